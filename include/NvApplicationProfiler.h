@@ -40,7 +40,9 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <sys/time.h>
+#include <sys/types.h>
 #include <time.h>
+#include <vector>
 
 /**
  *
@@ -55,10 +57,18 @@
  * Only one instance of NvApplicationProfiler object gets created for the application.
  * It can be accessed using getProfilerInstance().
  *
- * NvApplicationProfiler currently samples CPU usage and provides peak and average CPU
+ * NvApplicationProfiler samples CPU usage and provides peak and average CPU
  * usage during the profiling duration. It requires that the CPU frequency be
- * constant over the entire duration. To force this, NvApplicationProfiler will start only
- * when the CPU governor is set to @b performance.
+ * constant over the entire duration. To force this, the process CPU usage is
+ * measured only when the CPU governor is set to @b performance.
+ *
+ * Independently of the governor, every sample also accounts the CPU time,
+ * run-queue delay and context switches of each thread of the process (read
+ * from @c /proc/self/task and reported under the names set with
+ * @c pthread_setname_np), the utilization of each online core
+ * (@c /proc/stat), and the resident set size and major page faults of the
+ * process. The procfs files are kept open and re-read with @c pread, so a
+ * sampling interval of 10 ms costs a few system calls per thread.
  *
  * @defgroup l4t_mm_nvapplicationprofiler_group  Application Resource Profiler API
  * @ingroup aa_framework_api_group
@@ -67,6 +77,35 @@
 class NvApplicationProfiler
 {
 public:
+    /** Maximum number of threads accounted individually. */
+    static const uint32_t MaxProfiledThreads = 128;
+    /** Maximum number of cores accounted individually. */
+    static const uint32_t MaxProfiledCores = 64;
+
+    /**
+     * Holds the CPU accounting of one thread of the process.
+     */
+    typedef struct
+    {
+        /** Thread name, as set with pthread_setname_np or prctl. */
+        char name[16];
+        /** Kernel thread ID. */
+        pid_t tid;
+        /** Set if the thread exited before the profiler was stopped. */
+        bool exited;
+        /** CPU time used by the thread while profiling, in milliseconds. */
+        uint64_t cpu_time_ms;
+        /** Time the thread waited on a run queue while profiling,
+         *  in milliseconds. */
+        uint64_t run_delay_ms;
+        /** Number of times the thread was switched in while profiling. */
+        uint64_t context_switches;
+        /** Peak usage of one core by the thread over a sampling interval. */
+        float peak_cpu_usage;
+        /** Average usage of one core by the thread while it was profiled. */
+        float avg_cpu_usage;
+    } NvAppThreadProfilerData;
+
     /**
      * Holds the profiling data.
      */
@@ -82,6 +121,29 @@ public:
         uint32_t num_cpu_cores;
         /** Operating frequency of the cpu in MHz. */
         uint32_t cpu_freq_mhz;
+
+        /** Number of valid entries in @a threads. */
+        uint32_t num_threads;
+        /** Peak number of live threads that did not fit in @a threads. */
+        uint32_t num_untracked_threads;
+        /** Per-thread CPU accounting. Once the table is full, exited threads
+         *  make room for new ones, least busy first. */
+        NvAppThreadProfilerData threads[MaxProfiledThreads];
+
+        /** Number of valid entries in the per-core arrays. */
+        uint32_t num_cores;
+        /** Peak utilization of each core over a sampling interval, by any
+         *  process. */
+        float core_peak_usage[MaxProfiledCores];
+        /** Average utilization of each core, by any process. */
+        float core_avg_usage[MaxProfiledCores];
+
+        /** Peak resident set size of the process while profiling, in KiB. */
+        uint64_t peak_rss_kb;
+        /** Average resident set size of the process, in KiB. */
+        uint64_t avg_rss_kb;
+        /** Major page faults taken by the process while profiling. */
+        uint64_t major_faults;
     } NvAppProfilerData;
 
     static const uint64_t DefaultSamplingInterval = 100;
@@ -148,6 +210,50 @@ private:
     uint32_t cpu_freq; /**< Operating frequency of CPU cores in MHz. */
     bool check_cpu_usage; /**< Flag indicating if cpu usage should be checked. */
 
+    /**
+     * Holds the accounting state of one thread (internal use only).
+     */
+    struct ThreadState
+    {
+        int stat_fd;        /**< Open /proc/self/task/<tid>/stat, -1 once exited. */
+        int schedstat_fd;   /**< Open schedstat file, -1 if unavailable. */
+        bool seen;          /**< Set when listed by the current scan. */
+        uint64_t first_cpu_ns; /**< CPU time at the first reading. */
+        uint64_t first_delay_ns; /**< Run-queue delay at the first reading. */
+        uint64_t first_switches; /**< Timeslices at the first reading. */
+        uint64_t last_cpu_ns; /**< CPU time at the latest reading. */
+        uint64_t last_delay_ns; /**< Run-queue delay at the latest reading. */
+        uint64_t last_switches; /**< Timeslices at the latest reading. */
+        uint64_t first_time_ns; /**< Monotonic time of the first reading. */
+        uint64_t last_time_ns; /**< Monotonic time of the latest reading. */
+        NvAppThreadProfilerData data; /**< Aggregated data. */
+    };
+
+    /**
+     * Holds the accounting state of one core (internal use only).
+     */
+    struct CoreState
+    {
+        uint64_t first_busy;  /**< Busy ticks at the first reading. */
+        uint64_t first_total; /**< Total ticks at the first reading. */
+        uint64_t last_busy;   /**< Busy ticks at the latest reading. */
+        uint64_t last_total;  /**< Total ticks at the latest reading. */
+        float peak_usage;     /**< Peak utilization over an interval. */
+    };
+
+    std::vector<ThreadState> threads; /**< Threads seen while profiling. */
+    uint32_t num_untracked_threads; /**< Peak number of threads not accounted. */
+    uint64_t last_scan_ns; /**< Monotonic time of the previous thread scan. */
+    std::vector<CoreState> cores; /**< Online cores, by index in /proc/stat. */
+    int proc_stat_fd;  /**< Open /proc/stat, -1 if unavailable. */
+    int statm_fd;      /**< Open /proc/self/statm, -1 if unavailable. */
+    long page_size_kb; /**< Size of a page, in KiB. */
+    uint64_t first_major_faults; /**< Major faults when profiling started. */
+    uint64_t last_major_faults;  /**< Major faults at the latest reading. */
+    uint64_t peak_rss_kb; /**< Peak resident set size, in KiB. */
+    uint64_t sum_rss_kb;  /**< Sum of the resident set size readings. */
+    uint64_t num_rss_readings; /**< Number of resident set size readings. */
+
     /**
      * Holds resource usage readings (internal use only).
      */
@@ -186,6 +292,28 @@ private:
      */
     void profile();
 
+    /**
+     * Reads the CPU time of every thread of the process.
+     *
+     * @param[in] now_ns Monotonic time of the reading, in nanoseconds.
+     */
+    void profileThreads(uint64_t now_ns);
+
+    /**
+     * Reads the utilization of every core from /proc/stat.
+     */
+    void profileCores();
+
+    /**
+     * Reads the resident set size and major faults of the process.
+     */
+    void profileMemory();
+
+    /**
+     * Closes the procfs files, keeping the accounted data.
+     */
+    void closeAccountingFiles();
+
     /**
      * Default constructor used by getProfilerInstance.
      */
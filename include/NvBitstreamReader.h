@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Bitstream Reader API</b>
+ *
+ * @b Description: This file declares a helper class for reading Annex-B
+ * H.264/H.265/MPEG-2/MPEG-4 elementary streams one NAL unit or one access
+ * unit at a time.
+ */
+
+#ifndef __NV_BITSTREAM_READER_H__
+#define __NV_BITSTREAM_READER_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+#define H264_NAL_UNIT_CODED_SLICE  1
+#define H264_NAL_UNIT_CODED_SLICE_IDR  5
+
+#define GET_H264_NAL_UNIT_TYPE(buffer_ptr) (buffer_ptr[0] & 0x1F)
+#define IS_H264_NAL_CODED_SLICE(buffer_ptr) ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE)
+#define IS_H264_NAL_CODED_SLICE_IDR(buffer_ptr) ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE_IDR)
+
+#define GET_H265_NAL_UNIT_TYPE(buffer_ptr) ((buffer_ptr[0] & 0x7E) >> 1)
+
+/**
+ *
+ * @defgroup l4t_mm_nvbitstreamreader_group Bitstream Reader API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for reading Annex-B elementary streams.
+ *
+ * @c %NvBitstreamReader maps the input file into memory and builds an index
+ * of all the NAL units in a single pass over the file. The start code scan
+ * is vectorized with SSE2 or NEON where available. Each NAL unit is a
+ * contiguous span of the mapped file and can be copied into the output
+ * plane buffer of the decoder with a single @c memcpy, so the file is
+ * never read twice.
+ *
+ * A NAL unit spans from the first byte of its start code up to the first
+ * byte of the next start code. A 4-byte start code (@c 00 @c 00 @c 00 @c 01)
+ * belongs entirely to the NAL unit that follows it. Any bytes preceding the
+ * first start code in the file are skipped.
+ *
+ * For H.264 and H.265, consecutive NAL units can also be grouped into
+ * access units (one coded picture with its parameter sets and SEI), so that
+ * a whole picture is queued to the decoder in one buffer. Since the NAL
+ * units of an access unit are adjacent in the file, an access unit is also
+ * copied with a single @c memcpy.
+ */
+class NvBitstreamReader
+{
+public:
+    /**
+     * Holds the location of a NAL unit within the input file.
+     */
+    typedef struct
+    {
+        /** Offset of the first byte of the start code in the file. */
+        uint64_t offset;
+        /** Size of the NAL unit in bytes, including the start code. */
+        uint32_t size;
+        /** Length of the start code, 3 or 4 bytes. */
+        uint8_t start_code_len;
+        /** First byte of the NAL unit header. */
+        uint8_t header;
+    } NvNalUnit;
+
+    /**
+     * Creates a new bitstream reader for the file @a file_path and indexes
+     * all its NAL units.
+     *
+     * @param[in] file_path Path of the Annex-B elementary stream.
+     * @return Reference to the newly created reader object, or NULL
+     *          in case of failure during initialization.
+     */
+    static NvBitstreamReader *createBitstreamReader(const char *file_path);
+    ~NvBitstreamReader();
+
+    /**
+     * Copies the next NAL unit into plane 0 of @a buffer and advances
+     * the read position.
+     *
+     * On end of stream, @c bytesused of plane 0 is set to 0 and the read
+     * position is rewound to the first NAL unit, so that the stream can be
+     * looped.
+     *
+     * @param[in] buffer Buffer to be filled.
+     * @param[out] nalu Optional pointer to the index entry of the NAL unit
+     *                  that was copied. Set to NULL on end of stream.
+     * @return 0 for success, -1 if the NAL unit does not fit in the buffer.
+     */
+    int readNextNalUnit(NvBuffer *buffer, const NvNalUnit **nalu = NULL);
+
+    /**
+     * Copies the next access unit into plane 0 of @a buffer and advances
+     * the read position past all its NAL units.
+     *
+     * Access units are delimited as described in H.264 section 7.4.1.2.3
+     * and H.265 section 7.4.2.4.4, see isAccessUnitStart(). For other
+     * pixel formats each NAL unit is returned as its own access unit.
+     *
+     * End of stream is handled as in readNextNalUnit().
+     *
+     * @param[in] buffer Buffer to be filled.
+     * @param[in] pixfmt V4L2 pixel format of the stream.
+     * @param[out] nalu Optional pointer to the index entry of the first VCL
+     *                  NAL unit of the access unit, or of its first NAL unit
+     *                  if it has no VCL NAL unit. Set to NULL on end of stream.
+     * @param[out] num_nal_units Optional number of NAL units that were copied.
+     * @return 0 for success, -1 if the access unit does not fit in the buffer.
+     *         The read position is then unchanged, so that the NAL units of
+     *         the access unit can still be read with readNextNalUnit().
+     */
+    int readNextAccessUnit(NvBuffer *buffer, uint32_t pixfmt,
+                           const NvNalUnit **nalu = NULL,
+                           uint32_t *num_nal_units = NULL);
+
+    /**
+     * Checks whether a NAL unit may begin a new access unit.
+     *
+     * For H.264 this holds for AUD, SPS, PPS, SEI and NAL unit types 14 to 18,
+     * and for slices with @c first_mb_in_slice equal to 0. For H.265 this
+     * holds for AUD, VPS, SPS, PPS, prefix SEI, reserved types 41 to 44 and
+     * 48 to 55, and for slices with @c first_slice_segment_in_pic_flag set.
+     * A NAL unit only begins a new access unit if the current access unit
+     * already holds a VCL NAL unit.
+     *
+     * @param[in] pixfmt V4L2 pixel format, @c V4L2_PIX_FMT_H264 or
+     *                   @c V4L2_PIX_FMT_H265.
+     * @param[in] nal Pointer to the NAL unit header, past the start code.
+     * @param[in] size Size of the NAL unit in bytes, without the start code.
+     * @param[out] is_vcl Set to true if the NAL unit is a VCL NAL unit.
+     * @return true if the NAL unit may begin a new access unit.
+     */
+    static bool isAccessUnitStart(uint32_t pixfmt, const uint8_t *nal,
+                                  uint32_t size, bool &is_vcl);
+
+    /**
+     * Rewinds the read position to the first NAL unit.
+     */
+    void rewind();
+
+    /**
+     * Gets the number of NAL units in the stream.
+     */
+    uint64_t getNumNalUnits() const
+    {
+        return nal_units.size();
+    }
+
+    /**
+     * Gets the index entry of the NAL unit at @a index.
+     */
+    const NvNalUnit &getNalUnit(uint64_t index) const
+    {
+        return nal_units[index];
+    }
+
+    /**
+     * Gets a pointer to the start code of the NAL unit at @a index
+     * in the mapped file.
+     */
+    const uint8_t *getNalUnitData(uint64_t index) const
+    {
+        return data + nal_units[index].offset;
+    }
+
+    /**
+     * Gets the size of the input file in bytes.
+     */
+    uint64_t getFileSize() const
+    {
+        return size;
+    }
+
+    /**
+     * Finds the first 3-byte start code (@c 00 @c 00 @c 01) in the range
+     * [@a begin, @a end).
+     *
+     * @return Pointer to the first zero byte of the start code, or @a end
+     *          if no start code is found.
+     */
+    static const uint8_t *findStartCode(const uint8_t *begin,
+                                        const uint8_t *end);
+
+private:
+    /**
+     * Constructor which maps and indexes the file.
+     */
+    NvBitstreamReader(const char *file_path);
+
+    /**
+     * Builds the NAL unit index of the mapped file.
+     */
+    void buildIndex();
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvBitstreamReader(const NvBitstreamReader& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvBitstreamReader const&);
+
+    int fd;                             /**< File descriptor of the input file. */
+    const uint8_t *data;                /**< Start of the mapped file. */
+    uint64_t size;                      /**< Size of the mapped file. */
+    std::vector<NvNalUnit> nal_units;   /**< Index of the NAL units. */
+    uint64_t current;                   /**< Index of the next NAL unit to be read. */
+    bool is_in_error;                   /**< Set if initialization failed. */
+};
+
+/** @} */
+
+#endif
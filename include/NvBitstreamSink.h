@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Bitstream Sink API</b>
+ *
+ * @b Description: This file declares a helper class that writes encoded
+ * bitstream buffers to a file from a background thread.
+ */
+
+#ifndef __NV_BITSTREAM_SINK_H__
+#define __NV_BITSTREAM_SINK_H__
+
+#include <iostream>
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ *
+ * @defgroup l4t_mm_nvbitstreamsink_group Bitstream Sink API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for writing encoded bitstream data asynchronously.
+ *
+ * @c %NvBitstreamSink copies each buffer passed to write() into a large
+ * ring and returns, so the capture plane DQ thread that calls it is not
+ * held up by the file system. A writer thread drains everything queued in
+ * the ring with a single @c writev() per pass, which combines many small
+ * encoded frames into few large writes. Optionally, the writer calls
+ * @c fdatasync() every @a sync_interval bytes to bound the amount of dirty
+ * data the kernel accumulates.
+ *
+ * write() only blocks when the ring is full, that is when the disk cannot
+ * keep up on average. Such stalls are counted, together with the high-water
+ * mark of the queue, and reported by printStats().
+ *
+ * Several threads may call write(). Each buffer is queued whole, in the
+ * order in which the calls get the ring, and calls wait for the one
+ * filling the ring to finish.
+ */
+class NvBitstreamSink
+{
+public:
+    /**
+     * Holds the bitstream sink statistics.
+     */
+    typedef struct
+    {
+        /** Number of buffers passed to write(). */
+        uint64_t buffers_written;
+        /** Number of bytes written to the file. */
+        uint64_t bytes_written;
+        /** Number of @c writev() calls made by the writer thread. */
+        uint64_t writev_calls;
+        /** Number of @c fdatasync() calls made by the writer thread. */
+        uint64_t sync_calls;
+        /** Largest number of buffers queued at once. */
+        uint64_t max_queued_buffers;
+        /** Largest number of bytes queued at once. */
+        uint64_t max_queued_bytes;
+        /** Number of write() calls that had to wait for space in the ring. */
+        uint64_t stall_count;
+        /** Total time spent waiting in write(), in microseconds. */
+        uint64_t stall_time_usec;
+    } NvBitstreamSinkStats;
+
+    /**
+     * Creates a new bitstream sink writing to @a file_path, which is
+     * truncated.
+     *
+     * @param[in] name Unique name to identify the sink in the stats.
+     * @param[in] file_path Path of the output file.
+     * @param[in] ring_size Size of the ring in bytes.
+     * @param[in] sync_interval Number of bytes written between two
+     *                          @c fdatasync() calls, 0 to never sync.
+     * @return Reference to the newly created sink object, or NULL in case
+     *          of failure during initialization.
+     */
+    static NvBitstreamSink *createBitstreamSink(const char *name,
+            const char *file_path, uint32_t ring_size = 8 * 1024 * 1024,
+            uint64_t sync_interval = 0);
+
+    /**
+     * Writes out all the queued data and closes the file.
+     */
+    ~NvBitstreamSink();
+
+    /**
+     * Queues @a size bytes at @a data to be written to the file.
+     *
+     * The data is copied, @a data can be reused as soon as the call returns.
+     *
+     * @param[in] data Data to write.
+     * @param[in] size Number of bytes to write.
+     * @return 0 for success, -1 if writing to the file failed.
+     */
+    int write(const void *data, uint32_t size);
+
+    /**
+     * Waits until all the queued data has been written to the file.
+     *
+     * @return 0 for success, -1 if writing to the file failed.
+     */
+    int flush();
+
+    /**
+     * Gets the bitstream sink statistics.
+     *
+     * @param[out] stats Reference to the statistics structure to fill.
+     */
+    void getStats(NvBitstreamSinkStats &stats);
+
+    /**
+     * Prints the bitstream sink statistics to an output stream.
+     *
+     * @param[in] out_stream Output stream to print to, @c std::cout by default.
+     */
+    void printStats(std::ostream &out_stream = std::cout);
+
+    /**
+     * Checks whether writing the file failed.
+     */
+    bool isInError();
+
+private:
+    NvBitstreamSink(const char *name, const char *file_path,
+            uint32_t ring_size, uint64_t sync_interval);
+
+    /**
+     * Writes @a size bytes of the ring starting at position @a start.
+     */
+    int writeRing(uint64_t start, uint64_t size);
+
+    static void *writerThread(void *arg);
+
+    char *name;                 /**< Name of the sink. */
+    int fd;                     /**< FD of the output file. */
+    uint64_t sync_interval;     /**< Bytes between two fdatasync() calls. */
+    uint64_t unsynced_bytes;    /**< Bytes written since the last sync. */
+
+    unsigned char *ring;        /**< Ring of queued data. */
+    uint64_t ring_size;         /**< Size of the ring in bytes. */
+    uint64_t head;              /**< Total bytes queued. */
+    uint64_t tail;              /**< Total bytes written to the file. */
+    std::vector<uint64_t> buffer_ends; /**< Ring of the end positions of the
+                                            queued buffers. */
+    uint64_t buffers_queued;    /**< Total buffers queued. */
+    uint64_t buffers_done;      /**< Total buffers written to the file. */
+
+    pthread_mutex_t lock;       /**< Protects the ring and the stats. */
+    pthread_cond_t data_cond;   /**< Signaled when data is queued. */
+    pthread_cond_t space_cond;  /**< Signaled when data has been written. */
+    pthread_t writer;           /**< Writer thread. */
+    bool producer_busy;         /**< Indicates if a write() fills the ring. */
+    bool writer_started;        /**< Indicates if the writer thread runs. */
+    bool stop;                  /**< Set to stop the writer thread. */
+
+    NvBitstreamSinkStats stats; /**< Bitstream sink statistics. */
+    bool is_in_error;           /**< Indicates if writing the file failed,
+                                     protected by @a lock. */
+};
+/** @} */
+#endif
@@ -39,6 +39,7 @@
 #include <linux/videodev2.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <atomic>
 
 #include "v4l2_nv_extensions.h"
 
@@ -57,6 +58,10 @@
  */
 #define MAX_PLANES 3
 
+class NvBufferPool;
+struct NvBufferPoolMemory;
+class NvV4l2ElementPlane;
+
 /**
  * @brief Class representing a buffer.
  *
@@ -156,6 +161,24 @@ public:
      */
     NvBuffer(uint32_t pixfmt, uint32_t width, uint32_t height, uint32_t index);
 
+    /**
+     * Creates a new NvBuffer for raw pixel formats whose memory comes
+     * from a buffer pool.
+     *
+     * Same as NvBuffer(uint32_t, uint32_t, uint32_t, uint32_t), except that
+     * NvBuffer::allocateMemory takes page aligned planes recycled by
+     * @a pool, and NvBuffer::deallocateMemory gives them back to it.
+     *
+     * @param[in] pixfmt Pixel format of the buffer.
+     * @param[in] width Width of the buffer in pixels.
+     * @param[in] height Height of the buffer in pixels.
+     * @param[in] index Index/ID of the buffer.
+     * @param[in] pool Pool the memory is drawn from, must outlive the
+     *                 buffer. NULL to allocate the memory directly.
+     */
+    NvBuffer(uint32_t pixfmt, uint32_t width, uint32_t height, uint32_t index,
+            NvBufferPool *pool);
+
     /**
      * Creates a new NvBuffer object for non-raw pixel formats.
      *
@@ -203,7 +226,8 @@ public:
      * @warning This method works only for @c V4L2_MEMORY_USERPTR memory.
      *
      * This method allocates memory on the basis of the buffer format:
-     * @a height, @a width, @a bytesperpixel, and @a sizeimage.
+     * @a height, @a width, @a bytesperpixel, and @a sizeimage. Planes
+     * are aligned to 64 bytes, or to a page when drawn from a pool.
      *
      * @return 0 for success, -1 otherwise.
      */
@@ -219,7 +243,7 @@ public:
     /**
      * Increases the reference count of the buffer.
      *
-     * This method is thread safe.
+     * This method is thread safe and lock free.
      *
      * @return Reference count of the buffer after the operation.
      */
@@ -227,8 +251,11 @@ public:
     /**
      * Decreases the reference count of the buffer.
      *
-     * This thread-safe method decreases the buffer reference count if the
-     * buffer reference count is above 0.
+     * This thread-safe, lock-free method decreases the buffer reference
+     * count if the buffer reference count is above 0.
+     *
+     * Buffers returned by NvBufferPool::acquire are deleted when their
+     * reference count drops to 0, which gives their memory back to the pool.
      *
      * @return Reference count of the buffer after the operation.
      */
@@ -266,9 +293,7 @@ public:
             NvBuffer::NvBufferPlaneFormat *planefmts,
             uint32_t width, uint32_t height, uint32_t raw_pixfmt);
 private:
-    uint32_t ref_count;             /**< Holds the reference count of the buffer. */
-    pthread_mutex_t ref_lock;       /**< Mutex to synchronize increment/
-                                         decrement operations of @c ref_count. */
+    std::atomic<int> ref_count;     /**< Holds the reference count of the buffer. */
 
     bool mapped;                    /**< Indicates if the buffer is mapped to
                                          memory. */
@@ -278,6 +303,14 @@ private:
                                 points to the MMAP @c NvBuffer whose FD was
                                 sent when this buffer was queued. */
 
+    uint32_t pixfmt;                /**< Pixel format, 0 if not raw. */
+    NvBufferPool *pool;             /**< Pool the memory is drawn from, if any. */
+    NvBufferPoolMemory *pool_memory; /**< Memory drawn from @c pool. */
+    bool pool_owned;                /**< Set if the pool created the buffer,
+                                         which is deleted on the last unref. */
+    bool queued;                    /**< Set while the buffer is queued to
+                                         its plane. */
+
     /**
      * Disallows copy constructor.
      */
@@ -288,6 +321,139 @@ private:
     void operator=(NvBuffer const&);
 
     friend class NvV4l2ElementPlane;
+    friend class NvBufferPool;
+};
+
+/**
+ * @brief Move-only handle holding a reference to an NvBuffer.
+ *
+ * The handle takes a reference with NvBuffer::ref() and drops it when it is
+ * destroyed, reset or assigned. When the last reference of a buffer is
+ * dropped, the buffer goes back to its owner:
+ *
+ * - A buffer dequeued from a capture plane, wrapped with the plane, is
+ *   queued back to the plane to be filled again, unless the plane is no
+ *   longer streaming.
+ * - A buffer from NvBufferPool::acquire is deleted, giving its memory back
+ *   to the pool.
+ *
+ * A buffer handed down a pipeline, for instance from a decoder to a
+ * converter and a renderer, is thus returned exactly once, after its last
+ * user is done with it. Each user holds its own handle, obtained with
+ * share(). Handles are not thread safe themselves, but the reference count
+ * they manipulate is, so handles to one buffer may live on any threads.
+ */
+class NvBufferRef
+{
+public:
+    /**
+     * Creates an empty handle.
+     */
+    NvBufferRef();
+
+    /**
+     * Creates a handle taking a new reference to a buffer.
+     *
+     * @param[in] buffer Buffer to reference, may be NULL.
+     */
+    explicit NvBufferRef(NvBuffer *buffer);
+
+    /**
+     * Creates a handle taking a new reference to a buffer dequeued from a
+     * capture plane. The buffer is queued back to @a plane when its last
+     * reference is dropped, if the plane is still streaming. DMABUF buffers
+     * are queued back with the fd of plane 0, which the owner must set.
+     *
+     * @param[in] buffer Buffer to reference, may be NULL.
+     * @param[in] plane Plane the buffer was dequeued from.
+     */
+    NvBufferRef(NvBuffer *buffer, NvV4l2ElementPlane *plane);
+
+    /**
+     * Creates a handle taking over a reference already held on a buffer,
+     * such as the one returned by NvBufferPool::acquire.
+     *
+     * @param[in] buffer Buffer whose reference to take over, may be NULL.
+     * @return The handle.
+     */
+    static NvBufferRef adopt(NvBuffer *buffer);
+
+    /**
+     * Moves a handle, leaving @a other empty.
+     */
+    NvBufferRef(NvBufferRef &&other);
+
+    /**
+     * Drops the reference held, then moves @a other into this handle.
+     */
+    NvBufferRef &operator=(NvBufferRef &&other);
+
+    /**
+     * Drops the reference held.
+     */
+    ~NvBufferRef();
+
+    /**
+     * Creates another handle to the same buffer, with its own reference.
+     *
+     * @return The new handle, empty if this one is.
+     */
+    NvBufferRef share() const;
+
+    /**
+     * Drops the reference held and empties the handle.
+     *
+     * @return -1 if the buffer could not be queued back to its plane,
+     *         0 otherwise.
+     */
+    int reset();
+
+    /**
+     * Empties the handle without dropping its reference, which the caller
+     * becomes responsible for.
+     *
+     * @return The buffer, or NULL if the handle was empty.
+     */
+    NvBuffer *release();
+
+    /**
+     * Gets the buffer.
+     *
+     * @return The buffer, or NULL if the handle is empty.
+     */
+    NvBuffer *get() const
+    {
+        return buffer;
+    }
+
+    NvBuffer *operator->() const
+    {
+        return buffer;
+    }
+
+    NvBuffer &operator*() const
+    {
+        return *buffer;
+    }
+
+    explicit operator bool() const
+    {
+        return buffer != NULL;
+    }
+
+private:
+    NvBuffer *buffer;               /**< Buffer referenced, or NULL. */
+    NvV4l2ElementPlane *plane;      /**< Plane to queue the buffer back to,
+                                         or NULL. */
+
+    /**
+     * Disallows copy constructor, use share().
+     */
+    NvBufferRef(const NvBufferRef& that);
+    /**
+     * Disallows assignment.
+     */
+    void operator=(NvBufferRef const&);
 };
 /** @} */
 #endif
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Buffer Pool API</b>
+ *
+ * @b Description: This file declares a pool that recycles the memory of
+ * software (USERPTR) NvBuffer planes.
+ */
+
+#ifndef __NV_BUFFER_POOL_H__
+#define __NV_BUFFER_POOL_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvbufferpool_group Buffer Pool API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * Holds the memory of the planes of one pooled buffer (internal use only).
+ */
+struct NvBufferPoolMemory
+{
+    uint32_t pixfmt;              /**< Pixel format the memory is laid out for. */
+    uint32_t width;               /**< Width in pixels. */
+    uint32_t height;              /**< Height in pixels. */
+    unsigned char *base;          /**< Start of the mapping. */
+    size_t size;                  /**< Size of the mapping. */
+    unsigned char *data[MAX_PLANES]; /**< Page aligned start of each plane. */
+};
+
+/**
+ * @brief Pool recycling the plane memory of software NvBuffers.
+ *
+ * Software buffers allocate multi-megabyte planes, which is costly when a
+ * buffer is created for every image, as NvJPEGDecoder::decodeToBuffer does.
+ * A pool keeps the memory of released buffers, keyed by pixel format,
+ * width and height, and hands it to the next buffer of the same format.
+ *
+ * Planes are page aligned and all planes of a buffer share one anonymous
+ * mapping. With #FLAG_HUGEPAGES the mapping is backed by huge pages from
+ * the @c hugetlbfs reserve when possible, or else marked for transparent
+ * huge pages.
+ *
+ * Buffers are either acquired from the pool with acquire() and released
+ * with NvBuffer::unref(), or created with the pool constructor of NvBuffer
+ * and released with delete. At most @a max_free_buffers sets of planes are
+ * kept; trim() lowers the count, for instance after a resolution change.
+ *
+ * All methods are thread safe. The pool must outlive its buffers.
+ */
+class NvBufferPool
+{
+public:
+    /** Back the planes with huge pages. */
+    static const uint32_t FLAG_HUGEPAGES = 1 << 0;
+
+    /**
+     * Holds the pool statistics.
+     */
+    typedef struct
+    {
+        uint64_t allocations;   /**< Mappings created. */
+        uint64_t reuses;        /**< Buffers served from recycled memory. */
+        uint64_t releases;      /**< Mappings freed over the high-water mark
+                                     or by trim(). */
+        uint32_t outstanding;   /**< Buffers holding pool memory. */
+        uint32_t free_buffers;  /**< Sets of planes kept for reuse. */
+        uint64_t free_bytes;    /**< Bytes kept for reuse. */
+    } NvBufferPoolStats;
+
+    /**
+     * Creates a buffer pool.
+     *
+     * @param[in] name Name of the pool, for logging.
+     * @param[in] max_free_buffers Sets of planes kept for reuse.
+     * @param[in] flags Bitwise OR of the @c FLAG_* values.
+     * @return A reference to the pool, or NULL on error.
+     */
+    static NvBufferPool *createBufferPool(const char *name,
+            uint32_t max_free_buffers, uint32_t flags = 0);
+
+    /**
+     * Frees the memory kept for reuse.
+     */
+    ~NvBufferPool();
+
+    /**
+     * Gets a software buffer with memory from the pool.
+     *
+     * The buffer has a reference count of 1 and is deleted, giving its
+     * memory back to the pool, when NvBuffer::unref() drops it to 0.
+     *
+     * @param[in] pixfmt Raw pixel format of the buffer.
+     * @param[in] width Width of the buffer in pixels.
+     * @param[in] height Height of the buffer in pixels.
+     * @return The buffer, or NULL on error.
+     */
+    NvBuffer *acquire(uint32_t pixfmt, uint32_t width, uint32_t height);
+
+    /**
+     * Allocates and faults in memory for buffers of a format ahead of use.
+     *
+     * @param[in] pixfmt Raw pixel format of the buffers.
+     * @param[in] width Width of the buffers in pixels.
+     * @param[in] height Height of the buffers in pixels.
+     * @param[in] count Number of buffers to prepare, capped by the
+     *                  high-water mark of the pool.
+     * @return 0 on success, -1 otherwise.
+     */
+    int prewarm(uint32_t pixfmt, uint32_t width, uint32_t height,
+            uint32_t count);
+
+    /**
+     * Frees the memory kept for reuse down to a number of buffers, least
+     * recently released first.
+     *
+     * @param[in] max_free_buffers Sets of planes to keep.
+     */
+    void trim(uint32_t max_free_buffers);
+
+    /**
+     * Gets the pool statistics.
+     *
+     * @param[out] stats Statistics to fill.
+     */
+    void getStats(NvBufferPoolStats &stats);
+
+private:
+    /**
+     * Takes memory for a buffer, recycled or newly mapped, and points its
+     * planes to it. Called by NvBuffer::allocateMemory.
+     */
+    int allocateMemory(NvBuffer *buffer);
+
+    /**
+     * Gives the memory of a buffer back to the pool. Called by
+     * NvBuffer::deallocateMemory.
+     */
+    void deallocateMemory(NvBuffer *buffer);
+
+    /**
+     * Maps memory for a set of planes.
+     *
+     * @param[in] buffer Buffer whose plane lengths give the layout.
+     * @param[in] populate Fault the pages in.
+     */
+    NvBufferPoolMemory *mapMemory(NvBuffer *buffer, bool populate);
+
+    /**
+     * Unmaps a set of planes.
+     */
+    void unmapMemory(NvBufferPoolMemory *memory);
+
+    /**
+     * Frees memory kept for reuse down to @a max_free. Must be called with
+     * @c lock held.
+     */
+    void trimLocked(uint32_t max_free);
+
+    const char *name;           /**< Name of the pool. */
+    uint32_t max_free_buffers;  /**< High-water mark of the free list. */
+    uint32_t flags;             /**< @c FLAG_* values. */
+    size_t page_size;           /**< Alignment of the planes. */
+    size_t huge_page_size;      /**< Size of a huge page, 0 if unknown. */
+
+    pthread_mutex_t lock;       /**< Protects the free list and stats. */
+    std::vector<NvBufferPoolMemory *> free_list; /**< Least recently
+                                                      released first. */
+    NvBufferPoolStats stats;    /**< Statistics, without the free counts. */
+
+    NvBufferPool(const char *name, uint32_t max_free_buffers, uint32_t flags);
+
+    /**
+     * Disallows copy constructor.
+     */
+    NvBufferPool(const NvBufferPool& that);
+    /**
+     * Disallows assignment.
+     */
+    void operator=(NvBufferPool const&);
+
+    friend class NvBuffer;
+};
+
+/** @} */
+
+#endif
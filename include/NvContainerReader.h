@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Container Reader API</b>
+ *
+ * @b Description: This file declares a helper class for reading the video
+ * samples of MP4 and Matroska files.
+ */
+
+#ifndef __NV_CONTAINER_READER_H__
+#define __NV_CONTAINER_READER_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvcontainerreader_group Container Reader API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for reading video samples from MP4 and Matroska files.
+ *
+ * @c %NvContainerReader maps the input file into memory and builds an index
+ * of the samples of its first video track. ISO base media files (MP4, MOV),
+ * with either a sample table or movie fragments, and Matroska files (MKV,
+ * WebM) are supported. H.264, H.265, VP8, VP9 and AV1 tracks can be read.
+ *
+ * Each sample is copied into plane 0 of a buffer as the decoder expects it.
+ * For H.264 and H.265, the NAL unit length prefixes are replaced with start
+ * codes in place, and key frames are preceded by the parameter sets of the
+ * decoder configuration. AV1 samples are preceded by a temporal delimiter.
+ *
+ * The index holds the presentation timestamp of each sample, so that it
+ * can be passed to the decoder. On end of stream the reader rewinds
+ * itself, so that the stream can be looped indefinitely.
+ */
+class NvContainerReader
+{
+public:
+    /**
+     * Holds the location of a sample within the input file.
+     */
+    typedef struct
+    {
+        /** Offset of the sample data in the file. */
+        uint64_t offset;
+        /** Size of the sample data in bytes. */
+        uint32_t size;
+        /** Presentation timestamp in microseconds. */
+        int64_t pts;
+        /** Set if the sample is a key frame. */
+        bool key_frame;
+    } NvContainerSample;
+
+    /**
+     * Creates a new container reader for the file @a file_path and indexes
+     * the samples of its first video track.
+     *
+     * @param[in] file_path Path of the MP4 or Matroska file.
+     * @return Reference to the newly created reader object, or NULL
+     *          if the file cannot be read, is not a supported container or
+     *          has no supported video track.
+     */
+    static NvContainerReader *createContainerReader(const char *file_path);
+    ~NvContainerReader();
+
+    /**
+     * Converts the next sample into plane 0 of @a buffer and advances the
+     * read position.
+     *
+     * On end of stream, @c bytesused of plane 0 is set to 0 and the read
+     * position is rewound to the first sample.
+     *
+     * @param[in] buffer Buffer to be filled.
+     * @param[out] sample Optional pointer to the index entry of the sample
+     *                    that was read. Set to NULL on end of stream.
+     * @return 0 for success, -1 if the sample is malformed or does not fit
+     *          in the buffer.
+     */
+    int readNextSample(NvBuffer *buffer,
+                       const NvContainerSample **sample = NULL);
+
+    /**
+     * Moves the read position to the sample at @a index.
+     *
+     * @return 0 for success, -1 if @a index is out of range.
+     */
+    int seek(uint64_t index);
+
+    /**
+     * Moves the read position to the last key frame at or before the
+     * sample at @a index.
+     *
+     * @return Index of the key frame, or -1 if @a index is out of range or
+     *          no key frame precedes it.
+     */
+    int64_t seekToKeyFrame(uint64_t index);
+
+    /**
+     * Moves the read position back to the first sample.
+     */
+    void rewind();
+
+    /**
+     * Gets the index of the next sample to be read.
+     */
+    uint64_t getPosition()
+    {
+        return current;
+    }
+
+    /**
+     * Gets the number of indexed samples.
+     */
+    uint64_t getNumSamples()
+    {
+        return samples.size();
+    }
+
+    /**
+     * Gets the index entry of the sample at @a index.
+     *
+     * @return Pointer to the entry, or NULL if @a index is out of range.
+     */
+    const NvContainerSample *getSample(uint64_t index)
+    {
+        return index < samples.size() ? &samples[index] : NULL;
+    }
+
+    /**
+     * Gets the V4L2 pixel format of the video track.
+     */
+    uint32_t getPixelFormat()
+    {
+        return pixfmt;
+    }
+
+    /**
+     * Gets the frame width of the video track.
+     */
+    uint32_t getWidth()
+    {
+        return width;
+    }
+
+    /**
+     * Gets the frame height of the video track.
+     */
+    uint32_t getHeight()
+    {
+        return height;
+    }
+
+    /**
+     * Checks whether the file is a Matroska file.
+     */
+    bool isMatroska()
+    {
+        return is_matroska;
+    }
+
+private:
+    /**
+     * Holds the state of an ISO base media track while it is parsed.
+     */
+    struct Mp4Track;
+
+    /**
+     * Constructor which maps the file and indexes the samples.
+     */
+    NvContainerReader(const char *file_path);
+
+    /**
+     * Indexes the samples of an ISO base media file.
+     */
+    int parseMp4();
+
+    /**
+     * Parses a @c trak box, returns 1 if it is a supported video track.
+     */
+    int parseMp4Track(const uint8_t *trak, uint64_t trak_size,
+                      Mp4Track &track);
+
+    /**
+     * Adds the samples described by the sample table of @a track.
+     */
+    int addMp4SampleTable(const Mp4Track &track);
+
+    /**
+     * Adds the samples of the video track described by a @c moof box.
+     */
+    int addMp4Fragment(const uint8_t *moof, uint64_t moof_size,
+                       Mp4Track &track);
+
+    /**
+     * Indexes the blocks of the first video track of a Matroska file.
+     */
+    int parseMatroska();
+
+    /**
+     * Sets up the codec from an MP4 sample entry type or a Matroska codec
+     * ID, and parses its decoder configuration record.
+     */
+    int setCodec(uint32_t codec, const uint8_t *config, uint32_t config_size);
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvContainerReader(const NvContainerReader& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvContainerReader const&);
+
+    int fd;                             /**< File descriptor of the input file. */
+    const uint8_t *data;                /**< Start of the mapped file. */
+    uint64_t size;                      /**< Size of the mapped file. */
+    bool is_matroska;                   /**< Set for Matroska files. */
+    uint32_t pixfmt;                    /**< V4L2 pixel format of the track. */
+    uint32_t width;                     /**< Frame width. */
+    uint32_t height;                    /**< Frame height. */
+    uint32_t nal_length_size;           /**< Size of the NAL unit length
+                                             prefixes, 0 if not H.264 or
+                                             H.265. */
+    std::vector<uint8_t> parameter_sets; /**< Start code prefixed parameter
+                                              sets, or AV1 configuration
+                                              OBUs, put before key frames. */
+    std::vector<NvContainerSample> samples; /**< Index of the samples. */
+    uint64_t current;                   /**< Index of the next sample to be read. */
+    bool is_in_error;                   /**< Set if initialization failed. */
+};
+
+/** @} */
+
+#endif
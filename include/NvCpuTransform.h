@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: CPU Transform API</b>
+ *
+ * @b Description: This file declares a software implementation of the
+ * color conversion, cropping, scaling and flipping done by
+ * @c NvBufSurf::NvTransform on the VIC hardware.
+ */
+
+#ifndef __NV_CPU_TRANSFORM_H__
+#define __NV_CPU_TRANSFORM_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include "NvBufSurface.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvcputransform_group CPU Transform API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for transforming frames on the CPU.
+ *
+ * @c %NvCpuTransform takes the same @c NvBufSurf::NvCommonTransformParams
+ * as @c NvBufSurf::NvTransform, so it can stand in for the VIC when the VIC
+ * is saturated by other streams, and it can run off-target to benchmark or
+ * verify conversions.
+ *
+ * Supported formats are the 8-bit YUV 4:2:0, 4:2:2 and 4:4:4 formats in
+ * planar (I420, YV12, YUV444), semi-planar (NV12, NV21, NV16, NV24) and
+ * packed (YUYV, UYVY, YVYU, VYUY) layouts, their 10-bit and 12-bit
+ * semi-planar variants (P010 as @c NVBUF_COLOR_FORMAT_NV12_10LE), GRAY8,
+ * and 8-bit RGB with or without alpha. BT.601, BT.709 and BT.2020 matrices
+ * are applied in limited or extended range as given by the color format.
+ *
+ * Each transform runs in two passes, both split into bands of rows that the
+ * worker threads of the object process in parallel:
+ * -# Every color channel of the source window is scaled separately, in
+ *    16-bit precision, to the size of the destination rectangle before the
+ *    flip. Chroma is scaled directly from the source to the destination
+ *    subsampling.
+ * -# The scaled channels are read back in flipped order, converted to the
+ *    destination color space if it differs from the source one and packed
+ *    into the destination planes.
+ *
+ * Nearest, bilinear and bicubic filters are provided. The VIC 5-tap, 10-tap,
+ * smart and nicest filters map to bicubic. When downscaling, the bilinear and
+ * bicubic filters are widened by the scaling factor so that all the source
+ * pixels contribute to the output.
+ *
+ * The filter and color matrix loops have AVX2 kernels, chosen at run time,
+ * on x86 and NEON kernels on AArch64.
+ */
+class NvCpuTransform
+{
+public:
+    /**
+     * Holds a pitch-linear frame in CPU memory.
+     */
+    typedef struct
+    {
+        /** Color format of the frame. */
+        NvBufSurfaceColorFormat colorFormat;
+        /** Width of the frame in pixels. */
+        uint32_t width;
+        /** Height of the frame in pixels. */
+        uint32_t height;
+        /** Plane parameters, laid out as for an @c NvBufSurface. Only
+            @c num_planes, @c width, @c height, @c pitch and @c bytesPerPix
+            are used. */
+        NvBufSurfacePlaneParams planeParams;
+        /** Address of each plane. */
+        uint8_t *addr[NVBUF_MAX_PLANES];
+    } NvCpuSurface;
+
+    /**
+     * Holds the squared error between two series of frames, for PSNR
+     * computation.
+     */
+    typedef struct
+    {
+        /** Number of planes compared. */
+        uint32_t num_planes;
+        /** Largest sample value of each plane. */
+        uint32_t peak[NVBUF_MAX_PLANES];
+        /** Sum of the squared sample differences of each plane. */
+        double sse[NVBUF_MAX_PLANES];
+        /** Number of samples compared in each plane. */
+        uint64_t count[NVBUF_MAX_PLANES];
+    } NvCpuErrorStats;
+
+    /**
+     * Creates a new CPU transform object.
+     *
+     * @param[in] num_threads Number of threads that process a transform,
+     *                        including the calling thread. 0 uses one
+     *                        thread per online CPU.
+     * @param[in] use_vector_kernels Whether the AVX2 or NEON kernels are
+     *                        used when the CPU supports them. The scalar
+     *                        kernels give the same results, they can be
+     *                        forced to check or benchmark the vector ones.
+     * @return Reference to the newly created object, or NULL in case of
+     *          failure during initialization.
+     */
+    static NvCpuTransform *createCpuTransform(uint32_t num_threads = 0,
+            bool use_vector_kernels = true);
+    ~NvCpuTransform();
+
+    /**
+     * Transforms @a src into @a dst.
+     *
+     * The fields of @a transform_params are used as by
+     * @c NvBufSurf::NvTransform: the source and destination rectangles
+     * only apply with @c NVBUFSURF_TRANSFORM_CROP_SRC and
+     * @c NVBUFSURF_TRANSFORM_CROP_DST, the filter with
+     * @c NVBUFSURF_TRANSFORM_FILTER and the flip method with
+     * @c NVBUFSURF_TRANSFORM_FLIP. Pixels of @a dst outside of the
+     * destination rectangle are left untouched.
+     *
+     * @param[in] transform_params Transform parameters.
+     * @param[in] src Source frame.
+     * @param[in] dst Destination frame.
+     * @return 0 for success, -1 otherwise.
+     */
+    int NvTransform(NvBufSurf::NvCommonTransformParams *transform_params,
+            const NvCpuSurface *src, NvCpuSurface *dst);
+
+    /**
+     * Transforms a hardware buffer into another one. Both buffers are
+     * mapped for CPU access, so they must have the pitch-linear layout.
+     *
+     * @param[in] transform_params Transform parameters.
+     * @param[in] src_fd FD of the source buffer.
+     * @param[in] dst_fd FD of the destination buffer.
+     * @return 0 for success, -1 otherwise.
+     */
+    int NvTransform(NvBufSurf::NvCommonTransformParams *transform_params,
+            int src_fd, int dst_fd);
+
+    /**
+     * Checks whether @a format can be read and written.
+     */
+    static bool isFormatSupported(NvBufSurfaceColorFormat format);
+
+    /**
+     * Allocates a frame in CPU memory. The pitch of each plane is aligned
+     * to 64 bytes.
+     *
+     * @param[in] width Width of the frame in pixels.
+     * @param[in] height Height of the frame in pixels.
+     * @param[in] format Color format of the frame.
+     * @param[out] surface Frame to be filled.
+     * @return 0 for success, -1 otherwise.
+     */
+    static int NvAllocate(uint32_t width, uint32_t height,
+            NvBufSurfaceColorFormat format, NvCpuSurface *surface);
+
+    /**
+     * Frees a frame allocated with NvAllocate().
+     */
+    static void NvDestroy(NvCpuSurface *surface);
+
+    /**
+     * Adds the squared error between @a frame and @a ref to @a stats. The
+     * two frames must have the same format and size. For 10-bit and 12-bit
+     * formats, the error is computed on the significant bits only.
+     *
+     * @param[in] frame Frame to be compared.
+     * @param[in] ref Reference frame.
+     * @param[in,out] stats Error statistics, zeroed before the first call.
+     * @return 0 for success, -1 otherwise.
+     */
+    static int NvAccumulateError(const NvCpuSurface *frame,
+            const NvCpuSurface *ref, NvCpuErrorStats *stats);
+
+    /**
+     * Gets the PSNR in dB of plane @a plane from @a stats, infinite if the
+     * compared frames are identical.
+     */
+    static double getPsnr(const NvCpuErrorStats *stats, uint32_t plane);
+
+    /**
+     * Gets the number of threads that process a transform.
+     */
+    uint32_t getNumThreads() const
+    {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Gets the name of the vector kernels in use, or "none".
+     */
+    const char *getSimdName() const;
+
+private:
+    /**
+     * Describes the layout of a color format, see NvCpuTransform.cpp.
+     */
+    struct FormatDesc;
+
+    /**
+     * Holds the samples of one color channel in a frame.
+     */
+    typedef struct
+    {
+        /** Address of the first sample, NULL if the channel is missing
+            and takes the value @c fill. */
+        uint8_t *base;
+        /** Distance between two rows in bytes. */
+        uint32_t pitch;
+        /** Distance between two samples of a row, in samples. */
+        uint32_t step;
+        /** Number of significant bits, 8 for one byte per sample. Deeper
+            samples take two bytes, aligned to the most significant bit. */
+        uint32_t depth;
+        /** Size of the channel in samples. */
+        uint32_t width;
+        uint32_t height;
+        /** Value of a missing channel, on 16 bits. */
+        uint16_t fill;
+    } Channel;
+
+    /**
+     * Holds the scaling of one channel into a working plane.
+     */
+    typedef struct
+    {
+        Channel src;
+        /** Size of the working plane, before flipping. */
+        uint32_t out_width;
+        uint32_t out_height;
+        /** First column and number of columns of @c src that are read. */
+        uint32_t src_x;
+        uint32_t src_columns;
+        /** First row and number of rows of @c src that are read. */
+        uint32_t src_y;
+        uint32_t src_rows;
+        /** Number of horizontal taps, 0 to copy the source columns. */
+        uint32_t h_taps;
+        /** Tap-major source columns, relative to @c src_x, and weights.
+            Each tap holds @c h_stride entries. */
+        std::vector<int32_t> h_index;
+        std::vector<float> h_weight;
+        uint32_t h_stride;
+        /** Number of vertical taps, 0 to copy the source rows. */
+        uint32_t v_taps;
+        /** Tap-major source rows, relative to @c src_y, and weights. Each
+            tap holds @c out_height entries. */
+        std::vector<int32_t> v_index;
+        std::vector<float> v_weight;
+        /** Samples of the working plane, @c out_width per row. */
+        std::vector<uint16_t> plane;
+    } Stage;
+
+    /**
+     * Holds a band of rows processed by a single thread.
+     */
+    typedef struct
+    {
+        uint32_t channel;
+        uint32_t begin;
+        uint32_t end;
+    } Task;
+
+    /**
+     * Holds the scratch buffers of a thread.
+     */
+    typedef struct
+    {
+        /** Filtered source rows, followed by the rows being computed. */
+        std::vector<float> rows;
+        std::vector<uint16_t> samples;
+        /** Source row held by each filtered row, -1 if none. */
+        std::vector<int64_t> tags;
+        /** Rows and weights of the vertical taps of one output row. */
+        std::vector<const float *> taps;
+        std::vector<float> weights;
+    } Scratch;
+
+    typedef struct
+    {
+        NvCpuTransform *transform;
+        uint32_t index;
+        pthread_t thread;
+    } Worker;
+
+    NvCpuTransform(uint32_t num_threads, bool use_vector_kernels);
+
+    static const FormatDesc format_descs[];
+    static const FormatDesc *getFormatDesc(NvBufSurfaceColorFormat format);
+    static bool isChroma(const FormatDesc *desc, uint32_t channel);
+    static bool isPacked422(const FormatDesc *desc);
+    static bool isValidSurface(const FormatDesc *desc,
+            const NvCpuSurface *surface);
+    static void getChannel(const FormatDesc *desc, const NvCpuSurface *surface,
+            uint32_t index, bool write, Channel *channel);
+    static void getToRgbMatrix(const FormatDesc *desc, double m[12]);
+
+    static void readSamples(const Channel &channel, uint32_t row, uint32_t x,
+            uint32_t n, uint16_t *dst);
+    static void writeSamples(const Channel &channel, uint32_t row, uint32_t x,
+            uint32_t n, const uint16_t *src);
+
+    static void addBands(std::vector<Task> &tasks, uint32_t channel,
+            uint32_t rows, uint32_t num_threads, uint32_t align);
+
+    static void *workerThread(void *arg);
+
+    void runTasks(const std::vector<Task> &task_list, bool pack);
+    void processTasks(uint32_t worker);
+
+    void scaleBand(const Task &task, Scratch &s);
+    void packBand(const Task &task, Scratch &s);
+    void convertBand(const Task &task, Scratch &s);
+
+    const float *getFilteredRow(const Stage &stage, uint32_t row, Scratch &s);
+
+    std::vector<Worker> workers;
+    std::vector<Scratch> scratch;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    bool stop;
+    uint32_t generation;
+    uint32_t num_active;
+
+    /* State of the transform in progress, read by all the threads. */
+    const std::vector<Task> *tasks;
+    bool pack_phase;
+    uint32_t next_task;
+
+    int simd;
+
+    Stage stages[4];
+    uint32_t num_stages;
+    Channel dst_channels[4];
+    uint32_t num_dst_channels;
+    uint32_t dst_x;
+    uint32_t dst_y;
+    uint32_t dst_width;
+    uint32_t dst_height;
+    uint32_t dst_shift_x;
+    uint32_t dst_shift_y;
+    bool dst_is_rgb;
+    NvBufSurfTransform_Flip flip;
+    /** Whether the color space changes, the working planes then all have
+        the size of the destination luma. */
+    bool convert;
+    /** Affine color matrix, on 16-bit samples. */
+    float matrix[12];
+
+    std::vector<Task> scale_tasks;
+    std::vector<Task> pack_tasks;
+
+    bool is_in_error;
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvCpuTransform(const NvCpuTransform& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvCpuTransform const&);
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: CRC API</b>
+ *
+ * @b Description: This file declares a helper class that computes 32-bit
+ * CRCs of bitstream and frame data.
+ */
+
+#ifndef __NV_CRC_H__
+#define __NV_CRC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ *
+ * @defgroup l4t_mm_nvcrc_group CRC API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/** Reflected CRC-32 polynomial used by the samples (IEEE 802.3). */
+#define NV_CRC32_POLYNOMIAL 0xEDB88320
+
+/**
+ * @brief Helper class for computing 32-bit CRCs.
+ *
+ * @c %NvCrc computes the reflected CRC of a polynomial, starting from a CRC
+ * value of 0 with no final inversion, which are the values the samples
+ * compare against their golden CRC files.
+ *
+ * For @c NV_CRC32_POLYNOMIAL, the CRC is computed with carry-less multiply
+ * folding on ARMv8 CPUs that have PMULL and the CRC32 instructions, with the
+ * CRC32 instructions alone on ARMv8 CPUs without PMULL, or with PCLMULQDQ
+ * folding on x86 CPUs that have it. Otherwise, and for any other
+ * polynomial, a slice-by-16 table CRC is used. The engine is selected at
+ * runtime when the object is created, all engines give bit-exact results.
+ *
+ * The CRC can be computed in a stream with update(), or in independent
+ * chunks with calculate() which are then joined with combine(), for
+ * instance to checksum the planes of a frame in parallel.
+ */
+class NvCrc
+{
+public:
+    /**
+     * Specifies the CRC engines.
+     */
+    enum Engine
+    {
+        /** Fastest engine supported by the CPU for the polynomial. */
+        ENGINE_AUTO,
+        /** One table lookup per byte. */
+        ENGINE_BYTEWISE,
+        /** Software CRC with 8 tables, 8 bytes per iteration. */
+        ENGINE_SLICE_BY_8,
+        /** Software CRC with 16 tables, 16 bytes per iteration. */
+        ENGINE_SLICE_BY_16,
+        /** ARMv8 CRC32 instructions, @c NV_CRC32_POLYNOMIAL only. */
+        ENGINE_ARMV8_CRC32,
+        /** ARMv8 PMULL folding, @c NV_CRC32_POLYNOMIAL only. */
+        ENGINE_ARMV8_PMULL,
+        /** x86 PCLMULQDQ folding, @c NV_CRC32_POLYNOMIAL only. */
+        ENGINE_X86_PCLMUL
+    };
+
+    /**
+     * Creates a new CRC object with a CRC value of 0.
+     *
+     * @param[in] polynomial Reflected CRC polynomial.
+     * @param[in] engine Engine to compute the CRC with.
+     * @return Reference to the newly created CRC object, or NULL if
+     *          @a engine is not supported by the CPU or the polynomial.
+     */
+    static NvCrc *createCrc(uint32_t polynomial = NV_CRC32_POLYNOMIAL,
+            Engine engine = ENGINE_AUTO);
+    ~NvCrc();
+
+    /**
+     * Updates the CRC value with @a size bytes at @a data.
+     */
+    void update(const void *data, size_t size)
+    {
+        value = calculate(value, data, size);
+    }
+
+    /**
+     * Gets the CRC of all the data passed to update().
+     */
+    uint32_t getValue() const
+    {
+        return value;
+    }
+
+    /**
+     * Sets the CRC value, 0 to start over.
+     */
+    void setValue(uint32_t crc)
+    {
+        value = crc;
+    }
+
+    /**
+     * Computes the CRC of @a size bytes at @a data, starting from @a crc.
+     *
+     * Does not change the value of the object and can be called from
+     * several threads at once.
+     *
+     * @param[in] crc CRC of the preceding data, or 0.
+     * @param[in] data Data to compute the CRC of.
+     * @param[in] size Number of bytes at @a data.
+     * @return CRC of the preceding data followed by @a data.
+     */
+    uint32_t calculate(uint32_t crc, const void *data, size_t size) const;
+
+    /**
+     * Combines the CRCs of two consecutive chunks of data.
+     *
+     * @param[in] crc1 CRC of the first chunk.
+     * @param[in] crc2 CRC of the second chunk, computed from 0.
+     * @param[in] size2 Number of bytes in the second chunk.
+     * @return CRC of the first chunk followed by the second one.
+     */
+    uint32_t combine(uint32_t crc1, uint32_t crc2, uint64_t size2) const;
+
+    /**
+     * Gets the engine the CRC is computed with.
+     */
+    Engine getEngine() const
+    {
+        return engine;
+    }
+
+    /**
+     * Gets the name of an engine, for logs.
+     */
+    static const char *getEngineName(Engine engine);
+
+private:
+    NvCrc(uint32_t polynomial, Engine engine);
+
+    /**
+     * Multiplies two polynomials modulo the CRC polynomial.
+     */
+    uint32_t multiplyModulo(uint32_t a, uint32_t b) const;
+
+    uint32_t polynomial;        /**< Reflected CRC polynomial. */
+    Engine engine;              /**< Engine the CRC is computed with. */
+    uint32_t value;             /**< CRC of the data passed to update(). */
+    uint32_t (*tables)[256];    /**< Slice-by-16 lookup tables. */
+    uint32_t x2n_table[32];     /**< x^(2^n) modulo the polynomial. */
+};
+/** @} */
+#endif
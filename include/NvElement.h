@@ -73,9 +73,7 @@ public:
     {
         return is_in_error;
     }
-    virtual ~NvElement()
-    {
-    }
+    virtual ~NvElement();
 
     /**
      * Gets profiling data for the element.
@@ -122,6 +120,7 @@ protected:
     const char *comp_name;  /**< Specifies the name of the component,
                                for debugging. */
     NvElementProfiler profiler; /**< Profiler for the element. */
+    uint32_t metrics_id;    /**< ID of the element in NvMetricsRegistry. */
 
     /**
      * Disallows copy constructor.
@@ -132,6 +131,7 @@ protected:
      */
     void operator=(NvElement const&);
 
+    friend class NvMetricsRegistry;
 };
 /** @} */
 #endif
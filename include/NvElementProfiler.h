@@ -31,7 +31,7 @@
 
 #include <iostream>
 #include <pthread.h>
-#include <map>
+#include <atomic>
 #include <stdint.h>
 #include <sys/time.h>
 
@@ -51,6 +51,14 @@
  * the number of units that arrived late at the element. Components should use this
  * information internally.
  *
+ * startProcessing() and finishProcessing() are lock-free and do not allocate.
+ * Latencies are measured with the monotonic hardware counter and recorded in a
+ * log-bucketed histogram, with a relative precision of 12.5%, from which the
+ * latency percentiles are computed. The start times of at most
+ * @c MAX_UNITS_IN_FLIGHT units in processing are kept. Beyond that the start
+ * times of the oldest units are overwritten, and these units are counted
+ * without latency when they finish.
+ *
  * If you require latency measurements,
  * you must call startProcessing() to indicate that a unit has been submitted
  * for processing and finishProcessing() to indicate that a unit has finished processing.
@@ -101,6 +109,16 @@ public:
         uint64_t min_latency_usec;
         /** Maximum of latencies for each processed units, in microseconds. */
         uint64_t max_latency_usec;
+        /** Median latency, in microseconds. */
+        uint64_t p50_latency_usec;
+        /** 90th percentile latency, in microseconds. */
+        uint64_t p90_latency_usec;
+        /** 99th percentile latency, in microseconds. */
+        uint64_t p99_latency_usec;
+        /** 99.9th percentile latency, in microseconds. */
+        uint64_t p999_latency_usec;
+        /** Standard deviation of the latencies, in microseconds. */
+        float latency_jitter_usec;
 
         /** Total units processed. */
         uint64_t total_processed_units;
@@ -112,6 +130,11 @@ public:
 
         /** Total profiling time. */
         struct timeval profiling_time;
+
+        /** Number of units whose start time was overwritten because more
+            than @c MAX_UNITS_IN_FLIGHT units were in processing. They are
+            included in @a total_processed_units but not in the latencies. */
+        uint64_t num_overflowed_units;
     } NvElementProfilerData;
 
     /**
@@ -128,6 +151,32 @@ public:
      */
     void printProfilerData(std::ostream &out_stream = std::cout);
 
+    /** Number of log2 ranges of the latency histogram. */
+    static const int HISTOGRAM_RANGES = 38;
+    /** Number of linear sub-buckets per log2 range, as a power of 2. */
+    static const int HISTOGRAM_SUB_BUCKETS_LOG2 = 3;
+    /** Total number of histogram buckets. */
+    static const int HISTOGRAM_BUCKETS =
+        (HISTOGRAM_RANGES + 1) << HISTOGRAM_SUB_BUCKETS_LOG2;
+
+    /**
+     * Gets the latency histogram of all the processed units.
+     *
+     * Subtracting an earlier histogram from a later one gives the latencies
+     * of the units processed in between, for instance over a sliding window.
+     *
+     * @param[out] histogram Array of @c HISTOGRAM_BUCKETS unit counts.
+     */
+    void getLatencyHistogram(uint64_t *histogram);
+
+    /**
+     * Gets the latency that a histogram bucket stands for.
+     *
+     * @param[in] bucket Index of the bucket.
+     * @return Latency in microseconds.
+     */
+    static float getHistogramBucketUsec(int bucket);
+
     /**
      * Informs the profiler that processing has started.
      *
@@ -167,34 +216,83 @@ private:
      */
     void reset();
 
-    pthread_mutex_t profiler_lock; /**< Mutex to synchronize multithreaded access to profiler data. */
+    /**
+     * Claims the unit @a id, or the oldest unit in processing if @a id is 0.
+     *
+     * @return Start time of the unit in ticks, 0 if no such unit exists.
+     */
+    uint64_t claimUnit(uint64_t id);
+
+    /**
+     * Takes one of the overflowed units which have not finished yet.
+     *
+     * @return true if there was such a unit.
+     */
+    bool claimOverflowedUnit();
 
-    bool enabled; /**< Flag indicating if profiler is enabled. */
+    /**
+     * Records a processed unit in the shard of the calling thread.
+     */
+    void recordUnit(uint64_t now, uint64_t latency_ticks, bool is_late);
 
-    const ProfilerField valid_fields; /**< Valid fields for the element. */
+    pthread_mutex_t profiler_lock; /**< Mutex to synchronize enabling, disabling and reading. */
+
+    std::atomic<bool> enabled; /**< Flag indicating if profiler is enabled. */
 
-    struct NvElementProfilerDataInternal : NvElementProfilerData {
-        /** Wall-clock time at which the first unit was processed. */
-        struct timeval start_time;
+    const ProfilerField valid_fields; /**< Valid fields for the element. */
 
-        /** Wall-clock time at which the latest unit was processed. */
-        struct timeval stop_time;
+    /** Number of counter shards owned by a thread. */
+    static const int NUM_SHARDS = 4;
+    /** Maximum number of units in processing, as a power of 2. */
+    static const int MAX_UNITS_IN_FLIGHT = 256;
 
-        /** Total accumulated time.
-         *  When performance measurement is restarted @a start_time and @a stop_time
-         *  are reset. This field is used to accumulate time before
-         *  resetting. */
-        struct timeval accumulated_time;
+    /**
+     * Counters updated by the threads finishing units. The first
+     * @c NUM_SHARDS threads each own a shard which only they write, without
+     * atomic read-modify-write, and the other threads share the last one.
+     * Shards are merged in getProfilerData().
+     */
+    struct Shard {
+        /** Units processed without latency, timed units are counted in
+            the histogram only. */
+        std::atomic<uint64_t> num_untimed_units;
+        std::atomic<uint64_t> num_late_units;
+        /** Sum of latencies, in nanoseconds. */
+        std::atomic<uint64_t> total_latency;
+        /** Sum of squared latencies, in square microseconds. */
+        std::atomic<uint64_t> total_latency_sq;
+        /** Minimum latency, in nanoseconds. */
+        std::atomic<uint64_t> min_latency;
+        /** Maximum latency, in nanoseconds. */
+        std::atomic<uint64_t> max_latency;
+        /** Latency histogram in nanoseconds. */
+        std::atomic<uint64_t> histogram[HISTOGRAM_BUCKETS];
+        /** Keeps the counters of adjacent shards on separate cache lines. */
+        char padding[64];
+    } shards[NUM_SHARDS + 1];
 
-        /** Total accumulated latency for all units, in microseconds. */
-        uint64_t total_latency;
-    } data_int;
+    /** Start time of a unit in processing. */
+    struct UnitInFlight {
+        /** ID of the unit, with @c UNIT_CLAIMED set once finished. */
+        std::atomic<uint64_t> id;
+        /** Start time, in ticks. */
+        std::atomic<uint64_t> start;
+    } units_in_flight[MAX_UNITS_IN_FLIGHT];
 
-    /** Queue used to maintain the timestamps of when the unit
-     *  processing started. Required to calculate latency. */
-    std::map<uint64_t, struct timeval> unit_start_time_queue;
+    std::atomic<uint64_t> unit_id_counter; /**< Unique ID of the last unit. */
+    std::atomic<uint64_t> oldest_unit_id;  /**< ID of the oldest unit which may be in processing. */
+    std::atomic<uint64_t> num_overflowed_units; /**< Units whose start time was overwritten. */
+    std::atomic<uint64_t> num_overflowed_unfinished; /**< Overflowed units not finished yet. */
 
-    uint64_t unit_id_counter; /**< Unique ID of the last unit. */
+    /** Time at which the first unit was processed, in ticks. */
+    std::atomic<uint64_t> start_time;
+    /** Time at which the latest unit was processed, in ticks. */
+    std::atomic<uint64_t> stop_time;
+    /** Total accumulated time, in ticks.
+     *  When performance measurement is restarted @a start_time and @a stop_time
+     *  are reset. This field is used to accumulate time before
+     *  resetting. */
+    uint64_t accumulated_time;
 
     /**
      * Constructor for NvElementProfiler.
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Encoder Schedule API</b>
+ *
+ * @b Description: This file declares a helper class for compiling the
+ * runtime parameter changes and the per-frame input metadata files of the
+ * encoder into frame-indexed tables.
+ */
+
+#ifndef __NV_ENC_SCHEDULE_H__
+#define __NV_ENC_SCHEDULE_H__
+
+#include <stdint.h>
+#include <istream>
+#include <vector>
+#include <linux/videodev2.h>
+
+#include "v4l2_nv_extensions.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvencschedule_group Encoder Schedule API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+struct NvEncScheduleHeader;
+struct NvEncScheduleTable;
+
+/**
+ * @brief Helper class for precompiled encoder control schedules.
+ *
+ * @c %NvEncSchedule parses, once and before encoding starts, everything the
+ * encoder samples otherwise parse with @c operator>> while queuing frames:
+ *
+ * - The runtime parameter changes string, of the form
+ *   @c "f<frame>,<id><value>,...#f<frame>,...", as a list of changes, each
+ *   holding the frame it applies at and its bitrate, peak bitrate, frame
+ *   rate and force IDR operations.
+ * - The ROI, external RPS and external rate control hints files, as one
+ *   record of @c v4l2_enc_frame_ROI_params,
+ *   @c v4l2_enc_frame_ext_rps_ctrl_params or
+ *   @c v4l2_enc_frame_ext_rate_ctrl_params per frame.
+ * - The GDR file, as the list of GDR start frames and lengths.
+ *
+ * The files are parsed by replaying the stream based parsers of the samples
+ * frame after frame, so the records match what those parsers produce for
+ * the same frame, including the frames where a file is rewound at its end.
+ * Parsing stops as soon as the parser state repeats, and the lookup of the
+ * frames past the last record wraps around to the repeating records, so
+ * each lookup is a single table access. The record of a frame starts zeroed,
+ * fields the parser does not set are 0.
+ *
+ * The tables are laid out in a single binary image. When a cache path is
+ * given, the image is written to that file and later runs map it directly,
+ * as long as the sources have not changed, so that nothing is parsed at all.
+ */
+class NvEncSchedule
+{
+public:
+    /**
+     * Holds the sources of a schedule. Any of the members may be NULL.
+     */
+    typedef struct
+    {
+        /** Runtime parameter changes string. */
+        const char *runtime_params;
+        /** Path of the ROI parameters file. */
+        const char *roi_file_path;
+        /** Path of the external RPS parameters file. */
+        const char *rps_file_path;
+        /** Path of the external rate control hints file. */
+        const char *hints_file_path;
+        /** Path of the GDR parameters file. */
+        const char *gdr_file_path;
+    } NvEncScheduleSources;
+
+    /**
+     * Holds one operation of a runtime parameter change.
+     */
+    typedef struct
+    {
+        /** Property id: 'b' bitrate, 'p' peak bitrate, 'r' frame rate or
+         *  'i' force IDR. */
+        uint32_t id;
+        /** Value of the property, the numerator for the frame rate. */
+        uint32_t value;
+        /** Denominator for the frame rate, 0 otherwise. */
+        uint32_t value2;
+    } NvEncScheduleOp;
+
+    /**
+     * Holds a runtime parameter change.
+     */
+    typedef struct
+    {
+        /** Number of queued output plane buffers the change applies at. */
+        uint32_t frame;
+        /** Index of the first operation of the change. */
+        uint32_t first_op;
+        /** Number of operations of the change. */
+        uint32_t num_ops;
+        /** Set when the string could not be parsed past the operations of
+         *  this change. It is then the last change. */
+        uint32_t parse_error;
+    } NvEncScheduleChange;
+
+    /**
+     * Creates a new schedule from @a sources.
+     *
+     * If @a cache_path is not NULL and holds the image of a schedule
+     * compiled from the same sources, the image is mapped instead of
+     * parsing the sources. Otherwise the sources are parsed and the image
+     * is written to @a cache_path for the next run.
+     *
+     * @param[in] sources Sources of the schedule.
+     * @param[in] cache_path Optional path of the cached image.
+     * @return Reference to the newly created schedule object, or NULL
+     *          in case of failure during initialization.
+     */
+    static NvEncSchedule *createEncSchedule(const NvEncScheduleSources &sources,
+                                            const char *cache_path = NULL);
+    ~NvEncSchedule();
+
+    /**
+     * Gets the runtime parameter change at @a index, changes are in the
+     * order of the string.
+     *
+     * @return Pointer to the change, or NULL past the last change.
+     */
+    const NvEncScheduleChange *getRuntimeChange(uint32_t index) const;
+
+    /**
+     * Gets the number of runtime parameter changes.
+     */
+    uint32_t getNumRuntimeChanges() const;
+
+    /**
+     * Gets the first operation of the runtime parameter change @a change,
+     * its operations are contiguous.
+     */
+    const NvEncScheduleOp *getRuntimeOps(const NvEncScheduleChange *change) const;
+
+    /**
+     * Copies the ROI parameters of input frame @a index to @a params.
+     *
+     * @return 0 for success, -1 if the schedule has no ROI file.
+     */
+    int getRoiParams(uint32_t index, v4l2_enc_frame_ROI_params *params) const;
+
+    /**
+     * Copies the external RPS parameters of input frame @a index to
+     * @a params.
+     *
+     * @return 0 for success, -1 if the schedule has no RPS file.
+     */
+    int getRpsParams(uint32_t index,
+                     v4l2_enc_frame_ext_rps_ctrl_params *params) const;
+
+    /**
+     * Copies the external rate control parameters of input frame @a index
+     * to @a params.
+     *
+     * @return 0 for success, -1 if the schedule has no hints file.
+     */
+    int getRateCtrlParams(uint32_t index,
+                          v4l2_enc_frame_ext_rate_ctrl_params *params) const;
+
+    /**
+     * Gets the GDR entry @a index. Past the last entry @a start_frame_num
+     * is set to 0xFFFFFFFF and @a num_frames is left untouched.
+     */
+    void getGdrParams(uint32_t index, uint32_t *start_frame_num,
+                      uint32_t *num_frames) const;
+
+    /**
+     * Checks whether the schedule was mapped from its cached image.
+     */
+    bool isCached() const
+    {
+        return map_addr != NULL;
+    }
+
+private:
+    std::vector<uint8_t> image;     /**< Image built by compile(). */
+    void *map_addr;                 /**< Mapped cached image. */
+    uint64_t map_size;              /**< Size of the mapped cached image. */
+    const NvEncScheduleHeader *header; /**< Header of the image in use. */
+    bool is_in_error;
+
+    NvEncSchedule(const NvEncScheduleSources &sources, const char *cache_path);
+
+    static uint64_t getSourceStamp(const NvEncScheduleSources &sources);
+    bool mapCache(const char *cache_path, uint64_t stamp);
+    int writeCache(const char *cache_path);
+    int compile(const NvEncScheduleSources &sources, uint64_t stamp);
+
+    static int getNextParsedPair(std::istream &stream, char *id,
+                                 uint32_t *value);
+    static void compileRuntimeParams(const char *runtime_params,
+                                     std::vector<NvEncScheduleChange> &changes,
+                                     std::vector<NvEncScheduleOp> &ops);
+    static int compileRoi(const char *file_path,
+                          std::vector<v4l2_enc_frame_ROI_params> &records,
+                          uint32_t &loop_start);
+    static int compileRps(const char *file_path,
+                          std::vector<v4l2_enc_frame_ext_rps_ctrl_params> &records,
+                          uint32_t &loop_start);
+    static int compileRateCtrl(const char *file_path,
+                               std::vector<v4l2_enc_frame_ext_rate_ctrl_params> &records,
+                               uint32_t &loop_start);
+    static int compileGdr(const char *file_path, std::vector<uint32_t> &entries);
+
+    const void *getRecord(const NvEncScheduleTable &table, uint32_t index) const;
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvEncSchedule(const NvEncSchedule &that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvEncSchedule const&);
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Frame Source API</b>
+ *
+ * @b Description: This file declares a helper class that reads raw video
+ * frames from a file ahead of the encoder.
+ */
+
+#ifndef __NV_FRAME_SOURCE_H__
+#define __NV_FRAME_SOURCE_H__
+
+#include <iostream>
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvframesource_group Frame Source API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for reading raw video frames ahead of their use.
+ *
+ * @c %NvFrameSource keeps a bounded ring of frames that a pool of prefetch
+ * threads fills from the input file with positioned reads, while the
+ * encoder consumes them in order with readFrame(). As long as the disk
+ * keeps up on average, readFrame() only copies a frame that is already in
+ * memory into the output plane buffer, so file I/O latency never stalls the
+ * encoder queue.
+ *
+ * Frames are stored packed, in the layout read_video_frame() expects in the
+ * file: each plane is @c width * @c bytesperpixel bytes per row for
+ * @c height rows. readFrame() copies the rows to the plane stride of the
+ * buffer.
+ *
+ * Each time readFrame() has to wait for a frame that is still being read,
+ * a starvation event is counted. The events are reported by printStats().
+ *
+ * readFrame() must be called from one thread at a time.
+ */
+class NvFrameSource
+{
+public:
+    /**
+     * Holds the frame source statistics.
+     */
+    typedef struct
+    {
+        /** Number of frames returned by readFrame(). */
+        uint64_t frames_read;
+        /** Number of readFrame() calls that had to wait for the file. */
+        uint64_t starvation_count;
+        /** Total time spent waiting in readFrame(), in microseconds. */
+        uint64_t starvation_time_usec;
+        /** Longest wait in readFrame(), in microseconds. */
+        uint64_t max_starvation_usec;
+        /** Number of times the file was rewound in loop mode. */
+        uint64_t num_loops;
+    } NvFrameSourceStats;
+
+    /**
+     * Creates a new frame source for the file @a file_path and starts
+     * reading ahead.
+     *
+     * @param[in] name Unique name to identify the frame source in the stats.
+     * @param[in] file_path Path of the raw video file.
+     * @param[in] layout Buffer whose plane formats describe a frame.
+     * @param[in] start_offset Offset of the first frame in the file, in bytes.
+     * @param[in] num_frames_ahead Number of frames held in the ring.
+     * @param[in] loop Rewinds to the first frame at the end of the file
+     *                 instead of reporting the end of stream.
+     * @param[in] num_threads Number of prefetch threads.
+     * @return Reference to the newly created frame source object, or NULL
+     *          in case of failure during initialization.
+     */
+    static NvFrameSource *createFrameSource(const char *name,
+            const char *file_path, const NvBuffer &layout,
+            uint64_t start_offset = 0, uint32_t num_frames_ahead = 8,
+            bool loop = false, uint32_t num_threads = 1);
+    ~NvFrameSource();
+
+    /**
+     * Copies the next frame into @a buffer, waiting for it if it has not
+     * been read yet.
+     *
+     * Sets @c bytesused of every plane to @c stride * @c height.
+     *
+     * @param[in] buffer Buffer to be filled, with the plane formats of the
+     *                   layout given at creation.
+     * @return 0 for success, -1 at the end of the file or on a read error.
+     */
+    int readFrame(NvBuffer &buffer);
+
+    /**
+     * Gets the frame source statistics.
+     *
+     * @param[out] stats Reference to the statistics structure to fill.
+     */
+    void getStats(NvFrameSourceStats &stats);
+
+    /**
+     * Prints the frame source statistics to an output stream.
+     *
+     * @param[in] out_stream Output stream to print to, @c std::cout by default.
+     */
+    void printStats(std::ostream &out_stream = std::cout);
+
+    /**
+     * Checks whether reading the file failed.
+     */
+    bool isInError()
+    {
+        return is_in_error;
+    }
+
+private:
+    /**
+     * Holds one frame of the ring.
+     */
+    typedef struct
+    {
+        unsigned char *data;    /**< Packed frame data. */
+        uint64_t sequence;      /**< Sequence number of the frame held. */
+        enum
+        {
+            SLOT_FREE,
+            SLOT_LOADING,
+            SLOT_READY,
+            SLOT_FAILED
+        } state;
+    } Slot;
+
+    NvFrameSource(const char *name, const char *file_path,
+            const NvBuffer &layout, uint64_t start_offset,
+            uint32_t num_frames_ahead, bool loop, uint32_t num_threads);
+
+    /**
+     * Reads frame @a sequence of the file into @a data.
+     */
+    int loadFrame(uint64_t sequence, unsigned char *data);
+
+    static void *prefetchThread(void *arg);
+
+    char *name;                 /**< Name of the frame source. */
+    int fd;                     /**< FD of the input file. */
+    uint64_t start_offset;      /**< Offset of the first frame in the file. */
+    uint64_t frame_size;        /**< Size of a packed frame in bytes. */
+    uint64_t num_frames;        /**< Number of complete frames in the file. */
+    bool loop;                  /**< Rewind at the end of the file. */
+
+    uint32_t n_planes;                      /**< Number of planes in a frame. */
+    uint32_t row_bytes[MAX_PLANES];         /**< Packed row size of each plane. */
+    uint32_t plane_height[MAX_PLANES];      /**< Rows of each plane. */
+
+    std::vector<Slot> slots;    /**< Ring of frames. */
+    uint64_t next_load;         /**< Sequence number of the next frame to read. */
+    uint64_t next_consume;      /**< Sequence number of the next frame to return. */
+
+    pthread_mutex_t lock;       /**< Protects the ring and the stats. */
+    pthread_cond_t load_cond;   /**< Signaled when a slot becomes free. */
+    pthread_cond_t ready_cond;  /**< Signaled when a frame has been read. */
+    std::vector<pthread_t> threads; /**< Prefetch threads. */
+    bool stop;                  /**< Set to stop the prefetch threads. */
+
+    NvFrameSourceStats stats;   /**< Frame source statistics. */
+    bool is_in_error;           /**< Indicates if reading the file failed. */
+};
+/** @} */
+#endif
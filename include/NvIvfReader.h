@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: IVF Reader API</b>
+ *
+ * @b Description: This file declares a helper class for reading VP8, VP9
+ * and AV1 frames from IVF files.
+ */
+
+#ifndef __NV_IVF_READER_H__
+#define __NV_IVF_READER_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvivfreader_group IVF Reader API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for reading IVF files.
+ *
+ * @c %NvIvfReader maps the input file into memory, validates its DKIF file
+ * header and builds an index of all the frames by walking the 12-byte
+ * frame headers once. Each frame is a contiguous span of the mapped file,
+ * which is either handed out as is or copied into plane 0 of a buffer
+ * with a single @c memcpy.
+ *
+ * The index records whether each frame is a key frame, so that the read
+ * position can be moved to any frame or to the key frame preceding it.
+ * On end of stream the reader rewinds itself, so that the stream can be
+ * looped indefinitely.
+ */
+class NvIvfReader
+{
+public:
+    /**
+     * Holds the location of a frame within the input file.
+     */
+    typedef struct
+    {
+        /** Offset of the frame data in the file, past the frame header. */
+        uint64_t offset;
+        /** Size of the frame data in bytes. */
+        uint32_t size;
+        /** Presentation timestamp, in units of the file time base. */
+        uint64_t pts;
+        /** Set if the frame is a key frame, see isKeyFrame(). */
+        bool key_frame;
+    } NvIvfFrame;
+
+    /**
+     * Creates a new IVF reader for the file @a file_path and indexes
+     * all its frames.
+     *
+     * @param[in] file_path Path of the IVF file.
+     * @return Reference to the newly created reader object, or NULL
+     *          if the file cannot be read or is not an IVF file.
+     */
+    static NvIvfReader *createIvfReader(const char *file_path);
+    ~NvIvfReader();
+
+    /**
+     * Gets the next frame as a span of the mapped file and advances the
+     * read position.
+     *
+     * The span stays valid for the lifetime of the reader. On end of
+     * stream, NULL is returned and the read position is rewound to the
+     * first frame.
+     *
+     * @param[out] size Size of the frame in bytes, 0 on end of stream.
+     * @param[out] frame Optional pointer to the index entry of the frame.
+     *                   Set to NULL on end of stream.
+     * @return Pointer to the frame data, or NULL.
+     */
+    const uint8_t *getNextFrame(uint32_t &size,
+                                const NvIvfFrame **frame = NULL);
+
+    /**
+     * Copies the next frame into plane 0 of @a buffer and advances
+     * the read position.
+     *
+     * On end of stream, @c bytesused of plane 0 is set to 0 and the read
+     * position is rewound to the first frame.
+     *
+     * @param[in] buffer Buffer to be filled.
+     * @param[out] frame Optional pointer to the index entry of the frame
+     *                   that was copied. Set to NULL on end of stream.
+     * @return 0 for success, -1 if the frame does not fit in the buffer.
+     */
+    int readNextFrame(NvBuffer *buffer, const NvIvfFrame **frame = NULL);
+
+    /**
+     * Moves the read position to the frame at @a index.
+     *
+     * @return 0 for success, -1 if @a index is out of range.
+     */
+    int seek(uint64_t index);
+
+    /**
+     * Moves the read position to the last key frame at or before @a index,
+     * so that decoding can start cleanly from there. If no key frame
+     * precedes @a index, the read position is moved to the first frame.
+     *
+     * @param[in] index Index of the frame to seek to.
+     * @return Index of the frame the read position was moved to, or -1
+     *          if @a index is out of range.
+     */
+    int64_t seekToKeyFrame(uint64_t index);
+
+    /**
+     * Rewinds the read position to the first frame.
+     */
+    void rewind();
+
+    /**
+     * Gets the index of the next frame to be read.
+     */
+    uint64_t getPosition() const
+    {
+        return current;
+    }
+
+    /**
+     * Gets the number of frames in the file.
+     */
+    uint64_t getNumFrames() const
+    {
+        return frames.size();
+    }
+
+    /**
+     * Gets the index entry of the frame at @a index.
+     */
+    const NvIvfFrame &getFrame(uint64_t index) const
+    {
+        return frames[index];
+    }
+
+    /**
+     * Gets a pointer to the data of the frame at @a index in the
+     * mapped file.
+     */
+    const uint8_t *getFrameData(uint64_t index) const
+    {
+        return data + frames[index].offset;
+    }
+
+    /**
+     * Gets the codec FourCC of the file header, for example
+     * @c v4l2_fourcc('V','P','9','0').
+     */
+    uint32_t getFourcc() const
+    {
+        return fourcc;
+    }
+
+    /**
+     * Gets the frame width of the file header.
+     */
+    uint32_t getWidth() const
+    {
+        return width;
+    }
+
+    /**
+     * Gets the frame height of the file header.
+     */
+    uint32_t getHeight() const
+    {
+        return height;
+    }
+
+    /**
+     * Gets the time base of the timestamps, in seconds, as
+     * @a numerator / @a denominator.
+     */
+    void getTimeBase(uint32_t &numerator, uint32_t &denominator) const
+    {
+        numerator = timebase_num;
+        denominator = timebase_den;
+    }
+
+    /**
+     * Checks whether a frame is a key frame.
+     *
+     * For VP8 and VP9 the frame type is read from the frame header, and a
+     * VP9 superframe is classified by its first frame. For AV1 a temporal
+     * unit is treated as a key frame when it carries a sequence header OBU,
+     * which encoders emit with every key frame.
+     *
+     * @param[in] fourcc Codec FourCC of the file header.
+     * @param[in] frame Pointer to the frame data.
+     * @param[in] size Size of the frame in bytes.
+     * @return true if the frame is a key frame.
+     */
+    static bool isKeyFrame(uint32_t fourcc, const uint8_t *frame,
+                           uint32_t size);
+
+private:
+    /**
+     * Constructor which maps the file, validates its header and indexes
+     * the frames.
+     */
+    NvIvfReader(const char *file_path);
+
+    /**
+     * Builds the frame index of the mapped file.
+     */
+    void buildIndex();
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvIvfReader(const NvIvfReader& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvIvfReader const&);
+
+    int fd;                             /**< File descriptor of the input file. */
+    const uint8_t *data;                /**< Start of the mapped file. */
+    uint64_t size;                      /**< Size of the mapped file. */
+    uint32_t header_size;               /**< Size of the file header. */
+    uint32_t fourcc;                    /**< Codec FourCC. */
+    uint32_t width;                     /**< Frame width. */
+    uint32_t height;                    /**< Frame height. */
+    uint32_t timebase_den;              /**< Time base denominator. */
+    uint32_t timebase_num;              /**< Time base numerator. */
+    std::vector<NvIvfFrame> frames;     /**< Index of the frames. */
+    uint64_t current;                   /**< Index of the next frame to be read. */
+    bool is_in_error;                   /**< Set if initialization failed. */
+};
+
+/** @} */
+
+#endif
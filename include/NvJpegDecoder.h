@@ -56,9 +56,11 @@
 #endif
 
 #include <stdio.h>
+#include <vector>
 #include "jpeglib.h"
 #include "NvElement.h"
 #include "NvBuffer.h"
+#include "NvBufferPool.h"
 
 #ifndef MAX_CHANNELS
 /**
@@ -68,6 +70,25 @@
 #define MAX_CHANNELS 3
 #endif
 
+/**
+ * Holds a JPEG image to decode with NvJPEGDecoder::decodeBatch and,
+ * once decoded, the result.
+ */
+typedef struct
+{
+    unsigned char *in_buf;      /**< JPEG image. */
+    unsigned long in_buf_size;  /**< Size of the JPEG image in bytes. */
+    NvBuffer *buffer;           /**< Output buffer, reused from one batch to
+                                     the next. NULL, or a buffer too small
+                                     for the image, is replaced by a new
+                                     buffer that the application owns. */
+    uint32_t pixfmt;            /**< V4L2 pixel format of the image. */
+    uint32_t width;             /**< Width of the image in pixels. */
+    uint32_t height;            /**< Height of the image in pixels. */
+    int status;                 /**< 0 if decoded, -1 on error. */
+    uint64_t decode_time_us;    /**< Time spent decoding the image. */
+} NvJPEGDecodeJob;
+
 /**
  * @brief Helper class for decoding JPEG images using libjpeg APIs.
  *
@@ -127,7 +148,8 @@ public:
      * NvJPEGDecoder::decodeToFd method because it involves conversion
      * from hardware buffer memory to software buffer memory.
      *
-     * @attention The application must free the NvBuffer object.
+     * @attention The application must free the NvBuffer object, with
+     * delete or, when a buffer pool is set, with NvBuffer::unref().
      *
      * @param[out] buffer Indirect pointer to an @c %NvBuffer object that contains
      *                    the decoded image. The object is allocated by
@@ -147,13 +169,56 @@ public:
                          unsigned char *in_buf, unsigned long in_buf_size,
                          uint32_t *pixfmt, uint32_t *width, uint32_t *height);
 
+    /**
+     * Sets the pool the buffers returned by decodeToBuffer are taken from.
+     *
+     * Decoding a stream of same-sized images then reuses the memory of the
+     * released buffers instead of allocating planes for each image.
+     *
+     * @param[in] pool Buffer pool, must outlive the decoded buffers.
+     *                 NULL to allocate each buffer separately.
+     */
+    void setBufferPool(NvBufferPool *pool);
+
+    /**
+     * Decodes a batch of JPEG images to software buffer memory.
+     *
+     * Unlike decodeToBuffer, the output buffers are supplied by the
+     * application and reused across batches. Their planes are padded to
+     * whole MCUs, so that @c libjpeg writes straight into them instead of
+     * going through an extra full-frame copy. The plane formats give the
+     * image size and the padded @c stride. A buffer too small for its image
+     * is deleted and replaced, with memory from the buffer pool if one is
+     * set.
+     *
+     * The images are spread over @a num_decompressors decompressors, each
+     * on its own thread. The additional decompressors are kept for the next
+     * batches.
+     *
+     * @param[in,out] jobs Images to decode.
+     * @param[in] count Number of images.
+     * @param[in] num_decompressors Number of images decoded in parallel.
+     * @return 0 if all the images are decoded, -1 otherwise.
+     */
+    int decodeBatch(NvJPEGDecodeJob *jobs, uint32_t count,
+            uint32_t num_decompressors = 1);
+
 private:
 
     NvJPEGDecoder(const char *comp_name);
+    uint32_t getPixelFormat();
     void decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format);
     void decodeDirect(NvBuffer *out_buf, uint32_t pixel_format);
+    int decodeJob(NvJPEGDecodeJob &job);
+    int prepareBatchBuffer(NvJPEGDecodeJob &job, uint32_t pixel_format);
+    static void *batchThread(void *arg);
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
+    NvBufferPool *buffer_pool; /**< Pool of the decoded buffers, or NULL. */
+    unsigned char *scratch;    /**< Rows of the indirect decode. */
+    size_t scratch_size;       /**< Size of @c scratch. */
+    std::vector<NvJPEGDecoder *> batch_decoders; /**< Extra decompressors of
+                                                      decodeBatch. */
 
     static const NvElementProfiler::ProfilerField valid_fields =
             NvElementProfiler::PROFILER_FIELD_TOTAL_UNITS |
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Parallel Image Encode API</b>
+ *
+ * @b Description: This file declares a pool of NvJPEGEncoder instances
+ * encoding images in parallel.
+ */
+
+#ifndef __NV_JPEG_ENCODE_POOL_H__
+#define __NV_JPEG_ENCODE_POOL_H__
+
+#include <pthread.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "NvJpegEncoder.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvjpegencodepool_group Parallel Image Encoder
+ * @ingroup l4t_mm_nvimage_group
+ * @{
+ */
+
+/**
+ * Holds an image to encode and, once encoded, the result.
+ */
+typedef struct
+{
+    int fd;                     /**< FD of the hardware buffer to encode,
+                                     or -1 to encode @c buffer. */
+    NvBuffer *buffer;           /**< Software buffer to encode, used when
+                                     @c fd is -1. */
+    J_COLOR_SPACE color_space;  /**< Color space to encode with. */
+    int quality;                /**< Image quality. */
+    void *user_data;            /**< Passed back untouched. */
+
+    uint64_t sequence;          /**< Submission order, set by
+                                     NvJpegEncodePool::submit. */
+    int status;                 /**< 0 if encoded, -1 on error. */
+    unsigned char *out_buf;     /**< JPEG image, owned by the pool. */
+    unsigned long out_buf_size; /**< Size of the JPEG image in bytes. */
+} NvJpegEncodeJob;
+
+/**
+ * @brief Encodes JPEG images on several NvJPEGEncoder instances in parallel.
+ *
+ * A single NvJPEGEncoder encodes one image at a time on the calling thread.
+ * The pool runs one encoder per worker thread, so that the @c libjpeg
+ * software path, NvJPEGEncoder::encodeFromBuffer, scales with the CPU cores
+ * and hardware encodes overlap.
+ *
+ * Images are submitted in batches with submit(). Results are delivered to
+ * a callback in submission order, one at a time, even though encodes
+ * complete out of order. At most @a max_in_flight images are pending:
+ * submit() blocks until earlier images are delivered, which bounds the
+ * memory used and lets the producer reuse its source buffers safely.
+ *
+ * Each in-flight slot keeps its output buffer from one image to the next,
+ * growing it when @c libjpeg needs more room, so that steady state encoding
+ * does not allocate.
+ */
+class NvJpegEncodePool
+{
+public:
+    /**
+     * Delivers an encoded image.
+     *
+     * Called on a worker thread, never concurrently, in submission order.
+     * The @c out_buf memory of the job is reused once the callback returns.
+     * The source buffer of the job is no longer used by the pool. The
+     * callback must not call submit() or waitPending().
+     *
+     * @param[in] job The encoded image.
+     * @param[in] arg Argument given to createJpegEncodePool.
+     */
+    typedef void (*DeliverCallback)(const NvJpegEncodeJob &job, void *arg);
+
+    /**
+     * Creates a pool of JPEG encoders.
+     *
+     * @param[in] name Name of the pool, its encoders are named after it.
+     * @param[in] num_encoders Number of encoders and worker threads, 0 for
+     *                         one per online CPU.
+     * @param[in] max_in_flight Images pending before submit() blocks, 0 for
+     *                          twice the number of encoders.
+     * @param[in] out_buf_size Initial size of the output buffers in bytes,
+     *                         0 to let @c libjpeg size them.
+     * @param[in] callback Callback receiving the encoded images.
+     * @param[in] arg Argument passed to @a callback.
+     * @return A reference to the pool, or NULL on error.
+     */
+    static NvJpegEncodePool *createJpegEncodePool(const char *name,
+            uint32_t num_encoders, uint32_t max_in_flight,
+            unsigned long out_buf_size, DeliverCallback callback, void *arg);
+
+    /**
+     * Waits for the pending images to be delivered, then destroys the
+     * encoders.
+     */
+    ~NvJpegEncodePool();
+
+    /**
+     * Submits images to encode.
+     *
+     * Blocks while @a max_in_flight images are pending. The sources of the
+     * jobs must stay valid until the jobs are delivered.
+     *
+     * @param[in,out] jobs Images to encode, @c sequence is set on return.
+     * @param[in] count Number of images.
+     * @return 0 for success, -1 if the pool is in error.
+     */
+    int submit(NvJpegEncodeJob *jobs, uint32_t count);
+
+    /**
+     * Waits until at most @a max_pending images are pending.
+     *
+     * Producers reusing a ring of source buffers call this before refilling
+     * the buffer of the oldest pending image. waitPending(0) waits for all
+     * the submitted images to be delivered.
+     *
+     * @param[in] max_pending Number of images that may remain pending.
+     */
+    void waitPending(uint32_t max_pending);
+
+    /**
+     * Gets the number of encoders of the pool.
+     */
+    uint32_t getNumEncoders() const
+    {
+        return encoders.size();
+    }
+
+    /**
+     * Enables profiling of all the encoders.
+     */
+    void enableProfiling();
+
+    /**
+     * Prints the profiling statistics of each encoder.
+     *
+     * @param[in] out_stream Stream to print to.
+     */
+    void printProfilingStats(std::ostream &out_stream = std::cout);
+
+    /**
+     * Checks whether an encoder could not be created.
+     */
+    bool isInError() const
+    {
+        return is_in_error;
+    }
+
+private:
+    /**
+     * Holds an image between submission and delivery.
+     */
+    typedef struct
+    {
+        NvJpegEncodeJob job;        /**< Image and result. */
+        bool done;                  /**< Set once encoded. */
+        unsigned char *out_buf;     /**< Persistent output buffer. */
+        unsigned long out_buf_size; /**< Size of @c out_buf. */
+    } Slot;
+
+    /**
+     * Holds a worker thread and its encoder.
+     */
+    typedef struct
+    {
+        NvJpegEncodePool *pool;     /**< Owning pool. */
+        NvJPEGEncoder *encoder;     /**< Encoder used by the worker only. */
+        pthread_t thread;           /**< Worker thread. */
+    } Worker;
+
+    NvJpegEncodePool(const char *name, uint32_t num_encoders,
+            uint32_t max_in_flight, unsigned long out_buf_size,
+            DeliverCallback callback, void *arg);
+
+    static void *workerThread(void *arg);
+
+    /**
+     * Encodes the image of a slot.
+     */
+    void encode(NvJPEGEncoder *encoder, Slot &slot);
+
+    /**
+     * Delivers the encoded images that are next in order. Must be called
+     * with @c lock held, which it releases while calling the callback.
+     */
+    void deliverLocked();
+
+    std::vector<std::string> encoder_names; /**< Names the encoders point to. */
+    std::vector<NvJPEGEncoder *> encoders;
+    std::vector<Worker> workers;
+    std::vector<Slot> slots;        /**< Ring indexed by sequence number. */
+
+    DeliverCallback callback;
+    void *callback_arg;
+
+    pthread_mutex_t lock;           /**< Protects the fields below. */
+    pthread_cond_t work_cond;       /**< Signalled on submission and exit. */
+    pthread_cond_t slot_cond;       /**< Signalled on delivery. */
+    uint64_t next_submit;           /**< Sequence of the next image. */
+    uint64_t next_encode;           /**< Next image to hand to a worker. */
+    uint64_t next_deliver;          /**< Next image to deliver. */
+    bool delivering;                /**< Set while a thread delivers. */
+    bool stop;                      /**< Tells the workers to exit. */
+    bool is_in_error;
+
+    /**
+     * Disallows copy constructor.
+     */
+    NvJpegEncodePool(const NvJpegEncodePool& that);
+    /**
+     * Disallows assignment.
+     */
+    void operator=(NvJpegEncodePool const&);
+};
+
+/** @} */
+
+#endif
@@ -36,8 +36,10 @@
 #ifndef __NV_LOGGING_H_
 #define __NV_LOGGING_H_
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
+#include <stdint.h>
 
 /**
  *
@@ -79,6 +81,16 @@ extern int log_level;
  */
 #define DEFAULT_LOG_LEVEL LOG_LEVEL_ERROR
 
+/**
+ * Specifies the highest log level compiled in. Messages of a higher level
+ * are removed at compile time whatever the runtime log_level, for instance
+ * build with @c -DLOG_LEVEL_COMPILED=LOG_LEVEL_WARN to drop debug messages
+ * from the hot paths.
+ */
+#ifndef LOG_LEVEL_COMPILED
+#define LOG_LEVEL_COMPILED LOG_LEVEL_DEBUG
+#endif
+
 /**
  * @cond
  */
@@ -87,6 +99,21 @@ extern int log_level;
 #define __LINE_NUM_STR__ xstringify(__LINE__)
 
 extern const char *log_level_name[];
+
+/**
+ * Holds the rate limiting state of one logging call site.
+ */
+struct NvLogSite
+{
+    std::atomic<uint64_t> window;     /**< Current one second window. */
+    std::atomic<uint32_t> count;      /**< Messages in the window. */
+    std::atomic<uint32_t> suppressed; /**< Messages dropped since the last
+                                           one printed. */
+};
+
+bool nvLogAdmit(NvLogSite &site);
+std::ostream &nvLogBegin(int level, const char *location);
+void nvLogEnd(NvLogSite &site);
 /**
  * @endcond
  */
@@ -101,15 +128,28 @@ extern const char *log_level_name[];
  * Messages are in the following form:
  * [LEVEL] (FILE: LINE_NUM) Message
  *
+ * Messages are formatted into a buffer owned by the calling thread, without
+ * allocating. They are written to @c std::cerr right away, unless the
+ * @c NVMM_LOG_ASYNC or @c NVMM_LOG_FILE environment variables are set: the
+ * messages are then copied to a lock-free ring of the calling thread and
+ * written to stderr, or appended to the named file, by a background thread.
+ *
+ * Messages are not rate limited by default. When the @c NVMM_LOG_RATE
+ * environment variable is set to a non-zero value, each call site prints at
+ * most that many messages per second; the number of messages suppressed is
+ * appended to the next message printed by the site.
+ *
  * @param[in] level The Log level of the message.
  * @param[in] str1 The NULL-terminated char array to print.
  */
-#define PRINT_MSG(level, str1) if(level <= log_level) { \
-                                  std::ostringstream ostr; \
-                                  ostr << "[" << log_level_name[level] << "] ("  << \
-                                  __FILE__ << ":" __LINE_NUM_STR__ ") " << \
-                                  str1 << std::endl; \
-                                  std::cerr << ostr.str(); \
+#define PRINT_MSG(level, str1) if(level <= LOG_LEVEL_COMPILED && level <= log_level) { \
+                                  static NvLogSite nv_log_site; \
+                                  if (nvLogAdmit(nv_log_site)) { \
+                                      std::ostream &nv_log_stream = nvLogBegin(level, \
+                                              __FILE__ ":" __LINE_NUM_STR__); \
+                                      nv_log_stream << str1; \
+                                      nvLogEnd(nv_log_site); \
+                                  } \
                               }
 
 /**
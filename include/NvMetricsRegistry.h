@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Metrics Registry API</b>
+ *
+ * @b Description: This file declares a registry that exports live element
+ * and application metrics while the application runs.
+ */
+
+#ifndef __NV_METRICS_REGISTRY_H__
+#define __NV_METRICS_REGISTRY_H__
+
+#include <deque>
+#include <fstream>
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "NvElementProfiler.h"
+
+class NvElement;
+class NvApplicationProfiler;
+
+/**
+ *
+ * @defgroup l4t_mm_nvmetricsregistry_group Metrics Registry API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Registry of the live metrics of the elements of the application.
+ *
+ * Every NvElement registers its profiler with the registry when it is
+ * created and unregisters it when it is deleted. Applications can name the
+ * stream an element processes with registerStream(), and
+ * NvApplicationProfiler registers itself when it is started.
+ *
+ * Once startExporter() is called, a sampler thread reads the counters of
+ * every registered element each interval and computes the FPS, the number
+ * of late units and the latency percentiles over a sliding window, along
+ * with the number of buffers queued on the planes of V4L2 elements. The
+ * sampler only reads the lock-free profiler counters, so it never blocks
+ * the threads that process units. Elements must have profiling enabled to
+ * report units and latencies.
+ *
+ * Each snapshot can be appended as a JSON line to a file, and served on
+ * request over HTTP from a localhost TCP port or a Unix socket, in the
+ * Prometheus text format at @c /metrics or as JSON at @c /metrics.json.
+ * For instance:
+ * @code
+ * curl http://127.0.0.1:9100/metrics
+ * curl --unix-socket /tmp/nvmm.sock http://localhost/metrics.json
+ * @endcode
+ *
+ * Only one instance of the registry exists, accessed with getInstance().
+ */
+class NvMetricsRegistry
+{
+public:
+    /**
+     * Holds the metrics of one element over the sampling window.
+     */
+    typedef struct
+    {
+        /** Name of the element. */
+        std::string name;
+        /** Name of the stream processed by the element, empty if unknown. */
+        std::string stream;
+        /** Total number of units processed. */
+        uint64_t total_units;
+        /** Total number of units that arrived late. */
+        uint64_t total_late_units;
+        /** Number of units that arrived late during the window. */
+        uint64_t window_late_units;
+        /** Rate at which units were processed during the window. */
+        float window_fps;
+        /** Rate at which units were processed since profiling started. */
+        float average_fps;
+        /** Latency percentiles during the window, in microseconds. */
+        float p50_latency_usec;
+        float p90_latency_usec;
+        float p99_latency_usec;
+        /** Highest latency bucket seen during the window, in microseconds. */
+        float max_latency_usec;
+        /** Buffers queued on the output plane, -1 if the element has none. */
+        int32_t output_queue_depth;
+        /** Buffers queued on the capture plane, -1 if the element has none. */
+        int32_t capture_queue_depth;
+    } NvMetricsElementData;
+
+    /**
+     * Holds a snapshot of all the metrics.
+     */
+    typedef struct
+    {
+        /** Wall-clock time of the snapshot, in milliseconds since the epoch. */
+        uint64_t timestamp_ms;
+        /** Length of the sliding window, in milliseconds. */
+        uint32_t window_ms;
+        /** CPU usage of the process during the window, in percent of all
+         *  the cores. */
+        float process_cpu_usage;
+        /** Indicates if the application profiler fields are valid. */
+        bool has_app_profiler;
+        /** Average CPU usage reported by NvApplicationProfiler. */
+        float app_avg_cpu_usage;
+        /** Peak CPU usage reported by NvApplicationProfiler. */
+        float app_peak_cpu_usage;
+        /** Sum of the window FPS of the elements that process a stream. */
+        float total_stream_fps;
+        /** Metrics of each registered element. */
+        std::vector<NvMetricsElementData> elements;
+    } NvMetricsSnapshot;
+
+    /**
+     * Gets a reference to the global registry.
+     */
+    static NvMetricsRegistry &getInstance();
+
+    /**
+     * Registers the profiler of an element.
+     *
+     * Called by NvElement, the profiler must stay valid until
+     * unregisterElement() is called.
+     *
+     * @param[in] name Name of the element.
+     * @param[in] profiler Profiler of the element.
+     * @return ID of the element in the registry.
+     */
+    uint32_t registerElement(const char *name, NvElementProfiler *profiler);
+
+    /**
+     * Sets the counters of queued buffers of an element, or NULL if the
+     * element has none. The counters must stay valid until they are reset
+     * to NULL or the element is unregistered.
+     */
+    void setElementQueues(uint32_t id, const uint32_t *output_queued,
+            const uint32_t *capture_queued);
+
+    /**
+     * Unregisters an element.
+     */
+    void unregisterElement(uint32_t id);
+
+    /**
+     * Names the stream that @a element processes, so that its metrics are
+     * labeled with the stream and counted in the total stream FPS.
+     *
+     * @param[in] element Element processing the stream.
+     * @param[in] stream Name of the stream, usually its file name.
+     */
+    void registerStream(NvElement *element, const char *stream);
+
+    /**
+     * Registers the application profiler, called by NvApplicationProfiler
+     * when it starts.
+     */
+    void setApplicationProfiler(NvApplicationProfiler *profiler);
+
+    /**
+     * Starts sampling the metrics and exporting them.
+     *
+     * Any of the exports can be disabled. Calling it again while the
+     * exporter runs does nothing.
+     *
+     * @param[in] interval_ms Interval between two samples, in milliseconds.
+     * @param[in] window_ms Length of the sliding window, in milliseconds.
+     * @param[in] http_port Localhost TCP port to serve the metrics on,
+     *                      0 to disable.
+     * @param[in] socket_path Path of the Unix socket to serve the metrics
+     *                        on, NULL to disable.
+     * @param[in] json_file_path Path of the file the JSON lines are
+     *                           appended to, NULL to disable.
+     * @return 0 for success, -1 otherwise.
+     */
+    int startExporter(uint32_t interval_ms, uint32_t window_ms,
+            uint16_t http_port, const char *socket_path,
+            const char *json_file_path);
+
+    /**
+     * Stops the exporter, after writing a last snapshot to the JSON file.
+     */
+    void stopExporter();
+
+    /**
+     * Gets the latest snapshot taken by the exporter.
+     *
+     * @param[out] snapshot Reference to the snapshot to fill.
+     */
+    void getSnapshot(NvMetricsSnapshot &snapshot);
+
+    /**
+     * Writes a snapshot in the Prometheus text exposition format.
+     */
+    static void writePrometheus(const NvMetricsSnapshot &snapshot,
+            std::ostream &out_stream);
+
+    /**
+     * Writes a snapshot as a single JSON line.
+     */
+    static void writeJson(const NvMetricsSnapshot &snapshot,
+            std::ostream &out_stream);
+
+private:
+    /**
+     * Holds the counters of an element at one sampling time.
+     */
+    typedef struct
+    {
+        uint64_t time_usec;     /**< Monotonic time of the sample. */
+        uint64_t total_units;   /**< Units processed. */
+        uint64_t late_units;    /**< Late units. */
+        /** Latency histogram, see NvElementProfiler::getLatencyHistogram(). */
+        std::vector<uint64_t> histogram;
+    } ElementSample;
+
+    /**
+     * Holds a registered element.
+     */
+    typedef struct
+    {
+        uint32_t id;                    /**< ID of the element. */
+        std::string name;               /**< Name of the element. */
+        std::string stream;             /**< Name of its stream. */
+        NvElementProfiler *profiler;    /**< Profiler of the element. */
+        const uint32_t *output_queued;  /**< Output plane queue counter. */
+        const uint32_t *capture_queued; /**< Capture plane queue counter. */
+        std::deque<ElementSample> window; /**< Samples of the window. */
+    } Element;
+
+    NvMetricsRegistry();
+
+    /**
+     * Samples all the elements and updates the snapshot.
+     */
+    void sample();
+
+    static void *samplerThread(void *arg);
+    static void *serverThread(void *arg);
+
+    /**
+     * Opens the listening socket of the server.
+     */
+    int openServerSocket(uint16_t http_port, const char *socket_path);
+
+    /**
+     * Answers one HTTP request on @a fd.
+     */
+    void serveRequest(int fd);
+
+    pthread_mutex_t lock;           /**< Protects the elements. */
+    std::vector<Element> elements;  /**< Registered elements. */
+    uint32_t next_id;               /**< ID of the next element. */
+    NvApplicationProfiler *app_profiler; /**< Registered application profiler. */
+
+    pthread_mutex_t snapshot_lock;  /**< Protects the snapshot. */
+    NvMetricsSnapshot snapshot;     /**< Latest snapshot. */
+
+    pthread_mutex_t exporter_lock;  /**< Serializes start and stop. */
+    bool running;                   /**< Indicates if the exporter runs. */
+    uint32_t interval_ms;           /**< Sampling interval. */
+    uint32_t window_ms;             /**< Sliding window length. */
+    int stop_fd;                    /**< eventfd signaled to stop the threads. */
+    int server_fd;                  /**< Listening socket, -1 if disabled. */
+    std::string socket_path;        /**< Path of the Unix socket. */
+    std::ofstream *json_file;       /**< JSON lines file, NULL if disabled. */
+    pthread_t sampler;              /**< Sampler thread. */
+    pthread_t server;               /**< Server thread. */
+
+    std::deque<std::pair<uint64_t, uint64_t> > cpu_window; /**< Monotonic
+                                         and CPU times of the window. */
+};
+/** @} */
+#endif
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: MJPEG Reader API</b>
+ *
+ * @b Description: This file declares a helper class for splitting MJPEG
+ * streams and concatenated JPEG files into individual JPEG images.
+ */
+
+#ifndef __NV_MJPEG_READER_H__
+#define __NV_MJPEG_READER_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvmjpegreader_group MJPEG Reader API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for splitting MJPEG streams into JPEG images.
+ *
+ * @c %NvMjpegReader maps the input file into memory and builds an index
+ * of all the JPEG images in a single pass over the file. Each image spans
+ * from its SOI marker up to and including its EOI marker.
+ *
+ * The images are delimited by walking their marker segments, so an
+ * @c FF @c D9 byte pair inside a segment payload, such as an EXIF thumbnail,
+ * does not end the image early. Only the entropy-coded data following each
+ * SOS marker is scanned for markers, with SSE2 or NEON where available.
+ * Stuffed bytes (@c FF @c 00), fill bytes and restart markers are skipped.
+ *
+ * Bytes between images are skipped. An image that is truncated or whose
+ * marker segments are corrupted is dropped from the index with a warning.
+ *
+ * Images are handed out either as spans of the mapped file, which the
+ * JPEG decoder can read in place, or copied into plane 0 of a buffer
+ * with a single @c memcpy.
+ */
+class NvMjpegReader
+{
+public:
+    /**
+     * Holds the location of a JPEG image within the input file.
+     */
+    typedef struct
+    {
+        /** Offset of the SOI marker in the file. */
+        uint64_t offset;
+        /** Size of the image in bytes, from SOI to EOI included. */
+        uint32_t size;
+        /** Image width from the SOF segment, 0 if there is none. */
+        uint16_t width;
+        /** Image height from the SOF segment, 0 if there is none. */
+        uint16_t height;
+    } NvMjpegFrame;
+
+    /**
+     * Creates a new MJPEG reader for the file @a file_path and indexes
+     * all its images.
+     *
+     * @param[in] file_path Path of the MJPEG stream or concatenated JPEG file.
+     * @return Reference to the newly created reader object, or NULL
+     *          in case of failure during initialization.
+     */
+    static NvMjpegReader *createMjpegReader(const char *file_path);
+    ~NvMjpegReader();
+
+    /**
+     * Gets the next image as a span of the mapped file and advances the
+     * read position.
+     *
+     * The span stays valid for the lifetime of the reader. On end of
+     * stream, NULL is returned and the read position is rewound to the
+     * first image, so that the stream can be looped.
+     *
+     * @param[out] size Size of the image in bytes, 0 on end of stream.
+     * @param[out] frame Optional pointer to the index entry of the image.
+     *                   Set to NULL on end of stream.
+     * @return Pointer to the SOI marker of the image, or NULL.
+     */
+    const uint8_t *getNextFrame(uint32_t &size,
+                                const NvMjpegFrame **frame = NULL);
+
+    /**
+     * Copies the next image into plane 0 of @a buffer and advances
+     * the read position.
+     *
+     * On end of stream, @c bytesused of plane 0 is set to 0 and the read
+     * position is rewound to the first image.
+     *
+     * @param[in] buffer Buffer to be filled.
+     * @param[out] frame Optional pointer to the index entry of the image
+     *                   that was copied. Set to NULL on end of stream.
+     * @return 0 for success, -1 if the image does not fit in the buffer.
+     */
+    int readNextFrame(NvBuffer *buffer, const NvMjpegFrame **frame = NULL);
+
+    /**
+     * Rewinds the read position to the first image.
+     */
+    void rewind();
+
+    /**
+     * Gets the number of images in the stream.
+     */
+    uint64_t getNumFrames() const
+    {
+        return frames.size();
+    }
+
+    /**
+     * Gets the index entry of the image at @a index.
+     */
+    const NvMjpegFrame &getFrame(uint64_t index) const
+    {
+        return frames[index];
+    }
+
+    /**
+     * Gets a pointer to the SOI marker of the image at @a index
+     * in the mapped file.
+     */
+    const uint8_t *getFrameData(uint64_t index) const
+    {
+        return data + frames[index].offset;
+    }
+
+    /**
+     * Gets the size of the input file in bytes.
+     */
+    uint64_t getFileSize() const
+    {
+        return size;
+    }
+
+    /**
+     * Finds the first marker in the range [@a begin, @a end), that is the
+     * first @c FF byte followed by a byte other than @c 00 and @c FF.
+     *
+     * Stuffed bytes are skipped, and of a run of fill bytes only the last
+     * @c FF is returned.
+     *
+     * @return Pointer to the @c FF byte of the marker, or @a end if no
+     *          marker is found.
+     */
+    static const uint8_t *findMarker(const uint8_t *begin,
+                                     const uint8_t *end);
+
+    /**
+     * Parses the JPEG image starting at @a begin by walking its marker
+     * segments up to its EOI marker.
+     *
+     * This can also be used to get the exact size of a captured MJPEG
+     * frame whose buffer holds padding bytes after the image.
+     *
+     * @param[in] begin Pointer to the SOI marker of the image.
+     * @param[in] end End of the valid data.
+     * @param[out] width Optional image width from the SOF segment.
+     * @param[out] height Optional image height from the SOF segment.
+     * @return Size of the image in bytes including the EOI marker, or 0 if
+     *          the image is truncated or corrupted.
+     */
+    static uint32_t parseFrame(const uint8_t *begin, const uint8_t *end,
+                               uint16_t *width = NULL,
+                               uint16_t *height = NULL);
+
+private:
+    /**
+     * Constructor which maps and indexes the file.
+     */
+    NvMjpegReader(const char *file_path);
+
+    /**
+     * Builds the image index of the mapped file.
+     */
+    void buildIndex();
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvMjpegReader(const NvMjpegReader& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvMjpegReader const&);
+
+    int fd;                             /**< File descriptor of the input file. */
+    const uint8_t *data;                /**< Start of the mapped file. */
+    uint64_t size;                      /**< Size of the mapped file. */
+    std::vector<NvMjpegFrame> frames;   /**< Index of the images. */
+    uint64_t current;                   /**< Index of the next image to be read. */
+    bool is_in_error;                   /**< Set if initialization failed. */
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: MP4 Muxer API</b>
+ *
+ * @b Description: This file declares a helper class for writing encoded
+ * H.264, H.265 and AV1 streams to fragmented MP4 files.
+ */
+
+#ifndef __NV_MP4_MUXER_H__
+#define __NV_MP4_MUXER_H__
+
+#include <stdint.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "NvBuffer.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvmp4muxer_group MP4 Muxer API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Helper class for writing fragmented MP4 files.
+ *
+ * @c %NvMp4Muxer takes the encoder capture plane buffers as they are
+ * dequeued and writes them as the samples of a single video track of a
+ * fragmented ISO base media file. The parameter sets found in the stream
+ * (SPS, PPS and VPS for H.264 and H.265, the sequence header OBU for AV1)
+ * are turned into the @c avcC, @c hvcC or @c av1C decoder configuration,
+ * which is written with the @c moov box in front of the first sample.
+ *
+ * The samples are collected in memory and written as one @c moof and
+ * @c mdat fragment per GOP, starting at each key frame. A fragment is
+ * written with a single @c writev() of its headers and of the collected
+ * sample data, so the file is playable up to the last complete fragment
+ * at any time. H.264 and H.265 NAL units are converted from start code
+ * prefixes to 4-byte length prefixes while they are collected. Any IVF
+ * headers emitted with AV1 frames are dropped.
+ *
+ * Timestamps are given in microseconds. Decode timestamps are derived from
+ * the presentation timestamps of the samples of each fragment, so streams
+ * with B-frames are written with composition time offsets. A sample with
+ * the same timestamp as the previous one, which happens when the encoder
+ * input carries no timestamps, is placed one nominal frame duration after
+ * it.
+ *
+ * Samples must be written from one thread at a time.
+ */
+class NvMp4Muxer
+{
+public:
+    /**
+     * Creates a new MP4 muxer writing to @a file_path, which is truncated.
+     *
+     * @param[in] file_path Path of the output file.
+     * @param[in] pixfmt Codec of the stream, one of @c V4L2_PIX_FMT_H264,
+     *                   @c V4L2_PIX_FMT_H265 or @c V4L2_PIX_FMT_AV1.
+     * @param[in] width Frame width.
+     * @param[in] height Frame height.
+     * @param[in] fps_n Numerator of the nominal frame rate.
+     * @param[in] fps_d Denominator of the nominal frame rate.
+     * @return Reference to the newly created muxer object, or NULL in case
+     *          of failure during initialization.
+     */
+    static NvMp4Muxer *createMp4Muxer(const char *file_path, uint32_t pixfmt,
+            uint32_t width, uint32_t height, uint32_t fps_n = 30,
+            uint32_t fps_d = 1);
+
+    /**
+     * Writes the last fragment and closes the file.
+     */
+    ~NvMp4Muxer();
+
+    /**
+     * Adds one encoded frame to the file.
+     *
+     * The data is converted into the sample, @a data can be reused as soon
+     * as the call returns. Samples before the first key frame carrying
+     * the parameter sets are dropped.
+     *
+     * @param[in] data Encoded frame, as output by the encoder.
+     * @param[in] size Number of bytes of the frame.
+     * @param[in] pts Presentation timestamp in microseconds.
+     * @return 0 for success, -1 if the frame is malformed or writing to the
+     *          file failed.
+     */
+    int writeSample(const uint8_t *data, uint32_t size, uint64_t pts);
+
+    /**
+     * Adds the encoded frame held in plane 0 of an encoder capture plane
+     * buffer to the file, with the timestamp of @a v4l2_buf.
+     *
+     * @param[in] v4l2_buf V4L2 buffer as dequeued from the capture plane.
+     * @param[in] buffer %NvBuffer holding the encoded frame.
+     * @return 0 for success, -1 otherwise. See writeSample().
+     */
+    int writeBuffer(const struct v4l2_buffer *v4l2_buf, NvBuffer *buffer);
+
+    /**
+     * Writes the pending fragment and closes the file. Samples cannot be
+     * added afterwards.
+     *
+     * @return 0 for success, -1 if writing to the file failed.
+     */
+    int close();
+
+    /**
+     * Gets the number of samples written to the file.
+     */
+    uint64_t getNumSamples()
+    {
+        return num_samples;
+    }
+
+    /**
+     * Gets the number of fragments written to the file.
+     */
+    uint64_t getNumFragments()
+    {
+        return num_fragments;
+    }
+
+    /**
+     * Checks whether writing the file failed.
+     */
+    bool isInError()
+    {
+        return is_in_error;
+    }
+
+private:
+    /**
+     * Holds a sample of the pending fragment.
+     */
+    typedef struct
+    {
+        /** Size of the sample in bytes. */
+        uint32_t size;
+        /** Presentation timestamp, in units of the track time scale. */
+        int64_t pts;
+        /** Set if the sample is a key frame. */
+        bool key_frame;
+    } NvMp4Sample;
+
+    /**
+     * Constructor which opens the output file.
+     */
+    NvMp4Muxer(const char *file_path, uint32_t pixfmt, uint32_t width,
+            uint32_t height, uint32_t fps_n, uint32_t fps_d);
+
+    /**
+     * Converts the NAL units of an H.264 or H.265 frame into the pending
+     * fragment and collects the parameter sets.
+     */
+    int addNalUnits(const uint8_t *data, uint32_t size, bool &key_frame);
+
+    /**
+     * Copies the OBUs of an AV1 temporal unit into the pending fragment
+     * and collects the sequence header.
+     */
+    int addObus(const uint8_t *data, uint32_t size, bool &key_frame);
+
+    /**
+     * Builds the codec specific decoder configuration box.
+     */
+    int buildCodecConfig(std::vector<uint8_t> &out);
+
+    /**
+     * Writes the @c ftyp and @c moov boxes.
+     */
+    int writeHeader();
+
+    /**
+     * Writes the pending samples, whose data are the first @a data_size
+     * bytes of @a sample_data, as one @c moof and @c mdat fragment.
+     */
+    int writeFragment(uint32_t data_size);
+
+    /**
+     * Writes @a iovcnt buffers to the file, retrying partial writes.
+     */
+    int writeFully(struct iovec *iov, int iovcnt);
+
+    /**
+     * Disallow copy constructor.
+     */
+    NvMp4Muxer(const NvMp4Muxer& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(NvMp4Muxer const&);
+
+    int fd;                             /**< File descriptor of the output file. */
+    uint32_t pixfmt;                    /**< Codec of the stream. */
+    uint32_t width;                     /**< Frame width. */
+    uint32_t height;                    /**< Frame height. */
+    uint32_t frame_duration;            /**< Nominal frame duration, in units
+                                             of the track time scale. */
+
+    std::vector<uint8_t> vps;           /**< H.265 video parameter set. */
+    std::vector<uint8_t> sps;           /**< H.264 or H.265 sequence
+                                             parameter set. */
+    std::vector<uint8_t> pps;           /**< H.264 or H.265 picture
+                                             parameter set. */
+    std::vector<uint8_t> sequence_header; /**< AV1 sequence header OBU. */
+    bool header_written;                /**< Set once @c moov is written. */
+    bool warned_parameter_sets;         /**< Set once a change of the
+                                             parameter sets was reported. */
+
+    std::vector<uint8_t> sample_data;   /**< Data of the pending samples. */
+    std::vector<NvMp4Sample> samples;   /**< Pending samples. */
+    std::vector<uint8_t> fragment_header; /**< Scratch space for the
+                                               @c moof box. */
+
+    bool have_pts;                      /**< Set once a sample was added. */
+    uint64_t first_pts;                 /**< Timestamp of the first sample,
+                                             in microseconds. */
+    uint64_t last_input_pts;            /**< Timestamp passed with the
+                                             previous sample. */
+    int64_t last_pts;                   /**< Presentation timestamp of the
+                                             previous sample. */
+    uint64_t next_dts;                  /**< Decode timestamp following the
+                                             last written fragment. */
+    uint32_t sequence_number;           /**< Number of the next fragment. */
+
+    uint64_t num_samples;               /**< Samples written to the file. */
+    uint64_t num_fragments;             /**< Fragments written to the file. */
+    bool is_closed;                     /**< Set once close() was called. */
+    bool is_in_error;                   /**< Set if writing the file failed. */
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: Buffer Lifecycle Tracer API</b>
+ *
+ * @b Description: This file declares a tracer that records when buffers
+ * are queued, dequeued and processed, as a Chrome trace.
+ */
+
+#ifndef __NV_TRACER_H__
+#define __NV_TRACER_H__
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ *
+ * @defgroup l4t_mm_nvtracer_group Buffer Lifecycle Tracer API
+ * @ingroup aa_framework_api_group
+ * @{
+ */
+
+/**
+ * @brief Records a timeline of buffer lifecycles across elements.
+ *
+ * Tracing is enabled by naming the trace file in the @c NVMM_TRACE
+ * environment variable before the application starts:
+ * @code
+ * NVMM_TRACE=/tmp/decode.json ./video_decode ...
+ * @endcode
+ * The file is written in the JSON array format of the Chrome trace event
+ * profiler and can be opened in @c chrome://tracing or in the Perfetto UI.
+ * The trailing bracket of the array is optional in that format, so the
+ * trace of an application that did not exit cleanly can still be loaded.
+ *
+ * V4L2 planes record every queue and dequeue with the buffer index and
+ * timestamp, and the time each buffer spends queued in the driver as an
+ * async slice named after the element, plane and index. Dequeue callbacks,
+ * transforms, renderers and JPEG calls are recorded as slices too. Since
+ * the decoders and encoders copy the timestamp of a buffer across planes,
+ * searching the trace for a timestamp follows a frame from the input of a
+ * decoder to the renderer.
+ *
+ * Events are written to a lock-free ring owned by the recording thread and
+ * drained to the file by a background thread, so recording never blocks.
+ * Events recorded while the ring of a thread is full are dropped and
+ * counted. When tracing is disabled, each trace point costs one branch.
+ */
+class NvTracer
+{
+public:
+    /**
+     * Identifies the plane of a V4L2 element an event refers to.
+     */
+    enum Plane
+    {
+        PLANE_NONE,     /**< The event does not refer to a plane. */
+        PLANE_OUTPUT,   /**< Output plane of a V4L2 element. */
+        PLANE_CAPTURE   /**< Capture plane of a V4L2 element. */
+    };
+
+    /**
+     * Returns whether tracing is enabled.
+     */
+    static inline bool isEnabled()
+    {
+        return __builtin_expect(enabled, 0);
+    }
+
+    /**
+     * Returns the current trace time, in nanoseconds.
+     */
+    static inline uint64_t now()
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /**
+     * Records a slice of work done by the calling thread.
+     *
+     * @param[in] name Name of the slice, must be a string literal.
+     * @param[in] owner Name of the element doing the work, copied.
+     * @param[in] plane Plane the work is done on.
+     * @param[in] index Index of the buffer, -1 if none.
+     * @param[in] timestamp_us Timestamp of the buffer in microseconds,
+     *                         -1 if none.
+     * @param[in] start_ns Start of the slice, as returned by now().
+     */
+    static void recordSlice(const char *name, const char *owner, Plane plane,
+            int32_t index, int64_t timestamp_us, uint64_t start_ns);
+
+    /**
+     * Records that a buffer was queued to the driver.
+     *
+     * @param[in] queue Object the buffer is queued on, which tells apart
+     *                  elements with the same name.
+     * @param[in] owner Name of the element, copied.
+     * @param[in] plane Plane the buffer is queued on.
+     * @param[in] index Index of the buffer.
+     * @param[in] timestamp_us Timestamp of the buffer in microseconds.
+     */
+    static void recordQueued(const void *queue, const char *owner, Plane plane,
+            int32_t index, int64_t timestamp_us);
+
+    /**
+     * Records that a buffer was dequeued from the driver.
+     *
+     * @param[in] queue Object the buffer was queued on.
+     * @param[in] owner Name of the element, copied.
+     * @param[in] plane Plane the buffer is dequeued from.
+     * @param[in] index Index of the buffer.
+     * @param[in] timestamp_us Timestamp of the buffer in microseconds.
+     */
+    static void recordDequeued(const void *queue, const char *owner,
+            Plane plane, int32_t index, int64_t timestamp_us);
+
+    /**
+     * Drains the events recorded so far to the trace file.
+     *
+     * Called periodically by the background thread and when the
+     * application exits.
+     */
+    static void flush();
+
+private:
+    static bool enabled; /**< Set when NVMM_TRACE names a file. */
+
+    /**
+     * Opens the trace file and starts the drain thread if NVMM_TRACE is set.
+     *
+     * @return true if tracing is enabled.
+     */
+    static bool init();
+
+    /**
+     * Disallows instantiation, all members are static.
+     */
+    NvTracer();
+};
+
+/**
+ * @brief Records the lifetime of a scope as a trace slice.
+ *
+ * The slice is recorded when the object goes out of scope, with the buffer
+ * set by setBuffer() if any. Nothing is recorded when tracing is disabled
+ * or after discard().
+ */
+class NvTraceScope
+{
+public:
+    /**
+     * Starts a slice.
+     *
+     * @param[in] name Name of the slice, must be a string literal.
+     * @param[in] owner Name of the element doing the work.
+     * @param[in] plane Plane the work is done on.
+     */
+    NvTraceScope(const char *name, const char *owner,
+            NvTracer::Plane plane = NvTracer::PLANE_NONE)
+        : name(name), owner(owner), plane(plane), index(-1), timestamp_us(-1),
+          start_ns(0)
+    {
+        if (NvTracer::isEnabled())
+        {
+            start_ns = NvTracer::now();
+        }
+    }
+
+    /**
+     * Sets the buffer the slice processes.
+     *
+     * @param[in] index Index of the buffer.
+     * @param[in] timestamp_us Timestamp of the buffer in microseconds.
+     */
+    void setBuffer(int32_t index, int64_t timestamp_us)
+    {
+        this->index = index;
+        this->timestamp_us = timestamp_us;
+    }
+
+    /**
+     * Drops the slice, for calls that did no work.
+     */
+    void discard()
+    {
+        start_ns = 0;
+    }
+
+    ~NvTraceScope()
+    {
+        if (NvTracer::isEnabled() && start_ns)
+        {
+            NvTracer::recordSlice(name, owner, plane, index, timestamp_us,
+                    start_ns);
+        }
+    }
+
+private:
+    const char *name;
+    const char *owner;
+    NvTracer::Plane plane;
+    int32_t index;
+    int64_t timestamp_us;
+    uint64_t start_ns;
+
+    NvTraceScope(const NvTraceScope &);
+    void operator=(const NvTraceScope &);
+};
+
+/** @} */
+
+#endif
@@ -47,6 +47,7 @@
 #define __NV_UTILS_H_
 
 #include <fstream>
+#include <sys/types.h>
 #include "NvBuffer.h"
 
 /**
@@ -65,6 +66,25 @@
  */
 int read_video_frame(std::ifstream * stream, NvBuffer & buffer);
 
+/**
+ * @brief Reads a video frame from a file descriptor to the buffer structure.
+ *
+ * This function reads the same data as read_video_frame() with a stream,
+ * using positioned I/O at @a offset. The rows of each plane are gathered
+ * straight into the buffer with \c preadv. If the file was opened with
+ * \c O_DIRECT, the page cache is bypassed instead: each plane is read in
+ * aligned blocks through a staging buffer and then copied to the plane
+ * rows.
+ *
+ * @param[in] fd A file descriptor opened for reading, optionally with
+ *               \c O_DIRECT.
+ * @param[in,out] offset A pointer to the file offset of the frame. It is
+ *                       advanced past the frame on success.
+ * @param[in] buffer A reference to the buffer object into which data is read.
+ * @return 0 if successful, or -1 otherwise.
+ */
+int read_video_frame(int fd, off_t * offset, NvBuffer & buffer);
+
 /**
  * @brief Writes a video frame from the buffer structure to a file.
  *
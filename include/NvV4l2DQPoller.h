@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: V4L2 DQ Poller</b>
+ *
+ * @b Description: This file declares a helper class which dequeues the
+ * buffers of many V4L2 element planes from a single thread.
+ */
+
+#ifndef __NV_V4L2_DQ_POLLER_H__
+#define __NV_V4L2_DQ_POLLER_H__
+
+#include <pthread.h>
+#include <vector>
+
+#include "NvV4l2ElementPlane.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvv4l2dqpoller_group V4L2 DQ Poller
+ * @ingroup l4t_mm_nvelement_group
+ * @{
+ */
+
+/**
+ * @brief Services the DQ callbacks of many planes from one thread.
+ *
+ * Passing a poller to NvV4l2ElementPlane::startDQThread adds the plane to the
+ * poller instead of starting a DQ Thread for it. The poller thread sleeps in
+ * a single @c poll over the device FDs of all its planes, dequeues the ready
+ * buffers and calls the #dqThreadCallback of their plane, as the DQ Thread
+ * does. A plane leaves the poller when its callback returns false, when it
+ * stops streaming, or on NvV4l2ElementPlane::stopDQThread.
+ *
+ * If the device cannot be polled (see NvV4l2DeviceOps::poll), the poller
+ * thread sleeps in the DevicePoll control of the device instead, so all the
+ * planes of such a poller must belong to the same element.
+ *
+ * The callbacks of all the planes run on the poller thread, so they must not
+ * block. The elements must be opened in non-blocking mode and share the same
+ * device entry points.
+ */
+class NvV4l2DQPoller
+{
+public:
+    /**
+     * Creates a new poller and starts its thread.
+     *
+     * @param[in] name A pointer to the name of the poller thread.
+     * @return A pointer to the poller, or NULL on failure.
+     */
+    static NvV4l2DQPoller *createDQPoller(const char *name);
+
+    /**
+     * Stops the poller thread.
+     *
+     * The planes still in the poller are marked as stopped.
+     */
+    ~NvV4l2DQPoller();
+
+    /**
+     * Gets the number of planes serviced by the poller.
+     */
+    uint32_t getNumPlanes();
+
+private:
+    /**
+     * Adds a plane to the poller.
+     *
+     * @return 0 for success, -1 otherwise.
+     */
+    int addPlane(NvV4l2ElementPlane *plane);
+
+    /**
+     * Removes a plane from the poller.
+     *
+     * Waits for the callback of the plane to return if it is running on
+     * another thread.
+     */
+    void removePlane(NvV4l2ElementPlane *plane);
+
+    /**
+     * Wakes up the poller thread so that it checks its planes again.
+     */
+    void wake();
+
+    /**
+     * Dequeues the ready buffers of a plane and calls its callback.
+     *
+     * @return false if the plane must leave the poller.
+     */
+    static bool servicePlane(NvV4l2ElementPlane *plane);
+
+    /**
+     * The poller thread method.
+     */
+    static void *pollThread(void *poller);
+
+    const char *name; /**< Name of the poller thread. */
+    pthread_mutex_t lock; /**< Protects the plane list. */
+    pthread_cond_t cond; /**< Signaled when a callback returns. */
+    pthread_t thread; /**< Poller thread. */
+    int wake_fd; /**< eventfd waking the poller thread when the planes change. */
+    bool stop; /**< Set to stop the poller thread. */
+
+    std::vector<NvV4l2ElementPlane *> planes; /**< Planes serviced by the poller. */
+    NvV4l2ElementPlane *dispatching; /**< Plane whose callback is running. */
+    const NvV4l2DeviceOps *dev_ops; /**< Device entry points shared by the planes. */
+
+    /**
+     * Constructor for NvV4l2DQPoller.
+     */
+    NvV4l2DQPoller(const char *name);
+
+    /**
+     * Disallows copy constructor.
+     */
+    NvV4l2DQPoller(const NvV4l2DQPoller& that);
+    /**
+     * Disallows assignment.
+     */
+    void operator=(NvV4l2DQPoller const&);
+
+    friend class NvV4l2ElementPlane;
+};
+/** @} */
+#endif
@@ -83,7 +83,10 @@ public:
      *
      * Calls \c VIDIOC_DQEVENT IOCTL internally. The caller can specify the maximum time
      * to wait for dequeuing the event. The call blocks until an event is
-     * dequeued successfully or timeout is reached.
+     * dequeued successfully or timeout is reached. While waiting, the call
+     * sleeps in @c poll on the device FD for \c POLLPRI, or in the DevicePoll
+     * control if the device cannot be polled, and can be woken up with
+     * #interruptWait.
      *
      * @param[in,out] event A reference to the \c v4l2_event structure to fill.
      * @param[in] max_wait_ms Specifies the max wait time for dequeuing an event,
@@ -92,6 +95,14 @@ public:
      */
     int dqEvent(struct v4l2_event &event, uint32_t max_wait_ms);
 
+    /**
+     * Interrupts a #dqEvent call waiting for an event.
+     *
+     * If no wait is in progress, the next wait returns immediately. Waits on
+     * the planes are interrupted with NvV4l2ElementPlane::interruptWait.
+     */
+    void interruptWait();
+
     /**
      * Sets the value of a control.
      *
@@ -175,8 +186,49 @@ public:
      */
     void enableProfiling();
 
+    /**
+     * Sets the device entry points used by the elements created afterwards.
+     *
+     * Elements already created keep the entry points they were opened with.
+     *
+     * @param[in] ops A pointer to the entry points, or NULL to restore libv4l2.
+     */
+    static void setDeviceOps(const NvV4l2DeviceOps *ops);
+
+    /**
+     * Checks whether the device FD of the element can be polled.
+     *
+     * Elements which cannot be polled (see NvV4l2DeviceOps::poll) can only
+     * wait for their device in the DevicePoll control, one device at a time.
+     *
+     * @return true if #pollElements can wait for the element.
+     */
+    bool isPollable();
+
+    /**
+     * Waits until any of several elements has a buffer or an event to
+     * dequeue.
+     *
+     * Sleeps in a single @c poll over the device FDs of the elements, for
+     * \c POLLPRI, and for the planes streaming with buffers queued. This lets
+     * one thread drive many elements opened in non-blocking mode.
+     *
+     * @param[in] elements A pointer to the array of elements. They must share
+     *                     the same device entry points, which can poll.
+     * @param[in] num_elements Number of elements in @a elements.
+     * @param[out] ready A pointer to an array of @a num_elements flags, set
+     *                   for the elements with something to dequeue.
+     * @param[in] max_wait_ms Maximum time to wait in milliseconds, -1 to wait
+     *                        forever.
+     * @return The number of ready elements, 0 on timeout, -1 on error.
+     */
+    static int pollElements(NvV4l2Element **elements, uint32_t num_elements,
+                            bool *ready, int max_wait_ms);
+
 protected:
     int fd;         /**< Specifies the FD of the device opened using \c v4l2_open. */
+    const NvV4l2DeviceOps *dev_ops; /**< Entry points used to access the device. */
+    int event_abort_fd; /**< eventfd signaled by #interruptWait. */
 
     uint32_t output_plane_pixfmt;  /**< Pixel format of output plane buffers */
     uint32_t capture_plane_pixfmt; /**< Pixel format of capture plane buffers */
@@ -48,10 +48,41 @@
 #define __NV_V4L2_ELELMENT_PLANE_H__
 
 #include <pthread.h>
+#include <poll.h>
 #include "NvElement.h"
 #include "NvLogging.h"
 #include "NvBuffer.h"
 
+/**
+ * Holds the entry points used to access a V4L2 device.
+ *
+ * NvV4l2Element and NvV4l2ElementPlane issue all the device calls through
+ * this table. By default it points to the libv4l2 functions; an in-process
+ * implementation such as NvV4l2MockDevice can be installed with
+ * NvV4l2Element::setDeviceOps() to run pipelines without the hardware.
+ */
+typedef struct
+{
+    /** Opens the device node, as %v4l2_open. */
+    int (*open)(const char *dev_node, int flags);
+    /** Closes the device, as %v4l2_close. */
+    int (*close)(int fd);
+    /** Issues an IOCTL on the device, as %v4l2_ioctl. */
+    int (*ioctl)(int fd, unsigned long int request, void *arg);
+    /**
+     * Waits for device or other FDs to become ready, as %poll.
+     *
+     * NULL if the device FDs do not report readiness through %poll, which
+     * is the case of the Tegra libv4l2 plugin. Waits on such devices sleep
+     * in the \c V4L2_CID_MPEG_VIDEO_DEVICE_POLL control instead, and are
+     * woken up with \c V4L2_CID_MPEG_SET_POLL_INTERRUPT, as
+     * NvVideoDecoder::DevicePoll() and NvVideoDecoder::ClearPollInterrupt().
+     */
+    int (*poll)(struct pollfd *fds, nfds_t nfds, int timeout_ms);
+} NvV4l2DeviceOps;
+
+class NvV4l2DQPoller;
+
 /**
  * Prints a plane-specific message of level LOG_LEVEL_DEBUG.
  * Must not be used by applications.
@@ -98,7 +129,14 @@
  * #startDQThread, it internally spawns a thread that runs infinitely until
  * signaled to stop. This thread keeps trying to dequeue a buffer from the
  * plane and calls a #dqThreadCallback method specified by the user on
- * successful dequeue.
+ * successful dequeue. Alternatively, the plane can be serviced by a
+ * NvV4l2DQPoller, which dequeues the buffers of many planes from a single
+ * thread.
+ *
+ * In non-blocking mode, the DQ Thread and #waitForBuffer sleep in @c poll on
+ * the device FD until a buffer is ready, instead of retrying the dequeue.
+ * For devices that cannot be polled (see NvV4l2DeviceOps::poll), they sleep
+ * in the DevicePoll control of the device instead.
  *
  */
 class NvV4l2ElementPlane
@@ -300,6 +338,22 @@ public:
      */
     int dqBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer ** buffer,
                  NvBuffer ** shared_buffer, uint32_t num_retries);
+    /**
+     * Dequeues a buffer from the plane into a handle.
+     *
+     * Same as dqBuffer(struct v4l2_buffer &, NvBuffer **, NvBuffer **, uint32_t),
+     * except that the buffer is returned in an \c NvBufferRef. On a capture
+     * plane, the buffer is queued back to the plane once the handle and all
+     * the handles shared from it are released.
+     *
+     * @param[in] v4l2_buf A reference to the \c v4l2_buffer structure to use for dequeueing.
+     * @param[out] buffer Handle to the dequeued buffer, emptied on failure.
+     * @param[in] num_retries Number of times to try dequeuing a buffer before
+     *                        a failure is returned.
+     * @return 0 for success, -1 otherwise.
+     */
+    int dqBuffer(struct v4l2_buffer &v4l2_buf, NvBufferRef &buffer,
+                 uint32_t num_retries);
     /**
      * Queues a buffer on the plane.
      *
@@ -307,6 +361,9 @@ public:
      * buffer with other elements, the application can pass the pointer to the
      * shared NvBuffer object in \a shared_buffer.
      *
+     * Queuing a buffer that is already queued fails without reaching the
+     * driver and leaves the plane usable.
+     *
      * @param[in] v4l2_buf A reference to the \c v4l2_buffer structure to use for queueing.
      * @param[in] shared_buffer A pointer to the shared \c %NvBuffer object.
      * @return 0 for success, -1 otherwise.
@@ -401,6 +458,31 @@ public:
      */
     int waitAllBuffersDequeued(uint32_t max_wait_ms);
 
+    /**
+     * Waits until a buffer can be dequeued from the plane.
+     *
+     * Polls the device FD for \c POLLIN on the capture plane or \c POLLOUT
+     * on the output plane. The wait ends early if #interruptWait is called.
+     * If the device cannot be polled, the wait goes through the DevicePoll
+     * control. It may then return 0 without a buffer being ready, when a
+     * wait for another plane or for events of the device is interrupted, and
+     * the dequeue fails with \c EAGAIN.
+     *
+     * @param[in] max_wait_ms Maximum wait time, in milliseconds, or -1 to
+     *                        wait indefinitely.
+     * @return 0 if a buffer is ready, -1 otherwise with errno set to \c EAGAIN
+     *         on timeout, \c ECANCELED if interrupted or \c EPIPE if the
+     *         plane is not streaming.
+     */
+    int waitForBuffer(int max_wait_ms);
+    /**
+     * Interrupts #waitForBuffer.
+     *
+     * If no wait is in progress, the next wait returns immediately.
+     * Stopping the stream also interrupts the DQ Thread.
+     */
+    void interruptWait();
+
     /**
      * This is a callback function type method that is called by the DQ Thread when
      * it successfully dequeues a buffer from the plane. Applications must implement
@@ -444,15 +526,20 @@ public:
      *
      * @sa stopDQThread, waitForDQThread
      *
+     * If @a poller is not NULL, the plane is added to the poller instead of
+     * starting a thread. The device must be opened in non-blocking mode.
+     *
      * @param[in] data A pointer to the application data. This is provided as an
      *                 argument in the \c dqThreadCallback method.
+     * @param[in] poller A pointer to the poller servicing the plane, or NULL.
      * @return 0 for success, -1 otherwise.
      */
-    int startDQThread(void *data);
+    int startDQThread(void *data, NvV4l2DQPoller *poller = NULL);
     /**
      * Force stops the DQ Thread if it is running.
      *
-     * Does not work when the device is opened in blocking mode.
+     * Does not work when the device is opened in blocking mode, unless the
+     * plane is serviced by a NvV4l2DQPoller.
      *
      * @sa startDQThread, waitForDQThread
      *
@@ -478,6 +565,8 @@ public:
 
 private:
     int &fd;     /**< A reference to the FD of the V4l2 Element the plane is associated with. */
+    const NvV4l2DeviceOps *&dev_ops; /**< A reference to the device entry points
+                                          of the V4l2 Element. */
 
     const char *plane_name; /**< A pointer to the name of the plane. Could be "Output Plane" or
                                  "Capture Plane". Used only for debug logs. */
@@ -513,6 +602,9 @@ private:
     bool stop_dqthread; /**< Specifies the value used to signal the DQ Thread to stop. */
 
     pthread_t dq_thread; /**< Speciifes the pthread ID of the DQ Thread. */
+    NvV4l2DQPoller *dq_poller; /**< Poller servicing the plane instead of the DQ Thread. */
+
+    int wait_abort_fd; /**< eventfd signaled by #interruptWait. */
 
     dqThreadCallback callback; /**< Specifies the callback method used by the DQ Thread. */
 
@@ -532,6 +624,37 @@ private:
      */
     static void *dqThread(void *v4l2_element_plane);
 
+    /**
+     * Marks the DQ Thread, or the poller servicing the plane, as stopped.
+     */
+    void setDQThreadStopped();
+
+    /**
+     * Polls a device FD until it is ready for @a events.
+     *
+     * @param[in] ops Entry points of the device.
+     * @param[in] fd FD of the device.
+     * @param[in] abort_fd eventfd which interrupts the wait when signaled.
+     * @param[in] events Poll events to wait for.
+     * @param[in] max_wait_ms Maximum wait time, in milliseconds, or -1.
+     * @return 0 if ready, -1 otherwise with errno set as in #waitForBuffer.
+     *         If @a ops cannot poll, 0 may also be returned when another
+     *         wait on the device is interrupted, and the caller retries.
+     */
+    static int waitForDevice(const NvV4l2DeviceOps *ops, int fd, int abort_fd,
+            short events, int max_wait_ms);
+
+    /**
+     * Interrupts the waits of #waitForDevice using an interrupt FD.
+     *
+     * Signals @a abort_fd, and also clears the poll interrupt of the devices
+     * whose DevicePoll control the waits are sleeping in.
+     *
+     * @param[in] abort_fd eventfd passed to #waitForDevice.
+     * @return 0 for success, -1 otherwise.
+     */
+    static int interruptDeviceWait(int abort_fd);
+
     NvElementProfiler &v4l2elem_profiler; /**< A reference to the profiler belonging
                                             to the plane's parent element. */
 
@@ -553,11 +676,13 @@ private:
      * @param[in] buf_type Type of the stream.
      * @param[in] device_name A pointer to the name of the element the plane belongs to.
      * @param[in] fd A reference to the FD of the device opened using v4l2_open.
+     * @param[in] dev_ops A reference to the entry points of the device.
      * @param[in] blocking A flag that indicates whether the device has been opened with blocking mode.
      * @param[in] profiler The profiler.
      */
     NvV4l2ElementPlane(enum v4l2_buf_type buf_type, const char *device_name,
-                     int &fd, bool blocking, NvElementProfiler &profiler);
+                     int &fd, const NvV4l2DeviceOps *&dev_ops, bool blocking,
+                     NvElementProfiler &profiler);
 
     /**
      * Disallows copy constructor.
@@ -581,6 +706,7 @@ private:
                                for debugging. */
 
     friend class NvV4l2Element;
+    friend class NvV4l2DQPoller;
 };
 /** @} */
 #endif
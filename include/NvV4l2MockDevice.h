@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * <b>NVIDIA Multimedia API: V4L2 Mock Device</b>
+ *
+ * @b Description: This file declares an in-process loopback implementation
+ * of a V4L2 M2M device.
+ */
+
+#ifndef __NV_V4L2_MOCK_DEVICE_H__
+#define __NV_V4L2_MOCK_DEVICE_H__
+
+#include <stdint.h>
+
+#include "NvV4l2ElementPlane.h"
+
+/**
+ *
+ * @defgroup l4t_mm_nvv4l2mockdevice_group V4L2 Mock Device
+ * @ingroup l4t_mm_nvelement_group
+ * @{
+ */
+
+/**
+ * @brief Loopback V4L2 M2M device which runs without the hardware.
+ *
+ * Install it with
+ * @code
+ * NvV4l2Element::setDeviceOps(NvV4l2MockDevice::getDeviceOps());
+ * @endcode
+ * before creating the elements. Every element then opens its own mock
+ * device instead of the @c /dev node, so that buffer management, the DQ
+ * threads and the plane setup of NvV4l2Element pipelines can be exercised
+ * and benchmarked on any Linux machine.
+ *
+ * The device supports @c VIDIOC_REQBUFS, @c VIDIOC_QUERYBUF,
+ * @c VIDIOC_EXPBUF, @c VIDIOC_QBUF, @c VIDIOC_DQBUF, @c VIDIOC_STREAMON,
+ * @c VIDIOC_STREAMOFF, events, formats and controls. MMAP buffers are backed
+ * by anonymous memory files, so that NvBuffer::map() works unchanged.
+ *
+ * Each output plane buffer is paired with the next queued capture plane
+ * buffer and both are returned after the processing delay. The payload of
+ * the output buffer is copied to the capture buffer when both are
+ * accessible to the CPU; an empty output buffer produces an empty capture
+ * buffer flagged with @c V4L2_BUF_FLAG_LAST and a @c V4L2_EVENT_EOS event.
+ * Once it has been dequeued, @c VIDIOC_DQBUF on the capture plane fails
+ * with @c EAGAIN and sets @c V4L2_BUF_FLAG_LAST, as the Tegra codecs do.
+ * As a decoder would, the device returns the first output buffer without
+ * output and raises a resolution change event while the capture plane is
+ * not streaming, then waits for the capture plane.
+ *
+ * The device FD is an @c eventfd which is readable while a buffer or an
+ * event can be dequeued. The @c poll entry point of the mock reports
+ * \c POLLIN, \c POLLOUT and \c POLLPRI for the capture plane, the output
+ * plane and the events, as a V4L2 M2M device does.
+ *
+ * As the Tegra decoder does, the device also implements the
+ * \c V4L2_CID_MPEG_VIDEO_DEVICE_POLL control used by
+ * NvVideoDecoder::DevicePoll(), which blocks until a buffer or an event can
+ * be dequeued. NvVideoDecoder::SetPollInterrupt() arms the wait and
+ * NvVideoDecoder::ClearPollInterrupt() wakes it up; polls then return
+ * immediately until the interrupt is set again.
+ */
+class NvV4l2MockDevice
+{
+public:
+    /**
+     * Gets the entry points of the mock device.
+     *
+     * @param[in] pollable Whether the entry points include @c poll. Without it
+     *                     the elements wait in the DevicePoll control, as
+     *                     with libv4l2 on Tegra.
+     * @return A pointer to the entry points, to pass to NvV4l2Element::setDeviceOps().
+     */
+    static const NvV4l2DeviceOps *getDeviceOps(bool pollable = true);
+
+    /**
+     * Sets the time taken to process one buffer, for the devices opened afterwards.
+     *
+     * @param[in] delay_usec Processing delay, in microseconds. Defaults to 0.
+     */
+    static void setProcessingDelay(uint32_t delay_usec);
+
+    /**
+     * Sets the number of buffers processed concurrently, for the devices
+     * opened afterwards.
+     *
+     * The throughput of the device is @a capacity buffers per processing delay.
+     *
+     * @param[in] capacity Number of buffers, at least 1. Defaults to 1.
+     */
+    static void setCapacity(uint32_t capacity);
+
+    /**
+     * Sets the default capture plane resolution, for the devices opened
+     * afterwards.
+     *
+     * @param[in] width Width, in pixels. Defaults to 1920.
+     * @param[in] height Height, in pixels. Defaults to 1080.
+     */
+    static void setResolution(uint32_t width, uint32_t height);
+
+private:
+    /**
+     * Disallows instantiation.
+     */
+    NvV4l2MockDevice();
+};
+/** @} */
+#endif
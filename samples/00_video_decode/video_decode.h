@@ -27,12 +27,16 @@
  */
 
 #include "NvVideoDecoder.h"
+#include "NvV4l2DQPoller.h"
 #include "NvVideoConverter.h"
 #include "NvEglRenderer.h"
+#include "NvBitstreamReader.h"
+#include "NvMjpegReader.h"
+#include "NvIvfReader.h"
+#include "NvContainerReader.h"
 #include <queue>
 #include <fstream>
 #include <pthread.h>
-#include <semaphore.h>
 
 #include "NvBufSurface.h"
 
@@ -48,6 +52,10 @@ typedef struct
 
     char **in_file_path;
     std::ifstream **in_file;
+    NvBitstreamReader **bs_reader;
+    NvMjpegReader **mjpeg_reader;
+    NvIvfReader **ivf_reader;
+    NvContainerReader **container_reader;
 
     char *out_file_path;
     std::ofstream *out_file;
@@ -69,6 +77,8 @@ typedef struct
     bool disable_dpb;
 
     bool input_nalu;
+    bool input_au;
+    bool input_container;
 
     bool copy_timestamp;
     bool flag_copyts;
@@ -92,19 +102,19 @@ typedef struct
     pthread_mutex_t queue_lock;
     pthread_cond_t queue_cond;
 
-    sem_t pollthread_sema; // Polling thread waits on this to be signalled to issue Poll
-    sem_t decoderthread_sema; // Decoder thread waits on this to be signalled to continue q/dq loop
-    pthread_t   dec_pollthread; // Polling thread, created if running in non-blocking mode.
+    NvV4l2DQPoller *dq_poller; // Dequeues both decoder planes, created if running in non-blocking mode.
+    uint32_t current_file; // File read by the output plane callback, in non-blocking mode.
+    int current_loop; // Loop count of the output plane callback, in non-blocking mode.
+    bool input_eos; // Set once the empty buffer has been queued, in non-blocking mode.
 
     pthread_t dec_capture_loop; // Decoder capture thread, created if running in blocking mode.
     bool got_error;
     bool got_eos;
-    bool vp9_file_header_flag;
-    bool vp8_file_header_flag;
     int dst_dma_fd;
     int dmabuff_fd[MAX_BUFFERS];
     int numCapBuffers;
     int loop_count;
+    uint64_t start_frame;
     int max_perf;
     int extra_cap_plane_buffer;
     int blocking_mode; // Set to true if running in blocking mode
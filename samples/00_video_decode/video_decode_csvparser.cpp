@@ -71,6 +71,7 @@ print_help(void)
             "\t-ww <width>          Window width in pixels [Default = video-width]\n"
             "\t-wh <height>         Window height in pixels [Default = video-height]\n"
             "\t-loop <count>        Playback in a loop.[count = 1,2,...,n times looping , 0 = infinite looping]\n"
+            "\t--start-frame <n>    Start at the key frame at or before frame n (for VP8/VP9/AV1 and input-container)\n"
             "\t-queue [<file1> <file2> ....] Files are played in a queue manner\n"
             "\tNOTE: -queue should be the last option mentioned in the command line no other option should be mentioned after that.\n"
             "\t-wx <x-offset>       Horizontal window offset [Default = 0]\n"
@@ -85,7 +86,9 @@ print_help(void)
             "\t1 = Skip non-reference frames\n"
             "\t2 = Decode only key frames\n\n"
             "\t--input-nalu         Input to the decoder will be nal units\n"
-            "\t--input-chunks       Input to the decoder will be a chunk of bytes [Default]\n\n"
+            "\t--input-au           Input to the decoder will be access units (for H264/H265)\n"
+            "\t--input-chunks       Input to the decoder will be a chunk of bytes [Default]\n"
+            "\t--input-container    Input file is MP4 or Matroska, the decoder gets its samples with their timestamps\n\n"
             "\t--copy-timestamp <st> <fps> Enable copy timestamp with start timestamp(st) in seconds for decode fps(fps) (for input-nalu mode)\n"
             "\tNOTE: copy-timestamp used to demonstrate how timestamp can be associated with an individual H264/H265 frame to achieve video-synchronization.\n"
             "\t      currenly only supported for H264 & H265 video encode using MM APIs and is only for demonstration purpose.\n"
@@ -231,10 +234,26 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
         else if (!strcmp(arg, "--input-nalu"))
         {
             ctx->input_nalu = true;
+            ctx->input_au = false;
+            ctx->input_container = false;
+        }
+        else if (!strcmp(arg, "--input-au"))
+        {
+            ctx->input_nalu = true;
+            ctx->input_au = true;
+            ctx->input_container = false;
         }
         else if (!strcmp(arg, "--input-chunks"))
         {
             ctx->input_nalu = false;
+            ctx->input_au = false;
+            ctx->input_container = false;
+        }
+        else if (!strcmp(arg, "--input-container"))
+        {
+            ctx->input_nalu = false;
+            ctx->input_au = false;
+            ctx->input_container = true;
         }
         else if (!strcmp(arg, "--copy-timestamp"))
         {
@@ -314,6 +333,12 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
             CHECK_OPTION_VALUE(argp);
             ctx->loop_count = atoi(*argp);
         }
+        else if (!strcmp(arg, "--start-frame"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->start_frame = strtoull(*argp, NULL, 10);
+        }
         else if (!strcmp(arg, "-queue"))
         {
             ctx->bQueue = true;
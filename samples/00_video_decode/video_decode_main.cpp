@@ -58,94 +58,66 @@
 #define IS_NAL_UNIT_START1(buffer_ptr) (!buffer_ptr[0] && !buffer_ptr[1] && \
         (buffer_ptr[2] == 1))
 
-#define H264_NAL_UNIT_CODED_SLICE  1
-#define H264_NAL_UNIT_CODED_SLICE_IDR  5
-
 #define HEVC_NUT_TRAIL_N  0
 #define HEVC_NUT_RASL_R  9
 #define HEVC_NUT_BLA_W_LP  16
 #define HEVC_NUT_CRA_NUT  21
 
-#define IVF_FILE_HDR_SIZE   32
-#define IVF_FRAME_HDR_SIZE  12
-
-#define IS_H264_NAL_CODED_SLICE(buffer_ptr) ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE)
-#define IS_H264_NAL_CODED_SLICE_IDR(buffer_ptr) ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE_IDR)
-
-#define IS_MJPEG_START(buffer_ptr) (buffer_ptr[0] == 0xFF && buffer_ptr[1] == 0xD8)
-#define IS_MJPEG_END(buffer_ptr) (buffer_ptr[0] == 0xFF && buffer_ptr[1] == 0xD9)
-
-#define GET_H265_NAL_UNIT_TYPE(buffer_ptr) ((buffer_ptr[0] & 0x7E) >> 1)
 #define NAMELEN 16
 using namespace std;
 
 /**
-  * Read the input NAL unit for h264/H265/Mpeg2/Mpeg4 decoder.
+  * Read the input NAL unit for h264/H265/Mpeg2/Mpeg4 decoder, or the whole
+  * access unit for h264/H265 if access unit input is enabled.
   *
-  * @param stream            : Input stream
-  * @param buffer            : NvBuffer pointer
-  * @param parse_buffer      : parse buffer pointer
-  * @param parse_buffer_size : chunk size
-  * @param ctx               : Decoder context
+  * @param reader : Bitstream reader of the input file
+  * @param buffer : NvBuffer pointer
+  * @param ctx    : Decoder context
   */
-bool tesetoutOrNot=true;
 static int
-read_decoder_input_nalu(ifstream * stream, NvBuffer * buffer,
-        char *parse_buffer, streamsize parse_buffer_size, context_t * ctx)
+read_decoder_input_nalu(NvBitstreamReader * reader, NvBuffer * buffer,
+        context_t * ctx)
 {
-    /* Length is the size of the buffer in bytes. */
-    char *buffer_ptr = (char *) buffer->planes[0].data;
+    const NvBitstreamReader::NvNalUnit *nalu;
+    const uint8_t *nal_header;
     int h265_nal_unit_type;
-    char *stream_ptr;
-    bool nalu_found = false;
-
-    streamsize bytes_read;
-    streamsize stream_initial_pos = stream->tellg();
-
-    stream->read(parse_buffer, parse_buffer_size);
-    bytes_read = stream->gcount();
+    int ret;
 
-    if (bytes_read == 0)
+    /* Copy the next indexed NAL unit or access unit, start codes included,
+       in one go. */
+    if (ctx->input_au)
     {
-        return buffer->planes[0].bytesused = 0;
+        ret = reader->readNextAccessUnit(buffer, ctx->decoder_pixfmt, &nalu);
+        /* An access unit larger than the buffer is queued one NAL unit at
+           a time instead, as in NAL unit input mode. */
+        if (ret < 0)
+            ret = reader->readNextNalUnit(buffer, &nalu);
     }
-
-    /* Find the first NAL unit in the buffer. */
-    stream_ptr = parse_buffer;
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
+    else
+        ret = reader->readNextNalUnit(buffer, &nalu);
+    if (ret < 0)
     {
-        nalu_found = IS_NAL_UNIT_START(stream_ptr) ||
-                    IS_NAL_UNIT_START1(stream_ptr);
-        if (nalu_found)
-        {
-            break;
-        }
-        stream_ptr++;
+        cerr << "Could not read nal unit from file. File corrupted" << endl;
+        return -1;
     }
 
-    /* Reached end of buffer but could not find NAL unit. */
-    if (!nalu_found)
+    if (!nalu)
     {
-        cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-        return -1;
+        /* End of stream, bytesused is 0 and the reader is rewound. */
+        return 0;
     }
 
-    memcpy(buffer_ptr, stream_ptr, 4);
-    buffer_ptr += 4;
-    buffer->planes[0].bytesused = 4;
-    stream_ptr += 4;
-
+    nal_header = &nalu->header;
     if (ctx->copy_timestamp)
     {
       if (ctx->decoder_pixfmt == V4L2_PIX_FMT_H264) {
-        if ((IS_H264_NAL_CODED_SLICE(stream_ptr)) ||
-            (IS_H264_NAL_CODED_SLICE_IDR(stream_ptr)))
+        if ((IS_H264_NAL_CODED_SLICE(nal_header)) ||
+            (IS_H264_NAL_CODED_SLICE_IDR(nal_header)))
           ctx->flag_copyts = true;
         else
           ctx->flag_copyts = false;
       } else if (ctx->decoder_pixfmt == V4L2_PIX_FMT_H265) {
-        h265_nal_unit_type = GET_H265_NAL_UNIT_TYPE(stream_ptr);
+        h265_nal_unit_type = GET_H265_NAL_UNIT_TYPE(nal_header);
         if ((h265_nal_unit_type >= HEVC_NUT_TRAIL_N && h265_nal_unit_type <= HEVC_NUT_RASL_R) ||
             (h265_nal_unit_type >= HEVC_NUT_BLA_W_LP && h265_nal_unit_type <= HEVC_NUT_CRA_NUT))
           ctx->flag_copyts = true;
@@ -154,38 +126,7 @@ read_decoder_input_nalu(ifstream * stream, NvBuffer * buffer,
       }
     }
 
-    /* Copy bytes till the next NAL unit is found. */
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
-    {
-        if (IS_NAL_UNIT_START(stream_ptr) || IS_NAL_UNIT_START1(stream_ptr))
-        {
-            streamsize seekto = stream_initial_pos +
-                    (stream_ptr - parse_buffer);
-            if(stream->eof())
-            {
-                stream->clear();
-            }
-            stream->seekg(seekto, stream->beg);
-            return 0;
-        }
-        *buffer_ptr = *stream_ptr;
-        buffer_ptr++;
-        stream_ptr++;
-        buffer->planes[0].bytesused++;
-    }
-    // {
-    //     if(tesetoutOrNot){
-    //         ofstream testout;
-    //         testout.open("/dev/shm/xxxx",ios::out|ios::binary);
-    //         testout.write(buffer_ptr,buffer->planes[0].bytesused);
-    //         // testout<<buffer_ptr;
-    //         tesetoutOrNot=false;
-    //     }
-    // }
-    /* Reached end of buffer but could not find NAL unit. */
-    cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-    return -1;
+    return 0;
 }
 
 /**
@@ -222,86 +163,73 @@ read_decoder_input_chunk(ifstream * stream, NvBuffer * buffer)
 }
 
 /**
-  * Read the input chunks for MJPEG decoder.
+  * Read the next JPEG image for MJPEG decoder.
   *
-  * @param stream : Input filestream
+  * @param reader : MJPEG reader of the input file
   * @param buffer : NvBuffer pointer
   */
 static int
-read_mjpeg_decoder_input(ifstream * stream, NvBuffer * buffer)
+read_mjpeg_decoder_input(NvMjpegReader * reader, NvBuffer * buffer)
 {
-    char *buffer_ptr = (char *)buffer->planes[0].data;
-    stream->read(buffer_ptr,2);
-            buffer->planes[0].bytesused += stream->gcount();
-    if (IS_MJPEG_START(buffer_ptr))
+    /* Copy the next indexed image, SOI to EOI, in one go. On end of
+       stream bytesused is 0 and the reader is rewound. */
+    if (reader->readNextFrame(buffer) < 0)
     {
-        while (!IS_MJPEG_END(buffer_ptr))
-        {
-            buffer_ptr+=2;
-            stream->read(buffer_ptr,2);
-            buffer->planes[0].bytesused += stream->gcount();
-        }
-    }
-
-    if(buffer->planes[0].bytesused == 0)
-    {
-        stream->clear();
-        stream->seekg(0,stream->beg);
+        cerr << "Could not read jpeg image from file. File corrupted" << endl;
+        return -1;
     }
-
     return 0;
 }
 
 /**
-  * Read the input chunks for Vp8/Vp9/AV1 decoder.
+  * Read the next frame for Vp8/Vp9/AV1 decoder.
   *
-  * @param ctx    : Decoder context
+  * @param reader : IVF reader of the input file
   * @param buffer : NvBuffer pointer
   */
 static int
-read_vpx_decoder_input_chunk(context_t *ctx, NvBuffer * buffer)
+read_vpx_decoder_input_chunk(NvIvfReader * reader, NvBuffer * buffer)
 {
-    ifstream *stream = ctx->in_file[0];
-    int Framesize;
-    unsigned char *bitstreambuffer = (unsigned char *)buffer->planes[0].data;
-    if (ctx->vp9_file_header_flag == 0)
+    /* Copy the next indexed frame, without its IVF frame header, in one
+       go. On end of stream bytesused is 0 and the reader is rewound. */
+    if (reader->readNextFrame(buffer) < 0)
     {
-        stream->read((char *) buffer->planes[0].data, IVF_FILE_HDR_SIZE);
-        if (stream->gcount() !=  IVF_FILE_HDR_SIZE)
-        {
-            cerr << "Couldn't read IVF FILE HEADER" << endl;
-            return -1;
-        }
-        if (!((bitstreambuffer[0] == 'D') && (bitstreambuffer[1] == 'K') &&
-                    (bitstreambuffer[2] == 'I') && (bitstreambuffer[3] == 'F')))
-        {
-            cerr << "It's not a valid IVF file \n" << endl;
-            return -1;
-        }
-        cout << "It's a valid IVF file" << endl;
-        ctx->vp9_file_header_flag = 1;
+        cerr << "Could not read IVF frame from file. File corrupted" << endl;
+        return -1;
     }
-    stream->read((char *) buffer->planes[0].data, IVF_FRAME_HDR_SIZE);
+    return 0;
+}
 
-    if (!stream->gcount())
-    {
-        cout << "End of stream" << endl;
-        return 0;
-    }
+/**
+  * Read the next sample of an MP4 or Matroska file.
+  *
+  * @param reader   : Container reader of the input file
+  * @param buffer   : NvBuffer pointer
+  * @param v4l2_buf : V4L2 buffer to carry the sample timestamp
+  */
+static int
+read_decoder_input_sample(NvContainerReader * reader, NvBuffer * buffer,
+        struct v4l2_buffer * v4l2_buf)
+{
+    const NvContainerReader::NvContainerSample *sample;
+    uint64_t pts;
 
-    if (stream->gcount() != IVF_FRAME_HDR_SIZE)
+    /* Copy the next indexed sample in one go, with start codes written
+       over the NAL unit lengths. On end of stream bytesused is 0 and the
+       reader is rewound. */
+    if (reader->readNextSample(buffer, &sample) < 0)
     {
-        cerr << "Couldn't read IVF FRAME HEADER" << endl;
+        cerr << "Could not read sample from file. File corrupted" << endl;
         return -1;
     }
-    Framesize = (bitstreambuffer[3]<<24) + (bitstreambuffer[2]<<16) +
-        (bitstreambuffer[1]<<8) + bitstreambuffer[0];
-    buffer->planes[0].bytesused = Framesize;
-    stream->read((char *) buffer->planes[0].data, Framesize);
-    if (stream->gcount() != Framesize)
+
+    if (sample)
     {
-        cerr << "Couldn't read Framesize" << endl;
-        return -1;
+        /* Samples cut by an edit list may come before time 0. */
+        pts = sample->pts > 0 ? sample->pts : 0;
+        v4l2_buf->flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+        v4l2_buf->timestamp.tv_sec = pts / (MICROSECOND_UNIT);
+        v4l2_buf->timestamp.tv_usec = pts % (MICROSECOND_UNIT);
     }
     return 0;
 }
@@ -699,47 +627,270 @@ error:
 }
 
 /**
-  * Decoder polling thread loop function.
+  * Callback called by the DQ poller when a decoder output plane buffer
+  * is dequeued, in non-blocking mode. Reads the next input chunk into
+  * the buffer and queues it again.
   *
-  * @param args : void arguments
+  * @param v4l2_buf      : dequeued V4L2 buffer, NULL on error
+  * @param buffer        : dequeued NvBuffer
+  * @param shared_buffer : unused
+  * @param arg           : Decoder context
   */
-static void *decoder_pollthread_fcn(void *arg)
+static bool
+dec_output_plane_cb(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+                    NvBuffer *shared_buffer, void *arg)
 {
+    context_t *ctx = (context_t *) arg;
+    int ret;
+
+    if (!v4l2_buf)
+    {
+        cerr << "Error DQing buffer at output plane" << endl;
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
+    }
+
+    if ((v4l2_buf->flags & V4L2_BUF_FLAG_ERROR) && ctx->enable_input_metadata)
+    {
+        v4l2_ctrl_videodec_inputbuf_metadata dec_input_metadata;
+
+        /* Get the decoder input metadata.
+           Refer V4L2_CID_MPEG_VIDEODEC_INPUT_METADATA */
+        ret = ctx->dec->getInputMetadata(v4l2_buf->index, dec_input_metadata);
+        if (ret == 0)
+        {
+            ret = report_input_metadata(ctx, &dec_input_metadata);
+            if (ret == -1)
+            {
+                cerr << "Error with input stream header parsing" << endl;
+            }
+        }
+    }
+
+    if (ctx->input_eos)
+    {
+        /* Got End Of Stream, no more queueing of buffers on OUTPUT plane.
+           Leave the poller once all the buffers are back. */
+        return ctx->dec->output_plane.getNumQueuedBuffers() > 0;
+    }
+
+    while (1)
+    {
+        uint32_t current_file = ctx->current_file;
+
+        if (ctx->input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(ctx->container_reader[current_file], buffer,
+                    v4l2_buf);
+            if (ret != 0)
+                cerr << "Couldn't read sample" << endl;
+        }
+        else if ((ctx->decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+                (ctx->decoder_pixfmt == V4L2_PIX_FMT_H265) ||
+                (ctx->decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
+                (ctx->decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
+        {
+            if (ctx->input_nalu)
+            {
+                /* read the input nal unit. */
+                ret = read_decoder_input_nalu(ctx->bs_reader[current_file], buffer, ctx);
+                if (ret < 0)
+                {
+                    abort(ctx);
+                    ctx->dec->interruptWait();
+                    return false;
+                }
+            }
+            else
+            {
+                /* read the input chunks. */
+                read_decoder_input_chunk(ctx->in_file[current_file], buffer);
+            }
+        }
+        else if (ctx->decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
+        {
+            read_mjpeg_decoder_input(ctx->mjpeg_reader[current_file], buffer);
+        }
+        else if ((ctx->decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
+                (ctx->decoder_pixfmt == V4L2_PIX_FMT_VP8) ||
+                (ctx->decoder_pixfmt == V4L2_PIX_FMT_AV1))
+        {
+            /* read the input chunks. */
+            ret = read_vpx_decoder_input_chunk(ctx->ivf_reader[current_file], buffer);
+            if (ret != 0)
+                cerr << "Couldn't read chunk" << endl;
+        }
+        v4l2_buf->m.planes[0].bytesused = buffer->planes[0].bytesused;
+
+        if (ctx->input_nalu && ctx->copy_timestamp && ctx->flag_copyts)
+        {
+            /* Update the timestamp. */
+            v4l2_buf->flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+            ctx->timestamp += ctx->timestampincr;
+            v4l2_buf->timestamp.tv_sec = ctx->timestamp / (MICROSECOND_UNIT);
+            v4l2_buf->timestamp.tv_usec = ctx->timestamp % (MICROSECOND_UNIT);
+        }
+
+        /* At the end of a file, read the next one into the same buffer. */
+        if (v4l2_buf->m.planes[0].bytesused == 0)
+        {
+            if (ctx->bQueue)
+            {
+                ctx->current_file++;
+                if (ctx->current_file != ctx->file_count)
+                {
+                    continue;
+                }
+            }
+            if (ctx->bLoop)
+            {
+                ctx->current_file = ctx->current_file % ctx->file_count;
+                if (ctx->loop_count == 0 || ctx->current_loop < ctx->loop_count)
+                {
+                    ctx->current_loop++;
+                    continue;
+                }
+            }
+        }
+        break;
+    }
 
+    /* enqueue a buffer for output plane. */
+    ret = ctx->dec->output_plane.qBuffer(*v4l2_buf, NULL);
+    if (ret < 0)
+    {
+        cerr << "Error Qing buffer at output plane" << endl;
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
+    }
+    if (v4l2_buf->m.planes[0].bytesused == 0)
+    {
+        ctx->input_eos = true;
+        cout << "Input file read complete" << endl;
+    }
+    return true;
+}
+
+/**
+  * Callback called by the DQ poller when a decoded buffer is dequeued
+  * from the decoder capture plane, in non-blocking mode. Consumes the
+  * frame and queues the buffer back.
+  *
+  * @param v4l2_buf      : dequeued V4L2 buffer, NULL on error
+  * @param buffer        : dequeued NvBuffer
+  * @param shared_buffer : unused
+  * @param arg           : Decoder context
+  */
+static bool
+dec_capture_plane_cb(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+                     NvBuffer *shared_buffer, void *arg)
+{
     context_t *ctx = (context_t *) arg;
-    v4l2_ctrl_video_device_poll devicepoll;
+    int ret;
 
-    cout << "Starting Device Poll Thread " << endl;
+    if (!v4l2_buf)
+    {
+        cerr << "Error while calling dequeue at capture plane" << endl;
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
+    }
 
-    memset(&devicepoll, 0, sizeof(v4l2_ctrl_video_device_poll));
+    if (v4l2_buf->flags & V4L2_BUF_FLAG_LAST)
+    {
+        /* Wake up the event loop of decoder_proc_nonblocking. */
+        cout << "Got EoS at capture plane" << endl;
+        ctx->got_eos = true;
+        ctx->dec->interruptWait();
+        return false;
+    }
 
-    /* Wait here until you are signalled to issue the Poll call.
-       Check if the abort status is set , if so exit.
-       Else issue the Poll on the decoder and block.
-       When the Poll returns, signal the decoder thread to continue. */
+    /* EglRenderer and the transform require the fd of the 0th plane. */
+    if (ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+        buffer->planes[0].fd = ctx->dmabuff_fd[v4l2_buf->index];
+
+    if (ctx->enable_metadata)
+    {
+        v4l2_ctrl_videodec_outputbuf_metadata dec_metadata;
+
+        /* Get the decoder output metadata on capture-plane.
+           Refer V4L2_CID_MPEG_VIDEODEC_METADATA */
+        ret = ctx->dec->getMetadata(v4l2_buf->index, dec_metadata);
+        if (ret == 0)
+        {
+            report_metadata(ctx, &dec_metadata);
+        }
+    }
+
+    if (ctx->copy_timestamp && ctx->input_nalu && ctx->stats)
+    {
+      cout << "[" << v4l2_buf->index << "]" "dec capture plane dqB timestamp [" <<
+          v4l2_buf->timestamp.tv_sec << "s" << v4l2_buf->timestamp.tv_usec << "us]" << endl;
+    }
+
+    if (!ctx->disable_rendering && ctx->stats)
+    {
+        ctx->renderer->render(buffer->planes[0].fd);
+    }
 
-    while (!ctx->got_error && !ctx->dec->isInError())
+    if (ctx->out_file || (!ctx->disable_rendering && !ctx->stats))
     {
-        /* wait on polling semaphore */
-        sem_wait(&ctx->pollthread_sema);
+        /* Clip & Stitch can be done by adjusting rectangle. */
+        NvBufSurf::NvCommonTransformParams transform_params;
+        transform_params.src_top = 0;
+        transform_params.src_left = 0;
+        transform_params.src_width = ctx->display_width;
+        transform_params.src_height = ctx->display_height;
+        transform_params.dst_top = 0;
+        transform_params.dst_left = 0;
+        transform_params.dst_width = ctx->display_width;
+        transform_params.dst_height = ctx->display_height;
+        transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
+        transform_params.flip = NvBufSurfTransform_None;
+        transform_params.filter = NvBufSurfTransformInter_Nearest;
+        /* Perform Blocklinear to PitchLinear conversion. */
+        ret = NvBufSurf::NvTransform(&transform_params, buffer->planes[0].fd, ctx->dst_dma_fd);
+        if (ret == -1)
+        {
+            cerr << "Transform failed" << endl;
+            abort(ctx);
+            ctx->dec->interruptWait();
+            return false;
+        }
 
-        if (ctx->got_eos)
+        /* Write raw video frame to file. */
+        if (!ctx->stats && ctx->out_file)
         {
-            cout << "Decoder got eos, exiting poll thread \n";
-            return NULL;
+            /* Dumping two planes for NV12, NV16, NV24 and three for I420 */
+            dump_dmabuf(ctx->dst_dma_fd, 0, ctx->out_file);
+            dump_dmabuf(ctx->dst_dma_fd, 1, ctx->out_file);
+            if (ctx->out_pixfmt == 2)
+            {
+                dump_dmabuf(ctx->dst_dma_fd, 2, ctx->out_file);
+            }
         }
 
-        devicepoll.req_events = POLLIN | POLLOUT | POLLERR | POLLPRI;
+        if (!ctx->stats && !ctx->disable_rendering)
+        {
+            ctx->renderer->render(ctx->dst_dma_fd);
+        }
+    }
 
-        /* This call shall wait in the v4l2 decoder library.
-           Refer V4L2_CID_MPEG_VIDEO_DEVICE_POLL */
-        ctx->dec->DevicePoll(&devicepoll);
+    /* Queue the buffer back once it has been used. */
+    if (ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+        v4l2_buf->m.planes[0].m.fd = ctx->dmabuff_fd[v4l2_buf->index];
 
-        /* We can check the devicepoll.resp_events bitmask to see
-           which events are set. */
-        sem_post(&ctx->decoderthread_sema);
+    if (ctx->dec->capture_plane.qBuffer(*v4l2_buf, NULL) < 0)
+    {
+        cerr << "Error while queueing buffer at decoder capture plane" << endl;
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
     }
-    return NULL;
+    return true;
 }
 
 /**
@@ -793,8 +944,6 @@ dec_capture_loop_fcn(void *arg)
     /* Exit on error or EOS which is signalled in main() */
     while (!(ctx->got_error || dec->isInError()))
     {
-        NvBuffer *dec_buffer;
-
         /* Check for Resolution change again.
            Refer ioctl VIDIOC_DQEVENT */
         ret = dec->dqEvent(ev, false);
@@ -814,14 +963,16 @@ dec_capture_loop_fcn(void *arg)
         {
             struct v4l2_buffer v4l2_buf;
             struct v4l2_plane planes[MAX_PLANES];
+            NvBufferRef dec_buffer;
 
             memset(&v4l2_buf, 0, sizeof(v4l2_buf));
             memset(planes, 0, sizeof(planes));
             v4l2_buf.m.planes = planes;
 
-            /* Dequeue a filled buffer. */
+            /* Dequeue a filled buffer. The handle queues it back to the
+               capture plane once it has been used. */
 
-            if (dec->capture_plane.dqBuffer(v4l2_buf, &dec_buffer, NULL, 0))
+            if (dec->capture_plane.dqBuffer(v4l2_buf, dec_buffer, 0))
             {
 
                 if (errno == EAGAIN)
@@ -842,6 +993,10 @@ dec_capture_loop_fcn(void *arg)
                 break;
             }
 
+            /* EglRenderer and the transform require the fd of the 0th plane. */
+            if(ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+                dec_buffer->planes[0].fd = ctx->dmabuff_fd[v4l2_buf.index];
+
             if (ctx->enable_metadata)
             {
                 v4l2_ctrl_videodec_outputbuf_metadata dec_metadata;
@@ -863,9 +1018,6 @@ dec_capture_loop_fcn(void *arg)
 
             if (!ctx->disable_rendering && ctx->stats)
             {
-                /* EglRenderer requires the fd of the 0th plane to render the buffer. */
-                if(ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    dec_buffer->planes[0].fd = ctx->dmabuff_fd[v4l2_buf.index];
                 ctx->renderer->render(dec_buffer->planes[0].fd);
             }
 
@@ -884,13 +1036,13 @@ dec_capture_loop_fcn(void *arg)
                 transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
                 transform_params.flip = NvBufSurfTransform_None;
                 transform_params.filter = NvBufSurfTransformInter_Nearest;
-                if(ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    dec_buffer->planes[0].fd = ctx->dmabuff_fd[v4l2_buf.index];
                 /* Perform Blocklinear to PitchLinear conversion. */
                 ret = NvBufSurf::NvTransform(&transform_params, dec_buffer->planes[0].fd, ctx->dst_dma_fd);
                 if (ret == -1)
                 {
                     cerr << "Transform failed" << endl;
+                    /* Keep the buffer out of the plane, as before. */
+                    dec_buffer.release();
                     break;
                 }
 
@@ -910,32 +1062,16 @@ dec_capture_loop_fcn(void *arg)
                 {
                     ctx->renderer->render(ctx->dst_dma_fd);
                 }
-
-                /* If not writing to file, Queue the buffer back once it has been used. */
-                if(ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    v4l2_buf.m.planes[0].m.fd = ctx->dmabuff_fd[v4l2_buf.index];
-                if (dec->capture_plane.qBuffer(v4l2_buf, NULL) < 0)
-                {
-                    abort(ctx);
-                    cerr <<
-                        "Error while queueing buffer at decoder capture plane"
-                        << endl;
-                    break;
-                }
             }
-            else
+
+            /* Queue the buffer back once it has been used. */
+            if (dec_buffer.reset() < 0)
             {
-                /* If not writing to file, Queue the buffer back once it has been used. */
-                if(ctx->capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    v4l2_buf.m.planes[0].m.fd = ctx->dmabuff_fd[v4l2_buf.index];
-                if (dec->capture_plane.qBuffer(v4l2_buf, NULL) < 0)
-                {
-                    abort(ctx);
-                    cerr <<
-                        "Error while queueing buffer at decoder capture plane"
-                        << endl;
-                    break;
-                }
+                abort(ctx);
+                cerr <<
+                    "Error while queueing buffer at decoder capture plane"
+                    << endl;
+                break;
             }
         }
     }
@@ -962,8 +1098,6 @@ set_defaults(context_t * ctx)
     ctx->fps = 30;
     ctx->output_plane_mem_type = V4L2_MEMORY_MMAP;
     ctx->capture_plane_mem_type = V4L2_MEMORY_DMABUF;
-    ctx->vp9_file_header_flag = 0;
-    ctx->vp8_file_header_flag = 0;
     ctx->stress_test = 1;
     ctx->copy_timestamp = false;
     ctx->flag_copyts = false;
@@ -988,336 +1122,72 @@ set_defaults(context_t * ctx)
   * @param eos               : end of stream
   * @param current_file      : current file
   * @param current_loop      : iterator count
-  * @param nalu_parse_buffer : input parsed nal unit
   */
 static bool decoder_proc_nonblocking(context_t &ctx, bool eos, uint32_t current_file,
-                    int current_loop, char *nalu_parse_buffer)
+                    int current_loop)
 {
-    /*  NOTE: In non-blocking mode, we will have this function do below things:
-              1) Issue signal to PollThread so it starts Poll and wait until we are signalled.
-              2) After we are signalled, it means there is something to dequeue, either output plane
-                 or capture plane or there's an event.
-              3) Try dequeuing from all three and then act appropriately.
-              4) After enqueuing go back to the same loop. */
-
-    /* Since all the output plane buffers have been queued, we first need to
-       dequeue a buffer from output plane before we can read new data into it
-       and queue it again. */
-    int allow_DQ = true;
-    int ret = 0;
-    struct v4l2_buffer temp_buf;
+    /*  NOTE: In non-blocking mode, a DQ poller services both decoder planes:
+              1) The poller thread sleeps until a buffer can be dequeued from
+                 the output or the capture plane, and calls dec_output_plane_cb
+                 or dec_capture_plane_cb for it.
+              2) dec_output_plane_cb reads the next input chunk and queues the
+                 buffer again, dec_capture_plane_cb consumes the decoded frame
+                 and queues the buffer back.
+              3) Meanwhile this thread waits for the decoder events and sets up
+                 the capture plane on resolution change.
+              4) The callbacks interrupt the wait at the end of stream or on
+                 error. */
     struct v4l2_event ev;
+    int ret = 0;
 
-    while (!ctx.got_error && !ctx.dec->isInError())
-    {
-        struct v4l2_buffer v4l2_output_buf;
-        struct v4l2_plane output_planes[MAX_PLANES];
-
-        struct v4l2_buffer v4l2_capture_buf;
-        struct v4l2_plane capture_planes[MAX_PLANES];
-
-        NvBuffer *output_buffer = NULL;
-        NvBuffer *capture_buffer = NULL;
-
-        memset(&v4l2_output_buf, 0, sizeof(v4l2_output_buf));
-        memset(output_planes, 0, sizeof(output_planes));
-        v4l2_output_buf.m.planes = output_planes;
-
-        memset(&v4l2_capture_buf, 0, sizeof(v4l2_capture_buf));
-        memset(capture_planes, 0, sizeof(capture_planes));
-        v4l2_capture_buf.m.planes = capture_planes;
-
-        /* Call for SetPollInterrupt.
-           Refer V4L2_CID_MPEG_SET_POLL_INTERRUPT */
-        ctx.dec->SetPollInterrupt();
+    ctx.input_eos = eos;
+    ctx.current_file = current_file;
+    ctx.current_loop = current_loop;
 
-        /* Since buffers have been queued, issue a post to start polling and
-           then wait here. */
-        sem_post(&ctx.pollthread_sema);
-        sem_wait(&ctx.decoderthread_sema);
+    ctx.dec->output_plane.setDQThreadCallback(dec_output_plane_cb);
+    ctx.dec->capture_plane.setDQThreadCallback(dec_capture_plane_cb);
+    if (ctx.dec->output_plane.startDQThread(&ctx, ctx.dq_poller) < 0)
+    {
+        cerr << "Error adding the output plane to the DQ poller" << endl;
+        abort(&ctx);
+        return ctx.input_eos;
+    }
 
+    while (!ctx.got_eos && !ctx.got_error && !ctx.dec->isInError())
+    {
         /* Call for dequeuing an event.
            Refer ioctl VIDIOC_DQEVENT */
-        ret = ctx.dec->dqEvent(ev, 0);
-        if (ret == 0)
-        {
-            if (ev.type == V4L2_EVENT_RESOLUTION_CHANGE)
-            {
-                /* Received the resolution change event, now can do query_and_set_capture. */
-                cout << "Got V4L2_EVENT_RESOLUTION_CHANGE EVENT \n";
-                query_and_set_capture(&ctx);
-
-            }
-        }
-        else if (ret < 0 && errno == EINVAL)
+        ret = ctx.dec->dqEvent(ev, 50000);
+        if (ret < 0)
         {
+            /* Timed out, or woken up by the callbacks. */
+            if (errno == EAGAIN || errno == ECANCELED)
+                continue;
             cerr << "Error in dequeueing decoder event" << endl;
             abort(&ctx);
+            break;
         }
 
-        /* dequeue from the output plane and enqueue back the buffers after reading. */
-        while (1)
+        if (ev.type == V4L2_EVENT_RESOLUTION_CHANGE)
         {
-            if ( (eos) && (ctx.dec->output_plane.getNumQueuedBuffers() == 0) )
-            {
-                cout << "Done processing all the buffers returning \n";
-                return true;
-            }
-
-            /* dequeue a buffer for output plane. */
-            if (allow_DQ)
-            {
-                ret = ctx.dec->output_plane.dqBuffer(v4l2_output_buf, &output_buffer, NULL, 0);
-                if (ret < 0)
-                {
-                    if (errno == EAGAIN)
-                        goto check_capture_buffers;
-                    else
-                    {
-                        cerr << "Error DQing buffer at output plane" << endl;
-                        abort(&ctx);
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                allow_DQ = true;
-                memcpy(&v4l2_output_buf,&temp_buf,sizeof(v4l2_buffer));
-                output_buffer = ctx.dec->output_plane.getNthBuffer(v4l2_output_buf.index);
-            }
-
-            if ((v4l2_output_buf.flags & V4L2_BUF_FLAG_ERROR) && ctx.enable_input_metadata)
-            {
-                v4l2_ctrl_videodec_inputbuf_metadata dec_input_metadata;
-
-                /* Get the decoder input metadata.
-                   Refer V4L2_CID_MPEG_VIDEODEC_INPUT_METADATA */
-                ret = ctx.dec->getInputMetadata(v4l2_output_buf.index, dec_input_metadata);
-                if (ret == 0)
-                {
-                    ret = report_input_metadata(&ctx, &dec_input_metadata);
-                    if (ret == -1)
-                    {
-                        cerr << "Error with input stream header parsing" << endl;
-                    }
-                }
-            }
-
-            if (eos)
-            {
-                /* Got End Of Stream, no more queueing of buffers on OUTPUT plane. */
-                goto check_capture_buffers;
-            }
-
-            if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
-            {
-                if (ctx.input_nalu)
-                {
-                    /* read the input nal unit. */
-                    read_decoder_input_nalu(ctx.in_file[current_file], output_buffer, nalu_parse_buffer,
-                            CHUNK_SIZE, &ctx);
-                }
-                else
-                {
-                    /* read the input chunks. */
-                    read_decoder_input_chunk(ctx.in_file[current_file], output_buffer);
-                }
-            }
-
-            if (ctx.decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
-            {
-                read_mjpeg_decoder_input(ctx.in_file[current_file], output_buffer);
-            }
-            if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1))
-            {
-                /* read the input chunks. */
-                ret = read_vpx_decoder_input_chunk(&ctx, output_buffer);
-                if (ret != 0)
-                    cerr << "Couldn't read chunk" << endl;
-            }
-            v4l2_output_buf.m.planes[0].bytesused = output_buffer->planes[0].bytesused;
-
-            if (ctx.input_nalu && ctx.copy_timestamp && ctx.flag_copyts)
-            {
-                /* Update the timestamp. */
-                v4l2_output_buf.flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
-                ctx.timestamp += ctx.timestampincr;
-                v4l2_output_buf.timestamp.tv_sec = ctx.timestamp / (MICROSECOND_UNIT);
-                v4l2_output_buf.timestamp.tv_usec = ctx.timestamp % (MICROSECOND_UNIT);
-            }
-
-            if (v4l2_output_buf.m.planes[0].bytesused == 0)
+            /* Received the resolution change event, now can do query_and_set_capture.
+               The poller must not service the capture plane meanwhile. */
+            cout << "Got V4L2_EVENT_RESOLUTION_CHANGE EVENT \n";
+            ctx.dec->capture_plane.stopDQThread();
+            query_and_set_capture(&ctx);
+            if (!ctx.got_error &&
+                ctx.dec->capture_plane.startDQThread(&ctx, ctx.dq_poller) < 0)
             {
-                if (ctx.bQueue)
-                {
-                    current_file++;
-                    if(current_file != ctx.file_count)
-                    {
-                        allow_DQ = false;
-                        memcpy(&temp_buf, &v4l2_output_buf, sizeof(v4l2_buffer));
-                        continue;
-                    }
-                }
-                if(ctx.bLoop)
-                {
-                    current_file = current_file % ctx.file_count;
-                    allow_DQ = false;
-                    memcpy(&temp_buf, &v4l2_output_buf,sizeof(v4l2_buffer));
-                    if (ctx.loop_count == 0 || current_loop < ctx.loop_count )
-                    {
-                        current_loop++;
-                        continue;
-                    }
-                }
-            }
-
-            /* enqueue a buffer for output plane. */
-            ret = ctx.dec->output_plane.qBuffer(v4l2_output_buf, NULL);
-            if (ret < 0)
-            {
-                cerr << "Error Qing buffer at output plane" << endl;
+                cerr << "Error adding the capture plane to the DQ poller" << endl;
                 abort(&ctx);
-                break;
-            }
-            if (v4l2_output_buf.m.planes[0].bytesused == 0)
-            {
-                eos = true;
-                cout << "Input file read complete" << endl;
-                goto check_capture_buffers;
-            }
-        }
-
-check_capture_buffers:
-        /* Dequeue from the capture plane and write them to file and enqueue back. */
-        while (1)
-        {
-            if (!ctx.dec->capture_plane.getStreamStatus())
-            {
-                cout << "Capture plane not ON, skipping capture plane \n";
-                break;
-            }
-
-            /* Dequeue a filled buffer. */
-            ret = ctx.dec->capture_plane.dqBuffer(v4l2_capture_buf, &capture_buffer, NULL, 0);
-            if (ret < 0)
-            {
-                if (errno == EAGAIN)
-                    break;
-                else
-                {
-                    abort(&ctx);
-                    cerr << "Error while calling dequeue at capture plane" <<
-                        endl;
-                }
-                break;
-            }
-            if (capture_buffer == NULL)
-            {
-                cout << "Got CAPTURE BUFFER NULL \n";
-                break;
-            }
-
-            if (ctx.enable_metadata)
-            {
-                v4l2_ctrl_videodec_outputbuf_metadata dec_metadata;
-
-                /* Get the decoder output metadata on capture-plane.
-                   Refer V4L2_CID_MPEG_VIDEODEC_METADATA */
-                ret = ctx.dec->getMetadata(v4l2_capture_buf.index, dec_metadata);
-                if (ret == 0)
-                {
-                    report_metadata(&ctx, &dec_metadata);
-                }
-            }
-
-            if (ctx.copy_timestamp && ctx.input_nalu && ctx.stats)
-            {
-              cout << "[" << v4l2_capture_buf.index << "]" "dec capture plane dqB timestamp [" <<
-                  v4l2_capture_buf.timestamp.tv_sec << "s" << v4l2_capture_buf.timestamp.tv_usec << "us]" << endl;
-            }
-
-            if (!ctx.disable_rendering && ctx.stats)
-            {
-                /* Rendering the buffer.
-                   NOTE: EglRenderer requires the fd of the 0th plane to render the buffer. */
-                if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    capture_buffer->planes[0].fd = ctx.dmabuff_fd[v4l2_capture_buf.index];
-
-                if (ctx.renderer->render(capture_buffer->planes[0].fd) == -1)
-                {
-                    abort(&ctx);
-                    cerr << "Error while queueing buffer for rendering "
-                            << endl;
-                    break;
-                }
-            }
-
-            /* Get the decoded buffer data dumped to file. */
-            if (ctx.out_file || (!ctx.disable_rendering && !ctx.stats))
-            {
-                NvBufSurf::NvCommonTransformParams transform_params;
-                transform_params.src_top = 0;
-                transform_params.src_left = 0;
-                transform_params.src_width = ctx.display_width;
-                transform_params.src_height = ctx.display_height;
-                transform_params.dst_top = 0;
-                transform_params.dst_left = 0;
-                transform_params.dst_width = ctx.display_width;
-                transform_params.dst_height = ctx.display_height;
-                transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
-                transform_params.flip = NvBufSurfTransform_None;
-                transform_params.filter = NvBufSurfTransformInter_Nearest;
-
-                if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    capture_buffer->planes[0].fd = ctx.dmabuff_fd[v4l2_capture_buf.index];
-                /* Perform Blocklinear to PitchLinear conversion. */
-                ret = NvBufSurf::NvTransform(&transform_params, capture_buffer->planes[0].fd, ctx.dst_dma_fd);
-                if (ret == -1)
-                {
-                    cerr << "Transform failed" << endl;
-                    break;
-                }
-                /* Write raw video frame to file. */
-                if (!ctx.stats && ctx.out_file)
-                {
-                    /* Dumping two planes for NV12, NV16, NV24 and three for I420 */
-                    cout << "Writing to file \n";
-                    dump_dmabuf(ctx.dst_dma_fd, 0, ctx.out_file);
-                    dump_dmabuf(ctx.dst_dma_fd, 1, ctx.out_file);
-                    if (ctx.out_pixfmt == 2)
-                    {
-                        dump_dmabuf(ctx.dst_dma_fd, 2, ctx.out_file);
-                    }
-                }
-
-                /* Rendering the buffer. */
-                if (!ctx.stats && !ctx.disable_rendering)
-                {
-                    ctx.renderer->render(ctx.dst_dma_fd);
-                }
-
-                /* Queue the buffer back once it has been used.
-                   NOTE: If we are not rendering, queue the buffer back here immediately. */
-                if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    v4l2_capture_buf.m.planes[0].m.fd = ctx.dmabuff_fd[v4l2_capture_buf.index];
-
-                if (ctx.dec->capture_plane.qBuffer(v4l2_capture_buf, NULL) < 0)
-                {
-                    abort(&ctx);
-                    cerr << "Error while queueing buffer at decoder capture plane"
-                            << endl;
-                    break;
-                }
             }
         }
     }
-    return eos;
+
+    /* Stop servicing the planes before the decoder is torn down. */
+    ctx.dec->output_plane.stopDQThread();
+    ctx.dec->capture_plane.stopDQThread();
+    return ctx.input_eos;
 }
 
 /**
@@ -1327,10 +1197,9 @@ check_capture_buffers:
   * @param eos               : end of stream
   * @param current_file      : current file
   * @param current_loop      : iterator count
-  * @param nalu_parse_buffer : input parsed nal unit
   */
 static bool decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file,
-                                int current_loop, char *nalu_parse_buffer)
+                                int current_loop)
 {
     int allow_DQ = true;
     int ret = 0;
@@ -1385,7 +1254,15 @@ static bool decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_fil
             }
         }
 
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+        if (ctx.input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(ctx.container_reader[current_file], buffer,
+                    &v4l2_buf);
+            if (ret != 0)
+                cerr << "Couldn't read sample" << endl;
+        }
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
@@ -1393,8 +1270,12 @@ static bool decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_fil
             if (ctx.input_nalu)
             {
                 /* read the input nal unit. */
-                read_decoder_input_nalu(ctx.in_file[current_file], buffer, nalu_parse_buffer,
-                        CHUNK_SIZE, &ctx);
+                ret = read_decoder_input_nalu(ctx.bs_reader[current_file], buffer, &ctx);
+                if (ret < 0)
+                {
+                    abort(&ctx);
+                    break;
+                }
             }
             else
             {
@@ -1402,17 +1283,16 @@ static bool decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_fil
                 read_decoder_input_chunk(ctx.in_file[current_file], buffer);
             }
         }
-
-        if (ctx.decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
+        else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
         {
-            read_mjpeg_decoder_input(ctx.in_file[current_file], buffer);
+            read_mjpeg_decoder_input(ctx.mjpeg_reader[current_file], buffer);
         }
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1))
         {
             /* read the input chunks. */
-            ret = read_vpx_decoder_input_chunk(&ctx, buffer);
+            ret = read_vpx_decoder_input_chunk(ctx.ivf_reader[current_file], buffer);
             if (ret != 0)
                 cerr << "Couldn't read chunk" << endl;
         }
@@ -1481,7 +1361,6 @@ decode_proc(context_t& ctx, int argc, char *argv[])
     uint32_t i;
     bool eos = false;
     int current_loop = 0;
-    char *nalu_parse_buffer = NULL;
     //#define GOVERNOR_SYS_FILE "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor"
     //#define REQUIRED_GOVERNOR "performance" "schedutil"
     NvApplicationProfiler &profiler = NvApplicationProfiler::getProfilerInstance();
@@ -1520,6 +1399,89 @@ decode_proc(context_t& ctx, int argc, char *argv[])
         TEST_ERROR(!ctx.in_file[i]->is_open(), "Error opening input file", cleanup);
     }
 
+    /* NAL unit input is served from a memory mapped index of each file. */
+    if (ctx.input_nalu)
+    {
+        ctx.bs_reader = (NvBitstreamReader **)calloc(ctx.file_count,
+                sizeof(NvBitstreamReader *));
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+        {
+            ctx.bs_reader[i] =
+                NvBitstreamReader::createBitstreamReader(ctx.in_file_path[i]);
+            TEST_ERROR(!ctx.bs_reader[i], "Error indexing input file", cleanup);
+        }
+    }
+
+    /* Container input is served from a memory mapped sample index of
+       each MP4 or Matroska file. */
+    if (ctx.input_container)
+    {
+        ctx.container_reader = (NvContainerReader **)calloc(ctx.file_count,
+                sizeof(NvContainerReader *));
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+        {
+            ctx.container_reader[i] =
+                NvContainerReader::createContainerReader(ctx.in_file_path[i]);
+            TEST_ERROR(!ctx.container_reader[i], "Error indexing input file",
+                    cleanup);
+            if (ctx.container_reader[i]->getPixelFormat() != ctx.decoder_pixfmt)
+            {
+                cerr << "Warning: Video codec of " << ctx.in_file_path[i] <<
+                    " does not match the decoder format" << endl;
+            }
+        }
+
+        if (ctx.start_frame)
+        {
+            int64_t frame =
+                ctx.container_reader[0]->seekToKeyFrame(ctx.start_frame);
+            TEST_ERROR(frame < 0, "Start frame is beyond the end of the file",
+                    cleanup);
+            cout << "Starting at key frame " << frame << endl;
+        }
+    }
+    /* MJPEG input is split into images from a memory mapped index of
+       each file. */
+    else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
+    {
+        ctx.mjpeg_reader = (NvMjpegReader **)calloc(ctx.file_count,
+                sizeof(NvMjpegReader *));
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+        {
+            ctx.mjpeg_reader[i] =
+                NvMjpegReader::createMjpegReader(ctx.in_file_path[i]);
+            TEST_ERROR(!ctx.mjpeg_reader[i], "Error indexing input file", cleanup);
+        }
+    }
+    /* VP8/VP9/AV1 input is served from a memory mapped frame index of
+       each IVF file. */
+    else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
+            (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8) ||
+            (ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1))
+    {
+        ctx.ivf_reader = (NvIvfReader **)calloc(ctx.file_count,
+                sizeof(NvIvfReader *));
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+        {
+            ctx.ivf_reader[i] =
+                NvIvfReader::createIvfReader(ctx.in_file_path[i]);
+            TEST_ERROR(!ctx.ivf_reader[i], "Error indexing input file", cleanup);
+            if (ctx.ivf_reader[i]->getFourcc() != ctx.decoder_pixfmt)
+            {
+                cerr << "Warning: IVF codec of " << ctx.in_file_path[i] <<
+                    " does not match the decoder format" << endl;
+            }
+        }
+
+        if (ctx.start_frame)
+        {
+            int64_t frame = ctx.ivf_reader[0]->seekToKeyFrame(ctx.start_frame);
+            TEST_ERROR(frame < 0, "Start frame is beyond the end of the file",
+                    cleanup);
+            cout << "Starting at key frame " << frame << endl;
+        }
+    }
+
     /* Open the output file. */
     if (ctx.out_file_path)
     {
@@ -1548,10 +1510,10 @@ decode_proc(context_t& ctx, int argc, char *argv[])
 
     /* Configure for frame input mode for decoder.
        Refer V4L2_CID_MPEG_VIDEO_DISABLE_COMPLETE_FRAME_INPUT */
-    if (ctx.input_nalu)
+    if (ctx.input_nalu || ctx.input_container)
     {
-        /* Input to the decoder will be nal units. */
-        nalu_parse_buffer = new char[CHUNK_SIZE];
+        /* Input to the decoder will be nal units, or whole samples of a
+           container. */
         printf("Setting frame input mode to 0 \n");
         ret = ctx.dec->setFrameInputMode(0);
         TEST_ERROR(ret < 0,
@@ -1644,7 +1606,15 @@ decode_proc(context_t& ctx, int argc, char *argv[])
         memset(planes, 0, sizeof(planes));
         std::cout<<"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa   "<<i <<std::endl;
         buffer = ctx.dec->output_plane.getNthBuffer(i);
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+        if (ctx.input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(ctx.container_reader[current_file], buffer,
+                    &v4l2_buf);
+            if (ret != 0)
+                cerr << "Couldn't read sample" << endl;
+        }
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
@@ -1652,8 +1622,12 @@ decode_proc(context_t& ctx, int argc, char *argv[])
             if (ctx.input_nalu)
             {
                 /* read the input nal unit. */
-                read_decoder_input_nalu(ctx.in_file[current_file], buffer, nalu_parse_buffer,
-                        CHUNK_SIZE, &ctx);
+                ret = read_decoder_input_nalu(ctx.bs_reader[current_file], buffer, &ctx);
+                if (ret < 0)
+                {
+                    abort(&ctx);
+                    break;
+                }
             }
             else
             {
@@ -1661,17 +1635,16 @@ decode_proc(context_t& ctx, int argc, char *argv[])
                 read_decoder_input_chunk(ctx.in_file[current_file], buffer);
             }
         }
-
-        if (ctx.decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
+        else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_MJPEG)
         {
-            read_mjpeg_decoder_input(ctx.in_file[current_file], buffer);
+            read_mjpeg_decoder_input(ctx.mjpeg_reader[current_file], buffer);
         }
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1))
         {
             /* read the input chunks. */
-            ret = read_vpx_decoder_input_chunk(&ctx, buffer);
+            ret = read_vpx_decoder_input_chunk(ctx.ivf_reader[current_file], buffer);
             if (ret != 0)
                 cerr << "Couldn't read chunk" << endl;
         }
@@ -1748,18 +1721,16 @@ decode_proc(context_t& ctx, int argc, char *argv[])
     }
     else
     {
-        sem_init(&ctx.pollthread_sema, 0, 0);
-        sem_init(&ctx.decoderthread_sema, 0, 0);
-        pthread_create(&ctx.dec_pollthread, NULL, decoder_pollthread_fcn, &ctx);
-        cout << "Created the PollThread and Decoder Thread \n";
-        /* Set thread name for decoder Poll thread. */
-        pthread_setname_np(ctx.dec_pollthread, "DecPollThread");
+        /* One thread dequeues both decoder planes. */
+        ctx.dq_poller = NvV4l2DQPoller::createDQPoller("DecPollThread");
+        TEST_ERROR(!ctx.dq_poller, "Could not create DQ poller", cleanup);
+        cout << "Created the DQ poller \n";
     }
     
     if (ctx.blocking_mode)
-        eos = decoder_proc_blocking(ctx, eos, current_file, current_loop, nalu_parse_buffer);
+        eos = decoder_proc_blocking(ctx, eos, current_file, current_loop);
     else
-        eos = decoder_proc_nonblocking(ctx, eos, current_file, current_loop, nalu_parse_buffer);
+        eos = decoder_proc_nonblocking(ctx, eos, current_file, current_loop);
     /* After sending EOS, all the buffers from output plane should be dequeued.
        and after that capture plane loop should be signalled to stop. */
     if (ctx.blocking_mode)
@@ -1817,11 +1788,8 @@ cleanup:
     }
     else if (!ctx.blocking_mode)
     {
-        /* Clear the poll interrupt to get the decoder's poll thread out. */
-        ctx.dec->ClearPollInterrupt();
-        /* If Pollthread is waiting on, signal it to exit the thread. */
-        sem_post(&ctx.pollthread_sema);
-        pthread_join(ctx.dec_pollthread, NULL);
+        /* Stops the poller thread. */
+        delete ctx.dq_poller;
     }
 
     if (ctx.stats)
@@ -1879,18 +1847,36 @@ cleanup:
             error = 1;
         }
     }
-    delete[] nalu_parse_buffer;
+    if (ctx.bs_reader)
+    {
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+          delete ctx.bs_reader[i];
+        free (ctx.bs_reader);
+    }
+    if (ctx.mjpeg_reader)
+    {
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+          delete ctx.mjpeg_reader[i];
+        free (ctx.mjpeg_reader);
+    }
+    if (ctx.container_reader)
+    {
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+          delete ctx.container_reader[i];
+        free (ctx.container_reader);
+    }
+    if (ctx.ivf_reader)
+    {
+        for (uint32_t i = 0 ; i < ctx.file_count ; i++)
+          delete ctx.ivf_reader[i];
+        free (ctx.ivf_reader);
+    }
 
     free (ctx.in_file);
     for (uint32_t i = 0 ; i < ctx.file_count ; i++)
       free (ctx.in_file_path[i]);
     free (ctx.in_file_path);
     free(ctx.out_file_path);
-    if (!ctx.blocking_mode)
-    {
-        sem_destroy(&ctx.pollthread_sema);
-        sem_destroy(&ctx.decoderthread_sema);
-    }
 
     return -error;
 }
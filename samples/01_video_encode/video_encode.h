@@ -28,13 +28,17 @@
 
 #include <fstream>
 #include "NvVideoEncoder.h"
+#include "NvBitstreamSink.h"
+#include "NvMp4Muxer.h"
+#include "NvCrc.h"
+#include "NvFrameSource.h"
+#include "NvEncSchedule.h"
 #include <sstream>
 #include <stdint.h>
 #include <semaphore.h>
 
 #include "NvBufSurface.h"
 
-#define CRC32_POLYNOMIAL  0xEDB88320L
 #define MAX_OUT_BUFFERS 32
 
 typedef struct RPS_List
@@ -51,12 +55,6 @@ typedef struct RPS_param
     RPS_List rps_list[V4L2_MAX_REF_FRAMES];
 } RPS_param;
 
-typedef struct CrcRec
-{
-    unsigned int CRCTable[256];
-    unsigned int CrcValue;
-}Crc;
-
 typedef struct
 {
     NvVideoEncoder *enc;
@@ -65,12 +63,21 @@ typedef struct
 
     char *in_file_path;
     std::ifstream *in_file;
+    bool direct_io; // Read the input with positioned I/O, bypassing the page cache
+    int in_fd; // Input file descriptor, used instead of in_file with direct_io
+    off_t in_offset; // File offset of the next frame read through in_fd
+    uint32_t num_prefetch_frames; // Frames read ahead of the encoder, 0 to read synchronously
+    bool loop_input; // Rewind the input at its end, for soak tests
+    NvFrameSource *frame_source; // Reads frames ahead when num_prefetch_frames is set
 
     uint32_t width;
     uint32_t height;
 
     char *out_file_path;
-    std::ofstream *out_file;
+    NvBitstreamSink *out_file;
+    uint64_t sync_interval; // Bytes written to the output between two fdatasync calls, 0 to never sync
+    bool mp4_output; // Write the output as fragmented MP4 instead of an elementary stream
+    NvMp4Muxer *mp4_muxer;
 
     char *ROI_Param_file_path;
     char *Recon_Ref_file_path;
@@ -78,12 +85,12 @@ typedef struct
     char *hints_Param_file_path;
     char *GDR_Param_file_path;
     char *GDR_out_file_path;
-    std::ifstream *roi_Param_file;
+    char *schedule_cache_path; /* Cache file of the compiled schedule, NULL to parse the sources every run */
     std::ifstream *recon_Ref_file;
-    std::ifstream *rps_Param_file;
-    std::ifstream *hints_Param_file;
-    std::ifstream *gdr_Param_file;
-    std::ofstream *gdr_out_file;
+    NvEncSchedule *schedule; /* Runtime parameter changes and per-frame ROI/RPS/hints/GDR parameters */
+    uint32_t input_metadata_index; /* Frame index in the ROI/RPS/hints tables of the schedule */
+    uint32_t gdr_param_index; /* Index of the next GDR entry of the schedule */
+    NvBitstreamSink *gdr_out_file;
 
     uint32_t bitrate;
     uint32_t peak_bitrate;
@@ -160,7 +167,7 @@ typedef struct
 
     bool use_gold_crc;
     char gold_crc[20];
-    Crc *pBitStreamCrc;
+    NvCrc *pBitStreamCrc;
 
     bool bReconCrc;
     uint32_t rl;                   /* Reconstructed surface Left cordinate */
@@ -173,8 +180,8 @@ typedef struct
 
     bool stats;
 
-    std::stringstream *runtime_params_str;
-    uint32_t next_param_change_frame;
+    char *runtime_params;
+    uint32_t runtime_change_index;
     bool got_error;
     int  stress_test;
     uint32_t endofstream_capture;
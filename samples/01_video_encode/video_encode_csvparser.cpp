@@ -94,6 +94,8 @@ print_help(void)
             "\t-sir <interval>       Slice intrarefresh interval [Default = 0]\n\n"
             "\t-nbf <num>            Number of B frames [Default = 0]\n\n"
             "\t-rpc <string>         Change configurable parameters at runtime\n\n"
+            "\t--schedule-cache <file> Keep the parsed -rpc string and -roi, -rpsf, -hf and -gdrf files in <file>,\n"
+            "\t                      reused by later runs while they are unchanged\n\n"
             "\t-goldcrc <string>     GOLD CRC\n\n"
             "\t--rcrc                Reconstructed surface CRC\n\n"
             "\t-rl <cordinate>       Reconstructed surface Left cordinate [Default = 0]\n\n"
@@ -104,6 +106,12 @@ print_help(void)
             "\t-rcrcf <reconref_file_path> Specify recon crc reference param file\n\n"
             "\t--report-metadata     Print encoder output metadata\n"
             "\t--blocking-mode <val> Set blocking mode, 0 is non-blocking, 1 for blocking (Default) \n\n"
+            "\t--direct-io           Read input frames with O_DIRECT positioned reads [Default = disabled]\n\n"
+            "\t--prefetch <num>      Read <num> input frames ahead from a background thread [Default = 0, disabled]\n"
+            "\t--loop-input          Rewind the input file at its end, for soak tests (with --prefetch)\n\n"
+            "\t--sync-interval <KiB> fdatasync the output every <KiB> written [Default = 0, never]\n"
+            "\t--mp4                 Write the output as fragmented MP4, H264, H265 and AV1 only.\n"
+            "\t                      Timestamps are taken from --copy-timestamp, otherwise from the frame rate\n\n"
             "\t--input-metadata      Enable encoder input metadata\n"
             "\t--copy-timestamp <st> Enable copy timestamp with start timestamp(st) in seconds\n"
             "\t--mvdump              Dump encoded motion vectors\n\n"
@@ -657,7 +665,13 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
         {
             argp++;
             CHECK_OPTION_VALUE(argp);
-            ctx->runtime_params_str = new stringstream(*argp);
+            ctx->runtime_params = strdup(*argp);
+        }
+        else if (!strcmp(arg, "--schedule-cache"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->schedule_cache_path = strdup(*argp);
         }
         else if (!strcmp(arg, "-goldcrc"))
         {
@@ -925,6 +939,30 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
             CHECK_OPTION_VALUE(argp);
             ctx->blocking_mode = atoi(*argp);
         }
+        else if (!strcmp(arg, "--prefetch"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->num_prefetch_frames = atoi(*argp);
+        }
+        else if (!strcmp(arg, "--loop-input"))
+        {
+            ctx->loop_input = true;
+        }
+        else if (!strcmp(arg, "--sync-interval"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->sync_interval = (uint64_t) atoll(*argp) * 1024;
+        }
+        else if (!strcmp(arg, "--mp4"))
+        {
+            ctx->mp4_output = true;
+        }
+        else if (!strcmp(arg, "--direct-io"))
+        {
+            ctx->direct_io = true;
+        }
         else if (!strcmp(arg, "-sf"))
         {
             argp++;
@@ -33,8 +33,10 @@
 #include <malloc.h>
 #include <sstream>
 #include <string.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <unistd.h>
 
 #include "video_encode.h"
 
@@ -43,11 +45,6 @@
                                         error = 1; \
                                         goto label; }
 
-#define TEST_PARSE_ERROR(cond, label) if(cond) { \
-    cerr << "Error parsing runtime parameter changes string" << endl; \
-    goto label; }
-
-#define IS_DIGIT(c) (c >= '0' && c <= '9')
 #define MICROSECOND_UNIT 1000000
 
 using namespace std;
@@ -83,101 +80,19 @@ get_pixfmt_string(uint32_t pixfmt)
     }
 }
 
-/**
-  * Initialise CRC Rec and creates CRC Table based on the polynomial.
-  *
-  * @param CrcPolynomial : CRC Polynomial values
-  */
-static
-Crc* InitCrc(unsigned int CrcPolynomial)
-{
-    unsigned short int i;
-    unsigned short int j;
-    unsigned int tempcrc;
-    Crc *phCrc;
-    phCrc = (Crc*) malloc (sizeof(Crc));
-    if (phCrc == NULL)
-    {
-        cerr << "Mem allocation failed for Init CRC" <<endl;
-        return NULL;
-    }
-
-    memset (phCrc, 0, sizeof(Crc));
-
-    for (i = 0; i <= 255; i++)
-    {
-        tempcrc = i;
-        for (j = 8; j > 0; j--)
-        {
-            if (tempcrc & 1)
-            {
-                tempcrc = (tempcrc >> 1) ^ CrcPolynomial;
-            }
-            else
-            {
-                tempcrc >>= 1;
-            }
-        }
-        phCrc->CRCTable[i] = tempcrc;
-    }
-
-    phCrc->CrcValue = 0;
-    return phCrc;
-}
-
-/**
-  * Calculates CRC of data provided in by buffer.
-  *
-  * @param *phCrc : bitstream CRC
-  * @param buffer : process buffer
-  * @param count  : bytes used
-  */
-static
-void CalculateCrc(Crc *phCrc, unsigned char *buffer, uint32_t count)
-{
-    unsigned char *p;
-    unsigned int temp1;
-    unsigned int temp2;
-    unsigned int crc = phCrc->CrcValue;
-    unsigned int *CRCTable = phCrc->CRCTable;
-
-    if(!count)
-        return;
-
-    p = (unsigned char *) buffer;
-    while (count-- != 0)
-    {
-        temp1 = (crc >> 8) & 0x00FFFFFFL;
-        temp2 = CRCTable[((unsigned int) crc ^ *p++) & 0xFF];
-        crc = temp1 ^ temp2;
-    }
-
-    phCrc->CrcValue = crc;
-}
-
-/**
-  * Closes CRC related handles.
-  *
-  * @param *phCrc : bitstream CRC
-  */
-static
-void CloseCrc(Crc **phCrc)
-{
-    if (*phCrc)
-        free (*phCrc);
-}
-
 /**
   * Write encoded frame data.
   *
-  * @param stream : output stream
+  * The data is copied to the sink and written to the file from its writer
+  * thread, so a slow disk does not hold up the capture plane.
+  *
+  * @param sink   : output bitstream sink
   * @param buffer : output nvbuffer
   */
 static int
-write_encoder_output_frame(ofstream * stream, NvBuffer * buffer)
+write_encoder_output_frame(NvBitstreamSink * sink, NvBuffer * buffer)
 {
-    stream->write((char *) buffer->planes[0].data, buffer->planes[0].bytesused);
-    return 0;
+    return sink->write(buffer->planes[0].data, buffer->planes[0].bytesused);
 }
 
 /**
@@ -232,15 +147,31 @@ encoder_capture_plane_dq_callback(struct v4l2_buffer *v4l2_buf, NvBuffer * buffe
 
     /* Computing CRC with each frame */
     if(ctx->pBitStreamCrc)
-        CalculateCrc (ctx->pBitStreamCrc, buffer->planes[0].data, buffer->planes[0].bytesused);
+        ctx->pBitStreamCrc->update(buffer->planes[0].data, buffer->planes[0].bytesused);
 
     if (!ctx->stats)
-        write_encoder_output_frame(ctx->out_file, buffer);
+    {
+        if (ctx->mp4_muxer)
+            ret = ctx->mp4_muxer->writeBuffer(v4l2_buf, buffer);
+        else
+            ret = write_encoder_output_frame(ctx->out_file, buffer);
+        if (ret < 0)
+        {
+            cerr << "Error while writing encoded frame" << endl;
+            abort(ctx);
+            return false;
+        }
+    }
 
     /* Accounting for the first frame as it is only sps+pps */
     if (ctx->gdr_out_frame_number != 0xFFFFFFFF)
         if ( (ctx->enableGDR) && (ctx->GDR_out_file_path) && (num_encoded_frames >= ctx->gdr_out_frame_number+1))
-            write_encoder_output_frame(ctx->gdr_out_file, buffer);
+            if (write_encoder_output_frame(ctx->gdr_out_file, buffer) < 0)
+            {
+                cerr << "Error while writing GDR frame" << endl;
+                abort(ctx);
+                return false;
+            }
 
     num_encoded_frames++;
 
@@ -356,64 +287,36 @@ encoder_capture_plane_dq_callback(struct v4l2_buffer *v4l2_buf, NvBuffer * buffe
 }
 
 /**
-  * Parse runtime command stream.
+  * Apply the runtime parameter changes of the current frame.
   *
-  * @param ctx   : Encoder context
-  * @param id    : string id
-  * @param value : Integer value
+  * @param ctx : Encoder context
   */
 static int
-get_next_parsed_pair(context_t *ctx, char *id, uint32_t *value)
+set_runtime_params(context_t *ctx)
 {
-    char charval;
-
-    *ctx->runtime_params_str >> *id;
-    if (ctx->runtime_params_str->eof())
-    {
-        return -1;
-    }
-
-    charval = ctx->runtime_params_str->peek();
-    if (!IS_DIGIT(charval))
-    {
-        return -1;
-    }
-
-    *ctx->runtime_params_str >> *value;
+    const NvEncSchedule::NvEncScheduleChange *change;
+    const NvEncSchedule::NvEncScheduleOp *op;
+    int ret;
 
-    *ctx->runtime_params_str >> charval;
-    if (ctx->runtime_params_str->eof())
+    change = ctx->schedule->getRuntimeChange(ctx->runtime_change_index);
+    if (!change ||
+        ctx->enc->output_plane.getTotalQueuedBuffers() != change->frame)
     {
         return 0;
     }
+    ctx->runtime_change_index++;
 
-    return charval;
-}
-
-/**
-  * Set Runtime Parameters.
-  *
-  * @param ctx : Encoder context
-  */
-static int
-set_runtime_params(context_t *ctx)
-{
-    char charval;
-    uint32_t intval;
-    int ret, next;
-
-    cout << "Frame " << ctx->next_param_change_frame <<
+    cout << "Frame " << change->frame <<
         ": Changing parameters" << endl;
-    while (!ctx->runtime_params_str->eof())
+    op = ctx->schedule->getRuntimeOps(change);
+    for (uint32_t i = 0; i < change->num_ops; i++, op++)
     {
-        next = get_next_parsed_pair(ctx, &charval, &intval);
-        TEST_PARSE_ERROR(next < 0, err);
-        switch (charval)
+        switch (op->id)
         {
             case 'b':
                 if (ctx->ratecontrol == V4L2_MPEG_VIDEO_BITRATE_MODE_VBR &&
-                    ctx->peak_bitrate < intval) {
-                    uint32_t peak_bitrate = 1.2f * intval;
+                    ctx->peak_bitrate < op->value) {
+                    uint32_t peak_bitrate = 1.2f * op->value;
                     cout << "Peak bitrate = " << peak_bitrate << endl;
                     ret = ctx->enc->setPeakBitrate(peak_bitrate);
                     if (ret < 0)
@@ -422,8 +325,8 @@ set_runtime_params(context_t *ctx)
                         goto err;
                     }
                 }
-                cout << "Bitrate = " << intval << endl;
-                ret = ctx->enc->setBitrate(intval);
+                cout << "Bitrate = " << op->value << endl;
+                ret = ctx->enc->setBitrate(op->value);
                 if (ret < 0)
                 {
                     cerr << "Could not set encoder bitrate" << endl;
@@ -431,8 +334,8 @@ set_runtime_params(context_t *ctx)
                 }
                 break;
             case 'p':
-                cout << "Peak bitrate = " << intval << endl;
-                ret = ctx->enc->setPeakBitrate(intval);
+                cout << "Peak bitrate = " << op->value << endl;
+                ret = ctx->enc->setPeakBitrate(op->value);
                 if (ret < 0)
                 {
                     cerr << "Could not set encoder peakbitrate" << endl;
@@ -440,82 +343,53 @@ set_runtime_params(context_t *ctx)
                 }
                 break;
             case 'r':
-            {
-                int fps_num = intval;
-                TEST_PARSE_ERROR(next != '/', err);
+                cout << "Framerate = " << op->value << "/"  << op->value2 << endl;
 
-                ctx->runtime_params_str->seekg(-1, ios::cur);
-                next = get_next_parsed_pair(ctx, &charval, &intval);
-                TEST_PARSE_ERROR(next < 0, err);
-
-                cout << "Framerate = " << fps_num << "/"  << intval << endl;
-
-                ret = ctx->enc->setFrameRate(fps_num, intval);
+                ret = ctx->enc->setFrameRate(op->value, op->value2);
                 if (ret < 0)
                 {
                     cerr << "Could not set framerate" << endl;
                     goto err;
                 }
                 break;
-            }
             case 'i':
-                if (intval > 0)
+                if (op->value > 0)
                 {
                     ctx->enc->forceIDR();
                     cout << "Forcing IDR" << endl;
                 }
                 break;
-            default:
-                TEST_PARSE_ERROR(true, err);
-        }
-        switch (next)
-        {
-            case 0:
-                delete ctx->runtime_params_str;
-                ctx->runtime_params_str = NULL;
-                return 0;
-            case '#':
-                return 0;
-            case ',':
-                break;
-            default:
-                break;
         }
     }
+
+    /* The string could not be parsed past this change. */
+    if (change->parse_error)
+    {
+        goto err;
+    }
     return 0;
 err:
     cerr << "Skipping further runtime parameter changes" <<endl;
-    delete ctx->runtime_params_str;
-    ctx->runtime_params_str = NULL;
+    ctx->runtime_change_index = ctx->schedule->getNumRuntimeChanges();
     return -1;
 }
 
 /**
-  * Get the next runtime parameters change for frame.
+  * Reads the next raw frame from the input file, from the read-ahead ring
+  * when prefetching, or with positioned I/O on the file descriptor when
+  * direct I/O is enabled.
   *
-  * @param ctx : Encoder context
+  * @param ctx    : Encoder context
+  * @param buffer : Buffer to read the frame into
   */
 static int
-get_next_runtime_param_change_frame(context_t *ctx)
+read_input_frame(context_t &ctx, NvBuffer &buffer)
 {
-    char charval;
-    int ret;
-
-    ret = get_next_parsed_pair(ctx, &charval, &ctx->next_param_change_frame);
-    if(ret == 0)
-    {
-        return 0;
-    }
-
-    TEST_PARSE_ERROR((ret != ';' && ret != ',') || charval != 'f', err);
-
-    return 0;
-
-err:
-    cerr << "Skipping further runtime parameter changes" <<endl;
-    delete ctx->runtime_params_str;
-    ctx->runtime_params_str = NULL;
-    return -1;
+    if (ctx.frame_source)
+        return ctx.frame_source->readFrame(buffer);
+    if (ctx.in_fd >= 0)
+        return read_video_frame(ctx.in_fd, &ctx.in_offset, buffer);
+    return read_video_frame(ctx.in_file, buffer);
 }
 
 /**
@@ -572,6 +446,7 @@ set_defaults(context_t * ctx)
     ctx->start_ts = 0;
     ctx->max_perf = 0;
     ctx->blocking_mode = 1;
+    ctx->in_fd = -1;
     ctx->startf = 0;
     ctx->endf = 0;
     ctx->num_output_buffers = 6;
@@ -592,99 +467,6 @@ set_defaults(context_t * ctx)
     ctx->disable_av1cdfupdate = (uint8_t)-1;
 }
 
-/**
-  * Populate the Region Of Interest(ROI) Parameters.
-  *
-  * @param stream          : input stream
-  * @param VEnc_ROI_params : encoder ROI Parameters
-  */
-static void
-populate_roi_Param(std::ifstream * stream, v4l2_enc_frame_ROI_params *VEnc_ROI_params)
-{
-    unsigned int ROIIndex = 0;
-
-    if (!stream->eof()) {
-        *stream >> VEnc_ROI_params->num_ROI_regions;
-        while (ROIIndex < VEnc_ROI_params->num_ROI_regions)
-        {
-            if (ROIIndex == V4L2_MAX_ROI_REGIONS) {
-                string skip_str;
-                getline(*stream, skip_str);
-
-                VEnc_ROI_params->num_ROI_regions = V4L2_MAX_ROI_REGIONS;
-
-                cout << "Maximum of " << V4L2_MAX_ROI_REGIONS <<
-                        "regions can be applied for a frame" << endl;
-                break;
-            }
-
-            /* Populate Region Of Interest(ROI) coordinates and qpdelta value */
-            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].QPdelta;
-            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.left;
-            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.top;
-            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.width;
-            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.height;
-            ROIIndex++;
-        }
-    } else {
-        cout << "EOF of ROI_param_file & rewind" << endl;
-        stream->clear();
-        stream->seekg(0);
-    }
-}
-
-/**
-  * Populate the External Reference Picture Set(RPS) Parameters.
-  *
-  * @param stream                   : input stream
-  * @param VEnc_ext_rps_ctrl_params : encoder RPS Parameters
-  */
-static void
-populate_ext_rps_ctrl_Param (std::ifstream * stream, v4l2_enc_frame_ext_rps_ctrl_params *VEnc_ext_rps_ctrl_params)
-{
-    unsigned int RPSIndex = 0;
-    unsigned int temp = 0;
-
-    stream->peek();
-restart :
-    if (stream->eof()) {
-        cout << "EOF of rps_param_file & rewind" << endl;
-        stream->clear();
-        stream->seekg(0);
-    }
-    if (!stream->eof()) {
-        /* Populate External Reference Picture Set(RPS) specific configuration */
-        *stream >> VEnc_ext_rps_ctrl_params->nFrameId;
-        if (stream->eof())
-            goto restart;
-        *stream >> temp;
-        VEnc_ext_rps_ctrl_params->bRefFrame = ((temp)?true:false);
-        *stream >> temp;
-        VEnc_ext_rps_ctrl_params->bLTRefFrame = ((temp)?true:false);
-        *stream >> VEnc_ext_rps_ctrl_params->nMaxRefFrames;
-        *stream >> VEnc_ext_rps_ctrl_params->nActiveRefFrames;
-        *stream >> VEnc_ext_rps_ctrl_params->nCurrentRefFrameId;
-        while (RPSIndex < VEnc_ext_rps_ctrl_params->nActiveRefFrames)
-        {
-            if (RPSIndex == V4L2_MAX_REF_FRAMES) {
-                string skip_str;
-                getline(*stream, skip_str);
-
-                VEnc_ext_rps_ctrl_params->nActiveRefFrames = V4L2_MAX_REF_FRAMES;
-
-                cout << "Maximum of " << V4L2_MAX_REF_FRAMES <<
-                        "reference frames are valid" << endl;
-                break;
-            }
-
-            *stream >> VEnc_ext_rps_ctrl_params->RPSList[RPSIndex].nFrameId;
-            *stream >> temp;
-            VEnc_ext_rps_ctrl_params->RPSList[RPSIndex].bLTRefFrame = ((temp)?true:false);
-            RPSIndex++;
-        }
-    }
-}
-
 static void
 populate_ext_rps_threeLayerSvc_Param (context_t *ctx, v4l2_enc_frame_ext_rps_ctrl_params *VEnc_ext_rps_ctrl_params)
 {
@@ -817,54 +599,6 @@ setup_output_dmabuf(context_t *ctx, uint32_t num_buffers )
     return ret;
 }
 
-/**
-  * Populate the External Rate Control(RC) Parameters.
-  *
-  * @param stream                    : input stream
-  * @param VEnc_ext_rate_ctrl_params : encoder external RC Parameters
-  */
-static void
-populate_ext_rate_ctrl_Param(std::ifstream * stream, v4l2_enc_frame_ext_rate_ctrl_params *VEnc_ext_rate_ctrl_params)
-{
-    stream->peek();
-restart:
-    if (stream->eof()) {
-        cout << "EOF of hints_param_file & rewind" << endl;
-        stream->clear();
-        stream->seekg(0);
-    }
-    if (!stream->eof()) {
-        /* Populate External Rate Control specific configuration */
-        *stream >> VEnc_ext_rate_ctrl_params->nTargetFrameBits;
-        if (stream->eof())
-            goto restart;
-        *stream >> VEnc_ext_rate_ctrl_params->nFrameQP;
-        *stream >> VEnc_ext_rate_ctrl_params->nFrameMinQp;
-        *stream >> VEnc_ext_rate_ctrl_params->nFrameMaxQp;
-        *stream >> VEnc_ext_rate_ctrl_params->nMaxQPDeviation;
-    }
-}
-
-/**
-  * Populate the Gradual Decoder Refresh(GDR) Parameters.
-  *
-  * @param stream          : input stream
-  * @param start_frame_num : start frame number
-  * @param gdr_num_frames  : GDR frame number
-  */
-static void
-populate_gdr_Param(std::ifstream * stream, uint32_t *start_frame_num, uint32_t *gdr_num_frames)
-{
-    if (stream->eof()) {
-        *start_frame_num = 0xFFFFFFFF;
-        cout << "GDR param EoF reached \n";
-    }
-    if (!stream->eof()) {
-        *stream >> *start_frame_num;
-        *stream >> *gdr_num_frames;
-    }
-}
-
 /**
   * Encoder polling thread loop function.
   *
@@ -966,18 +700,12 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
                 return -1;
             }
 
-            /* Get the parsed encoder runtime parameters */
-            if (ctx.runtime_params_str &&
-                    (ctx.enc->output_plane.getTotalQueuedBuffers() ==
-                     ctx.next_param_change_frame))
-            {
+            /* Apply the runtime parameter changes of this frame */
+            if (ctx.schedule)
                 set_runtime_params(&ctx);
-                if (ctx.runtime_params_str)
-                    get_next_runtime_param_change_frame(&ctx);
-            }
 
             /* Read yuv frame data from input file */
-            if (read_video_frame(ctx.in_file, *outplane_buffer) < 0 || ctx.num_frames_to_encode == 0)
+            if (read_input_frame(ctx, *outplane_buffer) < 0 || ctx.num_frames_to_encode == 0)
             {
                 cerr << "Could not read complete frame from input file" << endl;
                 v4l2_output_buf.m.planes[0].bytesused = 0;
@@ -1013,8 +741,8 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
                     if (ctx.enableROI) {
                         VEnc_imeta_param.flag |= V4L2_ENC_INPUT_ROI_PARAM_FLAG;
                         VEnc_imeta_param.VideoEncROIParams = &VEnc_ROI_params;
-                        /* Update Region of Intrest parameters from ROI params file */
-                        populate_roi_Param(ctx.roi_Param_file, VEnc_imeta_param.VideoEncROIParams);
+                        /* Update Region of Intrest parameters of this frame from ROI params file */
+                        ctx.schedule->getRoiParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncROIParams);
                     }
                 }
 
@@ -1037,7 +765,7 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
                         VEnc_imeta_param.flag |= V4L2_ENC_INPUT_RPS_PARAM_FLAG;
                         VEnc_imeta_param.VideoEncRPSParams = &VEnc_ext_rps_ctrl_params;
                         /* Update external reference picture set parameters from RPS params file */
-                        populate_ext_rps_ctrl_Param(ctx.rps_Param_file, VEnc_imeta_param.VideoEncRPSParams);
+                        ctx.schedule->getRpsParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncRPSParams);
                     }
                 }
 
@@ -1047,8 +775,8 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
                     {
                         /* Update GDR parameters from GDR params file */
                         if (ctx.gdr_start_frame_number == 0xFFFFFFFF)
-                            populate_gdr_Param(ctx.gdr_Param_file, &ctx.gdr_start_frame_number,
-                                    &ctx.gdr_num_frames);
+                            ctx.schedule->getGdrParams(ctx.gdr_param_index++,
+                                    &ctx.gdr_start_frame_number, &ctx.gdr_num_frames);
                         if (ctx.input_frames_queued_count == ctx.gdr_start_frame_number)
                         {
                             ctx.gdr_out_frame_number = ctx.gdr_start_frame_number;
@@ -1066,7 +794,7 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
                         VEnc_imeta_param.VideoEncExtRCParams = &VEnc_ext_rate_ctrl_params;
 
                         /* Update external rate control parameters from hints params file */
-                        populate_ext_rate_ctrl_Param(ctx.hints_Param_file, VEnc_imeta_param.VideoEncExtRCParams);
+                        ctx.schedule->getRateCtrlParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncExtRCParams);
 
                     }
                 }
@@ -1077,6 +805,7 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
                     ctx.enc->SetInputMetaParams(v4l2_output_buf.index, VEnc_imeta_param);
                     v4l2_output_buf.reserved2 = v4l2_output_buf.index;
                 }
+                ctx.input_metadata_index++;
             }
 
             if (ctx.copy_timestamp)
@@ -1213,18 +942,12 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
             goto cleanup;
         }
 
-        /* Get the parsed encoder runtime parameters */
-        if (ctx.runtime_params_str &&
-            (ctx.enc->output_plane.getTotalQueuedBuffers() ==
-                ctx.next_param_change_frame))
-        {
+        /* Apply the runtime parameter changes of this frame */
+        if (ctx.schedule)
             set_runtime_params(&ctx);
-            if (ctx.runtime_params_str)
-                get_next_runtime_param_change_frame(&ctx);
-        }
 
         /* Read yuv frame data from input file */
-        if (read_video_frame(ctx.in_file, *buffer) < 0 || ctx.num_frames_to_encode == 0)
+        if (read_input_frame(ctx, *buffer) < 0 || ctx.num_frames_to_encode == 0)
         {
             cerr << "Could not read complete frame from input file" << endl;
             v4l2_buf.m.planes[0].bytesused = 0;
@@ -1260,8 +983,8 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
                 if (ctx.enableROI) {
                     VEnc_imeta_param.flag |= V4L2_ENC_INPUT_ROI_PARAM_FLAG;
                     VEnc_imeta_param.VideoEncROIParams = &VEnc_ROI_params;
-                    /* Update Region of Intrest parameters from ROI params file */
-                    populate_roi_Param(ctx.roi_Param_file, VEnc_imeta_param.VideoEncROIParams);
+                    /* Update Region of Intrest parameters of this frame from ROI params file */
+                    ctx.schedule->getRoiParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncROIParams);
                 }
             }
 
@@ -1295,7 +1018,7 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
                     VEnc_imeta_param.flag |= V4L2_ENC_INPUT_RPS_PARAM_FLAG;
                     VEnc_imeta_param.VideoEncRPSParams = &VEnc_ext_rps_ctrl_params;
                     /* Update external reference picture set parameters from RPS params file */
-                    populate_ext_rps_ctrl_Param(ctx.rps_Param_file, VEnc_imeta_param.VideoEncRPSParams);
+                    ctx.schedule->getRpsParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncRPSParams);
                 }
             }
 
@@ -1305,8 +1028,8 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
                 {
                     /* Update GDR parameters from GDR params file */
                     if (ctx.gdr_start_frame_number == 0xFFFFFFFF)
-                        populate_gdr_Param(ctx.gdr_Param_file, &ctx.gdr_start_frame_number,
-                                    &ctx.gdr_num_frames);
+                        ctx.schedule->getGdrParams(ctx.gdr_param_index++,
+                                    &ctx.gdr_start_frame_number, &ctx.gdr_num_frames);
                     if (ctx.input_frames_queued_count == ctx.gdr_start_frame_number)
                     {
                         ctx.gdr_out_frame_number = ctx.gdr_start_frame_number;
@@ -1324,7 +1047,7 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
                     VEnc_imeta_param.VideoEncExtRCParams = &VEnc_ext_rate_ctrl_params;
 
                     /* Update external rate control parameters from hints params file */
-                    populate_ext_rate_ctrl_Param(ctx.hints_Param_file, VEnc_imeta_param.VideoEncExtRCParams);
+                    ctx.schedule->getRateCtrlParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncExtRCParams);
 
                 }
             }
@@ -1335,6 +1058,7 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
                 ctx.enc->SetInputMetaParams(v4l2_buf.index, VEnc_imeta_param);
                 v4l2_buf.reserved2 = v4l2_buf.index;
             }
+            ctx.input_metadata_index++;
         }
 
         if (ctx.copy_timestamp)
@@ -1428,12 +1152,6 @@ encode_proc(context_t& ctx, int argc, char *argv[])
     /* Set thread name for encoder Output Plane thread. */
     pthread_setname_np(pthread_self(),"EncOutPlane");
 
-    /* Get the parsed encoder runtime parameters */
-    if (ctx.runtime_params_str)
-    {
-        get_next_runtime_param_change_frame(&ctx);
-    }
-
     if (ctx.encoder_pixfmt == V4L2_PIX_FMT_H265)
     {
         TEST_ERROR(ctx.width < 144 || ctx.height < 144, "Height/Width should be"
@@ -1448,25 +1166,66 @@ encode_proc(context_t& ctx, int argc, char *argv[])
     if (ctx.use_gold_crc)
     {
         /* CRC specific initializetion if gold_crc flag is set */
-        ctx.pBitStreamCrc = InitCrc(CRC32_POLYNOMIAL);
-        TEST_ERROR(!ctx.pBitStreamCrc, "InitCrc failed", cleanup);
+        ctx.pBitStreamCrc = NvCrc::createCrc(NV_CRC32_POLYNOMIAL);
+        TEST_ERROR(!ctx.pBitStreamCrc, "Could not create CRC", cleanup);
     }
 
     /* Open input file  for raw yuv */
-    ctx.in_file = new ifstream(ctx.in_file_path);
-    TEST_ERROR(!ctx.in_file->is_open(), "Could not open input file", cleanup);
+    if (ctx.num_prefetch_frames)
+    {
+        /* The frame source opens the file once the output plane is set up. */
+    }
+    else if (ctx.direct_io)
+    {
+        ctx.in_fd = open(ctx.in_file_path, O_RDONLY | O_DIRECT);
+        if (ctx.in_fd < 0 && errno == EINVAL)
+        {
+            /* File system without O_DIRECT support, keep positioned reads. */
+            cerr << "O_DIRECT not supported for input file, using buffered reads"
+                 << endl;
+            ctx.in_fd = open(ctx.in_file_path, O_RDONLY);
+        }
+        TEST_ERROR(ctx.in_fd < 0, "Could not open input file", cleanup);
+        ctx.in_offset = 0;
+    }
+    else
+    {
+        ctx.in_file = new ifstream(ctx.in_file_path);
+        TEST_ERROR(!ctx.in_file->is_open(), "Could not open input file", cleanup);
+    }
 
-    if (!ctx.stats)
+    if (!ctx.stats && ctx.mp4_output)
+    {
+        /* Open output file for the fragmented MP4 stream, one fragment per GOP */
+        ctx.mp4_muxer = NvMp4Muxer::createMp4Muxer(ctx.out_file_path,
+                ctx.encoder_pixfmt, ctx.width, ctx.height, ctx.fps_n, ctx.fps_d);
+        TEST_ERROR(!ctx.mp4_muxer, "Could not open output file", cleanup);
+    }
+    else if (!ctx.stats)
     {
         /* Open output file for encoded bitstream */
-        ctx.out_file = new ofstream(ctx.out_file_path);
-        TEST_ERROR(!ctx.out_file->is_open(), "Could not open output file", cleanup);
+        ctx.out_file = NvBitstreamSink::createBitstreamSink("out",
+                ctx.out_file_path, 8 * 1024 * 1024, ctx.sync_interval);
+        TEST_ERROR(!ctx.out_file, "Could not open output file", cleanup);
     }
 
-    if (ctx.ROI_Param_file_path) {
-        /* Open Region of Intreset(ROI) parameter file when ROI feature enabled */
-        ctx.roi_Param_file = new ifstream(ctx.ROI_Param_file_path);
-        TEST_ERROR(!ctx.roi_Param_file->is_open(), "Could not open roi param file", cleanup);
+    if (ctx.runtime_params || ctx.ROI_Param_file_path ||
+        ctx.RPS_Param_file_path || ctx.GDR_Param_file_path ||
+        ctx.hints_Param_file_path)
+    {
+        /* Parse the runtime parameter changes and the ROI, RPS, GDR and
+           hints parameter files up front, so that the encoder loop only
+           looks up the parameters of each frame */
+        NvEncSchedule::NvEncScheduleSources sources;
+
+        sources.runtime_params = ctx.runtime_params;
+        sources.roi_file_path = ctx.ROI_Param_file_path;
+        sources.rps_file_path = ctx.RPS_Param_file_path;
+        sources.hints_file_path = ctx.hints_Param_file_path;
+        sources.gdr_file_path = ctx.GDR_Param_file_path;
+        ctx.schedule = NvEncSchedule::createEncSchedule(sources,
+                ctx.schedule_cache_path);
+        TEST_ERROR(!ctx.schedule, "Could not parse encoder parameter files", cleanup);
     }
 
     if (ctx.Recon_Ref_file_path) {
@@ -1475,28 +1234,11 @@ encode_proc(context_t& ctx, int argc, char *argv[])
         TEST_ERROR(!ctx.recon_Ref_file->is_open(), "Could not open recon crc reference file", cleanup);
     }
 
-    if (ctx.RPS_Param_file_path) {
-        /* Open Reference Picture set(RPS) specififc reference file when Dynamic RPS feature enabled */
-        ctx.rps_Param_file = new ifstream(ctx.RPS_Param_file_path);
-        TEST_ERROR(!ctx.rps_Param_file->is_open(), "Could not open rps param file", cleanup);
-    }
-
-    if (ctx.GDR_Param_file_path) {
-        /* Open Gradual Decoder Refresh(GDR) parameters reference file when GDR feature enabled */
-        ctx.gdr_Param_file = new ifstream(ctx.GDR_Param_file_path);
-        TEST_ERROR(!ctx.gdr_Param_file->is_open(), "Could not open GDR param file", cleanup);
-    }
-
     if (ctx.GDR_out_file_path) {
         /* Open Gradual Decoder Refresh(GDR) output parameters reference file when GDR feature enabled */
-        ctx.gdr_out_file = new ofstream(ctx.GDR_out_file_path);
-        TEST_ERROR(!ctx.gdr_out_file->is_open(), "Could not open GDR Out file", cleanup);
-    }
-
-    if (ctx.hints_Param_file_path) {
-        /* Open external hints parameters file for when external rate control feature enabled */
-        ctx.hints_Param_file = new ifstream(ctx.hints_Param_file_path);
-        TEST_ERROR(!ctx.hints_Param_file->is_open(), "Could not open hints param file", cleanup);
+        ctx.gdr_out_file = NvBitstreamSink::createBitstreamSink("gdr",
+                ctx.GDR_out_file_path, 8 * 1024 * 1024, ctx.sync_interval);
+        TEST_ERROR(!ctx.gdr_out_file, "Could not open GDR Out file", cleanup);
     }
 
     /* Create NvVideoEncoder object for blocking or non-blocking I/O mode. */
@@ -1931,6 +1673,25 @@ encode_proc(context_t& ctx, int argc, char *argv[])
             TEST_ERROR(true, "Not a valid plane", cleanup);
     }
 
+    /* Start reading frames ahead, now that the frame layout is known. */
+    if (ctx.num_prefetch_frames)
+    {
+        NvBuffer *layout = ctx.enc->output_plane.getNthBuffer(0);
+        uint64_t frame_size = 0;
+
+        for (uint32_t i = 0; i < layout->n_planes; i++)
+        {
+            frame_size += layout->planes[i].fmt.bytesperpixel *
+                layout->planes[i].fmt.width * layout->planes[i].fmt.height;
+        }
+        ctx.frame_source = NvFrameSource::createFrameSource("src0",
+                ctx.in_file_path, *layout, frame_size * ctx.startf,
+                ctx.num_prefetch_frames, ctx.loop_input);
+        TEST_ERROR(!ctx.frame_source, "Could not create frame source", cleanup);
+        /* The frame source already starts at the first frame to encode. */
+        ctx.startf = 0;
+    }
+
     /* Query, Export and Map the capture plane buffers so that we can write
        encoded bitstream data into the buffers */
     ret = ctx.enc->capture_plane.setupPlane(V4L2_MEMORY_MMAP, ctx.num_output_buffers,
@@ -2049,12 +1810,15 @@ encode_proc(context_t& ctx, int argc, char *argv[])
                 frame_size += buffer->planes[i].fmt.bytesperpixel * buffer->planes[i].fmt.width * buffer->planes[i].fmt.height;
             }
             frame_size = frame_size * ctx.startf;
-            ctx.in_file->seekg (frame_size, std::ios::cur);
+            if (ctx.in_fd >= 0)
+                ctx.in_offset += frame_size;
+            else
+                ctx.in_file->seekg (frame_size, std::ios::cur);
             ctx.startf = 0;
         }
 
         /* Read yuv frame data from input file */
-        if (read_video_frame(ctx.in_file, *buffer) < 0 || ctx.num_frames_to_encode == 0)
+        if (read_input_frame(ctx, *buffer) < 0 || ctx.num_frames_to_encode == 0)
         {
             cerr << "Could not read complete frame from input file" << endl;
             v4l2_buf.m.planes[0].bytesused = 0;
@@ -2073,15 +1837,9 @@ encode_proc(context_t& ctx, int argc, char *argv[])
              }
         }
 
-        if (ctx.runtime_params_str &&
-            (ctx.enc->output_plane.getTotalQueuedBuffers() ==
-                ctx.next_param_change_frame))
-        {
-            /* Set runtime configuration parameters */
+        /* Apply the runtime parameter changes of this frame */
+        if (ctx.schedule)
             set_runtime_params(&ctx);
-            if (ctx.runtime_params_str)
-                get_next_runtime_param_change_frame(&ctx);
-        }
 
         /* Encoder supported input metadata specific configurations */
         if (ctx.input_metadata)
@@ -2100,8 +1858,8 @@ encode_proc(context_t& ctx, int argc, char *argv[])
                     VEnc_imeta_param.flag |= V4L2_ENC_INPUT_ROI_PARAM_FLAG;
                     VEnc_imeta_param.VideoEncROIParams = &VEnc_ROI_params;
 
-                    /* Update Region of Intrest parameters from ROI params file */
-                    populate_roi_Param(ctx.roi_Param_file, VEnc_imeta_param.VideoEncROIParams);
+                    /* Update Region of Intrest parameters of this frame from ROI params file */
+                    ctx.schedule->getRoiParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncROIParams);
                 }
             }
 
@@ -2136,7 +1894,7 @@ encode_proc(context_t& ctx, int argc, char *argv[])
                     VEnc_imeta_param.VideoEncRPSParams = &VEnc_ext_rps_ctrl_params;
 
                     /* Update external reference picture set parameters from RPS params file */
-                    populate_ext_rps_ctrl_Param(ctx.rps_Param_file, VEnc_imeta_param.VideoEncRPSParams);
+                    ctx.schedule->getRpsParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncRPSParams);
                 }
             }
 
@@ -2146,8 +1904,8 @@ encode_proc(context_t& ctx, int argc, char *argv[])
                 {
                     /* Update GDR parameters from GDR params file */
                     if (ctx.gdr_start_frame_number == 0xFFFFFFFF)
-                        populate_gdr_Param(ctx.gdr_Param_file, &ctx.gdr_start_frame_number,
-                                    &ctx.gdr_num_frames);
+                        ctx.schedule->getGdrParams(ctx.gdr_param_index++,
+                                    &ctx.gdr_start_frame_number, &ctx.gdr_num_frames);
                     if (ctx.input_frames_queued_count == ctx.gdr_start_frame_number)
                     {
                         ctx.gdr_out_frame_number = ctx.gdr_start_frame_number;
@@ -2165,7 +1923,7 @@ encode_proc(context_t& ctx, int argc, char *argv[])
                     VEnc_imeta_param.VideoEncExtRCParams = &VEnc_ext_rate_ctrl_params;
 
                     /* Update external rate control parameters from hints params file */
-                    populate_ext_rate_ctrl_Param(ctx.hints_Param_file, VEnc_imeta_param.VideoEncExtRCParams);
+                    ctx.schedule->getRateCtrlParams(ctx.input_metadata_index, VEnc_imeta_param.VideoEncExtRCParams);
                 }
             }
 
@@ -2175,6 +1933,7 @@ encode_proc(context_t& ctx, int argc, char *argv[])
                 ctx.enc->SetInputMetaParams(v4l2_buf.index, VEnc_imeta_param);
                 v4l2_buf.reserved2 = v4l2_buf.index;
             }
+            ctx.input_metadata_index++;
         }
 
         if (ctx.copy_timestamp)
@@ -2252,6 +2011,33 @@ encode_proc(context_t& ctx, int argc, char *argv[])
     if (ctx.stats)
     {
         ctx.enc->printProfilingStats(cout);
+        if (ctx.frame_source)
+        {
+            ctx.frame_source->printStats(cout);
+        }
+    }
+
+    if (ctx.out_file)
+    {
+        /* Wait for the writer so that the stats cover the whole stream. */
+        if (ctx.out_file->flush() < 0)
+        {
+            cerr << "Error while writing output file" << endl;
+            error = 1;
+        }
+        ctx.out_file->printStats(cout);
+    }
+
+    if (ctx.mp4_muxer)
+    {
+        /* Write the last fragment before reporting. */
+        if (ctx.mp4_muxer->close() < 0)
+        {
+            cerr << "Error while writing output file" << endl;
+            error = 1;
+        }
+        cout << "Wrote " << ctx.mp4_muxer->getNumSamples() << " samples in " <<
+            ctx.mp4_muxer->getNumFragments() << " MP4 fragments" << endl;
     }
 
 cleanup:
@@ -2268,9 +2054,8 @@ cleanup:
     if (ctx.pBitStreamCrc)
     {
         char *pgold_crc = ctx.gold_crc;
-        Crc *pout_crc= ctx.pBitStreamCrc;
         char StrCrcValue[20];
-        snprintf (StrCrcValue, 20, "%u", pout_crc->CrcValue);
+        snprintf (StrCrcValue, 20, "%u", ctx.pBitStreamCrc->getValue());
         /* Remove CRLF from end of CRC, if present */
         do {
                unsigned int len = strlen(pgold_crc);
@@ -2299,7 +2084,8 @@ cleanup:
             cout << "======================" << endl;
         }
 
-        CloseCrc(&ctx.pBitStreamCrc);
+        delete ctx.pBitStreamCrc;
+        ctx.pBitStreamCrc = NULL;
     }
 
     if(ctx.output_memory_type == V4L2_MEMORY_DMABUF && ctx.enc)
@@ -2326,13 +2112,14 @@ cleanup:
 
     /* Release encoder configuration specific resources. */
     delete ctx.enc;
+    delete ctx.frame_source;
     delete ctx.in_file;
+    if (ctx.in_fd >= 0)
+        close(ctx.in_fd);
     delete ctx.out_file;
-    delete ctx.roi_Param_file;
+    delete ctx.mp4_muxer;
     delete ctx.recon_Ref_file;
-    delete ctx.rps_Param_file;
-    delete ctx.hints_Param_file;
-    delete ctx.gdr_Param_file;
+    delete ctx.schedule;
     delete ctx.gdr_out_file;
 
     free(ctx.in_file_path);
@@ -2343,7 +2130,8 @@ cleanup:
     free(ctx.hints_Param_file_path);
     free(ctx.GDR_Param_file_path);
     free(ctx.GDR_out_file_path);
-    delete ctx.runtime_params_str;
+    free(ctx.runtime_params);
+    free(ctx.schedule_cache_path);
 
     if (ctx.blocking_mode)
     {
@@ -31,6 +31,7 @@
 #include <pthread.h>
 #include "NvLogging.h"
 #include "NvJpegEncoder.h"
+#include "NvJpegEncodePool.h"
 #include "NvBufSurface.h"
 
 typedef struct
@@ -60,6 +61,8 @@ typedef struct
     uint32_t scale_width;
     uint32_t scale_height;
     int quality;
+    int num_encoders;
+    uint32_t num_frames;
 } context_t;
 
 int parse_csv_args(context_t * ctx, int argc, char *argv[]);
@@ -61,7 +61,8 @@ print_help(void)
         "\t-crop <left> <top> <width> <height>  Cropping rectangle for JPEG encoder\n\n"
         "\t-s <loop-count>      Stress test [Default = 1]\n\n"
         "\t-scale_encode <scale_width> <scale_height>  Scale encoding with given scaled width and height encoder\n\n"
-        "\t-quality <value>     Sets the image quality [75(default)]\n\n";
+        "\t-quality <value>     Sets the image quality [75(default)]\n\n"
+        "\t--encoders <num>     Encodes every frame of <in-file> on <num> parallel encoders (works only for --encode-buffer)\n\n";
 }
 
 static int32_t
@@ -188,6 +189,14 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
             CHECK_OPTION_VALUE(argp);
             ctx->quality = atoi(*argp);
         }
+        else if (!strcmp(arg, "--encoders"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->num_encoders = atoi(*argp);
+            CSV_PARSE_CHECK_ERROR(ctx->num_encoders <= 0,
+                    "Number of encoders should be bigger than 0");
+        }
         else if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
         {
             print_help();
@@ -202,6 +211,12 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
                 "--encode-buffer is not supported with NV12 format");
     }
 
+    CSV_PARSE_CHECK_ERROR(ctx->num_encoders && ctx->use_fd,
+            "--encoders works only with --encode-buffer");
+    CSV_PARSE_CHECK_ERROR(ctx->num_encoders &&
+            (ctx->crop_width || ctx->scaled_encode),
+            "--encoders does not support -crop and -scale_encode");
+
     return 0;
 
 error:
@@ -32,7 +32,9 @@
 #include <iostream>
 #include <malloc.h>
 #include <string.h>
+#include <sys/time.h>
 #include <unistd.h>
+#include <vector>
 
 #include "jpeg_encode.h"
 
@@ -56,6 +58,123 @@ set_defaults(context_t * ctx)
     ctx->quality = 75;
 }
 
+/**
+ * Writes the JPEG images of the first pass over the input frames, which
+ * NvJpegEncodePool delivers in submission order.
+ */
+static void
+write_jpeg(const NvJpegEncodeJob &job, void *arg)
+{
+    context_t *ctx = (context_t *) arg;
+
+    if (job.status < 0)
+    {
+        ctx->got_error = true;
+        return;
+    }
+    if (job.sequence < ctx->num_frames)
+    {
+        ctx->out_file->write((char *) job.out_buf, job.out_buf_size);
+    }
+}
+
+/**
+ * Encodes every frame of the input file on a pool of encoders running in
+ * parallel. The JPEG images are written back to back to the output file.
+ * With --perf, the frames are encoded again until PERF_LOOP images are done,
+ * and the throughput is reported.
+ */
+static int
+encode_frames_parallel(context_t& ctx)
+{
+    std::vector<NvBuffer *> frames;
+    NvJpegEncodePool *pool;
+    struct timeval start_time;
+    struct timeval stop_time;
+    uint32_t num_images;
+    int ret = 0;
+
+    while (true)
+    {
+        NvBuffer *buffer = new NvBuffer(V4L2_PIX_FMT_YUV420M, ctx.in_width,
+                ctx.in_height, frames.size());
+
+        buffer->allocateMemory();
+        if (read_video_frame(ctx.in_file, *buffer) < 0)
+        {
+            delete buffer;
+            break;
+        }
+        frames.push_back(buffer);
+    }
+    ctx.num_frames = frames.size();
+    if (ctx.num_frames == 0)
+    {
+        cerr << "Could not read a complete frame from file" << endl;
+        return -1;
+    }
+
+    pool = NvJpegEncodePool::createJpegEncodePool("jpenenc", ctx.num_encoders,
+            0, ctx.in_width * ctx.in_height * 3 / 2, write_jpeg, &ctx);
+    if (!pool)
+    {
+        cerr << "Could not create Jpeg Encode Pool" << endl;
+        ret = -1;
+        goto cleanup;
+    }
+
+    num_images = ctx.num_frames;
+    if (ctx.perf)
+    {
+        pool->enableProfiling();
+        if (num_images < PERF_LOOP)
+            num_images = PERF_LOOP;
+    }
+
+    gettimeofday(&start_time, nullptr);
+    for (uint32_t i = 0; i < num_images; i++)
+    {
+        NvJpegEncodeJob job;
+
+        memset(&job, 0, sizeof(job));
+        job.fd = -1;
+        job.buffer = frames[i % ctx.num_frames];
+        job.color_space = JCS_YCbCr;
+        job.quality = ctx.quality;
+        pool->submit(&job, 1);
+    }
+    pool->waitPending(0);
+    gettimeofday(&stop_time, nullptr);
+
+    if (ctx.perf)
+    {
+        unsigned long total_time_us =
+            (stop_time.tv_sec - start_time.tv_sec) * 1000000 +
+            (stop_time.tv_usec - start_time.tv_usec);
+
+        pool->printProfilingStats(cout);
+        cout << endl;
+        cout << "Encoded " << num_images << " images on " <<
+            pool->getNumEncoders() << " encoders in " << total_time_us <<
+            " us, " << num_images * 1000000.0 / total_time_us <<
+            " images/s" << endl;
+        cout << endl;
+    }
+    if (ctx.got_error)
+    {
+        cerr << "Error while encoding from buffer" << endl;
+        ret = -1;
+    }
+
+cleanup:
+    delete pool;
+    for (uint32_t i = 0; i < frames.size(); i++)
+    {
+        delete frames[i];
+    }
+    return ret;
+}
+
 /**
  * Class NvJPEGEncoder encodes YUV420 image to JPEG.
  * NvJPEGEncoder::encodeFromBuffer() encodes from software buffer memory
@@ -116,6 +235,13 @@ jpeg_encode_proc(context_t& ctx, int argc, char *argv[])
      * Read YUV420 image from file system to CPU buffer, encode by
      * encodeFromBuffer() then write to file system.
      */
+    if (!ctx.use_fd && ctx.num_encoders)
+    {
+        ret = encode_frames_parallel(ctx);
+        TEST_ERROR(ret < 0, "Error while encoding frames in parallel", cleanup);
+        goto cleanup;
+    }
+
     if (!ctx.use_fd)
     {
         NvBuffer buffer(V4L2_PIX_FMT_YUV420M, ctx.in_width,
@@ -219,7 +345,7 @@ jpeg_encode_proc(context_t& ctx, int argc, char *argv[])
 
 
 cleanup:
-    if (ctx.perf)
+    if (ctx.perf && !ctx.num_encoders)
     {
         ctx.jpegenc->printProfilingStats(cout);
     }
@@ -31,6 +31,7 @@
 #include <pthread.h>
 #include "NvLogging.h"
 #include "NvJpegDecoder.h"
+#include "NvMjpegReader.h"
 #include "NvBufSurface.h"
 
 #define NUM_FILE_DECODE 10
@@ -38,6 +39,7 @@
 typedef struct
 {
     NvJPEGDecoder *jpegdec;
+    NvBufferPool *buffer_pool;
 
     char *in_file_path[NUM_FILE_DECODE];
     std::ifstream * in_file[NUM_FILE_DECODE];
@@ -54,6 +56,12 @@ typedef struct
     int  stress_test;
     int num_files;
     int current_file;
+
+    char *batch_in_dir;
+    char *batch_out_dir;
+    char *mjpeg_in_path;
+    char *mjpeg_out_path;
+    int num_decompressors;
 } context_t;
 
 int parse_csv_args(context_t * ctx, int argc, char *argv[]);
@@ -50,15 +50,23 @@ static void
 print_help(void)
 {
     cerr <<
-        "\njpeg-decode num_files <num_files> <in-file1> <out-file1> <in-file2> <out-file2> [OPTIONS]\n\n"
+        "\njpeg-decode num_files <num_files> <in-file1> <out-file1> <in-file2> <out-file2> [OPTIONS]\n"
+        "jpeg-decode --batch-dir <in-dir> <out-dir> [OPTIONS]\n"
+        "jpeg-decode --mjpeg <in-file> <out-file> [OPTIONS]\n\n"
         "OPTIONS:\n"
         "\t-h,--help            Prints this text\n"
-        "\t num_files           number of files to decode simultaneously\n\n"
+        "\t num_files           number of files to decode simultaneously\n"
+        "\t--batch-dir          Decodes the JPEG files of <in-dir> in batches to buffers,\n"
+        "\t                     writing one YUV file per image to <out-dir>\n"
+        "\t--mjpeg              Decodes the images of an MJPEG or concatenated JPEG file\n"
+        "\t                     in batches, appending them to <out-file>\n\n"
         "\t--dbg-level <level>  Sets the debug level [Values 0-3]\n\n"
         "\t--perf               Benchmark decoder performance\n\n"
         "\t--decode-fd          Uses FD as output of decoder [DEFAULT]\n"
         "\t--decode-buffer      Uses buffer as output of decoder\n\n"
-        "\t-s <loop-count>      Stress test [Default = 1]\n\n";
+        "\t-s <loop-count>      Stress test [Default = 1]\n\n"
+        "\t--decompressors <num> Images decoded in parallel with --batch-dir or --mjpeg\n"
+        "\t                     [Default = 1]\n\n";
 }
 
 static int32_t
@@ -97,7 +105,25 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
 
     CSV_PARSE_CHECK_ERROR(argc < 3, "Insufficient arguments");
 
-    if (!strcmp (*argp, "num_files"))
+    if (!strcmp (*argp, "--batch-dir"))
+    {
+        argp++;
+        ctx->num_files = 0;
+        CSV_PARSE_CHECK_ERROR(!*argp, "Input directory not specified");
+        ctx->batch_in_dir = strdup(*argp++);
+        CSV_PARSE_CHECK_ERROR(!*argp, "Output directory not specified");
+        ctx->batch_out_dir = strdup(*argp++);
+    }
+    else if (!strcmp (*argp, "--mjpeg"))
+    {
+        argp++;
+        ctx->num_files = 0;
+        CSV_PARSE_CHECK_ERROR(!*argp, "Input file not specified");
+        ctx->mjpeg_in_path = strdup(*argp++);
+        CSV_PARSE_CHECK_ERROR(!*argp, "Output file not specified");
+        ctx->mjpeg_out_path = strdup(*argp++);
+    }
+    else if (!strcmp (*argp, "num_files"))
     {
         argp++;
         ctx->num_files = atoi (*argp++);
@@ -141,6 +167,14 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
             argp++;
             ctx->use_fd = false;
         }
+        else if (!strcmp(arg, "--decompressors"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->num_decompressors = atoi(*argp++);
+            CSV_PARSE_CHECK_ERROR(ctx->num_decompressors <= 0,
+                    "Number of decompressors should be bigger than 0");
+        }
         else if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
         {
             print_help();
@@ -160,6 +194,10 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
         }
     }
 
+    CSV_PARSE_CHECK_ERROR(ctx->num_decompressors && !ctx->batch_in_dir &&
+            !ctx->mjpeg_in_path,
+            "--decompressors works only with --batch-dir or --mjpeg");
+
     return 0;
 
 error:
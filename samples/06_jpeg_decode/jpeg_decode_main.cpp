@@ -27,12 +27,18 @@
  */
 
 #include "NvUtils.h"
+#include <algorithm>
+#include <dirent.h>
 #include <errno.h>
 #include <fstream>
 #include <iostream>
 #include <malloc.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/time.h>
 #include <unistd.h>
+#include <string>
+#include <vector>
 
 #include "jpeg_decode.h"
 
@@ -43,8 +49,18 @@
 
 #define PERF_LOOP   300
 
+/* Images decoded per batch and decompressor in --batch-dir mode. */
+#define BATCH_IMAGES_PER_DECOMPRESSOR   4
+
 using namespace std;
 
+/* A JPEG image to be decoded in batch mode. */
+typedef struct
+{
+    unsigned char *data;
+    uint32_t size;
+} jpeg_span;
+
 static uint64_t
 get_file_size(ifstream * stream)
 {
@@ -66,6 +82,244 @@ set_defaults(context_t * ctx)
     ctx->current_file = 0;
 }
 
+/**
+ * Reads the JPEG files of a directory, sorted by name.
+ */
+static int
+read_jpeg_dir(const char *dir_path, std::vector<std::string> &names,
+        std::vector<std::vector<unsigned char> > &images)
+{
+    DIR *dir = opendir(dir_path);
+    struct dirent *entry;
+
+    if (!dir)
+    {
+        cerr << "Could not open directory " << dir_path << endl;
+        return -1;
+    }
+    while ((entry = readdir(dir)))
+    {
+        const char *ext = strrchr(entry->d_name, '.');
+
+        if (ext && (!strcasecmp(ext, ".jpg") || !strcasecmp(ext, ".jpeg")))
+        {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        std::string path = std::string(dir_path) + "/" + names[i];
+        ifstream file(path.c_str(), ios::binary);
+
+        images.push_back(std::vector<unsigned char>(
+                    std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>()));
+        if (images.back().empty())
+        {
+            cerr << "Could not read " << path << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Decodes the JPEG images in @a images with NvJPEGDecoder::decodeBatch.
+ * The decoded images are appended to @a out_file if it is set, otherwise
+ * image i is written to ctx.batch_out_dir/names[i].yuv. The output buffers
+ * of a batch are reused by the next one. With --perf, the images are
+ * decoded again until PERF_LOOP images are done and the throughput is
+ * reported.
+ */
+static int
+decode_batch(context_t& ctx, const std::vector<jpeg_span> &images,
+        const std::vector<std::string> &names, ofstream *out_file)
+{
+    std::vector<NvJPEGDecodeJob> jobs;
+    uint32_t num_decompressors = ctx.num_decompressors ? ctx.num_decompressors : 1;
+    uint32_t num_images;
+    uint64_t total_pixels = 0;
+    uint64_t total_decode_us = 0;
+    uint64_t max_decode_us = 0;
+    struct timeval start_time;
+    struct timeval stop_time;
+    int ret = 0;
+
+    num_images = images.size();
+    if (ctx.perf && num_images < PERF_LOOP)
+    {
+        num_images = PERF_LOOP;
+    }
+
+    jobs.resize(num_decompressors * BATCH_IMAGES_PER_DECOMPRESSOR);
+    memset(&jobs[0], 0, jobs.size() * sizeof(NvJPEGDecodeJob));
+
+    gettimeofday(&start_time, nullptr);
+    for (uint32_t first = 0; first < num_images; first += jobs.size())
+    {
+        uint32_t count = std::min<uint32_t>(jobs.size(), num_images - first);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const jpeg_span &image = images[(first + i) % images.size()];
+
+            jobs[i].in_buf = image.data;
+            jobs[i].in_buf_size = image.size;
+        }
+
+        if (ctx.jpegdec->decodeBatch(&jobs[0], count, num_decompressors) < 0)
+        {
+            cerr << "Could not decode batch starting at image " << first << endl;
+            ret = -1;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t index = first + i;
+
+            if (jobs[i].status < 0)
+            {
+                continue;
+            }
+            total_pixels += (uint64_t) jobs[i].width * jobs[i].height;
+            total_decode_us += jobs[i].decode_time_us;
+            max_decode_us = std::max(max_decode_us, jobs[i].decode_time_us);
+
+            /* Only the first pass over the images is written. */
+            if (index >= images.size())
+            {
+                continue;
+            }
+            if (out_file)
+            {
+                if (write_video_frame(out_file, *jobs[i].buffer) < 0)
+                {
+                    cerr << "Could not write image " << index << endl;
+                    ret = -1;
+                }
+            }
+            else
+            {
+                std::string path = std::string(ctx.batch_out_dir) + "/" +
+                    names[index] + ".yuv";
+                ofstream image_file(path.c_str());
+
+                if (write_video_frame(&image_file, *jobs[i].buffer) < 0)
+                {
+                    cerr << "Could not write " << path << endl;
+                    ret = -1;
+                }
+            }
+        }
+    }
+    gettimeofday(&stop_time, nullptr);
+
+    if (ctx.perf)
+    {
+        unsigned long total_time_us =
+            (stop_time.tv_sec - start_time.tv_sec) * 1000000 +
+            (stop_time.tv_usec - start_time.tv_usec);
+
+        cout << endl;
+        cout << "Decoded " << num_images << " images on " << num_decompressors
+            << " decompressors in " << total_time_us << " us: "
+            << num_images * 1000000.0 / total_time_us << " images/s, "
+            << total_pixels / (double) total_time_us << " MPix/s" << endl;
+        cout << "Per image decode time: average "
+            << total_decode_us / num_images << " us, max "
+            << max_decode_us << " us" << endl;
+        cout << endl;
+    }
+
+    for (uint32_t i = 0; i < jobs.size(); i++)
+    {
+        delete jobs[i].buffer;
+    }
+    return ret;
+}
+
+/**
+ * Decodes the JPEG files of ctx.batch_in_dir in batches and writes one
+ * YUV file per image to ctx.batch_out_dir.
+ */
+static int
+decode_batch_dir(context_t& ctx)
+{
+    std::vector<std::string> names;
+    std::vector<std::vector<unsigned char> > files;
+    std::vector<jpeg_span> images;
+
+    if (read_jpeg_dir(ctx.batch_in_dir, names, files) < 0)
+    {
+        return -1;
+    }
+    if (files.empty())
+    {
+        cerr << "No JPEG files in " << ctx.batch_in_dir << endl;
+        return -1;
+    }
+
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        jpeg_span image = { &files[i][0], (uint32_t) files[i].size() };
+        images.push_back(image);
+    }
+    return decode_batch(ctx, images, names, NULL);
+}
+
+/**
+ * Splits the MJPEG file ctx.mjpeg_in_path into JPEG images with
+ * NvMjpegReader, decodes them in batches straight from the mapped file
+ * and appends the decoded images to ctx.mjpeg_out_path.
+ */
+static int
+decode_mjpeg_file(context_t& ctx)
+{
+    NvMjpegReader *reader;
+    std::vector<std::string> names;
+    std::vector<jpeg_span> images;
+    int ret;
+
+    reader = NvMjpegReader::createMjpegReader(ctx.mjpeg_in_path);
+    if (!reader)
+    {
+        cerr << "Could not index " << ctx.mjpeg_in_path << endl;
+        return -1;
+    }
+    if (reader->getNumFrames() == 0)
+    {
+        cerr << "No JPEG images in " << ctx.mjpeg_in_path << endl;
+        delete reader;
+        return -1;
+    }
+
+    ofstream out_file(ctx.mjpeg_out_path);
+    if (!out_file.is_open())
+    {
+        cerr << "Could not open " << ctx.mjpeg_out_path << endl;
+        delete reader;
+        return -1;
+    }
+
+    /* libjpeg only reads the input, so the mapped images are decoded in
+       place without copying them. */
+    for (uint64_t i = 0; i < reader->getNumFrames(); i++)
+    {
+        jpeg_span image = { (unsigned char *) reader->getFrameData(i),
+                            reader->getFrame(i).size };
+        images.push_back(image);
+    }
+    cout << "Split " << images.size() << " images from " <<
+        ctx.mjpeg_in_path << endl;
+
+    ret = decode_batch(ctx, images, names, &out_file);
+    delete reader;
+    return ret;
+}
+
 /**
  * Class NvJPEGDecoder decodes JPEG image to YUV.
  * NvJPEGDecoder::decodeToBuffer() decodes to software buffer memory
@@ -107,12 +361,28 @@ jpeg_decode_proc(context_t& ctx, int argc, char *argv[])
     ctx.jpegdec = NvJPEGDecoder::createJPEGDecoder("jpegdec");
     TEST_ERROR(!ctx.jpegdec, "Could not create Jpeg Decoder", cleanup);
 
+    /* Decoded buffers of the same size reuse the memory of released ones. */
+    ctx.buffer_pool = NvBufferPool::createBufferPool("jpegdec", 2);
+    ctx.jpegdec->setBufferPool(ctx.buffer_pool);
+
     if (ctx.perf)
     {
       iterator_num = PERF_LOOP;
       ctx.jpegdec->enableProfiling();
     }
 
+    if (ctx.batch_in_dir)
+    {
+      ret = decode_batch_dir(ctx);
+      TEST_ERROR(ret < 0, "Could not decode directory", batch_cleanup);
+    }
+
+    if (ctx.mjpeg_in_path)
+    {
+      ret = decode_mjpeg_file(ctx);
+      TEST_ERROR(ret < 0, "Could not decode MJPEG file", batch_cleanup);
+    }
+
     for(i = 0; i < ctx.num_files; i++)
     {
       ctx.in_file_size = get_file_size(ctx.in_file[i]);
@@ -126,10 +396,14 @@ jpeg_decode_proc(context_t& ctx, int argc, char *argv[])
        */
       if (!ctx.use_fd)
       {
-        NvBuffer *buffer;
+        NvBuffer *buffer = NULL;
 
         for (int i = 0; i < iterator_num; ++i)
         {
+          if (buffer)
+          {
+            buffer->unref();
+          }
           ret = ctx.jpegdec->decodeToBuffer(&buffer, ctx.in_buffer,
                 ctx.in_file_size, &pixfmt, &width, &height);
           TEST_ERROR(ret < 0, "Could not decode image", cleanup);
@@ -137,7 +411,7 @@ jpeg_decode_proc(context_t& ctx, int argc, char *argv[])
 
         cout << "Image Resolution - " << width << " x " << height << endl;
         write_video_frame(ctx.out_file[i], *buffer);
-        delete buffer;
+        buffer->unref();
         goto cleanup;
       }
 
@@ -232,7 +506,13 @@ cleanup:
      * Destructors do all the cleanup, unmapping and deallocating buffers
      * and calling v4l2_close on fd
      */
+batch_cleanup:
+    free(ctx.batch_in_dir);
+    free(ctx.batch_out_dir);
+    free(ctx.mjpeg_in_path);
+    free(ctx.mjpeg_out_path);
     delete ctx.jpegdec;
+    delete ctx.buffer_pool;
 
     return -error;
 }
@@ -49,6 +49,10 @@ typedef struct
     NvBufSurfTransform_Flip flip_method;
     NvBufSurfTransform_Inter interpolation_method;
     NvBufSurfTransformRect crop_rect;
+
+    bool use_cpu;
+    uint32_t cpu_threads;
+    char *ref_file_path;
 } context_t;
 
 int parse_csv_args(context_t * ctx, int argc, char *argv[]);
@@ -68,6 +68,8 @@ print_help(void)
         "\tABGR\n"
         "\tXRGB\n"
         "\tARGB\n"
+        "\tRGBA\n"
+        "\tBGRA\n"
         "\tNV12_10LE\n"
         "\tNV12_10LE_709\n"
         "\tNV12_10LE_709_ER\n"
@@ -105,7 +107,11 @@ print_help(void)
         "\t-p,--perf            Calculate performance\n"
         "\t-cr <left> <top> <width> <height> Set the cropping rectangle [Default = 0 0 0 0]\n"
         "\t-fm <method>         Flip method to use [Default = 0]\n"
-        "\t-im <method>         Interpolation method to use [Default = 1]\n\n"
+        "\t-im <method>         Interpolation method to use [Default = 1]\n"
+        "\t--cpu                Transform with NvCpuTransform instead of the hardware\n"
+        "\t--cpu-threads <number> Number of threads per CPU transform [Default = 0, one per online CPU]\n"
+        "\t--ref <file-prefix>  Compare the CPU output with hardware output dumps <file-prefix><thread>\n"
+        "\t                     and report the PSNR of each plane, requires --cpu\n\n"
         "Allowed values for flip method:\n"
         "0 = Identity(no rotation)\n"
         "1 = 90 degree counter-clockwise rotation\n"
@@ -158,6 +164,10 @@ get_color_format(const char* userdefined_fmt)
       //  return NVBUF_COLOR_FORMAT_XRGB;
     if (!strcmp(userdefined_fmt, "ARGB"))
         return NVBUF_COLOR_FORMAT_ARGB;
+    if (!strcmp(userdefined_fmt, "RGBA"))
+        return NVBUF_COLOR_FORMAT_RGBA;
+    if (!strcmp(userdefined_fmt, "BGRA"))
+        return NVBUF_COLOR_FORMAT_BGRA;
     if (!strcmp(userdefined_fmt, "NV12_10LE"))
         return NVBUF_COLOR_FORMAT_NV12_10LE;
     if (!strcmp(userdefined_fmt, "NV12_10LE_709"))
@@ -334,12 +344,34 @@ parse_csv_args(context_t * ctx, int argc, char *argv[])
                     ctx->in_height),
                     "Crop height param out of bounds");
         }
+        else if (!strcmp(arg, "--cpu"))
+        {
+            ctx->use_cpu = true;
+        }
+        else if (!strcmp(arg, "--cpu-threads"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            ctx->cpu_threads = atoi(*argp);
+        }
+        else if (!strcmp(arg, "--ref"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE(argp);
+            free(ctx->ref_file_path);
+            ctx->ref_file_path = strdup(*argp);
+        }
         else
         {
             CSV_PARSE_CHECK_ERROR(ctx->out_file_path, "Unknown option " << arg);
         }
     }
 
+    CSV_PARSE_CHECK_ERROR(ctx->ref_file_path && !ctx->use_cpu,
+            "--ref requires --cpu");
+    CSV_PARSE_CHECK_ERROR(ctx->use_cpu && (ctx->async || ctx->create_session),
+            "--cpu does not support --async and --create-session");
+
     return 0;
 
 error:
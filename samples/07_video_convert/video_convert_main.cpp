@@ -36,6 +36,7 @@
 #include "NvUtils.h"
 #include "video_convert.h"
 #include "NvBufSurface.h"
+#include "NvCpuTransform.h"
 
 using namespace std;
 
@@ -56,6 +57,15 @@ struct thread_context
     bool perf;
     bool async;
     bool create_session;
+
+    /* CPU transform, the buffers are then in CPU memory. */
+    NvCpuTransform *cpu_transform;
+    NvCpuTransform::NvCpuSurface cpu_src;
+    NvCpuTransform::NvCpuSurface cpu_dst;
+    /* Hardware output the CPU output is compared with. */
+    ifstream *ref_file;
+    NvCpuTransform::NvCpuSurface cpu_ref;
+    NvCpuTransform::NvCpuErrorStats error_stats;
 };
 
 /**
@@ -108,6 +118,8 @@ fill_bytes_per_pixel(NvBufSurfaceColorFormat pixel_format, vector<int> *bytes_pe
         case NVBUF_COLOR_FORMAT_ABGR:
         //case NVBUF_COLOR_FORMAT_XRGB:
         case NVBUF_COLOR_FORMAT_ARGB:
+        case NVBUF_COLOR_FORMAT_RGBA:
+        case NVBUF_COLOR_FORMAT_BGRA:
         {
             bytes_per_pixel_fmt->push_back(4);
             break;
@@ -214,12 +226,70 @@ write_video_frame(int dst_dma_fd, ofstream * output_stream, const vector<int> &b
     return 0;
 }
 
+/**
+ * This function reads the video frame from the input file stream
+ * into a frame in CPU memory, plane by plane and row by row as
+ * read_dmabuf does.
+**/
+static int
+read_cpu_frame(NvCpuTransform::NvCpuSurface *surface, ifstream * input_stream)
+{
+    NvBufSurfacePlaneParams *params = &surface->planeParams;
+
+    for (uint32_t plane = 0; plane < params->num_planes; plane++)
+    {
+        uint32_t row_size = params->width[plane] * params->bytesPerPix[plane];
+
+        for (uint32_t i = 0; i < params->height[plane]; i++)
+        {
+            input_stream->read((char *) surface->addr[plane] +
+                    i * params->pitch[plane], row_size);
+            if (!input_stream->good())
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * This function writes a frame in CPU memory into the destination
+ * file, in the layout written by dump_dmabuf.
+**/
+static int
+write_cpu_frame(const NvCpuTransform::NvCpuSurface *surface, ofstream * output_stream)
+{
+    const NvBufSurfacePlaneParams *params = &surface->planeParams;
+
+    for (uint32_t plane = 0; plane < params->num_planes; plane++)
+    {
+        uint32_t row_size = params->width[plane] * params->bytesPerPix[plane];
+
+        for (uint32_t i = 0; i < params->height[plane]; i++)
+        {
+            output_stream->write((const char *) surface->addr[plane] +
+                    i * params->pitch[plane], row_size);
+        }
+    }
+
+    return output_stream->good() ? 0 : -1;
+}
+
 static int
 create_thread_context(context_t *ctx, struct thread_context *tctx, int index)
 {
     int ret = 0;
     string out_file_path(ctx->out_file_path);
 
+    tctx->in_dmabuf_fd = -1;
+    tctx->out_dmabuf_fd = -1;
+    tctx->cpu_transform = nullptr;
+    tctx->ref_file = nullptr;
+    memset(&tctx->cpu_src, 0, sizeof(tctx->cpu_src));
+    memset(&tctx->cpu_dst, 0, sizeof(tctx->cpu_dst));
+    memset(&tctx->cpu_ref, 0, sizeof(tctx->cpu_ref));
+    memset(&tctx->error_stats, 0, sizeof(tctx->error_stats));
+
     tctx->in_file = new ifstream(ctx->in_file_path);
     if (!tctx->in_file->is_open())
     {
@@ -258,23 +328,74 @@ create_thread_context(context_t *ctx, struct thread_context *tctx, int index)
     tctx->output_params.colorFormat = ctx->out_pixfmt;
     tctx->output_params.memtag = NvBufSurfaceTag_VIDEO_CONVERT;
 
-    /* Create the HW Buffer. It is exported as
-    ** an FD by the hardware.
-    */
-    tctx->in_dmabuf_fd = -1;
-    ret = NvBufSurf::NvAllocate(&tctx->input_params, 1, &tctx->in_dmabuf_fd);
-    if (ret)
+    if (ctx->use_cpu)
     {
-        cerr << "Error in creating the input buffer." << endl;
-        goto out;
-    }
+        /* The CPU transform works on frames in CPU memory,
+        ** no HW buffer is needed.
+        */
+        tctx->cpu_transform = NvCpuTransform::createCpuTransform(ctx->cpu_threads);
+        if (!tctx->cpu_transform)
+        {
+            cerr << "Error in creating the CPU transform." << endl;
+            ret = -1;
+            goto out;
+        }
 
-    tctx->out_dmabuf_fd = -1;
-    ret = NvBufSurf::NvAllocate(&tctx->output_params, 1, &tctx->out_dmabuf_fd);
-    if (ret)
+        ret = NvCpuTransform::NvAllocate(ctx->in_width, ctx->in_height,
+                ctx->in_pixfmt, &tctx->cpu_src);
+        if (ret)
+        {
+            cerr << "Error in creating the input CPU frame." << endl;
+            goto out;
+        }
+
+        ret = NvCpuTransform::NvAllocate(ctx->out_width, ctx->out_height,
+                ctx->out_pixfmt, &tctx->cpu_dst);
+        if (ret)
+        {
+            cerr << "Error in creating the output CPU frame." << endl;
+            goto out;
+        }
+
+        if (ctx->ref_file_path)
+        {
+            string ref_file_path(ctx->ref_file_path);
+
+            tctx->ref_file = new ifstream(ref_file_path + to_string(index));
+            if (!tctx->ref_file->is_open())
+            {
+                cerr << "Could not open reference file" << endl;
+                ret = -1;
+                goto out;
+            }
+
+            ret = NvCpuTransform::NvAllocate(ctx->out_width, ctx->out_height,
+                    ctx->out_pixfmt, &tctx->cpu_ref);
+            if (ret)
+            {
+                cerr << "Error in creating the reference CPU frame." << endl;
+                goto out;
+            }
+        }
+    }
+    else
     {
-        cerr << "Error in creating the output buffer." << endl;
-        goto out;
+        /* Create the HW Buffer. It is exported as
+        ** an FD by the hardware.
+        */
+        ret = NvBufSurf::NvAllocate(&tctx->input_params, 1, &tctx->in_dmabuf_fd);
+        if (ret)
+        {
+            cerr << "Error in creating the input buffer." << endl;
+            goto out;
+        }
+
+        ret = NvBufSurf::NvAllocate(&tctx->output_params, 1, &tctx->out_dmabuf_fd);
+        if (ret)
+        {
+            cerr << "Error in creating the output buffer." << endl;
+            goto out;
+        }
     }
 
     /* Store th bpp required for each color
@@ -352,6 +473,67 @@ destory_thread_context(context_t *ctx, struct thread_context *tctx)
     {
         NvBufSurf::NvDestroy(tctx->out_dmabuf_fd);
     }
+
+    if (tctx->ref_file)
+    {
+        delete tctx->ref_file;
+    }
+    NvCpuTransform::NvDestroy(&tctx->cpu_src);
+    NvCpuTransform::NvDestroy(&tctx->cpu_dst);
+    NvCpuTransform::NvDestroy(&tctx->cpu_ref);
+    delete tctx->cpu_transform;
+}
+
+/**
+ * This function runs the conversion loop with the CPU transform and,
+ * when reference dumps of the hardware output are given, accumulates
+ * the error of each output frame against them.
+**/
+static void *
+do_cpu_video_convert(struct thread_context *tctx)
+{
+    int ret = 0;
+    int count = tctx->perf ? PERF_LOOP : 1;
+
+    while (true)
+    {
+        ret = read_cpu_frame(&tctx->cpu_src, tctx->in_file);
+        if (ret < 0)
+        {
+            cout << "File read complete." << endl;
+            break;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            ret = tctx->cpu_transform->NvTransform(&tctx->transform_params,
+                    &tctx->cpu_src, &tctx->cpu_dst);
+            if (ret)
+            {
+                cerr << "Error in CPU transformation." << endl;
+                goto out;
+            }
+        }
+        ret = write_cpu_frame(&tctx->cpu_dst, tctx->out_file);
+        if (ret)
+        {
+            cerr << "Error in dumping the output raw buffer." << endl;
+            break;
+        }
+        if (tctx->ref_file)
+        {
+            ret = read_cpu_frame(&tctx->cpu_ref, tctx->ref_file);
+            if (ret < 0)
+            {
+                cerr << "Reference file has fewer frames than the input." << endl;
+                break;
+            }
+            NvCpuTransform::NvAccumulateError(&tctx->cpu_dst, &tctx->cpu_ref,
+                    &tctx->error_stats);
+        }
+    }
+
+out:
+    return nullptr;
 }
 
 static void *
@@ -364,6 +546,11 @@ do_video_convert(void *arg)
     NvBufSurfTransformConfigParams config_params;
     memset(&config_params,0,sizeof(NvBufSurfTransformConfigParams));
 
+    if (tctx->cpu_transform)
+    {
+        return do_cpu_video_convert(tctx);
+    }
+
     if (tctx->create_session)
     {
         NvBufSurfTransformSetSessionParams (&config_params);
@@ -460,7 +647,7 @@ main(int argc, char *argv[])
     }
 
     tids = new pthread_t[ctx.num_thread];
-    thread_ctxs = new struct thread_context[ctx.num_thread];
+    thread_ctxs = new struct thread_context[ctx.num_thread]();
 
     for (uint32_t i = 0; i < ctx.num_thread; ++i)
     {
@@ -503,6 +690,34 @@ main(int argc, char *argv[])
         cout << endl;
     }
 
+    if (ctx.use_cpu)
+    {
+        cout << "CPU transform used " << thread_ctxs[0].cpu_transform->getNumThreads()
+             << " threads per conversion, vector kernels: "
+             << thread_ctxs[0].cpu_transform->getSimdName() << endl;
+    }
+
+    if (ctx.ref_file_path)
+    {
+        for (uint32_t i = 0; i < ctx.num_thread; ++i)
+        {
+            NvCpuTransform::NvCpuErrorStats *stats = &thread_ctxs[i].error_stats;
+
+            if (!stats->num_planes)
+            {
+                cout << "Thread " << i << ": no frame compared with the reference" << endl;
+                continue;
+            }
+            cout << "Thread " << i << " PSNR against the reference:";
+            for (uint32_t plane = 0; plane < stats->num_planes; ++plane)
+            {
+                cout << " plane " << plane << " = "
+                     << NvCpuTransform::getPsnr(stats, plane) << " dB";
+            }
+            cout << endl;
+        }
+    }
+
 cleanup:
 
     for (uint32_t i = 0; i < ctx.num_thread; ++i)
@@ -512,6 +727,7 @@ cleanup:
 
     free(ctx.in_file_path);
     free(ctx.out_file_path);
+    free(ctx.ref_file_path);
 
     delete []tids;
     delete []thread_ctxs;
@@ -35,11 +35,13 @@
 
 #include <NvEglRenderer.h>
 #include <NvJpegEncoder.h>
+#include <NvJpegEncodePool.h>
 #include "NvBufSurface.h"
 
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <getopt.h>
 #include <iostream>
 #include <fstream>
@@ -56,6 +58,7 @@ static Size2D<uint32_t> CAPTURE_SIZE (1920, 1080);
 static bool    DO_STAT = false;
 static bool    VERBOSE_ENABLE = false;
 static bool    DO_JPEG_ENCODE = true;
+static uint32_t JPEG_ENCODERS = 1;
 
 #define JPEG_BUFFER_SIZE    (CAPTURE_SIZE.area() * 3 / 2)
 
@@ -92,6 +95,12 @@ protected:
 
     virtual bool processV4L2Fd(int32_t fd, uint64_t frameNumber) = 0;
 
+    /* Returns the dmabuf the next frame is copied to, created on first use. */
+    virtual int *nextDmabuf()
+    {
+        return &m_dmabuf;
+    }
+
     OutputStream* m_stream;
     UniqueObj<FrameConsumer> m_consumer;
     int m_dmabuf;
@@ -140,21 +149,22 @@ bool ConsumerThread::threadExecute()
 
         /* If we don't already have a buffer, create one from this image.
            Otherwise, just blit to our buffer. */
-        if (m_dmabuf == -1)
+        int *dmabuf = nextDmabuf();
+        if (*dmabuf == -1)
         {
-            m_dmabuf = iNativeBuffer->createNvBuffer(iEglOutputStream->getResolution(),
-                                                     NVBUF_COLOR_FORMAT_YUV420,
-                                                     NVBUF_LAYOUT_PITCH);
-            if (m_dmabuf == -1)
+            *dmabuf = iNativeBuffer->createNvBuffer(iEglOutputStream->getResolution(),
+                                                    NVBUF_COLOR_FORMAT_YUV420,
+                                                    NVBUF_LAYOUT_PITCH);
+            if (*dmabuf == -1)
                 CONSUMER_PRINT("\tFailed to create NvBuffer\n");
         }
-        else if (iNativeBuffer->copyToNvBuffer(m_dmabuf) != STATUS_OK)
+        else if (iNativeBuffer->copyToNvBuffer(*dmabuf) != STATUS_OK)
         {
             ORIGINATE_ERROR("Failed to copy frame to NvBuffer.");
         }
 
         /* Process frame. */
-        processV4L2Fd(m_dmabuf, iFrame->getNumber());
+        processV4L2Fd(*dmabuf, iFrame->getNumber());
     }
 
     CONSUMER_PRINT("Done.\n");
@@ -226,6 +236,8 @@ bool PreviewConsumerThread::processV4L2Fd(int32_t fd, uint64_t frameNumber)
 /*******************************************************************************
  * Capture Consumer thread:
  *   Read frames from the OutputStream and save it to JPEG file.
+ *   Frames are encoded in parallel by a pool of JPEG encoders, each frame
+ *   being copied to its own dmabuf until its JPEG file is written.
  ******************************************************************************/
 class CaptureConsumerThread : public ConsumerThread
 {
@@ -237,25 +249,33 @@ private:
     bool threadInitialize();
     bool threadShutdown();
     bool processV4L2Fd(int32_t fd, uint64_t frameNumber);
+    int *nextDmabuf();
 
-    NvJPEGEncoder *m_JpegEncoder;
-    unsigned char *m_OutputBuffer;
+    static void writeJpeg(const NvJpegEncodeJob &job, void *arg);
+
+    NvJpegEncodePool *m_JpegEncodePool;
+    std::vector<int> m_dmabufs;
+    uint64_t m_numFrames;
 };
 
 CaptureConsumerThread::CaptureConsumerThread(OutputStream *stream) :
     ConsumerThread(stream),
-    m_JpegEncoder(NULL),
-    m_OutputBuffer(NULL)
+    m_JpegEncodePool(NULL),
+    m_numFrames(0)
 {
 }
 
 CaptureConsumerThread::~CaptureConsumerThread()
 {
-    if (m_JpegEncoder)
-        delete m_JpegEncoder;
+    /* Waits for the pending frames before their dmabufs are destroyed. */
+    if (m_JpegEncodePool)
+        delete m_JpegEncodePool;
 
-    if (m_OutputBuffer)
-        delete [] m_OutputBuffer;
+    for (uint32_t i = 0; i < m_dmabufs.size(); i++)
+    {
+        if (m_dmabufs[i] != -1)
+            NvBufSurf::NvDestroy(m_dmabufs[i]);
+    }
 }
 
 bool CaptureConsumerThread::threadInitialize()
@@ -263,44 +283,69 @@ bool CaptureConsumerThread::threadInitialize()
     if (!ConsumerThread::threadInitialize())
         return false;
 
-    m_OutputBuffer = new unsigned char[JPEG_BUFFER_SIZE];
-    if (!m_OutputBuffer)
-        return false;
+    /* Two frames per encoder keep the encoders busy while frames are
+       copied and written. */
+    m_JpegEncodePool = NvJpegEncodePool::createJpegEncodePool("jpenenc",
+            JPEG_ENCODERS, 2 * JPEG_ENCODERS, JPEG_BUFFER_SIZE, writeJpeg, NULL);
+    if (!m_JpegEncodePool)
+        ORIGINATE_ERROR("Failed to create JPEG encode pool.");
 
-    m_JpegEncoder = NvJPEGEncoder::createJPEGEncoder("jpenenc");
-    if (!m_JpegEncoder)
-        ORIGINATE_ERROR("Failed to create JPEGEncoder.");
+    m_dmabufs.assign(2 * JPEG_ENCODERS, -1);
 
     if (DO_STAT)
-        m_JpegEncoder->enableProfiling();
+        m_JpegEncodePool->enableProfiling();
 
     return true;
 }
 
 bool CaptureConsumerThread::threadShutdown()
 {
+    m_JpegEncodePool->waitPending(0);
+
     if (DO_STAT)
-        m_JpegEncoder->printProfilingStats();
+        m_JpegEncodePool->printProfilingStats();
 
     return ConsumerThread::threadShutdown();
 }
 
+int *CaptureConsumerThread::nextDmabuf()
+{
+    /* The oldest pending frame uses the dmabuf of the next one. */
+    m_JpegEncodePool->waitPending(m_dmabufs.size() - 1);
+
+    return &m_dmabufs[m_numFrames++ % m_dmabufs.size()];
+}
+
 bool CaptureConsumerThread::processV4L2Fd(int32_t fd, uint64_t frameNumber)
+{
+    NvJpegEncodeJob job;
+
+    memset(&job, 0, sizeof(job));
+    job.fd = fd;
+    job.color_space = JCS_YCbCr;
+    job.quality = 75;
+    job.user_data = (void *) (uintptr_t) frameNumber;
+
+    return m_JpegEncodePool->submit(&job, 1) == 0;
+}
+
+void CaptureConsumerThread::writeJpeg(const NvJpegEncodeJob &job, void *)
 {
     char filename[FILENAME_MAX];
-    sprintf(filename, "output%03u.jpg", (unsigned) frameNumber);
+    sprintf(filename, "output%03u.jpg", (unsigned) (uintptr_t) job.user_data);
+
+    if (job.status < 0)
+    {
+        CONSUMER_PRINT("Failed to encode %s\n", filename);
+        return;
+    }
 
     std::ofstream *outputFile = new std::ofstream(filename);
     if (outputFile)
     {
-        unsigned long size = JPEG_BUFFER_SIZE;
-        unsigned char *buffer = m_OutputBuffer;
-        m_JpegEncoder->encodeFromFd(fd, JCS_YCbCr, &buffer, size);
-        outputFile->write((char *)buffer, size);
+        outputFile->write((char *)job.out_buf, job.out_buf_size);
         delete outputFile;
     }
-
-    return true;
 }
 
 /**
@@ -461,6 +506,7 @@ static void printHelp()
            "  --fps         Frame per second       [Default 30]\n"
            "  --sensor-mode Sensor mode            [Default 0]\n"
            "  --disable-jpg Disable JPEG encode    [Default Enable]\n"
+           "  --encoders    Parallel JPEG encoders [Default 1]\n"
            "  -s            Enable profiling\n"
            "  -v            Enable verbose message\n"
            "  -h            Print this help\n");
@@ -476,6 +522,7 @@ static bool parseCmdline(int argc, char * argv[])
         OPTION_FPS,
         OPTION_SENSOR_MODE,
         OPTION_DISABLE_JPEG_ENCODE,
+        OPTION_JPEG_ENCODERS,
     };
 
     static struct option longOptions[] =
@@ -486,6 +533,7 @@ static bool parseCmdline(int argc, char * argv[])
         { "fps",         1, NULL, OPTION_FPS },
         { "sensor-mode", 1, NULL, OPTION_SENSOR_MODE },
         { "disable-jpg", 0, NULL, OPTION_DISABLE_JPEG_ENCODE },
+        { "encoders",    1, NULL, OPTION_JPEG_ENCODERS },
         { 0 },
     };
 
@@ -525,6 +573,11 @@ static bool parseCmdline(int argc, char * argv[])
             case OPTION_DISABLE_JPEG_ENCODE:
                 DO_JPEG_ENCODE = false;
                 break;
+            case OPTION_JPEG_ENCODERS:
+                if (sscanf(optarg, "%u", &t) != 1 || t == 0)
+                    return false;
+                JPEG_ENCODERS = t;
+                break;
             case 's':
                 DO_STAT = true;
                 break;
@@ -32,6 +32,7 @@
 
 #include <Argus/Argus.h>
 #include <NvVideoEncoder.h>
+#include <NvMp4Muxer.h>
 #include <NvApplicationProfiler.h>
 
 #include "NvBufSurface.h"
@@ -75,6 +76,7 @@ static uint32_t     ENCODER_PIXFMT = V4L2_PIX_FMT_H264;
 static bool         DO_STAT = false;
 static bool         VERBOSE_ENABLE = false;
 static bool         DO_CPU_PROCESS = false;
+static bool         OUTPUT_MP4 = false;
 
 /* Debug print macros */
 #define PRODUCER_PRINT(...) printf("PRODUCER: " __VA_ARGS__)
@@ -197,6 +199,7 @@ private:
     OutputStream* m_stream;
     NvVideoEncoder *m_VideoEncoder;
     std::ofstream *m_outputFile;
+    NvMp4Muxer *m_mp4Muxer;
     bool m_gotError;
 };
 
@@ -204,6 +207,7 @@ ConsumerThread::ConsumerThread(OutputStream* stream) :
         m_stream(stream),
         m_VideoEncoder(NULL),
         m_outputFile(NULL),
+        m_mp4Muxer(NULL),
         m_gotError(false)
 {
 }
@@ -215,6 +219,9 @@ ConsumerThread::~ConsumerThread()
 
     if (m_outputFile)
         delete m_outputFile;
+
+    if (m_mp4Muxer)
+        delete m_mp4Muxer;
 }
 
 bool ConsumerThread::threadInitialize()
@@ -224,9 +231,20 @@ bool ConsumerThread::threadInitialize()
         ORIGINATE_ERROR("Failed to create video m_VideoEncoderoder");
 
     /* Create output file */
-    m_outputFile = new std::ofstream(OUTPUT_FILENAME.c_str());
-    if (!m_outputFile)
-        ORIGINATE_ERROR("Failed to open output file.");
+    if (OUTPUT_MP4)
+    {
+        m_mp4Muxer = NvMp4Muxer::createMp4Muxer(OUTPUT_FILENAME.c_str(),
+                ENCODER_PIXFMT, STREAM_SIZE.width(), STREAM_SIZE.height(),
+                DEFAULT_FPS, 1);
+        if (!m_mp4Muxer)
+            ORIGINATE_ERROR("Failed to open output file.");
+    }
+    else
+    {
+        m_outputFile = new std::ofstream(OUTPUT_FILENAME.c_str());
+        if (!m_outputFile)
+            ORIGINATE_ERROR("Failed to open output file.");
+    }
 
     /* Stream on */
     int e = m_VideoEncoder->output_plane.setStreamStatus(true);
@@ -262,6 +280,23 @@ bool ConsumerThread::threadInitialize()
     return true;
 }
 
+/* Stamp the frame with its sensor timestamp. The encoder copies it to the
+   capture plane buffer, where the MP4 muxer picks it up. */
+static void setFrameTimestamp(Buffer *buffer, struct v4l2_buffer &v4l2_buf)
+{
+    IBuffer *iBuffer = interface_cast<IBuffer>(buffer);
+    const ICaptureMetadata *iMetadata =
+        interface_cast<const ICaptureMetadata>(iBuffer->getMetadata());
+
+    if (!iMetadata)
+        return;
+
+    uint64_t timestamp = iMetadata->getSensorTimestamp() / 1000;
+    v4l2_buf.flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+    v4l2_buf.timestamp.tv_sec = timestamp / 1000000;
+    v4l2_buf.timestamp.tv_usec = timestamp % 1000000;
+}
+
 bool ConsumerThread::threadExecute()
 {
     IBufferOutputStream* stream = interface_cast<IBufferOutputStream>(m_stream);
@@ -279,6 +314,8 @@ bool ConsumerThread::threadExecute()
     {
         v4l2_buf.index = bufferIndex;
         Buffer* buffer = stream->acquireBuffer();
+        if (OUTPUT_MP4)
+            setFrameTimestamp(buffer, v4l2_buf);
         /* Convert Argus::Buffer to DmaBuffer and queue into v4l2 encoder */
         DmaBuffer *dmabuf = DmaBuffer::fromArgusBuffer(buffer);
         CHECK_ERROR(m_VideoEncoder->output_plane.qBuffer(v4l2_buf, dmabuf));
@@ -371,6 +408,9 @@ bool ConsumerThread::threadExecute()
             }
         }
 
+        if (OUTPUT_MP4)
+            setFrameTimestamp(buffer, v4l2_buf);
+
         /* Push the frame into V4L2. */
         CHECK_ERROR(m_VideoEncoder->output_plane.qBuffer(v4l2_buf, dmabuf));
     }
@@ -399,6 +439,10 @@ bool ConsumerThread::threadExecute()
 
 bool ConsumerThread::threadShutdown()
 {
+    /* Write the last fragment of the MP4 file */
+    if (m_mp4Muxer && m_mp4Muxer->close() < 0)
+        ORIGINATE_ERROR("Failed to write MP4 file");
+
     return true;
 }
 
@@ -496,8 +540,18 @@ bool ConsumerThread::encoderCapturePlaneDqCallback(struct v4l2_buffer *v4l2_buf,
         ORIGINATE_ERROR("Failed to dequeue buffer from encoder capture plane");
     }
 
-    thiz->m_outputFile->write((char *) buffer->planes[0].data,
-                              buffer->planes[0].bytesused);
+    if (thiz->m_mp4Muxer)
+    {
+        if (buffer->planes[0].bytesused &&
+            thiz->m_mp4Muxer->writeBuffer(v4l2_buf, buffer) < 0)
+        {
+            thiz->abort();
+            ORIGINATE_ERROR("Failed to write encoded frame to MP4 file");
+        }
+    }
+    else
+        thiz->m_outputFile->write((char *) buffer->planes[0].data,
+                                  buffer->planes[0].bytesused);
 
     if (thiz->m_VideoEncoder->capture_plane.qBuffer(*v4l2_buf, NULL) < 0)
     {
@@ -563,6 +617,10 @@ static bool execute()
     /* Configure the OutputStream to use the EGLImage BufferType */
     iStreamSettings->setBufferType(BUFFER_TYPE_EGL_IMAGE);
 
+    /* The MP4 output is timestamped with the sensor timestamps */
+    if (OUTPUT_MP4)
+        iStreamSettings->setMetadataEnable(true);
+
     /* Create the OutputStream */
     UniqueObj<OutputStream> outputStream(iCaptureSession->createOutputStream(streamSettings.get()));
     IBufferOutputStream *iBufferOutputStream = interface_cast<IBufferOutputStream>(outputStream);
@@ -687,6 +745,7 @@ static void printHelp()
            "  -r        Set output resolution WxH [Default 640x480]\n"
            "  -f        Set output filename [Default output.h264]\n"
            "  -t        Set encoder type H264 or H265 [Default H264]\n"
+           "  -m        Write fragmented MP4 output [Default output.mp4]\n"
            "  -d        Set capture duration [Default 5 seconds]\n"
            "  -i        Set camera index [Default 0]\n"
            "  -s        Enable profiling\n"
@@ -699,7 +758,7 @@ static bool parseCmdline(int argc, char **argv)
 {
     int c, w, h;
     bool haveFilename = false;
-    while ((c = getopt(argc, argv, "r:f:t:d:i:s::v::c::h")) != -1)
+    while ((c = getopt(argc, argv, "r:f:t:d:i:ms::v::c::h")) != -1)
     {
         switch (c)
         {
@@ -740,10 +799,15 @@ static bool parseCmdline(int argc, char **argv)
             case 'c':
                 DO_CPU_PROCESS = true;
                 break;
+            case 'm':
+                OUTPUT_MP4 = true;
+                break;
             default:
                 return false;
         }
     }
+    if (OUTPUT_MP4 && !haveFilename)
+        OUTPUT_FILENAME = "output.mp4";
     return true;
 }
 
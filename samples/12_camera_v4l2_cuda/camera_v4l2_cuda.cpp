@@ -43,8 +43,6 @@
 
 #include "camera_v4l2_cuda.h"
 
-#define MJPEG_EOS_SEARCH_SIZE 4096
-
 static bool quit = false;
 
 using namespace std;
@@ -62,6 +60,7 @@ print_usage(void)
            "\t-r\t\tSet renderer frame rate (30 fps by default)\n"
            "\t-n\t\tSave the n-th frame before VIC processing\n"
            "\t-c\t\tEnable CUDA aglorithm (draw a black box in the upper left corner)\n"
+           "\t-i\t\tReplay an MJPEG file in a loop instead of capturing from the device\n"
            "\t-v\t\tEnable verbose message\n"
            "\t-h\t\tPrint this usage\n\n"
            "\tNOTE: It runs infinitely until you terminate it with <ctrl+c>\n");
@@ -78,7 +77,7 @@ parse_cmdline(context_t * ctx, int argc, char **argv)
         exit(EXIT_SUCCESS);
     }
 
-    while ((c = getopt(argc, argv, "d:s:f:r:n:cvh")) != -1)
+    while ((c = getopt(argc, argv, "d:s:f:r:n:ci:vh")) != -1)
     {
         switch (c)
         {
@@ -122,6 +121,9 @@ parse_cmdline(context_t * ctx, int argc, char **argv)
             case 'c':
                 ctx->enable_cuda = true;
                 break;
+            case 'i':
+                ctx->replay_file = optarg;
+                break;
             case 'v':
                 ctx->enable_verbose = true;
                 break;
@@ -189,7 +191,8 @@ get_nvbuff_color_fmt(unsigned int v4l2_pixfmt)
 }
 
 static bool
-save_frame_to_file(context_t * ctx, struct v4l2_buffer * buf)
+save_frame_to_file(context_t * ctx, const unsigned char * start,
+        unsigned int size)
 {
     int file;
 
@@ -199,8 +202,7 @@ save_frame_to_file(context_t * ctx, struct v4l2_buffer * buf)
     if (-1 == file)
         ERROR_RETURN("Failed to open file for frame saving");
 
-    if (-1 == write(file, ctx->g_buff[buf->index].start,
-                ctx->g_buff[buf->index].size))
+    if (-1 == write(file, start, size))
     {
         close(file);
         ERROR_RETURN("Failed to write frame into file");
@@ -284,6 +286,32 @@ camera_initialize(context_t * ctx)
     return true;
 }
 
+static bool
+replay_initialize(context_t * ctx)
+{
+    /* Split the file into JPEG images once, they are decoded straight
+       from the mapped file */
+    ctx->replay_reader = NvMjpegReader::createMjpegReader(ctx->replay_file);
+    if (!ctx->replay_reader)
+        ERROR_RETURN("Failed to open MJPEG file %s", ctx->replay_file);
+    if (ctx->replay_reader->getNumFrames() == 0)
+        ERROR_RETURN("No JPEG images in %s", ctx->replay_file);
+
+    const NvMjpegReader::NvMjpegFrame &frame = ctx->replay_reader->getFrame(0);
+    if (frame.width == 0 || frame.height == 0)
+        ERROR_RETURN("No frame size in the first JPEG image");
+
+    ctx->cam_pixfmt = V4L2_PIX_FMT_MJPEG;
+    ctx->cam_w = frame.width;
+    ctx->cam_h = frame.height;
+
+    INFO("Replaying %lu MJPEG frames (%d x %d) from %s",
+            (unsigned long) ctx->replay_reader->getNumFrames(),
+            ctx->cam_w, ctx->cam_h, ctx->replay_file);
+
+    return true;
+}
+
 static bool
 display_initialize(context_t * ctx)
 {
@@ -312,7 +340,12 @@ display_initialize(context_t * ctx)
 static bool
 init_components(context_t * ctx)
 {
-    if (!camera_initialize(ctx))
+    if (ctx->replay_file)
+    {
+        if (!replay_initialize(ctx))
+            ERROR_RETURN("Failed to initialize MJPEG replay");
+    }
+    else if (!camera_initialize(ctx))
         ERROR_RETURN("Failed to initialize camera device");
 
     if (!display_initialize(ctx))
@@ -439,7 +472,7 @@ prepare_buffers_mjpeg(context_t * ctx)
         ERROR_RETURN("Failed to create NvBuffer");
 
     ctx->capture_dmabuf = false;
-    if (!request_camera_buff_mmap(ctx))
+    if (!ctx->replay_file && !request_camera_buff_mmap(ctx))
         ERROR_RETURN("Failed to set up camera buff");
 
     INFO("Succeed in preparing mjpeg buffers");
@@ -558,6 +591,107 @@ cuda_postprocess(context_t *ctx, int fd)
     return true;
 }
 
+static bool
+decode_mjpeg_frame(context_t * ctx,
+        NvBufSurf::NvCommonTransformParams &transform_params,
+        unsigned char * start, unsigned int size)
+{
+    int fd = 0;
+    uint32_t width, height, pixfmt;
+
+    /* Decoding MJPEG frame */
+    if (ctx->jpegdec->decodeToFd(fd, start, size, pixfmt, width, height) < 0)
+        ERROR_RETURN("Cannot decode MJPEG");
+
+    /* Convert the decoded buffer to YUV420P */
+    if (NvBufSurf::NvTransform(&transform_params, fd, ctx->render_dmabuf_fd))
+        ERROR_RETURN("Failed to convert the buffer");
+
+    return true;
+}
+
+static void
+init_transform_params(context_t * ctx,
+        NvBufSurf::NvCommonTransformParams &transform_params)
+{
+    transform_params.src_top = 0;
+    transform_params.src_left = 0;
+    transform_params.src_width = ctx->cam_w;
+    transform_params.src_height = ctx->cam_h;
+    transform_params.dst_top = 0;
+    transform_params.dst_left = 0;
+    transform_params.dst_width = ctx->cam_w;
+    transform_params.dst_height = ctx->cam_h;
+    transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
+    transform_params.flip = NvBufSurfTransform_None;
+    transform_params.filter = NvBufSurfTransformInter_Algo3;
+}
+
+static bool
+start_replay(context_t * ctx)
+{
+    struct sigaction sig_action;
+    NvBufSurf::NvCommonTransformParams transform_params = {0};
+    bool ret = true;
+
+    /* Register a shuwdown handler to ensure
+       a clean shutdown if user types <ctrl+c> */
+    sig_action.sa_handler = signal_handle;
+    sigemptyset(&sig_action.sa_mask);
+    sig_action.sa_flags = 0;
+    sigaction(SIGINT, &sig_action, NULL);
+
+    ctx->jpegdec = NvJPEGDecoder::createJPEGDecoder("jpegdec");
+    if (!ctx->jpegdec)
+        ERROR_RETURN("Failed to create JPEG decoder");
+
+    init_transform_params(ctx, transform_params);
+
+    /* Enable render profiling information */
+    ctx->renderer->enableProfiling();
+
+    /* The renderer paces the replay at the configured frame rate */
+    while (!quit)
+    {
+        const unsigned char *start;
+        uint32_t size;
+
+        start = ctx->replay_reader->getNextFrame(size);
+        if (!start)
+        {
+            /* End of file, the reader is rewound to loop the replay */
+            continue;
+        }
+
+        ctx->frame++;
+
+        /* Save the n-th frame to file */
+        if (ctx->frame == ctx->save_n_frame)
+            save_frame_to_file(ctx, start, size);
+
+        /* libjpeg only reads the image, so it is decoded in place */
+        if (!decode_mjpeg_frame(ctx, transform_params,
+                    (unsigned char *) start, size))
+        {
+            ret = false;
+            break;
+        }
+
+        cuda_postprocess(ctx, ctx->render_dmabuf_fd);
+
+        /* Preview */
+        ctx->renderer->render(ctx->render_dmabuf_fd);
+    }
+
+    /* Print profiling information when replay stops */
+    ctx->renderer->printProfilingStats();
+
+    delete ctx->jpegdec;
+    ctx->jpegdec = NULL;
+
+    return ret;
+}
+
 static bool
 start_capture(context_t * ctx)
 {
@@ -576,17 +710,7 @@ start_capture(context_t * ctx)
         ctx->jpegdec = NvJPEGDecoder::createJPEGDecoder("jpegdec");
 
     /* Init the NvBufferTransformParams */
-    transform_params.src_top = 0;
-    transform_params.src_left = 0;
-    transform_params.src_width = ctx->cam_w;
-    transform_params.src_height = ctx->cam_h;
-    transform_params.dst_top = 0;
-    transform_params.dst_left = 0;
-    transform_params.dst_width = ctx->cam_w;
-    transform_params.dst_height = ctx->cam_h;
-    transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
-    transform_params.flip = NvBufSurfTransform_None;
-    transform_params.filter = NvBufSurfTransformInter_Algo3;
+    init_transform_params(ctx, transform_params);
 
     /* Enable render profiling information */
     ctx->renderer->enableProfiling();
@@ -614,36 +738,25 @@ start_capture(context_t * ctx)
 
             /* Save the n-th frame to file */
             if (ctx->frame == ctx->save_n_frame)
-                save_frame_to_file(ctx, &v4l2_buf);
+                save_frame_to_file(ctx, ctx->g_buff[v4l2_buf.index].start,
+                        ctx->g_buff[v4l2_buf.index].size);
 
             if (ctx->cam_pixfmt == V4L2_PIX_FMT_MJPEG) {
-                int fd = 0;
-                uint32_t width, height, pixfmt;
-                unsigned int i = 0;
-                unsigned int eos_search_size = MJPEG_EOS_SEARCH_SIZE;
+                unsigned char *start = ctx->g_buff[v4l2_buf.index].start;
                 unsigned int bytesused = v4l2_buf.bytesused;
-                uint8_t *p;
+                uint32_t size;
 
                 /* v4l2_buf.bytesused may have padding bytes for alignment
-                   Search for EOF to get exact size */
-                if (eos_search_size > bytesused)
-                    eos_search_size = bytesused;
-                for (i = 0; i < eos_search_size; i++) {
-                    p =(uint8_t *)(ctx->g_buff[v4l2_buf.index].start + bytesused);
-                    if ((*(p-2) == 0xff) && (*(p-1) == 0xd9)) {
-                        break;
-                    }
-                    bytesused--;
+                   Walk the markers to get the exact size */
+                size = NvMjpegReader::parseFrame(start, start + bytesused);
+                if (size == 0) {
+                    WARN("No complete JPEG image in camera buffer");
+                } else {
+                    bytesused = size;
                 }
 
-                /* Decoding MJPEG frame */
-                if (ctx->jpegdec->decodeToFd(fd, ctx->g_buff[v4l2_buf.index].start,
-                    bytesused, pixfmt, width, height) < 0)
-                    ERROR_RETURN("Cannot decode MJPEG");
-
-                /* Convert the decoded buffer to YUV420P */
-                if (NvBufSurf::NvTransform(&transform_params, fd, ctx->render_dmabuf_fd))
-                    ERROR_RETURN("Failed to convert the buffer");
+                if (!decode_mjpeg_frame(ctx, transform_params, start, bytesused))
+                    return false;
             } else {
                 NvBufSurface *pSurf = NULL;
                 if (-1 == NvBufSurfaceFromFd(ctx->g_buff[v4l2_buf.index].dmabuff_fd,
@@ -729,6 +842,12 @@ main(int argc, char *argv[])
                 "Failed to prepare v4l2 buffs");
     }
 
+    if (ctx.replay_file) {
+        CHECK_ERROR(start_replay(&ctx), cleanup,
+                "Failed to replay MJPEG file");
+        goto cleanup;
+    }
+
     CHECK_ERROR(start_stream(&ctx), cleanup,
             "Failed to start streaming");
 
@@ -742,6 +861,8 @@ cleanup:
     if (ctx.cam_fd > 0)
         close(ctx.cam_fd);
 
+    delete ctx.replay_reader;
+
     if (ctx.renderer != NULL)
         delete ctx.renderer;
 
@@ -28,6 +28,7 @@
 
 #include <queue>
 #include "NvJpegDecoder.h"
+#include "NvMjpegReader.h"
 #include "NvBufSurface.h"
 
 #define V4L2_BUFFERS_NUM    4
@@ -91,6 +92,10 @@ typedef struct
     /* MJPEG decoding */
     NvJPEGDecoder *jpegdec;
 
+    /* MJPEG file replay */
+    const char * replay_file;
+    NvMjpegReader *replay_reader;
+
     /* Verbose option */
     bool enable_verbose;
 
@@ -27,8 +27,12 @@
  */
 
 #include "NvVideoDecoder.h"
+#include "NvV4l2DQPoller.h"
 #include "NvVideoConverter.h"
 #include "NvEglRenderer.h"
+#include "NvBitstreamReader.h"
+#include "NvIvfReader.h"
+#include "NvContainerReader.h"
 #include <queue>
 #include <fstream>
 #include <pthread.h>
@@ -48,6 +52,9 @@ typedef struct
 
     char *in_file_path;
     std::ifstream *in_file;
+    NvBitstreamReader *bs_reader;
+    NvIvfReader *ivf_reader;
+    NvContainerReader *container_reader;
 
     char *out_file_path;
     std::ofstream *out_file;
@@ -70,6 +77,8 @@ typedef struct
     bool disable_dpb;
 
     bool input_nalu;
+    bool input_au;
+    bool input_container;
 
     bool copy_timestamp;
     bool flag_copyts;
@@ -92,19 +101,26 @@ typedef struct
     pthread_cond_t queue_cond;
 
     sem_t pollthread_sema; // Polling thread waits on this to be signalled to issue Poll
-    sem_t decoderthread_sema; // Decoder thread waits on this to be signalled to continue q/dq loop
-    pthread_t dec_pollthread; // Polling thread, created if running in non-blocking mode.
+    pthread_t dec_pollthread; // Polling thread, created in reactor mode.
+    NvV4l2DQPoller *dq_poller; // Dequeues both decoder planes, created if running in non-blocking mode outside reactor mode.
     pthread_t decode_thread; // Current thread, decoding stream.
     pthread_t dec_capture_loop; // Decoder capture thread, created if running in blocking mode.
     bool got_error;
     bool got_eos;
-    bool vp9_file_header_flag;
-    bool vp8_file_header_flag;
     int dst_dma_fd;
     int dmabuff_fd[MAX_BUFFERS];
     int numCapBuffers;
     int loop_count;
     int blocking_mode; // Set to true if running in blocking mode
+    bool reactor_mode; // Set to true to decode all streams with a pool of reactor threads
+    uint32_t reactor_threads; // Number of reactor threads, 0 for one per online CPU
+    struct reactor_worker_t *reactor_worker; // Reactor thread the poll thread signals, NULL outside reactor mode
+    bool input_eos; // Set once all the input is queued, in non-blocking mode
+    bool mock_device; // Set to true to decode on the V4L2 loopback mock device
+    uint16_t metrics_port; // Localhost TCP port serving live metrics, 0 to disable
+    char *metrics_socket; // Unix socket serving live metrics, NULL to disable
+    char *metrics_file; // File live metrics are appended to as JSON lines, NULL to disable
+    uint32_t metrics_interval; // Interval between two metrics samples, in milliseconds
 } context_t;
 
 typedef struct
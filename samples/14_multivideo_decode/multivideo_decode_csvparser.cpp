@@ -64,7 +64,8 @@ print_help(void)
             "\tH264\n"
             "\tH265\n"
             "\tMPEG2\n"
-            "\tMPEG4\n\n"
+            "\tMPEG4\n"
+            "\tAV1\n\n"
             "OPTIONS:\n"
             "\tNOTE: Currently multivideo_decode to be only run with --disable-rendering Mandatory\n"
             "\t-h,--help            Prints this text\n"
@@ -90,12 +91,21 @@ print_help(void)
             "\t1 = Skip non-reference frames\n"
             "\t2 = Decode only key frames\n\n"
             "\t--input-nalu         Input to the decoder will be nal units\n"
-            "\t--input-chunks       Input to the decoder will be a chunk of bytes [Default]\n\n"
+            "\t--input-au           Input to the decoder will be access units (for H264/H265)\n"
+            "\t--input-chunks       Input to the decoder will be a chunk of bytes [Default]\n"
+            "\t--input-container    Input file is MP4 or Matroska, the decoder gets its samples with their timestamps\n\n"
             "\t--copy-timestamp <st> <fps> Enable copy timestamp with start timestamp(st) in seconds for decode fps(fps) (for input-nalu mode)\n"
             "\tNOTE: copy-timestamp used to demonstrate how timestamp can be associated with an individual H264/H265 frame to achieve video-synchronization.\n"
             "\t      currenly only supported for H264 & H265 video encode using MM APIs and is only for demonstration purpose.\n"
             "\t--report-metadata    Enable metadata reporting\n\n"
             "\t--blocking-mode <val> Set blocking mode, 0 is non-blocking, 1 for blocking (Default) \n\n"
+            "\t--reactor <threads>  Decode all streams in non-blocking mode from a fixed pool of threads\n"
+            "\t                     instead of a decode thread per stream [threads = 0 for one per CPU]\n\n"
+            "\t--mock-device        Decode on the V4L2 loopback mock device, for scalability tests without hardware\n\n"
+            "\t--metrics-port <port> Serve live metrics on http://127.0.0.1:<port>/metrics (Prometheus) and /metrics.json\n"
+            "\t--metrics-socket <path> Serve the live metrics over HTTP on a Unix socket instead\n"
+            "\t--metrics-file <path> Append a JSON line of live metrics to <path> every interval\n"
+            "\t--metrics-interval <ms> Live metrics sampling interval, FPS and latencies are over 5 intervals [Default = 1000]\n\n"
             "\t--report-input-metadata  Enable metadata reporting for input header parsing error\n\n"
             "\t-v4l2-memory-out-plane <num>       Specify memory type to be used on Output Plane [1 = V4L2_MEMORY_MMAP, 2 = V4L2_MEMORY_USERPTR], Default = V4L2_MEMORY_MMAP\n\n"
             "\t-v4l2-memory-cap-plane <num>       Specify memory type to be used on Capture Plane [1 = V4L2_MEMORY_MMAP, 2 = V4L2_MEMORY_DMABUF], Default = V4L2_MEMORY_DMABUF\n\n"
@@ -118,6 +128,8 @@ get_decoder_type(char *arg)
         return V4L2_PIX_FMT_MPEG2;
     if (!strcmp(arg, "MPEG4"))
         return V4L2_PIX_FMT_MPEG4;
+    if (!strcmp(arg, "AV1"))
+        return V4L2_PIX_FMT_AV1;
     return 0;
 }
 
@@ -288,11 +300,31 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
             {
                 CSV_PARSE_CHECK_ERROR(ctx[i]->decoder_pixfmt == V4L2_PIX_FMT_VP8, "VP8 does not support --input-nalu");
                 CSV_PARSE_CHECK_ERROR(ctx[i]->decoder_pixfmt == V4L2_PIX_FMT_VP9, "VP9 does not support --input-nalu");
+                CSV_PARSE_CHECK_ERROR(ctx[i]->decoder_pixfmt == V4L2_PIX_FMT_AV1, "AV1 does not support --input-nalu");
                 ctx[i]->input_nalu = true;
+                ctx[i]->input_au = false;
+                ctx[i]->input_container = false;
+            }
+            else if (!strcmp(arg, "--input-au"))
+            {
+                CSV_PARSE_CHECK_ERROR(ctx[i]->decoder_pixfmt != V4L2_PIX_FMT_H264 &&
+                        ctx[i]->decoder_pixfmt != V4L2_PIX_FMT_H265,
+                        "--input-au is supported only for H264/H265");
+                ctx[i]->input_nalu = true;
+                ctx[i]->input_au = true;
+                ctx[i]->input_container = false;
             }
             else if (!strcmp(arg, "--input-chunks"))
             {
                 ctx[i]->input_nalu = false;
+                ctx[i]->input_au = false;
+                ctx[i]->input_container = false;
+            }
+            else if (!strcmp(arg, "--input-container"))
+            {
+                ctx[i]->input_nalu = false;
+                ctx[i]->input_au = false;
+                ctx[i]->input_container = true;
             }
             else if (!strcmp(arg, "--copy-timestamp"))
             {
@@ -381,6 +413,53 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
                 ctx[i]->blocking_mode = atoi(*argp);
                 CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
             }
+            else if (!strcmp(arg, "--mock-device"))
+            {
+                ctx[i]->mock_device = true;
+            }
+            else if (!strcmp(arg, "--metrics-port"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                CSV_PARSE_CHECK_ERROR(atoi(*argp) <= 0 || atoi(*argp) > 65535,
+                        "Metrics port should be in 1-65535");
+                ctx[i]->metrics_port = atoi(*argp);
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-socket"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                ctx[i]->metrics_socket = *argp;
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-file"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                ctx[i]->metrics_file = *argp;
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-interval"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                CSV_PARSE_CHECK_ERROR(atoi(*argp) <= 0,
+                        "Metrics interval should be > 0");
+                ctx[i]->metrics_interval = atoi(*argp);
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--reactor"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                CSV_PARSE_CHECK_ERROR(atoi(*argp) < 0,
+                        "Number of reactor threads should be >= 0");
+                ctx[i]->reactor_mode = true;
+                ctx[i]->reactor_threads = atoi(*argp);
+                ctx[i]->blocking_mode = 0;
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
             else
             {
                 CSV_PARSE_CHECK_ERROR(ctx[i]->in_file_path, "Unknown option " << arg);
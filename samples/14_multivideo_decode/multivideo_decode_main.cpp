@@ -27,7 +27,9 @@
  */
 
 #include "NvApplicationProfiler.h"
+#include "NvMetricsRegistry.h"
 #include "NvUtils.h"
+#include "NvV4l2MockDevice.h"
 #include <errno.h>
 #include <fstream>
 #include <iostream>
@@ -38,6 +40,8 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/resource.h>
+#include <vector>
 
 #include "multivideo_decode.h"
 
@@ -56,26 +60,14 @@
 #define IS_NAL_UNIT_START1(buffer_ptr) (!buffer_ptr[0] && !buffer_ptr[1] && \
         (buffer_ptr[2] == 1))
 
-#define H264_NAL_UNIT_CODED_SLICE  1
-#define H264_NAL_UNIT_CODED_SLICE_IDR  5
-
 #define HEVC_NUT_TRAIL_N  0
 #define HEVC_NUT_RASL_R  9
 #define HEVC_NUT_BLA_W_LP  16
 #define HEVC_NUT_CRA_NUT  21
 
-#define IVF_FILE_HDR_SIZE   32
-#define IVF_FRAME_HDR_SIZE  12
 
 #define MAX_STREAM 32
 
-#define IS_H264_NAL_CODED_SLICE(buffer_ptr) \
-        ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE)
-#define IS_H264_NAL_CODED_SLICE_IDR(buffer_ptr) \
-        ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE_IDR)
-
-#define GET_H265_NAL_UNIT_TYPE(buffer_ptr) ((buffer_ptr[0] & 0x7E) >> 1)
-
 #define IS_SEMIPLANAR_FMT(pixel_format) ((pixel_format == NVBUF_COLOR_FORMAT_NV12) || \
         (pixel_format == NVBUF_COLOR_FORMAT_NV12_ER) || \
         (pixel_format == NVBUF_COLOR_FORMAT_NV12_709) || \
@@ -90,8 +82,13 @@ using namespace std;
 static void
 print_stats()
 {
+    float total_fps = 0;
+
     for ( int i = 0 ; i < num_files ; i++ )
     {
+        if (!stream_stats[i]->filename)
+            continue;
+        total_fps += stream_stats[i]->data.average_fps;
         cout << "*****************************************" << endl;
         cout << "Stream = " << stream_stats[i]->filename << endl;
         cout << "Total Profiling time = " <<
@@ -107,74 +104,61 @@ print_stats()
             stream_stats[i]->data.max_latency_usec << endl;
         cout << "*****************************************" << endl;
     }
+    cout << "Total FPS of " << num_files << " streams = " << total_fps << endl;
 }
 
 /**
-  * Read the input NAL unit for h264/H265/Mpeg2/Mpeg4 decoder.
+  * Read the input NAL unit for h264/H265/Mpeg2/Mpeg4 decoder, or the whole
+  * access unit for h264/H265 if access unit input is enabled.
   *
-  * @param stream            : Input stream
-  * @param buffer            : NvBuffer pointer
-  * @param parse_buffer      : parse buffer pointer
-  * @param parse_buffer_size : chunk size
-  * @param ctx               : Decoder context
+  * @param reader : Bitstream reader of the input file
+  * @param buffer : NvBuffer pointer
+  * @param ctx    : Decoder context
   */
 static int
-read_decoder_input_nalu(ifstream * stream, NvBuffer * buffer,
-        char *parse_buffer, streamsize parse_buffer_size, context_t * ctx)
+read_decoder_input_nalu(NvBitstreamReader * reader, NvBuffer * buffer,
+        context_t * ctx)
 {
-    /* Length is the size of the buffer in bytes */
-    char *buffer_ptr = (char *) buffer->planes[0].data;
+    const NvBitstreamReader::NvNalUnit *nalu;
+    const uint8_t *nal_header;
     int h265_nal_unit_type;
-    char *stream_ptr;
-    bool nalu_found = false;
-
-    streamsize bytes_read;
-    streamsize stream_initial_pos = stream->tellg();
-
-    stream->read(parse_buffer, parse_buffer_size);
-    bytes_read = stream->gcount();
+    int ret;
 
-    if (bytes_read == 0)
+    /* Copy the next indexed NAL unit or access unit, start codes included,
+       in one go */
+    if (ctx->input_au)
     {
-        return buffer->planes[0].bytesused = 0;
+        ret = reader->readNextAccessUnit(buffer, ctx->decoder_pixfmt, &nalu);
+        /* An access unit larger than the buffer is queued one NAL unit at
+           a time instead, as in NAL unit input mode. */
+        if (ret < 0)
+            ret = reader->readNextNalUnit(buffer, &nalu);
     }
-
-    /* Find the first NAL unit in the buffer */
-    stream_ptr = parse_buffer;
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
+    else
+        ret = reader->readNextNalUnit(buffer, &nalu);
+    if (ret < 0)
     {
-        nalu_found = IS_NAL_UNIT_START(stream_ptr) ||
-                    IS_NAL_UNIT_START1(stream_ptr);
-        if (nalu_found)
-        {
-            break;
-        }
-        stream_ptr++;
+        cerr << "Could not read nal unit from file. File corrupted" << endl;
+        return -1;
     }
 
-    /* Reached end of buffer but could not find NAL unit */
-    if (!nalu_found)
+    if (!nalu)
     {
-        cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-        return -1;
+        /* End of stream, bytesused is 0 and the reader is rewound */
+        return 0;
     }
 
-    memcpy(buffer_ptr, stream_ptr, 4);
-    buffer_ptr += 4;
-    buffer->planes[0].bytesused = 4;
-    stream_ptr += 4;
-
+    nal_header = &nalu->header;
     if (ctx->copy_timestamp)
     {
       if (ctx->decoder_pixfmt == V4L2_PIX_FMT_H264) {
-        if ((IS_H264_NAL_CODED_SLICE(stream_ptr)) ||
-            (IS_H264_NAL_CODED_SLICE_IDR(stream_ptr)))
+        if ((IS_H264_NAL_CODED_SLICE(nal_header)) ||
+            (IS_H264_NAL_CODED_SLICE_IDR(nal_header)))
           ctx->flag_copyts = true;
         else
           ctx->flag_copyts = false;
       } else if (ctx->decoder_pixfmt == V4L2_PIX_FMT_H265) {
-        h265_nal_unit_type = GET_H265_NAL_UNIT_TYPE(stream_ptr);
+        h265_nal_unit_type = GET_H265_NAL_UNIT_TYPE(nal_header);
         if ((h265_nal_unit_type >= HEVC_NUT_TRAIL_N &&
                 h265_nal_unit_type <= HEVC_NUT_RASL_R) ||
             (h265_nal_unit_type >= HEVC_NUT_BLA_W_LP &&
@@ -185,30 +169,7 @@ read_decoder_input_nalu(ifstream * stream, NvBuffer * buffer,
       }
     }
 
-    /* Copy bytes till the next NAL unit is found */
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
-    {
-        if (IS_NAL_UNIT_START(stream_ptr) || IS_NAL_UNIT_START1(stream_ptr))
-        {
-            streamsize seekto = stream_initial_pos +
-                    (stream_ptr - parse_buffer);
-            if(stream->eof())
-            {
-                stream->clear();
-            }
-            stream->seekg(seekto, stream->beg);
-            return 0;
-        }
-        *buffer_ptr = *stream_ptr;
-        buffer_ptr++;
-        stream_ptr++;
-        buffer->planes[0].bytesused++;
-    }
-
-    /* Reached end of buffer but could not find NAL unit */
-    cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-    return -1;
+    return 0;
 }
 
 
@@ -237,7 +198,7 @@ read_decoder_input_chunk(ifstream * stream, NvBuffer * buffer)
 }
 
 /**
-  * Read the input chunks for Vp8/Vp9 decoder.
+  * Read the next frame for Vp8/Vp9/AV1 decoder.
   *
   * @param ctx    : Decoder context
   * @param buffer : NvBuffer pointer
@@ -245,45 +206,46 @@ read_decoder_input_chunk(ifstream * stream, NvBuffer * buffer)
 static int
 read_vpx_decoder_input_chunk(context_t *ctx, NvBuffer * buffer)
 {
-    ifstream *stream = ctx->in_file;
-    int Framesize;
-    unsigned char *bitstreambuffer = (unsigned char *)buffer->planes[0].data;
-    if (ctx->vp9_file_header_flag == 0)
-    {
-        stream->read((char *) buffer->planes[0].data, IVF_FILE_HDR_SIZE);
-        if (stream->gcount() !=  IVF_FILE_HDR_SIZE)
-        {
-            cerr << "Couldn't read IVF FILE HEADER" << endl;
-            return -1;
-        }
-        if (!((bitstreambuffer[0] == 'D') && (bitstreambuffer[1] == 'K') &&
-                    (bitstreambuffer[2] == 'I') && (bitstreambuffer[3] == 'F')))
-        {
-            cerr << "It's not a valid IVF file \n" << endl;
-            return -1;
-        }
-        cout << "It's a valid IVF file" << endl;
-        ctx->vp9_file_header_flag = 1;
-    }
-    stream->read((char *) buffer->planes[0].data, IVF_FRAME_HDR_SIZE);
-    if (!stream->gcount())
+    /* Copy the next indexed frame, without its IVF frame header, in one
+       go. On end of stream bytesused is 0 and the reader is rewound. */
+    if (ctx->ivf_reader->readNextFrame(buffer) < 0)
     {
-        cout << "End of stream" << endl;
-        return 0;
+        cerr << "Could not read IVF frame from file. File corrupted" << endl;
+        return -1;
     }
-    if (stream->gcount() != IVF_FRAME_HDR_SIZE)
+    return 0;
+}
+
+/**
+  * Read the next sample of an MP4 or Matroska file.
+  *
+  * @param ctx      : Decoder context
+  * @param buffer   : NvBuffer pointer
+  * @param v4l2_buf : V4L2 buffer to carry the sample timestamp
+  */
+static int
+read_decoder_input_sample(context_t *ctx, NvBuffer * buffer,
+        struct v4l2_buffer * v4l2_buf)
+{
+    const NvContainerReader::NvContainerSample *sample;
+    uint64_t pts;
+
+    /* Copy the next indexed sample in one go, with start codes written
+       over the NAL unit lengths. On end of stream bytesused is 0 and the
+       reader is rewound. */
+    if (ctx->container_reader->readNextSample(buffer, &sample) < 0)
     {
-        cerr << "Couldn't read IVF FRAME HEADER" << endl;
+        cerr << "Could not read sample from file. File corrupted" << endl;
         return -1;
     }
-    Framesize = (bitstreambuffer[3]<<24) + (bitstreambuffer[2]<<16) +
-        (bitstreambuffer[1]<<8) + bitstreambuffer[0];
-    buffer->planes[0].bytesused = Framesize;
-    stream->read((char *) buffer->planes[0].data, Framesize);
-    if (stream->gcount() != Framesize)
+
+    if (sample)
     {
-        cerr << "Couldn't read Framesize" << endl;
-        return -1;
+        /* Samples cut by an edit list may come before time 0. */
+        pts = sample->pts > 0 ? sample->pts : 0;
+        v4l2_buf->flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+        v4l2_buf->timestamp.tv_sec = pts / (MICROSECOND_UNIT);
+        v4l2_buf->timestamp.tv_usec = pts % (MICROSECOND_UNIT);
     }
     return 0;
 }
@@ -657,7 +619,36 @@ error:
 }
 
 /**
-  * Decoder polling thread loop function.
+  * Streams driven by one reactor worker thread.
+  */
+typedef struct reactor_worker_t
+{
+    context_t **streams;
+    uint32_t num_streams;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    vector<context_t *> ready; // Streams whose device poll returned, under lock
+    int error;
+} reactor_worker_t;
+
+/**
+  * Hands a stream over to its reactor worker thread.
+  *
+  * @param worker : Reactor worker
+  * @param ctx    : Decoder context with something to dequeue
+  */
+static void
+reactor_notify(reactor_worker_t *worker, context_t *ctx)
+{
+    pthread_mutex_lock(&worker->lock);
+    worker->ready.push_back(ctx);
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/**
+  * Decoder polling thread loop function, in reactor mode.
   *
   * @param args : void arguments
   */
@@ -695,7 +686,7 @@ static void *decoder_pollthread_fcn(void *arg)
 
         /* We can check the devicepoll.resp_events bitmask to see
            which events are set. */
-        sem_post(&ctx->decoderthread_sema);
+        reactor_notify(ctx->reactor_worker, ctx);
     }
     return NULL;
 }
@@ -925,9 +916,8 @@ set_defaults(context_t ** ctx,fps_stats **stream_stats)
         ctx[i]->fps = 30;
         ctx[i]->output_plane_mem_type = V4L2_MEMORY_MMAP;
         ctx[i]->capture_plane_mem_type = V4L2_MEMORY_DMABUF;
-        ctx[i]->vp9_file_header_flag = 0;
-        ctx[i]->vp8_file_header_flag = 0;
         ctx[i]->stress_test = 1;
+        ctx[i]->metrics_interval = 1000;
         ctx[i]->copy_timestamp = false;
         ctx[i]->flag_copyts = false;
         ctx[i]->disable_rendering = true;
@@ -943,304 +933,460 @@ set_defaults(context_t ** ctx,fps_stats **stream_stats)
 }
 
 /**
-  * Decode processing function for non-blocking mode.
+  * Reads the next input chunk into a dequeued output plane buffer and
+  * queues it again, in non-blocking mode.
   *
-  * @param ctx               : Decoder context
-  * @param eos               : end of stream
-  * @param current_file      : current file
-  * @param current_loop      : iterator count
-  * @param nalu_parse_buffer : input parsed nal unit
+  * @param ctx      : Decoder context
+  * @param v4l2_buf : dequeued V4L2 buffer
+  * @param buffer   : dequeued NvBuffer
+  * @param eos      : end of stream, set once the empty buffer is queued
+  * @return 0 on success, -1 on error
   */
-static bool
-decoder_proc_nonblocking(context_t &ctx, bool eos, uint32_t current_file,
-                    char *nalu_parse_buffer)
+static int
+decoder_requeue_output_buffer(context_t &ctx, struct v4l2_buffer &v4l2_buf,
+                              NvBuffer *buffer, bool &eos)
 {
-     /*  NOTE: In non-blocking mode, we will have this function do below things:
-              1) Issue signal to PollThread so it starts Poll and wait until we are signalled.
-              2) After we are signalled, it means there is something to dequeue, either output plane
-                 or capture plane or there's an event.
-              3) Try dequeuing from all three and then act appropriately.
-              4) After enqueuing go back to the same loop. */
-
-    /* Since all the output plane buffers have been queued, we first need to
-       dequeue a buffer from output plane before we can read new data into it
-       and queue it again. */
-    int allow_DQ = true;
     int ret = 0;
-    struct v4l2_buffer temp_buf;
-    struct v4l2_event ev;
 
-    while (!ctx.got_error && !ctx.dec->isInError())
+    if ((v4l2_buf.flags & V4L2_BUF_FLAG_ERROR) && ctx.enable_input_metadata)
     {
-        struct v4l2_buffer v4l2_output_buf;
-        struct v4l2_plane output_planes[MAX_PLANES];
+        v4l2_ctrl_videodec_inputbuf_metadata dec_input_metadata;
 
-        struct v4l2_buffer v4l2_capture_buf;
-        struct v4l2_plane capture_planes[MAX_PLANES];
+        /* Get the decoder input metadata.
+           Refer V4L2_CID_MPEG_VIDEODEC_INPUT_METADATA */
+        ret = ctx.dec->getInputMetadata(v4l2_buf.index, dec_input_metadata);
+        if (ret == 0)
+        {
+            ret = report_input_metadata(&ctx, &dec_input_metadata);
+            if (ret == -1)
+            {
+                cerr << "Error with input stream header parsing" << endl;
+            }
+        }
+    }
 
-        NvBuffer *output_buffer = NULL;
-        NvBuffer *capture_buffer = NULL;
+    if (eos)
+    {
+        /* Got End Of Stream, no more queueing of buffers on OUTPUT plane. */
+        return 0;
+    }
 
-        memset(&v4l2_output_buf, 0, sizeof(v4l2_output_buf));
-        memset(output_planes, 0, sizeof(output_planes));
-        v4l2_output_buf.m.planes = output_planes;
+    if (ctx.input_container)
+    {
+        /* read the next sample with its timestamp. */
+        ret = read_decoder_input_sample(&ctx, buffer, &v4l2_buf);
+        if (ret != 0)
+            cerr << "Couldn't read sample" << endl;
+    }
+    else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+            (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
+            (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
+            (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
+    {
+        if (ctx.input_nalu)
+        {
+            /* read the input nal unit. */
+            ret = read_decoder_input_nalu(ctx.bs_reader, buffer, &ctx);
+            if (ret < 0)
+            {
+                abort(&ctx);
+                return -1;
+            }
+        }
+        else
+        {
+            /* read the input chunks. */
+            read_decoder_input_chunk(ctx.in_file, buffer);
+        }
+    }
+    else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+            ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        ret = read_vpx_decoder_input_chunk(&ctx, buffer);
+        if (ret != 0)
+            cerr << "Couldn't read IVF frame" << endl;
+    }
+    v4l2_buf.m.planes[0].bytesused = buffer->planes[0].bytesused;
 
-        memset(&v4l2_capture_buf, 0, sizeof(v4l2_capture_buf));
-        memset(capture_planes, 0, sizeof(capture_planes));
-        v4l2_capture_buf.m.planes = capture_planes;
+    if (ctx.input_nalu && ctx.copy_timestamp && ctx.flag_copyts)
+    {
+        /* Update the timestamp. */
+        v4l2_buf.flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+        ctx.timestamp += ctx.timestampincr;
+        v4l2_buf.timestamp.tv_sec = ctx.timestamp / (MICROSECOND_UNIT);
+        v4l2_buf.timestamp.tv_usec = ctx.timestamp % (MICROSECOND_UNIT);
+    }
+
+    /* enqueue a buffer for output plane. */
+    ret = ctx.dec->output_plane.qBuffer(v4l2_buf, NULL);
+    if (ret < 0)
+    {
+        cerr << "Error Qing buffer at output plane" << endl;
+        abort(&ctx);
+        return -1;
+    }
+    if (v4l2_buf.m.planes[0].bytesused == 0)
+    {
+        eos = true;
+        cout << "Input file read complete" << endl;
+    }
+    return 0;
+}
 
-        /* Call for SetPollInterrupt.
-           Refer V4L2_CID_MPEG_SET_POLL_INTERRUPT */
-        ctx.dec->SetPollInterrupt();
+/**
+  * Consumes a decoded capture plane buffer and queues it back, in
+  * non-blocking mode.
+  *
+  * @param ctx      : Decoder context
+  * @param v4l2_buf : dequeued V4L2 buffer
+  * @param buffer   : dequeued NvBuffer
+  * @return 0 on success, -1 on error
+  */
+static int
+decoder_requeue_capture_buffer(context_t &ctx, struct v4l2_buffer &v4l2_buf,
+                               NvBuffer *buffer)
+{
+    int ret = 0;
 
-        /* Since buffers have been queued, issue a post to start polling and
-           then wait here. */
-        sem_post(&ctx.pollthread_sema);
-        sem_wait(&ctx.decoderthread_sema);
+    if (ctx.enable_metadata)
+    {
+        v4l2_ctrl_videodec_outputbuf_metadata dec_metadata;
 
-        /* Call for dequeuing an event.
-           Refer ioctl VIDIOC_DQEVENT */
-        ret = ctx.dec->dqEvent(ev, 0);
+        /* Get the decoder output metadata on capture-plane.
+           Refer V4L2_CID_MPEG_VIDEODEC_METADATA */
+        ret = ctx.dec->getMetadata(v4l2_buf.index, dec_metadata);
         if (ret == 0)
         {
-            if (ev.type == V4L2_EVENT_RESOLUTION_CHANGE)
-            {
-                /* Received the resolution change event, now can do query_and_set_capture. */
-                cout << "Got V4L2_EVENT_RESOLUTION_CHANGE EVENT \n";
-                query_and_set_capture(&ctx);
-            }
+            report_metadata(&ctx, &dec_metadata);
         }
+    }
 
-        /* dequeue from the output plane and enqueue back the buffers after reading. */
-        while (1)
+    if (ctx.copy_timestamp && ctx.input_nalu && ctx.stats)
+    {
+      cout << "[" << v4l2_buf.index <<
+              "]" "dec capture plane dqB timestamp [" <<
+              v4l2_buf.timestamp.tv_sec <<
+              "s" << v4l2_buf.timestamp.tv_usec <<
+              "us]" << endl;
+    }
+
+    if (!ctx.disable_rendering && ctx.stats)
+    {
+        /* Rendering the buffer.
+           NOTE: EglRenderer requires the fd of the 0th plane to render the buffer. */
+        if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+            buffer->planes[0].fd = ctx.dmabuff_fd[v4l2_buf.index];
+        if (ctx.renderer->render(buffer->planes[0].fd) == -1)
         {
-            if ( (eos) && (ctx.dec->output_plane.getNumQueuedBuffers() == 0) )
-            {
-                cout << "Done processing all the buffers returning \n";
-                return true;
-            }
+            abort(&ctx);
+            cerr << "Error while queueing buffer for rendering "
+                    << endl;
+            return -1;
+        }
+    }
 
-            /* dequeue a buffer for output plane. */
-            if (allow_DQ)
-            {
-                ret = ctx.dec->output_plane.dqBuffer(v4l2_output_buf, &output_buffer, NULL, 0);
-                if (ret < 0)
-                {
-                    if (errno == EAGAIN)
-                        goto check_capture_buffers;
-                    else
-                    {
-                        cerr << "Error DQing buffer at output plane" << endl;
-                        abort(&ctx);
-                        break;
-                    }
-                }
-            }
-            else
+    /* Get the decoded buffer data dumped to file. */
+    if (ctx.out_file || (!ctx.disable_rendering && !ctx.stats))
+    {
+        NvBufSurf::NvCommonTransformParams transform_params;
+        transform_params.src_top = 0;
+        transform_params.src_left = 0;
+        transform_params.src_width = ctx.display_width;
+        transform_params.src_height = ctx.display_height;
+        transform_params.dst_top = 0;
+        transform_params.dst_left = 0;
+        transform_params.dst_width = ctx.display_width;
+        transform_params.dst_height = ctx.display_height;
+        transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
+        transform_params.flip = NvBufSurfTransform_None;
+        transform_params.filter = NvBufSurfTransformInter_Algo3;
+
+        if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+            buffer->planes[0].fd = ctx.dmabuff_fd[v4l2_buf.index];
+        /* Perform Blocklinear to PitchLinear conversion. */
+        ret = NvBufSurf::NvTransform(&transform_params, buffer->planes[0].fd, ctx.dst_dma_fd);
+        if (ret == -1)
+        {
+            cerr << "Transform failed" << endl;
+            return -1;
+        }
+
+        /* Write raw video frame to file */
+        if (!ctx.stats && ctx.out_file)
+        {
+            /* Dumping two planes of NV12 and three for I420 */
+            cout << "Writing to file \n";
+            dump_dmabuf(ctx.dst_dma_fd, 0, ctx.out_file);
+            dump_dmabuf(ctx.dst_dma_fd, 1, ctx.out_file);
+            if (ctx.out_pixfmt != 1)
             {
-                allow_DQ = true;
-                memcpy(&v4l2_output_buf,&temp_buf,sizeof(v4l2_buffer));
-                output_buffer = ctx.dec->output_plane.getNthBuffer(v4l2_output_buf.index);
+                dump_dmabuf(ctx.dst_dma_fd, 2, ctx.out_file);
             }
+        }
+        if (!ctx.stats && !ctx.disable_rendering)
+        {
+            ctx.renderer->render(ctx.dst_dma_fd);
+        }
+    }
 
-            if ((v4l2_output_buf.flags & V4L2_BUF_FLAG_ERROR) && ctx.enable_input_metadata)
-            {
-                v4l2_ctrl_videodec_inputbuf_metadata dec_input_metadata;
+    /* Queue the buffer back once it has been used. */
+    if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+        v4l2_buf.m.planes[0].m.fd = ctx.dmabuff_fd[v4l2_buf.index];
+    if (ctx.dec->capture_plane.qBuffer(v4l2_buf, NULL) < 0)
+    {
+        abort(&ctx);
+        cerr << "Error while queueing buffer at decoder capture plane"
+                << endl;
+        return -1;
+    }
+    return 0;
+}
 
-                /* Get the decoder input metadata.
-                   Refer V4L2_CID_MPEG_VIDEODEC_INPUT_METADATA */
-                ret = ctx.dec->getInputMetadata(v4l2_output_buf.index, dec_input_metadata);
-                if (ret == 0)
-                {
-                    ret = report_input_metadata(&ctx, &dec_input_metadata);
-                    if (ret == -1)
-                    {
-                        cerr << "Error with input stream header parsing" << endl;
-                    }
-                }
-            }
+/**
+  * Runs one round of the non-blocking decode state machine.
+  *
+  * Handles a pending event, refills and queues back the output plane
+  * buffers that have been consumed, then processes the decoded capture
+  * plane buffers. Never waits; the caller decides when to run the next
+  * round, on device readiness.
+  *
+  * @param ctx               : Decoder context
+  * @param eos               : end of stream, updated once the input is read
+  * @return true once all the output plane buffers have been processed
+  */
+static bool
+decoder_proc_nonblocking_step(context_t &ctx, bool &eos)
+{
+    int ret = 0;
+    struct v4l2_event ev;
 
-            if (eos)
-            {
-                /* Got End Of Stream, no more queueing of buffers on OUTPUT plane. */
-                goto check_capture_buffers;
-            }
+    struct v4l2_buffer v4l2_output_buf;
+    struct v4l2_plane output_planes[MAX_PLANES];
 
-            if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
-                    (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
-            {
-                if (ctx.input_nalu)
-                {
-                    /* read the input nal unit. */
-                    read_decoder_input_nalu(ctx.in_file, output_buffer, nalu_parse_buffer,
-                            CHUNK_SIZE, &ctx);
-                }
-                else
-                {
-                    /* read the input chunks. */
-                    read_decoder_input_chunk(ctx.in_file, output_buffer);
-                }
-            }
-            if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8)
-            {
-                ret = read_vpx_decoder_input_chunk(&ctx, output_buffer);
-                if (ret != 0)
-                    cerr << "Couldn't read VP9 chunk" << endl;
-            }
-            v4l2_output_buf.m.planes[0].bytesused = output_buffer->planes[0].bytesused;
+    struct v4l2_buffer v4l2_capture_buf;
+    struct v4l2_plane capture_planes[MAX_PLANES];
 
-            if (ctx.input_nalu && ctx.copy_timestamp && ctx.flag_copyts)
-            {
-                /* Update the timestamp. */
-                v4l2_output_buf.flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
-                ctx.timestamp += ctx.timestampincr;
-                v4l2_output_buf.timestamp.tv_sec = ctx.timestamp / (MICROSECOND_UNIT);
-                v4l2_output_buf.timestamp.tv_usec = ctx.timestamp % (MICROSECOND_UNIT);
-            }
+    NvBuffer *output_buffer = NULL;
+    NvBuffer *capture_buffer = NULL;
 
-            /* enqueue a buffer for output plane. */
-            ret = ctx.dec->output_plane.qBuffer(v4l2_output_buf, NULL);
-            if (ret < 0)
+    /* Call for dequeuing an event.
+       Refer ioctl VIDIOC_DQEVENT */
+    ret = ctx.dec->dqEvent(ev, 0);
+    if (ret == 0)
+    {
+        if (ev.type == V4L2_EVENT_RESOLUTION_CHANGE)
+        {
+            /* Received the resolution change event, now can do query_and_set_capture. */
+            cout << "Got V4L2_EVENT_RESOLUTION_CHANGE EVENT \n";
+            query_and_set_capture(&ctx);
+        }
+    }
+
+    /* dequeue from the output plane and enqueue back the buffers after reading. */
+    while (1)
+    {
+        if ( (eos) && (ctx.dec->output_plane.getNumQueuedBuffers() == 0) )
+        {
+            cout << "Done processing all the buffers returning \n";
+            return true;
+        }
+
+        memset(&v4l2_output_buf, 0, sizeof(v4l2_output_buf));
+        memset(output_planes, 0, sizeof(output_planes));
+        v4l2_output_buf.m.planes = output_planes;
+
+        /* dequeue a buffer for output plane. */
+        ret = ctx.dec->output_plane.dqBuffer(v4l2_output_buf, &output_buffer, NULL, 0);
+        if (ret < 0)
+        {
+            if (errno != EAGAIN)
             {
-                cerr << "Error Qing buffer at output plane" << endl;
+                cerr << "Error DQing buffer at output plane" << endl;
                 abort(&ctx);
-                break;
-            }
-            if (v4l2_output_buf.m.planes[0].bytesused == 0)
-            {
-                eos = true;
-                cout << "Input file read complete" << endl;
-                goto check_capture_buffers;
             }
+            break;
         }
+        if (decoder_requeue_output_buffer(ctx, v4l2_output_buf, output_buffer,
+                                          eos) < 0)
+            break;
+    }
 
-check_capture_buffers:
+    /* Dequeue from the capture plane and write them to file and enqueue back */
+    while (1)
+    {
+        if (!ctx.dec->capture_plane.getStreamStatus())
+        {
+            cout << "Capture plane not ON, skipping capture plane \n";
+            break;
+        }
 
-        /* Dequeue from the capture plane and write them to file and enqueue back */
-        while (1)
+        memset(&v4l2_capture_buf, 0, sizeof(v4l2_capture_buf));
+        memset(capture_planes, 0, sizeof(capture_planes));
+        v4l2_capture_buf.m.planes = capture_planes;
+
+        /* Dequeue a filled buffer */
+        ret = ctx.dec->capture_plane.dqBuffer(v4l2_capture_buf, &capture_buffer, NULL, 0);
+        if (ret < 0)
         {
-            if (!ctx.dec->capture_plane.getStreamStatus())
+            if (errno != EAGAIN)
             {
-                cout << "Capture plane not ON, skipping capture plane \n";
-                break;
+                abort(&ctx);
+                cerr << "Error while calling dequeue at capture plane" <<
+                    endl;
             }
+            break;
+        }
+        if (capture_buffer == NULL)
+        {
+            cout << "Got CAPTURE BUFFER NULL \n";
+            break;
+        }
+        if (decoder_requeue_capture_buffer(ctx, v4l2_capture_buf,
+                                           capture_buffer) < 0)
+            break;
+    }
+    /* The last output plane buffer may have been dequeued above, after which
+       the device has nothing left to report. */
+    return eos && ctx.dec->output_plane.getNumQueuedBuffers() == 0;
+}
 
-            /* Dequeue a filled buffer */
-            ret = ctx.dec->capture_plane.dqBuffer(v4l2_capture_buf, &capture_buffer, NULL, 0);
-            if (ret < 0)
-            {
-                if (errno == EAGAIN)
-                    break;
-                else
-                {
-                    abort(&ctx);
-                    cerr << "Error while calling dequeue at capture plane" <<
-                        endl;
-                }
-                break;
-            }
-            if (capture_buffer == NULL)
-            {
-                cout << "Got CAPTURE BUFFER NULL \n";
-                break;
-            }
+/**
+  * Callback called by the DQ poller when a decoder output plane buffer
+  * is dequeued, in non-blocking mode.
+  *
+  * @param v4l2_buf      : dequeued V4L2 buffer, NULL on error
+  * @param buffer        : dequeued NvBuffer
+  * @param shared_buffer : unused
+  * @param arg           : Decoder context
+  */
+static bool
+dec_output_plane_cb(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+                    NvBuffer *shared_buffer, void *arg)
+{
+    context_t *ctx = (context_t *) arg;
 
-            if (ctx.enable_metadata)
-            {
-                v4l2_ctrl_videodec_outputbuf_metadata dec_metadata;
+    if (!v4l2_buf)
+    {
+        cerr << "Error DQing buffer at output plane" << endl;
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
+    }
+    if (decoder_requeue_output_buffer(*ctx, *v4l2_buf, buffer,
+                                      ctx->input_eos) < 0)
+    {
+        ctx->dec->interruptWait();
+        return false;
+    }
+    /* Leave the poller once all the buffers are back after EOS. */
+    return !ctx->input_eos || ctx->dec->output_plane.getNumQueuedBuffers() > 0;
+}
 
-                /* Get the decoder output metadata on capture-plane.
-                   Refer V4L2_CID_MPEG_VIDEODEC_METADATA */
-                ret = ctx.dec->getMetadata(v4l2_capture_buf.index, dec_metadata);
-                if (ret == 0)
-                {
-                    report_metadata(&ctx, &dec_metadata);
-                }
-            }
+/**
+  * Callback called by the DQ poller when a decoded buffer is dequeued
+  * from the decoder capture plane, in non-blocking mode.
+  *
+  * @param v4l2_buf      : dequeued V4L2 buffer, NULL on error
+  * @param buffer        : dequeued NvBuffer
+  * @param shared_buffer : unused
+  * @param arg           : Decoder context
+  */
+static bool
+dec_capture_plane_cb(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+                     NvBuffer *shared_buffer, void *arg)
+{
+    context_t *ctx = (context_t *) arg;
 
-            if (ctx.copy_timestamp && ctx.input_nalu && ctx.stats)
-            {
-              cout << "[" << v4l2_capture_buf.index <<
-                      "]" "dec capture plane dqB timestamp [" <<
-                      v4l2_capture_buf.timestamp.tv_sec <<
-                      "s" << v4l2_capture_buf.timestamp.tv_usec <<
-                      "us]" << endl;
-            }
+    if (!v4l2_buf)
+    {
+        cerr << "Error while calling dequeue at capture plane" << endl;
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
+    }
+    if (v4l2_buf->flags & V4L2_BUF_FLAG_LAST)
+    {
+        /* Wake up the event loop of decoder_proc_nonblocking. */
+        cout << "Got EoS at capture plane" << endl;
+        ctx->got_eos = true;
+        ctx->dec->interruptWait();
+        return false;
+    }
+    if (decoder_requeue_capture_buffer(*ctx, *v4l2_buf, buffer) < 0)
+    {
+        abort(ctx);
+        ctx->dec->interruptWait();
+        return false;
+    }
+    return true;
+}
 
-            if (!ctx.disable_rendering && ctx.stats)
-            {
-                /* Rendering the buffer.
-                   NOTE: EglRenderer requires the fd of the 0th plane to render the buffer. */
-                if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    capture_buffer->planes[0].fd = ctx.dmabuff_fd[v4l2_capture_buf.index];
-                if (ctx.renderer->render(capture_buffer->planes[0].fd) == -1)
-                {
-                    abort(&ctx);
-                    cerr << "Error while queueing buffer for rendering "
-                            << endl;
-                    break;
-                }
-            }
+/**
+  * Decode processing function for non-blocking mode.
+  *
+  * @param ctx               : Decoder context
+  * @param eos               : end of stream
+  * @param current_file      : current file
+  */
+static bool
+decoder_proc_nonblocking(context_t &ctx, bool eos, uint32_t current_file)
+{
+    /*  NOTE: In non-blocking mode, a DQ poller services both decoder planes:
+              1) The poller thread sleeps until a buffer can be dequeued from
+                 the output or the capture plane, and calls dec_output_plane_cb
+                 or dec_capture_plane_cb for it.
+              2) Meanwhile this thread waits for the decoder events and sets up
+                 the capture plane on resolution change.
+              3) The callbacks interrupt the wait at the end of stream or on
+                 error. */
+    struct v4l2_event ev;
+    int ret = 0;
 
-            /* Get the decoded buffer data dumped to file. */
-            if (ctx.out_file || (!ctx.disable_rendering && !ctx.stats))
-            {
-                NvBufSurf::NvCommonTransformParams transform_params;
-                transform_params.src_top = 0;
-                transform_params.src_left = 0;
-                transform_params.src_width = ctx.display_width;
-                transform_params.src_height = ctx.display_height;
-                transform_params.dst_top = 0;
-                transform_params.dst_left = 0;
-                transform_params.dst_width = ctx.display_width;
-                transform_params.dst_height = ctx.display_height;
-                transform_params.flag = NVBUFSURF_TRANSFORM_FILTER;
-                transform_params.flip = NvBufSurfTransform_None;
-                transform_params.filter = NvBufSurfTransformInter_Algo3;
+    ctx.input_eos = eos;
+    ctx.dec->output_plane.setDQThreadCallback(dec_output_plane_cb);
+    ctx.dec->capture_plane.setDQThreadCallback(dec_capture_plane_cb);
+    if (ctx.dec->output_plane.startDQThread(&ctx, ctx.dq_poller) < 0)
+    {
+        cerr << "Error adding the output plane to the DQ poller" << endl;
+        abort(&ctx);
+        return ctx.input_eos;
+    }
 
-                if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    capture_buffer->planes[0].fd = ctx.dmabuff_fd[v4l2_capture_buf.index];
-                /* Perform Blocklinear to PitchLinear conversion. */
-                ret = NvBufSurf::NvTransform(&transform_params, capture_buffer->planes[0].fd, ctx.dst_dma_fd);
-                if (ret == -1)
-                {
-                    cerr << "Transform failed" << endl;
-                    break;
-                }
+    while (!ctx.got_eos && !ctx.got_error && !ctx.dec->isInError())
+    {
+        /* Call for dequeuing an event.
+           Refer ioctl VIDIOC_DQEVENT */
+        ret = ctx.dec->dqEvent(ev, 50000);
+        if (ret < 0)
+        {
+            /* Timed out, or woken up by the callbacks. */
+            if (errno == EAGAIN || errno == ECANCELED)
+                continue;
+            cerr << "Error in dequeueing decoder event" << endl;
+            abort(&ctx);
+            break;
+        }
 
-                /* Write raw video frame to file */
-                if (!ctx.stats && ctx.out_file)
-                {
-                    /* Dumping two planes of NV12 and three for I420 */
-                    cout << "Writing to file \n";
-                    dump_dmabuf(ctx.dst_dma_fd, 0, ctx.out_file);
-                    dump_dmabuf(ctx.dst_dma_fd, 1, ctx.out_file);
-                    if (ctx.out_pixfmt != 1)
-                    {
-                        dump_dmabuf(ctx.dst_dma_fd, 2, ctx.out_file);
-                    }
-                }
-                if (!ctx.stats && !ctx.disable_rendering)
-                {
-                    ctx.renderer->render(ctx.dst_dma_fd);
-                }
-                /* Queue the buffer back once it has been used.
-                   NOTE: If we are not rendering, queue the buffer back here immediately. */
-                if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-                    v4l2_capture_buf.m.planes[0].m.fd = ctx.dmabuff_fd[v4l2_capture_buf.index];
-                if (ctx.dec->capture_plane.qBuffer(v4l2_capture_buf, NULL) < 0)
-                {
-                    abort(&ctx);
-                    cerr << "Error while queueing buffer at decoder capture plane"
-                            << endl;
-                    break;
-                }
+        if (ev.type == V4L2_EVENT_RESOLUTION_CHANGE)
+        {
+            /* Received the resolution change event, now can do query_and_set_capture.
+               The poller must not service the capture plane meanwhile. */
+            cout << "Got V4L2_EVENT_RESOLUTION_CHANGE EVENT \n";
+            ctx.dec->capture_plane.stopDQThread();
+            query_and_set_capture(&ctx);
+            if (!ctx.got_error &&
+                ctx.dec->capture_plane.startDQThread(&ctx, ctx.dq_poller) < 0)
+            {
+                cerr << "Error adding the capture plane to the DQ poller" << endl;
+                abort(&ctx);
             }
         }
     }
-    return eos;
+
+    /* Stop servicing the planes before the decoder is torn down. */
+    ctx.dec->output_plane.stopDQThread();
+    ctx.dec->capture_plane.stopDQThread();
+    return ctx.input_eos;
 }
 
 /**
@@ -1250,11 +1396,9 @@ check_capture_buffers:
   * @param eos               : end of stream
   * @param current_file      : current file
   * @param current_loop      : iterator count
-  * @param nalu_parse_buffer : input parsed nal unit
   */
 static bool
-decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file,
-                        char *nalu_parse_buffer)
+decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file)
 {
 
     int allow_DQ = true;
@@ -1310,7 +1454,14 @@ decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file,
             }
         }
 
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+        if (ctx.input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(&ctx, buffer, &v4l2_buf);
+            if (ret != 0)
+                cerr << "Couldn't read sample" << endl;
+        }
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
@@ -1318,8 +1469,12 @@ decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file,
             if (ctx.input_nalu)
             {
                 /* read the input nal unit. */
-                read_decoder_input_nalu(ctx.in_file, buffer, nalu_parse_buffer,
-                        CHUNK_SIZE, &ctx);
+                ret = read_decoder_input_nalu(ctx.bs_reader, buffer, &ctx);
+                if (ret < 0)
+                {
+                    abort(&ctx);
+                    break;
+                }
             }
             else
             {
@@ -1327,12 +1482,13 @@ decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file,
                 read_decoder_input_chunk(ctx.in_file, buffer);
             }
         }
-        if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8)
+        else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+                ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
         {
             /* read the input chunks. */
             ret = read_vpx_decoder_input_chunk(&ctx, buffer);
             if (ret != 0)
-                cerr << "Couldn't read VP9 chunk" << endl;
+                cerr << "Couldn't read IVF frame" << endl;
         }
         v4l2_buf.m.planes[0].bytesused = buffer->planes[0].bytesused;
 
@@ -1364,23 +1520,18 @@ decoder_proc_blocking(context_t &ctx, bool eos, uint32_t current_file,
 }
 
 /**
-  * Decode processing function.
+  * Creates the decoder and sets it up for decoding, up to stream on
+  * of the output plane.
   *
   * @param ctx  : Decoder context
+  * @return 0 on success, -1 otherwise
   */
-static void *
-decode_proc(void * p_ctx)
+static int
+decoder_init(context_t &ctx)
 {
-    context_t ctx = *(context_t *)p_ctx;
     int ret = 0;
     int error = 0;
-    uint32_t current_file = 0;
-    uint32_t i;
-    bool eos = false;
-    char *nalu_parse_buffer = NULL;
-    int * perror = (int *)malloc(sizeof(int));
     NvApplicationProfiler &profiler = NvApplicationProfiler::getProfilerInstance();
-    NvElementProfiler::NvElementProfilerData data;
 
     /* Create NvVideoDecoder object for blocking or non-blocking I/O mode. */
     if (ctx.blocking_mode)
@@ -1393,7 +1544,7 @@ decode_proc(void * p_ctx)
         cout << "Creating decoder in non-blocking mode \n";
         ctx.dec = NvVideoDecoder::createVideoDecoder("dec0", O_NONBLOCK);
     }
-    TEST_ERROR(!ctx.dec, "Could not create decoder", cleanup);
+    TEST_ERROR(!ctx.dec, "Could not create decoder", error);
 
     /* Enable profiling for decoder if stats are requested. */
     if (ctx.stats)
@@ -1402,27 +1553,35 @@ decode_proc(void * p_ctx)
         ctx.dec->enableProfiling();
     }
 
+    /* Live metrics need the decoder profiler too, labeled with the stream. */
+    if (ctx.metrics_port || ctx.metrics_socket || ctx.metrics_file)
+    {
+        ctx.dec->enableProfiling();
+        NvMetricsRegistry::getInstance().registerStream(ctx.dec,
+                ctx.in_file_path);
+    }
+
     /* Subscribe to Resolution change event.
        Refer ioctl VIDIOC_SUBSCRIBE_EVENT */
     ret = ctx.dec->subscribeEvent(V4L2_EVENT_RESOLUTION_CHANGE, 0, 0);
     TEST_ERROR(ret < 0, "Could not subscribe to V4L2_EVENT_RESOLUTION_CHANGE",
-               cleanup);
+               error);
 
     /* Set format on the output plane.
        Refer ioctl VIDIOC_S_FMT */
     ret = ctx.dec->setOutputPlaneFormat(ctx.decoder_pixfmt, CHUNK_SIZE);
-    TEST_ERROR(ret < 0, "Could not set output plane format", cleanup);
+    TEST_ERROR(ret < 0, "Could not set output plane format", error);
 
     /* Configure for frame input mode for decoder.
        Refer V4L2_CID_MPEG_VIDEO_DISABLE_COMPLETE_FRAME_INPUT */
-    if (ctx.input_nalu)
+    if (ctx.input_nalu || ctx.input_container)
     {
-        /* Input to the decoder will be nal units. */
-        nalu_parse_buffer = new char[CHUNK_SIZE];
+        /* Input to the decoder will be nal units, or whole samples of a
+           container. */
         printf("Setting frame input mode to 0 \n");
         ret = ctx.dec->setFrameInputMode(0);
         TEST_ERROR(ret < 0,
-                "Error in decoder setFrameInputMode", cleanup);
+                "Error in decoder setFrameInputMode", error);
     }
     else
     {
@@ -1433,7 +1592,7 @@ decode_proc(void * p_ctx)
         printf("Setting frame input mode to 1 \n");
         ret = ctx.dec->setFrameInputMode(1);
         TEST_ERROR(ret < 0,
-                "Error in decoder setFrameInputMode", cleanup);
+                "Error in decoder setFrameInputMode", error);
     }
 
     /* Disable decoder DPB management.
@@ -1442,7 +1601,7 @@ decode_proc(void * p_ctx)
     if (ctx.disable_dpb)
     {
         ret = ctx.dec->disableDPB();
-        TEST_ERROR(ret < 0, "Error in decoder disableDPB", cleanup);
+        TEST_ERROR(ret < 0, "Error in decoder disableDPB", error);
     }
 
     /* Enable decoder error and metadata reporting.
@@ -1450,7 +1609,7 @@ decode_proc(void * p_ctx)
     if (ctx.enable_metadata || ctx.enable_input_metadata)
     {
         ret = ctx.dec->enableMetadataReporting();
-        TEST_ERROR(ret < 0, "Error while enabling metadata reporting", cleanup);
+        TEST_ERROR(ret < 0, "Error while enabling metadata reporting", error);
     }
 
     /* Set the skip frames property of the decoder.
@@ -1458,7 +1617,7 @@ decode_proc(void * p_ctx)
     if (ctx.skip_frames)
     {
         ret = ctx.dec->setSkipFrames(ctx.skip_frames);
-        TEST_ERROR(ret < 0, "Error while setting skip frames param", cleanup);
+        TEST_ERROR(ret < 0, "Error while setting skip frames param", error);
     }
 
     /* Query, Export and Map the output plane buffers so can read
@@ -1476,51 +1635,76 @@ decode_proc(void * p_ctx)
         ret = ctx.dec->output_plane.setupPlane(V4L2_MEMORY_USERPTR, 10, false, true);
     }
 
-    TEST_ERROR(ret < 0, "Error while setting up output plane", cleanup);
+    TEST_ERROR(ret < 0, "Error while setting up output plane", error);
 
     ctx.in_file = new ifstream(ctx.in_file_path);
-    TEST_ERROR(!ctx.in_file->is_open(), "Error opening input file", cleanup);
+    TEST_ERROR(!ctx.in_file->is_open(), "Error opening input file", error);
+
+    /* NAL unit input is served from a memory mapped index of the file */
+    if (ctx.input_nalu)
+    {
+        ctx.bs_reader =
+            NvBitstreamReader::createBitstreamReader(ctx.in_file_path);
+        TEST_ERROR(!ctx.bs_reader, "Error indexing input file", error);
+    }
+
+    /* Container input is served from a memory mapped sample index of the
+       MP4 or Matroska file */
+    if (ctx.input_container)
+    {
+        ctx.container_reader =
+            NvContainerReader::createContainerReader(ctx.in_file_path);
+        TEST_ERROR(!ctx.container_reader, "Error indexing input file", error);
+        if (ctx.container_reader->getPixelFormat() != ctx.decoder_pixfmt)
+        {
+            cerr << "Warning: Video codec of " << ctx.in_file_path <<
+                " does not match the decoder format" << endl;
+        }
+    }
+    /* VP8/VP9/AV1 input is served from a memory mapped frame index of
+       the IVF file */
+    else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 ||
+            ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+            ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        ctx.ivf_reader = NvIvfReader::createIvfReader(ctx.in_file_path);
+        TEST_ERROR(!ctx.ivf_reader, "Error indexing input file", error);
+    }
 
     if (ctx.out_file_path)
     {
         ctx.out_file = new ofstream(ctx.out_file_path);
         TEST_ERROR(!ctx.out_file->is_open(), "Error opening output file",
-                   cleanup);
+                   error);
     }
 
     /* Start stream processing on decoder output-plane.
        Refer ioctl VIDIOC_STREAMON */
     ret = ctx.dec->output_plane.setStreamStatus(true);
-    TEST_ERROR(ret < 0, "Error in output plane stream on", cleanup);
-
-    /* Create threads for decoder output */
-    if (ctx.blocking_mode)
-    {
-        pthread_create(&ctx.dec_capture_loop, NULL, dec_capture_loop_fcn, &ctx);
-        char dec_capture_plane[16] = "DecCapplane";
-        string s = to_string(ctx.thread_num);
-        strcat(dec_capture_plane, s.c_str());
-        /* Set thread name for decoder Capture Plane threads. */
-        pthread_setname_np(ctx.dec_capture_loop, dec_capture_plane);
-
-    }
-    else
-    {
-        sem_init(&ctx.pollthread_sema, 0, 0);
-        sem_init(&ctx.decoderthread_sema, 0, 0);
-        pthread_create(&ctx.dec_pollthread, NULL, decoder_pollthread_fcn, &ctx);
-        cout << "Created the PollThread and Decoder Thread \n";
-        char dec_poll[16] = "PollThread";
-        string s = to_string(ctx.thread_num);
-        strcat(dec_poll, s.c_str());
-        /* Set thread name for decoder poll threads. */
-        pthread_setname_np(ctx.dec_pollthread, dec_poll);
-    }
+    TEST_ERROR(ret < 0, "Error in output plane stream on", error);
 
     if (ctx.copy_timestamp && ctx.input_nalu) {
       ctx.timestamp = (ctx.start_ts * MICROSECOND_UNIT);
       ctx.timestampincr = (MICROSECOND_UNIT * 16) / ((uint32_t) (ctx.dec_fps * 16));
     }
+    return 0;
+
+error:
+    return -error;
+}
+
+/**
+  * Reads encoded data into all the output plane buffers and queues them.
+  *
+  * @param ctx  : Decoder context
+  * @return true if the input was fully read (EOS was queued)
+  */
+static bool
+decoder_queue_initial_buffers(context_t &ctx)
+{
+    int ret = 0;
+    uint32_t i;
+    bool eos = false;
 
     /* Read encoded data and enqueue all the output plane buffers.
        Exit loop in case file read is complete. */
@@ -1536,7 +1720,14 @@ decode_proc(void * p_ctx)
         memset(planes, 0, sizeof(planes));
 
         buffer = ctx.dec->output_plane.getNthBuffer(i);
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+        if (ctx.input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(&ctx, buffer, &v4l2_buf);
+            if (ret != 0)
+                cerr << "Couldn't read sample" << endl;
+        }
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG2) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_MPEG4))
@@ -1544,8 +1735,12 @@ decode_proc(void * p_ctx)
             if (ctx.input_nalu)
             {
                 /* read the input nal unit. */
-                read_decoder_input_nalu(ctx.in_file, buffer, nalu_parse_buffer,
-                        CHUNK_SIZE, &ctx);
+                ret = read_decoder_input_nalu(ctx.bs_reader, buffer, &ctx);
+                if (ret < 0)
+                {
+                    abort(&ctx);
+                    break;
+                }
             }
             else
             {
@@ -1553,12 +1748,13 @@ decode_proc(void * p_ctx)
                 read_decoder_input_chunk(ctx.in_file, buffer);
             }
         }
-        if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8)
+        else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+                ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
         {
             /* read the input chunks. */
             ret = read_vpx_decoder_input_chunk(&ctx, buffer);
             if (ret != 0)
-                cerr << "Couldn't read VP9 chunk" << endl;
+                cerr << "Couldn't read IVF frame" << endl;
         }
 
         v4l2_buf.index = i;
@@ -1591,10 +1787,146 @@ decode_proc(void * p_ctx)
         }
         i++;
     }
+    return eos;
+}
+
+/**
+  * Collects the stream stats and releases the decoder resources.
+  *
+  * @param ctx  : Decoder context
+  * @return 0 on success, -1 if the instance failed
+  */
+static int
+decoder_deinit(context_t &ctx)
+{
+    int ret = 0;
+    int error = 0;
+    NvApplicationProfiler &profiler = NvApplicationProfiler::getProfilerInstance();
+    NvElementProfiler::NvElementProfilerData data;
+
+    if (ctx.stats && ctx.dec)
+    {
+        profiler.stop();
+        ctx.dec->getProfilingData(data);
+        stream_stats[ctx.thread_num]->filename = strdup(ctx.in_file_path);
+        stream_stats[ctx.thread_num]->data = data;
+        stream_stats[ctx.thread_num]->thread_num = ctx.thread_num;
+
+        if (ctx.renderer)
+        {
+            ctx.renderer->printProfilingStats(cout);
+        }
+    }
+
+    if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
+    {
+        for(int index = 0 ; index < ctx.numCapBuffers ; index++)
+        {
+            if(ctx.dmabuff_fd[index] != 0)
+            {
+                ret = NvBufSurf::NvDestroy(ctx.dmabuff_fd[index]);
+                if(ret < 0)
+                {
+                    cerr << "Failed to Destroy NvBuffer" << endl;
+                }
+            }
+        }
+    }
+    if (ctx.dec && ctx.dec->isInError())
+    {
+        cerr << "Decoder is in error" << endl;
+        error = 1;
+    }
+
+    if (ctx.got_error)
+    {
+        error = 1;
+    }
+
+    /* The decoder destructor does all the cleanup i.e set streamoff on output and
+       capture planes, unmap buffers, tell decoder to deallocate buffer (reqbufs
+       ioctl with count = 0), and finally call v4l2_close on the fd. */
+    delete ctx.dec;
+    /* Similarly, EglRenderer destructor does all the cleanup */
+    delete ctx.renderer;
+    delete ctx.in_file;
+    delete ctx.out_file;
+    if(ctx.dst_dma_fd != -1)
+    {
+        ret = NvBufSurf::NvDestroy(ctx.dst_dma_fd);
+        ctx.dst_dma_fd = -1;
+        if(ret < 0)
+        {
+            cerr << "Error in BufferDestroy" << endl;
+            error = 1;
+        }
+    }
+    delete ctx.bs_reader;
+    delete ctx.ivf_reader;
+    delete ctx.container_reader;
+    free (ctx.in_file_path);
+    free (ctx.out_file_path);
+    if (ctx.reactor_worker)
+    {
+        sem_destroy(&ctx.pollthread_sema);
+    }
+
+    if(-error == 0)
+    {
+        cout << "Instance " << ctx.thread_num << " executed sucessfully." << endl;
+    }
+    else
+    {
+        cout << "Instance " << ctx.thread_num << " Failed." << endl;
+    }
+    return -error;
+}
+
+/**
+  * Decode processing function.
+  *
+  * @param ctx  : Decoder context
+  */
+static void *
+decode_proc(void * p_ctx)
+{
+    context_t ctx = *(context_t *)p_ctx;
+    int ret = 0;
+    int error = 0;
+    uint32_t current_file = 0;
+    bool eos = false;
+    int * perror = (int *)malloc(sizeof(int));
+
+    ret = decoder_init(ctx);
+    TEST_ERROR(ret < 0, "Error in decoder setup", cleanup);
+
+    /* Create threads for decoder output */
+    if (ctx.blocking_mode)
+    {
+        pthread_create(&ctx.dec_capture_loop, NULL, dec_capture_loop_fcn, &ctx);
+        char dec_capture_plane[16] = "DecCapplane";
+        string s = to_string(ctx.thread_num);
+        strcat(dec_capture_plane, s.c_str());
+        /* Set thread name for decoder Capture Plane threads. */
+        pthread_setname_np(ctx.dec_capture_loop, dec_capture_plane);
+
+    }
+    else
+    {
+        /* One thread dequeues both planes of the decoder. */
+        char dec_poll[16] = "PollThread";
+        string s = to_string(ctx.thread_num);
+        strcat(dec_poll, s.c_str());
+        ctx.dq_poller = NvV4l2DQPoller::createDQPoller(dec_poll);
+        TEST_ERROR(!ctx.dq_poller, "Could not create DQ poller", cleanup);
+        cout << "Created the DQ poller \n";
+    }
+
+    eos = decoder_queue_initial_buffers(ctx);
     if (ctx.blocking_mode)
-        eos = decoder_proc_blocking(ctx, eos, current_file, nalu_parse_buffer);
+        eos = decoder_proc_blocking(ctx, eos, current_file);
     else
-        eos = decoder_proc_nonblocking(ctx, eos, current_file, nalu_parse_buffer);
+        eos = decoder_proc_nonblocking(ctx, eos, current_file);
 
     /* After sending EOS, all the buffers from output plane should be dequeued.
        and after that capture plane loop should be signalled to stop. */
@@ -1655,90 +1987,289 @@ cleanup:
     }
     else if (!ctx.blocking_mode)
     {
-        /* Clear the poll interrupt to get the decoder's poll thread out. */
-        ctx.dec->ClearPollInterrupt();
-        /* If Pollthread is waiting on, signal it to exit the thread. */
-        sem_post(&ctx.pollthread_sema);
-        pthread_join(ctx.dec_pollthread, NULL);
+        /* Stops the poller thread. */
+        delete ctx.dq_poller;
     }
 
-    if (ctx.stats)
+    if (decoder_deinit(ctx) < 0)
     {
-        profiler.stop();
-        ctx.dec->getProfilingData(data);
-        stream_stats[ctx.thread_num]->filename = strdup(ctx.in_file_path);
-        stream_stats[ctx.thread_num]->data = data;
-        stream_stats[ctx.thread_num]->thread_num = ctx.thread_num;
+        error = 1;
+    }
+    free (p_ctx);
+    *perror = -error;
+    return (perror);
+}
 
-        if (ctx.renderer)
+/**
+  * Stops the poll thread of a reactor stream.
+  *
+  * Only called while the poll thread waits for the next round, so it is
+  * not blocked in DevicePoll.
+  *
+  * @param ctx : Decoder context
+  */
+static void
+reactor_stop_stream(context_t *ctx)
+{
+    ctx->got_eos = true;
+    sem_post(&ctx->pollthread_sema);
+    pthread_join(ctx->dec_pollthread, NULL);
+    ctx->dec_pollthread = 0;
+}
+
+/**
+  * Drives the streams of a reactor worker whose decoders can be polled.
+  *
+  * The worker sleeps in a single poll over the decoders of all its
+  * streams, then runs one round of the non-blocking state machine for the
+  * ready ones. No thread is needed besides the worker.
+  *
+  * @param active : Streams still decoding, emptied on return
+  * @return 0 on success, -1 on polling error
+  */
+static int
+reactor_run_polled(vector<context_t *> &active)
+{
+    vector<NvV4l2Element *> elements;
+    vector<context_t *> pending;
+    bool *ready = new bool[active.size()];
+    int error = 0;
+    int ret;
+    uint32_t i;
+
+    while (!active.empty())
+    {
+        elements.clear();
+        for (i = 0; i < active.size(); i++)
+            elements.push_back(active[i]->dec);
+
+        /* Time out now and then, and check every stream again. */
+        ret = NvV4l2Element::pollElements(&elements[0], elements.size(),
+                                          ready, 1000);
+        if (ret < 0)
         {
-            ctx.renderer->printProfilingStats(cout);
+            cerr << "Error while polling the decoders" << endl;
+            for (i = 0; i < active.size(); i++)
+                abort(active[i]);
+            error = -1;
+            break;
         }
-    }
 
-    if(ctx.capture_plane_mem_type == V4L2_MEMORY_DMABUF)
-    {
-        for(int index = 0 ; index < ctx.numCapBuffers ; index++)
+        pending.clear();
+        for (i = 0; i < active.size(); i++)
         {
-            if(ctx.dmabuff_fd[index] != 0)
+            context_t *ctx = active[i];
+
+            if (ret > 0 && !ready[i])
             {
-                ret = NvBufSurf::NvDestroy(ctx.dmabuff_fd[index]);
-                if(ret < 0)
-                {
-                    cerr << "Failed to Destroy NvBuffer" << endl;
-                }
+                pending.push_back(ctx);
+                continue;
             }
+            if (decoder_proc_nonblocking_step(*ctx, ctx->input_eos) ||
+                    ctx->got_error || ctx->dec->isInError())
+                continue;
+            pending.push_back(ctx);
         }
+        active.swap(pending);
     }
-    if (ctx.dec && ctx.dec->isInError())
+    active.clear();
+    delete[] ready;
+    return error;
+}
+
+/**
+  * Drives the streams of a reactor worker whose decoders cannot be polled.
+  *
+  * The DevicePoll control blocks on a single decoder, so each stream keeps
+  * a poll thread blocked in it, as in the non-reactor mode. Instead of
+  * waking up a decode thread of its own, it adds the stream to the ready
+  * list of the worker. A wake-up costs the worker one pass over the ready
+  * streams, however many streams it owns.
+  *
+  * @param worker : Reactor worker
+  * @param active : Streams still decoding, emptied on return
+  */
+static void
+reactor_run_devicepoll(reactor_worker_t *worker, vector<context_t *> &active)
+{
+    vector<context_t *> ready;
+    uint32_t num_active = active.size();
+    uint32_t i;
+
+    for (i = 0; i < active.size(); i++)
     {
-        cerr << "Decoder is in error" << endl;
-        error = 1;
+        context_t *ctx = active[i];
+
+        pthread_create(&ctx->dec_pollthread, NULL, decoder_pollthread_fcn, ctx);
+        char dec_poll[16] = "PollThread";
+        string s = to_string(ctx->thread_num);
+        strcat(dec_poll, s.c_str());
+        /* Set thread name for decoder poll threads. */
+        pthread_setname_np(ctx->dec_pollthread, dec_poll);
+
+        ctx->dec->SetPollInterrupt();
+        sem_post(&ctx->pollthread_sema);
     }
 
-    if (ctx.got_error)
+    while (num_active > 0)
     {
-        error = 1;
+        pthread_mutex_lock(&worker->lock);
+        while (worker->ready.empty())
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        ready.swap(worker->ready);
+        pthread_mutex_unlock(&worker->lock);
+
+        for (i = 0; i < ready.size(); i++)
+        {
+            context_t *ctx = ready[i];
+
+            if (decoder_proc_nonblocking_step(*ctx, ctx->input_eos) ||
+                    ctx->got_error || ctx->dec->isInError())
+            {
+                reactor_stop_stream(ctx);
+                num_active--;
+                continue;
+            }
+
+            /* Start the next poll of the stream. */
+            ctx->dec->SetPollInterrupt();
+            sem_post(&ctx->pollthread_sema);
+        }
+        ready.clear();
     }
+    active.clear();
+}
 
-    /* The decoder destructor does all the cleanup i.e set streamoff on output and
-       capture planes, unmap buffers, tell decoder to deallocate buffer (reqbufs
-       ioctl with count = 0), and finally call v4l2_close on the fd. */
-    delete ctx.dec;
-    /* Similarly, EglRenderer destructor does all the cleanup */
-    delete ctx.renderer;
-    delete ctx.in_file;
-    delete ctx.out_file;
-    if(ctx.dst_dma_fd != -1)
+/**
+  * Reactor worker function.
+  *
+  * Sets up its share of the decoders in non-blocking mode, then runs one
+  * round of the non-blocking state machine for every stream whose decoder
+  * is ready, until all the streams are done. The decoders are polled from
+  * the worker itself when they can be, otherwise from a poll thread per
+  * stream blocked in DevicePoll.
+  *
+  * @param arg : Reactor worker
+  */
+static void *
+reactor_worker_fcn(void *arg)
+{
+    reactor_worker_t *worker = (reactor_worker_t *) arg;
+    vector<context_t *> active;
+    bool pollable = true;
+    uint32_t i;
+
+    worker->error = 0;
+    for (i = 0; i < worker->num_streams; i++)
     {
-        ret = NvBufSurf::NvDestroy(ctx.dst_dma_fd);
-        ctx.dst_dma_fd = -1;
-        if(ret < 0)
+        context_t *ctx = worker->streams[i];
+
+        ctx->blocking_mode = 0;
+        ctx->reactor_worker = worker;
+        sem_init(&ctx->pollthread_sema, 0, 0);
+        if (decoder_init(*ctx) < 0)
         {
-            cerr << "Error in BufferDestroy" << endl;
-            error = 1;
+            cerr << "Error in decoder setup for stream " << ctx->thread_num
+                 << endl;
+            ctx->got_error = true;
+            continue;
         }
+        ctx->input_eos = decoder_queue_initial_buffers(*ctx);
+        if (ctx->got_error || ctx->dec->isInError())
+            continue;
+
+        pollable = pollable && ctx->dec->isPollable();
+        active.push_back(ctx);
     }
-    delete[] nalu_parse_buffer;
-    free (ctx.in_file_path);
-    free (ctx.out_file_path);
-    if (!ctx.blocking_mode)
+
+    if (pollable)
     {
-        sem_destroy(&ctx.pollthread_sema);
-        sem_destroy(&ctx.decoderthread_sema);
+        if (reactor_run_polled(active) < 0)
+            worker->error = -1;
+    }
+    else
+    {
+        reactor_run_devicepoll(worker, active);
     }
 
-    if(-error == 0)
+    for (i = 0; i < worker->num_streams; i++)
     {
-        cout << "Instance " << ctx.thread_num << " executed sucessfully." << endl;
+        context_t *ctx = worker->streams[i];
+
+        ctx->got_eos = true;
+        if (decoder_deinit(*ctx) < 0)
+            worker->error = -1;
+        free (ctx);
     }
-    else
+    return NULL;
+}
+
+/**
+  * Decodes all the streams with a fixed pool of reactor worker threads.
+  *
+  * Streams are spread over the workers round-robin; each worker owns its
+  * streams for the whole run, so the decoder of a stream is only driven by
+  * its worker, and its poll thread if any, one after the other.
+  *
+  * @param ctx         : Decoder contexts
+  * @param num_threads : Number of workers, 0 for one per online CPU
+  * @return 0 on success, -1 if any stream failed
+  */
+static int
+decode_reactor(context_t **ctx, uint32_t num_threads)
+{
+    vector<reactor_worker_t> workers;
+    int error = 0;
+    uint32_t i;
+
+    if (num_threads == 0)
     {
-        cout << "Instance " << ctx.thread_num << " Failed." << endl;
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (num_cpus > 0) ? num_cpus : 1;
     }
-    free (p_ctx);
-    *perror = -error;
-    return (perror);
+    if (num_threads > (uint32_t) num_files)
+        num_threads = num_files;
+
+    cout << "Decoding " << num_files << " streams with " << num_threads <<
+        " reactor threads" << endl;
+
+    workers.resize(num_threads);
+    for (i = 0; i < num_threads; i++)
+    {
+        workers[i].streams =
+            (context_t **) malloc(num_files * sizeof(context_t *));
+        workers[i].num_streams = 0;
+        workers[i].error = 0;
+        pthread_mutex_init(&workers[i].lock, NULL);
+        pthread_cond_init(&workers[i].cond, NULL);
+    }
+    for (i = 0; i < (uint32_t) num_files; i++)
+    {
+        reactor_worker_t &worker = workers[i % num_threads];
+        worker.streams[worker.num_streams++] = ctx[i];
+    }
+
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_create(&workers[i].thread, NULL, reactor_worker_fcn,
+                       &workers[i]);
+        char reactor_name[16] = "Reactor";
+        string s = to_string(i);
+        strcat(reactor_name, s.c_str());
+        /* Name each reactor worker thread. */
+        pthread_setname_np(workers[i].thread, reactor_name);
+    }
+
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].error)
+            error = -1;
+        free (workers[i].streams);
+        pthread_mutex_destroy(&workers[i].lock);
+        pthread_cond_destroy(&workers[i].cond);
+    }
+    return error;
 }
 
 /**
@@ -1786,26 +2317,64 @@ main(int argc, char *argv[])
 
         stress = ctx[0]->stress_test;
         stats = ctx[0]->stats;
-        for (int i = 0 ; i < num_files ; i++)
+        if (ctx[0]->mock_device)
+        {
+            NvV4l2Element::setDeviceOps(NvV4l2MockDevice::getDeviceOps());
+        }
+        if (ctx[0]->metrics_port || ctx[0]->metrics_socket ||
+                ctx[0]->metrics_file)
         {
-            /* Spawn multiple decoding threads for multiple decoders. */
-            pthread_create(&(ctx[i]->decode_thread), NULL, decode_proc, ctx[i]);
-            char dec_output_plane[16] = "DecOutplane";
-            string s = to_string(i);
-            strcat(dec_output_plane, s.c_str());
-            /* Name each spawned thread. */
-            pthread_setname_np(ctx[i]->decode_thread, dec_output_plane);
+            /* Keeps running across stress iterations. */
+            if (NvMetricsRegistry::getInstance().startExporter(
+                        ctx[0]->metrics_interval, 5 * ctx[0]->metrics_interval,
+                        ctx[0]->metrics_port, ctx[0]->metrics_socket,
+                        ctx[0]->metrics_file) < 0)
+            {
+                cerr << "Could not start metrics exporter" << endl;
+                ret = -1;
+                break;
+            }
         }
+        if (ctx[0]->reactor_mode)
+        {
+            /* Every stream holds a handful of file descriptors, allow as
+               many as the hard limit for large stream counts. */
+            struct rlimit fd_limit;
+            if (getrlimit(RLIMIT_NOFILE, &fd_limit) == 0 &&
+                    fd_limit.rlim_cur < fd_limit.rlim_max)
+            {
+                fd_limit.rlim_cur = fd_limit.rlim_max;
+                setrlimit(RLIMIT_NOFILE, &fd_limit);
+            }
 
-        for (int i = 0 ; i < num_files ; i++)
+            if (decode_reactor(ctx, ctx[0]->reactor_threads) != 0)
+            {
+                ret = -1;
+            }
+        }
+        else
         {
-            /* Wait for the decoding thread */
-            pthread_join(ctx[i]->decode_thread, &error);
-            if (*(int *)error != 0)
+            for (int i = 0 ; i < num_files ; i++)
             {
-                ret = *(int *)error;
+                /* Spawn multiple decoding threads for multiple decoders. */
+                pthread_create(&(ctx[i]->decode_thread), NULL, decode_proc, ctx[i]);
+                char dec_output_plane[16] = "DecOutplane";
+                string s = to_string(i);
+                strcat(dec_output_plane, s.c_str());
+                /* Name each spawned thread. */
+                pthread_setname_np(ctx[i]->decode_thread, dec_output_plane);
+            }
+
+            for (int i = 0 ; i < num_files ; i++)
+            {
+                /* Wait for the decoding thread */
+                pthread_join(ctx[i]->decode_thread, &error);
+                if (*(int *)error != 0)
+                {
+                    ret = *(int *)error;
+                }
+                free (error);
             }
-            free (error);
         }
         iterator_num++;
         if (stats)
@@ -1820,6 +2389,7 @@ main(int argc, char *argv[])
         }
     } while ((stress != iterator_num));
 
+    NvMetricsRegistry::getInstance().stopExporter();
     free (ctx);
     free (stream_stats);
     if (ret)
@@ -29,6 +29,9 @@
 #include <cstdint>
 #include <fstream>
 #include "NvVideoEncoder.h"
+#include "NvBitstreamSink.h"
+#include "NvMp4Muxer.h"
+#include "NvFrameSource.h"
 #include <semaphore.h>
 #include <stdint.h>
 #include <string>
@@ -47,8 +50,18 @@ typedef struct
     string in_file_path;
     string out_file_path;
     std::ifstream *in_file;
-    std::ofstream *out_file;
+    NvBitstreamSink *out_file;
     std::ofstream *mv_dump_file;
+    uint32_t num_prefetch_frames; // Frames read ahead of the encoder, 0 to read synchronously
+    bool loop_input; // Rewind the input at its end, for soak tests
+    NvFrameSource *frame_source; // Reads frames ahead when num_prefetch_frames is set
+    uint64_t sync_interval; // Bytes written to the output between two fdatasync calls, 0 to never sync
+    bool mp4_output; // Write the output as fragmented MP4 instead of an elementary stream
+    NvMp4Muxer *mp4_muxer;
+    uint16_t metrics_port; // Localhost TCP port serving live metrics, 0 to disable
+    char *metrics_socket; // Unix socket serving live metrics, NULL to disable
+    char *metrics_file; // File live metrics are appended to as JSON lines, NULL to disable
+    uint32_t metrics_interval; // Interval between two metrics samples, in milliseconds
 
     uint32_t width;
     uint32_t height;
@@ -76,6 +76,14 @@ print_help(void)
             "\t-hpt <type>           HW preset type (1 = ultrafast, 2 = fast, 3 = medium,  4 = slow)\n"
             "\t--blocking-mode <val> Set blocking mode, 0 is non-blocking, 1 for blocking (Default) \n\n"
             "\t--mvdump              Dump encoded motion vectors to <out-file>_mvdump\n\n"
+            "\t--prefetch <num>      Read <num> input frames ahead from a background thread [Default = 0, disabled]\n"
+            "\t--loop-input          Rewind the input files at their end, for soak tests (with --prefetch)\n\n"
+            "\t--sync-interval <KiB> fdatasync the outputs every <KiB> written [Default = 0, never]\n"
+            "\t--mp4                 Write the outputs as fragmented MP4, H264, H265 and AV1 only\n\n"
+            "\t--metrics-port <port> Serve live metrics on http://127.0.0.1:<port>/metrics (Prometheus) and /metrics.json\n"
+            "\t--metrics-socket <path> Serve the live metrics over HTTP on a Unix socket instead\n"
+            "\t--metrics-file <path> Append a JSON line of live metrics to <path> every interval\n"
+            "\t--metrics-interval <ms> Live metrics sampling interval, FPS and latencies are over 5 intervals [Default = 1000]\n\n"
             "\t-mem_type_oplane <num> Specify memory type for the output plane to be used [1 = V4L2_MEMORY_MMAP, 2 = V4L2_MEMORY_USERPTR, 3 = V4L2_MEMORY_DMABUF]\n\n"
             "\t-s <loop-count>       Stress test [Default = 1]\n\n"
             "Supported Encoding profiles for H.264:\n"
@@ -552,6 +560,82 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
                 ctx[i]->dump_mv = true;
             }
         }
+        else if (!strcmp (arg, "--prefetch"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE (argp);
+            uint32_t num_prefetch_frames = (uint32_t) atoi (*argp);
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->num_prefetch_frames = num_prefetch_frames;
+            }
+        }
+        else if (!strcmp (arg, "--loop-input"))
+        {
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->loop_input = true;
+            }
+        }
+        else if (!strcmp (arg, "--sync-interval"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE (argp);
+            uint64_t sync_interval = (uint64_t) atoll (*argp) * 1024;
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->sync_interval = sync_interval;
+            }
+        }
+        else if (!strcmp (arg, "--mp4"))
+        {
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->mp4_output = true;
+            }
+        }
+        else if (!strcmp (arg, "--metrics-port"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE (argp);
+            int port = atoi (*argp);
+            CSV_PARSE_CHECK_ERROR (port <= 0 || port > 65535,
+                    "Metrics port should be in 1-65535");
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->metrics_port = port;
+            }
+        }
+        else if (!strcmp (arg, "--metrics-socket"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE (argp);
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->metrics_socket = *argp;
+            }
+        }
+        else if (!strcmp (arg, "--metrics-file"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE (argp);
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->metrics_file = *argp;
+            }
+        }
+        else if (!strcmp (arg, "--metrics-interval"))
+        {
+            argp++;
+            CHECK_OPTION_VALUE (argp);
+            int interval = atoi (*argp);
+            CSV_PARSE_CHECK_ERROR (interval <= 0,
+                    "Metrics interval should be > 0");
+            for (int i = 0; i < num_files; i++)
+            {
+                ctx[i]->metrics_interval = interval;
+            }
+        }
         else if (!strcmp (arg, "-mem_type_oplane"))
         {
             argp++;
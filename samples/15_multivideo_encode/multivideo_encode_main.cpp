@@ -26,6 +26,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "NvMetricsRegistry.h"
 #include "NvUtils.h"
 #include <iostream>
 #include <string.h>
@@ -43,6 +44,21 @@
 
 int num_files;
 
+/**
+  * Read the next raw frame into an output plane buffer, from the read-ahead
+  * frame source when prefetching or directly from the input file otherwise.
+  *
+  * @param ctx    : Encoder context
+  * @param buffer : NvBuffer to fill
+  */
+static int
+read_input_frame(context_t &ctx, NvBuffer &buffer)
+{
+    if (ctx.frame_source)
+        return ctx.frame_source->readFrame(buffer);
+    return read_video_frame(ctx.in_file, buffer);
+}
+
 /**
   * Set encoder context defaults values.
   *
@@ -69,6 +85,7 @@ set_defaults(context_t ** ctx)
         ctx[i]->fps_n = 30;
         ctx[i]->fps_d = 1;
         ctx[i]->stress_test = 1;
+        ctx[i]->metrics_interval = 1000;
         ctx[i]->output_memory_type = V4L2_MEMORY_DMABUF;
         ctx[i]->blocking_mode = 1;
         ctx[i]->num_output_buffers = 6;
@@ -91,14 +108,16 @@ abort(context_t *ctx)
 /**
   * Write encoded frame data.
   *
-  * @param stream : output stream
+  * The data is copied to the sink and written to the file from its writer
+  * thread, so a slow disk does not hold up the capture plane.
+  *
+  * @param sink   : output bitstream sink
   * @param buffer : output nvbuffer
   */
 static int
-write_encoder_output_frame (ofstream * stream, NvBuffer * buffer)
+write_encoder_output_frame (NvBitstreamSink * sink, NvBuffer * buffer)
 {
-    stream->write ((char *) buffer->planes[0].data, buffer->planes[0].bytesused);
-    return 0;
+    return sink->write (buffer->planes[0].data, buffer->planes[0].bytesused);
 }
 
 /**
@@ -123,6 +142,7 @@ encoder_capture_plane_dq_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer
 
     uint32_t frame_num = ctx.enc->capture_plane.getTotalDequeuedBuffers() - 1;
     static uint32_t num_encoded_frames = 1;
+    int ret;
 
     if (v4l2_buf == NULL)
     {
@@ -138,7 +158,16 @@ encoder_capture_plane_dq_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer
         return false;
     }
 
-    write_encoder_output_frame (ctx.out_file, buffer);
+    if (ctx.mp4_muxer)
+        ret = ctx.mp4_muxer->writeBuffer (v4l2_buf, buffer);
+    else
+        ret = write_encoder_output_frame (ctx.out_file, buffer);
+    if (ret < 0)
+    {
+        cerr << "Error while writing encoded frame" << endl;
+        abort (&ctx);
+        return false;
+    }
     num_encoded_frames++;
 
     if (ctx.dump_mv)
@@ -333,7 +362,7 @@ static int encoder_proc_nonblocking(context_t &ctx, bool eos)
             }
 
             /* Read yuv frame data from input file */
-            if (read_video_frame (ctx.in_file, *outplane_buffer) < 0)
+            if (read_input_frame (ctx, *outplane_buffer) < 0)
             {
                 cerr << "Could not read complete frame from input file" << endl;
                 v4l2_output_buf.m.planes[0].bytesused = 0;
@@ -465,7 +494,7 @@ static int encoder_proc_blocking(context_t &ctx, bool eos)
         }
 
         /* Read yuv frame data from input file */
-        if (read_video_frame (ctx.in_file, *buffer) < 0)
+        if (read_input_frame (ctx, *buffer) < 0)
         {
             cerr << "Could not read complete frame from input file" << endl;
             v4l2_buf.m.planes[0].bytesused = 0;
@@ -544,13 +573,30 @@ encode_proc(void *p_ctx)
                     " > 144 for H.265", cleanup);
     }
 
-    /* Open input file for raw yuv */
-    ctx.in_file = new ifstream (ctx.in_file_path);
-    TEST_ERROR (!ctx.in_file->is_open(), "Could not open input file", cleanup);
+    /* Open input file for raw yuv, the frame source opens its own when
+     * prefetching.
+     */
+    if (!ctx.num_prefetch_frames)
+    {
+        ctx.in_file = new ifstream (ctx.in_file_path);
+        TEST_ERROR (!ctx.in_file->is_open(), "Could not open input file", cleanup);
+    }
 
-    /* Open output file for encoded bitstream */
-    ctx.out_file = new ofstream (ctx.out_file_path);
-    TEST_ERROR (!ctx.out_file->is_open(), "Couls not open output file", cleanup);
+    if (ctx.mp4_output)
+    {
+        /* Open output file for the fragmented MP4 stream, one fragment per GOP */
+        ctx.mp4_muxer = NvMp4Muxer::createMp4Muxer (ctx.out_file_path.c_str(),
+                ctx.encoder_pixfmt, ctx.width, ctx.height, ctx.fps_n, ctx.fps_d);
+        TEST_ERROR (!ctx.mp4_muxer, "Could not open output file", cleanup);
+    }
+    else
+    {
+        /* Open output file for encoded bitstream */
+        ctx.out_file = NvBitstreamSink::createBitstreamSink (
+                ("out" + to_string (ctx.thread_num)).c_str(),
+                ctx.out_file_path.c_str(), 8 * 1024 * 1024, ctx.sync_interval);
+        TEST_ERROR (!ctx.out_file, "Couls not open output file", cleanup);
+    }
 
     /* Create NvVideoEncoder object for blocking or non-blocking I/O mode. */
     if (ctx.blocking_mode)
@@ -565,6 +611,14 @@ encode_proc(void *p_ctx)
     }
     TEST_ERROR (!ctx.enc, "Could not create encoder", cleanup);
 
+    /* Live metrics need the encoder profiler, labeled with the stream. */
+    if (ctx.metrics_port || ctx.metrics_socket || ctx.metrics_file)
+    {
+        ctx.enc->enableProfiling();
+        NvMetricsRegistry::getInstance().registerStream(ctx.enc,
+                ctx.in_file_path.c_str());
+    }
+
     /*
      * Set encoder capture plane format.
      * NOTE: It is necessary that Capture Plane format be set before Output Plane
@@ -723,6 +777,18 @@ encode_proc(void *p_ctx)
             TEST_ERROR (true, "Not a valid plane", cleanup);
     }
 
+    if (ctx.num_prefetch_frames)
+    {
+        /* The output plane buffers fix the plane layout the frame source
+         * reads ahead into.
+         */
+        string name = "src" + to_string (ctx.thread_num);
+        ctx.frame_source = NvFrameSource::createFrameSource (name.c_str(),
+                ctx.in_file_path.c_str(), *ctx.enc->output_plane.getNthBuffer(0),
+                0, ctx.num_prefetch_frames, ctx.loop_input);
+        TEST_ERROR (!ctx.frame_source, "Could not create frame source", cleanup);
+    }
+
     /* Query, Export and Map the capture plane buffers so that we can write
      * encoded bitstream data into the buffers
      */
@@ -819,7 +885,7 @@ encode_proc(void *p_ctx)
         }
 
         /* Read yuv frame data from input file */
-        if (read_video_frame (ctx.in_file, *buffer) < 0)
+        if (read_input_frame (ctx, *buffer) < 0)
         {
             cerr << "Could not read complete frame from input file" << endl;
             v4l2_buf.m.planes[0].bytesused = 0;
@@ -930,9 +996,39 @@ cleanup:
     if (ctx.dump_mv && ctx.mv_dump_file)
         delete ctx.mv_dump_file;
 
+    if (ctx.frame_source)
+    {
+        ctx.frame_source->printStats (cout);
+        delete ctx.frame_source;
+    }
+
+    if (ctx.out_file)
+    {
+        /* Wait for the writer so that the stats cover the whole stream. */
+        if (ctx.out_file->flush() < 0)
+        {
+            cerr << "Error while writing output file" << endl;
+            error = 1;
+        }
+        ctx.out_file->printStats (cout);
+    }
+
+    if (ctx.mp4_muxer)
+    {
+        /* Write the last fragment before reporting. */
+        if (ctx.mp4_muxer->close() < 0)
+        {
+            cerr << "Error while writing output file" << endl;
+            error = 1;
+        }
+        cout << "Wrote " << ctx.mp4_muxer->getNumSamples() << " samples in " <<
+            ctx.mp4_muxer->getNumFragments() << " MP4 fragments" << endl;
+    }
+
     delete ctx.enc;
     delete ctx.in_file;
     delete ctx.out_file;
+    delete ctx.mp4_muxer;
 
     if (!ctx.blocking_mode)
     {
@@ -998,6 +1094,21 @@ main(int argc, char *argv[])
 
         stress = ctx[0]->stress_test;
 
+        if (ctx[0]->metrics_port || ctx[0]->metrics_socket ||
+                ctx[0]->metrics_file)
+        {
+            /* Keeps running across stress iterations. */
+            if (NvMetricsRegistry::getInstance().startExporter(
+                        ctx[0]->metrics_interval, 5 * ctx[0]->metrics_interval,
+                        ctx[0]->metrics_port, ctx[0]->metrics_socket,
+                        ctx[0]->metrics_file) < 0)
+            {
+                cerr << "Could not start metrics exporter\n";
+                ret = -1;
+                goto cleanup;
+            }
+        }
+
         for (int i = 0; i < num_files; i++)
         {
             /* Spawn multiple encoding threads for multiple encoders */
@@ -1025,6 +1136,7 @@ main(int argc, char *argv[])
     } while (stress != iterator_num);
 
 cleanup:
+    NvMetricsRegistry::getInstance().stopExporter();
     if (ctx)
         delete[] ctx;
 
@@ -29,6 +29,12 @@
 #include <fstream>
 #include "NvVideoEncoder.h"
 #include "NvVideoDecoder.h"
+#include "NvBitstreamReader.h"
+#include "NvIvfReader.h"
+#include "NvContainerReader.h"
+#include "NvBitstreamSink.h"
+#include "NvCrc.h"
+#include "NvEncSchedule.h"
 #include <unistd.h>
 #include <sstream>
 #include <stdint.h>
@@ -36,13 +42,10 @@
 
 #include "NvBufSurface.h"
 
-#define CRC32_POLYNOMIAL  0xEDB88320L
 #define MAX_BUFFERS 32
 #define NUM_ENCODER_OUTPUT_BUFFERS 6
 #define CHUNK_SIZE 4000000
 
-#define IVF_FILE_HDR_SIZE   32
-#define IVF_FRAME_HDR_SIZE  12
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
@@ -52,19 +55,11 @@
 #define IS_NAL_UNIT_START1(buffer_ptr) (!buffer_ptr[0] && !buffer_ptr[1] && \
         (buffer_ptr[2] == 1))
 
-#define H264_NAL_UNIT_CODED_SLICE  1
-#define H264_NAL_UNIT_CODED_SLICE_IDR  5
-
 #define HEVC_NUT_TRAIL_N  0
 #define HEVC_NUT_RASL_R  9
 #define HEVC_NUT_BLA_W_LP  16
 #define HEVC_NUT_CRA_NUT  21
 
-#define IS_H264_NAL_CODED_SLICE(buffer_ptr) ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE)
-#define IS_H264_NAL_CODED_SLICE_IDR(buffer_ptr) ((buffer_ptr[0] & 0x1F) == H264_NAL_UNIT_CODED_SLICE_IDR)
-
-#define GET_H265_NAL_UNIT_TYPE(buffer_ptr) ((buffer_ptr[0] & 0x7E) >> 1)
-
 #define GET_TIME(timeval) clock_gettime(CLOCK_MONOTONIC,timeval);
 
 #define TIMESPEC_DIFF_USEC(timespec1, timespec2) \
@@ -76,19 +71,8 @@
                                         error = 1; \
                                         goto label; }
 
-#define TEST_PARSE_ERROR(cond, label) if (cond) { \
-    cerr << "Error parsing runtime parameter changes string" << endl; \
-    goto label; }
-
-#define IS_DIGIT(c) (c >= '0' && c <= '9')
 #define MICROSECOND_UNIT 1000000
 
-typedef struct CrcRec
-{
-    uint32_t CRCTable[256];
-    uint32_t CrcValue;
-}Crc;
-
 typedef struct
 {
     NvVideoEncoder *enc;
@@ -98,10 +82,18 @@ typedef struct
     uint32_t decoder_pixfmt;
     char *in_file_path;
     std::ifstream *in_file;
+    NvBitstreamReader *bs_reader;
+    NvIvfReader *ivf_reader;
+    NvContainerReader *container_reader;
     uint32_t width;
     uint32_t height;
     char *out_file_path;
-    std::ofstream *out_file;
+    NvBitstreamSink *out_file;
+    uint64_t sync_interval; // Bytes written to the output between two fdatasync calls, 0 to never sync
+    uint16_t metrics_port; // Localhost TCP port serving live metrics, 0 to disable
+    char *metrics_socket; // Unix socket serving live metrics, NULL to disable
+    char *metrics_file; // File live metrics are appended to as JSON lines, NULL to disable
+    uint32_t metrics_interval; // Interval between two metrics samples, in milliseconds
     std::ifstream *recon_Ref_file;
     uint32_t bitrate;
     uint32_t peak_bitrate;
@@ -143,6 +135,7 @@ typedef struct
     enum v4l2_memory dec_capture_plane_mem_type;
     enum v4l2_colorspace cs;
     bool input_nalu;
+    bool input_container;
     bool copy_timestamp;
     bool flag_copyts;
     float dec_fps;
@@ -151,19 +144,18 @@ typedef struct
     bool bnoIframe;
     uint32_t nH264FrameNumBits;
     uint32_t nH265PocLsbBits;
-    uint32_t dec_vp8_file_header_flag;
-    uint32_t dec_vp9_file_header_flag;
     bool b_use_enc_cmd;
     bool enable_lossless;
     bool got_eos;
     bool use_gold_crc;
     char gold_crc[20];
-    Crc *pBitStreamCrc;
+    NvCrc *pBitStreamCrc;
     uint64_t timestamp;
     uint64_t timestampincr;
     bool stats;
-    std::stringstream *runtime_params_str;
-    uint32_t next_param_change_frame;
+    char *runtime_params;
+    NvEncSchedule *schedule;
+    uint32_t runtime_change_index;
     bool got_error;
     bool seek_mode;
     int iterator_num;
@@ -60,7 +60,8 @@ print_help(void)
             "\tH264\n"
             "\tH265\n"
             "\tVP8\n"
-            "\tVP9\n\n"
+            "\tVP9\n"
+            "\tAV1 (decoder input only)\n\n"
             "TRANSCODER OPTIONS:\n"
             "\t-h,--help             Prints this text\n"
             "\t--dbg-level <level>   Sets the debug level [Values 0-3]\n"
@@ -68,10 +69,16 @@ print_help(void)
             "\t--max-perf            Enable maximum Performance \n"
             "\t--seek-mode           Seek to begin of input file without re-construct video codec when reach the "
             "end of input file for loop test (Only works with H264/H265)\n"
-            "\t-ni <loop-count>      Number of iterations [Default = 1]\n\n"
+            "\t-ni <loop-count>      Number of iterations [Default = 1]\n"
+            "\t--sync-interval <KiB> fdatasync the output every <KiB> written [Default = 0, never]\n\n"
+            "\t--metrics-port <port> Serve live metrics on http://127.0.0.1:<port>/metrics (Prometheus) and /metrics.json\n"
+            "\t--metrics-socket <path> Serve the live metrics over HTTP on a Unix socket instead\n"
+            "\t--metrics-file <path> Append a JSON line of live metrics to <path> every interval\n"
+            "\t--metrics-interval <ms> Live metrics sampling interval, FPS and latencies are over 5 intervals [Default = 1000]\n\n"
 
             "DECODER OPTIONS:\n"
             "\t--input-nalu         Input to the decoder will be nal units\n"
+            "\t--input-container    Input file is MP4 or Matroska, the decoder gets its samples with their timestamps\n"
             "\t--dec-report-metadata     Enable metadata reporting\n"
             "\t--dec-input-metadata  Enable metadata reporting for input header parsing error\n\n"
 
@@ -102,6 +109,7 @@ print_help(void)
             "\t--cd                  CABAC Disable for H264 [Default = disabled]\n"
             "\t-sir <interval>       Slice intrarefresh interval [Default = 0]\n\n"
             "\t-nbf <num>            Number of B frames [Default = 0]\n\n"
+            "\t-rpc <string>         Change configurable parameters at runtime\n\n"
             "\t-goldcrc <string>     GOLD CRC\n\n"
             "\t--enc-report-metadata Print encoder output metadata\n"
             "\t--copy-timestamp <st> Enable copy timestamp with start timestamp(st) in seconds\n"
@@ -140,6 +148,9 @@ print_help(void)
             "Supported Temporal Tradeoff levels:\n"
             "0:Drop None       1:Drop 1 in 5      2:Drop 1 in 3\n"
             "3:Drop 1 in 2     4:Drop 2 in 3\n\n"
+            "Runtime configurable parameter string should be of the form:\n"
+            "\"f<frame_num1>,<prop_id1><val>,<prop_id2><val>#f<frame_num1>,<prop_id1><val>,<prop_id2><val>#...\"\n"
+            "e.g. \"f20,b8000000,i1#f300,b6000000,r40/1\"\n\n"
             "Property ids:\n"
             "\tb<bitrate>  Bitrate\n"
             "\tp<peak_bitrate>  Peak Bitrate\n"
@@ -171,6 +182,10 @@ get_pixfmt(char *arg)
     {
         return V4L2_PIX_FMT_VP9;
     }
+    if (!strcmp(arg, "AV1"))
+    {
+        return V4L2_PIX_FMT_AV1;
+    }
     return 0;
 }
 
@@ -532,6 +547,8 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
         ctx[i]->encoder_pixfmt = get_pixfmt(*(++argp));
         CSV_PARSE_CHECK_ERROR(ctx[i]->encoder_pixfmt == 0,
                               "Incorrect encoder type");
+        CSV_PARSE_CHECK_ERROR(ctx[i]->encoder_pixfmt == V4L2_PIX_FMT_AV1,
+                              "AV1 is supported only as decoder input");
     }
 
     while ((arg = *(++argp)))
@@ -554,7 +571,7 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
             else if (!strcmp(arg, "--stats"))
             {
                 ctx[i]->stats = true;
-                ctx[i]->input_nalu = true;
+                ctx[i]->input_nalu = !ctx[i]->input_container;
             }
             else if (!strcmp(arg, "--disable-dpb"))
             {
@@ -609,6 +626,45 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
             {
                 ctx[i]->seek_mode = true;
             }
+            else if (!strcmp(arg, "--sync-interval"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                ctx[i]->sync_interval = (uint64_t) atoll(*argp) * 1024;
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-port"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                CSV_PARSE_CHECK_ERROR(atoi(*argp) <= 0 || atoi(*argp) > 65535,
+                        "Metrics port should be in 1-65535");
+                ctx[i]->metrics_port = atoi(*argp);
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-socket"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                ctx[i]->metrics_socket = *argp;
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-file"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                ctx[i]->metrics_file = *argp;
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
+            else if (!strcmp(arg, "--metrics-interval"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                CSV_PARSE_CHECK_ERROR(atoi(*argp) <= 0,
+                        "Metrics interval should be > 0");
+                ctx[i]->metrics_interval = atoi(*argp);
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
             else if (!strcmp(arg, "-ni"))
             {
                 argp++;
@@ -663,6 +719,12 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
             else if (!strcmp(arg, "--input-nalu"))
             {
                 ctx[i]->input_nalu = true;
+                ctx[i]->input_container = false;
+            }
+            else if (!strcmp(arg, "--input-container"))
+            {
+                ctx[i]->input_nalu = false;
+                ctx[i]->input_container = true;
             }
             else if (!strcmp(arg, "--insert-vui"))
             {
@@ -710,6 +772,13 @@ parse_csv_args(context_t ** ctx, int argc, char *argv[], int num_files)
             {
                 ctx[i]->enable_lossless = true;
             }
+            else if (!strcmp(arg, "-rpc"))
+            {
+                argp++;
+                CHECK_OPTION_VALUE(argp);
+                ctx[i]->runtime_params = strdup(*argp);
+                CHECK_IF_LAST_LOOP(i, num_files, argp, 1);
+            }
             else if (!strcmp(arg, "-goldcrc"))
             {
                 argp++;
@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <poll.h>
 
+#include "NvMetricsRegistry.h"
 #include "NvUtils.h"
 #include "multivideo_transcode.h"
 
@@ -56,94 +57,6 @@ abort(context_t *ctx)
     ctx->dec->abort();
 }
 
-/**
-  * Initialise CRC Rec and creates CRC Table based on the polynomial.
-  *
-  * @param CrcPolynomial : CRC Polynomial values
-  */
-static
-Crc* InitCrc(uint32_t CrcPolynomial)
-{
-    unsigned short int i;
-    unsigned short int j;
-    uint32_t tempcrc;
-    Crc *phCrc;
-    phCrc = (Crc*) malloc (sizeof(Crc));
-    if (phCrc == NULL)
-    {
-        cerr << "Mem allocation failed for Init CRC" <<endl;
-        return NULL;
-    }
-
-    memset (phCrc, 0, sizeof(Crc));
-
-    for (i = 0; i <= 255; i++)
-    {
-        tempcrc = i;
-        for (j = 8; j > 0; j--)
-        {
-            if (tempcrc & 1)
-            {
-                tempcrc = (tempcrc >> 1) ^ CrcPolynomial;
-            }
-            else
-            {
-                tempcrc >>= 1;
-            }
-        }
-        phCrc->CRCTable[i] = tempcrc;
-    }
-
-    phCrc->CrcValue = 0;
-    return phCrc;
-}
-
-/**
-  * Calculates CRC of data provided in by buffer.
-  *
-  * @param *phCrc : bitstream CRC
-  * @param buffer : process buffer
-  * @param count  : bytes used
-  */
-static
-void CalculateCrc(Crc *phCrc, unsigned char *buffer, uint32_t count)
-{
-    unsigned char *p;
-    uint32_t temp1;
-    uint32_t temp2;
-    uint32_t crc = phCrc->CrcValue;
-    uint32_t *CRCTable = phCrc->CRCTable;
-
-    if (!count)
-    {
-        return;
-    }
-
-    p = (unsigned char *) buffer;
-    while (count-- != 0)
-    {
-        temp1 = (crc >> 8) & 0x00FFFFFFL;
-        temp2 = CRCTable[((uint32_t) crc ^ *p++) & 0xFF];
-        crc = temp1 ^ temp2;
-    }
-
-    phCrc->CrcValue = crc;
-}
-
-/**
-  * Closes CRC related handles.
-  *
-  * @param *phCrc : bitstream CRC
-  */
-static
-void CloseCrc(Crc **phCrc)
-{
-    if (*phCrc)
-    {
-        free (*phCrc);
-    }
-}
-
 static void
 print_stats(int num_files)
 {
@@ -282,65 +195,37 @@ report_metadata(context_t *ctx, v4l2_ctrl_videodec_outputbuf_metadata *metadata)
 }
 
 /**
-  * Parse runtime command stream.
+  * Apply the runtime parameter changes of the current frame.
   *
-  * @param ctx   : Transcoder context
-  * @param id    : command obtained during runtime
-  * @param value : Integer value obtained during runtime
+  * @param ctx : Transcoder context
   */
 static int
-get_next_parsed_pair(context_t *ctx, char *id, uint32_t *value)
+set_runtime_params(context_t *ctx)
 {
-    char charval;
-
-    *ctx->runtime_params_str >> *id;
-    if (ctx->runtime_params_str->eof())
-    {
-        return -1;
-    }
-
-    charval = ctx->runtime_params_str->peek();
-    if (!IS_DIGIT(charval))
-    {
-        return -1;
-    }
-
-    *ctx->runtime_params_str >> *value;
+    const NvEncSchedule::NvEncScheduleChange *change;
+    const NvEncSchedule::NvEncScheduleOp *op;
+    int ret;
 
-    *ctx->runtime_params_str >> charval;
-    if (ctx->runtime_params_str->eof())
+    change = ctx->schedule->getRuntimeChange(ctx->runtime_change_index);
+    if (!change ||
+        ctx->enc->output_plane.getTotalQueuedBuffers() != change->frame)
     {
         return 0;
     }
+    ctx->runtime_change_index++;
 
-    return charval;
-}
-
-/**
-  * Set Runtime Parameters.
-  *
-  * @param ctx : Transcoder context
-  */
-static int
-set_runtime_params(context_t *ctx)
-{
-    char charval;
-    uint32_t intval;
-    int ret, next;
-
-    cout << "Frame " << ctx->next_param_change_frame <<
+    cout << "Frame " << change->frame <<
         ": Changing parameters" << endl;
-    while (!ctx->runtime_params_str->eof())
+    op = ctx->schedule->getRuntimeOps(change);
+    for (uint32_t i = 0; i < change->num_ops; i++, op++)
     {
-        next = get_next_parsed_pair(ctx, &charval, &intval);
-        TEST_PARSE_ERROR(next < 0, err);
-        switch (charval)
+        switch (op->id)
         {
             case 'b':
                 if (ctx->ratecontrol == V4L2_MPEG_VIDEO_BITRATE_MODE_VBR &&
-                    ctx->peak_bitrate < intval)
+                    ctx->peak_bitrate < op->value)
                 {
-                    uint32_t peak_bitrate = 1.2f * intval;
+                    uint32_t peak_bitrate = 1.2f * op->value;
                     cout << "Peak bitrate = " << peak_bitrate << endl;
                     ret = ctx->enc->setPeakBitrate(peak_bitrate);
                     if (ret < 0)
@@ -349,8 +234,8 @@ set_runtime_params(context_t *ctx)
                         goto err;
                     }
                 }
-                cout << "Bitrate = " << intval << endl;
-                ret = ctx->enc->setBitrate(intval);
+                cout << "Bitrate = " << op->value << endl;
+                ret = ctx->enc->setBitrate(op->value);
                 if (ret < 0)
                 {
                     cerr << "Could not set encoder bitrate" << endl;
@@ -358,8 +243,8 @@ set_runtime_params(context_t *ctx)
                 }
                 break;
             case 'p':
-                cout << "Peak bitrate = " << intval << endl;
-                ret = ctx->enc->setPeakBitrate(intval);
+                cout << "Peak bitrate = " << op->value << endl;
+                ret = ctx->enc->setPeakBitrate(op->value);
                 if (ret < 0)
                 {
                     cerr << "Could not set encoder peakbitrate" << endl;
@@ -367,53 +252,34 @@ set_runtime_params(context_t *ctx)
                 }
                 break;
             case 'r':
-            {
-                int fps_num = intval;
-                TEST_PARSE_ERROR(next != '/', err);
-
-                ctx->runtime_params_str->seekg(-1, ios::cur);
-                next = get_next_parsed_pair(ctx, &charval, &intval);
-                TEST_PARSE_ERROR(next < 0, err);
-
-                cout << "Framerate = " << fps_num << "/"  << intval << endl;
+                cout << "Framerate = " << op->value << "/"  << op->value2 << endl;
 
-                ret = ctx->enc->setFrameRate(fps_num, intval);
+                ret = ctx->enc->setFrameRate(op->value, op->value2);
                 if (ret < 0)
                 {
                     cerr << "Could not set framerate" << endl;
                     goto err;
                 }
                 break;
-            }
             case 'i':
-                if (intval > 0)
+                if (op->value > 0)
                 {
                     ctx->enc->forceIDR();
                     cout << "Forcing IDR" << endl;
                 }
                 break;
-            default:
-                TEST_PARSE_ERROR(true, err);
-        }
-        switch (next)
-        {
-            case 0:
-                delete ctx->runtime_params_str;
-                ctx->runtime_params_str = NULL;
-                return 0;
-            case '#':
-                return 0;
-            case ',':
-                break;
-            default:
-                break;
         }
     }
+
+    /* The string could not be parsed past this change. */
+    if (change->parse_error)
+    {
+        goto err;
+    }
     return 0;
 err:
     cerr << "Skipping further runtime parameter changes" <<endl;
-    delete ctx->runtime_params_str;
-    ctx->runtime_params_str = NULL;
+    ctx->runtime_change_index = ctx->schedule->getNumRuntimeChanges();
     return -1;
 }
 
@@ -453,7 +319,7 @@ read_decoder_input_chunk(context_t *ctx, NvBuffer * buffer)
 }
 
 /**
-  * Read the input chunks for Vp8/Vp9 decoder.
+  * Read the next frame for Vp8/Vp9/AV1 decoder.
   *
   * @param ctx    : Transcoder context
   * @param buffer : NvBuffer pointer
@@ -461,126 +327,117 @@ read_decoder_input_chunk(context_t *ctx, NvBuffer * buffer)
 static int
 read_vpx_decoder_input_chunk(context_t *ctx, NvBuffer * buffer)
 {
-    ifstream *stream = ctx->in_file;
-    int Framesize;
-    unsigned char *bitstreambuffer = (unsigned char *)buffer->planes[0].data;
-    if (ctx->dec_vp9_file_header_flag == 0)
+    /* Copy the next indexed frame, without its IVF frame header, in one
+       go. On end of stream bytesused is 0 and the reader is rewound. */
+    if (ctx->ivf_reader->readNextFrame(buffer) < 0)
     {
-        stream->read((char *) buffer->planes[0].data, IVF_FILE_HDR_SIZE);
-        if (stream->gcount() !=  IVF_FILE_HDR_SIZE)
-        {
-            cerr << "Couldn't read IVF FILE HEADER" << endl;
-            return -1;
-        }
-        if (!((bitstreambuffer[0] == 'D') && (bitstreambuffer[1] == 'K') &&
-                    (bitstreambuffer[2] == 'I') && (bitstreambuffer[3] == 'F')))
-        {
-            cerr << "It's not a valid IVF file \n" << endl;
-            return -1;
-        }
-        cout << "It's a valid IVF file" << endl;
-        ctx->dec_vp9_file_header_flag = 1;
+        cerr << "Could not read IVF frame from file. File corrupted" << endl;
+        return -1;
     }
-    stream->read((char *) buffer->planes[0].data, IVF_FRAME_HDR_SIZE);
+    return 0;
+}
+
+/**
+  * Read the next sample of an MP4 or Matroska file.
+  *
+  * @param ctx      : Transcoder context
+  * @param buffer   : NvBuffer pointer
+  * @param v4l2_buf : V4L2 buffer to carry the sample timestamp
+  */
+static int
+read_decoder_input_sample(context_t *ctx, NvBuffer * buffer,
+        struct v4l2_buffer * v4l2_buf)
+{
+    NvContainerReader *reader = ctx->container_reader;
+    const NvContainerReader::NvContainerSample *sample;
+    uint64_t pts;
 
-    if (!stream->gcount())
+    /* Copy the next indexed sample in one go, with start codes written
+       over the NAL unit lengths. */
+    if (reader->readNextSample(buffer, &sample) < 0)
     {
-        cout << "End of stream" << endl;
-        return 0;
+        cerr << "Could not read sample from file. File corrupted" << endl;
+        return -1;
     }
 
-    if (stream->gcount() != IVF_FRAME_HDR_SIZE)
+    if (!sample && ctx->seek_mode)
     {
-        cerr << "Couldn't read IVF FRAME HEADER" << endl;
-        return -1;
+        /* The reader has been rewound, start the next iteration. */
+        ctx->iterator_num++;
+        if (ctx->iterator_num < ctx->num_iterations)
+        {
+            if (reader->readNextSample(buffer, &sample) < 0)
+            {
+                cerr << "Could not read sample from file. File corrupted"
+                    << endl;
+                return -1;
+            }
+        }
     }
-    Framesize = (bitstreambuffer[3]<<24) + (bitstreambuffer[2]<<16) +
-        (bitstreambuffer[1]<<8) + bitstreambuffer[0];
-    buffer->planes[0].bytesused = Framesize;
-    stream->read((char *) buffer->planes[0].data, Framesize);
-    if (stream->gcount() != Framesize)
+
+    if (!sample)
     {
-        cerr << "Couldn't read Framesize" << endl;
-        return -1;
+        /* End of stream, bytesused is 0. */
+        return 0;
     }
+
+    /* Samples cut by an edit list may come before time 0. */
+    pts = sample->pts > 0 ? sample->pts : 0;
+    v4l2_buf->flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+    v4l2_buf->timestamp.tv_sec = pts / (MICROSECOND_UNIT);
+    v4l2_buf->timestamp.tv_usec = pts % (MICROSECOND_UNIT);
     return 0;
 }
 
 /**
   * Read the input NAL unit for h264/H265.
   *
-  * @param stream            : Input stream
-  * @param buffer            : NvBuffer pointer
-  * @param parse_buffer      : parse buffer pointer
-  * @param parse_buffer_size : chunk size
-  * @param ctx               : Transcoder context
+  * @param ctx    : Transcoder context
+  * @param buffer : NvBuffer pointer
   */
 static int
-read_decoder_input_nalu(context_t *ctx, NvBuffer * buffer,
-        char *parse_buffer, streamsize parse_buffer_size)
+read_decoder_input_nalu(context_t *ctx, NvBuffer * buffer)
 {
-    ifstream *stream = ctx->in_file;
-    /* Length is the size of the buffer in bytes. */
-    char *buffer_ptr = (char *) buffer->planes[0].data;
+    NvBitstreamReader *reader = ctx->bs_reader;
+    const NvBitstreamReader::NvNalUnit *nalu;
+    const uint8_t *nal_header;
     int h265_nal_unit_type;
-    char *stream_ptr;
-    bool nalu_found = false;
 
-    streamsize bytes_read;
-    streamsize stream_initial_pos = stream->tellg();
-
-    stream->read(parse_buffer, parse_buffer_size);
-    bytes_read = stream->gcount();
-    if (bytes_read == 0)
+    /* Copy the next indexed NAL unit, start code included, in one go. */
+    if (reader->readNextNalUnit(buffer, &nalu) < 0)
     {
-        stream->clear();
-        stream->seekg(0,stream->beg);
-
-        if (ctx->seek_mode)
-        {
-            ctx->iterator_num++;
-            if (ctx->iterator_num < ctx->num_iterations)
-            {
-                stream->read(parse_buffer, parse_buffer_size);
-                bytes_read = stream->gcount();
-            }
-        }
-        else
-            return buffer->planes[0].bytesused = 0;
+        cerr << "Could not read nal unit from file. File corrupted" << endl;
+        return -1;
     }
 
-    /* Find the first NAL unit in the buffer. */
-    stream_ptr = parse_buffer;
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
+    if (!nalu && ctx->seek_mode)
     {
-        nalu_found = IS_NAL_UNIT_START(stream_ptr) ||
-                    IS_NAL_UNIT_START1(stream_ptr);
-        if (nalu_found)
+        /* The reader has been rewound, start the next iteration. */
+        ctx->iterator_num++;
+        if (ctx->iterator_num < ctx->num_iterations)
         {
-            break;
+            if (reader->readNextNalUnit(buffer, &nalu) < 0)
+            {
+                cerr << "Could not read nal unit from file. File corrupted"
+                    << endl;
+                return -1;
+            }
         }
-        stream_ptr++;
     }
 
-    /* Reached end of buffer but could not find NAL unit. */
-    if (!nalu_found)
+    if (!nalu)
     {
-        cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-        return -1;
+        /* End of stream, bytesused is 0. */
+        return 0;
     }
 
-    memcpy(buffer_ptr, stream_ptr, 4);
-    buffer_ptr += 4;
-    buffer->planes[0].bytesused = 4;
-    stream_ptr += 4;
-
+    nal_header = &nalu->header;
     if (ctx->copy_timestamp)
     {
         if (ctx->decoder_pixfmt == V4L2_PIX_FMT_H264)
         {
-            if ((IS_H264_NAL_CODED_SLICE(stream_ptr)) ||
-                (IS_H264_NAL_CODED_SLICE_IDR(stream_ptr)))
+            if ((IS_H264_NAL_CODED_SLICE(nal_header)) ||
+                (IS_H264_NAL_CODED_SLICE_IDR(nal_header)))
             {
                 ctx->flag_copyts = true;
             }
@@ -591,7 +448,7 @@ read_decoder_input_nalu(context_t *ctx, NvBuffer * buffer,
         }
         else if (ctx->decoder_pixfmt == V4L2_PIX_FMT_H265)
         {
-            h265_nal_unit_type = GET_H265_NAL_UNIT_TYPE(stream_ptr);
+            h265_nal_unit_type = GET_H265_NAL_UNIT_TYPE(nal_header);
 
             if ((h265_nal_unit_type >= HEVC_NUT_TRAIL_N && h265_nal_unit_type <= HEVC_NUT_RASL_R) ||
             (h265_nal_unit_type >= HEVC_NUT_BLA_W_LP && h265_nal_unit_type <= HEVC_NUT_CRA_NUT))
@@ -605,43 +462,22 @@ read_decoder_input_nalu(context_t *ctx, NvBuffer * buffer,
         }
     }
 
-    /* Copy bytes till the next NAL unit is found. */
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
-    {
-        if (IS_NAL_UNIT_START(stream_ptr) || IS_NAL_UNIT_START1(stream_ptr))
-        {
-            streamsize seekto = stream_initial_pos +
-                    (stream_ptr - parse_buffer);
-            if (stream->eof())
-            {
-                stream->clear();
-            }
-            stream->seekg(seekto, stream->beg);
-            return 0;
-        }
-        *buffer_ptr = *stream_ptr;
-        buffer_ptr++;
-        stream_ptr++;
-        buffer->planes[0].bytesused++;
-    }
-
-    /* Reached end of buffer but could not find NAL unit. */
-    cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-    return -1;
+    return 0;
 }
 
 /**
   * Write transcoded frame data.
   *
-  * @param stream : output stream
+  * The data is copied to the sink and written to the file from its writer
+  * thread, so a slow disk does not hold up the capture plane.
+  *
+  * @param sink   : output bitstream sink
   * @param buffer : output nvbuffer
   */
 static int
-write_transcoder_output_frame(ofstream * stream, NvBuffer * buffer)
+write_transcoder_output_frame(NvBitstreamSink * sink, NvBuffer * buffer)
 {
-    stream->write((char *) buffer->planes[0].data, buffer->planes[0].bytesused);
-    return 0;
+    return sink->write(buffer->planes[0].data, buffer->planes[0].bytesused);
 }
 
 /**
@@ -698,12 +534,14 @@ encoder_capture_plane_dq_callback(struct v4l2_buffer *v4l2_buf, NvBuffer * buffe
     /* Computing CRC with each frame */
     if (ctx->pBitStreamCrc)
     {
-        CalculateCrc (ctx->pBitStreamCrc, buffer->planes[0].data, buffer->planes[0].bytesused);
+        ctx->pBitStreamCrc->update(buffer->planes[0].data, buffer->planes[0].bytesused);
     }
 
-    if (!ctx->stats)
+    if (!ctx->stats && write_transcoder_output_frame(ctx->out_file, buffer) < 0)
     {
-        write_transcoder_output_frame(ctx->out_file, buffer);
+        cerr << "Error while writing transcoded frame" << endl;
+        abort(ctx);
+        return false;
     }
 
     num_encoded_frames++;
@@ -754,34 +592,6 @@ encoder_capture_plane_dq_callback(struct v4l2_buffer *v4l2_buf, NvBuffer * buffe
     return true;
 }
 
-/**
-  * Get the next runtime parameters change for frame.
-  *
-  * @param ctx : Transcoder context
-  */
-static int
-get_next_runtime_param_change_frame(context_t *ctx)
-{
-    char charval;
-    int ret;
-
-    ret = get_next_parsed_pair(ctx, &charval, &ctx->next_param_change_frame);
-    if (ret == 0)
-    {
-        return 0;
-    }
-
-    TEST_PARSE_ERROR((ret != ';' && ret != ',') || charval != 'f', err);
-
-    return 0;
-
-err:
-    cerr << "Skipping further runtime parameter changes" <<endl;
-    delete ctx->runtime_params_str;
-    ctx->runtime_params_str = NULL;
-    return -1;
-}
-
 /**
   * Set transcoder context defaults values.
   *
@@ -803,8 +613,6 @@ set_defaults(context_t ** ctx, fps_stats **stream_stats, int files )
         ctx[i]->out_file_path = NULL;
         ctx[i]->dec_output_plane_mem_type = V4L2_MEMORY_MMAP;
         ctx[i]->dec_capture_plane_mem_type = V4L2_MEMORY_DMABUF;
-        ctx[i]->dec_vp9_file_header_flag = 0;
-        ctx[i]->dec_vp8_file_header_flag = 0;
         ctx[i]->raw_pixfmt = V4L2_PIX_FMT_YUV420M;
         ctx[i]->bitrate = 4 * 1024 * 1024;
         ctx[i]->peak_bitrate = 0;
@@ -816,6 +624,7 @@ set_defaults(context_t ** ctx, fps_stats **stream_stats, int files )
         ctx[i]->nH264FrameNumBits = 0;
         ctx[i]->nH265PocLsbBits = 0;
         ctx[i]->idr_interval = 256;
+        ctx[i]->metrics_interval = 1000;
         ctx[i]->level = -1;
         ctx[i]->fps_n = 30;
         ctx[i]->fps_d = 1;
@@ -1518,16 +1327,10 @@ dec_capture_loop_fcn(void *arg)
                 }
             }
 
-            if (ctx->runtime_params_str &&
-                (ctx->enc->output_plane.getTotalQueuedBuffers() ==
-                    ctx->next_param_change_frame))
+            /* Apply the runtime parameter changes of this frame */
+            if (ctx->schedule)
             {
-                /* Set runtime configuration parameters */
                 set_runtime_params(ctx);
-                if (ctx->runtime_params_str)
-                {
-                    get_next_runtime_param_change_frame(ctx);
-                }
             }
 
             /* Encoder supported input metadata specific configurations */
@@ -1551,6 +1354,12 @@ dec_capture_loop_fcn(void *arg)
                 v4l2_buf.timestamp.tv_sec = ctx->timestamp / (MICROSECOND_UNIT);
                 v4l2_buf.timestamp.tv_usec = ctx->timestamp % (MICROSECOND_UNIT);
             }
+            else if (ctx->input_container)
+            {
+                /* Pass on the container timestamp the decoder copied to
+                   the frame. */
+                v4l2_buf.flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+            }
 
             if (ctx->enc->output_plane.qBuffer(v4l2_buf, NULL) < 0)
             {
@@ -1579,9 +1388,8 @@ dec_capture_loop_fcn(void *arg)
   * @param eos               : end of stream
   * @param current_file      : current file
   * @param current_loop      : iterator count
-  * @param nalu_parse_buffer : input parsed nal unit
   */
-static bool transcoder_proc_blocking(context_t &ctx, bool eos, char *nalu_parse_buffer)
+static bool transcoder_proc_blocking(context_t &ctx, bool eos)
 {
     bool allow_DQ = true;
     int ret = 0;
@@ -1636,14 +1444,27 @@ static bool transcoder_proc_blocking(context_t &ctx, bool eos, char *nalu_parse_
             }
         }
 
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+        if (ctx.input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(&ctx, buffer, &v4l2_buf);
+            if (ret != 0)
+            {
+                cerr << "Couldn't read sample" << endl;
+            }
+        }
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265))
         {
             if (ctx.input_nalu)
             {
                 /* read the input nal unit. */
-                read_decoder_input_nalu(&ctx, buffer, nalu_parse_buffer,
-                        CHUNK_SIZE);
+                ret = read_decoder_input_nalu(&ctx, buffer);
+                if (ret < 0)
+                {
+                    abort(&ctx);
+                    break;
+                }
             }
             else
             {
@@ -1651,8 +1472,8 @@ static bool transcoder_proc_blocking(context_t &ctx, bool eos, char *nalu_parse_
                 read_decoder_input_chunk(&ctx, buffer);
             }
         }
-
-        if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8)
+        else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+                ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
         {
             /* read the input chunks. */
             ret = read_vpx_decoder_input_chunk(&ctx, buffer);
@@ -1696,7 +1517,6 @@ transcode_proc(void * p_ctx)
     int error = 0;
     int * perror = (int *)malloc(sizeof(int));
     bool eos = false;
-    char *nalu_parse_buffer = NULL;
     uint32_t i;
     NvElementProfiler::NvElementProfilerData enc_data;
     NvElementProfiler::NvElementProfilerData dec_data;
@@ -1711,8 +1531,53 @@ transcode_proc(void * p_ctx)
     ctx.in_file = new ifstream(ctx.in_file_path);
     TEST_ERROR(!ctx.in_file->is_open(), "Error opening input file", cleanup);
 
-    ctx.out_file = new ofstream(ctx.out_file_path);
-    TEST_ERROR(!ctx.out_file->is_open(), "Error opening output file", cleanup);
+    if (ctx.runtime_params)
+    {
+        /* Parse the runtime parameter changes up front, so that the decoder
+           capture loop only looks up the change of each frame */
+        NvEncSchedule::NvEncScheduleSources sources;
+
+        memset(&sources, 0, sizeof(sources));
+        sources.runtime_params = ctx.runtime_params;
+        ctx.schedule = NvEncSchedule::createEncSchedule(sources);
+        TEST_ERROR(!ctx.schedule, "Could not parse runtime parameter changes", cleanup);
+    }
+
+    /* NAL unit input is served from a memory mapped index of the file. */
+    if (ctx.input_nalu)
+    {
+        ctx.bs_reader =
+            NvBitstreamReader::createBitstreamReader(ctx.in_file_path);
+        TEST_ERROR(!ctx.bs_reader, "Error indexing input file", cleanup);
+    }
+
+    /* Container input is served from a memory mapped sample index of the
+       MP4 or Matroska file. */
+    if (ctx.input_container)
+    {
+        ctx.container_reader =
+            NvContainerReader::createContainerReader(ctx.in_file_path);
+        TEST_ERROR(!ctx.container_reader, "Error indexing input file", cleanup);
+        if (ctx.container_reader->getPixelFormat() != ctx.decoder_pixfmt)
+        {
+            cerr << "Warning: Video codec of " << ctx.in_file_path <<
+                " does not match the decoder format" << endl;
+        }
+    }
+    /* VP8/VP9/AV1 input is served from a memory mapped frame index of
+       the IVF file. */
+    else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 ||
+            ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+            ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        ctx.ivf_reader = NvIvfReader::createIvfReader(ctx.in_file_path);
+        TEST_ERROR(!ctx.ivf_reader, "Error indexing input file", cleanup);
+    }
+
+    ctx.out_file = NvBitstreamSink::createBitstreamSink(
+            ("out" + to_string(ctx.thread_num)).c_str(), ctx.out_file_path,
+            8 * 1024 * 1024, ctx.sync_interval);
+    TEST_ERROR(!ctx.out_file, "Error opening output file", cleanup);
 
     ret = ctx.dec->subscribeEvent(V4L2_EVENT_RESOLUTION_CHANGE, 0, 0);
     TEST_ERROR(ret < 0, "Could not subscribe to V4L2_EVENT_RESOLUTION_CHANGE",
@@ -1721,8 +1586,8 @@ transcode_proc(void * p_ctx)
     if (ctx.use_gold_crc)
     {
         /* CRC specific initializetion if gold_crc flag is set */
-        ctx.pBitStreamCrc = InitCrc(CRC32_POLYNOMIAL);
-        TEST_ERROR(!ctx.pBitStreamCrc, "InitCrc failed", cleanup);
+        ctx.pBitStreamCrc = NvCrc::createCrc(NV_CRC32_POLYNOMIAL);
+        TEST_ERROR(!ctx.pBitStreamCrc, "Could not create CRC", cleanup);
     }
 
     if (ctx.stats)
@@ -1731,15 +1596,25 @@ transcode_proc(void * p_ctx)
         ctx.enc->enableProfiling();
     }
 
+    /* Live metrics need both profilers. Only the encoder is labeled with the
+       stream so the stream total counts each transcoded frame once. */
+    if (ctx.metrics_port || ctx.metrics_socket || ctx.metrics_file)
+    {
+        ctx.dec->enableProfiling();
+        ctx.enc->enableProfiling();
+        NvMetricsRegistry::getInstance().registerStream(ctx.enc,
+                ctx.in_file_path);
+    }
+
     ret = ctx.dec->setOutputPlaneFormat(ctx.decoder_pixfmt, CHUNK_SIZE);
     TEST_ERROR(ret < 0, "Could not set output plane format", cleanup);
 
     /* Configure for frame input mode for decoder.
        Refer V4L2_CID_MPEG_VIDEO_DISABLE_COMPLETE_FRAME_INPUT */
-    if (ctx.input_nalu)
+    if (ctx.input_nalu || ctx.input_container)
     {
-         /* Input to the decoder will be nal units. */
-         nalu_parse_buffer = new char[CHUNK_SIZE];
+         /* Input to the decoder will be nal units, or whole samples of a
+            container. */
          ret = ctx.dec->setFrameInputMode(0);
          TEST_ERROR(ret < 0,
                  "Error in decoder setFrameInputMode", cleanup);
@@ -1824,14 +1699,27 @@ transcode_proc(void * p_ctx)
         memset(planes, 0, sizeof(planes));
 
         buffer = ctx.dec->output_plane.getNthBuffer(i);
-        if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
+        if (ctx.input_container)
+        {
+            /* read the next sample with its timestamp. */
+            ret = read_decoder_input_sample(&ctx, buffer, &v4l2_buf);
+            if (ret != 0)
+            {
+                cerr << "Couldn't read sample" << endl;
+            }
+        }
+        else if ((ctx.decoder_pixfmt == V4L2_PIX_FMT_H264) ||
                 (ctx.decoder_pixfmt == V4L2_PIX_FMT_H265))
         {
             if (ctx.input_nalu)
             {
                 /* read the input nal unit. */
-                read_decoder_input_nalu(&ctx, buffer, nalu_parse_buffer,
-                        CHUNK_SIZE);
+                ret = read_decoder_input_nalu(&ctx, buffer);
+                if (ret < 0)
+                {
+                    abort(&ctx);
+                    break;
+                }
             }
             else
             {
@@ -1839,8 +1727,8 @@ transcode_proc(void * p_ctx)
                 read_decoder_input_chunk(&ctx, buffer);
             }
         }
-
-        if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8)
+        else if (ctx.decoder_pixfmt == V4L2_PIX_FMT_VP9 || ctx.decoder_pixfmt == V4L2_PIX_FMT_VP8 ||
+                ctx.decoder_pixfmt == V4L2_PIX_FMT_AV1)
         {
             /* read the input chunks. */
             ret = read_vpx_decoder_input_chunk(&ctx, buffer);
@@ -1892,7 +1780,7 @@ transcode_proc(void * p_ctx)
         /* Set thread name for decoder Capture Plane thread. */
     pthread_setname_np(ctx.dec_capture_loop, "DecCapPlane");
 
-    eos = transcoder_proc_blocking(ctx, eos, nalu_parse_buffer);
+    eos = transcoder_proc_blocking(ctx, eos);
 
     while (ctx.dec->output_plane.getNumQueuedBuffers() > 0 &&
            !ctx.got_error && !ctx.dec->isInError())
@@ -1990,9 +1878,8 @@ cleanup:
     if (ctx.pBitStreamCrc)
     {
         char *pgold_crc = ctx.gold_crc;
-        Crc *pout_crc= ctx.pBitStreamCrc;
         char StrCrcValue[20];
-        snprintf (StrCrcValue, 20, "%u", pout_crc->CrcValue);
+        snprintf (StrCrcValue, 20, "%u", ctx.pBitStreamCrc->getValue());
         /* Remove CRLF from end of CRC, if present */
         do {
                 uint32_t len = strlen(pgold_crc);
@@ -2030,7 +1917,8 @@ cleanup:
             cout << "======================" << endl;
         }
 
-        CloseCrc(&ctx.pBitStreamCrc);
+        delete ctx.pBitStreamCrc;
+        ctx.pBitStreamCrc = NULL;
     }
 
     ctx.dec->output_plane.deinitPlane();
@@ -2041,17 +1929,31 @@ cleanup:
 
     ctx.enc->capture_plane.deinitPlane();
 
+    if (ctx.out_file && !ctx.stats)
+    {
+        /* Wait for the writer so that the stats cover the whole stream. */
+        if (ctx.out_file->flush() < 0)
+        {
+            cerr << "Error while writing output file" << endl;
+            error = 1;
+        }
+        ctx.out_file->printStats(cout);
+    }
+
     /* Release encoder configuration specific resources. */
     delete ctx.enc;
     delete ctx.dec;
     delete ctx.in_file;
     delete ctx.out_file;
     delete ctx.recon_Ref_file;
-    delete[] nalu_parse_buffer;
+    delete ctx.bs_reader;
+    delete ctx.ivf_reader;
+    delete ctx.container_reader;
 
     free(ctx.in_file_path);
     free(ctx.out_file_path);
-    delete ctx.runtime_params_str;
+    delete ctx.schedule;
+    free(ctx.runtime_params);
 
     if (!ctx.blocking_mode)
     {
@@ -2117,6 +2019,19 @@ main(int argc, char *argv[])
 
         iterations = ctx[0]->num_iterations;
         stats = ctx[0]->stats;
+        if (ctx[0]->metrics_port || ctx[0]->metrics_socket ||
+                ctx[0]->metrics_file)
+        {
+            /* Keeps running across iterations. */
+            if (NvMetricsRegistry::getInstance().startExporter(
+                        ctx[0]->metrics_interval, 5 * ctx[0]->metrics_interval,
+                        ctx[0]->metrics_port, ctx[0]->metrics_socket,
+                        ctx[0]->metrics_file) < 0)
+            {
+                fprintf(stderr, "Could not start metrics exporter\n");
+                return -1;
+            }
+        }
         for (int i = 0 ; i < num_files ; i++)
         {
             /* Spawn multiple decoding threads for multiple decoders. */
@@ -2151,6 +2066,7 @@ main(int argc, char *argv[])
         }
     } while(!ctx[0]->seek_mode && iterator_num < iterations);
 
+    NvMetricsRegistry::getInstance().stopExporter();
     free (ctx);
 
     /* Report application run status on exit. */
@@ -32,6 +32,7 @@
 #include "NvVideoConverter.h"
 #include "NvEglRenderer.h"
 #include "NvJpegEncoder.h"
+#include "NvBitstreamReader.h"
 #include <queue>
 #include <utility>
 #include <map>
@@ -168,6 +169,7 @@ typedef struct backend_context
 
     char *in_file_path;
     std::ifstream *in_file;
+    NvBitstreamReader *bs_reader;
 
     char *out_file_path;
     std::ofstream *out_file;
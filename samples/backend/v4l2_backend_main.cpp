@@ -82,76 +82,17 @@ static uint64_t ts[CHANNEL_NUM];
 static uint64_t time_scale[CHANNEL_NUM];
 
 static int
-read_decoder_input_nalu(ifstream * stream, NvBuffer * buffer,
-        char *parse_buffer, streamsize parse_buffer_size)
+read_decoder_input_nalu(NvBitstreamReader * reader, NvBuffer * buffer)
 {
-    // Length is the size of the buffer in bytes
-    char *buffer_ptr = (char *) buffer->planes[0].data;
-
-    char *stream_ptr;
-    bool nalu_found = false;
-
-    streamsize bytes_read;
-    streamsize stream_initial_pos = stream->tellg();
-
-    stream->read(parse_buffer, parse_buffer_size);
-    bytes_read = stream->gcount();
-
-    if (bytes_read == 0)
-    {
-        return buffer->planes[0].bytesused = 0;
-    }
-
-    // Find the first NAL unit in the buffer
-    stream_ptr = parse_buffer;
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
-    {
-        nalu_found = IS_NAL_UNIT_START(stream_ptr) ||
-                        IS_NAL_UNIT_START1(stream_ptr);
-        if (nalu_found)
-        {
-            break;
-        }
-        stream_ptr++;
-    }
-
-    // Reached end of buffer but could not find NAL unit
-    if (!nalu_found)
+    // Copy the next indexed NAL unit, start code included, in one go.
+    // At end of stream bytesused is 0 and the reader is rewound.
+    if (reader->readNextNalUnit(buffer) < 0)
     {
-        cerr << "Could not read nal unit from file. EOF or file corrupted"
+        cerr << "Could not read nal unit from file. File corrupted"
             << endl;
         return -1;
     }
-
-    memcpy(buffer_ptr, stream_ptr, 4);
-    buffer_ptr += 4;
-    buffer->planes[0].bytesused = 4;
-    stream_ptr += 4;
-
-    // Copy bytes till the next NAL unit is found
-    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
-    {
-        if (IS_NAL_UNIT_START(stream_ptr) || IS_NAL_UNIT_START1(stream_ptr))
-        {
-            streamsize seekto = stream_initial_pos +
-                    (stream_ptr - parse_buffer);
-            if (stream->eof())
-            {
-                stream->clear();
-            }
-            stream->seekg(seekto, stream->beg);
-            return 0;
-        }
-        *buffer_ptr = *stream_ptr;
-        buffer_ptr++;
-        stream_ptr++;
-        buffer->planes[0].bytesused++;
-    }
-
-    // Reached end of buffer but could not find NAL unit
-    cerr << "Could not read nal unit from file. EOF or file corrupted"
-            << endl;
-    return -1;
+    return 0;
 }
 
 static int
@@ -936,14 +877,8 @@ dec_feed_loop_fcn(void *arg)
     int i = 0;
     bool eos = false;
     int ret;
-    char *nalu_parse_buffer = NULL;
     nal_type_e nal_type;
 
-    if (ctx->input_nalu)
-    {
-        nalu_parse_buffer = new char[CHUNK_SIZE];
-    }
-
     // Read encoded data and enqueue all the output plane buffers.
     // Exit loop in case file read is complete.
     while (!eos && !ctx->got_error && !ctx->dec->isInError() &&
@@ -959,8 +894,12 @@ dec_feed_loop_fcn(void *arg)
         buffer = ctx->dec->output_plane.getNthBuffer(i);
         if (ctx->input_nalu)
         {
-            read_decoder_input_nalu(ctx->in_file, buffer,
-                    nalu_parse_buffer, CHUNK_SIZE);
+            ret = read_decoder_input_nalu(ctx->bs_reader, buffer);
+            if (ret < 0)
+            {
+                ctx->got_error = true;
+                break;
+            }
             wait_for_nextFrame(ctx);
         }
         else
@@ -1040,8 +979,12 @@ dec_feed_loop_fcn(void *arg)
 
         if (ctx->input_nalu)
         {
-            read_decoder_input_nalu(ctx->in_file, buffer,
-                                    nalu_parse_buffer, CHUNK_SIZE);
+            ret = read_decoder_input_nalu(ctx->bs_reader, buffer);
+            if (ret < 0)
+            {
+                ctx->got_error = true;
+                break;
+            }
             wait_for_nextFrame(ctx);
         }
         else
@@ -1113,11 +1056,6 @@ dec_feed_loop_fcn(void *arg)
         }
     }
 
-    if (ctx->input_nalu)
-    {
-        delete []nalu_parse_buffer;
-    }
-
     ctx->got_eos = true;
     return NULL;
 }
@@ -1300,6 +1238,15 @@ main(int argc, char *argv[])
         TEST_ERROR(!ctx[iterator].in_file->is_open(),
                 "Error opening input file", cleanup);
 
+        // NAL unit input is served from a memory mapped index of the file
+        if (ctx[iterator].input_nalu)
+        {
+            ctx[iterator].bs_reader = NvBitstreamReader::createBitstreamReader(
+                    ctx[iterator].in_file_path);
+            TEST_ERROR(!ctx[iterator].bs_reader,
+                    "Error indexing input file", cleanup);
+        }
+
         if (ctx[iterator].out_file_path)
         {
             ctx[iterator].out_file = new ofstream(ctx[iterator].out_file_path);
@@ -1400,6 +1347,7 @@ cleanup:
         delete ctx[iterator].dec;
         // Similarly, EglRenderer destructor does all the cleanup
         delete ctx[iterator].in_file;
+        delete ctx[iterator].bs_reader;
         delete ctx[iterator].out_file;
         delete ctx[iterator].render_buf_queue;
         if (ctx[iterator].nvosd_context)
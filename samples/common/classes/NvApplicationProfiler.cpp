@@ -27,16 +27,29 @@
  */
 
 #include "NvApplicationProfiler.h"
+#include "NvMetricsRegistry.h"
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #define GOVERNOR_SYS_FILE "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor"
 #define CPU_FREQ_FILE "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq"
 #define REQUIRED_GOVERNOR "performance"
+#define PROC_STAT_FILE "/proc/stat"
+#define PROC_STATM_FILE "/proc/self/statm"
+#define PROC_TASK_DIR "/proc/self/task"
+#define PRINT_MAX_THREADS 32
 
 #define TIMESPEC_DIFF_USEC(timespec1, timespec2) \
     (timespec1.tv_sec - timespec2.tv_sec) * 1000000.0 + \
@@ -44,10 +57,42 @@
 
 using namespace std;
 
+static uint64_t
+monotonicNsec()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * Re-reads a procfs file from its start into buf, NUL terminated.
+ * Returns the number of bytes read, 0 if the file is gone or empty.
+ */
+static ssize_t
+readProcFile(int fd, char *buf, size_t size)
+{
+    ssize_t len;
+
+    do
+    {
+        len = pread(fd, buf, size - 1, 0);
+    } while (len < 0 && errno == EINTR);
+
+    if (len <= 0)
+    {
+        buf[0] = '\0';
+        return 0;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
 NvApplicationProfiler::NvApplicationProfiler()
 {
-    char governor[64];
-    uint64_t cpu_freq_khz;
+    char governor[64] = "";
+    uint64_t cpu_freq_khz = 0;
 
     memset(&data, 0, sizeof(data));
 
@@ -66,11 +111,22 @@ NvApplicationProfiler::NvApplicationProfiler()
     if (strcmp(governor, REQUIRED_GOVERNOR))
     {
         cerr << "Set governor to " REQUIRED_GOVERNOR " before enabling profiler"
-            << endl;
+            " to measure the process CPU usage" << endl;
         check_cpu_usage = false;
     }
     num_cpu_cores = sysconf(_SC_NPROCESSORS_ONLN);
 
+    num_untracked_threads = 0;
+    last_scan_ns = 0;
+    proc_stat_fd = -1;
+    statm_fd = -1;
+    page_size_kb = sysconf(_SC_PAGESIZE) / 1024;
+    first_major_faults = 0;
+    last_major_faults = 0;
+    peak_rss_kb = 0;
+    sum_rss_kb = 0;
+    num_rss_readings = 0;
+
     ifstream cpu_freq_file(CPU_FREQ_FILE, std::ifstream::in);
     cpu_freq_file >> cpu_freq_khz;
     cpu_freq = cpu_freq_khz / 1000;
@@ -95,19 +151,23 @@ NvApplicationProfiler::start(uint32_t sampling_interval_ms)
         return;
     }
 
-    if (!check_cpu_usage)
-    {
-        cerr << "Set governor to " REQUIRED_GOVERNOR " before enabling profiler"
-            << endl;
-        pthread_mutex_unlock(&thread_lock);
-        return;
-    }
-
     running = true;
     sampling_interval = sampling_interval_ms;
 
     memset(&data, 0, sizeof(data));
 
+    /* Thread, core and memory accounting does not depend on the governor. */
+    closeAccountingFiles();
+    threads.clear();
+    cores.clear();
+    num_untracked_threads = 0;
+    last_scan_ns = 0;
+    peak_rss_kb = 0;
+    sum_rss_kb = 0;
+    num_rss_readings = 0;
+    proc_stat_fd = open(PROC_STAT_FILE, O_RDONLY | O_CLOEXEC);
+    statm_fd = open(PROC_STATM_FILE, O_RDONLY | O_CLOEXEC);
+
     gettimeofday(&data.start_time, NULL);
 
     if (check_cpu_usage)
@@ -120,19 +180,354 @@ NvApplicationProfiler::start(uint32_t sampling_interval_ms)
     pthread_setname_np(profiling_thread, "ProfilingThread");
 
     pthread_mutex_unlock(&thread_lock);
+
+    NvMetricsRegistry::getInstance().setApplicationProfiler(this);
 }
 
 void
 NvApplicationProfiler::stop()
 {
+    /* Several users may share the profiler; only the first stop joins. */
+    pthread_mutex_lock(&thread_lock);
+    if (!running)
+    {
+        pthread_mutex_unlock(&thread_lock);
+        return;
+    }
     running = false;
+    pthread_mutex_unlock(&thread_lock);
     pthread_join(profiling_thread, NULL);
 
     pthread_mutex_lock(&thread_lock);
     gettimeofday(&data.stop_time, NULL);
+    closeAccountingFiles();
     pthread_mutex_unlock(&thread_lock);
 }
 
+void
+NvApplicationProfiler::closeAccountingFiles()
+{
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        if (threads[i].stat_fd >= 0)
+        {
+            close(threads[i].stat_fd);
+            threads[i].stat_fd = -1;
+        }
+        if (threads[i].schedstat_fd >= 0)
+        {
+            close(threads[i].schedstat_fd);
+            threads[i].schedstat_fd = -1;
+        }
+    }
+    if (proc_stat_fd >= 0)
+    {
+        close(proc_stat_fd);
+        proc_stat_fd = -1;
+    }
+    if (statm_fd >= 0)
+    {
+        close(statm_fd);
+        statm_fd = -1;
+    }
+}
+
+void
+NvApplicationProfiler::profileThreads(uint64_t now_ns)
+{
+    static const uint64_t ns_per_tick = 1000000000ULL / sysconf(_SC_CLK_TCK);
+    char path[64];
+    char buf[512];
+    uint32_t untracked = 0;
+    struct dirent *entry;
+    DIR *dir;
+
+    dir = opendir(PROC_TASK_DIR);
+    if (!dir)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].seen = false;
+    }
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        pid_t tid = atoi(entry->d_name);
+        ThreadState *thread = NULL;
+
+        if (tid <= 0)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            if (threads[i].data.tid == tid && !threads[i].data.exited)
+            {
+                thread = &threads[i];
+                break;
+            }
+        }
+
+        if (!thread)
+        {
+            ThreadState state;
+
+            memset(&state, 0, sizeof(state));
+            snprintf(path, sizeof(path), PROC_TASK_DIR "/%d/stat", tid);
+            state.stat_fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (state.stat_fd < 0)
+            {
+                /* Exited since the directory was listed. */
+                continue;
+            }
+            snprintf(path, sizeof(path), PROC_TASK_DIR "/%d/schedstat", tid);
+            state.schedstat_fd = open(path, O_RDONLY | O_CLOEXEC);
+            state.data.tid = tid;
+            /* Threads started after the first scan used all of their CPU
+               time while profiling, older ones are measured from now on. */
+            state.first_time_ns = data.num_readings ? last_scan_ns : now_ns;
+            state.last_time_ns = state.first_time_ns;
+
+            if (threads.size() < MaxProfiledThreads)
+            {
+                threads.push_back(state);
+                thread = &threads.back();
+            }
+            else
+            {
+                ThreadState *victim = NULL;
+
+                for (size_t i = 0; i < threads.size(); i++)
+                {
+                    if (threads[i].data.exited && (!victim ||
+                        threads[i].data.cpu_time_ms < victim->data.cpu_time_ms))
+                    {
+                        victim = &threads[i];
+                    }
+                }
+                if (!victim)
+                {
+                    close(state.stat_fd);
+                    if (state.schedstat_fd >= 0)
+                    {
+                        close(state.schedstat_fd);
+                    }
+                    untracked++;
+                    continue;
+                }
+                *victim = state;
+                thread = victim;
+            }
+        }
+        thread->seen = true;
+
+        /* Name and, without schedstats, CPU time come from stat. The name
+           is between the first '(' and the last ')' as it may hold both. */
+        uint64_t cpu_ns = 0, delay_ns = 0, switches = 0;
+        if (!readProcFile(thread->stat_fd, buf, sizeof(buf)))
+        {
+            thread->seen = false;
+            continue;
+        }
+        char *name_start = strchr(buf, '(');
+        char *name_end = strrchr(buf, ')');
+        if (!name_start || !name_end || name_end < name_start)
+        {
+            continue;
+        }
+        size_t name_len = std::min<size_t>(name_end - name_start - 1,
+                sizeof(thread->data.name) - 1);
+        memcpy(thread->data.name, name_start + 1, name_len);
+        thread->data.name[name_len] = '\0';
+
+        if (thread->schedstat_fd >= 0)
+        {
+            char schedstat[128];
+            unsigned long long run, wait, slices;
+
+            if (readProcFile(thread->schedstat_fd, schedstat, sizeof(schedstat))
+                && sscanf(schedstat, "%llu %llu %llu", &run, &wait, &slices) == 3)
+            {
+                cpu_ns = run;
+                delay_ns = wait;
+                switches = slices;
+            }
+        }
+        if (!cpu_ns)
+        {
+            /* utime and stime are fields 14 and 15, the state field 3 is
+               right after the name. */
+            unsigned long long utime = 0, stime = 0;
+            if (sscanf(name_end + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u "
+                       "%*u %*u %llu %llu", &utime, &stime) == 2)
+            {
+                cpu_ns = (utime + stime) * ns_per_tick;
+            }
+        }
+
+        /* Timestamp each thread separately, the scan itself takes time. */
+        uint64_t read_ns = monotonicNsec();
+        if (thread->last_time_ns == thread->first_time_ns &&
+            thread->first_time_ns == now_ns)
+        {
+            thread->first_cpu_ns = cpu_ns;
+            thread->first_delay_ns = delay_ns;
+            thread->first_switches = switches;
+        }
+        else if (read_ns > thread->last_time_ns)
+        {
+            /* The run time of a thread on a CPU is only brought up to date
+               at scheduler ticks, so short intervals can read above 100%. */
+            float usage = std::min(100.0f,
+                    (cpu_ns - thread->last_cpu_ns) * 100.0f /
+                    (read_ns - thread->last_time_ns));
+            if (usage > thread->data.peak_cpu_usage)
+            {
+                thread->data.peak_cpu_usage = usage;
+            }
+        }
+        thread->last_cpu_ns = cpu_ns;
+        thread->last_delay_ns = delay_ns;
+        thread->last_switches = switches;
+        thread->last_time_ns = read_ns;
+        if (thread->first_time_ns == now_ns)
+        {
+            thread->first_time_ns = read_ns;
+        }
+
+        thread->data.cpu_time_ms =
+            (thread->last_cpu_ns - thread->first_cpu_ns) / 1000000;
+        thread->data.run_delay_ms =
+            (thread->last_delay_ns - thread->first_delay_ns) / 1000000;
+        thread->data.context_switches =
+            thread->last_switches - thread->first_switches;
+        if (thread->last_time_ns > thread->first_time_ns)
+        {
+            thread->data.avg_cpu_usage =
+                (thread->last_cpu_ns - thread->first_cpu_ns) * 100.0f /
+                (thread->last_time_ns - thread->first_time_ns);
+        }
+    }
+    closedir(dir);
+
+    /* Threads no longer listed have exited, keep their totals. */
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        if (!threads[i].seen && !threads[i].data.exited)
+        {
+            threads[i].data.exited = true;
+            close(threads[i].stat_fd);
+            threads[i].stat_fd = -1;
+            if (threads[i].schedstat_fd >= 0)
+            {
+                close(threads[i].schedstat_fd);
+                threads[i].schedstat_fd = -1;
+            }
+        }
+    }
+
+    if (untracked > num_untracked_threads)
+    {
+        num_untracked_threads = untracked;
+    }
+    last_scan_ns = now_ns;
+}
+
+void
+NvApplicationProfiler::profileCores()
+{
+    char buf[16384];
+    char *line = buf;
+
+    if (proc_stat_fd < 0 || !readProcFile(proc_stat_fd, buf, sizeof(buf)))
+    {
+        return;
+    }
+
+    /* Per-core lines "cpuN user nice system idle iowait irq softirq steal"
+       follow the aggregate "cpu" line. */
+    while (line && !strncmp(line, "cpu", 3))
+    {
+        unsigned long long user = 0, nice = 0, system = 0, idle = 0;
+        unsigned long long iowait = 0, irq = 0, softirq = 0, steal = 0;
+        unsigned int id;
+
+        if (sscanf(line, "cpu%u %llu %llu %llu %llu %llu %llu %llu %llu", &id,
+                   &user, &nice, &system, &idle, &iowait, &irq, &softirq,
+                   &steal) >= 5 && id < MaxProfiledCores)
+        {
+            uint64_t busy = user + nice + system + irq + softirq + steal;
+            uint64_t total = busy + idle + iowait;
+
+            if (id >= cores.size())
+            {
+                CoreState core;
+
+                memset(&core, 0, sizeof(core));
+                cores.resize(id + 1, core);
+            }
+
+            CoreState &core = cores[id];
+            if (!core.first_total)
+            {
+                core.first_busy = busy;
+                core.first_total = total;
+            }
+            else if (total > core.last_total)
+            {
+                float usage = (busy - core.last_busy) * 100.0f /
+                    (total - core.last_total);
+                if (usage > core.peak_usage)
+                {
+                    core.peak_usage = usage;
+                }
+            }
+            core.last_busy = busy;
+            core.last_total = total;
+        }
+
+        line = strchr(line, '\n');
+        if (line)
+        {
+            line++;
+        }
+    }
+}
+
+void
+NvApplicationProfiler::profileMemory()
+{
+    struct rusage usage;
+    char buf[128];
+    unsigned long size, resident;
+
+    if (statm_fd >= 0 && readProcFile(statm_fd, buf, sizeof(buf)) &&
+        sscanf(buf, "%lu %lu", &size, &resident) == 2)
+    {
+        uint64_t rss_kb = resident * page_size_kb;
+
+        if (rss_kb > peak_rss_kb)
+        {
+            peak_rss_kb = rss_kb;
+        }
+        sum_rss_kb += rss_kb;
+        num_rss_readings++;
+    }
+
+    if (!getrusage(RUSAGE_SELF, &usage))
+    {
+        if (!data.num_readings)
+        {
+            first_major_faults = usage.ru_majflt;
+        }
+        last_major_faults = usage.ru_majflt;
+    }
+}
+
 void
 NvApplicationProfiler::profile()
 {
@@ -166,6 +561,11 @@ NvApplicationProfiler::profile()
         data.stop_proc_cpu_clock_time = cur_proc_cpu_clock_time;
         data.stop_cpu_clock_time = cur_cpu_clock_time;
     }
+
+    profileThreads(monotonicNsec());
+    profileCores();
+    profileMemory();
+
     data.num_readings++;
 }
 
@@ -219,20 +619,60 @@ NvApplicationProfiler::getProfilerData(NvAppProfilerData &pdata)
         pdata.peak_cpu_usage = data.max_cpu_usage / num_cpu_cores;
         pdata.avg_cpu_usage = proc_cpu_time * 100 / total_cpu_time / num_cpu_cores;
 
-        pdata.total_time.tv_sec = data.stop_time.tv_sec - data.start_time.tv_sec;
-        pdata.total_time.tv_usec = data.stop_time.tv_usec - data.start_time.tv_usec;
-        if (pdata.total_time.tv_usec < 0)
+        pdata.cpu_freq_mhz = cpu_freq;
+    }
+
+    /* A running profiler reports the time profiled so far. */
+    struct timeval stop_time = data.stop_time;
+    if (running)
+    {
+        gettimeofday(&stop_time, NULL);
+    }
+    pdata.total_time.tv_sec = stop_time.tv_sec - data.start_time.tv_sec;
+    pdata.total_time.tv_usec = stop_time.tv_usec - data.start_time.tv_usec;
+    if (pdata.total_time.tv_usec < 0)
+    {
+        pdata.total_time.tv_sec--;
+        pdata.total_time.tv_usec += 1000000;
+    }
+    pdata.num_cpu_cores = num_cpu_cores;
+
+    pdata.num_threads = threads.size();
+    pdata.num_untracked_threads = num_untracked_threads;
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        pdata.threads[i] = threads[i].data;
+    }
+
+    pdata.num_cores = cores.size();
+    for (size_t i = 0; i < cores.size(); i++)
+    {
+        pdata.core_peak_usage[i] = cores[i].peak_usage;
+        if (cores[i].last_total > cores[i].first_total)
         {
-            pdata.total_time.tv_sec--;
-            pdata.total_time.tv_usec += 1000000;
+            pdata.core_avg_usage[i] =
+                (cores[i].last_busy - cores[i].first_busy) * 100.0f /
+                (cores[i].last_total - cores[i].first_total);
         }
+    }
 
-        pdata.num_cpu_cores = num_cpu_cores;
-        pdata.cpu_freq_mhz = cpu_freq;
+    pdata.peak_rss_kb = peak_rss_kb;
+    if (num_rss_readings)
+    {
+        pdata.avg_rss_kb = sum_rss_kb / num_rss_readings;
     }
+    pdata.major_faults = last_major_faults - first_major_faults;
 
     pthread_mutex_unlock(&thread_lock);
 }
+
+static bool
+compareThreadCpuTime(const NvApplicationProfiler::NvAppThreadProfilerData *a,
+        const NvApplicationProfiler::NvAppThreadProfilerData *b)
+{
+    return a->cpu_time_ms > b->cpu_time_ms;
+}
+
 void
 NvApplicationProfiler::printProfilerData(std::ostream &outstream)
 {
@@ -249,6 +689,70 @@ NvApplicationProfiler::printProfilerData(std::ostream &outstream)
         outstream << "Num. of Cores = " << data.num_cpu_cores << endl;
         outstream << "CPU frequency = " << data.cpu_freq_mhz << "MHz" << endl;
     }
+
+    if (data.num_threads)
+    {
+        vector<NvAppThreadProfilerData *> sorted;
+        for (uint32_t i = 0; i < data.num_threads; i++)
+        {
+            sorted.push_back(&data.threads[i]);
+        }
+        sort(sorted.begin(), sorted.end(), compareThreadCpuTime);
+
+        outstream << "Per-thread CPU usage (% of one core):" << endl;
+        outstream << "  " << left << setw(16) << "Thread" << right <<
+            setw(8) << "TID" << setw(10) << "Avg" << setw(10) << "Peak" <<
+            setw(12) << "CPU ms" << setw(12) << "Delay ms" <<
+            setw(12) << "Switches" << endl;
+        for (size_t i = 0; i < sorted.size() && i < PRINT_MAX_THREADS; i++)
+        {
+            NvAppThreadProfilerData *thread = sorted[i];
+            outstream << "  " << left << setw(16) << thread->name << right <<
+                setw(8) << thread->tid << fixed << setprecision(1) <<
+                setw(10) << thread->avg_cpu_usage <<
+                setw(10) << thread->peak_cpu_usage <<
+                setw(12) << thread->cpu_time_ms <<
+                setw(12) << thread->run_delay_ms <<
+                setw(12) << thread->context_switches <<
+                (thread->exited ? "  (exited)" : "") << endl;
+        }
+        outstream.unsetf(ios::floatfield);
+        outstream << setprecision(6);
+        if (sorted.size() > PRINT_MAX_THREADS)
+        {
+            uint64_t cpu_time_ms = 0;
+            for (size_t i = PRINT_MAX_THREADS; i < sorted.size(); i++)
+            {
+                cpu_time_ms += sorted[i]->cpu_time_ms;
+            }
+            outstream << "  " << sorted.size() - PRINT_MAX_THREADS <<
+                " less busy threads used " << cpu_time_ms << " ms" << endl;
+        }
+        if (data.num_untracked_threads)
+        {
+            outstream << "  " << data.num_untracked_threads <<
+                " more threads not accounted" << endl;
+        }
+    }
+
+    if (data.num_cores)
+    {
+        outstream << "Per-core utilization (avg/peak %):" << endl;
+        for (uint32_t i = 0; i < data.num_cores; i++)
+        {
+            outstream << "  cpu" << i << " = " << fixed << setprecision(1) <<
+                data.core_avg_usage[i] << "/" << data.core_peak_usage[i] <<
+                endl;
+        }
+        outstream.unsetf(ios::floatfield);
+        outstream << setprecision(6);
+    }
+
+    if (data.peak_rss_kb)
+    {
+        outstream << "Avg/Peak RSS = " << data.avg_rss_kb << "/" <<
+            data.peak_rss_kb << " KiB" << endl;
+    }
+    outstream << "Major page faults = " << data.major_faults << endl;
     outstream << "************************************" << endl;
 }
-
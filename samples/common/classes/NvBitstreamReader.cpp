@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvBitstreamReader.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define CAT_NAME "BitstreamReader"
+
+/* Number of bytes consumed by one iteration of the vector scan. */
+#define SCAN_BLOCK_SIZE 16
+
+NvBitstreamReader::NvBitstreamReader(const char *file_path)
+{
+    struct stat st;
+    void *addr;
+
+    fd = -1;
+    data = NULL;
+    size = 0;
+    current = 0;
+    is_in_error = false;
+
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    if (fstat(fd, &st) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not stat " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    size = st.st_size;
+    if (size == 0)
+    {
+        /* Nothing to index, the reader reports end of stream right away. */
+        return;
+    }
+
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        CAT_SYS_ERROR_MSG("Could not map " << file_path);
+        size = 0;
+        is_in_error = true;
+        return;
+    }
+    data = (const uint8_t *) addr;
+
+    /* Both the index pass and the NAL copies walk the file front to back. */
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    buildIndex();
+    CAT_DEBUG_MSG("Indexed " << nal_units.size() << " NAL units in " <<
+            file_path);
+}
+
+NvBitstreamReader *
+NvBitstreamReader::createBitstreamReader(const char *file_path)
+{
+    NvBitstreamReader *reader = new NvBitstreamReader(file_path);
+    if (reader->is_in_error)
+    {
+        delete reader;
+        return NULL;
+    }
+    return reader;
+}
+
+NvBitstreamReader::~NvBitstreamReader()
+{
+    if (data)
+    {
+        munmap((void *) data, size);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+const uint8_t *
+NvBitstreamReader::findStartCode(const uint8_t *begin, const uint8_t *end)
+{
+    const uint8_t *p = begin;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    /* Each lane i tests p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1. */
+    while (end - p >= SCAN_BLOCK_SIZE + 2)
+    {
+        __m128i b0 = _mm_loadu_si128((const __m128i *) p);
+        __m128i b1 = _mm_loadu_si128((const __m128i *) (p + 1));
+        __m128i b2 = _mm_loadu_si128((const __m128i *) (p + 2));
+        __m128i match = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+                _mm_cmpeq_epi8(b2, one));
+        int mask = _mm_movemask_epi8(match);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += SCAN_BLOCK_SIZE;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+
+    while (end - p >= SCAN_BLOCK_SIZE + 2)
+    {
+        uint8x16_t b0 = vld1q_u8(p);
+        uint8x16_t b1 = vld1q_u8(p + 1);
+        uint8x16_t b2 = vld1q_u8(p + 2);
+        uint8x16_t match = vandq_u8(
+                vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)),
+                vceqq_u8(b2, one));
+        if (vmaxvq_u8(match))
+        {
+            /* Rare case, locate the lane with a scalar scan. */
+            break;
+        }
+        p += SCAN_BLOCK_SIZE;
+    }
+#endif
+
+    while (end - p >= 3)
+    {
+        if (!p[0] && !p[1] && p[2] == 1)
+        {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+void
+NvBitstreamReader::buildIndex()
+{
+    const uint8_t *end = data + size;
+    const uint8_t *p = findStartCode(data, end);
+
+    /* Rough guess of one NAL unit per 1 KiB to limit reallocations. */
+    nal_units.reserve(size / 1024 + 1);
+
+    while (p != end)
+    {
+        NvNalUnit nalu;
+
+        nalu.start_code_len = 3;
+        if (p > data && p[-1] == 0)
+        {
+            /* 4-byte start code. */
+            nalu.start_code_len = 4;
+        }
+        nalu.offset = (p + 3 - nalu.start_code_len) - data;
+        nalu.header = (end - p > 3) ? p[3] : 0;
+
+        if (!nal_units.empty())
+        {
+            NvNalUnit &prev = nal_units.back();
+            prev.size = nalu.offset - prev.offset;
+        }
+        nal_units.push_back(nalu);
+
+        p = findStartCode(p + 3, end);
+    }
+
+    if (!nal_units.empty())
+    {
+        NvNalUnit &last = nal_units.back();
+        last.size = size - last.offset;
+    }
+}
+
+int
+NvBitstreamReader::readNextNalUnit(NvBuffer *buffer, const NvNalUnit **nalu)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+
+    if (nalu)
+    {
+        *nalu = NULL;
+    }
+
+    if (current >= nal_units.size())
+    {
+        plane.bytesused = 0;
+        rewind();
+        return 0;
+    }
+
+    const NvNalUnit &unit = nal_units[current];
+    if (unit.size > plane.length)
+    {
+        CAT_ERROR_MSG("NAL unit " << current << " of size " << unit.size <<
+                " does not fit in buffer of size " << plane.length);
+        plane.bytesused = 0;
+        return -1;
+    }
+
+    memcpy(plane.data, data + unit.offset, unit.size);
+    plane.bytesused = unit.size;
+    current++;
+
+    if (nalu)
+    {
+        *nalu = &unit;
+    }
+    return 0;
+}
+
+bool
+NvBitstreamReader::isAccessUnitStart(uint32_t pixfmt, const uint8_t *nal,
+        uint32_t size, bool &is_vcl)
+{
+    int type;
+
+    is_vcl = false;
+    if (pixfmt == V4L2_PIX_FMT_H264)
+    {
+        if (size < 1)
+        {
+            return false;
+        }
+        type = GET_H264_NAL_UNIT_TYPE(nal);
+        if (type >= 1 && type <= 5)
+        {
+            is_vcl = true;
+            /* Partitions B and C never start a picture. */
+            if (type == 3 || type == 4 || size < 2)
+            {
+                return false;
+            }
+            /* first_mb_in_slice is ue(v), a value of 0 is coded as '1'. */
+            return (nal[1] & 0x80) != 0;
+        }
+        return (type >= 6 && type <= 9) || (type >= 14 && type <= 18);
+    }
+    else if (pixfmt == V4L2_PIX_FMT_H265)
+    {
+        if (size < 2)
+        {
+            return false;
+        }
+        type = GET_H265_NAL_UNIT_TYPE(nal);
+        if (type <= 31)
+        {
+            is_vcl = true;
+            if (size < 3)
+            {
+                return false;
+            }
+            /* first_slice_segment_in_pic_flag follows the 2-byte header. */
+            return (nal[2] & 0x80) != 0;
+        }
+        return (type >= 32 && type <= 35) || type == 39 ||
+            (type >= 41 && type <= 44) || (type >= 48 && type <= 55);
+    }
+
+    /* No grouping for other formats, every NAL unit is an access unit. */
+    is_vcl = true;
+    return true;
+}
+
+int
+NvBitstreamReader::readNextAccessUnit(NvBuffer *buffer, uint32_t pixfmt,
+        const NvNalUnit **nalu, uint32_t *num_nal_units)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+    const NvNalUnit *first_vcl = NULL;
+    uint64_t first = current;
+    uint64_t next;
+    uint64_t au_size;
+
+    if (nalu)
+    {
+        *nalu = NULL;
+    }
+    if (num_nal_units)
+    {
+        *num_nal_units = 0;
+    }
+
+    if (current >= nal_units.size())
+    {
+        plane.bytesused = 0;
+        rewind();
+        return 0;
+    }
+
+    for (next = first; next < nal_units.size(); next++)
+    {
+        const NvNalUnit &unit = nal_units[next];
+        bool is_vcl;
+        bool is_start = isAccessUnitStart(pixfmt,
+                data + unit.offset + unit.start_code_len,
+                unit.size - unit.start_code_len, is_vcl);
+
+        if (first_vcl && is_start)
+        {
+            break;
+        }
+        if (is_vcl && !first_vcl)
+        {
+            first_vcl = &unit;
+        }
+    }
+
+    /* The NAL units of an access unit are adjacent in the file. */
+    au_size = nal_units[next - 1].offset + nal_units[next - 1].size -
+        nal_units[first].offset;
+    if (au_size > plane.length)
+    {
+        CAT_WARN_MSG("Access unit at NAL unit " << first << " of size " <<
+                au_size << " does not fit in buffer of size " << plane.length);
+        plane.bytesused = 0;
+        return -1;
+    }
+
+    memcpy(plane.data, data + nal_units[first].offset, au_size);
+    plane.bytesused = au_size;
+    current = next;
+
+    if (nalu)
+    {
+        *nalu = first_vcl ? first_vcl : &nal_units[first];
+    }
+    if (num_nal_units)
+    {
+        *num_nal_units = next - first;
+    }
+    return 0;
+}
+
+void
+NvBitstreamReader::rewind()
+{
+    current = 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvBitstreamSink.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#define CAT_NAME "BitstreamSink"
+
+/* Number of buffers the ring can hold, whatever their size. */
+#define MAX_QUEUED_BUFFERS 4096
+/* Smallest ring accepted, to keep writes reasonably batched. */
+#define MIN_RING_SIZE (64 * 1024)
+
+static uint64_t
+get_time_usec()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+NvBitstreamSink::NvBitstreamSink(const char *name, const char *file_path,
+        uint32_t ring_size, uint64_t sync_interval)
+{
+    void *data = NULL;
+
+    this->name = strdup(name);
+    this->sync_interval = sync_interval;
+    this->ring_size = ring_size < MIN_RING_SIZE ? MIN_RING_SIZE : ring_size;
+    fd = -1;
+    unsynced_bytes = 0;
+    ring = NULL;
+    head = 0;
+    tail = 0;
+    buffer_ends.resize(MAX_QUEUED_BUFFERS);
+    buffers_queued = 0;
+    buffers_done = 0;
+    producer_busy = false;
+    writer_started = false;
+    stop = false;
+    is_in_error = false;
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&data_cond, NULL);
+    pthread_cond_init(&space_cond, NULL);
+
+    if (posix_memalign(&data, 4096, this->ring_size))
+    {
+        CAT_ERROR_MSG("Could not allocate a ring of " << this->ring_size <<
+                " bytes");
+        is_in_error = true;
+        return;
+    }
+    ring = (unsigned char *) data;
+
+    fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    if (pthread_create(&writer, NULL, writerThread, this))
+    {
+        CAT_ERROR_MSG("Could not create writer thread");
+        is_in_error = true;
+        return;
+    }
+    pthread_setname_np(writer, "BitstreamWriter");
+    writer_started = true;
+
+    CAT_DEBUG_MSG("Writing " << file_path << " through a ring of " <<
+            this->ring_size << " bytes");
+}
+
+NvBitstreamSink *
+NvBitstreamSink::createBitstreamSink(const char *name, const char *file_path,
+        uint32_t ring_size, uint64_t sync_interval)
+{
+    NvBitstreamSink *sink = new NvBitstreamSink(name, file_path, ring_size,
+            sync_interval);
+    if (sink->is_in_error)
+    {
+        delete sink;
+        return NULL;
+    }
+    return sink;
+}
+
+NvBitstreamSink::~NvBitstreamSink()
+{
+    pthread_mutex_lock(&lock);
+    stop = true;
+    pthread_cond_broadcast(&data_cond);
+    pthread_mutex_unlock(&lock);
+
+    if (writer_started)
+    {
+        pthread_join(writer, NULL);
+    }
+    if (fd >= 0)
+    {
+        if (sync_interval && unsynced_bytes && fdatasync(fd) < 0)
+        {
+            CAT_SYS_ERROR_MSG("Error while syncing " << name);
+        }
+        close(fd);
+    }
+    free(ring);
+    pthread_cond_destroy(&space_cond);
+    pthread_cond_destroy(&data_cond);
+    pthread_mutex_destroy(&lock);
+    free(name);
+}
+
+int
+NvBitstreamSink::writeRing(uint64_t start, uint64_t size)
+{
+    uint64_t pos = start % ring_size;
+    struct iovec iov[2];
+    int first = 0;
+    int iovcnt = 1;
+    uint64_t done = 0;
+    uint64_t num_calls = 0;
+    int ret = 0;
+
+    /* The queued data wraps at most once around the end of the ring. */
+    iov[0].iov_base = ring + pos;
+    iov[0].iov_len = size < ring_size - pos ? size : ring_size - pos;
+    if (iov[0].iov_len < size)
+    {
+        iov[1].iov_base = ring;
+        iov[1].iov_len = size - iov[0].iov_len;
+        iovcnt = 2;
+    }
+
+    while (done < size)
+    {
+        ssize_t written = writev(fd, iov + first, iovcnt - first);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            CAT_SYS_ERROR_MSG("Error while writing " << name);
+            ret = -1;
+            break;
+        }
+        num_calls++;
+        done += written;
+
+        /* Skip what a short write took, then write the rest. */
+        while (first < iovcnt && (size_t) written >= iov[first].iov_len)
+        {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (written > 0)
+        {
+            iov[first].iov_base = (unsigned char *) iov[first].iov_base + written;
+            iov[first].iov_len -= written;
+        }
+    }
+
+    pthread_mutex_lock(&lock);
+    stats.writev_calls += num_calls;
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+void *
+NvBitstreamSink::writerThread(void *arg)
+{
+    NvBitstreamSink *sink = (NvBitstreamSink *) arg;
+
+    pthread_mutex_lock(&sink->lock);
+    while (1)
+    {
+        uint64_t start, size;
+        bool synced = false;
+        bool in_error;
+        int ret;
+
+        while (sink->head == sink->tail && !sink->stop)
+        {
+            pthread_cond_wait(&sink->data_cond, &sink->lock);
+        }
+        if (sink->head == sink->tail)
+        {
+            break;
+        }
+
+        /* Everything queued so far goes out in one writev(). */
+        start = sink->tail;
+        size = sink->head - sink->tail;
+        in_error = sink->is_in_error;
+        pthread_mutex_unlock(&sink->lock);
+
+        ret = in_error ? -1 : sink->writeRing(start, size);
+        if (ret == 0 && sink->sync_interval)
+        {
+            sink->unsynced_bytes += size;
+            if (sink->unsynced_bytes >= sink->sync_interval)
+            {
+                if (fdatasync(sink->fd) < 0)
+                {
+                    CAT_SYS_ERROR_MSG("Error while syncing " << sink->name);
+                    ret = -1;
+                }
+                sink->unsynced_bytes = 0;
+                synced = true;
+            }
+        }
+
+        pthread_mutex_lock(&sink->lock);
+        if (ret < 0)
+        {
+            /* Queued data is dropped from now on, write() reports it. */
+            sink->is_in_error = true;
+        }
+        else
+        {
+            sink->stats.bytes_written += size;
+        }
+        if (synced)
+        {
+            sink->stats.sync_calls++;
+        }
+        sink->tail += size;
+        while (sink->buffers_done < sink->buffers_queued &&
+                sink->buffer_ends[sink->buffers_done % MAX_QUEUED_BUFFERS] <=
+                sink->tail)
+        {
+            sink->buffers_done++;
+        }
+        pthread_cond_broadcast(&sink->space_cond);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+int
+NvBitstreamSink::write(const void *data, uint32_t size)
+{
+    const unsigned char *src = (const unsigned char *) data;
+    uint64_t stall_start = 0;
+    uint32_t copied = 0;
+    int ret = 0;
+
+    pthread_mutex_lock(&lock);
+    /* The ring is filled by one write() at a time, so that each buffer is
+     * queued whole even if several threads write to the sink.
+     */
+    while (producer_busy)
+    {
+        pthread_cond_wait(&space_cond, &lock);
+    }
+    producer_busy = true;
+
+    while (!is_in_error && buffers_queued - buffers_done >= MAX_QUEUED_BUFFERS)
+    {
+        if (!stall_start)
+            stall_start = get_time_usec();
+        pthread_cond_wait(&space_cond, &lock);
+    }
+
+    while (!is_in_error && copied < size)
+    {
+        uint64_t space = ring_size - (head - tail);
+        uint64_t pos = head % ring_size;
+        uint64_t chunk = size - copied;
+
+        if (space == 0)
+        {
+            if (!stall_start)
+                stall_start = get_time_usec();
+            pthread_cond_wait(&space_cond, &lock);
+            continue;
+        }
+        if (chunk > space)
+            chunk = space;
+        pthread_mutex_unlock(&lock);
+
+        /* The writer thread only reads the ring up to head and the other
+         * producers wait for producer_busy, so the free part can be filled
+         * without holding the lock.
+         */
+        if (chunk > ring_size - pos)
+        {
+            memcpy(ring + pos, src + copied, ring_size - pos);
+            memcpy(ring, src + copied + (ring_size - pos),
+                    chunk - (ring_size - pos));
+        }
+        else
+        {
+            memcpy(ring + pos, src + copied, chunk);
+        }
+        copied += chunk;
+
+        pthread_mutex_lock(&lock);
+        head += chunk;
+        pthread_cond_signal(&data_cond);
+    }
+
+    if (is_in_error)
+    {
+        ret = -1;
+    }
+    else
+    {
+        buffer_ends[buffers_queued % MAX_QUEUED_BUFFERS] = head;
+        buffers_queued++;
+        stats.buffers_written++;
+        if (buffers_queued - buffers_done > stats.max_queued_buffers)
+            stats.max_queued_buffers = buffers_queued - buffers_done;
+        if (head - tail > stats.max_queued_bytes)
+            stats.max_queued_bytes = head - tail;
+    }
+    if (stall_start)
+    {
+        stats.stall_count++;
+        stats.stall_time_usec += get_time_usec() - stall_start;
+    }
+    producer_busy = false;
+    pthread_cond_broadcast(&space_cond);
+    pthread_mutex_unlock(&lock);
+
+    if (ret < 0)
+    {
+        CAT_ERROR_MSG("Could not write " << size << " bytes to " << name);
+    }
+    return ret;
+}
+
+int
+NvBitstreamSink::flush()
+{
+    int ret;
+
+    pthread_mutex_lock(&lock);
+    while (tail != head)
+    {
+        pthread_cond_wait(&space_cond, &lock);
+    }
+    ret = is_in_error ? -1 : 0;
+    pthread_mutex_unlock(&lock);
+
+    return ret;
+}
+
+bool
+NvBitstreamSink::isInError()
+{
+    bool ret;
+
+    pthread_mutex_lock(&lock);
+    ret = is_in_error;
+    pthread_mutex_unlock(&lock);
+
+    return ret;
+}
+
+void
+NvBitstreamSink::getStats(NvBitstreamSinkStats &stats)
+{
+    pthread_mutex_lock(&lock);
+    stats = this->stats;
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvBitstreamSink::printStats(std::ostream &out_stream)
+{
+    NvBitstreamSinkStats data;
+
+    getStats(data);
+    out_stream << "----------- Bitstream sink = " << name << " -----------" <<
+        std::endl;
+    out_stream << "Buffers written = " << data.buffers_written << std::endl;
+    out_stream << "Bytes written = " << data.bytes_written << std::endl;
+    out_stream << "Write calls = " << data.writev_calls << std::endl;
+    if (sync_interval)
+    {
+        out_stream << "Sync calls = " << data.sync_calls << std::endl;
+    }
+    out_stream << "Queue high-water mark = " << data.max_queued_buffers <<
+        " buffers, " << data.max_queued_bytes << " bytes of " << ring_size <<
+        std::endl;
+    out_stream << "Writer stalls = " << data.stall_count << std::endl;
+    out_stream << "Total stall time(usec) = " << data.stall_time_usec <<
+        std::endl;
+    out_stream << "-------------------------------------" << std::endl;
+}
@@ -8,6 +8,7 @@
  */
 
 #include "NvBufSurface.h"
+#include "NvTracer.h"
 
 using namespace std;
 
@@ -55,6 +56,7 @@ int
 NvBufSurf::NvTransform(NvCommonTransformParams *transformParams, int src_fd, int dst_fd)
 {
     int ret = 0;
+    NvTraceScope trace("NvTransform", "NvBufSurf");
     if (transformParams == NULL)
       return -1;
     NvBufSurfTransformRect src_rect = {0};
@@ -90,6 +92,7 @@ int
 NvBufSurf::NvTransformAsync(NvCommonTransformParams *transformParams, NvBufSurfTransformSyncObj_t *sync_obj, int src_fd, int dst_fd)
 {
     int ret = 0;
+    NvTraceScope trace("NvTransformAsync", "NvBufSurf");
     NvBufSurfTransformRect dest_rect, src_rect;
     NvBufSurfTransformParams transform_params;
     NvBufSurface *nvbuf_surf_src = 0;
@@ -27,9 +27,12 @@
  */
 
 #include "NvBuffer.h"
+#include "NvBufferPool.h"
+#include "NvV4l2ElementPlane.h"
 #include "NvLogging.h"
 
 #include <cstring>
+#include <cstdlib>
 #include <errno.h>
 #include <sys/mman.h>
 #include <libv4l2.h>
@@ -58,12 +61,23 @@ NvBuffer::NvBuffer(enum v4l2_buf_type buf_type, enum v4l2_memory memory_type,
     }
 
     ref_count = 0;
-    pthread_mutex_init(&ref_lock, NULL);
     shared_buffer = NULL;
+
+    this->pixfmt = 0;
+    pool = NULL;
+    pool_memory = NULL;
+    pool_owned = false;
+    queued = false;
 }
 
 NvBuffer::NvBuffer(uint32_t pixfmt, uint32_t width, uint32_t height,
         uint32_t index)
+        :NvBuffer(pixfmt, width, height, index, NULL)
+{
+}
+
+NvBuffer::NvBuffer(uint32_t pixfmt, uint32_t width, uint32_t height,
+        uint32_t index, NvBufferPool *pool)
         :buf_type(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE),
          memory_type(V4L2_MEMORY_USERPTR),
          index(index)
@@ -90,8 +104,13 @@ NvBuffer::NvBuffer(uint32_t pixfmt, uint32_t width, uint32_t height,
     }
 
     ref_count = 0;
-    pthread_mutex_init(&ref_lock, NULL);
     shared_buffer = NULL;
+
+    this->pixfmt = pixfmt;
+    this->pool = pool;
+    pool_memory = NULL;
+    pool_owned = false;
+    queued = false;
 }
 
 NvBuffer::NvBuffer(uint32_t size, uint32_t index)
@@ -116,8 +135,13 @@ NvBuffer::NvBuffer(uint32_t size, uint32_t index)
     }
 
     ref_count = 0;
-    pthread_mutex_init(&ref_lock, NULL);
     shared_buffer = NULL;
+
+    this->pixfmt = 0;
+    pool = NULL;
+    pool_memory = NULL;
+    pool_owned = false;
+    queued = false;
 }
 
 NvBuffer::~NvBuffer()
@@ -130,8 +154,6 @@ NvBuffer::~NvBuffer()
     {
         deallocateMemory();
     }
-
-    pthread_mutex_destroy(&ref_lock);
 }
 
 int
@@ -231,19 +253,38 @@ NvBuffer::allocateMemory()
                                planes[j].fmt.width *
                                planes[j].fmt.bytesperpixel *
                                planes[j].fmt.height);
-        planes[j].data = new unsigned char [planes[j].length];
+    }
 
-        if (planes[j].data == MAP_FAILED)
+    if (pool)
+    {
+        if (pool->allocateMemory(this) < 0)
         {
-            SYS_ERROR_MSG("Error while allocating buffer " << index <<
-                    " plane " << j);
+            CAT_ERROR_MSG("Error while allocating buffer " << index <<
+                    " from pool");
             return -1;
         }
-        else
+        allocated = true;
+        return 0;
+    }
+
+    for (j = 0; j < n_planes; j++)
+    {
+        void *data = NULL;
+
+        if (posix_memalign(&data, 64, planes[j].length) != 0)
         {
-            DEBUG_MSG("Buffer " << index << ", Plane " << j <<
-                    " allocated to " << (void *) planes[j].data);
+            SYS_ERROR_MSG("Error while allocating buffer " << index <<
+                    " plane " << j);
+            while (j-- > 0)
+            {
+                free(planes[j].data);
+                planes[j].data = NULL;
+            }
+            return -1;
         }
+        planes[j].data = (unsigned char *) data;
+        DEBUG_MSG("Buffer " << index << ", Plane " << j <<
+                " allocated to " << (void *) planes[j].data);
     }
     allocated = true;
     return 0;
@@ -260,6 +301,14 @@ NvBuffer::deallocateMemory()
         return;
     }
 
+    if (pool_memory)
+    {
+        pool->deallocateMemory(this);
+        allocated = false;
+        DEBUG_MSG("Buffer " << index << " returned to pool");
+        return;
+    }
+
     for (j = 0; j < n_planes; j++)
     {
         if (!planes[j].data)
@@ -268,7 +317,7 @@ NvBuffer::deallocateMemory()
                     " not allocated");
             continue;
         }
-        delete[] planes[j].data;
+        free(planes[j].data);
         planes[j].data = NULL;
     }
     allocated = false;
@@ -278,27 +327,30 @@ NvBuffer::deallocateMemory()
 int
 NvBuffer::ref()
 {
-    int ref_count;
-
-    pthread_mutex_lock(&ref_lock);
-    ref_count = ++this->ref_count;
-    pthread_mutex_unlock(&ref_lock);
-    return ref_count;
+    return ref_count.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
 int
 NvBuffer::unref()
 {
-    int ref_count;
+    int count = ref_count.load(std::memory_order_relaxed);
 
-    pthread_mutex_lock(&ref_lock);
-    if (this->ref_count > 0)
+    /* Decrement only above 0, as the mutex based count did. */
+    do
     {
-        --this->ref_count;
+        if (count == 0)
+        {
+            return 0;
+        }
+    }
+    while (!ref_count.compare_exchange_weak(count, count - 1,
+                std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    if (count == 1 && pool_owned)
+    {
+        delete this;
     }
-    ref_count = this->ref_count;
-    pthread_mutex_unlock(&ref_lock);
-    return ref_count;
+    return count - 1;
 }
 
 int
@@ -454,3 +506,124 @@ NvBuffer::fill_buffer_plane_format(uint32_t *num_planes,
     }
     return 0;
 }
+
+NvBufferRef::NvBufferRef()
+        :buffer(NULL),
+         plane(NULL)
+{
+}
+
+NvBufferRef::NvBufferRef(NvBuffer *buffer)
+        :buffer(buffer),
+         plane(NULL)
+{
+    if (buffer)
+    {
+        buffer->ref();
+    }
+}
+
+NvBufferRef::NvBufferRef(NvBuffer *buffer, NvV4l2ElementPlane *plane)
+        :buffer(buffer),
+         plane(plane)
+{
+    if (buffer)
+    {
+        buffer->ref();
+    }
+}
+
+NvBufferRef
+NvBufferRef::adopt(NvBuffer *buffer)
+{
+    NvBufferRef handle;
+
+    handle.buffer = buffer;
+    return handle;
+}
+
+NvBufferRef::NvBufferRef(NvBufferRef &&other)
+        :buffer(other.buffer),
+         plane(other.plane)
+{
+    other.buffer = NULL;
+    other.plane = NULL;
+}
+
+NvBufferRef &
+NvBufferRef::operator=(NvBufferRef &&other)
+{
+    if (this != &other)
+    {
+        reset();
+        buffer = other.buffer;
+        plane = other.plane;
+        other.buffer = NULL;
+        other.plane = NULL;
+    }
+    return *this;
+}
+
+NvBufferRef::~NvBufferRef()
+{
+    reset();
+}
+
+NvBufferRef
+NvBufferRef::share() const
+{
+    return NvBufferRef(buffer, plane);
+}
+
+int
+NvBufferRef::reset()
+{
+    NvBuffer *buffer = this->buffer;
+    NvV4l2ElementPlane *plane = this->plane;
+
+    this->buffer = NULL;
+    this->plane = NULL;
+
+    if (!buffer || buffer->unref() > 0 || !plane)
+    {
+        return 0;
+    }
+
+    /* The buffers of a plane which stopped streaming are all dequeued and
+       may be about to be freed, do not hand them back to the driver. */
+    if (!plane->getStreamStatus())
+    {
+        return 0;
+    }
+
+    struct v4l2_buffer v4l2_buf;
+    struct v4l2_plane v4l2_planes[MAX_PLANES];
+
+    memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+    memset(v4l2_planes, 0, sizeof(v4l2_planes));
+    v4l2_buf.index = buffer->index;
+    v4l2_buf.m.planes = v4l2_planes;
+    /* As when the buffers were first queued, only plane 0 carries the
+       DMABUF fd, which holds all the planes of the frame. */
+    if (buffer->memory_type == V4L2_MEMORY_DMABUF)
+    {
+        v4l2_planes[0].m.fd = buffer->planes[0].fd;
+    }
+
+    if (plane->qBuffer(v4l2_buf, NULL) < 0)
+    {
+        CAT_ERROR_MSG("Could not queue back buffer " << buffer->index);
+        return -1;
+    }
+    return 0;
+}
+
+NvBuffer *
+NvBufferRef::release()
+{
+    NvBuffer *buffer = this->buffer;
+
+    this->buffer = NULL;
+    this->plane = NULL;
+    return buffer;
+}
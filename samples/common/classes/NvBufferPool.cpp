@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvBufferPool.h"
+#include "NvLogging.h"
+
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define CAT_NAME "BufferPool"
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+/**
+ * Reads the default huge page size from /proc/meminfo.
+ */
+static size_t
+get_huge_page_size()
+{
+    char line[128];
+    size_t size_kb = 0;
+    FILE *file = fopen("/proc/meminfo", "r");
+
+    if (!file)
+    {
+        return 0;
+    }
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "Hugepagesize: %zu kB", &size_kb) == 1)
+        {
+            break;
+        }
+    }
+    fclose(file);
+    return size_kb * 1024;
+}
+
+NvBufferPool *
+NvBufferPool::createBufferPool(const char *name, uint32_t max_free_buffers,
+        uint32_t flags)
+{
+    return new NvBufferPool(name, max_free_buffers, flags);
+}
+
+NvBufferPool::NvBufferPool(const char *name, uint32_t max_free_buffers,
+        uint32_t flags)
+        :name(name ? name : "BufferPool"),
+         max_free_buffers(max_free_buffers),
+         flags(flags)
+{
+    long page = sysconf(_SC_PAGESIZE);
+
+    page_size = page > 0 ? page : 4096;
+    huge_page_size = (flags & FLAG_HUGEPAGES) ? get_huge_page_size() : 0;
+
+    pthread_mutex_init(&lock, NULL);
+    memset(&stats, 0, sizeof(stats));
+    free_list.reserve(max_free_buffers);
+
+    CAT_DEBUG_MSG(this->name << ": created, keeping " << max_free_buffers <<
+            " buffers, huge page size " << huge_page_size);
+}
+
+NvBufferPool::~NvBufferPool()
+{
+    pthread_mutex_lock(&lock);
+    if (stats.outstanding)
+    {
+        CAT_WARN_MSG(name << ": destroyed with " << stats.outstanding <<
+                " buffers outstanding");
+    }
+    trimLocked(0);
+    pthread_mutex_unlock(&lock);
+
+    CAT_DEBUG_MSG(name << ": " << stats.allocations << " allocations, " <<
+            stats.reuses << " reuses");
+    pthread_mutex_destroy(&lock);
+}
+
+NvBuffer *
+NvBufferPool::acquire(uint32_t pixfmt, uint32_t width, uint32_t height)
+{
+    NvBuffer::NvBufferPlaneFormat fmt[MAX_PLANES];
+    uint32_t n_planes;
+    NvBuffer *buffer;
+
+    if (NvBuffer::fill_buffer_plane_format(&n_planes, fmt, width, height,
+                pixfmt) < 0)
+    {
+        return NULL;
+    }
+
+    buffer = new NvBuffer(pixfmt, width, height, 0, this);
+    if (buffer->allocateMemory() < 0)
+    {
+        CAT_ERROR_MSG(name << ": could not allocate " << width << "x" <<
+                height << " buffer");
+        delete buffer;
+        return NULL;
+    }
+    buffer->pool_owned = true;
+    buffer->ref();
+    return buffer;
+}
+
+int
+NvBufferPool::prewarm(uint32_t pixfmt, uint32_t width, uint32_t height,
+        uint32_t count)
+{
+    NvBuffer::NvBufferPlaneFormat fmt[MAX_PLANES];
+    uint32_t n_planes;
+    uint32_t free_buffers;
+    uint32_t i;
+
+    if (NvBuffer::fill_buffer_plane_format(&n_planes, fmt, width, height,
+                pixfmt) < 0)
+    {
+        return -1;
+    }
+
+    NvBuffer layout(pixfmt, width, height, 0);
+
+    for (i = 0; i < layout.n_planes; i++)
+    {
+        layout.planes[i].length = layout.planes[i].fmt.sizeimage;
+    }
+
+    pthread_mutex_lock(&lock);
+    free_buffers = free_list.size();
+    pthread_mutex_unlock(&lock);
+
+    if (count > max_free_buffers - free_buffers)
+    {
+        count = max_free_buffers - free_buffers;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        NvBufferPoolMemory *memory = mapMemory(&layout, true);
+
+        if (!memory)
+        {
+            return -1;
+        }
+        pthread_mutex_lock(&lock);
+        stats.allocations++;
+        free_list.push_back(memory);
+        trimLocked(max_free_buffers);
+        pthread_mutex_unlock(&lock);
+    }
+    return 0;
+}
+
+void
+NvBufferPool::trim(uint32_t max_free_buffers)
+{
+    pthread_mutex_lock(&lock);
+    trimLocked(max_free_buffers);
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvBufferPool::getStats(NvBufferPoolStats &stats)
+{
+    pthread_mutex_lock(&lock);
+    stats = this->stats;
+    stats.free_buffers = free_list.size();
+    stats.free_bytes = 0;
+    for (size_t i = 0; i < free_list.size(); i++)
+    {
+        stats.free_bytes += free_list[i]->size;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+int
+NvBufferPool::allocateMemory(NvBuffer *buffer)
+{
+    NvBufferPoolMemory *memory = NULL;
+    uint32_t width = buffer->planes[0].fmt.width;
+    uint32_t height = buffer->planes[0].fmt.height;
+    bool reused;
+    uint32_t i;
+
+    pthread_mutex_lock(&lock);
+    for (i = free_list.size(); i-- > 0;)
+    {
+        if (free_list[i]->pixfmt == buffer->pixfmt &&
+                free_list[i]->width == width &&
+                free_list[i]->height == height)
+        {
+            memory = free_list[i];
+            free_list.erase(free_list.begin() + i);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+
+    reused = (memory != NULL);
+    if (!memory)
+    {
+        memory = mapMemory(buffer, false);
+        if (!memory)
+        {
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&lock);
+    if (reused)
+    {
+        stats.reuses++;
+    }
+    else
+    {
+        stats.allocations++;
+    }
+    stats.outstanding++;
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i < buffer->n_planes; i++)
+    {
+        buffer->planes[i].data = memory->data[i];
+    }
+    buffer->pool_memory = memory;
+    return 0;
+}
+
+void
+NvBufferPool::deallocateMemory(NvBuffer *buffer)
+{
+    NvBufferPoolMemory *memory = buffer->pool_memory;
+    bool keep;
+
+    for (uint32_t i = 0; i < buffer->n_planes; i++)
+    {
+        buffer->planes[i].data = NULL;
+    }
+    buffer->pool_memory = NULL;
+
+    pthread_mutex_lock(&lock);
+    stats.outstanding--;
+    keep = free_list.size() < max_free_buffers;
+    if (keep)
+    {
+        free_list.push_back(memory);
+    }
+    else
+    {
+        stats.releases++;
+    }
+    pthread_mutex_unlock(&lock);
+
+    if (!keep)
+    {
+        unmapMemory(memory);
+    }
+}
+
+NvBufferPoolMemory *
+NvBufferPool::mapMemory(NvBuffer *buffer, bool populate)
+{
+    NvBufferPoolMemory *memory;
+    size_t offsets[MAX_PLANES];
+    size_t size = 0;
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void *base = MAP_FAILED;
+    uint32_t i;
+
+    for (i = 0; i < buffer->n_planes; i++)
+    {
+        offsets[i] = size;
+        size += ALIGN_UP(buffer->planes[i].length, page_size);
+    }
+    if (size == 0)
+    {
+        CAT_ERROR_MSG(name << ": buffer has no memory to allocate");
+        return NULL;
+    }
+
+    if (populate)
+    {
+        map_flags |= MAP_POPULATE;
+    }
+
+    if (huge_page_size && size >= huge_page_size)
+    {
+        size_t huge_size = ALIGN_UP(size, huge_page_size);
+
+        base = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+                map_flags | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED)
+        {
+            size = huge_size;
+        }
+    }
+
+    if (base == MAP_FAILED)
+    {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            CAT_ERROR_MSG(name << ": could not map " << size << " bytes: " <<
+                    strerror(errno));
+            return NULL;
+        }
+        if (huge_page_size)
+        {
+            madvise(base, size, MADV_HUGEPAGE);
+        }
+    }
+
+    memory = new NvBufferPoolMemory;
+    memory->pixfmt = buffer->pixfmt;
+    memory->width = buffer->planes[0].fmt.width;
+    memory->height = buffer->planes[0].fmt.height;
+    memory->base = (unsigned char *) base;
+    memory->size = size;
+    memset(memory->data, 0, sizeof(memory->data));
+    for (i = 0; i < buffer->n_planes; i++)
+    {
+        memory->data[i] = memory->base + offsets[i];
+    }
+
+    CAT_DEBUG_MSG(name << ": mapped " << size << " bytes at " << base);
+    return memory;
+}
+
+void
+NvBufferPool::unmapMemory(NvBufferPoolMemory *memory)
+{
+    munmap(memory->base, memory->size);
+    delete memory;
+}
+
+void
+NvBufferPool::trimLocked(uint32_t max_free)
+{
+    while (free_list.size() > max_free)
+    {
+        unmapMemory(free_list.front());
+        free_list.erase(free_list.begin());
+        stats.releases++;
+    }
+}
@@ -0,0 +1,1667 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvContainerReader.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CAT_NAME "ContainerReader"
+
+#define BOX_TYPE(a, b, c, d) \
+    (((uint32_t) (a) << 24) | ((b) << 16) | ((c) << 8) | (d))
+
+/* ISO base media sample_is_non_sync_sample flag. */
+#define MP4_SAMPLE_NON_SYNC             0x10000
+
+/* Track fragment header flags. */
+#define MP4_TFHD_BASE_DATA_OFFSET       0x000001
+#define MP4_TFHD_SAMPLE_DESC_INDEX      0x000002
+#define MP4_TFHD_DEFAULT_DURATION       0x000008
+#define MP4_TFHD_DEFAULT_SIZE           0x000010
+#define MP4_TFHD_DEFAULT_FLAGS          0x000020
+
+/* Track fragment run flags. */
+#define MP4_TRUN_DATA_OFFSET            0x000001
+#define MP4_TRUN_FIRST_SAMPLE_FLAGS     0x000004
+#define MP4_TRUN_SAMPLE_DURATION        0x000100
+#define MP4_TRUN_SAMPLE_SIZE            0x000200
+#define MP4_TRUN_SAMPLE_FLAGS           0x000400
+#define MP4_TRUN_SAMPLE_CTS             0x000800
+
+/* Matroska element IDs, with the length marker kept. */
+#define MKV_ID_EBML                     0x1A45DFA3
+#define MKV_ID_SEGMENT                  0x18538067
+#define MKV_ID_SEEK_HEAD                0x114D9B74
+#define MKV_ID_INFO                     0x1549A966
+#define MKV_ID_TIMECODE_SCALE           0x2AD7B1
+#define MKV_ID_TRACKS                   0x1654AE6B
+#define MKV_ID_TRACK_ENTRY              0xAE
+#define MKV_ID_TRACK_NUMBER             0xD7
+#define MKV_ID_TRACK_TYPE               0x83
+#define MKV_ID_CODEC_ID                 0x86
+#define MKV_ID_CODEC_PRIVATE            0x63A2
+#define MKV_ID_CONTENT_ENCODINGS        0x6D80
+#define MKV_ID_VIDEO                    0xE0
+#define MKV_ID_PIXEL_WIDTH              0xB0
+#define MKV_ID_PIXEL_HEIGHT             0xBA
+#define MKV_ID_CLUSTER                  0x1F43B675
+#define MKV_ID_CLUSTER_TIMECODE         0xE7
+#define MKV_ID_SIMPLE_BLOCK             0xA3
+#define MKV_ID_BLOCK_GROUP              0xA0
+#define MKV_ID_BLOCK                    0xA1
+#define MKV_ID_REFERENCE_BLOCK          0xFB
+#define MKV_ID_CUES                     0x1C53BB6B
+#define MKV_ID_CHAPTERS                 0x1043A770
+#define MKV_ID_TAGS                     0x1254C367
+#define MKV_ID_ATTACHMENTS              0x1941A469
+
+#define MKV_TRACK_TYPE_VIDEO            1
+#define MKV_DEFAULT_TIMECODE_SCALE      1000000
+
+#define AV1_OBU_SEQUENCE_HEADER         1
+#define AV1_OBU_TYPE(header)            (((header) >> 3) & 0xF)
+
+static const uint8_t start_code[4] = { 0, 0, 0, 1 };
+static const uint8_t av1_temporal_delimiter[2] = { 0x12, 0x00 };
+
+struct NvContainerReader::Mp4Track
+{
+    uint32_t track_id;
+    uint32_t timescale;
+    int64_t edit_shift;         /* Media time of the first presented sample. */
+    uint32_t pixfmt;
+    const uint8_t *config;
+    uint32_t config_size;
+    uint32_t width;
+    uint32_t height;
+
+    /* Sample table boxes, payloads after the version and flags. */
+    const uint8_t *stsz, *stsc, *stco, *stts, *ctts, *stss;
+    uint64_t stsz_size, stsc_size, stco_size, stts_size, ctts_size, stss_size;
+    bool compact_sizes;         /* stz2 instead of stsz. */
+    bool large_offsets;         /* co64 instead of stco. */
+
+    /* Defaults from the trex box. */
+    uint32_t default_duration;
+    uint32_t default_size;
+    uint32_t default_flags;
+
+    /* Decode time following the last indexed sample. */
+    uint64_t next_dts;
+};
+
+static inline uint16_t
+read_be16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t
+read_be32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline uint64_t
+read_be64(const uint8_t *p)
+{
+    return ((uint64_t) read_be32(p) << 32) | read_be32(p + 4);
+}
+
+static inline int64_t
+ticks_to_usec(int64_t ticks, uint32_t timescale)
+{
+    return (ticks / timescale) * 1000000 +
+        (ticks % timescale) * 1000000 / timescale;
+}
+
+/**
+ * Gets the box at @a p and advances @a p past it. A size of 0 extends
+ * the box to @a end. Returns false if no complete box is left.
+ */
+static bool
+next_box(const uint8_t *&p, const uint8_t *end, uint32_t &type,
+        const uint8_t *&payload, uint64_t &payload_size)
+{
+    uint64_t box_size;
+    uint32_t header = 8;
+
+    if (end - p < 8)
+    {
+        return false;
+    }
+    box_size = read_be32(p);
+    type = read_be32(p + 4);
+    if (box_size == 1)
+    {
+        if (end - p < 16)
+        {
+            return false;
+        }
+        box_size = read_be64(p + 8);
+        header = 16;
+    }
+    else if (box_size == 0)
+    {
+        box_size = end - p;
+    }
+    if (box_size < header || box_size > (uint64_t) (end - p))
+    {
+        return false;
+    }
+    payload = p + header;
+    payload_size = box_size - header;
+    p += box_size;
+    return true;
+}
+
+/**
+ * Finds the first child box of type @a type in [p, end).
+ */
+static const uint8_t *
+find_box(const uint8_t *p, const uint8_t *end, uint32_t type,
+        uint64_t &payload_size)
+{
+    const uint8_t *payload;
+    uint32_t box_type;
+
+    while (next_box(p, end, box_type, payload, payload_size))
+    {
+        if (box_type == type)
+        {
+            return payload;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Reads an EBML variable size integer. IDs keep their length marker and
+ * are at most 4 bytes long. Returns the length of the integer, or 0 if it
+ * is invalid or truncated.
+ */
+static int
+read_vint(const uint8_t *p, const uint8_t *end, uint64_t &value,
+        bool is_id, bool *unknown = NULL)
+{
+    int len;
+    int i;
+    uint64_t all_ones;
+
+    if (p >= end || !p[0])
+    {
+        return 0;
+    }
+    len = __builtin_clz(p[0]) - 23;
+    if (len > (is_id ? 4 : 8) || end - p < len)
+    {
+        return 0;
+    }
+
+    value = is_id ? p[0] : p[0] & (0xFF >> len);
+    for (i = 1; i < len; i++)
+    {
+        value = (value << 8) | p[i];
+    }
+
+    if (unknown)
+    {
+        all_ones = (1ULL << (7 * len)) - 1;
+        *unknown = (value == all_ones);
+    }
+    return len;
+}
+
+/**
+ * Gets the EBML element at @a p and advances @a p past it. The payload of
+ * an element of unknown size extends to @a end and @a p is left at its
+ * payload, so that the children are read next. Elements running past
+ * @a end are clamped to it if @a clamp is set. Returns false if no valid
+ * element is left.
+ */
+static bool
+next_element(const uint8_t *&p, const uint8_t *end, uint32_t &id,
+        const uint8_t *&payload, uint64_t &payload_size, bool &unknown,
+        bool clamp = false)
+{
+    uint64_t value;
+    int len;
+
+    len = read_vint(p, end, value, true);
+    if (!len)
+    {
+        return false;
+    }
+    id = value;
+    payload = p + len;
+
+    len = read_vint(payload, end, payload_size, false, &unknown);
+    if (!len)
+    {
+        return false;
+    }
+    payload += len;
+
+    if (unknown)
+    {
+        payload_size = end - payload;
+        p = payload;
+        return true;
+    }
+    if (payload_size > (uint64_t) (end - payload))
+    {
+        if (!clamp)
+        {
+            return false;
+        }
+        payload_size = end - payload;
+    }
+    p = payload + payload_size;
+    return true;
+}
+
+static uint64_t
+read_uint(const uint8_t *p, uint64_t size)
+{
+    uint64_t value = 0;
+
+    while (size--)
+    {
+        value = (value << 8) | *p++;
+    }
+    return value;
+}
+
+/**
+ * Checks whether the OBUs of an AV1 sample include a sequence header.
+ */
+static bool
+has_av1_sequence_header(const uint8_t *p, const uint8_t *end)
+{
+    while (p < end)
+    {
+        uint8_t header = p[0];
+        uint64_t obu_size = 0;
+        int shift = 0;
+
+        if (AV1_OBU_TYPE(header) == AV1_OBU_SEQUENCE_HEADER)
+        {
+            return true;
+        }
+        p += (header & 0x4) ? 2 : 1;
+        if (!(header & 0x2))
+        {
+            /* Without a size field the OBU extends to the end. */
+            return false;
+        }
+        while (p < end && shift < 56)
+        {
+            obu_size |= (uint64_t) (*p & 0x7F) << shift;
+            shift += 7;
+            if (!(*p++ & 0x80))
+            {
+                break;
+            }
+        }
+        if (obu_size > (uint64_t) (end - p))
+        {
+            return false;
+        }
+        p += obu_size;
+    }
+    return false;
+}
+
+NvContainerReader::NvContainerReader(const char *file_path)
+{
+    struct stat st;
+    void *addr;
+
+    fd = -1;
+    data = NULL;
+    size = 0;
+    is_matroska = false;
+    pixfmt = 0;
+    width = 0;
+    height = 0;
+    nal_length_size = 0;
+    current = 0;
+    is_in_error = false;
+
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    if (fstat(fd, &st) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not stat " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    size = st.st_size;
+    if (size < 8)
+    {
+        CAT_ERROR_MSG(file_path << " is too small to be a container");
+        is_in_error = true;
+        return;
+    }
+
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        CAT_SYS_ERROR_MSG("Could not map " << file_path);
+        size = 0;
+        is_in_error = true;
+        return;
+    }
+    data = (const uint8_t *) addr;
+
+    if (read_be32(data) == MKV_ID_EBML)
+    {
+        is_matroska = true;
+        if (parseMatroska() < 0)
+        {
+            is_in_error = true;
+            return;
+        }
+    }
+    else if (parseMp4() < 0)
+    {
+        is_in_error = true;
+        return;
+    }
+
+    if (samples.empty())
+    {
+        CAT_ERROR_MSG("No video samples found in " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    /* Once indexed, samples are read in file order. */
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    CAT_DEBUG_MSG("Indexed " << samples.size() << " samples of a " <<
+            width << "x" << height << " track in " << file_path);
+}
+
+NvContainerReader *
+NvContainerReader::createContainerReader(const char *file_path)
+{
+    NvContainerReader *reader = new NvContainerReader(file_path);
+    if (reader->is_in_error)
+    {
+        delete reader;
+        return NULL;
+    }
+    return reader;
+}
+
+NvContainerReader::~NvContainerReader()
+{
+    if (data)
+    {
+        munmap((void *) data, size);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+int
+NvContainerReader::setCodec(uint32_t codec, const uint8_t *config,
+        uint32_t config_size)
+{
+    const uint8_t *p = config;
+    const uint8_t *end = config + config_size;
+    uint32_t num_arrays;
+    uint32_t count;
+    uint32_t len;
+    uint32_t i;
+
+    pixfmt = codec;
+    nal_length_size = 0;
+    parameter_sets.clear();
+
+    switch (codec)
+    {
+        case V4L2_PIX_FMT_H264:
+            /* AVCDecoderConfigurationRecord */
+            if (config_size < 7)
+            {
+                CAT_ERROR_MSG("Missing or truncated avcC configuration");
+                return -1;
+            }
+            nal_length_size = (p[4] & 0x3) + 1;
+            p += 5;
+            /* SPS first, then PPS. */
+            for (num_arrays = 0; num_arrays < 2; num_arrays++)
+            {
+                if (p >= end)
+                {
+                    goto truncated;
+                }
+                count = num_arrays ? p[0] : p[0] & 0x1F;
+                p++;
+                for (i = 0; i < count; i++)
+                {
+                    if (end - p < 2 || (uint32_t) (end - p - 2) < read_be16(p))
+                    {
+                        goto truncated;
+                    }
+                    len = read_be16(p);
+                    parameter_sets.insert(parameter_sets.end(), start_code,
+                            start_code + 4);
+                    parameter_sets.insert(parameter_sets.end(), p + 2,
+                            p + 2 + len);
+                    p += 2 + len;
+                }
+            }
+            break;
+
+        case V4L2_PIX_FMT_H265:
+            /* HEVCDecoderConfigurationRecord */
+            if (config_size < 23)
+            {
+                CAT_ERROR_MSG("Missing or truncated hvcC configuration");
+                return -1;
+            }
+            nal_length_size = (p[21] & 0x3) + 1;
+            num_arrays = p[22];
+            p += 23;
+            while (num_arrays--)
+            {
+                if (end - p < 3)
+                {
+                    goto truncated;
+                }
+                count = read_be16(p + 1);
+                p += 3;
+                for (i = 0; i < count; i++)
+                {
+                    if (end - p < 2 || (uint32_t) (end - p - 2) < read_be16(p))
+                    {
+                        goto truncated;
+                    }
+                    len = read_be16(p);
+                    parameter_sets.insert(parameter_sets.end(), start_code,
+                            start_code + 4);
+                    parameter_sets.insert(parameter_sets.end(), p + 2,
+                            p + 2 + len);
+                    p += 2 + len;
+                }
+            }
+            break;
+
+        case V4L2_PIX_FMT_AV1:
+            /* AV1CodecConfigurationRecord, followed by the config OBUs. */
+            if (config_size > 4)
+            {
+                parameter_sets.assign(p + 4, end);
+            }
+            break;
+
+        case V4L2_PIX_FMT_VP8:
+        case V4L2_PIX_FMT_VP9:
+            break;
+
+        default:
+            return -1;
+    }
+    return 0;
+
+truncated:
+    CAT_ERROR_MSG("Truncated decoder configuration record");
+    return -1;
+}
+
+int
+NvContainerReader::parseMp4Track(const uint8_t *trak, uint64_t trak_size,
+        Mp4Track &track)
+{
+    const uint8_t *trak_end = trak + trak_size;
+    const uint8_t *mdia, *minf, *stbl, *box, *entry, *p, *end, *payload;
+    uint64_t mdia_size, minf_size, stbl_size, box_size, payload_size;
+    uint32_t type;
+    uint32_t entry_type;
+
+    memset(&track, 0, sizeof(track));
+
+    box = find_box(trak, trak_end, BOX_TYPE('t', 'k', 'h', 'd'), box_size);
+    if (!box || box_size < 24)
+    {
+        return 0;
+    }
+    track.track_id = read_be32(box + (box[0] == 1 ? 20 : 12));
+
+    mdia = find_box(trak, trak_end, BOX_TYPE('m', 'd', 'i', 'a'), mdia_size);
+    if (!mdia)
+    {
+        return 0;
+    }
+    box = find_box(mdia, mdia + mdia_size, BOX_TYPE('h', 'd', 'l', 'r'),
+            box_size);
+    if (!box || box_size < 12 ||
+            read_be32(box + 8) != BOX_TYPE('v', 'i', 'd', 'e'))
+    {
+        return 0;
+    }
+    box = find_box(mdia, mdia + mdia_size, BOX_TYPE('m', 'd', 'h', 'd'),
+            box_size);
+    if (!box || box_size < (uint64_t) (box[0] == 1 ? 24 : 16))
+    {
+        return 0;
+    }
+    track.timescale = read_be32(box + (box[0] == 1 ? 20 : 12));
+    if (!track.timescale)
+    {
+        CAT_ERROR_MSG("Track " << track.track_id << " has no timescale");
+        return 0;
+    }
+
+    /* The first non-empty edit maps media time to presentation time 0. */
+    box = find_box(trak, trak_end, BOX_TYPE('e', 'd', 't', 's'), box_size);
+    if (box)
+    {
+        box = find_box(box, box + box_size, BOX_TYPE('e', 'l', 's', 't'),
+                box_size);
+    }
+    if (box && box_size >= 8)
+    {
+        bool v1 = (box[0] == 1);
+        uint32_t entry_size = v1 ? 20 : 12;
+        uint32_t count = read_be32(box + 4);
+        uint32_t i;
+
+        for (i = 0; i < count && 8 + (i + 1) * (uint64_t) entry_size <= box_size;
+                i++)
+        {
+            const uint8_t *entry = box + 8 + i * entry_size;
+            int64_t media_time = v1 ? (int64_t) read_be64(entry + 8) :
+                (int32_t) read_be32(entry + 4);
+            if (media_time >= 0)
+            {
+                track.edit_shift = media_time;
+                break;
+            }
+        }
+    }
+
+    minf = find_box(mdia, mdia + mdia_size, BOX_TYPE('m', 'i', 'n', 'f'),
+            minf_size);
+    stbl = minf ? find_box(minf, minf + minf_size,
+            BOX_TYPE('s', 't', 'b', 'l'), stbl_size) : NULL;
+    if (!stbl)
+    {
+        return 0;
+    }
+
+    p = stbl;
+    end = stbl + stbl_size;
+    while (next_box(p, end, type, payload, payload_size))
+    {
+        if (payload_size < 4)
+        {
+            continue;
+        }
+        switch (type)
+        {
+            case BOX_TYPE('s', 't', 's', 'd'):
+                /* Only the first sample entry is used. */
+                box = payload + 8;
+                if (payload_size < 8 + 8 + 78 ||
+                        !next_box(box, payload + payload_size, entry_type,
+                            entry, box_size) || box_size < 78)
+                {
+                    break;
+                }
+                box = entry;
+                track.width = read_be16(box + 24);
+                track.height = read_be16(box + 26);
+                switch (entry_type)
+                {
+                    case BOX_TYPE('a', 'v', 'c', '1'):
+                    case BOX_TYPE('a', 'v', 'c', '3'):
+                        track.pixfmt = V4L2_PIX_FMT_H264;
+                        type = BOX_TYPE('a', 'v', 'c', 'C');
+                        break;
+                    case BOX_TYPE('h', 'v', 'c', '1'):
+                    case BOX_TYPE('h', 'e', 'v', '1'):
+                        track.pixfmt = V4L2_PIX_FMT_H265;
+                        type = BOX_TYPE('h', 'v', 'c', 'C');
+                        break;
+                    case BOX_TYPE('a', 'v', '0', '1'):
+                        track.pixfmt = V4L2_PIX_FMT_AV1;
+                        type = BOX_TYPE('a', 'v', '1', 'C');
+                        break;
+                    case BOX_TYPE('v', 'p', '0', '8'):
+                        track.pixfmt = V4L2_PIX_FMT_VP8;
+                        type = 0;
+                        break;
+                    case BOX_TYPE('v', 'p', '0', '9'):
+                        track.pixfmt = V4L2_PIX_FMT_VP9;
+                        type = 0;
+                        break;
+                    default:
+                        CAT_WARN_MSG("Unsupported sample entry " <<
+                                std::string((const char *) payload + 12, 4) <<
+                                " in track " << track.track_id);
+                        return 0;
+                }
+                if (type)
+                {
+                    track.config = find_box(box + 78, box + box_size, type,
+                            box_size);
+                    track.config_size = track.config ? box_size : 0;
+                }
+                break;
+            case BOX_TYPE('s', 't', 's', 'z'):
+            case BOX_TYPE('s', 't', 'z', '2'):
+                track.stsz = payload + 4;
+                track.stsz_size = payload_size - 4;
+                track.compact_sizes = (type == BOX_TYPE('s', 't', 'z', '2'));
+                break;
+            case BOX_TYPE('s', 't', 's', 'c'):
+                track.stsc = payload + 4;
+                track.stsc_size = payload_size - 4;
+                break;
+            case BOX_TYPE('s', 't', 'c', 'o'):
+            case BOX_TYPE('c', 'o', '6', '4'):
+                track.stco = payload + 4;
+                track.stco_size = payload_size - 4;
+                track.large_offsets = (type == BOX_TYPE('c', 'o', '6', '4'));
+                break;
+            case BOX_TYPE('s', 't', 't', 's'):
+                track.stts = payload + 4;
+                track.stts_size = payload_size - 4;
+                break;
+            case BOX_TYPE('c', 't', 't', 's'):
+                track.ctts = payload + 4;
+                track.ctts_size = payload_size - 4;
+                break;
+            case BOX_TYPE('s', 't', 's', 's'):
+                track.stss = payload + 4;
+                track.stss_size = payload_size - 4;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return track.pixfmt ? 1 : 0;
+}
+
+int
+NvContainerReader::addMp4SampleTable(const Mp4Track &track)
+{
+    uint32_t num_samples, fixed_size, field_size = 32;
+    uint32_t num_chunks, num_stsc, num_stts, num_ctts = 0, num_stss = 0;
+    uint32_t chunk, entry, in_chunk, i;
+    uint32_t stts_index = 0, stts_left = 0, ctts_index = 0, ctts_left = 0;
+    uint32_t stss_index = 0;
+    uint64_t offset = 0;
+    uint64_t dts = 0;
+
+    if (!track.stsz || !track.stsc || !track.stco || !track.stts ||
+            track.stsz_size < 8 || track.stsc_size < 4 ||
+            track.stco_size < 4 || track.stts_size < 4)
+    {
+        /* Fragmented files carry an empty or no sample table. */
+        return 0;
+    }
+
+    if (track.compact_sizes)
+    {
+        fixed_size = 0;
+        field_size = track.stsz[3];
+        if (field_size != 4 && field_size != 8 && field_size != 16)
+        {
+            CAT_ERROR_MSG("Invalid stz2 field size " << field_size);
+            return -1;
+        }
+    }
+    else
+    {
+        fixed_size = read_be32(track.stsz);
+    }
+    num_samples = read_be32(track.stsz + 4);
+    if (!fixed_size &&
+            8 + ((uint64_t) num_samples * field_size + 7) / 8 > track.stsz_size)
+    {
+        goto truncated;
+    }
+
+    num_chunks = read_be32(track.stco);
+    if (4 + (uint64_t) num_chunks * (track.large_offsets ? 8 : 4) >
+            track.stco_size)
+    {
+        goto truncated;
+    }
+    num_stsc = read_be32(track.stsc);
+    num_stts = read_be32(track.stts);
+    if (4 + num_stsc * 12ULL > track.stsc_size ||
+            4 + num_stts * 8ULL > track.stts_size)
+    {
+        goto truncated;
+    }
+    if (track.ctts && track.ctts_size >= 4)
+    {
+        num_ctts = read_be32(track.ctts);
+        if (4 + num_ctts * 8ULL > track.ctts_size)
+        {
+            goto truncated;
+        }
+    }
+    if (track.stss && track.stss_size >= 4)
+    {
+        num_stss = read_be32(track.stss);
+        if (4 + num_stss * 4ULL > track.stss_size)
+        {
+            goto truncated;
+        }
+    }
+
+    samples.reserve(samples.size() + num_samples);
+
+    entry = 0;
+    in_chunk = 0;
+    chunk = 0;
+    for (i = 0; i < num_samples; i++)
+    {
+        NvContainerSample sample;
+        uint32_t samples_per_chunk;
+        int32_t cts = 0;
+
+        /* Move to the next chunk once the current one is exhausted. */
+        while (true)
+        {
+            if (entry >= num_stsc || chunk >= num_chunks)
+            {
+                goto truncated;
+            }
+            if (entry + 1 < num_stsc &&
+                    chunk + 1 >= read_be32(track.stsc + 4 + (entry + 1) * 12))
+            {
+                entry++;
+                continue;
+            }
+            samples_per_chunk = read_be32(track.stsc + 4 + entry * 12 + 4);
+            if (in_chunk < samples_per_chunk)
+            {
+                break;
+            }
+            chunk++;
+            in_chunk = 0;
+        }
+        if (in_chunk == 0)
+        {
+            offset = track.large_offsets ?
+                read_be64(track.stco + 4 + chunk * 8ULL) :
+                read_be32(track.stco + 4 + chunk * 4ULL);
+        }
+        in_chunk++;
+
+        sample.offset = offset;
+        if (fixed_size)
+        {
+            sample.size = fixed_size;
+        }
+        else if (field_size == 32)
+        {
+            sample.size = read_be32(track.stsz + 8 + i * 4ULL);
+        }
+        else if (field_size == 16)
+        {
+            sample.size = read_be16(track.stsz + 8 + i * 2ULL);
+        }
+        else if (field_size == 8)
+        {
+            sample.size = track.stsz[8 + i];
+        }
+        else
+        {
+            sample.size = (track.stsz[8 + i / 2] >> ((i & 1) ? 0 : 4)) & 0xF;
+        }
+        offset += sample.size;
+
+        while (!stts_left && stts_index < num_stts)
+        {
+            stts_left = read_be32(track.stts + 4 + stts_index * 8);
+            stts_index++;
+        }
+        while (!ctts_left && ctts_index < num_ctts)
+        {
+            ctts_left = read_be32(track.ctts + 4 + ctts_index * 8);
+            ctts_index++;
+        }
+        if (ctts_left)
+        {
+            /* Version 0 offsets are unsigned, but written signed in practice. */
+            cts = (int32_t) read_be32(track.ctts + 4 + (ctts_index - 1) * 8 + 4);
+            ctts_left--;
+        }
+        sample.pts = ticks_to_usec((int64_t) dts + cts - track.edit_shift,
+                track.timescale);
+        if (stts_left)
+        {
+            dts += read_be32(track.stts + 4 + (stts_index - 1) * 8 + 4);
+            stts_left--;
+        }
+
+        if (!track.stss)
+        {
+            sample.key_frame = true;
+        }
+        else
+        {
+            while (stss_index < num_stss &&
+                    read_be32(track.stss + 4 + stss_index * 4) < i + 1)
+            {
+                stss_index++;
+            }
+            sample.key_frame = stss_index < num_stss &&
+                read_be32(track.stss + 4 + stss_index * 4) == i + 1;
+        }
+
+        if (sample.offset > size || sample.size > size - sample.offset)
+        {
+            CAT_WARN_MSG("Sample " << i << " is past the end of the file, "
+                    "ignoring the remaining samples");
+            break;
+        }
+        samples.push_back(sample);
+    }
+    return 0;
+
+truncated:
+    CAT_ERROR_MSG("Truncated sample table in track " << track.track_id);
+    return -1;
+}
+
+int
+NvContainerReader::addMp4Fragment(const uint8_t *moof, uint64_t moof_size,
+        Mp4Track &track)
+{
+    const uint8_t *moof_end = moof + moof_size;
+    const uint8_t *traf, *p, *end, *box;
+    uint64_t traf_size, box_size;
+    uint32_t type;
+    /* The moof box starts 8 bytes before its payload. */
+    uint64_t moof_offset = (moof - 8) - data;
+
+    p = moof;
+    while (next_box(p, moof_end, type, traf, traf_size))
+    {
+        uint32_t flags;
+        uint64_t base_offset = moof_offset;
+        uint64_t data_offset;
+        uint32_t default_duration = track.default_duration;
+        uint32_t default_size = track.default_size;
+        uint32_t default_flags = track.default_flags;
+        uint32_t pos;
+
+        if (type != BOX_TYPE('t', 'r', 'a', 'f'))
+        {
+            continue;
+        }
+        end = traf + traf_size;
+
+        box = find_box(traf, end, BOX_TYPE('t', 'f', 'h', 'd'), box_size);
+        if (!box || box_size < 8 || read_be32(box + 4) != track.track_id)
+        {
+            continue;
+        }
+        flags = read_be32(box) & 0xFFFFFF;
+        pos = 8;
+        if (flags & MP4_TFHD_BASE_DATA_OFFSET)
+        {
+            if (box_size < pos + 8)
+            {
+                goto truncated;
+            }
+            base_offset = read_be64(box + pos);
+            pos += 8;
+        }
+        if (flags & MP4_TFHD_SAMPLE_DESC_INDEX)
+        {
+            pos += 4;
+        }
+        if (box_size < pos + 4 * (!!(flags & MP4_TFHD_DEFAULT_DURATION) +
+                    !!(flags & MP4_TFHD_DEFAULT_SIZE) +
+                    !!(flags & MP4_TFHD_DEFAULT_FLAGS)))
+        {
+            goto truncated;
+        }
+        if (flags & MP4_TFHD_DEFAULT_DURATION)
+        {
+            default_duration = read_be32(box + pos);
+            pos += 4;
+        }
+        if (flags & MP4_TFHD_DEFAULT_SIZE)
+        {
+            default_size = read_be32(box + pos);
+            pos += 4;
+        }
+        if (flags & MP4_TFHD_DEFAULT_FLAGS)
+        {
+            default_flags = read_be32(box + pos);
+        }
+
+        box = find_box(traf, end, BOX_TYPE('t', 'f', 'd', 't'), box_size);
+        if (box && box_size >= 8)
+        {
+            track.next_dts = box[0] == 1 && box_size >= 12 ?
+                read_be64(box + 4) : read_be32(box + 4);
+        }
+
+        /* Runs without a data offset follow the previous run. */
+        data_offset = base_offset;
+        const uint8_t *q = traf;
+        const uint8_t *trun;
+        uint64_t trun_size;
+        while (next_box(q, end, type, trun, trun_size))
+        {
+            uint32_t count, i, sample_size, entry_size;
+            uint32_t first_flags = 0;
+            bool has_first_flags;
+
+            if (type != BOX_TYPE('t', 'r', 'u', 'n'))
+            {
+                continue;
+            }
+            if (trun_size < 8)
+            {
+                goto truncated;
+            }
+            flags = read_be32(trun) & 0xFFFFFF;
+            count = read_be32(trun + 4);
+            pos = 8;
+            if (flags & MP4_TRUN_DATA_OFFSET)
+            {
+                if (trun_size < pos + 4)
+                {
+                    goto truncated;
+                }
+                data_offset = base_offset + (int32_t) read_be32(trun + pos);
+                pos += 4;
+            }
+            has_first_flags = flags & MP4_TRUN_FIRST_SAMPLE_FLAGS;
+            if (has_first_flags)
+            {
+                if (trun_size < pos + 4)
+                {
+                    goto truncated;
+                }
+                first_flags = read_be32(trun + pos);
+                pos += 4;
+            }
+            entry_size = 4 * (!!(flags & MP4_TRUN_SAMPLE_DURATION) +
+                    !!(flags & MP4_TRUN_SAMPLE_SIZE) +
+                    !!(flags & MP4_TRUN_SAMPLE_FLAGS) +
+                    !!(flags & MP4_TRUN_SAMPLE_CTS));
+            if (pos + (uint64_t) count * entry_size > trun_size)
+            {
+                goto truncated;
+            }
+
+            for (i = 0; i < count; i++)
+            {
+                NvContainerSample sample;
+                uint32_t duration = default_duration;
+                uint32_t sample_flags = default_flags;
+                int32_t cts = 0;
+
+                sample_size = default_size;
+                if (flags & MP4_TRUN_SAMPLE_DURATION)
+                {
+                    duration = read_be32(trun + pos);
+                    pos += 4;
+                }
+                if (flags & MP4_TRUN_SAMPLE_SIZE)
+                {
+                    sample_size = read_be32(trun + pos);
+                    pos += 4;
+                }
+                if (flags & MP4_TRUN_SAMPLE_FLAGS)
+                {
+                    sample_flags = read_be32(trun + pos);
+                    pos += 4;
+                }
+                if (i == 0 && has_first_flags)
+                {
+                    sample_flags = first_flags;
+                }
+                if (flags & MP4_TRUN_SAMPLE_CTS)
+                {
+                    cts = (int32_t) read_be32(trun + pos);
+                    pos += 4;
+                }
+
+                sample.offset = data_offset;
+                sample.size = sample_size;
+                sample.pts = ticks_to_usec((int64_t) track.next_dts + cts -
+                        track.edit_shift, track.timescale);
+                sample.key_frame = !(sample_flags & MP4_SAMPLE_NON_SYNC);
+                data_offset += sample_size;
+                track.next_dts += duration;
+
+                if (sample.offset > size || sample.size > size - sample.offset)
+                {
+                    CAT_WARN_MSG("Fragment sample is past the end of the "
+                            "file, ignoring it");
+                    continue;
+                }
+                samples.push_back(sample);
+            }
+        }
+    }
+    return 0;
+
+truncated:
+    CAT_ERROR_MSG("Truncated track fragment in moof at offset " <<
+            moof_offset);
+    return -1;
+}
+
+int
+NvContainerReader::parseMp4()
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    const uint8_t *payload, *child, *box;
+    uint64_t payload_size, child_size, box_size;
+    uint32_t type, child_type;
+    Mp4Track track;
+    bool have_track = false;
+    bool have_moov = false;
+
+    memset(&track, 0, sizeof(track));
+
+    while (next_box(p, end, type, payload, payload_size))
+    {
+        if (type == BOX_TYPE('m', 'o', 'o', 'v') && !have_moov)
+        {
+            have_moov = true;
+
+            /* The first supported video track. */
+            const uint8_t *q = payload;
+            while (next_box(q, payload + payload_size, child_type, child,
+                        child_size))
+            {
+                if (child_type == BOX_TYPE('t', 'r', 'a', 'k') &&
+                        parseMp4Track(child, child_size, track) > 0)
+                {
+                    have_track = true;
+                    break;
+                }
+            }
+            if (!have_track)
+            {
+                CAT_ERROR_MSG("No supported video track found");
+                return -1;
+            }
+
+            /* Fragment defaults of the track. */
+            box = find_box(payload, payload + payload_size,
+                    BOX_TYPE('m', 'v', 'e', 'x'), box_size);
+            q = box;
+            while (box && next_box(q, box + box_size, child_type, child,
+                        child_size))
+            {
+                if (child_type == BOX_TYPE('t', 'r', 'e', 'x') &&
+                        child_size >= 24 &&
+                        read_be32(child + 4) == track.track_id)
+                {
+                    track.default_duration = read_be32(child + 12);
+                    track.default_size = read_be32(child + 16);
+                    track.default_flags = read_be32(child + 20);
+                }
+            }
+
+            if (setCodec(track.pixfmt, track.config, track.config_size) < 0)
+            {
+                return -1;
+            }
+            width = track.width;
+            height = track.height;
+            if (addMp4SampleTable(track) < 0)
+            {
+                return -1;
+            }
+        }
+        else if (type == BOX_TYPE('m', 'o', 'o', 'f'))
+        {
+            if (!have_track)
+            {
+                CAT_ERROR_MSG("Movie fragment found before the movie header");
+                return -1;
+            }
+            if (addMp4Fragment(payload, payload_size, track) < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    if (!have_moov)
+    {
+        CAT_ERROR_MSG("Not an MP4 or Matroska file");
+        return -1;
+    }
+    return 0;
+}
+
+int
+NvContainerReader::parseMatroska()
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    const uint8_t *payload, *child;
+    uint64_t payload_size, child_size;
+    uint64_t timecode_scale = MKV_DEFAULT_TIMECODE_SCALE;
+    uint64_t track_number = 0;
+    uint32_t id;
+    bool unknown;
+    bool warned_lacing = false;
+
+    /* EBML header. */
+    if (!next_element(p, end, id, payload, payload_size, unknown) || unknown)
+    {
+        CAT_ERROR_MSG("Invalid EBML header");
+        return -1;
+    }
+
+    /* Skip anything before the segment. */
+    while (next_element(p, end, id, payload, payload_size, unknown, true) &&
+            id != MKV_ID_SEGMENT)
+    {
+        if (unknown)
+        {
+            break;
+        }
+    }
+    if (id != MKV_ID_SEGMENT)
+    {
+        CAT_ERROR_MSG("No Matroska segment found");
+        return -1;
+    }
+
+    /* Segment children, the segment is read to its end or the file end. */
+    p = payload;
+    end = payload + payload_size;
+    while (p < end)
+    {
+        if (!next_element(p, end, id, payload, payload_size, unknown, true))
+        {
+            break;
+        }
+
+        if (id == MKV_ID_INFO)
+        {
+            const uint8_t *q = payload;
+            while (next_element(q, payload + payload_size, id, child,
+                        child_size, unknown))
+            {
+                if (id == MKV_ID_TIMECODE_SCALE && child_size <= 8)
+                {
+                    timecode_scale = read_uint(child, child_size);
+                }
+            }
+        }
+        else if (id == MKV_ID_TRACKS && !track_number)
+        {
+            const uint8_t *q = payload;
+            const uint8_t *entry;
+            uint64_t entry_size;
+
+            while (!track_number && next_element(q, payload + payload_size,
+                        id, entry, entry_size, unknown))
+            {
+                const uint8_t *r = entry;
+                const uint8_t *codec_private = NULL;
+                uint32_t codec_private_size = 0;
+                uint64_t number = 0, type = 0;
+                uint32_t codec = 0;
+                uint32_t track_width = 0, track_height = 0;
+                bool encoded = false;
+                std::string codec_id;
+
+                if (id != MKV_ID_TRACK_ENTRY)
+                {
+                    continue;
+                }
+                while (next_element(r, entry + entry_size, id, child,
+                            child_size, unknown))
+                {
+                    switch (id)
+                    {
+                        case MKV_ID_TRACK_NUMBER:
+                            number = read_uint(child, child_size);
+                            break;
+                        case MKV_ID_TRACK_TYPE:
+                            type = read_uint(child, child_size);
+                            break;
+                        case MKV_ID_CODEC_ID:
+                            codec_id.assign((const char *) child, child_size);
+                            codec_id = codec_id.c_str();
+                            break;
+                        case MKV_ID_CODEC_PRIVATE:
+                            codec_private = child;
+                            codec_private_size = child_size;
+                            break;
+                        case MKV_ID_CONTENT_ENCODINGS:
+                            encoded = true;
+                            break;
+                        case MKV_ID_VIDEO:
+                        {
+                            const uint8_t *s = child;
+                            const uint8_t *value;
+                            uint64_t value_size;
+
+                            while (next_element(s, child + child_size, id,
+                                        value, value_size, unknown))
+                            {
+                                if (id == MKV_ID_PIXEL_WIDTH)
+                                {
+                                    track_width = read_uint(value, value_size);
+                                }
+                                else if (id == MKV_ID_PIXEL_HEIGHT)
+                                {
+                                    track_height = read_uint(value, value_size);
+                                }
+                            }
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                }
+
+                if (type != MKV_TRACK_TYPE_VIDEO)
+                {
+                    continue;
+                }
+                if (codec_id == "V_MPEG4/ISO/AVC")
+                {
+                    codec = V4L2_PIX_FMT_H264;
+                }
+                else if (codec_id == "V_MPEGH/ISO/HEVC")
+                {
+                    codec = V4L2_PIX_FMT_H265;
+                }
+                else if (codec_id == "V_AV1")
+                {
+                    codec = V4L2_PIX_FMT_AV1;
+                }
+                else if (codec_id == "V_VP8")
+                {
+                    codec = V4L2_PIX_FMT_VP8;
+                }
+                else if (codec_id == "V_VP9")
+                {
+                    codec = V4L2_PIX_FMT_VP9;
+                }
+                else
+                {
+                    CAT_WARN_MSG("Unsupported codec " << codec_id <<
+                            " in track " << number);
+                    continue;
+                }
+                if (encoded)
+                {
+                    CAT_WARN_MSG("Track " << number << " uses content "
+                            "encoding, which is not supported");
+                    continue;
+                }
+                if (setCodec(codec, codec_private, codec_private_size) < 0)
+                {
+                    return -1;
+                }
+                track_number = number;
+                width = track_width;
+                height = track_height;
+            }
+            if (!track_number)
+            {
+                CAT_ERROR_MSG("No supported video track found");
+                return -1;
+            }
+        }
+        else if (id == MKV_ID_CLUSTER)
+        {
+            const uint8_t *cluster_end = payload + payload_size;
+            const uint8_t *q = payload;
+            const uint8_t *element;
+            int64_t cluster_timecode = 0;
+
+            if (!track_number)
+            {
+                CAT_ERROR_MSG("Cluster found before the track list");
+                return -1;
+            }
+
+            while (q < cluster_end)
+            {
+                const uint8_t *block = NULL;
+                uint64_t block_size = 0;
+                bool key_frame = false;
+                bool simple = false;
+                const uint8_t *start = q;
+                uint64_t value;
+                int len;
+
+                if (!next_element(q, cluster_end, id, element, child_size,
+                            unknown, true))
+                {
+                    q = cluster_end;
+                    break;
+                }
+                if (unknown || id == MKV_ID_CLUSTER || id == MKV_ID_CUES ||
+                        id == MKV_ID_TAGS || id == MKV_ID_CHAPTERS ||
+                        id == MKV_ID_ATTACHMENTS || id == MKV_ID_SEEK_HEAD ||
+                        id == MKV_ID_TRACKS || id == MKV_ID_INFO)
+                {
+                    /* End of a cluster of unknown size. */
+                    q = start;
+                    break;
+                }
+
+                if (id == MKV_ID_CLUSTER_TIMECODE)
+                {
+                    cluster_timecode = read_uint(element, child_size);
+                }
+                else if (id == MKV_ID_SIMPLE_BLOCK)
+                {
+                    block = element;
+                    block_size = child_size;
+                    simple = true;
+                }
+                else if (id == MKV_ID_BLOCK_GROUP)
+                {
+                    const uint8_t *r = element;
+                    key_frame = true;
+                    while (next_element(r, element + child_size, id, child,
+                                payload_size, unknown))
+                    {
+                        if (id == MKV_ID_BLOCK)
+                        {
+                            block = child;
+                            block_size = payload_size;
+                        }
+                        else if (id == MKV_ID_REFERENCE_BLOCK)
+                        {
+                            key_frame = false;
+                        }
+                    }
+                }
+
+                if (!block)
+                {
+                    continue;
+                }
+
+                /* Track number, relative timecode and flags. */
+                len = read_vint(block, block + block_size, value, false);
+                if (!len || block_size < (uint64_t) len + 3)
+                {
+                    continue;
+                }
+                if (value != track_number)
+                {
+                    continue;
+                }
+                if (simple)
+                {
+                    key_frame = block[len + 2] & 0x80;
+                }
+                if ((block[len + 2] >> 1) & 0x3)
+                {
+                    if (!warned_lacing)
+                    {
+                        CAT_WARN_MSG("Laced blocks are not supported, "
+                                "skipping them");
+                        warned_lacing = true;
+                    }
+                    continue;
+                }
+
+                NvContainerSample sample;
+                int16_t relative = (int16_t) read_be16(block + len);
+
+                sample.offset = (block + len + 3) - data;
+                sample.size = block_size - len - 3;
+                sample.pts = (cluster_timecode + relative) *
+                    (int64_t) timecode_scale / 1000;
+                sample.key_frame = key_frame;
+                samples.push_back(sample);
+            }
+            p = q;
+        }
+    }
+
+    if (!track_number)
+    {
+        CAT_ERROR_MSG("No video track found");
+        return -1;
+    }
+    return 0;
+}
+
+int
+NvContainerReader::readNextSample(NvBuffer *buffer,
+        const NvContainerSample **sample)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+    uint8_t *dst = plane.data;
+    uint32_t used = 0;
+    const uint8_t *src, *src_end;
+
+    if (sample)
+    {
+        *sample = NULL;
+    }
+    plane.bytesused = 0;
+
+    if (current >= samples.size())
+    {
+        rewind();
+        return 0;
+    }
+
+    const NvContainerSample &s = samples[current];
+    src = data + s.offset;
+    src_end = src + s.size;
+
+    if (pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        /* Containers strip the temporal delimiters, the decoder wants them. */
+        if (plane.length < sizeof(av1_temporal_delimiter))
+        {
+            goto too_large;
+        }
+        memcpy(dst, av1_temporal_delimiter, sizeof(av1_temporal_delimiter));
+        used = sizeof(av1_temporal_delimiter);
+        if (s.key_frame && !has_av1_sequence_header(src, src_end))
+        {
+            if (plane.length - used < parameter_sets.size())
+            {
+                goto too_large;
+            }
+            if (!parameter_sets.empty())
+            {
+                memcpy(dst + used, &parameter_sets[0], parameter_sets.size());
+                used += parameter_sets.size();
+            }
+        }
+    }
+    else if (s.key_frame && !parameter_sets.empty())
+    {
+        if (plane.length < parameter_sets.size())
+        {
+            goto too_large;
+        }
+        memcpy(dst, &parameter_sets[0], parameter_sets.size());
+        used = parameter_sets.size();
+    }
+
+    if (nal_length_size == 4)
+    {
+        uint8_t *p, *end;
+
+        /* Same size as start codes, overwrite the prefixes in place. */
+        if (plane.length - used < s.size)
+        {
+            goto too_large;
+        }
+        memcpy(dst + used, src, s.size);
+        p = dst + used;
+        end = p + s.size;
+        while (p < end)
+        {
+            uint32_t len;
+
+            if (end - p < 4)
+            {
+                goto malformed;
+            }
+            len = read_be32(p);
+            if (len > (uint32_t) (end - p - 4))
+            {
+                goto malformed;
+            }
+            memcpy(p, start_code, 4);
+            p += 4 + len;
+        }
+        used += s.size;
+    }
+    else if (nal_length_size)
+    {
+        /* Shorter prefixes grow into start codes, copy NAL by NAL. */
+        while (src < src_end)
+        {
+            uint32_t len;
+
+            if ((uint32_t) (src_end - src) < nal_length_size)
+            {
+                goto malformed;
+            }
+            len = read_uint(src, nal_length_size);
+            src += nal_length_size;
+            if (len > (uint32_t) (src_end - src))
+            {
+                goto malformed;
+            }
+            if (plane.length - used < 4 + len)
+            {
+                goto too_large;
+            }
+            memcpy(dst + used, start_code, 4);
+            memcpy(dst + used + 4, src, len);
+            used += 4 + len;
+            src += len;
+        }
+    }
+    else
+    {
+        if (plane.length - used < s.size)
+        {
+            goto too_large;
+        }
+        memcpy(dst + used, src, s.size);
+        used += s.size;
+    }
+
+    plane.bytesused = used;
+    current++;
+    if (sample)
+    {
+        *sample = &s;
+    }
+    return 0;
+
+too_large:
+    CAT_ERROR_MSG("Sample " << current << " of size " << s.size <<
+            " does not fit in buffer of size " << plane.length);
+    return -1;
+
+malformed:
+    CAT_ERROR_MSG("Sample " << current << " has an invalid NAL unit length");
+    return -1;
+}
+
+int
+NvContainerReader::seek(uint64_t index)
+{
+    if (index >= samples.size())
+    {
+        CAT_ERROR_MSG("Cannot seek to sample " << index << " of " <<
+                samples.size());
+        return -1;
+    }
+    current = index;
+    return 0;
+}
+
+int64_t
+NvContainerReader::seekToKeyFrame(uint64_t index)
+{
+    uint64_t i;
+
+    if (seek(index) < 0)
+    {
+        return -1;
+    }
+    for (i = index; i > 0 && !samples[i].key_frame; i--)
+    {
+    }
+    if (!samples[i].key_frame)
+    {
+        CAT_ERROR_MSG("No key frame at or before sample " << index);
+        return -1;
+    }
+    current = i;
+    return i;
+}
+
+void
+NvContainerReader::rewind()
+{
+    current = 0;
+}
@@ -0,0 +1,1941 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvCpuTransform.h"
+#include "NvLogging.h"
+#include "NvTracer.h"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_TRANSFORM_X86
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CPU_TRANSFORM_NEON
+#endif
+
+#define CAT_NAME "CpuTransform"
+
+/* Fewest rows handed to a thread at once, a band also pays for the source
+ * rows that the vertical filter reads above and below it. */
+#define MIN_BAND_ROWS 16
+#define PLANE_ALIGNMENT 64
+
+/* Value of a missing chroma channel, 128 on 8 bits. */
+#define NEUTRAL_CHROMA 0x8080
+
+enum
+{
+    SIMD_NONE,
+    SIMD_AVX2,
+    SIMD_NEON
+};
+
+enum
+{
+    FILTER_NEAREST,
+    FILTER_BILINEAR,
+    FILTER_BICUBIC
+};
+
+enum
+{
+    MATRIX_601,
+    MATRIX_709,
+    MATRIX_2020
+};
+
+/**
+ * Describes how the channels of a color format are laid out. Channels are
+ * Y, U, V for YUV formats and R, G, B, A for RGB formats.
+ */
+struct NvCpuTransform::FormatDesc
+{
+    NvBufSurfaceColorFormat format;
+    uint8_t num_planes;
+    /* 1 for GRAY8, 4 for RGB formats with an alpha or padding byte. */
+    uint8_t num_channels;
+    bool is_rgb;
+    /* Whether the fourth channel holds alpha rather than padding. */
+    bool has_alpha;
+    uint8_t depth;
+    /* Log2 of the chroma subsampling. */
+    uint8_t shift_x;
+    uint8_t shift_y;
+    uint8_t matrix;
+    bool full_range;
+    /* Per channel: plane, offset of the first sample in the plane row and
+     * distance between two samples, both in samples. */
+    uint8_t plane[4];
+    uint8_t offset[4];
+    uint8_t step[4];
+    uint8_t bytes_per_pix[3];
+};
+
+#define PLANAR(f, m, r, sx, sy, u, v) \
+    { f, 3, 3, false, false, 8, sx, sy, m, r, \
+      {0, u, v, 0}, {0, 0, 0, 0}, {1, 1, 1, 0}, {1, 1, 1} }
+#define SEMI_PLANAR(f, d, m, r, sx, sy, u, v) \
+    { f, 2, 3, false, false, d, sx, sy, m, r, \
+      {0, 1, 1, 0}, {0, u, v, 0}, {1, 2, 2, 0}, \
+      {(d) > 8 ? 2 : 1, (d) > 8 ? 4 : 2, 0} }
+#define PACKED_422(f, r, y, u, v) \
+    { f, 1, 3, false, false, 8, 1, 0, MATRIX_601, r, \
+      {0, 0, 0, 0}, {y, u, v, 0}, {2, 4, 4, 0}, {2, 0, 0} }
+#define PACKED_RGB(f, size, alpha, r, g, b, a) \
+    { f, 1, size, true, alpha, 8, 0, 0, MATRIX_601, true, \
+      {0, 0, 0, 0}, {r, g, b, a}, {size, size, size, size}, {size, 0, 0} }
+
+const NvCpuTransform::FormatDesc NvCpuTransform::format_descs[] =
+{
+    { NVBUF_COLOR_FORMAT_GRAY8, 1, 1, false, false, 8, 0, 0, MATRIX_601, true,
+      {0, 0, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {1, 0, 0} },
+
+    PLANAR(NVBUF_COLOR_FORMAT_YUV420, MATRIX_601, false, 1, 1, 1, 2),
+    PLANAR(NVBUF_COLOR_FORMAT_YUV420_ER, MATRIX_601, true, 1, 1, 1, 2),
+    PLANAR(NVBUF_COLOR_FORMAT_YVU420, MATRIX_601, false, 1, 1, 2, 1),
+    PLANAR(NVBUF_COLOR_FORMAT_YVU420_ER, MATRIX_601, true, 1, 1, 2, 1),
+    PLANAR(NVBUF_COLOR_FORMAT_YUV420_709, MATRIX_709, false, 1, 1, 1, 2),
+    PLANAR(NVBUF_COLOR_FORMAT_YUV420_709_ER, MATRIX_709, true, 1, 1, 1, 2),
+    PLANAR(NVBUF_COLOR_FORMAT_YUV420_2020, MATRIX_2020, false, 1, 1, 1, 2),
+    PLANAR(NVBUF_COLOR_FORMAT_YUV422, MATRIX_601, false, 1, 0, 1, 2),
+    PLANAR(NVBUF_COLOR_FORMAT_YUV444, MATRIX_601, false, 0, 0, 1, 2),
+
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12, 8, MATRIX_601, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_ER, 8, MATRIX_601, true, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV21, 8, MATRIX_601, false, 1, 1, 1, 0),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV21_ER, 8, MATRIX_601, true, 1, 1, 1, 0),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_709, 8, MATRIX_709, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_709_ER, 8, MATRIX_709, true, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_2020, 8, MATRIX_2020, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV16, 8, MATRIX_601, false, 1, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV16_ER, 8, MATRIX_601, true, 1, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV16_709, 8, MATRIX_709, false, 1, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV16_709_ER, 8, MATRIX_709, true, 1, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24, 8, MATRIX_601, false, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_ER, 8, MATRIX_601, true, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_709, 8, MATRIX_709, false, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_709_ER, 8, MATRIX_709, true, 0, 0, 0, 1),
+
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_10LE, 10, MATRIX_601, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_10LE_ER, 10, MATRIX_601, true, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_10LE_709, 10, MATRIX_709, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_10LE_709_ER, 10, MATRIX_709, true, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_10LE_2020, 10, MATRIX_2020, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV21_10LE, 10, MATRIX_601, false, 1, 1, 1, 0),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV16_10LE, 10, MATRIX_601, false, 1, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_10LE, 10, MATRIX_601, false, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_10LE_709, 10, MATRIX_709, false, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_10LE_709_ER, 10, MATRIX_709, true, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_10LE_2020, 10, MATRIX_2020, false, 0, 0, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_12LE, 12, MATRIX_601, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV12_12LE_2020, 12, MATRIX_2020, false, 1, 1, 0, 1),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV21_12LE, 12, MATRIX_601, false, 1, 1, 1, 0),
+    SEMI_PLANAR(NVBUF_COLOR_FORMAT_NV24_12LE_2020, 12, MATRIX_2020, false, 0, 0, 0, 1),
+
+    PACKED_422(NVBUF_COLOR_FORMAT_YUYV, false, 0, 1, 3),
+    PACKED_422(NVBUF_COLOR_FORMAT_YUYV_ER, true, 0, 1, 3),
+    PACKED_422(NVBUF_COLOR_FORMAT_YVYU, false, 0, 3, 1),
+    PACKED_422(NVBUF_COLOR_FORMAT_YVYU_ER, true, 0, 3, 1),
+    PACKED_422(NVBUF_COLOR_FORMAT_UYVY, false, 1, 0, 2),
+    PACKED_422(NVBUF_COLOR_FORMAT_UYVY_ER, true, 1, 0, 2),
+    PACKED_422(NVBUF_COLOR_FORMAT_VYUY, false, 1, 2, 0),
+    PACKED_422(NVBUF_COLOR_FORMAT_VYUY_ER, true, 1, 2, 0),
+
+    PACKED_RGB(NVBUF_COLOR_FORMAT_RGBA, 4, true, 0, 1, 2, 3),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_BGRA, 4, true, 2, 1, 0, 3),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_ARGB, 4, true, 1, 2, 3, 0),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_ABGR, 4, true, 3, 2, 1, 0),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_RGBx, 4, false, 0, 1, 2, 3),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_BGRx, 4, false, 2, 1, 0, 3),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_xRGB, 4, false, 1, 2, 3, 0),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_xBGR, 4, false, 3, 2, 1, 0),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_RGB, 3, false, 0, 1, 2, 0),
+    PACKED_RGB(NVBUF_COLOR_FORMAT_BGR, 3, false, 2, 1, 0, 0),
+};
+
+const NvCpuTransform::FormatDesc *
+NvCpuTransform::getFormatDesc(NvBufSurfaceColorFormat format)
+{
+    for (size_t i = 0; i < sizeof(format_descs) / sizeof(format_descs[0]); i++)
+    {
+        if (format_descs[i].format == format)
+        {
+            return &format_descs[i];
+        }
+    }
+    return NULL;
+}
+
+bool
+NvCpuTransform::isChroma(const FormatDesc *desc, uint32_t channel)
+{
+    return !desc->is_rgb && (channel == 1 || channel == 2);
+}
+
+bool
+NvCpuTransform::isPacked422(const FormatDesc *desc)
+{
+    return !desc->is_rgb && desc->num_planes == 1 && desc->shift_x;
+}
+
+/*
+ * Row kernels. Each kernel has a scalar loop, which also handles the tail
+ * of the row, and AVX2 or NEON versions of the loop that return the number
+ * of elements they processed. The vector versions add the products in the
+ * same order as the scalar loop.
+ */
+
+#if defined(CPU_TRANSFORM_X86)
+
+__attribute__((target("avx2"))) static uint32_t
+filterRowHAvx2(const float *src, const int32_t *index, const float *weight,
+        uint32_t taps, uint32_t stride, uint32_t n, float *dst)
+{
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            __m256i idx = _mm256_loadu_si256(
+                    (const __m256i *) (index + t * stride + i));
+            __m256 s = _mm256_i32gather_ps(src, idx, 4);
+            sum = _mm256_add_ps(sum,
+                    _mm256_mul_ps(s, _mm256_loadu_ps(weight + t * stride + i)));
+        }
+        _mm256_storeu_ps(dst + i, sum);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static uint32_t
+filterRowVAvx2(const float * const *rows, const float *weight, uint32_t taps,
+        uint32_t n, float *dst)
+{
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(
+                        _mm256_loadu_ps(rows[t] + i),
+                        _mm256_set1_ps(weight[t])));
+        }
+        _mm256_storeu_ps(dst + i, sum);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static uint32_t
+floatToU16Avx2(const float *src, uint32_t n, uint16_t *dst)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max = _mm256_set1_ps(65535.0f);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), zero),
+                max);
+        __m256i x = _mm256_cvtps_epi32(v);
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(x),
+                _mm256_extracti128_si256(x, 1));
+        _mm_storeu_si128((__m128i *) (dst + i), packed);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static uint32_t
+u16ToFloatAvx2(const uint16_t *src, uint32_t n, float *dst)
+{
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *) (src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(x));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static uint32_t
+applyMatrixAvx2(float *c0, float *c1, float *c2, uint32_t n, const float *m)
+{
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 a = _mm256_loadu_ps(c0 + i);
+        __m256 b = _mm256_loadu_ps(c1 + i);
+        __m256 c = _mm256_loadu_ps(c2 + i);
+        float *out[3] = { c0, c1, c2 };
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const float *row = m + 4 * k;
+            __m256 v = _mm256_mul_ps(a, _mm256_set1_ps(row[0]));
+            v = _mm256_add_ps(v, _mm256_mul_ps(b, _mm256_set1_ps(row[1])));
+            v = _mm256_add_ps(v, _mm256_mul_ps(c, _mm256_set1_ps(row[2])));
+            v = _mm256_add_ps(v, _mm256_set1_ps(row[3]));
+            _mm256_storeu_ps(out[k] + i, v);
+        }
+    }
+    return i;
+}
+
+#elif defined(CPU_TRANSFORM_NEON)
+
+static uint32_t
+filterRowHNeon(const float *src, const int32_t *index, const float *weight,
+        uint32_t taps, uint32_t stride, uint32_t n, float *dst)
+{
+    uint32_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            const int32_t *idx = index + t * stride + i;
+            float32x4_t s = vdupq_n_f32(src[idx[0]]);
+            s = vsetq_lane_f32(src[idx[1]], s, 1);
+            s = vsetq_lane_f32(src[idx[2]], s, 2);
+            s = vsetq_lane_f32(src[idx[3]], s, 3);
+            sum = vaddq_f32(sum, vmulq_f32(s, vld1q_f32(weight + t * stride + i)));
+        }
+        vst1q_f32(dst + i, sum);
+    }
+    return i;
+}
+
+static uint32_t
+filterRowVNeon(const float * const *rows, const float *weight, uint32_t taps,
+        uint32_t n, float *dst)
+{
+    uint32_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(rows[t] + i), weight[t]));
+        }
+        vst1q_f32(dst + i, sum);
+    }
+    return i;
+}
+
+static uint32_t
+floatToU16Neon(const float *src, uint32_t n, uint16_t *dst)
+{
+    const float32x4_t max = vdupq_n_f32(65535.0f);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        /* Negative values saturate to 0 in the conversion. */
+        uint32x4_t lo = vcvtnq_u32_f32(vminq_f32(vld1q_f32(src + i), max));
+        uint32x4_t hi = vcvtnq_u32_f32(vminq_f32(vld1q_f32(src + i + 4), max));
+        vst1q_u16(dst + i, vcombine_u16(vqmovn_u32(lo), vqmovn_u32(hi)));
+    }
+    return i;
+}
+
+static uint32_t
+u16ToFloatNeon(const uint16_t *src, uint32_t n, float *dst)
+{
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        uint16x8_t x = vld1q_u16(src + i);
+        vst1q_f32(dst + i, vcvtq_f32_u32(vmovl_u16(vget_low_u16(x))));
+        vst1q_f32(dst + i + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(x))));
+    }
+    return i;
+}
+
+static uint32_t
+applyMatrixNeon(float *c0, float *c1, float *c2, uint32_t n, const float *m)
+{
+    uint32_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        float32x4_t a = vld1q_f32(c0 + i);
+        float32x4_t b = vld1q_f32(c1 + i);
+        float32x4_t c = vld1q_f32(c2 + i);
+        float *out[3] = { c0, c1, c2 };
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const float *row = m + 4 * k;
+            float32x4_t v = vmulq_n_f32(a, row[0]);
+            v = vaddq_f32(v, vmulq_n_f32(b, row[1]));
+            v = vaddq_f32(v, vmulq_n_f32(c, row[2]));
+            v = vaddq_f32(v, vdupq_n_f32(row[3]));
+            vst1q_f32(out[k] + i, v);
+        }
+    }
+    return i;
+}
+
+#endif
+
+/*
+ * Computes dst[i] as the sum over the taps of src[index] * weight, where
+ * the indices and weights of tap t start at t * stride.
+ */
+static void
+filterRowH(int simd, const float *src, const int32_t *index,
+        const float *weight, uint32_t taps, uint32_t stride, uint32_t n,
+        float *dst)
+{
+    uint32_t i = 0;
+
+#if defined(CPU_TRANSFORM_X86)
+    if (simd == SIMD_AVX2)
+    {
+        i = filterRowHAvx2(src, index, weight, taps, stride, n, dst);
+    }
+#elif defined(CPU_TRANSFORM_NEON)
+    if (simd == SIMD_NEON)
+    {
+        i = filterRowHNeon(src, index, weight, taps, stride, n, dst);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float sum = 0.0f;
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            sum += src[index[t * stride + i]] * weight[t * stride + i];
+        }
+        dst[i] = sum;
+    }
+}
+
+/*
+ * Computes dst[i] as the sum over the taps of rows[t][i] * weight[t].
+ */
+static void
+filterRowV(int simd, const float * const *rows, const float *weight,
+        uint32_t taps, uint32_t n, float *dst)
+{
+    uint32_t i = 0;
+
+#if defined(CPU_TRANSFORM_X86)
+    if (simd == SIMD_AVX2)
+    {
+        i = filterRowVAvx2(rows, weight, taps, n, dst);
+    }
+#elif defined(CPU_TRANSFORM_NEON)
+    if (simd == SIMD_NEON)
+    {
+        i = filterRowVNeon(rows, weight, taps, n, dst);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float sum = 0.0f;
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            sum += rows[t][i] * weight[t];
+        }
+        dst[i] = sum;
+    }
+}
+
+/*
+ * Rounds to the nearest 16-bit sample, ties to even, with saturation.
+ */
+static void
+floatToU16(int simd, const float *src, uint32_t n, uint16_t *dst)
+{
+    uint32_t i = 0;
+
+#if defined(CPU_TRANSFORM_X86)
+    if (simd == SIMD_AVX2)
+    {
+        i = floatToU16Avx2(src, n, dst);
+    }
+#elif defined(CPU_TRANSFORM_NEON)
+    if (simd == SIMD_NEON)
+    {
+        i = floatToU16Neon(src, n, dst);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float v = src[i];
+        dst[i] = v > 0.0f ? (v < 65535.0f ? (uint16_t) lrintf(v) : 65535) : 0;
+    }
+}
+
+static void
+u16ToFloat(int simd, const uint16_t *src, uint32_t n, float *dst)
+{
+    uint32_t i = 0;
+
+#if defined(CPU_TRANSFORM_X86)
+    if (simd == SIMD_AVX2)
+    {
+        i = u16ToFloatAvx2(src, n, dst);
+    }
+#elif defined(CPU_TRANSFORM_NEON)
+    if (simd == SIMD_NEON)
+    {
+        i = u16ToFloatNeon(src, n, dst);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        dst[i] = src[i];
+    }
+}
+
+/*
+ * Applies the 3x4 affine matrix m in place to the three channel rows.
+ */
+static void
+applyMatrix(int simd, float *c0, float *c1, float *c2, uint32_t n,
+        const float *m)
+{
+    uint32_t i = 0;
+
+#if defined(CPU_TRANSFORM_X86)
+    if (simd == SIMD_AVX2)
+    {
+        i = applyMatrixAvx2(c0, c1, c2, n, m);
+    }
+#elif defined(CPU_TRANSFORM_NEON)
+    if (simd == SIMD_NEON)
+    {
+        i = applyMatrixNeon(c0, c1, c2, n, m);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float a = c0[i];
+        float b = c1[i];
+        float c = c2[i];
+        c0[i] = m[0] * a + m[1] * b + m[2] * c + m[3];
+        c1[i] = m[4] * a + m[5] * b + m[6] * c + m[7];
+        c2[i] = m[8] * a + m[9] * b + m[10] * c + m[11];
+    }
+}
+
+/*
+ * Sample access. Samples are widened to 16 bits by replicating their most
+ * significant bits, so that 8, 10 and 12-bit peaks all map to 65535, and
+ * narrowed back with rounding. The loops take the step as a constant so
+ * that the compiler can vectorize the interleaved accesses.
+ */
+
+template <uint32_t STEP>
+static void
+readRow8(const uint8_t *src, uint32_t n, uint16_t *dst)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dst[i] = src[i * STEP] * 257;
+    }
+}
+
+template <uint32_t STEP>
+static void
+readRow16(const uint16_t *src, uint32_t n, uint32_t depth, uint16_t *dst)
+{
+    const uint16_t mask = 0xFFFF << (16 - depth);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint16_t v = src[i * STEP] & mask;
+        dst[i] = v | (v >> depth);
+    }
+}
+
+template <uint32_t STEP>
+static void
+writeRow8(const uint16_t *src, uint32_t n, uint8_t *dst)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t s = src[i];
+        dst[i * STEP] = (s - (s >> 8) + 128) >> 8;
+    }
+}
+
+template <uint32_t STEP>
+static void
+writeRow16(const uint16_t *src, uint32_t n, uint32_t depth, uint16_t *dst)
+{
+    const uint32_t shift = 16 - depth;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t s = src[i];
+        dst[i * STEP] = ((s - (s >> depth) + (1 << (shift - 1))) >> shift) << shift;
+    }
+}
+
+void
+NvCpuTransform::readSamples(const Channel &channel, uint32_t row, uint32_t x,
+        uint32_t n, uint16_t *dst)
+{
+    if (!channel.base)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            dst[i] = channel.fill;
+        }
+        return;
+    }
+
+    const uint8_t *line = channel.base + (size_t) row * channel.pitch;
+    if (channel.depth == 8)
+    {
+        const uint8_t *src = line + (size_t) x * channel.step;
+        switch (channel.step)
+        {
+            case 1: readRow8<1>(src, n, dst); break;
+            case 2: readRow8<2>(src, n, dst); break;
+            case 3: readRow8<3>(src, n, dst); break;
+            default: readRow8<4>(src, n, dst); break;
+        }
+    }
+    else
+    {
+        const uint16_t *src = (const uint16_t *) line + (size_t) x * channel.step;
+        if (channel.step == 1)
+        {
+            readRow16<1>(src, n, channel.depth, dst);
+        }
+        else
+        {
+            readRow16<2>(src, n, channel.depth, dst);
+        }
+    }
+}
+
+void
+NvCpuTransform::writeSamples(const Channel &channel, uint32_t row, uint32_t x,
+        uint32_t n, const uint16_t *src)
+{
+    uint8_t *line = channel.base + (size_t) row * channel.pitch;
+
+    if (channel.depth == 8)
+    {
+        uint8_t *dst = line + (size_t) x * channel.step;
+        switch (channel.step)
+        {
+            case 1: writeRow8<1>(src, n, dst); break;
+            case 2: writeRow8<2>(src, n, dst); break;
+            case 3: writeRow8<3>(src, n, dst); break;
+            default: writeRow8<4>(src, n, dst); break;
+        }
+    }
+    else
+    {
+        uint16_t *dst = (uint16_t *) line + (size_t) x * channel.step;
+        if (channel.step == 1)
+        {
+            writeRow16<1>(src, n, channel.depth, dst);
+        }
+        else
+        {
+            writeRow16<2>(src, n, channel.depth, dst);
+        }
+    }
+}
+
+/*
+ * Fills @a channel with channel @a index of @a surface. When reading, the
+ * padding byte of the RGBx formats and the chroma of GRAY8 are missing
+ * channels. When writing, padding is a regular channel that receives the
+ * value of a missing alpha channel.
+ */
+void
+NvCpuTransform::getChannel(const FormatDesc *desc,
+        const NvCpuSurface *surface, uint32_t index, bool write,
+        Channel *channel)
+{
+    uint32_t plane = desc->plane[index];
+    uint32_t sample_size = desc->depth > 8 ? 2 : 1;
+
+    memset(channel, 0, sizeof(Channel));
+    channel->fill = (index == 3) ? 0xFFFF : NEUTRAL_CHROMA;
+    channel->width = surface->width;
+    channel->height = surface->height;
+    if (isChroma(desc, index))
+    {
+        channel->width = (surface->width + (1 << desc->shift_x) - 1) >>
+            desc->shift_x;
+        channel->height = (surface->height + (1 << desc->shift_y) - 1) >>
+            desc->shift_y;
+    }
+
+    if (index >= desc->num_channels ||
+            (index == 3 && !desc->has_alpha && !write))
+    {
+        return;
+    }
+
+    channel->base = surface->addr[plane] + desc->offset[index] * sample_size;
+    channel->pitch = surface->planeParams.pitch[plane];
+    channel->step = desc->step[index];
+    channel->depth = desc->depth;
+}
+
+static float
+filterKernel(int method, double x)
+{
+    x = fabs(x);
+    if (method == FILTER_BILINEAR)
+    {
+        return x < 1.0 ? 1.0 - x : 0.0;
+    }
+    /* Keys cubic convolution with a = -0.5. */
+    if (x < 1.0)
+    {
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    }
+    if (x < 2.0)
+    {
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    }
+    return 0.0;
+}
+
+/*
+ * Computes the taps that map the window [start, start + length) of a
+ * channel of in_size samples onto out_size samples. The taps are stored
+ * tap-major, stride entries per tap, with indices relative to first.
+ * first and count receive the range of source samples that are read.
+ *
+ * Returns the number of taps, or 0 if the window is copied as is.
+ */
+static uint32_t
+buildFilter(int method, uint32_t in_size, double start, double length,
+        uint32_t out_size, uint32_t stride, std::vector<int32_t> &index,
+        std::vector<float> &weight, uint32_t &first, uint32_t &count)
+{
+    double scale = length / out_size;
+    int32_t lo = (int32_t) floor(start);
+    int32_t hi = (int32_t) ceil(start + length);
+    uint32_t taps;
+
+    if (scale == 1.0 && start == floor(start) && lo + out_size <= in_size)
+    {
+        first = lo;
+        count = out_size;
+        return 0;
+    }
+
+    if (lo > (int32_t) in_size - 1)
+    {
+        lo = in_size - 1;
+    }
+    if (hi > (int32_t) in_size)
+    {
+        hi = in_size;
+    }
+    if (hi <= lo)
+    {
+        hi = lo + 1;
+    }
+    first = lo;
+    count = hi - lo;
+
+    if (method == FILTER_NEAREST)
+    {
+        index.assign(stride, 0);
+        weight.assign(stride, 0.0f);
+        for (uint32_t i = 0; i < out_size; i++)
+        {
+            int32_t x = (int32_t) floor(start + (i + 0.5) * scale);
+            x = x < lo ? lo : (x >= hi ? hi - 1 : x);
+            index[i] = x - lo;
+            weight[i] = 1.0f;
+        }
+        return 1;
+    }
+
+    /* Widen the filter when downscaling so that it covers all the source
+     * samples, as an area filter would. */
+    double filter_scale = scale > 1.0 ? scale : 1.0;
+    double support = (method == FILTER_BILINEAR ? 1.0 : 2.0) * filter_scale;
+    uint32_t max_taps = (uint32_t) ceil(support) * 2 + 1;
+    std::vector<double> w(max_taps);
+
+    index.assign(max_taps * stride, 0);
+    weight.assign(max_taps * stride, 0.0f);
+    taps = 1;
+    for (uint32_t i = 0; i < out_size; i++)
+    {
+        double center = start + (i + 0.5) * scale;
+        int32_t x0 = (int32_t) floor(center - support + 0.5);
+        int32_t x1 = (int32_t) floor(center + support + 0.5);
+        double sum = 0.0;
+
+        x0 = x0 < lo ? lo : (x0 >= hi ? hi - 1 : x0);
+        x1 = x1 > hi ? hi : (x1 <= x0 ? x0 + 1 : x1);
+        if ((uint32_t) (x1 - x0) > max_taps)
+        {
+            x1 = x0 + max_taps;
+        }
+
+        for (int32_t x = x0; x < x1; x++)
+        {
+            w[x - x0] = filterKernel(method, (x + 0.5 - center) / filter_scale);
+            sum += w[x - x0];
+        }
+        for (int32_t x = x0; x < x1; x++)
+        {
+            uint32_t t = x - x0;
+            index[t * stride + i] = x - lo;
+            if (sum != 0.0)
+            {
+                weight[t * stride + i] = w[t] / sum;
+            }
+            else
+            {
+                weight[t * stride + i] = (t == 0) ? 1.0f : 0.0f;
+            }
+        }
+        /* Unused taps read the first sample with a weight of 0. */
+        for (uint32_t t = x1 - x0; t < max_taps; t++)
+        {
+            index[t * stride + i] = x0 - lo;
+        }
+        if ((uint32_t) (x1 - x0) > taps)
+        {
+            taps = x1 - x0;
+        }
+    }
+    return taps;
+}
+
+static void
+getLumaWeights(uint32_t matrix, double &kr, double &kb)
+{
+    switch (matrix)
+    {
+        case MATRIX_709:
+            kr = 0.2126;
+            kb = 0.0722;
+            break;
+        case MATRIX_2020:
+            kr = 0.2627;
+            kb = 0.0593;
+            break;
+        default:
+            kr = 0.299;
+            kb = 0.114;
+            break;
+    }
+}
+
+/*
+ * Gets the affine transform from the 16-bit samples of a format to RGB
+ * samples on 16 bits.
+ */
+void
+NvCpuTransform::getToRgbMatrix(const FormatDesc *desc, double m[12])
+{
+    double kr, kb, kg;
+    double ys, yo, cs, co;
+
+    memset(m, 0, 12 * sizeof(double));
+    if (desc->is_rgb)
+    {
+        m[0] = m[5] = m[10] = 1.0;
+        return;
+    }
+
+    getLumaWeights(desc->matrix, kr, kb);
+    kg = 1.0 - kr - kb;
+    ys = desc->full_range ? 1.0 : 255.0 / 219.0;
+    yo = desc->full_range ? 0.0 : 16.0 * 257.0;
+    cs = desc->full_range ? 1.0 : 255.0 / 224.0;
+    co = 128.0 * 257.0;
+
+    double rv = cs * 2.0 * (1.0 - kr);
+    double gu = -cs * 2.0 * kb * (1.0 - kb) / kg;
+    double gv = -cs * 2.0 * kr * (1.0 - kr) / kg;
+    double bu = cs * 2.0 * (1.0 - kb);
+
+    m[0] = ys; m[1] = 0.0; m[2] = rv; m[3] = -ys * yo - rv * co;
+    m[4] = ys; m[5] = gu;  m[6] = gv; m[7] = -ys * yo - (gu + gv) * co;
+    m[8] = ys; m[9] = bu;  m[10] = 0.0; m[11] = -ys * yo - bu * co;
+}
+
+/*
+ * Inverts the affine transform m.
+ */
+static void
+invertMatrix(const double m[12], double inv[12])
+{
+    double det = m[0] * (m[5] * m[10] - m[6] * m[9]) -
+        m[1] * (m[4] * m[10] - m[6] * m[8]) +
+        m[2] * (m[4] * m[9] - m[5] * m[8]);
+
+    inv[0] = (m[5] * m[10] - m[6] * m[9]) / det;
+    inv[1] = (m[2] * m[9] - m[1] * m[10]) / det;
+    inv[2] = (m[1] * m[6] - m[2] * m[5]) / det;
+    inv[4] = (m[6] * m[8] - m[4] * m[10]) / det;
+    inv[5] = (m[0] * m[10] - m[2] * m[8]) / det;
+    inv[6] = (m[2] * m[4] - m[0] * m[6]) / det;
+    inv[8] = (m[4] * m[9] - m[5] * m[8]) / det;
+    inv[9] = (m[1] * m[8] - m[0] * m[9]) / det;
+    inv[10] = (m[0] * m[5] - m[1] * m[4]) / det;
+    for (int k = 0; k < 3; k++)
+    {
+        inv[4 * k + 3] = -(inv[4 * k] * m[3] + inv[4 * k + 1] * m[7] +
+                inv[4 * k + 2] * m[11]);
+    }
+}
+
+/*
+ * Gets the walk through a working plane of pw x ph samples that yields
+ * row y of the flipped plane: sample x of the row is at base + x * step.
+ * Rotations are counter-clockwise.
+ */
+static void
+getFlipWalk(NvBufSurfTransform_Flip flip, uint32_t pw, uint32_t ph,
+        uint32_t y, ptrdiff_t &base, ptrdiff_t &step)
+{
+    switch (flip)
+    {
+        case NvBufSurfTransform_Rotate90:
+            base = pw - 1 - y;
+            step = pw;
+            break;
+        case NvBufSurfTransform_Rotate180:
+            base = (ptrdiff_t) (ph - 1 - y) * pw + pw - 1;
+            step = -1;
+            break;
+        case NvBufSurfTransform_Rotate270:
+            base = (ptrdiff_t) (ph - 1) * pw + y;
+            step = -(ptrdiff_t) pw;
+            break;
+        case NvBufSurfTransform_FlipX:
+            base = (ptrdiff_t) y * pw + pw - 1;
+            step = -1;
+            break;
+        case NvBufSurfTransform_FlipY:
+            base = (ptrdiff_t) (ph - 1 - y) * pw;
+            step = 1;
+            break;
+        case NvBufSurfTransform_Transpose:
+            base = y;
+            step = pw;
+            break;
+        case NvBufSurfTransform_InvTranspose:
+            base = (ptrdiff_t) (ph - 1) * pw + pw - 1 - y;
+            step = -(ptrdiff_t) pw;
+            break;
+        default:
+            base = (ptrdiff_t) y * pw;
+            step = 1;
+            break;
+    }
+}
+
+static bool
+isTransposed(NvBufSurfTransform_Flip flip)
+{
+    return flip == NvBufSurfTransform_Rotate90 ||
+        flip == NvBufSurfTransform_Rotate270 ||
+        flip == NvBufSurfTransform_Transpose ||
+        flip == NvBufSurfTransform_InvTranspose;
+}
+
+/*
+ * Gets the samples of row y of the flipped working plane, either in place
+ * or gathered into @a scratch.
+ */
+static const uint16_t *
+getFlippedRow(NvBufSurfTransform_Flip flip, const uint16_t *plane,
+        uint32_t pw, uint32_t ph, uint32_t y, uint32_t n, uint16_t *scratch)
+{
+    ptrdiff_t base, step;
+
+    getFlipWalk(flip, pw, ph, y, base, step);
+    if (step == 1)
+    {
+        return plane + base;
+    }
+
+    const uint16_t *src = plane + base;
+    for (uint32_t x = 0; x < n; x++)
+    {
+        scratch[x] = *src;
+        src += step;
+    }
+    return scratch;
+}
+
+/*
+ * Splits rows into bands of at least MIN_BAND_ROWS rows, a multiple of
+ * align, giving every thread about four bands.
+ */
+void
+NvCpuTransform::addBands(std::vector<Task> &tasks, uint32_t channel,
+        uint32_t rows, uint32_t num_threads, uint32_t align)
+{
+    uint32_t band = rows;
+
+    if (num_threads > 1)
+    {
+        band = (rows + 4 * num_threads - 1) / (4 * num_threads);
+        if (band < MIN_BAND_ROWS)
+        {
+            band = MIN_BAND_ROWS;
+        }
+    }
+    band = (band + align - 1) / align * align;
+
+    for (uint32_t begin = 0; begin < rows; begin += band)
+    {
+        Task task;
+        task.channel = channel;
+        task.begin = begin;
+        task.end = (rows - begin > band) ? begin + band : rows;
+        tasks.push_back(task);
+    }
+}
+
+NvCpuTransform::NvCpuTransform(uint32_t num_threads, bool use_vector_kernels)
+{
+    stop = false;
+    generation = 0;
+    num_active = 0;
+    tasks = NULL;
+    pack_phase = false;
+    next_task = 0;
+    num_stages = 0;
+    num_dst_channels = 0;
+    dst_is_rgb = false;
+    convert = false;
+    flip = NvBufSurfTransform_None;
+    is_in_error = false;
+
+    simd = SIMD_NONE;
+#if defined(CPU_TRANSFORM_X86)
+    __builtin_cpu_init();
+    if (use_vector_kernels && __builtin_cpu_supports("avx2"))
+    {
+        simd = SIMD_AVX2;
+    }
+#elif defined(CPU_TRANSFORM_NEON)
+    if (use_vector_kernels)
+    {
+        simd = SIMD_NEON;
+    }
+#endif
+
+    if (num_threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? cpus : 1;
+    }
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&work_cond, NULL);
+    pthread_cond_init(&done_cond, NULL);
+
+    scratch.resize(num_threads);
+
+    /* The calling thread processes tasks too. */
+    workers.resize(num_threads - 1);
+    for (uint32_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].transform = this;
+        workers[i].index = i + 1;
+        if (pthread_create(&workers[i].thread, NULL, workerThread,
+                    &workers[i]) != 0)
+        {
+            CAT_ERROR_MSG("Could not create worker thread " << i);
+            workers.resize(i);
+            is_in_error = true;
+            return;
+        }
+    }
+
+    CAT_DEBUG_MSG(num_threads << " threads, vector kernels: " <<
+            getSimdName());
+}
+
+NvCpuTransform *
+NvCpuTransform::createCpuTransform(uint32_t num_threads,
+        bool use_vector_kernels)
+{
+    NvCpuTransform *transform = new NvCpuTransform(num_threads,
+            use_vector_kernels);
+    if (transform->is_in_error)
+    {
+        delete transform;
+        return NULL;
+    }
+    return transform;
+}
+
+NvCpuTransform::~NvCpuTransform()
+{
+    pthread_mutex_lock(&lock);
+    stop = true;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&lock);
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&done_cond);
+    pthread_cond_destroy(&work_cond);
+    pthread_mutex_destroy(&lock);
+}
+
+const char *
+NvCpuTransform::getSimdName() const
+{
+    switch (simd)
+    {
+        case SIMD_AVX2:
+            return "AVX2";
+        case SIMD_NEON:
+            return "NEON";
+        default:
+            return "none";
+    }
+}
+
+void *
+NvCpuTransform::workerThread(void *arg)
+{
+    Worker *worker = (Worker *) arg;
+    NvCpuTransform *transform = worker->transform;
+    uint32_t seen = 0;
+
+    pthread_mutex_lock(&transform->lock);
+    while (true)
+    {
+        while (!transform->stop && transform->generation == seen)
+        {
+            pthread_cond_wait(&transform->work_cond, &transform->lock);
+        }
+        if (transform->stop)
+        {
+            break;
+        }
+        seen = transform->generation;
+
+        pthread_mutex_unlock(&transform->lock);
+        transform->processTasks(worker->index);
+        pthread_mutex_lock(&transform->lock);
+
+        if (--transform->num_active == 0)
+        {
+            pthread_cond_signal(&transform->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&transform->lock);
+    return NULL;
+}
+
+void
+NvCpuTransform::runTasks(const std::vector<Task> &task_list, bool pack)
+{
+    tasks = &task_list;
+    pack_phase = pack;
+    next_task = 0;
+
+    if (!workers.empty())
+    {
+        pthread_mutex_lock(&lock);
+        num_active = workers.size();
+        generation++;
+        pthread_cond_broadcast(&work_cond);
+        pthread_mutex_unlock(&lock);
+    }
+
+    processTasks(0);
+
+    if (!workers.empty())
+    {
+        pthread_mutex_lock(&lock);
+        while (num_active)
+        {
+            pthread_cond_wait(&done_cond, &lock);
+        }
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+void
+NvCpuTransform::processTasks(uint32_t worker)
+{
+    Scratch &s = scratch[worker];
+
+    while (true)
+    {
+        uint32_t i = __sync_fetch_and_add(&next_task, 1);
+        if (i >= tasks->size())
+        {
+            break;
+        }
+
+        const Task &task = (*tasks)[i];
+        if (!pack_phase)
+        {
+            scaleBand(task, s);
+        }
+        else if (convert)
+        {
+            convertBand(task, s);
+        }
+        else
+        {
+            packBand(task, s);
+        }
+    }
+}
+
+/*
+ * Gets source row @a row of a stage filtered horizontally. The filtered
+ * rows are kept in a ring of as many rows as the vertical filter has taps,
+ * so that each row is filtered once per band.
+ */
+const float *
+NvCpuTransform::getFilteredRow(const Stage &stage, uint32_t row,
+        Scratch &s)
+{
+    uint32_t ring_rows = stage.v_taps ? stage.v_taps : 1;
+    uint32_t slot = row % ring_rows;
+    float *out = &s.rows[(size_t) slot * stage.out_width];
+    float *line = &s.rows[(size_t) ring_rows * stage.out_width];
+
+    if (s.tags[slot] == row)
+    {
+        return out;
+    }
+    s.tags[slot] = row;
+
+    if (!stage.h_taps)
+    {
+        readSamples(stage.src, row, stage.src_x, stage.out_width, &s.samples[0]);
+        u16ToFloat(simd, &s.samples[0], stage.out_width, out);
+    }
+    else
+    {
+        readSamples(stage.src, row, stage.src_x, stage.src_columns,
+                &s.samples[0]);
+        u16ToFloat(simd, &s.samples[0], stage.src_columns, line);
+        filterRowH(simd, line, &stage.h_index[0], &stage.h_weight[0],
+                stage.h_taps, stage.h_stride, stage.out_width, out);
+    }
+    return out;
+}
+
+void
+NvCpuTransform::scaleBand(const Task &task, Scratch &s)
+{
+    const Stage &stage = stages[task.channel];
+    uint32_t ring_rows = stage.v_taps ? stage.v_taps : 1;
+    float *sum = &s.rows[(size_t) ring_rows * stage.out_width +
+        stage.src_columns];
+
+    for (uint32_t i = 0; i < ring_rows; i++)
+    {
+        s.tags[i] = -1;
+    }
+
+    for (uint32_t y = task.begin; y < task.end; y++)
+    {
+        uint16_t *out = stages[task.channel].plane.data() +
+            (size_t) y * stage.out_width;
+
+        if (!stage.src.base || (!stage.h_taps && !stage.v_taps))
+        {
+            readSamples(stage.src, stage.src_y + y, stage.src_x,
+                    stage.out_width, out);
+        }
+        else if (!stage.v_taps)
+        {
+            floatToU16(simd, getFilteredRow(stage, stage.src_y + y, s),
+                    stage.out_width, out);
+        }
+        else
+        {
+            for (uint32_t t = 0; t < stage.v_taps; t++)
+            {
+                size_t k = (size_t) t * stage.out_height + y;
+                s.taps[t] = getFilteredRow(stage,
+                        stage.src_y + stage.v_index[k], s);
+                s.weights[t] = stage.v_weight[k];
+            }
+            filterRowV(simd, &s.taps[0], &s.weights[0], stage.v_taps,
+                    stage.out_width, sum);
+            floatToU16(simd, sum, stage.out_width, out);
+        }
+    }
+}
+
+void
+NvCpuTransform::packBand(const Task &task, Scratch &s)
+{
+    const Stage &stage = stages[task.channel];
+    const Channel &channel = dst_channels[task.channel];
+    uint32_t n = isTransposed(flip) ? stage.out_height : stage.out_width;
+    uint32_t x0 = dst_x;
+    uint32_t y0 = dst_y;
+
+    if (!dst_is_rgb && (task.channel == 1 || task.channel == 2))
+    {
+        x0 >>= dst_shift_x;
+        y0 >>= dst_shift_y;
+    }
+
+    for (uint32_t y = task.begin; y < task.end; y++)
+    {
+        const uint16_t *row = getFlippedRow(flip, stage.plane.data(),
+                stage.out_width, stage.out_height, y, n, &s.samples[0]);
+        writeSamples(channel, y0 + y, x0, n, row);
+    }
+}
+
+void
+NvCpuTransform::convertBand(const Task &task, Scratch &s)
+{
+    uint32_t group_width = 1 << dst_shift_x;
+    uint32_t group_height = 1 << dst_shift_y;
+    uint32_t chroma_width = (dst_width + group_width - 1) >> dst_shift_x;
+    bool chroma = !dst_is_rgb && num_dst_channels == 3;
+    uint32_t num_direct = dst_is_rgb ? 3 : 1;
+    float *c[3] = { &s.rows[0], &s.rows[dst_width], &s.rows[2 * dst_width] };
+    float *sum_u = &s.rows[3 * dst_width];
+    float *sum_v = sum_u + chroma_width;
+    uint16_t *samples = &s.samples[0];
+
+    for (uint32_t y = task.begin; y < task.end; y += group_height)
+    {
+        uint32_t rows = (dst_height - y < group_height) ? dst_height - y :
+            group_height;
+
+        if (chroma)
+        {
+            memset(sum_u, 0, 2 * chroma_width * sizeof(float));
+        }
+
+        for (uint32_t r = 0; r < rows; r++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint16_t *row = getFlippedRow(flip,
+                        stages[k].plane.data(), stages[k].out_width,
+                        stages[k].out_height, y + r, dst_width, samples);
+                u16ToFloat(simd, row, dst_width, c[k]);
+            }
+            applyMatrix(simd, c[0], c[1], c[2], dst_width, matrix);
+
+            for (uint32_t k = 0; k < num_direct; k++)
+            {
+                floatToU16(simd, c[k], dst_width, samples);
+                writeSamples(dst_channels[k], dst_y + y + r, dst_x, dst_width,
+                        samples);
+            }
+            if (num_dst_channels == 4)
+            {
+                for (uint32_t x = 0; x < dst_width; x++)
+                {
+                    samples[x] = 0xFFFF;
+                }
+                writeSamples(dst_channels[3], dst_y + y + r, dst_x, dst_width,
+                        samples);
+            }
+            if (chroma)
+            {
+                for (uint32_t x = 0; x < dst_width; x++)
+                {
+                    sum_u[x >> dst_shift_x] += c[1][x];
+                    sum_v[x >> dst_shift_x] += c[2][x];
+                }
+            }
+        }
+
+        if (chroma)
+        {
+            /* Average the chroma of each group of pixels, the last groups
+             * of a row or column can be partial. */
+            for (uint32_t x = 0; x < chroma_width; x++)
+            {
+                uint32_t columns = dst_width - x * group_width;
+                if (columns > group_width)
+                {
+                    columns = group_width;
+                }
+                float scale = 1.0f / (columns * rows);
+                sum_u[x] *= scale;
+                sum_v[x] *= scale;
+            }
+            floatToU16(simd, sum_u, chroma_width, samples);
+            writeSamples(dst_channels[1], (dst_y + y) >> dst_shift_y,
+                    dst_x >> dst_shift_x, chroma_width, samples);
+            floatToU16(simd, sum_v, chroma_width, samples);
+            writeSamples(dst_channels[2], (dst_y + y) >> dst_shift_y,
+                    dst_x >> dst_shift_x, chroma_width, samples);
+        }
+    }
+}
+
+bool
+NvCpuTransform::isValidSurface(const FormatDesc *desc,
+        const NvCpuSurface *surface)
+{
+    if (!surface->width || !surface->height)
+    {
+        CAT_ERROR_MSG("Empty surface");
+        return false;
+    }
+    if (surface->planeParams.num_planes != desc->num_planes)
+    {
+        CAT_ERROR_MSG("Surface has " << surface->planeParams.num_planes <<
+                " planes, its color format has " << (int) desc->num_planes);
+        return false;
+    }
+    for (uint32_t p = 0; p < desc->num_planes; p++)
+    {
+        if (!surface->addr[p])
+        {
+            CAT_ERROR_MSG("Plane " << p << " of surface is not mapped");
+            return false;
+        }
+    }
+    if (isPacked422(desc) && (surface->width & 1))
+    {
+        CAT_ERROR_MSG("Packed 4:2:2 surface has odd width " << surface->width);
+        return false;
+    }
+    return true;
+}
+
+int
+NvCpuTransform::NvTransform(NvBufSurf::NvCommonTransformParams *transform_params,
+        const NvCpuSurface *src, NvCpuSurface *dst)
+{
+    NvTraceScope trace("NvTransform", "NvCpuTransform");
+    const FormatDesc *src_desc;
+    const FormatDesc *dst_desc;
+    uint32_t src_left = 0;
+    uint32_t src_top = 0;
+    uint32_t src_width;
+    uint32_t src_height;
+    NvBufSurfTransform_Inter filter = NvBufSurfTransformInter_Default;
+    int method;
+    bool transposed;
+    size_t num_floats = 0;
+    size_t num_samples = 0;
+    size_t num_taps = 1;
+
+    if (!transform_params || !src || !dst)
+    {
+        return -1;
+    }
+
+    src_desc = getFormatDesc(src->colorFormat);
+    dst_desc = getFormatDesc(dst->colorFormat);
+    if (!src_desc || !dst_desc)
+    {
+        CAT_ERROR_MSG("Unsupported color format " <<
+                (src_desc ? dst->colorFormat : src->colorFormat));
+        return -1;
+    }
+    if (!isValidSurface(src_desc, src) || !isValidSurface(dst_desc, dst))
+    {
+        return -1;
+    }
+
+    src_width = src->width;
+    src_height = src->height;
+    if (transform_params->flag & NVBUFSURF_TRANSFORM_CROP_SRC)
+    {
+        src_left = transform_params->src_left;
+        src_top = transform_params->src_top;
+        src_width = transform_params->src_width;
+        src_height = transform_params->src_height;
+    }
+    if (!src_width || !src_height ||
+            (uint64_t) src_left + src_width > src->width ||
+            (uint64_t) src_top + src_height > src->height)
+    {
+        CAT_ERROR_MSG("Source rectangle is out of the surface");
+        return -1;
+    }
+
+    dst_x = 0;
+    dst_y = 0;
+    dst_width = dst->width;
+    dst_height = dst->height;
+    if (transform_params->flag & NVBUFSURF_TRANSFORM_CROP_DST)
+    {
+        dst_x = transform_params->dst_left;
+        dst_y = transform_params->dst_top;
+        dst_width = transform_params->dst_width;
+        dst_height = transform_params->dst_height;
+    }
+    if (!dst_width || !dst_height ||
+            (uint64_t) dst_x + dst_width > dst->width ||
+            (uint64_t) dst_y + dst_height > dst->height)
+    {
+        CAT_ERROR_MSG("Destination rectangle is out of the surface");
+        return -1;
+    }
+
+    dst_is_rgb = dst_desc->is_rgb;
+    dst_shift_x = dst_desc->shift_x;
+    dst_shift_y = dst_desc->shift_y;
+    if ((dst_x & ((1 << dst_shift_x) - 1)) ||
+            (dst_y & ((1 << dst_shift_y) - 1)))
+    {
+        CAT_ERROR_MSG("Destination rectangle is not aligned to the chroma "
+                "subsampling");
+        return -1;
+    }
+
+    if (transform_params->flag & NVBUFSURF_TRANSFORM_FILTER)
+    {
+        filter = transform_params->filter;
+    }
+    switch (filter)
+    {
+        case NvBufSurfTransformInter_Nearest:
+        case NvBufSurfTransformInter_Default:
+            method = FILTER_NEAREST;
+            break;
+        case NvBufSurfTransformInter_Bilinear:
+            method = FILTER_BILINEAR;
+            break;
+        default:
+            method = FILTER_BICUBIC;
+            break;
+    }
+
+    flip = NvBufSurfTransform_None;
+    if (transform_params->flag & NVBUFSURF_TRANSFORM_FLIP)
+    {
+        flip = transform_params->flip;
+    }
+    if (flip < NvBufSurfTransform_None || flip > NvBufSurfTransform_InvTranspose)
+    {
+        CAT_ERROR_MSG("Unsupported flip method " << flip);
+        return -1;
+    }
+    transposed = isTransposed(flip);
+
+    /* Channels are scaled as they are when the color space is the same,
+     * otherwise they are all brought to the destination size and go
+     * through RGB. */
+    convert = src_desc->is_rgb != dst_desc->is_rgb ||
+        (!src_desc->is_rgb && (src_desc->matrix != dst_desc->matrix ||
+                               src_desc->full_range != dst_desc->full_range));
+    if (convert)
+    {
+        double to_rgb[12];
+        double to_dst_rgb[12];
+        double from_rgb[12];
+
+        getToRgbMatrix(src_desc, to_rgb);
+        getToRgbMatrix(dst_desc, to_dst_rgb);
+        invertMatrix(to_dst_rgb, from_rgb);
+        for (int k = 0; k < 3; k++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                double v = (j == 3) ? from_rgb[4 * k + 3] : 0.0;
+                for (int i = 0; i < 3; i++)
+                {
+                    v += from_rgb[4 * k + i] * to_rgb[4 * i + j];
+                }
+                matrix[4 * k + j] = v;
+            }
+        }
+    }
+
+    num_dst_channels = dst_desc->num_channels;
+    for (uint32_t c = 0; c < num_dst_channels; c++)
+    {
+        getChannel(dst_desc, dst, c, true, &dst_channels[c]);
+    }
+
+    scale_tasks.clear();
+    pack_tasks.clear();
+    num_stages = convert ? 3 : num_dst_channels;
+    for (uint32_t c = 0; c < num_stages; c++)
+    {
+        Stage &stage = stages[c];
+        double sub_x = isChroma(src_desc, c) ? 1 << src_desc->shift_x : 1;
+        double sub_y = isChroma(src_desc, c) ? 1 << src_desc->shift_y : 1;
+        uint32_t width = dst_width;
+        uint32_t height = dst_height;
+        double src_columns = src_width;
+        double src_rows = src_height;
+
+        getChannel(src_desc, src, c, false, &stage.src);
+
+        if (!convert && isChroma(dst_desc, c))
+        {
+            width = ((dst_x + dst_width + (1 << dst_shift_x) - 1) >>
+                    dst_shift_x) - (dst_x >> dst_shift_x);
+            height = ((dst_y + dst_height + (1 << dst_shift_y) - 1) >>
+                    dst_shift_y) - (dst_y >> dst_shift_y);
+            /* The last chroma sample of an odd sized rectangle also covers
+             * the luma column or row past its end, stretch the source
+             * rectangle alike so that same size copies stay exact. */
+            if (transposed)
+            {
+                src_columns = (double) src_width * (height << dst_shift_y) /
+                    dst_height;
+                src_rows = (double) src_height * (width << dst_shift_x) /
+                    dst_width;
+            }
+            else
+            {
+                src_columns = (double) src_width * (width << dst_shift_x) /
+                    dst_width;
+                src_rows = (double) src_height * (height << dst_shift_y) /
+                    dst_height;
+            }
+        }
+        stage.out_width = transposed ? height : width;
+        stage.out_height = transposed ? width : height;
+        stage.h_stride = (stage.out_width + 7) & ~7;
+
+        if (stage.src.base)
+        {
+            stage.h_taps = buildFilter(method, stage.src.width,
+                    src_left / sub_x, src_columns / sub_x,
+                    stage.out_width,
+                    stage.h_stride, stage.h_index, stage.h_weight,
+                    stage.src_x, stage.src_columns);
+            stage.v_taps = buildFilter(method, stage.src.height,
+                    src_top / sub_y, src_rows / sub_y,
+                    stage.out_height,
+                    stage.out_height, stage.v_index, stage.v_weight,
+                    stage.src_y, stage.src_rows);
+        }
+        else
+        {
+            stage.h_taps = 0;
+            stage.v_taps = 0;
+            stage.src_x = 0;
+            stage.src_y = 0;
+            stage.src_columns = stage.out_width;
+            stage.src_rows = stage.out_height;
+        }
+        stage.plane.resize((size_t) stage.out_width * stage.out_height);
+
+        addBands(scale_tasks, c, stage.out_height, getNumThreads(), 1);
+
+        size_t ring_rows = stage.v_taps ? stage.v_taps : 1;
+        num_floats = std::max(num_floats, (ring_rows + 1) * stage.out_width +
+                stage.src_columns);
+        num_samples = std::max(num_samples, (size_t) std::max(
+                    stage.src_columns, std::max(stage.out_width,
+                        stage.out_height)));
+        num_taps = std::max(num_taps, ring_rows);
+    }
+
+    if (convert)
+    {
+        addBands(pack_tasks, 0, dst_height, getNumThreads(), 1 << dst_shift_y);
+        num_floats = std::max(num_floats, (size_t) 5 * dst_width);
+        num_samples = std::max(num_samples, (size_t) dst_width);
+    }
+    else
+    {
+        for (uint32_t c = 0; c < num_stages; c++)
+        {
+            addBands(pack_tasks, c, transposed ? stages[c].out_width :
+                    stages[c].out_height, getNumThreads(), 1);
+        }
+    }
+
+    for (size_t i = 0; i < scratch.size(); i++)
+    {
+        Scratch &s = scratch[i];
+        if (s.rows.size() < num_floats)
+        {
+            s.rows.resize(num_floats);
+        }
+        if (s.samples.size() < num_samples)
+        {
+            s.samples.resize(num_samples);
+        }
+        if (s.tags.size() < num_taps)
+        {
+            s.tags.resize(num_taps);
+            s.taps.resize(num_taps);
+            s.weights.resize(num_taps);
+        }
+    }
+
+    runTasks(scale_tasks, false);
+    runTasks(pack_tasks, true);
+    return 0;
+}
+
+/*
+ * Maps all the planes of the buffer @a fd for CPU access.
+ */
+static int
+mapSurface(int fd, NvBufSurfaceMemMapFlags flags, NvBufSurface **nvbuf_surf,
+        NvCpuTransform::NvCpuSurface *surface)
+{
+    NvBufSurfaceParams *params;
+
+    if (NvBufSurfaceFromFd(fd, (void **) nvbuf_surf) != 0)
+    {
+        CAT_ERROR_MSG("Could not get the surface of fd " << fd);
+        return -1;
+    }
+    params = &(*nvbuf_surf)->surfaceList[0];
+    if (params->layout != NVBUF_LAYOUT_PITCH)
+    {
+        CAT_ERROR_MSG("Surface of fd " << fd << " is not pitch-linear");
+        return -1;
+    }
+    if (NvBufSurfaceMap(*nvbuf_surf, 0, -1, flags) != 0)
+    {
+        CAT_ERROR_MSG("Could not map the surface of fd " << fd);
+        return -1;
+    }
+    NvBufSurfaceSyncForCpu(*nvbuf_surf, 0, -1);
+
+    memset(surface, 0, sizeof(NvCpuTransform::NvCpuSurface));
+    surface->colorFormat = params->colorFormat;
+    surface->width = params->width;
+    surface->height = params->height;
+    surface->planeParams = params->planeParams;
+    for (uint32_t p = 0; p < params->planeParams.num_planes &&
+            p < NVBUF_MAX_PLANES; p++)
+    {
+        surface->addr[p] = (uint8_t *) params->mappedAddr.addr[p];
+    }
+    return 0;
+}
+
+int
+NvCpuTransform::NvTransform(NvBufSurf::NvCommonTransformParams *transform_params,
+        int src_fd, int dst_fd)
+{
+    NvBufSurface *nvbuf_surf_src = NULL;
+    NvBufSurface *nvbuf_surf_dst = NULL;
+    NvCpuSurface src;
+    NvCpuSurface dst;
+    int ret = -1;
+
+    if (mapSurface(src_fd, NVBUF_MAP_READ, &nvbuf_surf_src, &src) < 0)
+    {
+        return -1;
+    }
+
+    /* Pixels outside of the destination rectangle are kept. */
+    if (mapSurface(dst_fd, NVBUF_MAP_READ_WRITE, &nvbuf_surf_dst, &dst) == 0)
+    {
+        ret = NvTransform(transform_params, &src, &dst);
+        NvBufSurfaceSyncForDevice(nvbuf_surf_dst, 0, -1);
+        NvBufSurfaceUnMap(nvbuf_surf_dst, 0, -1);
+    }
+    NvBufSurfaceUnMap(nvbuf_surf_src, 0, -1);
+    return ret;
+}
+
+bool
+NvCpuTransform::isFormatSupported(NvBufSurfaceColorFormat format)
+{
+    return getFormatDesc(format) != NULL;
+}
+
+int
+NvCpuTransform::NvAllocate(uint32_t width, uint32_t height,
+        NvBufSurfaceColorFormat format, NvCpuSurface *surface)
+{
+    const FormatDesc *desc = getFormatDesc(format);
+    size_t size = 0;
+    void *data;
+
+    if (!surface)
+    {
+        return -1;
+    }
+    memset(surface, 0, sizeof(NvCpuSurface));
+
+    if (!desc)
+    {
+        CAT_ERROR_MSG("Unsupported color format " << format);
+        return -1;
+    }
+    if (!width || !height || (isPacked422(desc) && (width & 1)))
+    {
+        CAT_ERROR_MSG("Invalid size " << width << "x" << height <<
+                " for color format " << format);
+        return -1;
+    }
+
+    NvBufSurfacePlaneParams &params = surface->planeParams;
+    params.num_planes = desc->num_planes;
+    for (uint32_t p = 0; p < desc->num_planes; p++)
+    {
+        params.width[p] = width;
+        params.height[p] = height;
+        if (p > 0)
+        {
+            params.width[p] = (width + (1 << desc->shift_x) - 1) >>
+                desc->shift_x;
+            params.height[p] = (height + (1 << desc->shift_y) - 1) >>
+                desc->shift_y;
+        }
+        params.bytesPerPix[p] = desc->bytes_per_pix[p];
+        params.pitch[p] = (params.width[p] * params.bytesPerPix[p] +
+                PLANE_ALIGNMENT - 1) & ~(PLANE_ALIGNMENT - 1);
+        params.offset[p] = size;
+        params.psize[p] = params.pitch[p] * params.height[p];
+        size += params.psize[p];
+    }
+
+    if (posix_memalign(&data, PLANE_ALIGNMENT, size) != 0)
+    {
+        CAT_ERROR_MSG("Could not allocate " << size << " bytes");
+        return -1;
+    }
+
+    surface->colorFormat = format;
+    surface->width = width;
+    surface->height = height;
+    for (uint32_t p = 0; p < desc->num_planes; p++)
+    {
+        surface->addr[p] = (uint8_t *) data + params.offset[p];
+    }
+    return 0;
+}
+
+void
+NvCpuTransform::NvDestroy(NvCpuSurface *surface)
+{
+    if (surface)
+    {
+        free(surface->addr[0]);
+        memset(surface, 0, sizeof(NvCpuSurface));
+    }
+}
+
+int
+NvCpuTransform::NvAccumulateError(const NvCpuSurface *frame,
+        const NvCpuSurface *ref, NvCpuErrorStats *stats)
+{
+    const FormatDesc *desc = getFormatDesc(frame->colorFormat);
+
+    if (!desc || frame->colorFormat != ref->colorFormat ||
+            frame->width != ref->width || frame->height != ref->height ||
+            frame->planeParams.num_planes != desc->num_planes ||
+            ref->planeParams.num_planes != desc->num_planes)
+    {
+        CAT_ERROR_MSG("Frames differ in color format or size");
+        return -1;
+    }
+
+    stats->num_planes = desc->num_planes;
+    for (uint32_t p = 0; p < desc->num_planes; p++)
+    {
+        uint32_t row_bytes = frame->planeParams.width[p] *
+            frame->planeParams.bytesPerPix[p];
+
+        stats->peak[p] = (1 << desc->depth) - 1;
+        for (uint32_t y = 0; y < frame->planeParams.height[p]; y++)
+        {
+            const uint8_t *a = frame->addr[p] +
+                (size_t) y * frame->planeParams.pitch[p];
+            const uint8_t *b = ref->addr[p] +
+                (size_t) y * ref->planeParams.pitch[p];
+            uint64_t sse = 0;
+
+            if (desc->depth == 8)
+            {
+                for (uint32_t x = 0; x < row_bytes; x++)
+                {
+                    int d = a[x] - b[x];
+                    sse += d * d;
+                }
+                stats->count[p] += row_bytes;
+            }
+            else
+            {
+                const uint16_t *a16 = (const uint16_t *) a;
+                const uint16_t *b16 = (const uint16_t *) b;
+                uint32_t shift = 16 - desc->depth;
+
+                for (uint32_t x = 0; x < row_bytes / 2; x++)
+                {
+                    int d = (a16[x] >> shift) - (b16[x] >> shift);
+                    sse += d * d;
+                }
+                stats->count[p] += row_bytes / 2;
+            }
+            stats->sse[p] += sse;
+        }
+    }
+    return 0;
+}
+
+double
+NvCpuTransform::getPsnr(const NvCpuErrorStats *stats, uint32_t plane)
+{
+    if (plane >= stats->num_planes || !stats->count[plane])
+    {
+        return 0.0;
+    }
+
+    double mse = stats->sse[plane] / stats->count[plane];
+    if (mse == 0.0)
+    {
+        return HUGE_VAL;
+    }
+    return 10.0 * log10((double) stats->peak[plane] * stats->peak[plane] / mse);
+}
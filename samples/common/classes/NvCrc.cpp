@@ -0,0 +1,509 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvCrc.h"
+#include "NvLogging.h"
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define CAT_NAME "Crc"
+
+/* Bytes of input the folding engine needs at least, in 16-byte blocks. */
+#define FOLD_MIN_SIZE 64
+
+static uint32_t
+crc_bytewise(const uint32_t (*tables)[256], uint32_t crc,
+        const unsigned char *p, size_t size)
+{
+    while (size--)
+    {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+/* The slicing engines load the data as little-endian words, as stored on
+ * the ARM and x86 CPUs the samples run on.
+ */
+static uint32_t
+crc_slice_by_8(const uint32_t (*tables)[256], uint32_t crc,
+        const unsigned char *p, size_t size)
+{
+    while (size >= 8)
+    {
+        uint32_t w[2];
+
+        memcpy(w, p, sizeof(w));
+        w[0] ^= crc;
+        crc = tables[7][w[0] & 0xFF] ^ tables[6][(w[0] >> 8) & 0xFF] ^
+            tables[5][(w[0] >> 16) & 0xFF] ^ tables[4][w[0] >> 24] ^
+            tables[3][w[1] & 0xFF] ^ tables[2][(w[1] >> 8) & 0xFF] ^
+            tables[1][(w[1] >> 16) & 0xFF] ^ tables[0][w[1] >> 24];
+        p += 8;
+        size -= 8;
+    }
+    return crc_bytewise(tables, crc, p, size);
+}
+
+static uint32_t
+crc_slice_by_16(const uint32_t (*tables)[256], uint32_t crc,
+        const unsigned char *p, size_t size)
+{
+    while (size >= 16)
+    {
+        uint32_t w[4];
+
+        memcpy(w, p, sizeof(w));
+        w[0] ^= crc;
+        crc = tables[15][w[0] & 0xFF] ^ tables[14][(w[0] >> 8) & 0xFF] ^
+            tables[13][(w[0] >> 16) & 0xFF] ^ tables[12][w[0] >> 24] ^
+            tables[11][w[1] & 0xFF] ^ tables[10][(w[1] >> 8) & 0xFF] ^
+            tables[9][(w[1] >> 16) & 0xFF] ^ tables[8][w[1] >> 24] ^
+            tables[7][w[2] & 0xFF] ^ tables[6][(w[2] >> 8) & 0xFF] ^
+            tables[5][(w[2] >> 16) & 0xFF] ^ tables[4][w[2] >> 24] ^
+            tables[3][w[3] & 0xFF] ^ tables[2][(w[3] >> 8) & 0xFF] ^
+            tables[1][(w[3] >> 16) & 0xFF] ^ tables[0][w[3] >> 24];
+        p += 16;
+        size -= 16;
+    }
+    return crc_bytewise(tables, crc, p, size);
+}
+
+#if defined(__aarch64__)
+static bool
+cpu_has_engine(NvCrc::Engine engine)
+{
+    unsigned long hwcap = getauxval(AT_HWCAP);
+
+    if (engine == NvCrc::ENGINE_ARMV8_CRC32)
+        return (hwcap & HWCAP_CRC32) != 0;
+    if (engine == NvCrc::ENGINE_ARMV8_PMULL)
+        return (hwcap & HWCAP_CRC32) && (hwcap & HWCAP_PMULL);
+    return false;
+}
+
+__attribute__((target("arch=armv8-a+crc")))
+static uint32_t
+crc_armv8(uint32_t crc, const unsigned char *p, size_t size)
+{
+    while (size && ((uintptr_t) p & 7))
+    {
+        crc = __crc32b(crc, *p++);
+        size--;
+    }
+    while (size >= 32)
+    {
+        uint64_t w[4];
+
+        memcpy(w, p, sizeof(w));
+        crc = __crc32d(crc, w[0]);
+        crc = __crc32d(crc, w[1]);
+        crc = __crc32d(crc, w[2]);
+        crc = __crc32d(crc, w[3]);
+        p += 32;
+        size -= 32;
+    }
+    while (size >= 8)
+    {
+        uint64_t w;
+
+        memcpy(&w, p, sizeof(w));
+        crc = __crc32d(crc, w);
+        p += 8;
+        size -= 8;
+    }
+    while (size--)
+    {
+        crc = __crc32b(crc, *p++);
+    }
+    return crc;
+}
+
+__attribute__((target("arch=armv8-a+crc+crypto")))
+static inline uint64x2_t
+clmul_lo(uint64x2_t a, uint64x2_t b)
+{
+    return vreinterpretq_u64_p128(vmull_p64(vgetq_lane_u64(a, 0),
+                vgetq_lane_u64(b, 0)));
+}
+
+__attribute__((target("arch=armv8-a+crc+crypto")))
+static inline uint64x2_t
+clmul_hi(uint64x2_t a, uint64x2_t b)
+{
+    return vreinterpretq_u64_p128(vmull_high_p64(vreinterpretq_p64_u64(a),
+                vreinterpretq_p64_u64(b)));
+}
+
+/* Same folding as crc_pclmul(), with PMULL. The 128-bit remainder is the
+ * CRC, from 0, of its 16 bytes, which the CRC32 instructions then reduce.
+ * @a size must be a multiple of 16, at least FOLD_MIN_SIZE.
+ */
+__attribute__((target("arch=armv8-a+crc+crypto")))
+static uint32_t
+crc_armv8_pmull(uint32_t crc, const unsigned char *p, size_t size)
+{
+    static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    uint64x2_t x0, x1, x2, x3, x4;
+
+    x1 = vld1q_u64((const uint64_t *) (p + 0x00));
+    x2 = vld1q_u64((const uint64_t *) (p + 0x10));
+    x3 = vld1q_u64((const uint64_t *) (p + 0x20));
+    x4 = vld1q_u64((const uint64_t *) (p + 0x30));
+    x1 = veorq_u64(x1, vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+    x0 = vld1q_u64(k1k2);
+    p += 64;
+    size -= 64;
+
+    /* Fold four lanes of 128 bits in parallel. */
+    while (size >= 64)
+    {
+        x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), clmul_lo(x1, x0)),
+                vld1q_u64((const uint64_t *) (p + 0x00)));
+        x2 = veorq_u64(veorq_u64(clmul_hi(x2, x0), clmul_lo(x2, x0)),
+                vld1q_u64((const uint64_t *) (p + 0x10)));
+        x3 = veorq_u64(veorq_u64(clmul_hi(x3, x0), clmul_lo(x3, x0)),
+                vld1q_u64((const uint64_t *) (p + 0x20)));
+        x4 = veorq_u64(veorq_u64(clmul_hi(x4, x0), clmul_lo(x4, x0)),
+                vld1q_u64((const uint64_t *) (p + 0x30)));
+        p += 64;
+        size -= 64;
+    }
+
+    /* Fold the four lanes into one. */
+    x0 = vld1q_u64(k3k4);
+    x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), clmul_lo(x1, x0)), x2);
+    x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), clmul_lo(x1, x0)), x3);
+    x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), clmul_lo(x1, x0)), x4);
+
+    /* Fold the remaining 16-byte blocks. */
+    while (size >= 16)
+    {
+        x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), clmul_lo(x1, x0)),
+                vld1q_u64((const uint64_t *) p));
+        p += 16;
+        size -= 16;
+    }
+
+    crc = __crc32d(0, vgetq_lane_u64(x1, 0));
+    return __crc32d(crc, vgetq_lane_u64(x1, 1));
+}
+#elif defined(__x86_64__) || defined(__i386__)
+static bool
+cpu_has_engine(NvCrc::Engine engine)
+{
+    if (engine == NvCrc::ENGINE_X86_PCLMUL)
+        return __builtin_cpu_supports("pclmul") &&
+            __builtin_cpu_supports("sse4.1");
+    return false;
+}
+
+/* Folds 64 bytes at a time with carry-less multiplies, then reduces the
+ * 128-bit remainder with a Barrett reduction. The constants are powers of x
+ * modulo the bit-reflected CRC-32 polynomial, from Intel's "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+ * @a size must be a multiple of 16, at least FOLD_MIN_SIZE.
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t
+crc_pclmul(uint32_t crc, const unsigned char *p, size_t size)
+{
+    static const uint64_t __attribute__((aligned(16))) k1k2[] =
+        { 0x0154442bd4, 0x01c6e41596 };
+    static const uint64_t __attribute__((aligned(16))) k3k4[] =
+        { 0x01751997d0, 0x00ccaa009e };
+    static const uint64_t __attribute__((aligned(16))) k5k0[] =
+        { 0x0163cd6124, 0x0000000000 };
+    static const uint64_t __attribute__((aligned(16))) poly[] =
+        { 0x01db710641, 0x01f7011641 };
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((const __m128i *) (p + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *) (p + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *) (p + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *) (p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    x0 = _mm_load_si128((const __m128i *) k1k2);
+    p += 64;
+    size -= 64;
+
+    /* Fold four lanes of 128 bits in parallel. */
+    while (size >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                _mm_loadu_si128((const __m128i *) (p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                _mm_loadu_si128((const __m128i *) (p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                _mm_loadu_si128((const __m128i *) (p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                _mm_loadu_si128((const __m128i *) (p + 0x30)));
+        p += 64;
+        size -= 64;
+    }
+
+    /* Fold the four lanes into one. */
+    x0 = _mm_load_si128((const __m128i *) k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* Fold the remaining 16-byte blocks. */
+    while (size >= 16)
+    {
+        x2 = _mm_loadu_si128((const __m128i *) p);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        p += 16;
+        size -= 16;
+    }
+
+    /* Fold 128 bits to 64 bits. */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i *) k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits. */
+    x0 = _mm_load_si128((const __m128i *) poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return _mm_extract_epi32(x1, 1);
+}
+#else
+static bool
+cpu_has_engine(NvCrc::Engine engine)
+{
+    return false;
+}
+#endif
+
+NvCrc::NvCrc(uint32_t polynomial, Engine engine)
+{
+    this->polynomial = polynomial;
+    this->engine = engine;
+    value = 0;
+    tables = new uint32_t[16][256];
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+
+        for (uint32_t j = 0; j < 8; j++)
+        {
+            crc = crc & 1 ? (crc >> 1) ^ polynomial : crc >> 1;
+        }
+        tables[0][i] = crc;
+    }
+    /* tables[n][i] is the CRC of byte i followed by n zero bytes. */
+    for (uint32_t n = 1; n < 16; n++)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            tables[n][i] = (tables[n - 1][i] >> 8) ^
+                tables[0][tables[n - 1][i] & 0xFF];
+        }
+    }
+
+    /* x^1, then each entry squares the previous one. */
+    x2n_table[0] = 1U << 30;
+    for (uint32_t n = 1; n < 32; n++)
+    {
+        x2n_table[n] = multiplyModulo(x2n_table[n - 1], x2n_table[n - 1]);
+    }
+}
+
+NvCrc *
+NvCrc::createCrc(uint32_t polynomial, Engine engine)
+{
+    bool hardware = engine == ENGINE_ARMV8_CRC32 ||
+        engine == ENGINE_ARMV8_PMULL || engine == ENGINE_X86_PCLMUL;
+
+    if (engine == ENGINE_AUTO)
+    {
+        engine = ENGINE_SLICE_BY_16;
+        if (polynomial == NV_CRC32_POLYNOMIAL)
+        {
+            if (cpu_has_engine(ENGINE_ARMV8_PMULL))
+                engine = ENGINE_ARMV8_PMULL;
+            else if (cpu_has_engine(ENGINE_ARMV8_CRC32))
+                engine = ENGINE_ARMV8_CRC32;
+            else if (cpu_has_engine(ENGINE_X86_PCLMUL))
+                engine = ENGINE_X86_PCLMUL;
+        }
+    }
+    else if (hardware && (polynomial != NV_CRC32_POLYNOMIAL ||
+                !cpu_has_engine(engine)))
+    {
+        CAT_ERROR_MSG(getEngineName(engine) << " is not supported by the CPU "
+                "or for polynomial 0x" << std::hex << polynomial << std::dec);
+        return NULL;
+    }
+
+    CAT_DEBUG_MSG("Using " << getEngineName(engine) << " engine");
+    return new NvCrc(polynomial, engine);
+}
+
+NvCrc::~NvCrc()
+{
+    delete[] tables;
+}
+
+const char *
+NvCrc::getEngineName(Engine engine)
+{
+    switch (engine)
+    {
+        case ENGINE_AUTO:           return "auto";
+        case ENGINE_BYTEWISE:       return "bytewise";
+        case ENGINE_SLICE_BY_8:     return "slice-by-8";
+        case ENGINE_SLICE_BY_16:    return "slice-by-16";
+        case ENGINE_ARMV8_CRC32:    return "armv8-crc32";
+        case ENGINE_ARMV8_PMULL:    return "armv8-pmull";
+        case ENGINE_X86_PCLMUL:     return "x86-pclmul";
+    }
+    return "";
+}
+
+uint32_t
+NvCrc::calculate(uint32_t crc, const void *data, size_t size) const
+{
+    const unsigned char *p = (const unsigned char *) data;
+
+    switch (engine)
+    {
+        case ENGINE_BYTEWISE:
+            return crc_bytewise(tables, crc, p, size);
+        case ENGINE_SLICE_BY_8:
+            return crc_slice_by_8(tables, crc, p, size);
+#if defined(__aarch64__)
+        case ENGINE_ARMV8_CRC32:
+            return crc_armv8(crc, p, size);
+        case ENGINE_ARMV8_PMULL:
+            if (size >= FOLD_MIN_SIZE)
+            {
+                size_t folded = size & ~(size_t) 15;
+
+                crc = crc_armv8_pmull(crc, p, folded);
+                p += folded;
+                size -= folded;
+            }
+            return crc_armv8(crc, p, size);
+#elif defined(__x86_64__) || defined(__i386__)
+        case ENGINE_X86_PCLMUL:
+            if (size >= FOLD_MIN_SIZE)
+            {
+                size_t folded = size & ~(size_t) 15;
+
+                crc = crc_pclmul(crc, p, folded);
+                p += folded;
+                size -= folded;
+            }
+            return crc_slice_by_16(tables, crc, p, size);
+#endif
+        default:
+            return crc_slice_by_16(tables, crc, p, size);
+    }
+}
+
+uint32_t
+NvCrc::multiplyModulo(uint32_t a, uint32_t b) const
+{
+    /* Reflected representation: bit 31 holds x^0. */
+    uint32_t m = 1U << 31;
+    uint32_t p = 0;
+
+    while (m)
+    {
+        if (a & m)
+        {
+            p ^= b;
+            if ((a & (m - 1)) == 0)
+                break;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ polynomial : b >> 1;
+    }
+    return p;
+}
+
+uint32_t
+NvCrc::combine(uint32_t crc1, uint32_t crc2, uint64_t size2) const
+{
+    /* Shift crc1 over size2 zero bytes, that is multiply it by
+     * x^(8 * size2), then add the CRC of the second chunk.
+     */
+    uint32_t shift = 1U << 31;
+    uint32_t n = 3;
+
+    while (size2)
+    {
+        if (size2 & 1)
+            shift = multiplyModulo(x2n_table[n & 31], shift);
+        size2 >>= 1;
+        n++;
+    }
+    return multiplyModulo(shift, crc1) ^ crc2;
+}
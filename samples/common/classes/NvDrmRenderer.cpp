@@ -9,6 +9,7 @@
 
 #include "NvDrmRenderer.h"
 #include "NvLogging.h"
+#include "NvTracer.h"
 #include "nvbufsurface.h"
 
 #include <sys/time.h>
@@ -671,6 +672,7 @@ NvDrmRenderer::enqueBuffer(int fd)
 {
   int ret = -1;
   int tmpFd;
+  NvTraceScope trace("enqueBuffer", comp_name);
 
   if (is_in_error)
     return ret;
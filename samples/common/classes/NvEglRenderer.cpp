@@ -28,6 +28,7 @@
 
 #include "NvEglRenderer.h"
 #include "NvLogging.h"
+#include "NvTracer.h"
 #include "nvbufsurface.h"
 
 #include <cstring>
@@ -360,6 +361,8 @@ NvEglRenderer::~NvEglRenderer()
 int
 NvEglRenderer::render(int fd)
 {
+    NvTraceScope trace("render", comp_name);
+
     this->render_fd = fd;
     pthread_mutex_lock(&render_lock);
     pthread_cond_broadcast(&render_cond);
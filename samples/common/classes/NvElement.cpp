@@ -27,6 +27,7 @@
  */
 
 #include "NvElement.h"
+#include "NvMetricsRegistry.h"
 
 void NvElement::getProfilingData(NvElementProfiler::NvElementProfilerData &data)
 {
@@ -57,4 +58,11 @@ NvElement::NvElement(const char *name, NvElementProfiler::ProfilerField fields)
     if (!name)
         is_in_error = 1;
     this->comp_name = name;
+    metrics_id = NvMetricsRegistry::getInstance().registerElement(name,
+            &profiler);
+}
+
+NvElement::~NvElement()
+{
+    NvMetricsRegistry::getInstance().unregisterElement(metrics_id);
 }
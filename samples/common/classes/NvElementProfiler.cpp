@@ -28,8 +28,9 @@
 
 #include <iostream>
 #include <string.h>
-#include <map>
 #include <stdint.h>
+#include <math.h>
+#include <time.h>
 #include "NvElementProfiler.h"
 
 #define LOCK() pthread_mutex_lock(&profiler_lock)
@@ -41,14 +42,189 @@
         return; \
     }
 
-#define GET_TIME(timeval) gettimeofday(timeval, NULL);
+/** Set in the ID of an in-flight unit once it has been finished. */
+#define UNIT_CLAIMED (1ULL << 63)
 
-#define TIMESPEC_DIFF_USEC(timespec1, timespec2) \
-    (((timespec1)->tv_sec - (timespec2)->tv_sec) * 1000000L + \
-        (timespec1)->tv_usec - (timespec2)->tv_usec)
+#if defined(__aarch64__)
+#define CPU_RELAX() asm volatile("yield" ::: "memory")
+#elif defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() asm volatile("pause" ::: "memory")
+#else
+#define CPU_RELAX() asm volatile("" ::: "memory")
+#endif
 
 using namespace std;
 
+#if defined(__aarch64__)
+/* The generic timer counts at a fixed frequency, independent of CPU
+ * frequency scaling, and is readable from userspace without a syscall. */
+static inline uint64_t
+getTicks()
+{
+    uint64_t ticks;
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r" (ticks) :: "memory");
+    return ticks;
+}
+
+static uint64_t
+getTickFrequency()
+{
+    uint64_t freq;
+    asm volatile("mrs %0, cntfrq_el0" : "=r" (freq));
+    return freq;
+}
+
+static const double nsec_per_tick = 1e9 / getTickFrequency();
+
+static inline uint64_t
+ticksToNsec(uint64_t ticks)
+{
+    return (uint64_t) (ticks * nsec_per_tick);
+}
+#else
+static inline uint64_t
+getTicks()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t
+ticksToNsec(uint64_t ticks)
+{
+    return ticks;
+}
+#endif
+
+/* Shards owned by live threads, one bit per shard. */
+static std::atomic<unsigned int> owned_shards(0);
+
+/**
+ * Shard owned by a thread. The first threads to finish units each own one
+ * shard in every profiler until they exit, and are the only ones updating
+ * it. The other threads share the last shard.
+ */
+class ShardOwnership
+{
+public:
+    ShardOwnership(int num_owned_shards)
+        :index(num_owned_shards), owned(false)
+    {
+        for (int i = 0; i < num_owned_shards; i++)
+        {
+            if (!(owned_shards.fetch_or(1U << i, std::memory_order_acquire) &
+                        (1U << i)))
+            {
+                index = i;
+                owned = true;
+                break;
+            }
+        }
+    }
+
+    ~ShardOwnership()
+    {
+        if (owned)
+        {
+            owned_shards.fetch_and(~(1U << index), std::memory_order_release);
+        }
+    }
+
+    int index;
+    bool owned;
+};
+
+/**
+ * Returns the shard index of the calling thread, @a num_owned_shards if it
+ * does not own one.
+ */
+static inline int
+getShardIndex(int num_owned_shards)
+{
+    static thread_local ShardOwnership ownership(num_owned_shards);
+
+    return ownership.index;
+}
+
+/* Adds to a counter. The counters of a shard owned by the calling thread
+ * are not written by other threads, so they need no read-modify-write. */
+static inline void
+addToCounter(std::atomic<uint64_t> &var, uint64_t value, bool owned)
+{
+    if (owned)
+    {
+        var.store(var.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+    }
+    else
+    {
+        var.fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+/* Values below 8 get a bucket each, larger values are split in 8 linear
+ * sub-buckets per power of 2. */
+static inline int
+getHistogramBucket(uint64_t value, int num_buckets, int sub_buckets_log2)
+{
+    int msb;
+    int bucket;
+
+    if (value < (1U << sub_buckets_log2))
+    {
+        return value;
+    }
+
+    msb = 63 - __builtin_clzll(value);
+    bucket = ((msb - sub_buckets_log2 + 1) << sub_buckets_log2) +
+        ((value >> (msb - sub_buckets_log2)) & ((1 << sub_buckets_log2) - 1));
+
+    return bucket < num_buckets ? bucket : num_buckets - 1;
+}
+
+/* Returns the middle of the range of values of a bucket. */
+static inline uint64_t
+getHistogramValue(int bucket, int sub_buckets_log2)
+{
+    int range = bucket >> sub_buckets_log2;
+    uint64_t sub_bucket = bucket & ((1 << sub_buckets_log2) - 1);
+    int shift;
+
+    if (range == 0)
+    {
+        return bucket;
+    }
+
+    shift = range - 1;
+    return (((1ULL << sub_buckets_log2) + sub_bucket) << shift) +
+        ((1ULL << shift) >> 1);
+}
+
+/* Returns 0 if no unit was processed, or if the start time was set after
+ * the stop time was read. */
+static inline uint64_t
+getElapsedTicks(uint64_t start, uint64_t stop)
+{
+    return (start && stop > start) ? stop - start : 0;
+}
+
+static inline void
+atomicMin(std::atomic<uint64_t> &var, uint64_t value)
+{
+    uint64_t cur = var.load(std::memory_order_relaxed);
+    while (value < cur &&
+            !var.compare_exchange_weak(cur, value, std::memory_order_relaxed));
+}
+
+static inline void
+atomicMax(std::atomic<uint64_t> &var, uint64_t value)
+{
+    uint64_t cur = var.load(std::memory_order_relaxed);
+    while (value > cur &&
+            !var.compare_exchange_weak(cur, value, std::memory_order_relaxed));
+}
+
 NvElementProfiler::NvElementProfiler(ProfilerField fields)
     :valid_fields(fields)
 {
@@ -92,78 +268,147 @@ NvElementProfiler::disableProfiling()
     LOCK();
     RETURN_IF_DISABLED();
 
-    data_int.accumulated_time.tv_sec +=
-        (data_int.stop_time.tv_sec - data_int.start_time.tv_sec);
-    data_int.accumulated_time.tv_usec +=
-        (data_int.stop_time.tv_usec - data_int.start_time.tv_usec);
-    data_int.start_time.tv_sec = 0;
-    data_int.start_time.tv_usec = 0;
-    data_int.stop_time.tv_sec = 0;
-    data_int.stop_time.tv_usec = 0;
     enabled = false;
+    accumulated_time += getElapsedTicks(start_time.exchange(0),
+            stop_time.exchange(0));
     UNLOCK();
 }
 
 void NvElementProfiler::getProfilerData(NvElementProfiler::NvElementProfilerData &data)
 {
+    static const uint64_t percentiles[] = { 500, 900, 990, 999 };
+    uint64_t *percentile_values[] = { &data.p50_latency_usec,
+        &data.p90_latency_usec, &data.p99_latency_usec, &data.p999_latency_usec };
+    uint64_t histogram[HISTOGRAM_BUCKETS] = { 0 };
+    uint64_t total_units = 0;
+    uint64_t late_units = 0;
+    uint64_t total_latency = 0;
+    uint64_t total_latency_sq = 0;
+    uint64_t min_latency = (uint64_t) -1;
+    uint64_t max_latency = 0;
+    uint64_t first_time;
     uint64_t total_time;
+    uint64_t count;
+    int bucket;
+    int i;
 
     LOCK();
 
-    total_time = data_int.accumulated_time.tv_sec * 1000000L +
-        data_int.accumulated_time.tv_usec +
-        TIMESPEC_DIFF_USEC(&data_int.stop_time, &data_int.start_time);
+    for (i = 0; i <= NUM_SHARDS; i++)
+    {
+        Shard &shard = shards[i];
+
+        total_units += shard.num_untimed_units.load(memory_order_relaxed);
+        late_units += shard.num_late_units.load(memory_order_relaxed);
+        total_latency += shard.total_latency.load(memory_order_relaxed);
+        total_latency_sq += shard.total_latency_sq.load(memory_order_relaxed);
+        min_latency = min(min_latency,
+                shard.min_latency.load(memory_order_relaxed));
+        max_latency = max(max_latency,
+                shard.max_latency.load(memory_order_relaxed));
+        for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+        {
+            histogram[bucket] += shard.histogram[bucket].load(memory_order_relaxed);
+        }
+    }
+
+    /* Timed units are only counted in the histogram. */
+    count = 0;
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        count += histogram[bucket];
+    }
+    total_units += count;
+
+    /* A unit finishing concurrently may set the start time after the stop
+     * time, so read the start time first. */
+    first_time = start_time.load();
+    total_time = ticksToNsec(accumulated_time +
+            getElapsedTicks(first_time, stop_time.load())) / 1000;
 
-    if (data_int.total_processed_units == 0 || total_time == 0)
+    if (total_units == 0 || total_time == 0)
     {
         data.average_fps = 0;
     }
     else
     {
-        data.average_fps = ((float) (data_int.total_processed_units - 1)) *
-            1000000 / total_time;
+        data.average_fps = ((float) (total_units - 1)) * 1000000 / total_time;
     }
 
-    if (data_int.total_processed_units == 0)
+    if (count == 0)
     {
         data.max_latency_usec = 0;
         data.min_latency_usec = 0;
         data.average_latency_usec = 0;
+        data.latency_jitter_usec = 0;
+        for (i = 0; i < 4; i++)
+        {
+            *percentile_values[i] = 0;
+        }
     }
     else
     {
-        data.max_latency_usec = data_int.max_latency_usec;
-        data.min_latency_usec = data_int.min_latency_usec;
-        data.average_latency_usec =
-            data_int.total_latency / data_int.total_processed_units;
+        double mean = (double) total_latency / count / 1000;
+        double variance = (double) total_latency_sq / count - mean * mean;
+        uint64_t seen = 0;
+
+        data.max_latency_usec = max_latency / 1000;
+        data.min_latency_usec = min_latency / 1000;
+        data.average_latency_usec = total_latency / count / 1000;
+        data.latency_jitter_usec = variance > 0 ? sqrt(variance) : 0;
+
+        bucket = 0;
+        for (i = 0; i < 4; i++)
+        {
+            uint64_t rank = (count * percentiles[i] + 999) / 1000;
+            uint64_t value;
+
+            while (seen + histogram[bucket] < rank)
+            {
+                seen += histogram[bucket++];
+            }
+            value = getHistogramValue(bucket, HISTOGRAM_SUB_BUCKETS_LOG2);
+            value = min(max(value, min_latency), max_latency);
+            *percentile_values[i] = value / 1000;
+        }
     }
 
-    data.profiling_time.tv_sec =
-        data_int.accumulated_time.tv_sec + data_int.stop_time.tv_sec -
-                data_int.start_time.tv_sec;
+    data.profiling_time.tv_sec = total_time / 1000000;
+    data.profiling_time.tv_usec = total_time % 1000000;
 
-    data.profiling_time.tv_usec =
-        data_int.accumulated_time.tv_usec + data_int.stop_time.tv_usec -
-                data_int.start_time.tv_usec;
+    data.total_processed_units = total_units;
+    data.num_late_units = late_units;
+    data.num_overflowed_units = num_overflowed_units.load(memory_order_relaxed);
+    data.valid_fields = valid_fields;
+    UNLOCK();
+}
 
-    if (data.profiling_time.tv_usec < 0)
-    {
-        data.profiling_time.tv_usec += 1000000;
-        data.profiling_time.tv_sec--;
-    }
+void
+NvElementProfiler::getLatencyHistogram(uint64_t *histogram)
+{
+    int bucket;
+    int i;
+
+    memset(histogram, 0, HISTOGRAM_BUCKETS * sizeof(uint64_t));
 
-    if (data.profiling_time.tv_usec > 1000000)
+    LOCK();
+    for (i = 0; i <= NUM_SHARDS; i++)
     {
-        data.profiling_time.tv_usec -= 1000000;
-        data.profiling_time.tv_sec++;
+        for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+        {
+            histogram[bucket] +=
+                shards[i].histogram[bucket].load(memory_order_relaxed);
+        }
     }
-
-    data.total_processed_units = data_int.total_processed_units;
-    data.num_late_units = data_int.num_late_units;
-    data.valid_fields = valid_fields;
     UNLOCK();
 }
 
+float
+NvElementProfiler::getHistogramBucketUsec(int bucket)
+{
+    return getHistogramValue(bucket, HISTOGRAM_SUB_BUCKETS_LOG2) / 1000.0f;
+}
+
 void NvElementProfiler::printProfilerData(ostream &out_stream)
 {
     NvElementProfilerData data;
@@ -194,105 +439,212 @@ void NvElementProfiler::printProfilerData(ostream &out_stream)
             data.min_latency_usec << endl;
         out_stream << "Maximum latency(usec) = " <<
             data.max_latency_usec << endl;
+        out_stream << "Latency percentiles(usec) p50/p90/p99/p99.9 = " <<
+            data.p50_latency_usec << "/" << data.p90_latency_usec << "/" <<
+            data.p99_latency_usec << "/" << data.p999_latency_usec << endl;
+        out_stream << "Latency jitter(usec) = " <<
+            data.latency_jitter_usec << endl;
+        if (data.num_overflowed_units)
+        {
+            out_stream << "Units without latency (overflow) = " <<
+                data.num_overflowed_units << endl;
+        }
     }
 }
 
 void
 NvElementProfiler::reset()
 {
-    memset(&data_int, 0, sizeof(data_int));
-    data_int.min_latency_usec = (uint64_t) -1;
+    int i, j;
+
+    for (i = 0; i <= NUM_SHARDS; i++)
+    {
+        Shard &shard = shards[i];
+
+        shard.num_untimed_units = 0;
+        shard.num_late_units = 0;
+        shard.total_latency = 0;
+        shard.total_latency_sq = 0;
+        shard.min_latency = (uint64_t) -1;
+        shard.max_latency = 0;
+        for (j = 0; j < HISTOGRAM_BUCKETS; j++)
+        {
+            shard.histogram[j] = 0;
+        }
+    }
 
-    unit_start_time_queue.clear();
+    for (i = 0; i < MAX_UNITS_IN_FLIGHT; i++)
+    {
+        units_in_flight[i].id = UNIT_CLAIMED;
+        units_in_flight[i].start = 0;
+    }
+    oldest_unit_id = unit_id_counter + 1;
+    num_overflowed_units = 0;
+    num_overflowed_unfinished = 0;
+
+    start_time = 0;
+    stop_time = 0;
+    accumulated_time = 0;
 }
 
 uint64_t
 NvElementProfiler::startProcessing()
 {
-    struct timeval time;
-    uint64_t ret = 0;
-    LOCK();
-    if (enabled)
-    {
-        std::map<uint64_t,struct timeval>::iterator it =
-            unit_start_time_queue.end();
+    UnitInFlight *unit;
+    uint64_t old_id;
+    uint64_t id;
 
-        unit_id_counter++;
-        GET_TIME(&time);
+    if (!enabled.load(memory_order_relaxed))
+    {
+        return 0;
+    }
 
-        unit_start_time_queue.insert(it,
-                std::pair<uint64_t,struct timeval>(unit_id_counter, time));
+    id = unit_id_counter.fetch_add(1, memory_order_relaxed) + 1;
+    unit = &units_in_flight[id & (MAX_UNITS_IN_FLIGHT - 1)];
 
-        ret = unit_id_counter;
+    unit->start.store(getTicks(), memory_order_relaxed);
+    old_id = unit->id.exchange(id, memory_order_acq_rel);
+    if (!(old_id & UNIT_CLAIMED))
+    {
+        /* The unit MAX_UNITS_IN_FLIGHT before this one is still in
+         * processing. Its claim will now fail, so keep count of it. */
+        num_overflowed_units.fetch_add(1, memory_order_relaxed);
+        num_overflowed_unfinished.fetch_add(1, memory_order_relaxed);
     }
-    UNLOCK();
-    return ret;
+
+    return id;
 }
 
-void
-NvElementProfiler::finishProcessing(uint64_t id, bool is_late)
+uint64_t
+NvElementProfiler::claimUnit(uint64_t id)
 {
-    struct timeval unit_start_time;
-    struct timeval stop_time;
-    uint64_t latency;
-
-    LOCK();
-    RETURN_IF_DISABLED();
+    UnitInFlight *unit;
+    uint64_t unit_id;
+    uint64_t start;
 
-    if ((valid_fields & PROFILER_FIELD_LATENCIES) &&
-            unit_start_time_queue.empty())
+    if (id)
     {
-        UNLOCK();
-        return;
+        unit = &units_in_flight[id & (MAX_UNITS_IN_FLIGHT - 1)];
+        unit_id = unit->id.load(memory_order_acquire);
+        start = unit->start.load(memory_order_relaxed);
+        if (unit_id != id ||
+                !unit->id.compare_exchange_strong(unit_id, id | UNIT_CLAIMED))
+        {
+            return 0;
+        }
+        return start;
     }
 
-    GET_TIME(&stop_time);
-
-    if (valid_fields & PROFILER_FIELD_LATENCIES)
+    /* Walk from the oldest unit which may still be in processing, skipping
+     * units which have already been finished by ID or overwritten. */
+    while (true)
     {
-        std::map<uint64_t, struct timeval>::iterator it;
-        if (id)
-        {
-            it = unit_start_time_queue.find(id);
-        }
-        else
+        id = oldest_unit_id.load(memory_order_acquire);
+        if (id > unit_id_counter.load(memory_order_acquire))
         {
-            it = unit_start_time_queue.begin();
+            return 0;
         }
 
-        if (it == unit_start_time_queue.end())
+        unit = &units_in_flight[id & (MAX_UNITS_IN_FLIGHT - 1)];
+        unit_id = unit->id.load(memory_order_acquire);
+        if ((unit_id & ~UNIT_CLAIMED) < id)
         {
-            UNLOCK();
-            return;
+            /* startProcessing() has reserved the ID but not yet published
+             * the start time. */
+            CPU_RELAX();
+            continue;
         }
-        unit_start_time = it->second;
-        unit_start_time_queue.erase(it);
-
-        latency = TIMESPEC_DIFF_USEC(&stop_time, &unit_start_time);
-        data_int.total_latency += latency;
 
-        if (latency < data_int.min_latency_usec)
+        if (unit_id == id)
         {
-            data_int.min_latency_usec = latency;
-        }
-        if(latency > data_int.max_latency_usec)
-        {
-            data_int.max_latency_usec = latency;
+            start = unit->start.load(memory_order_relaxed);
+            if (unit->id.compare_exchange_strong(unit_id, id | UNIT_CLAIMED))
+            {
+                oldest_unit_id.compare_exchange_strong(id, id + 1);
+                return start;
+            }
+            continue;
         }
+
+        oldest_unit_id.compare_exchange_strong(id, id + 1);
     }
+}
 
-    data_int.stop_time = stop_time;
+bool
+NvElementProfiler::claimOverflowedUnit()
+{
+    uint64_t count = num_overflowed_unfinished.load(memory_order_relaxed);
 
-    if (!data_int.start_time.tv_sec && !data_int.start_time.tv_usec)
+    while (count &&
+            !num_overflowed_unfinished.compare_exchange_weak(count, count - 1,
+                memory_order_relaxed));
+    return count != 0;
+}
+
+void
+NvElementProfiler::recordUnit(uint64_t now, uint64_t latency_ticks, bool is_late)
+{
+    int index = getShardIndex(NUM_SHARDS);
+    Shard &shard = shards[index];
+    bool owned = index < NUM_SHARDS;
+
+    if (latency_ticks)
     {
-        data_int.start_time = data_int.stop_time;
+        uint64_t latency = ticksToNsec(latency_ticks);
+        uint64_t latency_usec = latency / 1000;
+        int bucket = getHistogramBucket(latency, HISTOGRAM_BUCKETS,
+                HISTOGRAM_SUB_BUCKETS_LOG2);
+
+        addToCounter(shard.histogram[bucket], 1, owned);
+        addToCounter(shard.total_latency, latency, owned);
+        addToCounter(shard.total_latency_sq, latency_usec * latency_usec, owned);
+        atomicMin(shard.min_latency, latency);
+        atomicMax(shard.max_latency, latency);
+    }
+    else
+    {
+        addToCounter(shard.num_untimed_units, 1, owned);
     }
 
     if (is_late)
     {
-        data_int.num_late_units++;
+        addToCounter(shard.num_late_units, 1, owned);
     }
-    data_int.total_processed_units++;
 
-    UNLOCK();
+    /* Threads finishing units at the same time may leave the stop time a
+     * few ticks behind, which is not worth a compare-and-swap per unit. */
+    if (now > stop_time.load(memory_order_relaxed))
+    {
+        stop_time.store(now, memory_order_relaxed);
+    }
+    if (start_time.load(memory_order_relaxed) == 0)
+    {
+        uint64_t zero = 0;
+        start_time.compare_exchange_strong(zero, now, memory_order_relaxed);
+    }
+}
+
+void
+NvElementProfiler::finishProcessing(uint64_t id, bool is_late)
+{
+    uint64_t unit_start_time = 0;
+    uint64_t now;
+
+    if (!enabled.load(memory_order_relaxed))
+    {
+        return;
+    }
+
+    if (valid_fields & PROFILER_FIELD_LATENCIES)
+    {
+        unit_start_time = claimUnit(id);
+        if (!unit_start_time && !claimOverflowedUnit())
+        {
+            return;
+        }
+    }
+
+    now = getTicks();
+    recordUnit(now, unit_start_time ? max(now - unit_start_time, (uint64_t) 1) : 0,
+            is_late);
 }
@@ -0,0 +1,966 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvEncSchedule.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CAT_NAME "EncSchedule"
+
+#define SCHEDULE_MAGIC "NVENCSCH"
+#define SCHEDULE_VERSION 1
+
+/* Tables start on 8-byte boundaries of the image. */
+#define SCHEDULE_ALIGN(x) (((x) + 7) & ~((uint64_t) 7))
+
+#define FNV1A_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV1A_PRIME 0x100000001b3ULL
+
+#define IS_DIGIT(c) (c >= '0' && c <= '9')
+
+/**
+ * Location of a table in the image. Lookups past the last record wrap
+ * around to the record at @c loop_start.
+ */
+struct NvEncScheduleTable
+{
+    uint32_t offset;
+    uint32_t count;
+    uint32_t loop_start;
+    uint32_t record_size;
+};
+
+/**
+ * Header at the start of the image, also the layout of the cache file.
+ */
+struct NvEncScheduleHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t source_stamp;
+    uint64_t image_size;
+    NvEncScheduleTable changes;
+    NvEncScheduleTable ops;
+    NvEncScheduleTable roi;
+    NvEncScheduleTable rps;
+    NvEncScheduleTable rate_ctrl;
+    NvEncScheduleTable gdr;
+};
+
+NvEncSchedule::NvEncSchedule(const NvEncScheduleSources &sources,
+        const char *cache_path)
+{
+    uint64_t stamp;
+
+    map_addr = NULL;
+    map_size = 0;
+    header = NULL;
+    is_in_error = false;
+
+    stamp = getSourceStamp(sources);
+    if (cache_path && mapCache(cache_path, stamp))
+    {
+        CAT_DEBUG_MSG("Mapped schedule from " << cache_path);
+        return;
+    }
+
+    if (compile(sources, stamp) < 0)
+    {
+        is_in_error = true;
+        return;
+    }
+
+    if (cache_path)
+    {
+        /* Not fatal, the next run parses the sources again. */
+        writeCache(cache_path);
+    }
+}
+
+NvEncSchedule *
+NvEncSchedule::createEncSchedule(const NvEncScheduleSources &sources,
+        const char *cache_path)
+{
+    NvEncSchedule *schedule = new NvEncSchedule(sources, cache_path);
+    if (schedule->is_in_error)
+    {
+        delete schedule;
+        return NULL;
+    }
+    return schedule;
+}
+
+NvEncSchedule::~NvEncSchedule()
+{
+    if (map_addr)
+    {
+        munmap(map_addr, map_size);
+    }
+}
+
+static uint64_t
+fnv1a(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+uint64_t
+NvEncSchedule::getSourceStamp(const NvEncScheduleSources &sources)
+{
+    const char *files[] = { sources.roi_file_path, sources.rps_file_path,
+        sources.hints_file_path, sources.gdr_file_path };
+    uint64_t hash = FNV1A_OFFSET_BASIS;
+    uint8_t slot;
+
+    /* Each source is hashed with its slot, so that an unset source and the
+       same file given for another source give different stamps. */
+    if (sources.runtime_params)
+    {
+        slot = 0;
+        hash = fnv1a(hash, &slot, 1);
+        hash = fnv1a(hash, sources.runtime_params,
+                strlen(sources.runtime_params) + 1);
+    }
+
+    for (uint32_t i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    {
+        struct stat st;
+        uint64_t fields[4] = { 0, 0, 0, 0 };
+
+        if (!files[i])
+        {
+            continue;
+        }
+        slot = i + 1;
+        hash = fnv1a(hash, &slot, 1);
+        hash = fnv1a(hash, files[i], strlen(files[i]) + 1);
+
+        /* The file is identified by its inode, size and modification time
+           rather than by its contents, which would have to be read. */
+        if (stat(files[i], &st) == 0)
+        {
+            fields[0] = st.st_ino;
+            fields[1] = st.st_size;
+            fields[2] = st.st_mtim.tv_sec;
+            fields[3] = st.st_mtim.tv_nsec;
+        }
+        hash = fnv1a(hash, fields, sizeof(fields));
+    }
+    return hash;
+}
+
+static bool
+check_table(const NvEncScheduleTable &table, uint32_t record_size,
+        uint64_t image_size)
+{
+    if (table.record_size != record_size || (table.offset & 7))
+    {
+        return false;
+    }
+    if (table.count && table.loop_start >= table.count)
+    {
+        return false;
+    }
+    return (uint64_t) table.offset + (uint64_t) table.count * record_size <=
+        image_size;
+}
+
+bool
+NvEncSchedule::mapCache(const char *cache_path, uint64_t stamp)
+{
+    const NvEncScheduleHeader *hdr;
+    struct stat st;
+    void *addr;
+    int fd;
+
+    fd = open(cache_path, O_RDONLY);
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+        {
+            CAT_SYS_ERROR_MSG("Could not open " << cache_path);
+        }
+        return false;
+    }
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(NvEncScheduleHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        CAT_SYS_ERROR_MSG("Could not map " << cache_path);
+        return false;
+    }
+
+    hdr = (const NvEncScheduleHeader *) addr;
+    if (memcmp(hdr->magic, SCHEDULE_MAGIC, sizeof(hdr->magic)) ||
+        hdr->version != SCHEDULE_VERSION ||
+        hdr->header_size != sizeof(NvEncScheduleHeader) ||
+        hdr->source_stamp != stamp ||
+        hdr->image_size != (uint64_t) st.st_size ||
+        !check_table(hdr->changes, sizeof(NvEncScheduleChange), hdr->image_size) ||
+        !check_table(hdr->ops, sizeof(NvEncScheduleOp), hdr->image_size) ||
+        !check_table(hdr->roi, sizeof(v4l2_enc_frame_ROI_params), hdr->image_size) ||
+        !check_table(hdr->rps, sizeof(v4l2_enc_frame_ext_rps_ctrl_params), hdr->image_size) ||
+        !check_table(hdr->rate_ctrl, sizeof(v4l2_enc_frame_ext_rate_ctrl_params), hdr->image_size) ||
+        !check_table(hdr->gdr, 2 * sizeof(uint32_t), hdr->image_size))
+    {
+        CAT_DEBUG_MSG("Schedule cache " << cache_path << " is stale");
+        munmap(addr, st.st_size);
+        return false;
+    }
+
+    map_addr = addr;
+    map_size = st.st_size;
+    header = hdr;
+    return true;
+}
+
+int
+NvEncSchedule::writeCache(const char *cache_path)
+{
+    std::string tmp_path(cache_path);
+    const uint8_t *p = &image[0];
+    size_t left = image.size();
+    int fd;
+
+    /* Write a temporary file and rename it, so that a concurrent run never
+       maps a partially written image. */
+    tmp_path += ".tmp";
+    fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not create " << tmp_path);
+        return -1;
+    }
+
+    while (left)
+    {
+        ssize_t ret = write(fd, p, left);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            CAT_SYS_ERROR_MSG("Could not write " << tmp_path);
+            close(fd);
+            unlink(tmp_path.c_str());
+            return -1;
+        }
+        p += ret;
+        left -= ret;
+    }
+
+    if (close(fd) < 0 || rename(tmp_path.c_str(), cache_path) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not write " << cache_path);
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+static void
+set_table(NvEncScheduleTable &table, uint64_t &offset, uint32_t count,
+        uint32_t loop_start, uint32_t record_size)
+{
+    table.offset = offset;
+    table.count = count;
+    table.loop_start = loop_start;
+    table.record_size = record_size;
+    offset = SCHEDULE_ALIGN(offset + (uint64_t) count * record_size);
+}
+
+int
+NvEncSchedule::compile(const NvEncScheduleSources &sources, uint64_t stamp)
+{
+    std::vector<NvEncScheduleChange> changes;
+    std::vector<NvEncScheduleOp> ops;
+    std::vector<v4l2_enc_frame_ROI_params> roi;
+    std::vector<v4l2_enc_frame_ext_rps_ctrl_params> rps;
+    std::vector<v4l2_enc_frame_ext_rate_ctrl_params> rate_ctrl;
+    std::vector<uint32_t> gdr;
+    uint32_t roi_loop_start = 0;
+    uint32_t rps_loop_start = 0;
+    uint32_t rate_ctrl_loop_start = 0;
+    NvEncScheduleHeader layout;
+    NvEncScheduleHeader *hdr;
+    uint64_t offset;
+
+    if (sources.runtime_params)
+    {
+        compileRuntimeParams(sources.runtime_params, changes, ops);
+    }
+    if (sources.roi_file_path &&
+        compileRoi(sources.roi_file_path, roi, roi_loop_start) < 0)
+    {
+        return -1;
+    }
+    if (sources.rps_file_path &&
+        compileRps(sources.rps_file_path, rps, rps_loop_start) < 0)
+    {
+        return -1;
+    }
+    if (sources.hints_file_path &&
+        compileRateCtrl(sources.hints_file_path, rate_ctrl,
+            rate_ctrl_loop_start) < 0)
+    {
+        return -1;
+    }
+    if (sources.gdr_file_path && compileGdr(sources.gdr_file_path, gdr) < 0)
+    {
+        return -1;
+    }
+
+    memset(&layout, 0, sizeof(layout));
+    memcpy(layout.magic, SCHEDULE_MAGIC, sizeof(layout.magic));
+    layout.version = SCHEDULE_VERSION;
+    layout.header_size = sizeof(NvEncScheduleHeader);
+    layout.source_stamp = stamp;
+
+    offset = SCHEDULE_ALIGN(sizeof(NvEncScheduleHeader));
+    set_table(layout.changes, offset, changes.size(), 0,
+            sizeof(NvEncScheduleChange));
+    set_table(layout.ops, offset, ops.size(), 0, sizeof(NvEncScheduleOp));
+    set_table(layout.roi, offset, roi.size(), roi_loop_start,
+            sizeof(v4l2_enc_frame_ROI_params));
+    set_table(layout.rps, offset, rps.size(), rps_loop_start,
+            sizeof(v4l2_enc_frame_ext_rps_ctrl_params));
+    set_table(layout.rate_ctrl, offset, rate_ctrl.size(), rate_ctrl_loop_start,
+            sizeof(v4l2_enc_frame_ext_rate_ctrl_params));
+    set_table(layout.gdr, offset, gdr.size() / 2, 0, 2 * sizeof(uint32_t));
+    layout.image_size = offset;
+
+    if (offset > UINT32_MAX)
+    {
+        CAT_ERROR_MSG("Schedule of " << offset << " bytes is too large");
+        return -1;
+    }
+
+    image.assign(offset, 0);
+    hdr = (NvEncScheduleHeader *) &image[0];
+    *hdr = layout;
+
+    if (!changes.empty())
+    {
+        memcpy(&image[hdr->changes.offset], &changes[0],
+                changes.size() * sizeof(changes[0]));
+    }
+    if (!ops.empty())
+    {
+        memcpy(&image[hdr->ops.offset], &ops[0], ops.size() * sizeof(ops[0]));
+    }
+    if (!roi.empty())
+    {
+        memcpy(&image[hdr->roi.offset], &roi[0], roi.size() * sizeof(roi[0]));
+    }
+    if (!rps.empty())
+    {
+        memcpy(&image[hdr->rps.offset], &rps[0], rps.size() * sizeof(rps[0]));
+    }
+    if (!rate_ctrl.empty())
+    {
+        memcpy(&image[hdr->rate_ctrl.offset], &rate_ctrl[0],
+                rate_ctrl.size() * sizeof(rate_ctrl[0]));
+    }
+    if (!gdr.empty())
+    {
+        memcpy(&image[hdr->gdr.offset], &gdr[0], gdr.size() * sizeof(gdr[0]));
+    }
+
+    header = hdr;
+    CAT_DEBUG_MSG("Compiled schedule of " << changes.size() <<
+            " runtime changes, " << roi.size() << " ROI, " << rps.size() <<
+            " RPS, " << rate_ctrl.size() << " RC and " << gdr.size() / 2 <<
+            " GDR records");
+    return 0;
+}
+
+int
+NvEncSchedule::getNextParsedPair(std::istream &stream, char *id,
+        uint32_t *value)
+{
+    char charval;
+
+    stream >> *id;
+    if (stream.eof())
+    {
+        return -1;
+    }
+
+    charval = stream.peek();
+    if (!IS_DIGIT(charval))
+    {
+        return -1;
+    }
+
+    stream >> *value;
+
+    stream >> charval;
+    if (stream.eof())
+    {
+        return 0;
+    }
+
+    return charval;
+}
+
+static bool
+is_change_frame_pair(int next, char id)
+{
+    /* At the end of the string, the pair is taken as the frame whatever
+       its id. */
+    return next == 0 || ((next == ';' || next == ',') && id == 'f');
+}
+
+void
+NvEncSchedule::compileRuntimeParams(const char *runtime_params,
+        std::vector<NvEncScheduleChange> &changes,
+        std::vector<NvEncScheduleOp> &ops)
+{
+    std::stringstream stream(runtime_params);
+    NvEncScheduleChange change;
+    uint32_t frame = 0;
+    bool last = false;
+    char id;
+    int next;
+
+    /* The string is parsed the way the encoder samples parsed it between
+       frames: the operations up to a '#' apply at the frame of the
+       preceding 'f' pair, and a parse error ends the changes after the
+       operations parsed so far. */
+    next = getNextParsedPair(stream, &id, &frame);
+    if (!is_change_frame_pair(next, id))
+    {
+        CAT_ERROR_MSG("Could not parse runtime parameter changes \"" <<
+                runtime_params << "\"");
+        return;
+    }
+
+    while (!last)
+    {
+        change.frame = frame;
+        change.first_op = ops.size();
+        change.num_ops = 0;
+        change.parse_error = 0;
+
+        while (!stream.eof())
+        {
+            NvEncScheduleOp op;
+            uint32_t value;
+
+            next = getNextParsedPair(stream, &id, &value);
+            if (next < 0)
+            {
+                change.parse_error = 1;
+                break;
+            }
+
+            op.id = id;
+            op.value = value;
+            op.value2 = 0;
+            if (id == 'r')
+            {
+                /* Frame rate, the denominator follows the '/'. */
+                if (next != '/')
+                {
+                    change.parse_error = 1;
+                    break;
+                }
+                stream.seekg(-1, std::ios::cur);
+                next = getNextParsedPair(stream, &id, &op.value2);
+                if (next < 0)
+                {
+                    change.parse_error = 1;
+                    break;
+                }
+            }
+            else if (id != 'b' && id != 'p' && id != 'i')
+            {
+                change.parse_error = 1;
+                break;
+            }
+            ops.push_back(op);
+            change.num_ops++;
+
+            if (next == 0)
+            {
+                last = true;
+                break;
+            }
+            if (next == '#')
+            {
+                break;
+            }
+        }
+
+        if (!last && !change.parse_error)
+        {
+            next = getNextParsedPair(stream, &id, &frame);
+            if (!is_change_frame_pair(next, id))
+            {
+                change.parse_error = 1;
+            }
+        }
+
+        changes.push_back(change);
+        if (change.parse_error)
+        {
+            CAT_ERROR_MSG("Could not parse runtime parameter changes \"" <<
+                    runtime_params << "\" past the change at frame " <<
+                    change.frame);
+            last = true;
+        }
+    }
+}
+
+/**
+ * Reads the ROI parameters of one frame. At the end of the file the file
+ * is rewound instead and the parameters are left untouched.
+ */
+static bool
+populate_roi(std::ifstream &stream, v4l2_enc_frame_ROI_params *params,
+        bool &clamped)
+{
+    unsigned int index = 0;
+
+    if (stream.eof())
+    {
+        stream.clear();
+        stream.seekg(0);
+        return true;
+    }
+
+    stream >> params->num_ROI_regions;
+    while (index < params->num_ROI_regions)
+    {
+        if (index == V4L2_MAX_ROI_REGIONS)
+        {
+            std::string skip_str;
+            getline(stream, skip_str);
+
+            params->num_ROI_regions = V4L2_MAX_ROI_REGIONS;
+            clamped = true;
+            break;
+        }
+
+        stream >> params->ROI_params[index].QPdelta;
+        stream >> params->ROI_params[index].ROIRect.left;
+        stream >> params->ROI_params[index].ROIRect.top;
+        stream >> params->ROI_params[index].ROIRect.width;
+        stream >> params->ROI_params[index].ROIRect.height;
+        index++;
+    }
+    return false;
+}
+
+/**
+ * Reads the external RPS parameters of one frame, rewinding the file at
+ * its end. Returns the number of rewinds, or -1 if the file holds no
+ * record and the frame could never be read.
+ */
+static int
+populate_rps(std::ifstream &stream, v4l2_enc_frame_ext_rps_ctrl_params *params,
+        bool &clamped)
+{
+    unsigned int index = 0;
+    unsigned int temp = 0;
+    int rewinds = 0;
+
+    stream.peek();
+restart:
+    if (stream.eof())
+    {
+        if (rewinds++)
+        {
+            return -1;
+        }
+        stream.clear();
+        stream.seekg(0);
+    }
+
+    stream >> params->nFrameId;
+    if (stream.eof())
+    {
+        goto restart;
+    }
+    stream >> temp;
+    params->bRefFrame = ((temp) ? true : false);
+    stream >> temp;
+    params->bLTRefFrame = ((temp) ? true : false);
+    stream >> params->nMaxRefFrames;
+    stream >> params->nActiveRefFrames;
+    stream >> params->nCurrentRefFrameId;
+    while (index < params->nActiveRefFrames)
+    {
+        if (index == V4L2_MAX_REF_FRAMES)
+        {
+            std::string skip_str;
+            getline(stream, skip_str);
+
+            params->nActiveRefFrames = V4L2_MAX_REF_FRAMES;
+            clamped = true;
+            break;
+        }
+
+        stream >> params->RPSList[index].nFrameId;
+        stream >> temp;
+        params->RPSList[index].bLTRefFrame = ((temp) ? true : false);
+        index++;
+    }
+    return rewinds;
+}
+
+/**
+ * Reads the external rate control parameters of one frame, rewinding the
+ * file at its end. Returns as populate_rps().
+ */
+static int
+populate_rate_ctrl(std::ifstream &stream,
+        v4l2_enc_frame_ext_rate_ctrl_params *params)
+{
+    int rewinds = 0;
+
+    stream.peek();
+restart:
+    if (stream.eof())
+    {
+        if (rewinds++)
+        {
+            return -1;
+        }
+        stream.clear();
+        stream.seekg(0);
+    }
+
+    stream >> params->nTargetFrameBits;
+    if (stream.eof())
+    {
+        goto restart;
+    }
+    stream >> params->nFrameQP;
+    stream >> params->nFrameMinQp;
+    stream >> params->nFrameMaxQp;
+    stream >> params->nMaxQPDeviation;
+    return rewinds;
+}
+
+/*
+ * A stream that failed without reaching its end is never rewound and no
+ * longer reads anything, all the following frames get the same record.
+ */
+static bool
+is_stuck(const std::ifstream &stream)
+{
+    return stream.fail() && !stream.eof();
+}
+
+int
+NvEncSchedule::compileRoi(const char *file_path,
+        std::vector<v4l2_enc_frame_ROI_params> &records, uint32_t &loop_start)
+{
+    std::ifstream stream(file_path);
+    v4l2_enc_frame_ROI_params params;
+    bool clamped = false;
+
+    if (!stream.is_open())
+    {
+        CAT_ERROR_MSG("Could not open ROI parameters file " << file_path);
+        return -1;
+    }
+
+    /* The frame that finds the end of the file only rewinds it, the next
+       frame reads the first record again. */
+    loop_start = 0;
+    for (;;)
+    {
+        memset(&params, 0, sizeof(params));
+        bool rewound = populate_roi(stream, &params, clamped);
+        records.push_back(params);
+        if (rewound)
+        {
+            break;
+        }
+        if (is_stuck(stream))
+        {
+            memset(&params, 0, sizeof(params));
+            populate_roi(stream, &params, clamped);
+            records.push_back(params);
+            loop_start = records.size() - 1;
+            break;
+        }
+    }
+
+    if (clamped)
+    {
+        CAT_WARN_MSG("Maximum of " << V4L2_MAX_ROI_REGIONS <<
+                " regions can be applied for a frame in " << file_path);
+    }
+    return 0;
+}
+
+int
+NvEncSchedule::compileRps(const char *file_path,
+        std::vector<v4l2_enc_frame_ext_rps_ctrl_params> &records,
+        uint32_t &loop_start)
+{
+    std::ifstream stream(file_path);
+    v4l2_enc_frame_ext_rps_ctrl_params params;
+    bool clamped = false;
+
+    if (!stream.is_open())
+    {
+        CAT_ERROR_MSG("Could not open RPS parameters file " << file_path);
+        return -1;
+    }
+
+    /* The frame that finds the end of the file rewinds it and reads the
+       first record, so the records repeat from that frame on. */
+    loop_start = 0;
+    for (;;)
+    {
+        memset(&params, 0, sizeof(params));
+        int rewinds = populate_rps(stream, &params, clamped);
+        if (rewinds < 0)
+        {
+            CAT_ERROR_MSG("No RPS parameters in " << file_path);
+            return -1;
+        }
+        if (rewinds)
+        {
+            break;
+        }
+        records.push_back(params);
+        if (is_stuck(stream))
+        {
+            memset(&params, 0, sizeof(params));
+            populate_rps(stream, &params, clamped);
+            records.push_back(params);
+            loop_start = records.size() - 1;
+            break;
+        }
+    }
+
+    if (clamped)
+    {
+        CAT_WARN_MSG("Maximum of " << V4L2_MAX_REF_FRAMES <<
+                " reference frames are valid in " << file_path);
+    }
+    return 0;
+}
+
+int
+NvEncSchedule::compileRateCtrl(const char *file_path,
+        std::vector<v4l2_enc_frame_ext_rate_ctrl_params> &records,
+        uint32_t &loop_start)
+{
+    std::ifstream stream(file_path);
+    v4l2_enc_frame_ext_rate_ctrl_params params;
+
+    if (!stream.is_open())
+    {
+        CAT_ERROR_MSG("Could not open hints parameters file " << file_path);
+        return -1;
+    }
+
+    /* Same as the RPS file. */
+    loop_start = 0;
+    for (;;)
+    {
+        memset(&params, 0, sizeof(params));
+        int rewinds = populate_rate_ctrl(stream, &params);
+        if (rewinds < 0)
+        {
+            CAT_ERROR_MSG("No rate control parameters in " << file_path);
+            return -1;
+        }
+        if (rewinds)
+        {
+            break;
+        }
+        records.push_back(params);
+        if (is_stuck(stream))
+        {
+            memset(&params, 0, sizeof(params));
+            populate_rate_ctrl(stream, &params);
+            records.push_back(params);
+            loop_start = records.size() - 1;
+            break;
+        }
+    }
+    return 0;
+}
+
+int
+NvEncSchedule::compileGdr(const char *file_path, std::vector<uint32_t> &entries)
+{
+    std::ifstream stream(file_path);
+    uint32_t start_frame_num;
+    uint32_t num_frames = 0xFFFFFFFF;
+
+    if (!stream.is_open())
+    {
+        CAT_ERROR_MSG("Could not open GDR parameters file " << file_path);
+        return -1;
+    }
+
+    /* One entry per read of the file, which the encoder samples do each
+       frame while they have no pending GDR start frame. Reads that give no
+       start frame are kept too, they take up a frame. */
+    for (;;)
+    {
+        start_frame_num = 0xFFFFFFFF;
+        if (!stream.eof())
+        {
+            stream >> start_frame_num;
+            stream >> num_frames;
+        }
+
+        entries.push_back(start_frame_num);
+        entries.push_back(num_frames);
+
+        /* Nothing is read past this entry. Either its start frame is kept
+           and the file is not read again, or no start frame is ever given
+           again. */
+        if (stream.eof() || stream.fail())
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+const void *
+NvEncSchedule::getRecord(const NvEncScheduleTable &table, uint32_t index) const
+{
+    if (index >= table.count)
+    {
+        index = table.loop_start +
+            (index - table.loop_start) % (table.count - table.loop_start);
+    }
+    return (const uint8_t *) header + table.offset +
+        (uint64_t) index * table.record_size;
+}
+
+uint32_t
+NvEncSchedule::getNumRuntimeChanges() const
+{
+    return header->changes.count;
+}
+
+const NvEncSchedule::NvEncScheduleChange *
+NvEncSchedule::getRuntimeChange(uint32_t index) const
+{
+    if (index >= header->changes.count)
+    {
+        return NULL;
+    }
+    return (const NvEncScheduleChange *) getRecord(header->changes, index);
+}
+
+const NvEncSchedule::NvEncScheduleOp *
+NvEncSchedule::getRuntimeOps(const NvEncScheduleChange *change) const
+{
+    return (const NvEncScheduleOp *) ((const uint8_t *) header +
+            header->ops.offset) + change->first_op;
+}
+
+int
+NvEncSchedule::getRoiParams(uint32_t index,
+        v4l2_enc_frame_ROI_params *params) const
+{
+    if (!header->roi.count)
+    {
+        return -1;
+    }
+    memcpy(params, getRecord(header->roi, index), sizeof(*params));
+    return 0;
+}
+
+int
+NvEncSchedule::getRpsParams(uint32_t index,
+        v4l2_enc_frame_ext_rps_ctrl_params *params) const
+{
+    if (!header->rps.count)
+    {
+        return -1;
+    }
+    memcpy(params, getRecord(header->rps, index), sizeof(*params));
+    return 0;
+}
+
+int
+NvEncSchedule::getRateCtrlParams(uint32_t index,
+        v4l2_enc_frame_ext_rate_ctrl_params *params) const
+{
+    if (!header->rate_ctrl.count)
+    {
+        return -1;
+    }
+    memcpy(params, getRecord(header->rate_ctrl, index), sizeof(*params));
+    return 0;
+}
+
+void
+NvEncSchedule::getGdrParams(uint32_t index, uint32_t *start_frame_num,
+        uint32_t *num_frames) const
+{
+    const uint32_t *entry;
+
+    if (index >= header->gdr.count)
+    {
+        *start_frame_num = 0xFFFFFFFF;
+        return;
+    }
+    entry = (const uint32_t *) getRecord(header->gdr, index);
+    *start_frame_num = entry[0];
+    *num_frames = entry[1];
+}
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvFrameSource.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CAT_NAME "FrameSource"
+
+/* Alignment of the frame memory, a page so that reads can go direct. */
+#define FRAME_ALIGNMENT 4096
+
+static uint64_t
+get_time_usec()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+NvFrameSource::NvFrameSource(const char *name, const char *file_path,
+        const NvBuffer &layout, uint64_t start_offset,
+        uint32_t num_frames_ahead, bool loop, uint32_t num_threads)
+{
+    struct stat st;
+    uint32_t i;
+
+    this->name = strdup(name);
+    this->start_offset = start_offset;
+    this->loop = loop;
+    fd = -1;
+    frame_size = 0;
+    num_frames = 0;
+    next_load = 0;
+    next_consume = 0;
+    stop = false;
+    is_in_error = false;
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&load_cond, NULL);
+    pthread_cond_init(&ready_cond, NULL);
+
+    n_planes = layout.n_planes;
+    for (i = 0; i < n_planes; i++)
+    {
+        row_bytes[i] = layout.planes[i].fmt.bytesperpixel *
+            layout.planes[i].fmt.width;
+        plane_height[i] = layout.planes[i].fmt.height;
+        frame_size += (uint64_t) row_bytes[i] * plane_height[i];
+    }
+    if (frame_size == 0)
+    {
+        CAT_ERROR_MSG("Invalid frame layout for " << name);
+        is_in_error = true;
+        return;
+    }
+
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+    if (fstat(fd, &st) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not stat " << file_path);
+        is_in_error = true;
+        return;
+    }
+    if ((uint64_t) st.st_size > start_offset)
+    {
+        num_frames = (st.st_size - start_offset) / frame_size;
+    }
+    if (num_frames == 0)
+    {
+        /* Nothing to loop over, readFrame reports the end right away. */
+        this->loop = false;
+    }
+    posix_fadvise(fd, start_offset, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (num_frames_ahead == 0)
+        num_frames_ahead = 1;
+    slots.resize(num_frames_ahead);
+    for (i = 0; i < slots.size(); i++)
+    {
+        void *data = NULL;
+
+        slots[i].sequence = UINT64_MAX;
+        slots[i].state = Slot::SLOT_FREE;
+        if (posix_memalign(&data, FRAME_ALIGNMENT, frame_size))
+        {
+            CAT_ERROR_MSG("Could not allocate " << num_frames_ahead <<
+                    " frames of " << frame_size << " bytes");
+            slots[i].data = NULL;
+            is_in_error = true;
+            return;
+        }
+        slots[i].data = (unsigned char *) data;
+    }
+
+    if (num_threads == 0)
+        num_threads = 1;
+    if (num_threads > slots.size())
+        num_threads = slots.size();
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, prefetchThread, this))
+        {
+            CAT_ERROR_MSG("Could not create prefetch thread");
+            is_in_error = true;
+            return;
+        }
+        pthread_setname_np(thread, "FramePrefetch");
+        threads.push_back(thread);
+    }
+
+    CAT_DEBUG_MSG("Reading " << num_frames << " frames of " << frame_size <<
+            " bytes ahead from " << file_path);
+}
+
+NvFrameSource *
+NvFrameSource::createFrameSource(const char *name, const char *file_path,
+        const NvBuffer &layout, uint64_t start_offset,
+        uint32_t num_frames_ahead, bool loop, uint32_t num_threads)
+{
+    NvFrameSource *source = new NvFrameSource(name, file_path, layout,
+            start_offset, num_frames_ahead, loop, num_threads);
+    if (source->is_in_error)
+    {
+        delete source;
+        return NULL;
+    }
+    return source;
+}
+
+NvFrameSource::~NvFrameSource()
+{
+    pthread_mutex_lock(&lock);
+    stop = true;
+    pthread_cond_broadcast(&load_cond);
+    pthread_mutex_unlock(&lock);
+
+    for (uint32_t i = 0; i < threads.size(); i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    for (uint32_t i = 0; i < slots.size(); i++)
+    {
+        free(slots[i].data);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    pthread_cond_destroy(&ready_cond);
+    pthread_cond_destroy(&load_cond);
+    pthread_mutex_destroy(&lock);
+    free(name);
+}
+
+int
+NvFrameSource::loadFrame(uint64_t sequence, unsigned char *data)
+{
+    uint64_t frame = loop ? sequence % num_frames : sequence;
+    off_t offset = start_offset + frame * frame_size;
+    uint64_t done = 0;
+
+    while (done < frame_size)
+    {
+        ssize_t ret = pread(fd, data + done, frame_size - done, offset + done);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            CAT_SYS_ERROR_MSG("Error while reading frame " << frame);
+            return -1;
+        }
+        if (ret == 0)
+        {
+            CAT_ERROR_MSG("Input file truncated at frame " << frame);
+            return -1;
+        }
+        done += ret;
+    }
+    return 0;
+}
+
+void *
+NvFrameSource::prefetchThread(void *arg)
+{
+    NvFrameSource *source = (NvFrameSource *) arg;
+
+    pthread_mutex_lock(&source->lock);
+    while (!source->stop)
+    {
+        uint64_t sequence = source->next_load;
+        Slot &slot = source->slots[sequence % source->slots.size()];
+        int ret;
+
+        if (!source->loop && sequence >= source->num_frames)
+        {
+            /* The whole file has been read. */
+            break;
+        }
+        if (slot.state != Slot::SLOT_FREE)
+        {
+            /* Ring full, wait for the consumer. */
+            pthread_cond_wait(&source->load_cond, &source->lock);
+            continue;
+        }
+
+        slot.state = Slot::SLOT_LOADING;
+        slot.sequence = sequence;
+        source->next_load++;
+        pthread_mutex_unlock(&source->lock);
+
+        ret = source->loadFrame(sequence, slot.data);
+
+        pthread_mutex_lock(&source->lock);
+        slot.state = (ret < 0) ? Slot::SLOT_FAILED : Slot::SLOT_READY;
+        pthread_cond_signal(&source->ready_cond);
+        if (ret < 0)
+            break;
+    }
+    pthread_mutex_unlock(&source->lock);
+    return NULL;
+}
+
+int
+NvFrameSource::readFrame(NvBuffer &buffer)
+{
+    const unsigned char *src;
+    uint64_t sequence;
+    uint32_t i, j;
+
+    if (buffer.n_planes != n_planes)
+    {
+        CAT_ERROR_MSG("Buffer does not match the frame layout of " << name);
+        return -1;
+    }
+
+    pthread_mutex_lock(&lock);
+    sequence = next_consume;
+    if (!loop && sequence >= num_frames)
+    {
+        pthread_mutex_unlock(&lock);
+        return -1;
+    }
+
+    Slot &slot = slots[sequence % slots.size()];
+    if (slot.sequence != sequence ||
+            (slot.state != Slot::SLOT_READY && slot.state != Slot::SLOT_FAILED))
+    {
+        uint64_t start = get_time_usec();
+        uint64_t waited;
+
+        do
+        {
+            pthread_cond_wait(&ready_cond, &lock);
+        }
+        while (slot.sequence != sequence ||
+               (slot.state != Slot::SLOT_READY &&
+                slot.state != Slot::SLOT_FAILED));
+
+        waited = get_time_usec() - start;
+        stats.starvation_count++;
+        stats.starvation_time_usec += waited;
+        if (waited > stats.max_starvation_usec)
+            stats.max_starvation_usec = waited;
+    }
+    if (slot.state == Slot::SLOT_FAILED)
+    {
+        is_in_error = true;
+        pthread_mutex_unlock(&lock);
+        return -1;
+    }
+    pthread_mutex_unlock(&lock);
+
+    /* The slot stays ready until it is released below, no lock needed. */
+    src = slot.data;
+    for (i = 0; i < n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = buffer.planes[i];
+        unsigned char *dst = plane.data;
+
+        if (plane.fmt.stride == row_bytes[i])
+        {
+            memcpy(dst, src, (size_t) row_bytes[i] * plane_height[i]);
+            src += (size_t) row_bytes[i] * plane_height[i];
+        }
+        else
+        {
+            for (j = 0; j < plane_height[i]; j++)
+            {
+                memcpy(dst, src, row_bytes[i]);
+                dst += plane.fmt.stride;
+                src += row_bytes[i];
+            }
+        }
+        plane.bytesused = plane.fmt.stride * plane.fmt.height;
+    }
+
+    pthread_mutex_lock(&lock);
+    slot.state = Slot::SLOT_FREE;
+    if (loop && sequence > 0 && sequence % num_frames == 0)
+        stats.num_loops++;
+    stats.frames_read++;
+    next_consume++;
+    pthread_cond_broadcast(&load_cond);
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+void
+NvFrameSource::getStats(NvFrameSourceStats &stats)
+{
+    pthread_mutex_lock(&lock);
+    stats = this->stats;
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvFrameSource::printStats(std::ostream &out_stream)
+{
+    NvFrameSourceStats data;
+
+    getStats(data);
+    out_stream << "----------- Frame source = " << name << " -----------" <<
+        std::endl;
+    out_stream << "Frames read = " << data.frames_read << std::endl;
+    out_stream << "Read-ahead depth = " << slots.size() << " frames, " <<
+        threads.size() << " threads" << std::endl;
+    out_stream << "Starvation events = " << data.starvation_count << std::endl;
+    out_stream << "Total starvation time(usec) = " <<
+        data.starvation_time_usec << std::endl;
+    out_stream << "Maximum starvation time(usec) = " <<
+        data.max_starvation_usec << std::endl;
+    if (loop)
+    {
+        out_stream << "Input loops = " << data.num_loops << std::endl;
+    }
+    out_stream << "-------------------------------------" << std::endl;
+}
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvIvfReader.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CAT_NAME "IvfReader"
+
+#define IVF_FILE_HDR_SIZE   32
+#define IVF_FRAME_HDR_SIZE  12
+
+#define IVF_FOURCC_VP8  v4l2_fourcc('V', 'P', '8', '0')
+#define IVF_FOURCC_VP9  v4l2_fourcc('V', 'P', '9', '0')
+#define IVF_FOURCC_AV1  v4l2_fourcc('A', 'V', '0', '1')
+
+#define AV1_OBU_SEQUENCE_HEADER 1
+
+static inline uint16_t
+read_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t
+read_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint64_t
+read_le64(const uint8_t *p)
+{
+    return read_le32(p) | ((uint64_t) read_le32(p + 4) << 32);
+}
+
+NvIvfReader::NvIvfReader(const char *file_path)
+{
+    struct stat st;
+    void *addr;
+
+    fd = -1;
+    data = NULL;
+    size = 0;
+    header_size = 0;
+    fourcc = 0;
+    width = 0;
+    height = 0;
+    timebase_den = 0;
+    timebase_num = 0;
+    current = 0;
+    is_in_error = false;
+
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    if (fstat(fd, &st) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not stat " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    size = st.st_size;
+    if (size < IVF_FILE_HDR_SIZE)
+    {
+        CAT_ERROR_MSG(file_path << " is too small for an IVF file header");
+        size = 0;
+        is_in_error = true;
+        return;
+    }
+
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        CAT_SYS_ERROR_MSG("Could not map " << file_path);
+        size = 0;
+        is_in_error = true;
+        return;
+    }
+    data = (const uint8_t *) addr;
+
+    /* Both the index pass and the frame reads walk the file front to back. */
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    if (memcmp(data, "DKIF", 4) != 0)
+    {
+        CAT_ERROR_MSG(file_path << " is not a valid IVF file");
+        is_in_error = true;
+        return;
+    }
+
+    header_size = read_le16(data + 6);
+    if (read_le16(data + 4) != 0 || header_size < IVF_FILE_HDR_SIZE ||
+            header_size > size)
+    {
+        CAT_ERROR_MSG("Unsupported IVF version " << read_le16(data + 4) <<
+                " or header size " << header_size << " in " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    fourcc = read_le32(data + 8);
+    width = read_le16(data + 12);
+    height = read_le16(data + 14);
+    timebase_den = read_le32(data + 16);
+    timebase_num = read_le32(data + 20);
+
+    buildIndex();
+    CAT_DEBUG_MSG("Indexed " << frames.size() << " frames of " << width <<
+            "x" << height << " in " << file_path);
+}
+
+NvIvfReader *
+NvIvfReader::createIvfReader(const char *file_path)
+{
+    NvIvfReader *reader = new NvIvfReader(file_path);
+    if (reader->is_in_error)
+    {
+        delete reader;
+        return NULL;
+    }
+    return reader;
+}
+
+NvIvfReader::~NvIvfReader()
+{
+    if (data)
+    {
+        munmap((void *) data, size);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool
+NvIvfReader::isKeyFrame(uint32_t fourcc, const uint8_t *frame, uint32_t size)
+{
+    if (size == 0)
+    {
+        return false;
+    }
+
+    if (fourcc == IVF_FOURCC_VP8)
+    {
+        /* key_frame is bit 0 of the frame tag, 0 for key frames. */
+        return (frame[0] & 0x01) == 0;
+    }
+
+    if (fourcc == IVF_FOURCC_VP9)
+    {
+        /* frame_marker(2), profile_low_bit(1), profile_high_bit(1),
+           reserved_zero(1) for profile 3, show_existing_frame(1),
+           frame_type(1) with 0 for key frames. */
+        uint8_t b = frame[0];
+        int bit = 4;
+
+        if ((b >> 6) != 2)
+        {
+            return false;
+        }
+        if (((b >> 5) & 1) && ((b >> 4) & 1))
+        {
+            bit--;
+        }
+        if ((b >> (bit - 1)) & 1)
+        {
+            /* show_existing_frame */
+            return false;
+        }
+        return ((b >> (bit - 2)) & 1) == 0;
+    }
+
+    if (fourcc == IVF_FOURCC_AV1)
+    {
+        const uint8_t *p = frame;
+        const uint8_t *end = frame + size;
+
+        /* Walk the OBUs of the temporal unit looking for a sequence header. */
+        while (p < end)
+        {
+            uint8_t header = *p++;
+            uint64_t obu_size = 0;
+            int shift = 0;
+
+            if (((header >> 3) & 0x0F) == AV1_OBU_SEQUENCE_HEADER)
+            {
+                return true;
+            }
+            if (header & 0x04)
+            {
+                /* obu_extension_flag */
+                p++;
+            }
+            if (!(header & 0x02))
+            {
+                /* No obu_size, the OBU extends to the end of the unit. */
+                break;
+            }
+            /* obu_size is leb128 coded. */
+            while (p < end && shift < 56)
+            {
+                uint8_t byte = *p++;
+                obu_size |= (uint64_t) (byte & 0x7F) << shift;
+                shift += 7;
+                if (!(byte & 0x80))
+                {
+                    break;
+                }
+            }
+            if (obu_size > (uint64_t) (end - p))
+            {
+                break;
+            }
+            p += obu_size;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+void
+NvIvfReader::buildIndex()
+{
+    const uint8_t *p = data + header_size;
+    const uint8_t *end = data + size;
+
+    /* The file header may announce the number of frames. */
+    frames.reserve(read_le32(data + 24) + 1);
+
+    while (end - p >= IVF_FRAME_HDR_SIZE)
+    {
+        NvIvfFrame frame;
+
+        frame.size = read_le32(p);
+        frame.pts = read_le64(p + 4);
+        frame.offset = (p + IVF_FRAME_HDR_SIZE) - data;
+        if (frame.size > (uint64_t) (end - p - IVF_FRAME_HDR_SIZE))
+        {
+            CAT_WARN_MSG("Dropping truncated frame " << frames.size() <<
+                    " at offset " << frame.offset);
+            return;
+        }
+        frame.key_frame = isKeyFrame(fourcc, data + frame.offset, frame.size);
+        frames.push_back(frame);
+        p += IVF_FRAME_HDR_SIZE + frame.size;
+    }
+
+    if (p != end)
+    {
+        CAT_WARN_MSG("Ignoring " << (end - p) << " trailing bytes");
+    }
+}
+
+const uint8_t *
+NvIvfReader::getNextFrame(uint32_t &frame_size, const NvIvfFrame **frame)
+{
+    if (frame)
+    {
+        *frame = NULL;
+    }
+
+    if (current >= frames.size())
+    {
+        frame_size = 0;
+        rewind();
+        return NULL;
+    }
+
+    const NvIvfFrame &entry = frames[current++];
+    frame_size = entry.size;
+    if (frame)
+    {
+        *frame = &entry;
+    }
+    return data + entry.offset;
+}
+
+int
+NvIvfReader::readNextFrame(NvBuffer *buffer, const NvIvfFrame **frame)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+
+    if (frame)
+    {
+        *frame = NULL;
+    }
+
+    if (current >= frames.size())
+    {
+        plane.bytesused = 0;
+        rewind();
+        return 0;
+    }
+
+    const NvIvfFrame &entry = frames[current];
+    if (entry.size > plane.length)
+    {
+        CAT_ERROR_MSG("Frame " << current << " of size " << entry.size <<
+                " does not fit in buffer of size " << plane.length);
+        plane.bytesused = 0;
+        return -1;
+    }
+
+    memcpy(plane.data, data + entry.offset, entry.size);
+    plane.bytesused = entry.size;
+    current++;
+
+    if (frame)
+    {
+        *frame = &entry;
+    }
+    return 0;
+}
+
+int
+NvIvfReader::seek(uint64_t index)
+{
+    if (index >= frames.size())
+    {
+        CAT_ERROR_MSG("Cannot seek to frame " << index << " of " <<
+                frames.size());
+        return -1;
+    }
+    current = index;
+    return 0;
+}
+
+int64_t
+NvIvfReader::seekToKeyFrame(uint64_t index)
+{
+    uint64_t i;
+
+    if (seek(index) < 0)
+    {
+        return -1;
+    }
+    for (i = index; i > 0 && !frames[i].key_frame; i--)
+    {
+    }
+    current = i;
+    return i;
+}
+
+void
+NvIvfReader::rewind()
+{
+    current = 0;
+}
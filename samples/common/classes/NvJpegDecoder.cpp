@@ -28,14 +28,18 @@
 
 #include "NvJpegDecoder.h"
 #include "NvLogging.h"
+#include "NvTracer.h"
 #include <string.h>
 #include <malloc.h>
+#include <time.h>
+#include <atomic>
 #include "unistd.h"
 #include "stdlib.h"
 #include "nvbufsurface.h"
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define ROUND_UP_4(num)  (((num) + 3) & ~3)
+#define ROUND_UP(num, align) (((num) + (align) - 1) / (align) * (align))
 
 #define CAT_NAME "JpegDecoder"
 
@@ -45,6 +49,9 @@ NvJPEGDecoder::NvJPEGDecoder(const char *comp_name)
     memset(&cinfo, 0, sizeof(cinfo));
     memset(&jerr, 0, sizeof(jerr));
     cinfo.err = jpeg_std_error(&jerr);
+    buffer_pool = NULL;
+    scratch = NULL;
+    scratch_size = 0;
 
     jpeg_create_decompress(&cinfo);
 }
@@ -63,6 +70,11 @@ NvJPEGDecoder::createJPEGDecoder(const char *comp_name)
 
 NvJPEGDecoder::~NvJPEGDecoder()
 {
+    for (size_t i = 0; i < batch_decoders.size(); i++)
+    {
+        delete batch_decoders[i];
+    }
+    delete[] scratch;
     jpeg_destroy_decompress(&cinfo);
     CAT_DEBUG_MSG(comp_name << " (" << this << ") destroyed");
 }
@@ -75,6 +87,7 @@ NvJPEGDecoder::decodeToFd(int &fd, unsigned char * in_buf,
     uint32_t pixel_format = 0;
     uint32_t buffer_id;
     NvBufSurface surface;
+    NvTraceScope trace("decodeToFd", comp_name);
 
     if (in_buf == NULL || in_buf_size == 0)
     {
@@ -98,28 +111,7 @@ NvJPEGDecoder::decodeToFd(int &fd, unsigned char * in_buf,
     cinfo.is_deepstream = TRUE;
     cinfo.pVendor_buf = (unsigned char*)&surface;
 
-    if (cinfo.comp_info[0].h_samp_factor == 2)
-    {
-        if (cinfo.comp_info[0].v_samp_factor == 2)
-        {
-            pixel_format = V4L2_PIX_FMT_YUV420M;
-        }
-        else
-        {
-            pixel_format = V4L2_PIX_FMT_YUV422M;
-        }
-    }
-    else
-    {
-        if (cinfo.comp_info[0].v_samp_factor == 1)
-        {
-            pixel_format = V4L2_PIX_FMT_YUV444M;
-        }
-        else
-        {
-            pixel_format = V4L2_PIX_FMT_YUV422RM;
-        }
-    }
+    pixel_format = getPixelFormat();
 
     jpeg_start_decompress (&cinfo);
     if ((cinfo.output_width % (cinfo.max_h_samp_factor * DCTSIZE))
@@ -156,6 +148,7 @@ NvJPEGDecoder::decodeToBuffer(NvBuffer ** buffer, unsigned char * in_buf,
     NvBuffer *out_buf = NULL;
     uint32_t pixel_format = 0;
     uint32_t buffer_id;
+    NvTraceScope trace("decodeToBuffer", comp_name);
 
     if (buffer == NULL)
     {
@@ -179,33 +172,27 @@ NvJPEGDecoder::decodeToBuffer(NvBuffer ** buffer, unsigned char * in_buf,
 
     cinfo.out_color_space = JCS_YCbCr;
 
-    if (cinfo.comp_info[0].h_samp_factor == 2)
+    pixel_format = getPixelFormat();
+
+    if (buffer_pool)
     {
-        if (cinfo.comp_info[0].v_samp_factor == 2)
+        out_buf = buffer_pool->acquire(pixel_format, cinfo.image_width,
+                cinfo.image_height);
+        if (!out_buf)
         {
-            pixel_format = V4L2_PIX_FMT_YUV420M;
-        }
-        else
-        {
-            pixel_format = V4L2_PIX_FMT_YUV422M;
+            COMP_ERROR_MSG("Could not get buffer from pool");
+            jpeg_abort_decompress(&cinfo);
+            profiler.finishProcessing(buffer_id, false);
+            return -1;
         }
     }
     else
     {
-        if (cinfo.comp_info[0].v_samp_factor == 1)
-        {
-            pixel_format = V4L2_PIX_FMT_YUV444M;
-        }
-        else
-        {
-            pixel_format = V4L2_PIX_FMT_YUV422RM;
-        }
+        out_buf = new NvBuffer(pixel_format, cinfo.image_width,
+                cinfo.image_height, 0);
+        out_buf->allocateMemory();
     }
 
-    out_buf = new NvBuffer(pixel_format, cinfo.image_width,
-            cinfo.image_height, 0);
-    out_buf->allocateMemory();
-
     cinfo.do_fancy_upsampling = FALSE;
     cinfo.do_block_smoothing = FALSE;
     cinfo.out_color_space = cinfo.jpeg_color_space;
@@ -269,6 +256,7 @@ NvJPEGDecoder::decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format)
     unsigned char *base[3] = { NULL, };
     unsigned char *last[3] = { NULL, };
     int stride[3];
+    int copy[3];
     int width, height;
     int r_v, r_h, width_32, read_rows;
 
@@ -285,10 +273,22 @@ NvJPEGDecoder::decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format)
         last[i] = base[i] + (stride[i] * (out_buf->planes[i].fmt.height - 1));
     }
     width_32 = (width + 31) & 0xFFFFFFE0;
+    for (i = 0; i < 3; i++)
+    {
+        copy[i] = stride[i] < width_32 ? stride[i] : width_32;
+    }
+
+    /* The row buffers are kept from one image to the next. */
+    if (scratch_size < (size_t) 3 * read_rows * width_32)
+    {
+        delete[] scratch;
+        scratch_size = (size_t) 3 * read_rows * width_32;
+        scratch = new unsigned char [scratch_size];
+    }
     for (i = 0; i < read_rows; i++) {
-        y_rows[i] = new unsigned char [width_32];
-        u_rows[i] = new unsigned char [width_32];
-        v_rows[i] = new unsigned char [width_32];
+        y_rows[i] = scratch + i * width_32;
+        u_rows[i] = scratch + (read_rows + i) * width_32;
+        v_rows[i] = scratch + (2 * read_rows + i) * width_32;
     }
     for (i = 0; i < height; i += read_rows)
     {
@@ -300,7 +300,7 @@ NvJPEGDecoder::decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format)
                 if (base[0] <= last[0])
                 {
                     memcpy ((void*)base[0], (void*)y_rows[j],
-                        stride[0]*sizeof(unsigned char));
+                        copy[0]*sizeof(unsigned char));
                     base[0] += stride[0];
                 }
                 if (r_v == 2)
@@ -308,7 +308,7 @@ NvJPEGDecoder::decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format)
                     if (base[0] <= last[0])
                     {
                         memcpy ((void*)base[0], (void*)y_rows[j + 1],
-                            stride[0]*sizeof(unsigned char));
+                            copy[0]*sizeof(unsigned char));
                         base[0] += stride[0];
                     }
                 }
@@ -319,9 +319,9 @@ NvJPEGDecoder::decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format)
                         || pixel_format == V4L2_PIX_FMT_YUV422RM)
                     {
                         memcpy ((void*)base[1], (void*)u_rows[k],
-                            stride[1]*sizeof(unsigned char));
+                            copy[1]*sizeof(unsigned char));
                         memcpy ((void*)base[2], (void*)v_rows[k],
-                            stride[2]*sizeof(unsigned char));
+                            copy[2]*sizeof(unsigned char));
                     }
                 }
                 if (r_v == 2 || (k & 1) != 0 ||
@@ -337,12 +337,6 @@ NvJPEGDecoder::decodeIndirect(NvBuffer *out_buf, uint32_t pixel_format)
             COMP_ERROR_MSG("jpeg_read_raw_data() returned 0");
         }
     }
-    for (i = 0; i < read_rows; i++)
-    {
-        delete[] y_rows[i];
-        delete[] u_rows[i];
-        delete[] v_rows[i];
-    }
 }
 
 void
@@ -364,9 +358,11 @@ NvJPEGDecoder::decodeDirect(NvBuffer *out_buf, uint32_t pixel_format)
     for (i = 0; i < 3; i++)
     {
         v_samp[i] = cinfo.comp_info[i].v_samp_factor;
-        stride[i] = out_buf->planes[i].fmt.width;
+        stride[i] = out_buf->planes[i].fmt.stride;
         base[i] = out_buf->planes[i].data;
-        last[i] = base[i] + (stride[i] * (out_buf->planes[i].fmt.height - 1));
+        /* Rows past the image land in the padding of batch buffers. */
+        last[i] = base[i] + (stride[i] *
+                (out_buf->planes[i].length / stride[i] - 1));
     }
 
     for (i = 0; i < (int) cinfo.image_height; i += v_samp[0] * DCTSIZE)
@@ -414,3 +410,280 @@ NvJPEGDecoder::decodeDirect(NvBuffer *out_buf, uint32_t pixel_format)
         }
     }
 }
+
+void
+NvJPEGDecoder::setBufferPool(NvBufferPool *pool)
+{
+    buffer_pool = pool;
+}
+
+uint32_t
+NvJPEGDecoder::getPixelFormat()
+{
+    if (cinfo.comp_info[0].h_samp_factor == 2)
+    {
+        if (cinfo.comp_info[0].v_samp_factor == 2)
+        {
+            return V4L2_PIX_FMT_YUV420M;
+        }
+        return V4L2_PIX_FMT_YUV422M;
+    }
+    if (cinfo.comp_info[0].v_samp_factor == 1)
+    {
+        return V4L2_PIX_FMT_YUV444M;
+    }
+    return V4L2_PIX_FMT_YUV422RM;
+}
+
+/**
+ * Holds the state shared by the threads of a decodeBatch call.
+ */
+typedef struct
+{
+    NvJPEGDecodeJob *jobs;
+    uint32_t count;
+    std::atomic<uint32_t> next;     /**< Next image to decode. */
+    std::atomic<bool> failed;       /**< Set if an image failed. */
+} NvJPEGDecodeBatch;
+
+/**
+ * Holds a decompressor of a decodeBatch call.
+ */
+typedef struct
+{
+    NvJPEGDecoder *decoder;
+    NvJPEGDecodeBatch *batch;
+} NvJPEGDecodeBatchWorker;
+
+int
+NvJPEGDecoder::decodeBatch(NvJPEGDecodeJob *jobs, uint32_t count,
+        uint32_t num_decompressors)
+{
+    std::vector<NvJPEGDecodeBatchWorker> workers;
+    std::vector<pthread_t> threads;
+    NvJPEGDecodeBatch batch;
+    uint32_t i;
+
+    if (jobs == NULL && count)
+    {
+        COMP_ERROR_MSG("Not decoding because jobs = NULL");
+        return -1;
+    }
+
+    if (num_decompressors > count)
+    {
+        num_decompressors = count;
+    }
+    if (num_decompressors == 0)
+    {
+        num_decompressors = 1;
+    }
+
+    while (batch_decoders.size() + 1 < num_decompressors)
+    {
+        NvJPEGDecoder *decoder = createJPEGDecoder(comp_name);
+        if (!decoder)
+        {
+            COMP_WARN_MSG("Could not create decompressor, using " <<
+                    batch_decoders.size() + 1);
+            num_decompressors = batch_decoders.size() + 1;
+            break;
+        }
+        batch_decoders.push_back(decoder);
+    }
+
+    batch.jobs = jobs;
+    batch.count = count;
+    batch.next = 0;
+    batch.failed = false;
+
+    workers.resize(num_decompressors);
+    for (i = 0; i < num_decompressors; i++)
+    {
+        workers[i].decoder = i ? batch_decoders[i - 1] : this;
+        workers[i].decoder->buffer_pool = buffer_pool;
+        workers[i].batch = &batch;
+    }
+
+    /* The calling thread decodes too, with this decompressor. */
+    for (i = 1; i < num_decompressors; i++)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, batchThread, &workers[i]) != 0)
+        {
+            COMP_WARN_MSG("Could not create decode thread " << i);
+            break;
+        }
+        threads.push_back(thread);
+    }
+    batchThread(&workers[0]);
+
+    for (i = 0; i < threads.size(); i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    return batch.failed ? -1 : 0;
+}
+
+void *
+NvJPEGDecoder::batchThread(void *arg)
+{
+    NvJPEGDecodeBatchWorker *worker = (NvJPEGDecodeBatchWorker *) arg;
+    NvJPEGDecodeBatch *batch = worker->batch;
+    uint32_t i;
+
+    while ((i = batch->next++) < batch->count)
+    {
+        if (worker->decoder->decodeJob(batch->jobs[i]) < 0)
+        {
+            batch->failed = true;
+        }
+    }
+    return NULL;
+}
+
+int
+NvJPEGDecoder::prepareBatchBuffer(NvJPEGDecodeJob &job, uint32_t pixel_format)
+{
+    NvBuffer::NvBufferPlaneFormat padded[MAX_PLANES];
+    NvBuffer::NvBufferPlaneFormat image[MAX_PLANES];
+    uint32_t mcu_width = cinfo.max_h_samp_factor * DCTSIZE;
+    uint32_t mcu_height = cinfo.max_v_samp_factor * DCTSIZE;
+    uint32_t padded_width = ROUND_UP(cinfo.image_width, mcu_width);
+    uint32_t padded_height = ROUND_UP(cinfo.image_height, mcu_height);
+    uint32_t n_planes;
+    uint32_t i;
+    bool fits;
+
+    if (NvBuffer::fill_buffer_plane_format(&n_planes, padded, padded_width,
+                padded_height, pixel_format) < 0 ||
+        NvBuffer::fill_buffer_plane_format(&n_planes, image,
+                cinfo.image_width, cinfo.image_height, pixel_format) < 0)
+    {
+        return -1;
+    }
+
+    fits = job.buffer && job.buffer->memory_type == V4L2_MEMORY_USERPTR &&
+        job.buffer->n_planes == n_planes;
+    for (i = 0; fits && i < n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = job.buffer->planes[i];
+
+        fits = plane.data && plane.fmt.stride >= padded[i].width &&
+            plane.length >= (size_t) plane.fmt.stride * padded[i].height;
+    }
+
+    if (!fits)
+    {
+        delete job.buffer;
+        job.buffer = new NvBuffer(pixel_format, padded_width, padded_height,
+                0, buffer_pool);
+        if (job.buffer->allocateMemory() < 0)
+        {
+            COMP_ERROR_MSG("Could not allocate " << padded_width << "x" <<
+                    padded_height << " buffer");
+            delete job.buffer;
+            job.buffer = NULL;
+            return -1;
+        }
+    }
+
+    /* The planes describe the image, the stride keeps the padding. */
+    for (i = 0; i < n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = job.buffer->planes[i];
+
+        plane.fmt.width = image[i].width;
+        plane.fmt.height = image[i].height;
+        plane.bytesused = plane.fmt.stride * image[i].height;
+    }
+    return 0;
+}
+
+int
+NvJPEGDecoder::decodeJob(NvJPEGDecodeJob &job)
+{
+    struct timespec start;
+    struct timespec end;
+    uint32_t pixel_format;
+    uint32_t buffer_id;
+    NvTraceScope trace("decodeBatch", comp_name);
+
+    job.status = -1;
+    job.decode_time_us = 0;
+
+    if (job.in_buf == NULL || job.in_buf_size == 0)
+    {
+        COMP_ERROR_MSG("Not decoding because input buffer = NULL or size = 0");
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    buffer_id = profiler.startProcessing();
+
+    jpeg_mem_src(&cinfo, job.in_buf, job.in_buf_size);
+    cinfo.out_color_space = JCS_YCbCr;
+
+    (void) jpeg_read_header(&cinfo, TRUE);
+
+    cinfo.out_color_space = JCS_YCbCr;
+
+    if (cinfo.num_components != 3)
+    {
+        COMP_ERROR_MSG("Unsupported number of components " <<
+                cinfo.num_components);
+        jpeg_abort_decompress(&cinfo);
+        profiler.finishProcessing(buffer_id, false);
+        return -1;
+    }
+
+    pixel_format = getPixelFormat();
+    if (prepareBatchBuffer(job, pixel_format) < 0)
+    {
+        jpeg_abort_decompress(&cinfo);
+        profiler.finishProcessing(buffer_id, false);
+        return -1;
+    }
+
+    cinfo.do_fancy_upsampling = FALSE;
+    cinfo.do_block_smoothing = FALSE;
+    cinfo.out_color_space = cinfo.jpeg_color_space;
+    cinfo.dct_method = JDCT_FASTEST;
+    cinfo.bMeasure_ImageProcessTime = FALSE;
+    cinfo.raw_data_out = TRUE;
+    jpeg_start_decompress (&cinfo);
+
+    /* With planes padded to whole MCUs, jpeglib writes its rows straight
+     * into the buffer whatever the width. decodeDirect only lays out
+     * chroma that is not subsampled vertically below the luma rows, so
+     * vertically subsampled 4:2:2 still goes through the copy. */
+    if (pixel_format == V4L2_PIX_FMT_YUV422RM
+            || cinfo.comp_info[1].h_samp_factor != 1
+            || cinfo.comp_info[1].v_samp_factor != 1
+            || cinfo.comp_info[2].h_samp_factor != 1
+            || cinfo.comp_info[2].v_samp_factor != 1)
+    {
+        COMP_DEBUG_MSG("indirect decoding using extra buffer copy");
+        decodeIndirect(job.buffer, pixel_format);
+    }
+    else
+    {
+        decodeDirect(job.buffer, pixel_format);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+
+    job.pixfmt = pixel_format;
+    job.width = cinfo.image_width;
+    job.height = cinfo.image_height;
+    job.status = 0;
+
+    profiler.finishProcessing(buffer_id, false);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    job.decode_time_us = (end.tv_sec - start.tv_sec) * 1000000ULL +
+        (end.tv_nsec - start.tv_nsec) / 1000;
+    return 0;
+}
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvJpegEncodePool.h"
+#include "NvLogging.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CAT_NAME "JpegEncodePool"
+
+NvJpegEncodePool *
+NvJpegEncodePool::createJpegEncodePool(const char *name, uint32_t num_encoders,
+        uint32_t max_in_flight, unsigned long out_buf_size,
+        DeliverCallback callback, void *arg)
+{
+    NvJpegEncodePool *pool;
+
+    if (!callback)
+    {
+        CAT_ERROR_MSG("A delivery callback is required");
+        return NULL;
+    }
+
+    pool = new NvJpegEncodePool(name, num_encoders, max_in_flight,
+            out_buf_size, callback, arg);
+    if (pool->isInError())
+    {
+        delete pool;
+        return NULL;
+    }
+    return pool;
+}
+
+NvJpegEncodePool::NvJpegEncodePool(const char *name, uint32_t num_encoders,
+        uint32_t max_in_flight, unsigned long out_buf_size,
+        DeliverCallback callback, void *arg)
+        :callback(callback),
+         callback_arg(arg),
+         next_submit(0),
+         next_encode(0),
+         next_deliver(0),
+         delivering(false),
+         stop(false),
+         is_in_error(false)
+{
+    uint32_t i;
+
+    if (num_encoders == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_encoders = cpus > 0 ? cpus : 1;
+    }
+    if (max_in_flight == 0)
+    {
+        max_in_flight = 2 * num_encoders;
+    }
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&work_cond, NULL);
+    pthread_cond_init(&slot_cond, NULL);
+
+    slots.resize(max_in_flight);
+    for (i = 0; i < max_in_flight; i++)
+    {
+        memset(&slots[i], 0, sizeof(Slot));
+        if (out_buf_size)
+        {
+            slots[i].out_buf = (unsigned char *) malloc(out_buf_size);
+            slots[i].out_buf_size = slots[i].out_buf ? out_buf_size : 0;
+        }
+    }
+
+    /* The encoders keep pointers to their names. */
+    encoder_names.reserve(num_encoders);
+    for (i = 0; i < num_encoders; i++)
+    {
+        encoder_names.push_back(std::string(name) + std::to_string(i));
+
+        NvJPEGEncoder *encoder = NvJPEGEncoder::createJPEGEncoder(
+                encoder_names[i].c_str());
+        if (!encoder)
+        {
+            CAT_ERROR_MSG("Could not create encoder " << encoder_names[i]);
+            is_in_error = true;
+            return;
+        }
+        encoders.push_back(encoder);
+    }
+
+    workers.resize(num_encoders);
+    for (i = 0; i < num_encoders; i++)
+    {
+        workers[i].pool = this;
+        workers[i].encoder = encoders[i];
+        if (pthread_create(&workers[i].thread, NULL, workerThread,
+                    &workers[i]) != 0)
+        {
+            CAT_ERROR_MSG("Could not create worker thread " << i);
+            workers.resize(i);
+            is_in_error = true;
+            return;
+        }
+    }
+
+    CAT_DEBUG_MSG(name << ": " << num_encoders << " encoders, " <<
+            max_in_flight << " images in flight");
+}
+
+NvJpegEncodePool::~NvJpegEncodePool()
+{
+    waitPending(0);
+
+    pthread_mutex_lock(&lock);
+    stop = true;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&lock);
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    for (size_t i = 0; i < encoders.size(); i++)
+    {
+        delete encoders[i];
+    }
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        free(slots[i].out_buf);
+    }
+
+    pthread_cond_destroy(&slot_cond);
+    pthread_cond_destroy(&work_cond);
+    pthread_mutex_destroy(&lock);
+}
+
+int
+NvJpegEncodePool::submit(NvJpegEncodeJob *jobs, uint32_t count)
+{
+    if (is_in_error)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&lock);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        /* Back-pressure: a slot is free once its image is delivered. */
+        while (next_submit - next_deliver >= slots.size())
+        {
+            pthread_cond_wait(&slot_cond, &lock);
+        }
+
+        Slot &slot = slots[next_submit % slots.size()];
+
+        jobs[i].sequence = next_submit;
+        slot.job = jobs[i];
+        slot.done = false;
+        next_submit++;
+        pthread_cond_signal(&work_cond);
+    }
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+void
+NvJpegEncodePool::waitPending(uint32_t max_pending)
+{
+    pthread_mutex_lock(&lock);
+    while (next_submit - next_deliver > max_pending)
+    {
+        pthread_cond_wait(&slot_cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvJpegEncodePool::enableProfiling()
+{
+    for (size_t i = 0; i < encoders.size(); i++)
+    {
+        encoders[i]->enableProfiling();
+    }
+}
+
+void
+NvJpegEncodePool::printProfilingStats(std::ostream &out_stream)
+{
+    for (size_t i = 0; i < encoders.size(); i++)
+    {
+        encoders[i]->printProfilingStats(out_stream);
+    }
+}
+
+void *
+NvJpegEncodePool::workerThread(void *arg)
+{
+    Worker *worker = (Worker *) arg;
+    NvJpegEncodePool *pool = worker->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while (!pool->stop && pool->next_encode == pool->next_submit)
+        {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        if (pool->next_encode == pool->next_submit)
+        {
+            break;
+        }
+
+        Slot &slot = pool->slots[pool->next_encode % pool->slots.size()];
+        pool->next_encode++;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool->encode(worker->encoder, slot);
+        pthread_mutex_lock(&pool->lock);
+
+        slot.done = true;
+        pool->deliverLocked();
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void
+NvJpegEncodePool::encode(NvJPEGEncoder *encoder, Slot &slot)
+{
+    NvJpegEncodeJob &job = slot.job;
+    unsigned char *out_buf = slot.out_buf;
+    unsigned long out_buf_size = slot.out_buf_size;
+    int ret;
+
+    if (job.fd != -1)
+    {
+        ret = encoder->encodeFromFd(job.fd, job.color_space, &out_buf,
+                out_buf_size, job.quality);
+    }
+    else if (job.buffer)
+    {
+        ret = encoder->encodeFromBuffer(*job.buffer, job.color_space,
+                &out_buf, out_buf_size, job.quality);
+    }
+    else
+    {
+        CAT_ERROR_MSG("Image " << job.sequence << " has no source");
+        ret = -1;
+    }
+
+    /* libjpeg allocates a larger buffer when the image does not fit. Keep
+       it for the next images of this slot. */
+    if (out_buf && out_buf != slot.out_buf)
+    {
+        free(slot.out_buf);
+        slot.out_buf = out_buf;
+        slot.out_buf_size = out_buf_size;
+    }
+
+    job.status = ret < 0 ? -1 : 0;
+    job.out_buf = ret < 0 ? NULL : out_buf;
+    job.out_buf_size = ret < 0 ? 0 : out_buf_size;
+}
+
+void
+NvJpegEncodePool::deliverLocked()
+{
+    /* Another worker is delivering, it will pick this image up. */
+    if (delivering)
+    {
+        return;
+    }
+
+    delivering = true;
+    while (next_deliver < next_encode)
+    {
+        Slot &slot = slots[next_deliver % slots.size()];
+
+        if (!slot.done)
+        {
+            break;
+        }
+
+        pthread_mutex_unlock(&lock);
+        callback(slot.job, callback_arg);
+        pthread_mutex_lock(&lock);
+
+        slot.done = false;
+        next_deliver++;
+        pthread_cond_broadcast(&slot_cond);
+    }
+    delivering = false;
+}
@@ -28,6 +28,7 @@
 
 #include "NvJpegEncoder.h"
 #include "NvLogging.h"
+#include "NvTracer.h"
 #include <string.h>
 #include <malloc.h>
 
@@ -71,6 +72,7 @@ NvJPEGEncoder::encodeFromFd(int fd, J_COLOR_SPACE color_space,
         int quality)
 {
     uint32_t buffer_id;
+    NvTraceScope trace("encodeFromFd", comp_name);
 
     if (fd == -1)
     {
@@ -127,7 +129,8 @@ NvJPEGEncoder::encodeFromBuffer(NvBuffer & buffer, J_COLOR_SPACE color_space,
         unsigned char **out_buf, unsigned long &out_buf_size,
         int quality)
 {
-    unsigned char **line[3];
+    unsigned char *line_pointers[MAX_CHANNELS][MAX_SAMP_FACTOR * DCTSIZE];
+    unsigned char **line[MAX_CHANNELS];
 
     uint32_t comp_height[MAX_CHANNELS];
     uint32_t comp_width[MAX_CHANNELS];
@@ -145,6 +148,7 @@ NvJPEGEncoder::encodeFromBuffer(NvBuffer & buffer, J_COLOR_SPACE color_space,
 
     uint32_t i, j, k;
     uint32_t buffer_id;
+    NvTraceScope trace("encodeFromBuffer", comp_name);
 
     buffer_id = profiler.startProcessing();
 
@@ -233,8 +237,7 @@ NvJPEGEncoder::encodeFromBuffer(NvBuffer & buffer, J_COLOR_SPACE color_space,
     {
         cinfo.comp_info[i].h_samp_factor = h_samp[i];
         cinfo.comp_info[i].v_samp_factor = v_samp[i];
-        line[i] = (unsigned char **) malloc(v_max_samp * DCTSIZE *
-                sizeof(unsigned char *));
+        line[i] = line_pointers[i];
     }
 
     for (i = 0; i < channels; i++)
@@ -269,10 +272,6 @@ NvJPEGEncoder::encodeFromBuffer(NvBuffer & buffer, J_COLOR_SPACE color_space,
     }
 
     jpeg_finish_compress(&cinfo);
-    for (i = 0; i < channels; i++)
-    {
-        free(line[i]);
-    }
     COMP_DEBUG_MSG("Succesfully encoded Buffer");
 
     profiler.finishProcessing(buffer_id, false);
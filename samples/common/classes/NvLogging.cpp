@@ -28,6 +28,436 @@
 
 #include "NvLogging.h"
 
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
 int log_level = DEFAULT_LOG_LEVEL;
 
-const char *log_level_name[] = {"INFO", "ERROR", "WARN", "DEBUG"};
\ No newline at end of file
+const char *log_level_name[] = {"INFO", "ERROR", "WARN", "DEBUG"};
+
+/* Longest message, longer ones are truncated. */
+#define LOG_MESSAGE_SIZE 4096
+/* Room kept after a message for the suppressed count and newline. */
+#define LOG_SUFFIX_SIZE 64
+/* Messages logged while formatting another one, by the same thread. */
+#define LOG_MAX_DEPTH 4
+/* Bytes of the ring of each logging thread, a power of two. */
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_RING_WRAP 0xffffffffU
+#define LOG_DRAIN_INTERVAL_MS 10
+
+namespace
+{
+
+/**
+ * Stream buffer over a fixed array. Output past its end is discarded.
+ */
+class LogBuffer : public std::streambuf
+{
+public:
+    LogBuffer()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        setp(data, data + LOG_MESSAGE_SIZE - LOG_SUFFIX_SIZE);
+    }
+
+    /** Appends to the reserved room at the end of the array. */
+    void appendSuffix(const char *str)
+    {
+        size_t len = strlen(str);
+        size_t room = data + LOG_MESSAGE_SIZE - pptr();
+
+        if (len > room)
+        {
+            len = room;
+        }
+        memcpy(pptr(), str, len);
+        setp(pptr() + len, data + LOG_MESSAGE_SIZE);
+    }
+
+    const char *begin() const
+    {
+        return data;
+    }
+
+    size_t length() const
+    {
+        return pptr() - data;
+    }
+
+protected:
+    virtual int_type overflow(int_type c)
+    {
+        return traits_type::not_eof(c);
+    }
+
+private:
+    char data[LOG_MESSAGE_SIZE];
+};
+
+struct LogStream
+{
+    LogBuffer buffer;
+    std::ostream stream;
+    int level;
+
+    LogStream() : stream(&buffer), level(0)
+    {
+    }
+};
+
+/**
+ * Single producer, single consumer ring of the messages of one thread.
+ * Each record is a 32-bit length followed by the message, padded to
+ * 8 bytes. A length of LOG_RING_WRAP skips to the start of the ring.
+ */
+struct LogRing
+{
+    char data[LOG_RING_SIZE];
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> exited;
+};
+
+struct LogThread
+{
+    LogStream *streams[LOG_MAX_DEPTH];
+    int depth;
+    LogRing *ring;
+};
+
+}
+
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_thread_key;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t log_drain_thread;
+static std::atomic<bool> log_async(false);
+static bool log_draining;
+static FILE *log_file;
+static std::vector<LogRing *> *log_rings;
+static uint32_t log_rate;
+static __thread LogThread *log_thread;
+
+static void
+writeRecords(LogRing *ring)
+{
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+
+    while (tail != head)
+    {
+        size_t offset = tail & (LOG_RING_SIZE - 1);
+        uint32_t len;
+
+        memcpy(&len, ring->data + offset, sizeof(len));
+        if (len == LOG_RING_WRAP)
+        {
+            tail += LOG_RING_SIZE - offset;
+            continue;
+        }
+        fwrite(ring->data + offset + sizeof(len), 1, len, log_file);
+        tail += (sizeof(len) + len + 7) & ~7ULL;
+    }
+    ring->tail.store(tail, std::memory_order_release);
+
+    uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped)
+    {
+        fprintf(log_file, "[%s] (%s) <Logging> Dropped %llu messages, the "
+                "ring of the logging thread was full\n",
+                log_level_name[LOG_LEVEL_WARN], __FILE__,
+                (unsigned long long) dropped);
+    }
+}
+
+/**
+ * Writes the pending messages of every thread. Must be called with
+ * log_lock held.
+ */
+static void
+drainRings()
+{
+    for (size_t i = 0; i < log_rings->size();)
+    {
+        LogRing *ring = (*log_rings)[i];
+        bool exited = ring->exited.load(std::memory_order_acquire);
+
+        writeRecords(ring);
+        if (exited)
+        {
+            log_rings->erase(log_rings->begin() + i);
+            delete ring;
+            continue;
+        }
+        i++;
+    }
+    fflush(log_file);
+}
+
+static void *
+drainThread(void *)
+{
+    struct timespec wakeup;
+
+    pthread_setname_np(pthread_self(), "NvLogging");
+    pthread_mutex_lock(&log_lock);
+    while (log_draining)
+    {
+        clock_gettime(CLOCK_REALTIME, &wakeup);
+        wakeup.tv_nsec += LOG_DRAIN_INTERVAL_MS * 1000000L;
+        wakeup.tv_sec += wakeup.tv_nsec / 1000000000L;
+        wakeup.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&log_cond, &log_lock, &wakeup);
+        drainRings();
+    }
+    pthread_mutex_unlock(&log_lock);
+    return NULL;
+}
+
+/**
+ * Writes the last messages when the application exits. Messages logged
+ * afterwards are written synchronously.
+ */
+static void
+stopDrain()
+{
+    log_async.store(false);
+
+    pthread_mutex_lock(&log_lock);
+    log_draining = false;
+    pthread_cond_signal(&log_cond);
+    pthread_mutex_unlock(&log_lock);
+    pthread_join(log_drain_thread, NULL);
+
+    pthread_mutex_lock(&log_lock);
+    drainRings();
+    pthread_mutex_unlock(&log_lock);
+}
+
+static void
+threadExited(void *data)
+{
+    LogThread *thread = (LogThread *) data;
+
+    for (int i = 0; i < LOG_MAX_DEPTH; i++)
+    {
+        delete thread->streams[i];
+    }
+    if (thread->ring)
+    {
+        /* The drain frees the ring once its last messages are written. */
+        thread->ring->exited.store(true, std::memory_order_release);
+    }
+    delete thread;
+    log_thread = NULL;
+}
+
+static void
+initLogging()
+{
+    const char *rate = getenv("NVMM_LOG_RATE");
+    const char *path = getenv("NVMM_LOG_FILE");
+    const char *async = getenv("NVMM_LOG_ASYNC");
+
+    pthread_key_create(&log_thread_key, threadExited);
+
+    if (rate && *rate)
+    {
+        log_rate = strtoul(rate, NULL, 0);
+    }
+
+    if (path && *path)
+    {
+        log_file = fopen(path, "a");
+        if (!log_file)
+        {
+            std::cerr << "[" << log_level_name[LOG_LEVEL_ERROR] << "] (" <<
+                __FILE__ << ") <Logging> Could not open " << path <<
+                ", logging to stderr" << std::endl;
+        }
+    }
+    if (!log_file && async && *async && strcmp(async, "0"))
+    {
+        log_file = stderr;
+    }
+    if (!log_file)
+    {
+        return;
+    }
+
+    log_rings = new std::vector<LogRing *>;
+    log_draining = true;
+    if (pthread_create(&log_drain_thread, NULL, drainThread, NULL))
+    {
+        log_draining = false;
+        return;
+    }
+    atexit(stopDrain);
+    log_async.store(true);
+}
+
+static LogThread *
+getLogThread()
+{
+    if (!log_thread)
+    {
+        log_thread = new LogThread;
+        memset(log_thread, 0, sizeof(*log_thread));
+        pthread_setspecific(log_thread_key, log_thread);
+    }
+    return log_thread;
+}
+
+/**
+ * Copies a message to the ring of the calling thread. Returns false if
+ * the message has to be written synchronously.
+ */
+static bool
+queueMessage(LogThread *thread, const char *message, uint32_t len)
+{
+    if (!log_async.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    if (!thread->ring)
+    {
+        LogRing *ring = new LogRing;
+        ring->head.store(0);
+        ring->tail.store(0);
+        ring->dropped.store(0);
+        ring->exited.store(false);
+
+        pthread_mutex_lock(&log_lock);
+        log_rings->push_back(ring);
+        pthread_mutex_unlock(&log_lock);
+        thread->ring = ring;
+    }
+
+    LogRing *ring = thread->ring;
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    size_t offset = head & (LOG_RING_SIZE - 1);
+    size_t contiguous = LOG_RING_SIZE - offset;
+    size_t needed = (sizeof(len) + len + 7) & ~7ULL;
+    size_t total = contiguous < needed ? contiguous + needed : needed;
+
+    if (LOG_RING_SIZE - (head - tail) < total)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (contiguous < needed)
+    {
+        uint32_t wrap = LOG_RING_WRAP;
+        memcpy(ring->data + offset, &wrap, sizeof(wrap));
+        head += contiguous;
+        offset = 0;
+    }
+    memcpy(ring->data + offset, &len, sizeof(len));
+    memcpy(ring->data + offset + sizeof(len), message, len);
+    ring->head.store(head + needed, std::memory_order_release);
+    return true;
+}
+
+bool
+nvLogAdmit(NvLogSite &site)
+{
+    struct timespec now;
+    uint64_t window;
+
+    pthread_once(&log_once, initLogging);
+    if (!log_rate)
+    {
+        return true;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    window = site.window.load(std::memory_order_relaxed);
+    if (window != (uint64_t) now.tv_sec &&
+        site.window.compare_exchange_strong(window, now.tv_sec))
+    {
+        site.count.store(0, std::memory_order_relaxed);
+    }
+    if (site.count.fetch_add(1, std::memory_order_relaxed) < log_rate)
+    {
+        return true;
+    }
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+std::ostream &
+nvLogBegin(int level, const char *location)
+{
+    LogThread *thread = getLogThread();
+    int depth = thread->depth < LOG_MAX_DEPTH ? thread->depth :
+        LOG_MAX_DEPTH - 1;
+    LogStream *log = thread->streams[depth];
+
+    if (!log)
+    {
+        log = thread->streams[depth] = new LogStream;
+    }
+    thread->depth++;
+
+    /* Each message starts from the default format state, like a new
+       stream would. */
+    log->buffer.reset();
+    log->stream.clear();
+    log->stream.flags(std::ios_base::skipws | std::ios_base::dec);
+    log->stream.precision(6);
+    log->stream.width(0);
+    log->stream.fill(' ');
+    log->level = level;
+
+    log->stream << "[" << log_level_name[level] << "] (" << location << ") ";
+    return log->stream;
+}
+
+void
+nvLogEnd(NvLogSite &site)
+{
+    LogThread *thread = log_thread;
+    int depth;
+    LogStream *log;
+    char suffix[LOG_SUFFIX_SIZE];
+    uint32_t suppressed;
+
+    thread->depth--;
+    depth = thread->depth < LOG_MAX_DEPTH ? thread->depth : LOG_MAX_DEPTH - 1;
+    log = thread->streams[depth];
+
+    suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed)
+    {
+        snprintf(suffix, sizeof(suffix), " [%u similar messages suppressed]\n",
+                suppressed);
+    }
+    else
+    {
+        strcpy(suffix, "\n");
+    }
+    log->buffer.appendSuffix(suffix);
+
+    if (!queueMessage(thread, log->buffer.begin(), log->buffer.length()))
+    {
+        std::cerr.write(log->buffer.begin(), log->buffer.length());
+    }
+    else if (log->level == LOG_LEVEL_ERROR)
+    {
+        /* Errors are written without waiting for the next drain. */
+        pthread_cond_signal(&log_cond);
+    }
+}
@@ -0,0 +1,867 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvMetricsRegistry.h"
+#include "NvApplicationProfiler.h"
+#include "NvElement.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <sstream>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define CAT_NAME "MetricsRegistry"
+
+/* Longest HTTP request header accepted by the server. */
+#define MAX_REQUEST_SIZE 4096
+/* Time a client has to send its request or read the answer. */
+#define CLIENT_TIMEOUT_MS 1000
+
+using namespace std;
+
+static uint64_t
+get_time_usec(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+NvMetricsRegistry::NvMetricsRegistry()
+{
+    next_id = 1;
+    app_profiler = NULL;
+    running = false;
+    interval_ms = 0;
+    window_ms = 0;
+    stop_fd = -1;
+    server_fd = -1;
+    json_file = NULL;
+    snapshot.timestamp_ms = 0;
+    snapshot.window_ms = 0;
+    snapshot.process_cpu_usage = 0;
+    snapshot.has_app_profiler = false;
+    snapshot.app_avg_cpu_usage = 0;
+    snapshot.app_peak_cpu_usage = 0;
+    snapshot.total_stream_fps = 0;
+    pthread_mutex_init(&lock, NULL);
+    pthread_mutex_init(&snapshot_lock, NULL);
+    pthread_mutex_init(&exporter_lock, NULL);
+}
+
+NvMetricsRegistry &
+NvMetricsRegistry::getInstance()
+{
+    /* Never destroyed, elements may be deleted from static destructors. */
+    static NvMetricsRegistry *registry = new NvMetricsRegistry();
+    return *registry;
+}
+
+uint32_t
+NvMetricsRegistry::registerElement(const char *name,
+        NvElementProfiler *profiler)
+{
+    Element element;
+
+    element.name = name ? name : "";
+    element.profiler = profiler;
+    element.output_queued = NULL;
+    element.capture_queued = NULL;
+
+    pthread_mutex_lock(&lock);
+    element.id = next_id++;
+    elements.push_back(element);
+    pthread_mutex_unlock(&lock);
+
+    return element.id;
+}
+
+void
+NvMetricsRegistry::setElementQueues(uint32_t id,
+        const uint32_t *output_queued, const uint32_t *capture_queued)
+{
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        if (elements[i].id == id)
+        {
+            elements[i].output_queued = output_queued;
+            elements[i].capture_queued = capture_queued;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvMetricsRegistry::unregisterElement(uint32_t id)
+{
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        if (elements[i].id == id)
+        {
+            elements.erase(elements.begin() + i);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvMetricsRegistry::registerStream(NvElement *element, const char *stream)
+{
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        if (elements[i].id == element->metrics_id)
+        {
+            elements[i].stream = stream ? stream : "";
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void
+NvMetricsRegistry::setApplicationProfiler(NvApplicationProfiler *profiler)
+{
+    pthread_mutex_lock(&lock);
+    app_profiler = profiler;
+    pthread_mutex_unlock(&lock);
+}
+
+/* Returns the latency under which @a permille of the @a count units of the
+ * histogram fall, in microseconds. */
+static float
+get_histogram_percentile(const vector<uint64_t> &histogram, uint64_t count,
+        uint32_t permille)
+{
+    uint64_t rank = (count * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (size_t bucket = 0; bucket < histogram.size(); bucket++)
+    {
+        seen += histogram[bucket];
+        if (seen >= rank)
+            return NvElementProfiler::getHistogramBucketUsec(bucket);
+    }
+    return 0;
+}
+
+void
+NvMetricsRegistry::sample()
+{
+    NvMetricsSnapshot snap;
+    uint64_t now = get_time_usec(CLOCK_MONOTONIC);
+    uint64_t window_usec = (uint64_t) window_ms * 1000;
+    long num_cpu_cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    snap.timestamp_ms = get_time_usec(CLOCK_REALTIME) / 1000;
+    snap.window_ms = window_ms;
+    snap.process_cpu_usage = 0;
+    snap.has_app_profiler = false;
+    snap.app_avg_cpu_usage = 0;
+    snap.app_peak_cpu_usage = 0;
+    snap.total_stream_fps = 0;
+
+    /* The oldest sample kept is the last one at or before the start of the
+     * window, so that the window is always fully covered. */
+    cpu_window.push_back(make_pair(now,
+                get_time_usec(CLOCK_PROCESS_CPUTIME_ID)));
+    while (cpu_window.size() > 2 && cpu_window[1].first + window_usec <= now)
+    {
+        cpu_window.pop_front();
+    }
+    if (cpu_window.size() > 1 && num_cpu_cores > 0)
+    {
+        snap.process_cpu_usage = (float) (cpu_window.back().second -
+                cpu_window.front().second) * 100 /
+            (cpu_window.back().first - cpu_window.front().first) /
+            num_cpu_cores;
+    }
+
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        Element &element = elements[i];
+        NvElementProfiler::NvElementProfilerData data;
+        NvMetricsElementData metrics;
+        ElementSample cur;
+        vector<uint64_t> histogram(NvElementProfiler::HISTOGRAM_BUCKETS);
+        uint64_t count = 0;
+
+        element.profiler->getProfilerData(data);
+        cur.time_usec = now;
+        cur.total_units = data.total_processed_units;
+        cur.late_units = data.num_late_units;
+        cur.histogram.resize(NvElementProfiler::HISTOGRAM_BUCKETS);
+        element.profiler->getLatencyHistogram(&cur.histogram[0]);
+
+        /* Counters go back when profiling is re-enabled with a reset. */
+        if (!element.window.empty() &&
+                cur.total_units < element.window.back().total_units)
+        {
+            element.window.clear();
+        }
+        element.window.push_back(cur);
+        while (element.window.size() > 2 &&
+                element.window[1].time_usec + window_usec <= now)
+        {
+            element.window.pop_front();
+        }
+        const ElementSample &oldest = element.window.front();
+
+        metrics.name = element.name;
+        metrics.stream = element.stream;
+        metrics.total_units = cur.total_units;
+        metrics.total_late_units = cur.late_units;
+        metrics.window_late_units = cur.late_units - oldest.late_units;
+        metrics.window_fps = 0;
+        if (now > oldest.time_usec)
+        {
+            metrics.window_fps = (float) (cur.total_units -
+                    oldest.total_units) * 1000000 / (now - oldest.time_usec);
+        }
+        metrics.average_fps = data.average_fps;
+
+        metrics.max_latency_usec = 0;
+        for (size_t bucket = 0; bucket < histogram.size(); bucket++)
+        {
+            histogram[bucket] = cur.histogram[bucket] - oldest.histogram[bucket];
+            count += histogram[bucket];
+            if (histogram[bucket])
+            {
+                metrics.max_latency_usec =
+                    NvElementProfiler::getHistogramBucketUsec(bucket);
+            }
+        }
+        metrics.p50_latency_usec = count ?
+            get_histogram_percentile(histogram, count, 500) : 0;
+        metrics.p90_latency_usec = count ?
+            get_histogram_percentile(histogram, count, 900) : 0;
+        metrics.p99_latency_usec = count ?
+            get_histogram_percentile(histogram, count, 990) : 0;
+
+        /* The planes update their counters under their own locks, a
+         * relaxed read is enough for a gauge. */
+        metrics.output_queue_depth = element.output_queued ?
+            __atomic_load_n(element.output_queued, __ATOMIC_RELAXED) : -1;
+        metrics.capture_queue_depth = element.capture_queued ?
+            __atomic_load_n(element.capture_queued, __ATOMIC_RELAXED) : -1;
+
+        if (!metrics.stream.empty())
+        {
+            snap.total_stream_fps += metrics.window_fps;
+        }
+        snap.elements.push_back(metrics);
+    }
+    if (app_profiler)
+    {
+        NvApplicationProfiler::NvAppProfilerData app_data;
+
+        app_profiler->getProfilerData(app_data);
+        snap.has_app_profiler = true;
+        snap.app_avg_cpu_usage = app_data.avg_cpu_usage;
+        snap.app_peak_cpu_usage = app_data.peak_cpu_usage;
+    }
+    pthread_mutex_unlock(&lock);
+
+    pthread_mutex_lock(&snapshot_lock);
+    snapshot.elements.swap(snap.elements);
+    snapshot.timestamp_ms = snap.timestamp_ms;
+    snapshot.window_ms = snap.window_ms;
+    snapshot.process_cpu_usage = snap.process_cpu_usage;
+    snapshot.has_app_profiler = snap.has_app_profiler;
+    snapshot.app_avg_cpu_usage = snap.app_avg_cpu_usage;
+    snapshot.app_peak_cpu_usage = snap.app_peak_cpu_usage;
+    snapshot.total_stream_fps = snap.total_stream_fps;
+    pthread_mutex_unlock(&snapshot_lock);
+}
+
+void
+NvMetricsRegistry::getSnapshot(NvMetricsSnapshot &snapshot)
+{
+    pthread_mutex_lock(&snapshot_lock);
+    snapshot = this->snapshot;
+    pthread_mutex_unlock(&snapshot_lock);
+}
+
+void *
+NvMetricsRegistry::samplerThread(void *arg)
+{
+    NvMetricsRegistry *registry = (NvMetricsRegistry *) arg;
+    uint64_t next_sample = get_time_usec(CLOCK_MONOTONIC);
+    bool stop = false;
+
+    while (!stop)
+    {
+        struct pollfd pfd;
+        uint64_t now = get_time_usec(CLOCK_MONOTONIC);
+        int timeout_ms = 0;
+
+        if (next_sample > now)
+            timeout_ms = (next_sample - now + 999) / 1000;
+
+        pfd.fd = registry->stop_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, timeout_ms) > 0)
+        {
+            /* Take a last sample so that the file ends with the totals. */
+            stop = true;
+        }
+        else if (get_time_usec(CLOCK_MONOTONIC) < next_sample)
+        {
+            continue;
+        }
+
+        registry->sample();
+        next_sample += (uint64_t) registry->interval_ms * 1000;
+
+        if (registry->json_file)
+        {
+            NvMetricsSnapshot snap;
+
+            registry->getSnapshot(snap);
+            writeJson(snap, *registry->json_file);
+            registry->json_file->flush();
+        }
+    }
+    return NULL;
+}
+
+int
+NvMetricsRegistry::openServerSocket(uint16_t http_port,
+        const char *socket_path)
+{
+    int fd;
+
+    if (socket_path)
+    {
+        struct sockaddr_un addr;
+
+        if (strlen(socket_path) >= sizeof(addr.sun_path))
+        {
+            CAT_ERROR_MSG("Socket path " << socket_path << " is too long");
+            return -1;
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            CAT_SYS_ERROR_MSG("Could not create metrics socket");
+            return -1;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, socket_path);
+        /* A previous run may have left its socket behind. */
+        unlink(socket_path);
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+        {
+            CAT_SYS_ERROR_MSG("Could not bind metrics socket to " <<
+                    socket_path);
+            close(fd);
+            return -1;
+        }
+        this->socket_path = socket_path;
+    }
+    else
+    {
+        struct sockaddr_in addr;
+        int reuse = 1;
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            CAT_SYS_ERROR_MSG("Could not create metrics socket");
+            return -1;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(http_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+        {
+            CAT_SYS_ERROR_MSG("Could not bind metrics socket to port " <<
+                    http_port);
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, 16) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not listen on metrics socket");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void
+NvMetricsRegistry::serveRequest(int fd)
+{
+    struct timeval timeout = { 0, CLIENT_TIMEOUT_MS * 1000 };
+    char request[MAX_REQUEST_SIZE + 1];
+    size_t size = 0;
+    const char *status = "200 OK";
+    const char *content_type = "text/plain; version=0.0.4";
+    ostringstream body;
+    ostringstream response;
+    string path;
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    /* Only the request line matters, read until the end of the headers. */
+    while (size < MAX_REQUEST_SIZE)
+    {
+        ssize_t ret = recv(fd, request + size, MAX_REQUEST_SIZE - size, 0);
+
+        if (ret <= 0)
+            break;
+        size += ret;
+        request[size] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+            break;
+    }
+    request[size] = '\0';
+
+    if (strncmp(request, "GET ", 4))
+    {
+        status = "405 Method Not Allowed";
+        body << "Only GET is supported\n";
+    }
+    else
+    {
+        NvMetricsSnapshot snap;
+
+        path.assign(request + 4, strcspn(request + 4, " ?\r\n"));
+        getSnapshot(snap);
+        if (path == "/" || path == "/metrics")
+        {
+            writePrometheus(snap, body);
+        }
+        else if (path == "/metrics.json")
+        {
+            content_type = "application/json";
+            writeJson(snap, body);
+        }
+        else
+        {
+            status = "404 Not Found";
+            body << "Use /metrics or /metrics.json\n";
+        }
+    }
+
+    response << "HTTP/1.0 " << status << "\r\n" <<
+        "Content-Type: " << content_type << "\r\n" <<
+        "Content-Length: " << body.str().size() << "\r\n" <<
+        "Connection: close\r\n\r\n" << body.str();
+
+    string data = response.str();
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t ret = send(fd, data.data() + sent, data.size() - sent,
+                MSG_NOSIGNAL);
+
+        if (ret <= 0)
+            break;
+        sent += ret;
+    }
+}
+
+void *
+NvMetricsRegistry::serverThread(void *arg)
+{
+    NvMetricsRegistry *registry = (NvMetricsRegistry *) arg;
+
+    while (1)
+    {
+        struct pollfd pfds[2];
+        int fd;
+
+        pfds[0].fd = registry->server_fd;
+        pfds[0].events = POLLIN;
+        pfds[1].fd = registry->stop_fd;
+        pfds[1].events = POLLIN;
+        if (poll(pfds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            CAT_SYS_ERROR_MSG("Error while polling metrics socket");
+            break;
+        }
+        if (pfds[1].revents)
+            break;
+
+        fd = accept4(registry->server_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        registry->serveRequest(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+int
+NvMetricsRegistry::startExporter(uint32_t interval_ms, uint32_t window_ms,
+        uint16_t http_port, const char *socket_path,
+        const char *json_file_path)
+{
+    pthread_mutex_lock(&exporter_lock);
+    if (running)
+    {
+        pthread_mutex_unlock(&exporter_lock);
+        return 0;
+    }
+
+    this->interval_ms = interval_ms ? interval_ms : 1000;
+    this->window_ms = window_ms > this->interval_ms ? window_ms :
+        this->interval_ms;
+    cpu_window.clear();
+
+    stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not create eventfd");
+        goto error;
+    }
+
+    if (json_file_path)
+    {
+        json_file = new ofstream(json_file_path, ios::app);
+        if (!json_file->is_open())
+        {
+            CAT_ERROR_MSG("Could not open metrics file " << json_file_path);
+            goto error;
+        }
+    }
+
+    if (http_port || socket_path)
+    {
+        server_fd = openServerSocket(http_port, socket_path);
+        if (server_fd < 0)
+            goto error;
+    }
+
+    if (pthread_create(&sampler, NULL, samplerThread, this))
+    {
+        CAT_ERROR_MSG("Could not create metrics sampler thread");
+        goto error;
+    }
+    pthread_setname_np(sampler, "MetricsSampler");
+
+    if (server_fd >= 0)
+    {
+        if (pthread_create(&server, NULL, serverThread, this))
+        {
+            uint64_t stop = 1;
+
+            CAT_ERROR_MSG("Could not create metrics server thread");
+            if (write(stop_fd, &stop, sizeof(stop)) < 0)
+                CAT_SYS_ERROR_MSG("Could not stop metrics sampler thread");
+            pthread_join(sampler, NULL);
+            goto error;
+        }
+        pthread_setname_np(server, "MetricsServer");
+    }
+
+    running = true;
+    pthread_mutex_unlock(&exporter_lock);
+    CAT_INFO_MSG("Exporting metrics every " << this->interval_ms << " ms");
+    return 0;
+
+error:
+    if (server_fd >= 0)
+    {
+        close(server_fd);
+        server_fd = -1;
+    }
+    if (!this->socket_path.empty())
+    {
+        unlink(this->socket_path.c_str());
+        this->socket_path.clear();
+    }
+    delete json_file;
+    json_file = NULL;
+    if (stop_fd >= 0)
+    {
+        close(stop_fd);
+        stop_fd = -1;
+    }
+    pthread_mutex_unlock(&exporter_lock);
+    return -1;
+}
+
+void
+NvMetricsRegistry::stopExporter()
+{
+    uint64_t stop = 1;
+
+    pthread_mutex_lock(&exporter_lock);
+    if (!running)
+    {
+        pthread_mutex_unlock(&exporter_lock);
+        return;
+    }
+
+    if (write(stop_fd, &stop, sizeof(stop)) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not stop metrics threads");
+    }
+    pthread_join(sampler, NULL);
+    if (server_fd >= 0)
+    {
+        pthread_join(server, NULL);
+        close(server_fd);
+        server_fd = -1;
+    }
+    if (!socket_path.empty())
+    {
+        unlink(socket_path.c_str());
+        socket_path.clear();
+    }
+    delete json_file;
+    json_file = NULL;
+    close(stop_fd);
+    stop_fd = -1;
+    running = false;
+    pthread_mutex_unlock(&exporter_lock);
+}
+
+/* Writes @a str with the escapes that both Prometheus label values and JSON
+ * strings need. */
+static void
+write_escaped(ostream &out_stream, const string &str)
+{
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        switch (str[i])
+        {
+            case '\\':  out_stream << "\\\\"; break;
+            case '"':   out_stream << "\\\""; break;
+            case '\n':  out_stream << "\\n"; break;
+            default:
+                if ((unsigned char) str[i] >= 0x20)
+                    out_stream << str[i];
+        }
+    }
+}
+
+/* JSON has no NaN nor infinities. */
+static float
+finite_or_zero(float value)
+{
+    return isfinite(value) ? value : 0;
+}
+
+static void
+write_labels(ostream &out_stream,
+        const NvMetricsRegistry::NvMetricsElementData &element,
+        const char *extra_label = NULL, const char *extra_value = NULL)
+{
+    out_stream << "{element=\"";
+    write_escaped(out_stream, element.name);
+    out_stream << "\"";
+    if (!element.stream.empty())
+    {
+        out_stream << ",stream=\"";
+        write_escaped(out_stream, element.stream);
+        out_stream << "\"";
+    }
+    if (extra_label)
+    {
+        out_stream << "," << extra_label << "=\"" << extra_value << "\"";
+    }
+    out_stream << "}";
+}
+
+static void
+write_family(ostream &out_stream, const char *name, const char *type,
+        const char *help)
+{
+    out_stream << "# HELP " << name << " " << help << "\n";
+    out_stream << "# TYPE " << name << " " << type << "\n";
+}
+
+void
+NvMetricsRegistry::writePrometheus(const NvMetricsSnapshot &snapshot,
+        ostream &out_stream)
+{
+    const vector<NvMetricsElementData> &elements = snapshot.elements;
+    size_t i;
+
+    write_family(out_stream, "nvmm_element_units_total", "counter",
+            "Units processed by the element.");
+    for (i = 0; i < elements.size(); i++)
+    {
+        out_stream << "nvmm_element_units_total";
+        write_labels(out_stream, elements[i]);
+        out_stream << " " << elements[i].total_units << "\n";
+    }
+
+    write_family(out_stream, "nvmm_element_late_units_total", "counter",
+            "Units that arrived late at the element.");
+    for (i = 0; i < elements.size(); i++)
+    {
+        out_stream << "nvmm_element_late_units_total";
+        write_labels(out_stream, elements[i]);
+        out_stream << " " << elements[i].total_late_units << "\n";
+    }
+
+    write_family(out_stream, "nvmm_element_fps", "gauge",
+            "Units processed per second over the sliding window.");
+    for (i = 0; i < elements.size(); i++)
+    {
+        out_stream << "nvmm_element_fps";
+        write_labels(out_stream, elements[i]);
+        out_stream << " " << finite_or_zero(elements[i].window_fps) << "\n";
+    }
+
+    write_family(out_stream, "nvmm_element_latency_usec", "gauge",
+            "Processing latency percentiles over the sliding window.");
+    for (i = 0; i < elements.size(); i++)
+    {
+        const NvMetricsElementData &element = elements[i];
+
+        out_stream << "nvmm_element_latency_usec";
+        write_labels(out_stream, element, "quantile", "0.5");
+        out_stream << " " << element.p50_latency_usec << "\n";
+        out_stream << "nvmm_element_latency_usec";
+        write_labels(out_stream, element, "quantile", "0.9");
+        out_stream << " " << element.p90_latency_usec << "\n";
+        out_stream << "nvmm_element_latency_usec";
+        write_labels(out_stream, element, "quantile", "0.99");
+        out_stream << " " << element.p99_latency_usec << "\n";
+        out_stream << "nvmm_element_latency_usec";
+        write_labels(out_stream, element, "quantile", "1");
+        out_stream << " " << element.max_latency_usec << "\n";
+    }
+
+    write_family(out_stream, "nvmm_element_queue_depth", "gauge",
+            "Buffers queued on the plane of the element.");
+    for (i = 0; i < elements.size(); i++)
+    {
+        if (elements[i].output_queue_depth >= 0)
+        {
+            out_stream << "nvmm_element_queue_depth";
+            write_labels(out_stream, elements[i], "plane", "output");
+            out_stream << " " << elements[i].output_queue_depth << "\n";
+        }
+        if (elements[i].capture_queue_depth >= 0)
+        {
+            out_stream << "nvmm_element_queue_depth";
+            write_labels(out_stream, elements[i], "plane", "capture");
+            out_stream << " " << elements[i].capture_queue_depth << "\n";
+        }
+    }
+
+    write_family(out_stream, "nvmm_stream_fps_total", "gauge",
+            "Sum of the FPS of all the streams over the sliding window.");
+    out_stream << "nvmm_stream_fps_total " <<
+        finite_or_zero(snapshot.total_stream_fps) << "\n";
+
+    write_family(out_stream, "nvmm_process_cpu_usage_percent", "gauge",
+            "CPU usage of the process over the sliding window, in percent "
+            "of all the cores.");
+    out_stream << "nvmm_process_cpu_usage_percent " <<
+        finite_or_zero(snapshot.process_cpu_usage) << "\n";
+
+    if (snapshot.has_app_profiler)
+    {
+        write_family(out_stream, "nvmm_app_cpu_usage_percent", "gauge",
+                "CPU usage measured by the application profiler.");
+        out_stream << "nvmm_app_cpu_usage_percent{stat=\"average\"} " <<
+            finite_or_zero(snapshot.app_avg_cpu_usage) << "\n";
+        out_stream << "nvmm_app_cpu_usage_percent{stat=\"peak\"} " <<
+            finite_or_zero(snapshot.app_peak_cpu_usage) << "\n";
+    }
+}
+
+void
+NvMetricsRegistry::writeJson(const NvMetricsSnapshot &snapshot,
+        ostream &out_stream)
+{
+    out_stream << "{\"timestamp_ms\":" << snapshot.timestamp_ms <<
+        ",\"window_ms\":" << snapshot.window_ms <<
+        ",\"process_cpu_usage\":" <<
+        finite_or_zero(snapshot.process_cpu_usage) <<
+        ",\"total_stream_fps\":" << finite_or_zero(snapshot.total_stream_fps);
+    if (snapshot.has_app_profiler)
+    {
+        out_stream << ",\"app\":{\"avg_cpu_usage\":" <<
+            finite_or_zero(snapshot.app_avg_cpu_usage) <<
+            ",\"peak_cpu_usage\":" <<
+            finite_or_zero(snapshot.app_peak_cpu_usage) << "}";
+    }
+    out_stream << ",\"elements\":[";
+    for (size_t i = 0; i < snapshot.elements.size(); i++)
+    {
+        const NvMetricsElementData &element = snapshot.elements[i];
+
+        out_stream << (i ? "," : "") << "{\"name\":\"";
+        write_escaped(out_stream, element.name);
+        out_stream << "\"";
+        if (!element.stream.empty())
+        {
+            out_stream << ",\"stream\":\"";
+            write_escaped(out_stream, element.stream);
+            out_stream << "\"";
+        }
+        out_stream << ",\"units\":" << element.total_units <<
+            ",\"late_units\":" << element.total_late_units <<
+            ",\"window_late_units\":" << element.window_late_units <<
+            ",\"fps\":" << finite_or_zero(element.window_fps) <<
+            ",\"average_fps\":" << finite_or_zero(element.average_fps) <<
+            ",\"latency_usec\":{\"p50\":" << element.p50_latency_usec <<
+            ",\"p90\":" << element.p90_latency_usec <<
+            ",\"p99\":" << element.p99_latency_usec <<
+            ",\"max\":" << element.max_latency_usec << "}";
+        if (element.output_queue_depth >= 0 || element.capture_queue_depth >= 0)
+        {
+            out_stream << ",\"queue_depth\":{\"output\":" <<
+                element.output_queue_depth << ",\"capture\":" <<
+                element.capture_queue_depth << "}";
+        }
+        out_stream << "}";
+    }
+    out_stream << "]}" << endl;
+}
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvMjpegReader.h"
+#include "NvLogging.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define CAT_NAME "MjpegReader"
+
+/* Number of bytes consumed by one iteration of the vector scan. */
+#define SCAN_BLOCK_SIZE 16
+
+#define JPEG_MARKER_SOI 0xD8
+#define JPEG_MARKER_EOI 0xD9
+#define JPEG_MARKER_SOS 0xDA
+#define JPEG_MARKER_TEM 0x01
+
+/* RSTn markers may only appear inside entropy-coded data. */
+#define IS_JPEG_MARKER_RST(m) ((m) >= 0xD0 && (m) <= 0xD7)
+/* SOFn markers, excluding DHT, JPG and DAC which share the range. */
+#define IS_JPEG_MARKER_SOF(m) ((m) >= 0xC0 && (m) <= 0xCF && \
+        (m) != 0xC4 && (m) != 0xC8 && (m) != 0xCC)
+
+NvMjpegReader::NvMjpegReader(const char *file_path)
+{
+    struct stat st;
+    void *addr;
+
+    fd = -1;
+    data = NULL;
+    size = 0;
+    current = 0;
+    is_in_error = false;
+
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    if (fstat(fd, &st) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not stat " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    size = st.st_size;
+    if (size == 0)
+    {
+        /* Nothing to index, the reader reports end of stream right away. */
+        return;
+    }
+
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        CAT_SYS_ERROR_MSG("Could not map " << file_path);
+        size = 0;
+        is_in_error = true;
+        return;
+    }
+    data = (const uint8_t *) addr;
+
+    /* Both the index pass and the image reads walk the file front to back. */
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    buildIndex();
+    CAT_DEBUG_MSG("Indexed " << frames.size() << " images in " << file_path);
+}
+
+NvMjpegReader *
+NvMjpegReader::createMjpegReader(const char *file_path)
+{
+    NvMjpegReader *reader = new NvMjpegReader(file_path);
+    if (reader->is_in_error)
+    {
+        delete reader;
+        return NULL;
+    }
+    return reader;
+}
+
+NvMjpegReader::~NvMjpegReader()
+{
+    if (data)
+    {
+        munmap((void *) data, size);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+const uint8_t *
+NvMjpegReader::findMarker(const uint8_t *begin, const uint8_t *end)
+{
+    const uint8_t *p = begin;
+
+#if defined(__SSE2__)
+    const __m128i ff = _mm_set1_epi8((char) 0xFF);
+    const __m128i zero = _mm_setzero_si128();
+
+    /* Each lane i tests p[i] == FF && p[i + 1] != 00 && p[i + 1] != FF. */
+    while (end - p >= SCAN_BLOCK_SIZE + 1)
+    {
+        __m128i b0 = _mm_loadu_si128((const __m128i *) p);
+        __m128i b1 = _mm_loadu_si128((const __m128i *) (p + 1));
+        __m128i match = _mm_andnot_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(b1, zero), _mm_cmpeq_epi8(b1, ff)),
+                _mm_cmpeq_epi8(b0, ff));
+        int mask = _mm_movemask_epi8(match);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += SCAN_BLOCK_SIZE;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t ff = vdupq_n_u8(0xFF);
+    const uint8x16_t zero = vdupq_n_u8(0);
+
+    while (end - p >= SCAN_BLOCK_SIZE + 1)
+    {
+        uint8x16_t b0 = vld1q_u8(p);
+        uint8x16_t b1 = vld1q_u8(p + 1);
+        uint8x16_t match = vbicq_u8(vceqq_u8(b0, ff),
+                vorrq_u8(vceqq_u8(b1, zero), vceqq_u8(b1, ff)));
+        if (vmaxvq_u8(match))
+        {
+            /* Rare case, locate the lane with a scalar scan. */
+            break;
+        }
+        p += SCAN_BLOCK_SIZE;
+    }
+#endif
+
+    while (end - p >= 2)
+    {
+        if (p[0] == 0xFF && p[1] != 0x00 && p[1] != 0xFF)
+        {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+uint32_t
+NvMjpegReader::parseFrame(const uint8_t *begin, const uint8_t *end,
+        uint16_t *width, uint16_t *height)
+{
+    const uint8_t *p = begin + 2;
+    uint32_t length;
+    uint8_t marker;
+
+    if (end - begin < 2 || begin[0] != 0xFF || begin[1] != JPEG_MARKER_SOI)
+    {
+        return 0;
+    }
+
+    while (end - p >= 2)
+    {
+        if (p[0] != 0xFF)
+        {
+            /* Not at a marker, a segment length was wrong. */
+            return 0;
+        }
+        marker = p[1];
+        if (marker == 0xFF)
+        {
+            /* Fill byte. */
+            p++;
+            continue;
+        }
+        if (marker == JPEG_MARKER_EOI)
+        {
+            p += 2;
+            if ((uint64_t) (p - begin) > UINT32_MAX)
+            {
+                return 0;
+            }
+            return p - begin;
+        }
+        if (marker == JPEG_MARKER_SOI || marker == 0x00)
+        {
+            /* The next image starts before this one ended. */
+            return 0;
+        }
+        if (marker == JPEG_MARKER_TEM || IS_JPEG_MARKER_RST(marker))
+        {
+            p += 2;
+            continue;
+        }
+
+        /* Marker segment, the length includes its own two bytes. */
+        if (end - p < 4)
+        {
+            return 0;
+        }
+        length = (p[2] << 8) | p[3];
+        if (length < 2 || (uint64_t) (end - p - 2) < length)
+        {
+            return 0;
+        }
+        if (IS_JPEG_MARKER_SOF(marker) && length >= 7)
+        {
+            if (height)
+            {
+                *height = (p[5] << 8) | p[6];
+            }
+            if (width)
+            {
+                *width = (p[7] << 8) | p[8];
+            }
+        }
+        p += 2 + length;
+
+        if (marker == JPEG_MARKER_SOS)
+        {
+            /* Skip the entropy-coded data, which ends at the first
+               marker that is not a restart marker. */
+            for (;;)
+            {
+                p = findMarker(p, end);
+                if (p == end)
+                {
+                    return 0;
+                }
+                if (!IS_JPEG_MARKER_RST(p[1]))
+                {
+                    break;
+                }
+                p += 2;
+            }
+        }
+    }
+    return 0;
+}
+
+void
+NvMjpegReader::buildIndex()
+{
+    const uint8_t *end = data + size;
+    const uint8_t *p = data;
+
+    /* Rough guess of one image per 64 KiB to limit reallocations. */
+    frames.reserve(size / 65536 + 1);
+
+    for (;;)
+    {
+        NvMjpegFrame frame;
+
+        /* Find the next SOI marker, skipping anything between images. */
+        p = findMarker(p, end);
+        while (p != end && p[1] != JPEG_MARKER_SOI)
+        {
+            p = findMarker(p + 2, end);
+        }
+        if (p == end)
+        {
+            break;
+        }
+
+        frame.offset = p - data;
+        frame.width = 0;
+        frame.height = 0;
+        frame.size = parseFrame(p, end, &frame.width, &frame.height);
+        if (frame.size == 0)
+        {
+            CAT_WARN_MSG("Skipping truncated or corrupted image at offset " <<
+                    frame.offset);
+            p += 2;
+            continue;
+        }
+        frames.push_back(frame);
+        p += frame.size;
+    }
+}
+
+const uint8_t *
+NvMjpegReader::getNextFrame(uint32_t &frame_size, const NvMjpegFrame **frame)
+{
+    if (frame)
+    {
+        *frame = NULL;
+    }
+
+    if (current >= frames.size())
+    {
+        frame_size = 0;
+        rewind();
+        return NULL;
+    }
+
+    const NvMjpegFrame &entry = frames[current++];
+    frame_size = entry.size;
+    if (frame)
+    {
+        *frame = &entry;
+    }
+    return data + entry.offset;
+}
+
+int
+NvMjpegReader::readNextFrame(NvBuffer *buffer, const NvMjpegFrame **frame)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+
+    if (frame)
+    {
+        *frame = NULL;
+    }
+
+    if (current >= frames.size())
+    {
+        plane.bytesused = 0;
+        rewind();
+        return 0;
+    }
+
+    const NvMjpegFrame &entry = frames[current];
+    if (entry.size > plane.length)
+    {
+        CAT_ERROR_MSG("Image " << current << " of size " << entry.size <<
+                " does not fit in buffer of size " << plane.length);
+        plane.bytesused = 0;
+        return -1;
+    }
+
+    memcpy(plane.data, data + entry.offset, entry.size);
+    plane.bytesused = entry.size;
+    current++;
+
+    if (frame)
+    {
+        *frame = &entry;
+    }
+    return 0;
+}
+
+void
+NvMjpegReader::rewind()
+{
+    current = 0;
+}
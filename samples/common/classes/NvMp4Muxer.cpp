@@ -0,0 +1,1309 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvMp4Muxer.h"
+#include "NvBitstreamReader.h"
+#include "NvLogging.h"
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CAT_NAME "Mp4Muxer"
+
+/* Time scale of the video track, in ticks per second. */
+#define MP4_TIMESCALE 90000
+/* Size of the pending samples above which a fragment is written even
+ * without a key frame, for streams with very long or no GOPs. */
+#define MAX_FRAGMENT_SIZE (16 * 1024 * 1024)
+
+#define TRUN_DATA_OFFSET_PRESENT        0x000001
+#define TRUN_SAMPLE_DURATION_PRESENT    0x000100
+#define TRUN_SAMPLE_SIZE_PRESENT        0x000200
+#define TRUN_SAMPLE_FLAGS_PRESENT       0x000400
+#define TRUN_SAMPLE_CTO_PRESENT         0x000800
+#define TFHD_DEFAULT_BASE_IS_MOOF       0x020000
+
+/* sample_depends_on = 2, the sample does not depend on others. */
+#define SAMPLE_FLAGS_SYNC               0x02000000
+/* sample_depends_on = 1 and sample_is_non_sync_sample = 1. */
+#define SAMPLE_FLAGS_NON_SYNC           0x01010000
+
+#define H264_NAL_SPS 7
+#define H264_NAL_PPS 8
+#define H264_NAL_AUD 9
+#define H264_NAL_IDR 5
+#define H265_NAL_IRAP_FIRST 16
+#define H265_NAL_IRAP_LAST 21
+#define H265_NAL_VPS 32
+#define H265_NAL_SPS 33
+#define H265_NAL_PPS 34
+#define H265_NAL_AUD 35
+
+#define AV1_OBU_SEQUENCE_HEADER 1
+#define AV1_OBU_TEMPORAL_DELIMITER 2
+#define AV1_OBU_PADDING 15
+
+/* Size of the IVF headers the AV1 encoder may put in front of frames. */
+#define IVF_FILE_HEADER_SIZE 32
+#define IVF_FRAME_HEADER_SIZE 12
+
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t size;
+    /* Position of the next bit to read. */
+    uint64_t pos;
+} bit_reader;
+
+typedef struct
+{
+    uint8_t seq_profile;
+    uint8_t seq_level_idx_0;
+    uint8_t seq_tier_0;
+    uint8_t high_bitdepth;
+    uint8_t twelve_bit;
+    uint8_t mono_chrome;
+    uint8_t chroma_subsampling_x;
+    uint8_t chroma_subsampling_y;
+    uint8_t chroma_sample_position;
+} av1_config;
+
+static uint32_t
+read_bits(bit_reader &br, int n)
+{
+    uint32_t value = 0;
+
+    /* Reading past the end yields zeros, callers check br.pos at the end. */
+    for (int i = 0; i < n; i++, br.pos++)
+    {
+        uint32_t bit = 0;
+        if (br.pos < (uint64_t) br.size * 8)
+        {
+            bit = (br.data[br.pos >> 3] >> (7 - (br.pos & 7))) & 1;
+        }
+        value = (value << 1) | bit;
+    }
+    return value;
+}
+
+static void
+skip_bits(bit_reader &br, uint32_t n)
+{
+    br.pos += n;
+}
+
+static bool
+bits_overrun(const bit_reader &br)
+{
+    return br.pos > (uint64_t) br.size * 8;
+}
+
+/* Exp-Golomb ue(v) of H.264 and H.265. */
+static uint32_t
+read_ue(bit_reader &br)
+{
+    int leading_zeros = 0;
+
+    while (!read_bits(br, 1))
+    {
+        if (++leading_zeros > 31 || bits_overrun(br))
+        {
+            return 0;
+        }
+    }
+    return ((1u << leading_zeros) - 1) + read_bits(br, leading_zeros);
+}
+
+/* uvlc() of AV1. */
+static uint32_t
+read_uvlc(bit_reader &br)
+{
+    return read_ue(br);
+}
+
+/* Removes the emulation prevention bytes of a NAL unit payload. */
+static void
+unescape_rbsp(const uint8_t *data, uint32_t size, std::vector<uint8_t> &rbsp)
+{
+    int zeros = 0;
+
+    rbsp.clear();
+    rbsp.reserve(size);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (zeros >= 2 && data[i] == 3)
+        {
+            zeros = 0;
+            continue;
+        }
+        zeros = data[i] ? 0 : zeros + 1;
+        rbsp.push_back(data[i]);
+    }
+}
+
+static void
+put_u8(std::vector<uint8_t> &b, uint8_t v)
+{
+    b.push_back(v);
+}
+
+static void
+put_u16(std::vector<uint8_t> &b, uint16_t v)
+{
+    b.push_back(v >> 8);
+    b.push_back(v);
+}
+
+static void
+put_u32(std::vector<uint8_t> &b, uint32_t v)
+{
+    b.push_back(v >> 24);
+    b.push_back(v >> 16);
+    b.push_back(v >> 8);
+    b.push_back(v);
+}
+
+static void
+put_u64(std::vector<uint8_t> &b, uint64_t v)
+{
+    put_u32(b, v >> 32);
+    put_u32(b, v);
+}
+
+static void
+put_bytes(std::vector<uint8_t> &b, const void *data, size_t size)
+{
+    b.insert(b.end(), (const uint8_t *) data, (const uint8_t *) data + size);
+}
+
+static void
+put_zeros(std::vector<uint8_t> &b, size_t size)
+{
+    b.insert(b.end(), size, 0);
+}
+
+static void
+put_leb128(std::vector<uint8_t> &b, uint64_t v)
+{
+    do
+    {
+        uint8_t byte = v & 0x7F;
+        v >>= 7;
+        b.push_back(byte | (v ? 0x80 : 0));
+    } while (v);
+}
+
+static void
+set_u32(std::vector<uint8_t> &b, size_t offset, uint32_t v)
+{
+    b[offset] = v >> 24;
+    b[offset + 1] = v >> 16;
+    b[offset + 2] = v >> 8;
+    b[offset + 3] = v;
+}
+
+/* Starts a box, its size is filled in by end_box(). */
+static size_t
+begin_box(std::vector<uint8_t> &b, const char *type)
+{
+    size_t offset = b.size();
+
+    put_u32(b, 0);
+    put_bytes(b, type, 4);
+    return offset;
+}
+
+static size_t
+begin_full_box(std::vector<uint8_t> &b, const char *type, uint8_t version,
+        uint32_t flags)
+{
+    size_t offset = begin_box(b, type);
+
+    put_u32(b, ((uint32_t) version << 24) | (flags & 0xFFFFFF));
+    return offset;
+}
+
+static void
+end_box(std::vector<uint8_t> &b, size_t offset)
+{
+    set_u32(b, offset, b.size() - offset);
+}
+
+static void
+put_matrix(std::vector<uint8_t> &b)
+{
+    static const uint32_t unity[9] = {
+        0x00010000, 0, 0,
+        0, 0x00010000, 0,
+        0, 0, 0x40000000 };
+
+    for (int i = 0; i < 9; i++)
+    {
+        put_u32(b, unity[i]);
+    }
+}
+
+static uint32_t
+read_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* Reads an AV1 leb128() value, returns its size or 0 if it is invalid. */
+static uint32_t
+read_leb128(const uint8_t *p, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (uint32_t i = 0; i < 8 && p + i < end; i++)
+    {
+        value |= (uint64_t) (p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80))
+        {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/* Parses the fields of an AV1 sequence header OBU payload needed for av1C. */
+static int
+parse_av1_sequence_header(const uint8_t *data, uint32_t size, av1_config &cfg)
+{
+    bit_reader br = { data, size, 0 };
+    bool reduced_still_picture_header;
+    bool decoder_model_info_present = false;
+    bool initial_display_delay_present = false;
+    uint32_t buffer_delay_length = 0;
+    uint32_t frame_width_bits, frame_height_bits;
+    uint32_t color_primaries = 2;
+    uint32_t transfer_characteristics = 2;
+    uint32_t matrix_coefficients = 2;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.seq_profile = read_bits(br, 3);
+    skip_bits(br, 1); /* still_picture */
+    reduced_still_picture_header = read_bits(br, 1);
+    if (reduced_still_picture_header)
+    {
+        cfg.seq_level_idx_0 = read_bits(br, 5);
+    }
+    else
+    {
+        uint32_t operating_points_cnt;
+
+        if (read_bits(br, 1)) /* timing_info_present_flag */
+        {
+            skip_bits(br, 64);
+            if (read_bits(br, 1)) /* equal_picture_interval */
+            {
+                read_uvlc(br);
+            }
+            decoder_model_info_present = read_bits(br, 1);
+            if (decoder_model_info_present)
+            {
+                buffer_delay_length = read_bits(br, 5) + 1;
+                skip_bits(br, 32 + 5 + 5);
+            }
+        }
+        initial_display_delay_present = read_bits(br, 1);
+        operating_points_cnt = read_bits(br, 5) + 1;
+        for (uint32_t i = 0; i < operating_points_cnt; i++)
+        {
+            uint32_t level, tier = 0;
+
+            skip_bits(br, 12); /* operating_point_idc */
+            level = read_bits(br, 5);
+            if (level > 7)
+            {
+                tier = read_bits(br, 1);
+            }
+            if (i == 0)
+            {
+                cfg.seq_level_idx_0 = level;
+                cfg.seq_tier_0 = tier;
+            }
+            if (decoder_model_info_present && read_bits(br, 1))
+            {
+                skip_bits(br, 2 * buffer_delay_length + 1);
+            }
+            if (initial_display_delay_present && read_bits(br, 1))
+            {
+                skip_bits(br, 4);
+            }
+        }
+    }
+
+    frame_width_bits = read_bits(br, 4) + 1;
+    frame_height_bits = read_bits(br, 4) + 1;
+    skip_bits(br, frame_width_bits + frame_height_bits);
+    if (!reduced_still_picture_header && read_bits(br, 1)) /* frame_id_numbers_present_flag */
+    {
+        skip_bits(br, 4 + 3);
+    }
+    skip_bits(br, 3); /* use_128x128_superblock, enable_filter_intra, enable_intra_edge_filter */
+    if (!reduced_still_picture_header)
+    {
+        bool enable_order_hint;
+        uint32_t seq_force_screen_content_tools;
+
+        skip_bits(br, 4); /* interintra, masked_compound, warped_motion, dual_filter */
+        enable_order_hint = read_bits(br, 1);
+        if (enable_order_hint)
+        {
+            skip_bits(br, 2); /* enable_jnt_comp, enable_ref_frame_mvs */
+        }
+        seq_force_screen_content_tools = read_bits(br, 1) ? 2 : read_bits(br, 1);
+        if (seq_force_screen_content_tools > 0 && !read_bits(br, 1))
+        {
+            skip_bits(br, 1); /* seq_force_integer_mv */
+        }
+        if (enable_order_hint)
+        {
+            skip_bits(br, 3); /* order_hint_bits_minus_1 */
+        }
+    }
+    skip_bits(br, 3); /* enable_superres, enable_cdef, enable_restoration */
+
+    /* color_config() */
+    cfg.high_bitdepth = read_bits(br, 1);
+    if (cfg.seq_profile == 2 && cfg.high_bitdepth)
+    {
+        cfg.twelve_bit = read_bits(br, 1);
+    }
+    cfg.mono_chrome = (cfg.seq_profile == 1) ? 0 : read_bits(br, 1);
+    if (read_bits(br, 1)) /* color_description_present_flag */
+    {
+        color_primaries = read_bits(br, 8);
+        transfer_characteristics = read_bits(br, 8);
+        matrix_coefficients = read_bits(br, 8);
+    }
+    if (cfg.mono_chrome)
+    {
+        cfg.chroma_subsampling_x = 1;
+        cfg.chroma_subsampling_y = 1;
+    }
+    else if (color_primaries == 1 && transfer_characteristics == 13 &&
+            matrix_coefficients == 0)
+    {
+        /* sRGB, always 4:4:4. */
+        cfg.chroma_subsampling_x = 0;
+        cfg.chroma_subsampling_y = 0;
+    }
+    else
+    {
+        skip_bits(br, 1); /* color_range */
+        if (cfg.seq_profile == 0)
+        {
+            cfg.chroma_subsampling_x = 1;
+            cfg.chroma_subsampling_y = 1;
+        }
+        else if (cfg.seq_profile == 2 && cfg.twelve_bit)
+        {
+            cfg.chroma_subsampling_x = read_bits(br, 1);
+            if (cfg.chroma_subsampling_x)
+            {
+                cfg.chroma_subsampling_y = read_bits(br, 1);
+            }
+        }
+        else if (cfg.seq_profile == 2)
+        {
+            cfg.chroma_subsampling_x = 1;
+        }
+        if (cfg.chroma_subsampling_x && cfg.chroma_subsampling_y)
+        {
+            cfg.chroma_sample_position = read_bits(br, 2);
+        }
+    }
+
+    return bits_overrun(br) ? -1 : 0;
+}
+
+NvMp4Muxer::NvMp4Muxer(const char *file_path, uint32_t pixfmt,
+        uint32_t width, uint32_t height, uint32_t fps_n, uint32_t fps_d)
+    : pixfmt(pixfmt), width(width), height(height)
+{
+    fd = -1;
+    header_written = false;
+    warned_parameter_sets = false;
+    have_pts = false;
+    first_pts = 0;
+    last_input_pts = 0;
+    last_pts = 0;
+    next_dts = 0;
+    sequence_number = 1;
+    num_samples = 0;
+    num_fragments = 0;
+    is_closed = false;
+    is_in_error = false;
+
+    if (fps_n == 0 || fps_d == 0)
+    {
+        fps_n = 30;
+        fps_d = 1;
+    }
+    frame_duration = (uint64_t) MP4_TIMESCALE * fps_d / fps_n;
+    if (frame_duration == 0)
+    {
+        frame_duration = 1;
+    }
+
+    if (pixfmt != V4L2_PIX_FMT_H264 && pixfmt != V4L2_PIX_FMT_H265 &&
+            pixfmt != V4L2_PIX_FMT_AV1)
+    {
+        CAT_ERROR_MSG("MP4 output is supported only for H.264, H.265 and AV1");
+        is_in_error = true;
+        return;
+    }
+
+    fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+    {
+        CAT_SYS_ERROR_MSG("Could not open " << file_path);
+        is_in_error = true;
+        return;
+    }
+
+    /* Room for a typical GOP, grown when needed. */
+    sample_data.reserve(4 * 1024 * 1024);
+}
+
+NvMp4Muxer *
+NvMp4Muxer::createMp4Muxer(const char *file_path, uint32_t pixfmt,
+        uint32_t width, uint32_t height, uint32_t fps_n, uint32_t fps_d)
+{
+    NvMp4Muxer *muxer = new NvMp4Muxer(file_path, pixfmt, width, height,
+            fps_n, fps_d);
+    if (muxer->is_in_error)
+    {
+        delete muxer;
+        return NULL;
+    }
+    return muxer;
+}
+
+NvMp4Muxer::~NvMp4Muxer()
+{
+    close();
+}
+
+int
+NvMp4Muxer::addNalUnits(const uint8_t *data, uint32_t size, bool &key_frame)
+{
+    const uint8_t *end = data + size;
+    const uint8_t *p = NvBitstreamReader::findStartCode(data, end);
+
+    if (p == end)
+    {
+        CAT_ERROR_MSG("No start code in frame of size " << size);
+        return -1;
+    }
+
+    while (p != end)
+    {
+        const uint8_t *nal = p + 3;
+        const uint8_t *next = NvBitstreamReader::findStartCode(nal, end);
+        const uint8_t *nal_end = next;
+        std::vector<uint8_t> *parameter_set = NULL;
+        uint32_t nal_size;
+        int type;
+
+        /* Trailing zeros belong to the next start code, or are padding. */
+        while (nal_end > nal && nal_end[-1] == 0)
+        {
+            nal_end--;
+        }
+        nal_size = nal_end - nal;
+        p = next;
+        if (nal_size == 0)
+        {
+            continue;
+        }
+
+        if (pixfmt == V4L2_PIX_FMT_H264)
+        {
+            type = nal[0] & 0x1F;
+            if (type == H264_NAL_AUD)
+            {
+                continue;
+            }
+            if (type == H264_NAL_SPS)
+            {
+                parameter_set = &sps;
+            }
+            else if (type == H264_NAL_PPS)
+            {
+                parameter_set = &pps;
+            }
+            else if (type == H264_NAL_IDR)
+            {
+                key_frame = true;
+            }
+        }
+        else
+        {
+            type = (nal[0] >> 1) & 0x3F;
+            if (type == H265_NAL_AUD)
+            {
+                continue;
+            }
+            if (type == H265_NAL_VPS)
+            {
+                parameter_set = &vps;
+            }
+            else if (type == H265_NAL_SPS)
+            {
+                parameter_set = &sps;
+            }
+            else if (type == H265_NAL_PPS)
+            {
+                parameter_set = &pps;
+            }
+            else if (type >= H265_NAL_IRAP_FIRST && type <= H265_NAL_IRAP_LAST)
+            {
+                key_frame = true;
+            }
+        }
+
+        if (parameter_set)
+        {
+            /* Parameter sets go to the sample entry, repeats are dropped. */
+            if (!header_written)
+            {
+                parameter_set->assign(nal, nal_end);
+                continue;
+            }
+            if (parameter_set->size() == nal_size &&
+                    !memcmp(parameter_set->data(), nal, nal_size))
+            {
+                continue;
+            }
+            if (!warned_parameter_sets)
+            {
+                CAT_WARN_MSG("Parameter sets changed, keeping them in band");
+                warned_parameter_sets = true;
+            }
+        }
+
+        put_u32(sample_data, nal_size);
+        put_bytes(sample_data, nal, nal_size);
+    }
+    return 0;
+}
+
+int
+NvMp4Muxer::addObus(const uint8_t *data, uint32_t size, bool &key_frame)
+{
+    const uint8_t *end = data + size;
+    const uint8_t *p = data;
+
+    if (size >= IVF_FILE_HEADER_SIZE && !memcmp(data, "DKIF", 4))
+    {
+        uint32_t header_size = data[6] | (data[7] << 8);
+        p += std::min(header_size, size);
+    }
+    if (end - p >= IVF_FRAME_HEADER_SIZE &&
+            read_le32(p) == (uint32_t) (end - p) - IVF_FRAME_HEADER_SIZE)
+    {
+        p += IVF_FRAME_HEADER_SIZE;
+    }
+
+    while (p < end)
+    {
+        uint8_t header = p[0];
+        uint32_t header_size = (header & 0x04) ? 2 : 1;
+        bool has_size_field = (header & 0x02) != 0;
+        uint32_t leb128_size = 0;
+        uint64_t obu_size;
+        const uint8_t *payload;
+        int type = (header >> 3) & 0x0F;
+
+        if ((header & 0x80) || (uint32_t) (end - p) < header_size)
+        {
+            CAT_ERROR_MSG("Invalid OBU header at offset " << (p - data));
+            return -1;
+        }
+        if (has_size_field)
+        {
+            leb128_size = read_leb128(p + header_size, end, obu_size);
+            if (!leb128_size)
+            {
+                CAT_ERROR_MSG("Invalid OBU size at offset " << (p - data));
+                return -1;
+            }
+        }
+        else
+        {
+            obu_size = end - p - header_size;
+        }
+        payload = p + header_size + leb128_size;
+        if (obu_size > (uint64_t) (end - payload))
+        {
+            CAT_ERROR_MSG("Truncated OBU at offset " << (p - data));
+            return -1;
+        }
+
+        if (type == AV1_OBU_SEQUENCE_HEADER)
+        {
+            key_frame = true;
+            if (!header_written)
+            {
+                sequence_header.assign(payload, payload + obu_size);
+            }
+            else if ((sequence_header.size() != obu_size ||
+                        memcmp(sequence_header.data(), payload, obu_size)) &&
+                    !warned_parameter_sets)
+            {
+                CAT_WARN_MSG("Sequence header changed, keeping it in band");
+                warned_parameter_sets = true;
+            }
+        }
+
+        /* Temporal delimiters are implied by the sample boundaries. */
+        if (type != AV1_OBU_TEMPORAL_DELIMITER && type != AV1_OBU_PADDING)
+        {
+            if (has_size_field)
+            {
+                put_bytes(sample_data, p, payload + obu_size - p);
+            }
+            else
+            {
+                /* Samples carry OBUs with a size field only. */
+                put_u8(sample_data, header | 0x02);
+                put_bytes(sample_data, p + 1, header_size - 1);
+                put_leb128(sample_data, obu_size);
+                put_bytes(sample_data, payload, obu_size);
+            }
+        }
+        p = payload + obu_size;
+    }
+    return 0;
+}
+
+int
+NvMp4Muxer::buildCodecConfig(std::vector<uint8_t> &out)
+{
+    std::vector<uint8_t> rbsp;
+    size_t box;
+
+    if (pixfmt == V4L2_PIX_FMT_H264)
+    {
+        uint8_t profile_idc;
+
+        if (sps.size() < 4 || pps.empty())
+        {
+            CAT_ERROR_MSG("No SPS or PPS before the first key frame");
+            return -1;
+        }
+        profile_idc = sps[1];
+
+        box = begin_box(out, "avcC");
+        put_u8(out, 1);
+        put_u8(out, profile_idc);
+        put_u8(out, sps[2]);
+        put_u8(out, sps[3]);
+        put_u8(out, 0xFC | 3);    /* lengthSizeMinusOne */
+        put_u8(out, 0xE0 | 1);    /* numOfSequenceParameterSets */
+        put_u16(out, sps.size());
+        put_bytes(out, sps.data(), sps.size());
+        put_u8(out, 1);           /* numOfPictureParameterSets */
+        put_u16(out, pps.size());
+        put_bytes(out, pps.data(), pps.size());
+
+        if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 ||
+                profile_idc == 144)
+        {
+            uint32_t chroma_format_idc, bit_depth_luma, bit_depth_chroma;
+
+            unescape_rbsp(sps.data() + 1, sps.size() - 1, rbsp);
+            bit_reader br = { rbsp.data(), (uint32_t) rbsp.size(), 24 };
+            read_ue(br); /* seq_parameter_set_id */
+            chroma_format_idc = read_ue(br);
+            if (chroma_format_idc == 3)
+            {
+                skip_bits(br, 1); /* separate_colour_plane_flag */
+            }
+            bit_depth_luma = read_ue(br);
+            bit_depth_chroma = read_ue(br);
+            if (bits_overrun(br))
+            {
+                CAT_ERROR_MSG("Truncated SPS");
+                return -1;
+            }
+
+            put_u8(out, 0xFC | chroma_format_idc);
+            put_u8(out, 0xF8 | bit_depth_luma);
+            put_u8(out, 0xF8 | bit_depth_chroma);
+            put_u8(out, 0);       /* numOfSequenceParameterSetExt */
+        }
+        end_box(out, box);
+    }
+    else if (pixfmt == V4L2_PIX_FMT_H265)
+    {
+        const std::vector<uint8_t> *arrays[3] = { &vps, &sps, &pps };
+        static const uint8_t types[3] = { H265_NAL_VPS, H265_NAL_SPS,
+            H265_NAL_PPS };
+        uint32_t max_sub_layers_minus1, temporal_id_nesting;
+        uint32_t chroma_format_idc, bit_depth_luma, bit_depth_chroma;
+        uint8_t ptl[12];
+
+        if (vps.empty() || sps.size() < 15 || pps.empty())
+        {
+            CAT_ERROR_MSG("No VPS, SPS or PPS before the first key frame");
+            return -1;
+        }
+
+        unescape_rbsp(sps.data() + 2, sps.size() - 2, rbsp);
+        bit_reader br = { rbsp.data(), (uint32_t) rbsp.size(), 0 };
+        skip_bits(br, 4); /* sps_video_parameter_set_id */
+        max_sub_layers_minus1 = read_bits(br, 3);
+        temporal_id_nesting = read_bits(br, 1);
+        /* The general profile, tier and level are byte aligned. */
+        for (int i = 0; i < 12; i++)
+        {
+            ptl[i] = read_bits(br, 8);
+        }
+        if (max_sub_layers_minus1 > 0)
+        {
+            uint32_t flags = read_bits(br, 16);
+
+            /* sub_layer_profile/level_present_flag pairs, then padding. */
+            for (uint32_t i = 0; i < max_sub_layers_minus1; i++)
+            {
+                if (flags & (0x8000 >> (2 * i)))
+                {
+                    skip_bits(br, 88);
+                }
+                if (flags & (0x4000 >> (2 * i)))
+                {
+                    skip_bits(br, 8);
+                }
+            }
+        }
+        read_ue(br); /* sps_seq_parameter_set_id */
+        chroma_format_idc = read_ue(br);
+        if (chroma_format_idc == 3)
+        {
+            skip_bits(br, 1); /* separate_colour_plane_flag */
+        }
+        read_ue(br); /* pic_width_in_luma_samples */
+        read_ue(br); /* pic_height_in_luma_samples */
+        if (read_bits(br, 1)) /* conformance_window_flag */
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                read_ue(br);
+            }
+        }
+        bit_depth_luma = read_ue(br);
+        bit_depth_chroma = read_ue(br);
+        if (bits_overrun(br))
+        {
+            CAT_ERROR_MSG("Truncated SPS");
+            return -1;
+        }
+
+        box = begin_box(out, "hvcC");
+        put_u8(out, 1);
+        put_bytes(out, ptl, sizeof(ptl));
+        put_u16(out, 0xF000);     /* min_spatial_segmentation_idc */
+        put_u8(out, 0xFC);        /* parallelismType */
+        put_u8(out, 0xFC | chroma_format_idc);
+        put_u8(out, 0xF8 | bit_depth_luma);
+        put_u8(out, 0xF8 | bit_depth_chroma);
+        put_u16(out, 0);          /* avgFrameRate */
+        put_u8(out, ((max_sub_layers_minus1 + 1) << 3) |
+                (temporal_id_nesting << 2) | 3);
+        put_u8(out, 3);           /* numOfArrays */
+        for (int i = 0; i < 3; i++)
+        {
+            put_u8(out, 0x80 | types[i]); /* array_completeness */
+            put_u16(out, 1);
+            put_u16(out, arrays[i]->size());
+            put_bytes(out, arrays[i]->data(), arrays[i]->size());
+        }
+        end_box(out, box);
+    }
+    else
+    {
+        av1_config cfg;
+
+        if (sequence_header.empty())
+        {
+            CAT_ERROR_MSG("No sequence header before the first key frame");
+            return -1;
+        }
+        if (parse_av1_sequence_header(sequence_header.data(),
+                    sequence_header.size(), cfg) < 0)
+        {
+            CAT_ERROR_MSG("Truncated sequence header");
+            return -1;
+        }
+
+        box = begin_box(out, "av1C");
+        put_u8(out, 0x81);        /* marker, version */
+        put_u8(out, (cfg.seq_profile << 5) | cfg.seq_level_idx_0);
+        put_u8(out, (cfg.seq_tier_0 << 7) | (cfg.high_bitdepth << 6) |
+                (cfg.twelve_bit << 5) | (cfg.mono_chrome << 4) |
+                (cfg.chroma_subsampling_x << 3) |
+                (cfg.chroma_subsampling_y << 2) | cfg.chroma_sample_position);
+        put_u8(out, 0);           /* initial_presentation_delay_present */
+        put_u8(out, (AV1_OBU_SEQUENCE_HEADER << 3) | 0x02);
+        put_leb128(out, sequence_header.size());
+        put_bytes(out, sequence_header.data(), sequence_header.size());
+        end_box(out, box);
+    }
+    return 0;
+}
+
+int
+NvMp4Muxer::writeHeader()
+{
+    std::vector<uint8_t> b;
+    std::vector<uint8_t> config;
+    const char *sample_entry;
+    struct iovec iov;
+    size_t moov, trak, mdia, minf, dinf, dref, stbl, stsd, entry, mvex, box;
+
+    if (buildCodecConfig(config) < 0)
+    {
+        return -1;
+    }
+    if (pixfmt == V4L2_PIX_FMT_H264)
+    {
+        sample_entry = "avc1";
+    }
+    else if (pixfmt == V4L2_PIX_FMT_H265)
+    {
+        sample_entry = "hvc1";
+    }
+    else
+    {
+        sample_entry = "av01";
+    }
+
+    box = begin_box(b, "ftyp");
+    put_bytes(b, "iso6", 4);      /* major_brand */
+    put_u32(b, 0);                /* minor_version */
+    put_bytes(b, "iso6", 4);
+    put_bytes(b, "mp41", 4);
+    if (pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        put_bytes(b, "av01", 4);
+    }
+    end_box(b, box);
+
+    moov = begin_box(b, "moov");
+
+    box = begin_full_box(b, "mvhd", 0, 0);
+    put_u32(b, 0);                /* creation_time */
+    put_u32(b, 0);                /* modification_time */
+    put_u32(b, 1000);             /* timescale */
+    put_u32(b, 0);                /* duration, given by the fragments */
+    put_u32(b, 0x00010000);       /* rate */
+    put_u16(b, 0x0100);           /* volume */
+    put_zeros(b, 2 + 8);
+    put_matrix(b);
+    put_zeros(b, 6 * 4);          /* pre_defined */
+    put_u32(b, 2);                /* next_track_ID */
+    end_box(b, box);
+
+    trak = begin_box(b, "trak");
+
+    box = begin_full_box(b, "tkhd", 0, 0x000003); /* enabled, in movie */
+    put_u32(b, 0);                /* creation_time */
+    put_u32(b, 0);                /* modification_time */
+    put_u32(b, 1);                /* track_ID */
+    put_u32(b, 0);
+    put_u32(b, 0);                /* duration */
+    put_zeros(b, 8);
+    put_u16(b, 0);                /* layer */
+    put_u16(b, 0);                /* alternate_group */
+    put_u16(b, 0);                /* volume */
+    put_u16(b, 0);
+    put_matrix(b);
+    put_u32(b, width << 16);
+    put_u32(b, height << 16);
+    end_box(b, box);
+
+    mdia = begin_box(b, "mdia");
+
+    box = begin_full_box(b, "mdhd", 0, 0);
+    put_u32(b, 0);                /* creation_time */
+    put_u32(b, 0);                /* modification_time */
+    put_u32(b, MP4_TIMESCALE);
+    put_u32(b, 0);                /* duration */
+    put_u16(b, 0x55C4);           /* language, 'und' */
+    put_u16(b, 0);
+    end_box(b, box);
+
+    box = begin_full_box(b, "hdlr", 0, 0);
+    put_u32(b, 0);                /* pre_defined */
+    put_bytes(b, "vide", 4);
+    put_zeros(b, 3 * 4);
+    put_bytes(b, "VideoHandler", 13);
+    end_box(b, box);
+
+    minf = begin_box(b, "minf");
+
+    box = begin_full_box(b, "vmhd", 0, 0x000001);
+    put_zeros(b, 2 + 3 * 2);      /* graphicsmode, opcolor */
+    end_box(b, box);
+
+    dinf = begin_box(b, "dinf");
+    dref = begin_full_box(b, "dref", 0, 0);
+    put_u32(b, 1);                /* entry_count */
+    box = begin_full_box(b, "url ", 0, 0x000001); /* media in this file */
+    end_box(b, box);
+    end_box(b, dref);
+    end_box(b, dinf);
+
+    stbl = begin_box(b, "stbl");
+
+    stsd = begin_full_box(b, "stsd", 0, 0);
+    put_u32(b, 1);                /* entry_count */
+    entry = begin_box(b, sample_entry);
+    put_zeros(b, 6);
+    put_u16(b, 1);                /* data_reference_index */
+    put_zeros(b, 2 + 2 + 3 * 4);
+    put_u16(b, width);
+    put_u16(b, height);
+    put_u32(b, 0x00480000);       /* horizresolution, 72 dpi */
+    put_u32(b, 0x00480000);       /* vertresolution, 72 dpi */
+    put_u32(b, 0);
+    put_u16(b, 1);                /* frame_count */
+    put_zeros(b, 32);             /* compressorname */
+    put_u16(b, 0x0018);           /* depth */
+    put_u16(b, 0xFFFF);           /* pre_defined */
+    put_bytes(b, config.data(), config.size());
+    end_box(b, entry);
+    end_box(b, stsd);
+
+    /* The sample tables are empty, the samples are in the fragments. */
+    box = begin_full_box(b, "stts", 0, 0);
+    put_u32(b, 0);
+    end_box(b, box);
+    box = begin_full_box(b, "stsc", 0, 0);
+    put_u32(b, 0);
+    end_box(b, box);
+    box = begin_full_box(b, "stsz", 0, 0);
+    put_u32(b, 0);
+    put_u32(b, 0);
+    end_box(b, box);
+    box = begin_full_box(b, "stco", 0, 0);
+    put_u32(b, 0);
+    end_box(b, box);
+
+    end_box(b, stbl);
+    end_box(b, minf);
+    end_box(b, mdia);
+    end_box(b, trak);
+
+    mvex = begin_box(b, "mvex");
+    box = begin_full_box(b, "trex", 0, 0);
+    put_u32(b, 1);                /* track_ID */
+    put_u32(b, 1);                /* default_sample_description_index */
+    put_u32(b, 0);                /* default_sample_duration */
+    put_u32(b, 0);                /* default_sample_size */
+    put_u32(b, 0);                /* default_sample_flags */
+    end_box(b, box);
+    end_box(b, mvex);
+
+    end_box(b, moov);
+
+    iov.iov_base = b.data();
+    iov.iov_len = b.size();
+    if (writeFully(&iov, 1) < 0)
+    {
+        return -1;
+    }
+    header_written = true;
+    return 0;
+}
+
+int
+NvMp4Muxer::writeFragment(uint32_t data_size)
+{
+    std::vector<uint8_t> &b = fragment_header;
+    uint32_t count = samples.size();
+    std::vector<int64_t> sorted_pts(count);
+    std::vector<int64_t> dts(count);
+    bool has_cto = false;
+    bool negative_cto = false;
+    int64_t last_duration;
+    size_t moof, traf, box, data_offset;
+    struct iovec iov[2];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sorted_pts[i] = samples[i].pts;
+    }
+    std::sort(sorted_pts.begin(), sorted_pts.end());
+
+    /* Samples come in decode order, which is presentation order except
+     * for B-frames. The decode timestamps are the presentation timestamps
+     * sorted, kept strictly increasing and following the previous
+     * fragment, the differences are composition time offsets. */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        dts[i] = std::max((int64_t) next_dts, sorted_pts[0]) +
+            (sorted_pts[i] - sorted_pts[0]);
+        if (i > 0 && dts[i] <= dts[i - 1])
+        {
+            dts[i] = dts[i - 1] + 1;
+        }
+        if (samples[i].pts != dts[i])
+        {
+            has_cto = true;
+            negative_cto |= samples[i].pts < dts[i];
+        }
+    }
+    last_duration = frame_duration;
+    if (count > 1 && sorted_pts[count - 1] > sorted_pts[0])
+    {
+        last_duration = (sorted_pts[count - 1] - sorted_pts[0]) / (count - 1);
+    }
+
+    b.clear();
+    moof = begin_box(b, "moof");
+
+    box = begin_full_box(b, "mfhd", 0, 0);
+    put_u32(b, sequence_number);
+    end_box(b, box);
+
+    traf = begin_box(b, "traf");
+
+    box = begin_full_box(b, "tfhd", 0, TFHD_DEFAULT_BASE_IS_MOOF);
+    put_u32(b, 1);                /* track_ID */
+    end_box(b, box);
+
+    box = begin_full_box(b, "tfdt", 1, 0);
+    put_u64(b, dts[0]);           /* baseMediaDecodeTime */
+    end_box(b, box);
+
+    /* Version 1 makes the composition time offsets signed. */
+    box = begin_full_box(b, "trun", negative_cto ? 1 : 0,
+            TRUN_DATA_OFFSET_PRESENT | TRUN_SAMPLE_DURATION_PRESENT |
+            TRUN_SAMPLE_SIZE_PRESENT | TRUN_SAMPLE_FLAGS_PRESENT |
+            (has_cto ? TRUN_SAMPLE_CTO_PRESENT : 0));
+    put_u32(b, count);
+    data_offset = b.size();
+    put_u32(b, 0);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        put_u32(b, (i + 1 < count) ? dts[i + 1] - dts[i] : last_duration);
+        put_u32(b, samples[i].size);
+        put_u32(b, samples[i].key_frame ? SAMPLE_FLAGS_SYNC :
+                SAMPLE_FLAGS_NON_SYNC);
+        if (has_cto)
+        {
+            put_u32(b, (uint32_t) (samples[i].pts - dts[i]));
+        }
+    }
+    end_box(b, box);
+
+    end_box(b, traf);
+    end_box(b, moof);
+
+    /* The sample data follows the moof and the mdat box header. */
+    set_u32(b, data_offset, b.size() - moof + 8);
+    put_u32(b, 8 + data_size);
+    put_bytes(b, "mdat", 4);
+
+    iov[0].iov_base = b.data();
+    iov[0].iov_len = b.size();
+    iov[1].iov_base = sample_data.data();
+    iov[1].iov_len = data_size;
+    if (writeFully(iov, 2) < 0)
+    {
+        return -1;
+    }
+
+    next_dts = dts[count - 1] + last_duration;
+    sequence_number++;
+    num_fragments++;
+    num_samples += count;
+    samples.clear();
+    sample_data.erase(sample_data.begin(), sample_data.begin() + data_size);
+    return 0;
+}
+
+int
+NvMp4Muxer::writeFully(struct iovec *iov, int iovcnt)
+{
+    int first = 0;
+
+    while (first < iovcnt)
+    {
+        ssize_t written = writev(fd, iov + first, iovcnt - first);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            CAT_SYS_ERROR_MSG("Error while writing MP4 file");
+            is_in_error = true;
+            return -1;
+        }
+
+        /* Skip what a short write took, then write the rest. */
+        while (first < iovcnt && (size_t) written >= iov[first].iov_len)
+        {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (written > 0)
+        {
+            iov[first].iov_base = (unsigned char *) iov[first].iov_base + written;
+            iov[first].iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+int
+NvMp4Muxer::writeSample(const uint8_t *data, uint32_t size, uint64_t pts)
+{
+    size_t data_start = sample_data.size();
+    uint32_t sample_size;
+    bool key_frame = false;
+    NvMp4Sample sample;
+    int ret;
+
+    if (is_closed || is_in_error)
+    {
+        return -1;
+    }
+
+    if (pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        ret = addObus(data, size, key_frame);
+    }
+    else
+    {
+        ret = addNalUnits(data, size, key_frame);
+    }
+    if (ret < 0)
+    {
+        sample_data.resize(data_start);
+        return -1;
+    }
+    if (sample_data.size() == data_start)
+    {
+        /* Only parameter sets, nothing to store. */
+        return 0;
+    }
+    sample_size = sample_data.size() - data_start;
+
+    if (!header_written)
+    {
+        if (!key_frame)
+        {
+            CAT_WARN_MSG("Dropping frame before the first key frame");
+            sample_data.resize(data_start);
+            return 0;
+        }
+        if (writeHeader() < 0)
+        {
+            sample_data.resize(data_start);
+            is_in_error = true;
+            return -1;
+        }
+    }
+
+    /* A fragment holds a GOP, split when it grows too large. */
+    if (!samples.empty() && (key_frame || data_start >= MAX_FRAGMENT_SIZE))
+    {
+        if (writeFragment(data_start) < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (!have_pts)
+    {
+        first_pts = pts;
+        last_pts = 0;
+        have_pts = true;
+    }
+    else if (pts == last_input_pts)
+    {
+        last_pts += frame_duration;
+    }
+    else
+    {
+        last_pts = ((int64_t) (pts - first_pts) * MP4_TIMESCALE) / 1000000;
+    }
+    last_input_pts = pts;
+
+    sample.size = sample_size;
+    sample.pts = last_pts;
+    sample.key_frame = key_frame;
+    samples.push_back(sample);
+    return 0;
+}
+
+int
+NvMp4Muxer::writeBuffer(const struct v4l2_buffer *v4l2_buf, NvBuffer *buffer)
+{
+    uint64_t pts = (uint64_t) v4l2_buf->timestamp.tv_sec * 1000000 +
+        v4l2_buf->timestamp.tv_usec;
+
+    return writeSample(buffer->planes[0].data, buffer->planes[0].bytesused,
+            pts);
+}
+
+int
+NvMp4Muxer::close()
+{
+    if (is_closed)
+    {
+        return is_in_error ? -1 : 0;
+    }
+    is_closed = true;
+
+    if (!is_in_error && !samples.empty())
+    {
+        writeFragment(sample_data.size());
+    }
+    if (!header_written && !is_in_error)
+    {
+        CAT_WARN_MSG("No key frame was written, the file is empty");
+    }
+    if (fd >= 0)
+    {
+        if (::close(fd) < 0)
+        {
+            CAT_SYS_ERROR_MSG("Error while closing MP4 file");
+            is_in_error = true;
+        }
+        fd = -1;
+    }
+    return is_in_error ? -1 : 0;
+}
@@ -0,0 +1,524 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvTracer.h"
+#include "NvLogging.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#define CAT_NAME "Tracer"
+
+#define TRACE_ENV "NVMM_TRACE"
+/* Events per thread, a power of two. About 1 MiB per tracing thread. */
+#define TRACE_RING_EVENTS 16384
+#define TRACE_DRAIN_INTERVAL_MS 100
+#define TRACE_NAME_SIZE 16
+
+using namespace std;
+
+namespace
+{
+
+enum TraceEventType
+{
+    EVENT_SLICE,
+    EVENT_QUEUED,
+    EVENT_DEQUEUED
+};
+
+struct TraceEvent
+{
+    uint64_t start_ns;
+    uint64_t end_ns;
+    int64_t timestamp_us;
+    uint64_t queue;
+    const char *name;
+    char owner[TRACE_NAME_SIZE];
+    int32_t index;
+    uint8_t type;
+    uint8_t plane;
+};
+
+/**
+ * Single producer, single consumer ring of the events of one thread. The
+ * thread owning it only moves head, the drain only moves tail.
+ */
+struct TraceRing
+{
+    TraceEvent events[TRACE_RING_EVENTS];
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+    bool exited;
+    pid_t tid;
+    char thread_name[TRACE_NAME_SIZE];
+    char written_name[TRACE_NAME_SIZE];
+};
+
+}
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trace_cond = PTHREAD_COND_INITIALIZER;
+static vector<TraceRing *> *trace_rings;
+static FILE *trace_file;
+static bool trace_first_event = true;
+static uint64_t trace_base_ns;
+static uint64_t trace_dropped;
+static pid_t trace_pid;
+static pthread_key_t trace_ring_key;
+static pthread_t trace_drain_thread;
+static bool trace_draining;
+static __thread TraceRing *thread_ring;
+
+bool NvTracer::enabled = NvTracer::init();
+
+static const char *
+planeName(uint8_t plane)
+{
+    switch (plane)
+    {
+        case NvTracer::PLANE_OUTPUT:
+            return "output";
+        case NvTracer::PLANE_CAPTURE:
+            return "capture";
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Writes str as the contents of a JSON string. Names are short and rarely
+ * need escaping.
+ */
+static void
+writeString(const char *str)
+{
+    for (; *str; str++)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            fputc('\\', trace_file);
+            fputc(*str, trace_file);
+        }
+        else if ((unsigned char) *str >= 0x20)
+        {
+            fputc(*str, trace_file);
+        }
+    }
+}
+
+static void
+writeSeparator()
+{
+    fputs(trace_first_event ? "\n" : ",\n", trace_file);
+    trace_first_event = false;
+}
+
+static void
+writeTime(const char *key, uint64_t ns)
+{
+    fprintf(trace_file, ",\"%s\":%llu.%03llu", key,
+            (unsigned long long) (ns / 1000), (unsigned long long) (ns % 1000));
+}
+
+static void
+writeThreadName(TraceRing *ring)
+{
+    writeSeparator();
+    fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"tid\":%d,\"args\":{\"name\":\"", trace_pid, ring->tid);
+    writeString(ring->thread_name);
+    fputs("\"}}", trace_file);
+    memcpy(ring->written_name, ring->thread_name, TRACE_NAME_SIZE);
+}
+
+static void
+writeEvent(TraceRing *ring, const TraceEvent &event)
+{
+    const char *plane = planeName(event.plane);
+    uint64_t start_ns = event.start_ns > trace_base_ns ?
+        event.start_ns - trace_base_ns : 0;
+
+    writeSeparator();
+    if (event.type == EVENT_SLICE)
+    {
+        fputs("{\"name\":\"", trace_file);
+        writeString(event.name);
+        fputs("\",\"cat\":\"nvmm\",\"ph\":\"X\"", trace_file);
+        writeTime("ts", start_ns);
+        writeTime("dur", event.end_ns - event.start_ns);
+    }
+    else
+    {
+        /* One async track per buffer, spanning its time in the driver. */
+        fputs("{\"name\":\"", trace_file);
+        writeString(event.owner);
+        fprintf(trace_file, " %s %d\",\"cat\":\"buffer\",\"ph\":\"%s\","
+                "\"id\":\"0x%llx.%d\"", plane ? plane : "", event.index,
+                event.type == EVENT_QUEUED ? "b" : "e",
+                (unsigned long long) event.queue, event.index);
+        writeTime("ts", start_ns);
+    }
+    fprintf(trace_file, ",\"pid\":%d,\"tid\":%d,\"args\":{\"element\":\"",
+            trace_pid, ring->tid);
+    writeString(event.owner);
+    fputc('"', trace_file);
+    if (plane)
+    {
+        fprintf(trace_file, ",\"plane\":\"%s\"", plane);
+    }
+    if (event.index >= 0)
+    {
+        fprintf(trace_file, ",\"index\":%d", event.index);
+    }
+    if (event.timestamp_us >= 0)
+    {
+        fprintf(trace_file, ",\"timestamp\":%lld",
+                (long long) event.timestamp_us);
+    }
+    fputs("}}", trace_file);
+}
+
+/**
+ * Reads the current name of a live thread, which may have been set after
+ * its first event.
+ */
+static void
+readThreadName(TraceRing *ring)
+{
+    char path[64];
+    char name[TRACE_NAME_SIZE];
+    ssize_t len;
+    int fd;
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", ring->tid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    len = read(fd, name, sizeof(name) - 1);
+    close(fd);
+    if (len <= 0)
+    {
+        return;
+    }
+    if (name[len - 1] == '\n')
+    {
+        len--;
+    }
+    name[len] = '\0';
+    memcpy(ring->thread_name, name, len + 1);
+}
+
+/**
+ * Writes the pending events of every ring. Must be called with trace_lock
+ * held.
+ */
+static void
+drainRings()
+{
+    for (size_t i = 0; i < trace_rings->size();)
+    {
+        TraceRing *ring = (*trace_rings)[i];
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+
+        if (!ring->exited)
+        {
+            readThreadName(ring);
+        }
+        if (strcmp(ring->thread_name, ring->written_name))
+        {
+            writeThreadName(ring);
+        }
+
+        for (; tail != head; tail++)
+        {
+            writeEvent(ring, ring->events[tail & (TRACE_RING_EVENTS - 1)]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        trace_dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+
+        if (ring->exited)
+        {
+            trace_rings->erase(trace_rings->begin() + i);
+            delete ring;
+            continue;
+        }
+        i++;
+    }
+    fflush(trace_file);
+}
+
+/**
+ * Called when a thread that recorded events exits. The drain frees its
+ * ring once the last events are written.
+ */
+static void
+threadExited(void *data)
+{
+    TraceRing *ring = (TraceRing *) data;
+
+    pthread_mutex_lock(&trace_lock);
+    prctl(PR_GET_NAME, ring->thread_name, 0, 0, 0);
+    ring->exited = true;
+    pthread_mutex_unlock(&trace_lock);
+}
+
+static TraceRing *
+getThreadRing()
+{
+    if (thread_ring)
+    {
+        return thread_ring;
+    }
+
+    TraceRing *ring = new TraceRing;
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->dropped.store(0);
+    ring->exited = false;
+    ring->tid = syscall(SYS_gettid);
+    memset(ring->thread_name, 0, sizeof(ring->thread_name));
+    memset(ring->written_name, 0, sizeof(ring->written_name));
+    prctl(PR_GET_NAME, ring->thread_name, 0, 0, 0);
+
+    pthread_mutex_lock(&trace_lock);
+    trace_rings->push_back(ring);
+    pthread_mutex_unlock(&trace_lock);
+
+    pthread_setspecific(trace_ring_key, ring);
+    thread_ring = ring;
+    return ring;
+}
+
+/**
+ * Reserves the next event of the ring of the calling thread, or returns
+ * NULL and counts a drop if the ring is full.
+ */
+static TraceEvent *
+reserveEvent(TraceRing *ring, uint64_t &head)
+{
+    head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= TRACE_RING_EVENTS)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+    return &ring->events[head & (TRACE_RING_EVENTS - 1)];
+}
+
+static void
+recordBufferEvent(TraceEventType type, const void *queue, const char *owner,
+        NvTracer::Plane plane, int32_t index, int64_t timestamp_us)
+{
+    TraceRing *ring = getThreadRing();
+    uint64_t head;
+    TraceEvent *event = reserveEvent(ring, head);
+
+    if (!event)
+    {
+        return;
+    }
+    event->start_ns = NvTracer::now();
+    event->end_ns = event->start_ns;
+    event->timestamp_us = timestamp_us;
+    event->queue = (uintptr_t) queue;
+    event->name = NULL;
+    strncpy(event->owner, owner, TRACE_NAME_SIZE - 1);
+    event->owner[TRACE_NAME_SIZE - 1] = '\0';
+    event->index = index;
+    event->type = type;
+    event->plane = plane;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void
+NvTracer::recordSlice(const char *name, const char *owner, Plane plane,
+        int32_t index, int64_t timestamp_us, uint64_t start_ns)
+{
+    TraceRing *ring = getThreadRing();
+    uint64_t head;
+    TraceEvent *event = reserveEvent(ring, head);
+
+    if (!event)
+    {
+        return;
+    }
+    event->start_ns = start_ns;
+    event->end_ns = now();
+    event->timestamp_us = timestamp_us;
+    event->queue = 0;
+    event->name = name;
+    strncpy(event->owner, owner, TRACE_NAME_SIZE - 1);
+    event->owner[TRACE_NAME_SIZE - 1] = '\0';
+    event->index = index;
+    event->type = EVENT_SLICE;
+    event->plane = plane;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void
+NvTracer::recordQueued(const void *queue, const char *owner, Plane plane,
+        int32_t index, int64_t timestamp_us)
+{
+    recordBufferEvent(EVENT_QUEUED, queue, owner, plane, index, timestamp_us);
+}
+
+void
+NvTracer::recordDequeued(const void *queue, const char *owner, Plane plane,
+        int32_t index, int64_t timestamp_us)
+{
+    recordBufferEvent(EVENT_DEQUEUED, queue, owner, plane, index, timestamp_us);
+}
+
+void
+NvTracer::flush()
+{
+    if (!enabled)
+    {
+        return;
+    }
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file)
+    {
+        drainRings();
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+static void *
+drainThread(void *)
+{
+    struct timespec wakeup;
+
+    prctl(PR_SET_NAME, "NvTracer", 0, 0, 0);
+    pthread_mutex_lock(&trace_lock);
+    while (trace_draining)
+    {
+        clock_gettime(CLOCK_REALTIME, &wakeup);
+        wakeup.tv_nsec += TRACE_DRAIN_INTERVAL_MS * 1000000L;
+        wakeup.tv_sec += wakeup.tv_nsec / 1000000000L;
+        wakeup.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&trace_cond, &trace_lock, &wakeup);
+        drainRings();
+    }
+    pthread_mutex_unlock(&trace_lock);
+    return NULL;
+}
+
+/**
+ * Writes the last events and closes the trace when the application exits.
+ * Threads still running keep their rings, their later events are lost.
+ */
+static void
+closeTrace()
+{
+    pthread_mutex_lock(&trace_lock);
+    trace_draining = false;
+    pthread_cond_signal(&trace_cond);
+    pthread_mutex_unlock(&trace_lock);
+    pthread_join(trace_drain_thread, NULL);
+
+    pthread_mutex_lock(&trace_lock);
+    drainRings();
+    fputs("\n]\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+    pthread_mutex_unlock(&trace_lock);
+
+    if (trace_dropped)
+    {
+        CAT_WARN_MSG("Dropped " << trace_dropped << " trace events, the "
+                "rings of the tracing threads were full");
+    }
+}
+
+bool
+NvTracer::init()
+{
+    const char *path = getenv(TRACE_ENV);
+    char process_name[TRACE_NAME_SIZE] = "";
+
+    if (!path || !*path)
+    {
+        return false;
+    }
+
+    trace_file = fopen(path, "w");
+    if (!trace_file)
+    {
+        CAT_ERROR_MSG("Could not open trace file " << path << ": " <<
+                strerror(errno));
+        return false;
+    }
+    setvbuf(trace_file, NULL, _IOFBF, 1 << 20);
+
+    if (pthread_key_create(&trace_ring_key, threadExited))
+    {
+        CAT_ERROR_MSG("Could not create the trace thread key");
+        fclose(trace_file);
+        trace_file = NULL;
+        return false;
+    }
+
+    trace_rings = new vector<TraceRing *>;
+    trace_pid = getpid();
+    trace_base_ns = now();
+
+    prctl(PR_GET_NAME, process_name, 0, 0, 0);
+    fputc('[', trace_file);
+    writeSeparator();
+    fprintf(trace_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"args\":{\"name\":\"", trace_pid);
+    writeString(process_name);
+    fputs("\"}}", trace_file);
+
+    trace_draining = true;
+    if (pthread_create(&trace_drain_thread, NULL, drainThread, NULL))
+    {
+        CAT_ERROR_MSG("Could not create the trace drain thread");
+        fclose(trace_file);
+        trace_file = NULL;
+        return false;
+    }
+    atexit(closeTrace);
+
+    CAT_INFO_MSG("Tracing buffer lifecycles to " << path);
+    return true;
+}
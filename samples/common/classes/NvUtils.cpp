@@ -32,53 +32,275 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #include "nvbufsurface.h"
 
+#define CAT_NAME "NvUtils"
+
+/* Alignment of the staging buffer, which is also the O_DIRECT transfer
+   alignment (covers 512 and 4096 byte logical blocks). */
+#define VIDEO_FRAME_IO_ALIGNMENT 4096
+
+/* Number of rows gathered per preadv call. */
+#define VIDEO_FRAME_IO_MAX_ROWS 256
+
+/**
+ * Page aligned staging buffer used when the plane stride differs from the
+ * row size, so that a whole plane still moves in one I/O call. One buffer
+ * per thread, grown on demand and freed on thread exit.
+ */
+class VideoFrameStagingBuffer
+{
+public:
+    VideoFrameStagingBuffer() : data(NULL), size(0) {}
+    ~VideoFrameStagingBuffer() { free(data); }
+
+    unsigned char *get(size_t required)
+    {
+        if (required > size)
+        {
+            void *new_data = NULL;
+            size_t new_size = (required + VIDEO_FRAME_IO_ALIGNMENT - 1) &
+                ~((size_t) VIDEO_FRAME_IO_ALIGNMENT - 1);
+
+            if (posix_memalign(&new_data, VIDEO_FRAME_IO_ALIGNMENT, new_size))
+            {
+                CAT_ERROR_MSG("Could not allocate " << new_size <<
+                        " bytes for frame staging");
+                return NULL;
+            }
+            free(data);
+            data = (unsigned char *) new_data;
+            size = new_size;
+        }
+        return data;
+    }
+
+private:
+    unsigned char *data;
+    size_t size;
+};
+
+static thread_local VideoFrameStagingBuffer staging_buffer;
+
+static void
+copy_rows(unsigned char *dst, size_t dst_stride, const unsigned char *src,
+        size_t src_stride, size_t row_bytes, uint32_t rows)
+{
+    /* memcpy is vectorized by the C library and handles the row tails. */
+    for (uint32_t j = 0; j < rows; j++)
+    {
+        memcpy(dst, src, row_bytes);
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
 int
 read_video_frame(std::ifstream * stream, NvBuffer & buffer)
 {
-    uint32_t i, j;
-    char *data;
+    uint32_t i;
 
     for (i = 0; i < buffer.n_planes; i++)
     {
         NvBuffer::NvBufferPlane &plane = buffer.planes[i];
-        std::streamsize bytes_to_read =
+        std::streamsize row_bytes =
             plane.fmt.bytesperpixel * plane.fmt.width;
-        data = (char *) plane.data;
+        std::streamsize bytes_to_read = row_bytes * plane.fmt.height;
+
         plane.bytesused = 0;
-        for (j = 0; j < plane.fmt.height; j++)
+        if (plane.fmt.stride == row_bytes)
+        {
+            /* Rows are contiguous, read the plane in one go. */
+            stream->read((char *) plane.data, bytes_to_read);
+            if (stream->gcount() < bytes_to_read)
+                return -1;
+        }
+        else
         {
-            stream->read(data, bytes_to_read);
+            unsigned char *staging = staging_buffer.get(bytes_to_read);
+
+            if (!staging)
+                return -1;
+            stream->read((char *) staging, bytes_to_read);
             if (stream->gcount() < bytes_to_read)
                 return -1;
-            data += plane.fmt.stride;
+            copy_rows(plane.data, plane.fmt.stride, staging, row_bytes,
+                    row_bytes, plane.fmt.height);
         }
         plane.bytesused = plane.fmt.stride * plane.fmt.height;
     }
     return 0;
 }
 
+/* Reads into the iovecs at offset, resuming after short reads. */
+static int
+preadv_full(int fd, struct iovec *iov, int iovcnt, off_t offset)
+{
+    while (iovcnt > 0)
+    {
+        ssize_t ret = preadv(fd, iov, iovcnt, offset);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (ret == 0)
+            return -1;
+
+        offset += ret;
+        while (iovcnt > 0 && (size_t) ret >= iov->iov_len)
+        {
+            ret -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (char *) iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+    return 0;
+}
+
+/* Gathers the rows of the plane straight from the file. */
+static int
+read_plane_gather(int fd, off_t offset, NvBuffer::NvBufferPlane &plane)
+{
+    struct iovec iov[VIDEO_FRAME_IO_MAX_ROWS];
+    size_t row_bytes = plane.fmt.bytesperpixel * plane.fmt.width;
+    uint32_t row = 0;
+
+    if (plane.fmt.stride == row_bytes)
+    {
+        iov[0].iov_base = plane.data;
+        iov[0].iov_len = row_bytes * plane.fmt.height;
+        return preadv_full(fd, iov, 1, offset);
+    }
+
+    while (row < plane.fmt.height)
+    {
+        uint32_t rows = plane.fmt.height - row;
+
+        if (rows > VIDEO_FRAME_IO_MAX_ROWS)
+            rows = VIDEO_FRAME_IO_MAX_ROWS;
+        for (uint32_t j = 0; j < rows; j++)
+        {
+            iov[j].iov_base = plane.data + (size_t) (row + j) * plane.fmt.stride;
+            iov[j].iov_len = row_bytes;
+        }
+        if (preadv_full(fd, iov, rows, offset) < 0)
+            return -1;
+        offset += (off_t) rows * row_bytes;
+        row += rows;
+    }
+    return 0;
+}
+
+/* Reads the aligned blocks covering the plane into the staging buffer,
+   as required by O_DIRECT, and copies the rows out. */
+static int
+read_plane_direct(int fd, off_t offset, NvBuffer::NvBufferPlane &plane)
+{
+    size_t row_bytes = plane.fmt.bytesperpixel * plane.fmt.width;
+    size_t plane_bytes = row_bytes * plane.fmt.height;
+    off_t start = offset & ~((off_t) VIDEO_FRAME_IO_ALIGNMENT - 1);
+    size_t head = offset - start;
+    size_t length = (head + plane_bytes + VIDEO_FRAME_IO_ALIGNMENT - 1) &
+        ~((size_t) VIDEO_FRAME_IO_ALIGNMENT - 1);
+    unsigned char *staging = staging_buffer.get(length);
+    size_t done = 0;
+
+    if (!staging)
+        return -1;
+
+    /* The file may end inside the last block; only the plane must be there. */
+    while (done < head + plane_bytes)
+    {
+        ssize_t ret = pread(fd, staging + done, length - done, start + done);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (ret == 0)
+            return -1;
+        done += ret;
+    }
+
+    copy_rows(plane.data, plane.fmt.stride, staging + head, row_bytes,
+            row_bytes, plane.fmt.height);
+    return 0;
+}
+
+int
+read_video_frame(int fd, off_t * offset, NvBuffer & buffer)
+{
+    int flags = fcntl(fd, F_GETFL);
+    bool direct = (flags >= 0) && (flags & O_DIRECT);
+    off_t frame_offset = *offset;
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < buffer.n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = buffer.planes[i];
+
+        plane.bytesused = 0;
+        if (direct)
+            ret = read_plane_direct(fd, frame_offset, plane);
+        else
+            ret = read_plane_gather(fd, frame_offset, plane);
+        if (ret < 0)
+            return -1;
+
+        frame_offset += (off_t) plane.fmt.bytesperpixel * plane.fmt.width *
+            plane.fmt.height;
+        plane.bytesused = plane.fmt.stride * plane.fmt.height;
+    }
+    *offset = frame_offset;
+    return 0;
+}
+
 int
 write_video_frame(std::ofstream * stream, NvBuffer &buffer)
 {
-    uint32_t i, j;
-    char *data;
+    uint32_t i;
 
     for (i = 0; i < buffer.n_planes; i++)
     {
         NvBuffer::NvBufferPlane &plane = buffer.planes[i];
-        size_t bytes_to_write =
+        size_t row_bytes =
             plane.fmt.bytesperpixel * plane.fmt.width;
+        size_t bytes_to_write = row_bytes * plane.fmt.height;
 
-        data = (char *) plane.data;
-        for (j = 0; j < plane.fmt.height; j++)
+        if (plane.fmt.stride == row_bytes)
         {
-            stream->write(data, bytes_to_write);
-            if (!stream->good())
+            /* Rows are contiguous, write the plane in one go. */
+            stream->write((char *) plane.data, bytes_to_write);
+        }
+        else
+        {
+            unsigned char *staging = staging_buffer.get(bytes_to_write);
+
+            if (!staging)
                 return -1;
-            data += plane.fmt.stride;
+            copy_rows(staging, row_bytes, plane.data, plane.fmt.stride,
+                    row_bytes, plane.fmt.height);
+            stream->write((char *) staging, bytes_to_write);
         }
+        if (!stream->good())
+            return -1;
     }
     return 0;
 }
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvV4l2DQPoller.h"
+#include "NvLogging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+
+#define CAT_NAME "V4l2DQPoller"
+
+using namespace std;
+
+NvV4l2DQPoller::NvV4l2DQPoller(const char *name)
+    :name(name)
+{
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&cond, NULL);
+    thread = 0;
+    wake_fd = -1;
+    stop = false;
+    dispatching = NULL;
+    dev_ops = NULL;
+}
+
+NvV4l2DQPoller *
+NvV4l2DQPoller::createDQPoller(const char *name)
+{
+    NvV4l2DQPoller *poller = new NvV4l2DQPoller(name);
+
+    poller->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (poller->wake_fd == -1)
+    {
+        CAT_SYS_ERROR_MSG("Could not create eventfd");
+        delete poller;
+        return NULL;
+    }
+
+    if (pthread_create(&poller->thread, NULL, pollThread, poller))
+    {
+        CAT_ERROR_MSG("Could not create poller thread");
+        poller->thread = 0;
+        delete poller;
+        return NULL;
+    }
+
+    CAT_DEBUG_MSG("Created poller " << name);
+    return poller;
+}
+
+NvV4l2DQPoller::~NvV4l2DQPoller()
+{
+    vector<NvV4l2ElementPlane *>::iterator it;
+
+    if (thread)
+    {
+        pthread_mutex_lock(&lock);
+        stop = true;
+        pthread_mutex_unlock(&lock);
+        wake();
+        pthread_join(thread, NULL);
+    }
+
+    for (it = planes.begin(); it != planes.end(); ++it)
+    {
+        (*it)->dq_poller = NULL;
+        (*it)->setDQThreadStopped();
+    }
+
+    if (wake_fd != -1)
+    {
+        close(wake_fd);
+    }
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&cond);
+}
+
+uint32_t
+NvV4l2DQPoller::getNumPlanes()
+{
+    uint32_t num_planes;
+
+    pthread_mutex_lock(&lock);
+    num_planes = planes.size();
+    pthread_mutex_unlock(&lock);
+    return num_planes;
+}
+
+int
+NvV4l2DQPoller::addPlane(NvV4l2ElementPlane *plane)
+{
+    if (plane->blocking)
+    {
+        CAT_ERROR_MSG("Plane must be opened in non-blocking mode");
+        return -1;
+    }
+
+    pthread_mutex_lock(&lock);
+    if (!planes.empty() && plane->dev_ops != dev_ops)
+    {
+        pthread_mutex_unlock(&lock);
+        CAT_ERROR_MSG("Planes of a poller must share the device entry points");
+        return -1;
+    }
+    if (!planes.empty() && !plane->dev_ops->poll && plane->fd != planes[0]->fd)
+    {
+        pthread_mutex_unlock(&lock);
+        CAT_ERROR_MSG("Planes of a poller must share the device when it "
+                "cannot be polled");
+        return -1;
+    }
+    dev_ops = plane->dev_ops;
+    planes.push_back(plane);
+    pthread_mutex_unlock(&lock);
+
+    wake();
+    return 0;
+}
+
+void
+NvV4l2DQPoller::removePlane(NvV4l2ElementPlane *plane)
+{
+    vector<NvV4l2ElementPlane *>::iterator it;
+
+    pthread_mutex_lock(&lock);
+    it = find(planes.begin(), planes.end(), plane);
+    if (it != planes.end())
+    {
+        planes.erase(it);
+    }
+    if (!pthread_equal(pthread_self(), thread))
+    {
+        while (dispatching == plane)
+        {
+            pthread_cond_wait(&cond, &lock);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+
+    wake();
+}
+
+void
+NvV4l2DQPoller::wake()
+{
+    /* Also interrupts the DevicePoll control the thread may sleep in. */
+    if (NvV4l2ElementPlane::interruptDeviceWait(wake_fd) < 0)
+    {
+        CAT_SYS_ERROR_MSG("Error while waking poller thread");
+    }
+}
+
+bool
+NvV4l2DQPoller::servicePlane(NvV4l2ElementPlane *plane)
+{
+    uint32_t i;
+
+    /* Bound the work done per wakeup so that busy planes do not starve the
+       other planes. */
+    for (i = 0; i < plane->num_buffers; i++)
+    {
+        struct v4l2_buffer v4l2_buf;
+        struct v4l2_plane v4l2_planes[MAX_PLANES];
+        NvBuffer *buffer;
+        NvBuffer *shared_buffer;
+
+        memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+        memset(v4l2_planes, 0, sizeof(v4l2_planes));
+        v4l2_buf.m.planes = v4l2_planes;
+        v4l2_buf.length = plane->n_planes;
+
+        if (plane->dqBuffer(v4l2_buf, &buffer, &shared_buffer, -1) < 0)
+        {
+            if (errno == EAGAIN)
+            {
+                return plane->streamon;
+            }
+            plane->is_in_error = 1;
+            plane->callback(NULL, NULL, NULL, plane->dqThread_data);
+            return false;
+        }
+
+        if (!plane->callback(&v4l2_buf, buffer, shared_buffer,
+                    plane->dqThread_data))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void *
+NvV4l2DQPoller::pollThread(void *data)
+{
+    NvV4l2DQPoller *poller = (NvV4l2DQPoller *) data;
+    vector<NvV4l2ElementPlane *> polled;
+    vector<NvV4l2ElementPlane *> parked;
+    vector<struct pollfd> fds;
+    vector<NvV4l2ElementPlane *>::iterator it;
+    uint64_t value;
+    uint32_t i;
+    int timeout_ms;
+    int ret;
+
+    prctl(PR_SET_NAME, poller->name, 0, 0, 0);
+
+    pthread_mutex_lock(&poller->lock);
+    while (!poller->stop)
+    {
+        struct pollfd pfd;
+        const NvV4l2DeviceOps *ops = poller->dev_ops;
+        /* The planes of a device which cannot be polled all belong to the
+           same element, wait in its DevicePoll control instead. */
+        bool can_poll = !ops || ops->poll;
+        short device_events = 0;
+        int device_fd = -1;
+
+        fds.clear();
+        polled.clear();
+        timeout_ms = -1;
+
+        pfd.fd = poller->wake_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        fds.push_back(pfd);
+
+        for (it = poller->planes.begin(); it != poller->planes.end(); ++it)
+        {
+            /* M2M devices report an error while no buffer is queued on
+               either plane, check those planes again later. */
+            if (find(parked.begin(), parked.end(), *it) != parked.end())
+            {
+                timeout_ms = 1;
+                continue;
+            }
+            pfd.fd = (*it)->fd;
+            pfd.events =
+                ((*it)->buf_type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) ?
+                POLLIN : POLLOUT;
+            device_fd = pfd.fd;
+            device_events |= pfd.events;
+            fds.push_back(pfd);
+            polled.push_back(*it);
+        }
+        parked.clear();
+        pthread_mutex_unlock(&poller->lock);
+
+        if (can_poll)
+        {
+            ret = (ops ? ops->poll : poll)(&fds[0], fds.size(), timeout_ms);
+            if (ret < 0 && errno != EINTR)
+            {
+                CAT_SYS_ERROR_MSG("Error while polling");
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                if (read(poller->wake_fd, &value, sizeof(value)) < 0)
+                {
+                    CAT_SYS_ERROR_MSG("Error while reading eventfd");
+                }
+            }
+        }
+        else if (device_fd == -1)
+        {
+            /* Only parked planes, or none at all. */
+            ret = poll(&fds[0], 1, timeout_ms);
+            if (ret > 0 && read(poller->wake_fd, &value, sizeof(value)) < 0)
+            {
+                CAT_SYS_ERROR_MSG("Error while reading eventfd");
+            }
+        }
+        else
+        {
+            /* Check every plane after the wait, the DevicePoll control
+               only reports the events of the whole device. */
+            short revents = device_events;
+
+            if (NvV4l2ElementPlane::waitForDevice(ops, device_fd,
+                        poller->wake_fd, device_events, -1) < 0)
+            {
+                if (errno == EPIPE)
+                {
+                    revents = POLLERR;
+                }
+                else if (errno != ECANCELED)
+                {
+                    CAT_SYS_ERROR_MSG("Error while waiting for device");
+                }
+            }
+            for (i = 0; i < polled.size(); i++)
+            {
+                fds[i + 1].revents = revents;
+            }
+            ret = polled.size();
+        }
+
+        pthread_mutex_lock(&poller->lock);
+        for (i = 0; ret > 0 && i < polled.size() && !poller->stop; i++)
+        {
+            NvV4l2ElementPlane *plane = polled[i];
+            short events = fds[i + 1].events;
+            short revents = fds[i + 1].revents;
+            bool keep;
+
+            if (!revents)
+            {
+                continue;
+            }
+            it = find(poller->planes.begin(), poller->planes.end(), plane);
+            if (it == poller->planes.end())
+            {
+                continue;
+            }
+
+            if (!(revents & events))
+            {
+                if (plane->streamon)
+                {
+                    parked.push_back(plane);
+                    continue;
+                }
+                keep = false;
+            }
+            else
+            {
+                poller->dispatching = plane;
+                pthread_mutex_unlock(&poller->lock);
+
+                keep = servicePlane(plane);
+
+                pthread_mutex_lock(&poller->lock);
+                poller->dispatching = NULL;
+                pthread_cond_broadcast(&poller->cond);
+            }
+
+            if (!keep)
+            {
+                it = find(poller->planes.begin(), poller->planes.end(), plane);
+                if (it != poller->planes.end())
+                {
+                    poller->planes.erase(it);
+                    pthread_mutex_unlock(&poller->lock);
+                    plane->setDQThreadStopped();
+                    pthread_mutex_lock(&poller->lock);
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&poller->lock);
+
+    CAT_DEBUG_MSG("Exiting poller thread " << poller->name);
+    return NULL;
+}
@@ -28,11 +28,17 @@
 
 #include "NvV4l2Element.h"
 #include "NvLogging.h"
+#include "NvMetricsRegistry.h"
 
 #include <fcntl.h>
 #include <cstring>
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
 #include <libv4l2.h>
+#include <vector>
+#include <sys/eventfd.h>
 
 #define CAT_NAME "V4l2Element"
 
@@ -41,12 +47,49 @@ using namespace std;
 /*initialization of mutex for NvV4l2Element*/
 pthread_mutex_t initializer_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static int
+libv4l2_open(const char *dev_node, int flags)
+{
+    return v4l2_open(dev_node, flags);
+}
+
+static int
+libv4l2_close(int fd)
+{
+    return v4l2_close(fd);
+}
+
+static int
+libv4l2_ioctl(int fd, unsigned long int request, void *arg)
+{
+    return v4l2_ioctl(fd, request, arg);
+}
+
+static const NvV4l2DeviceOps libv4l2_device_ops =
+{
+    libv4l2_open,
+    libv4l2_close,
+    libv4l2_ioctl,
+    /* The libv4l2 plugin FDs do not report buffers or events to poll. */
+    NULL
+};
+
+static const NvV4l2DeviceOps *default_device_ops = &libv4l2_device_ops;
+
+void
+NvV4l2Element::setDeviceOps(const NvV4l2DeviceOps *ops)
+{
+    pthread_mutex_lock(&initializer_mutex);
+    default_device_ops = ops ? ops : &libv4l2_device_ops;
+    pthread_mutex_unlock(&initializer_mutex);
+}
+
 NvV4l2Element::NvV4l2Element(const char *comp_name, const char *dev_node, int flags, NvElementProfiler::ProfilerField fields)
     :NvElement(comp_name, fields),
       output_plane(V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, comp_name,
-                  fd, !(flags & O_NONBLOCK), profiler),
+                  fd, dev_ops, !(flags & O_NONBLOCK), profiler),
       capture_plane(V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE, comp_name,
-                  fd, !(flags & O_NONBLOCK), profiler)
+                  fd, dev_ops, !(flags & O_NONBLOCK), profiler)
 {
     struct v4l2_capability caps;
     int ret;
@@ -54,10 +97,12 @@ NvV4l2Element::NvV4l2Element(const char *comp_name, const char *dev_node, int fl
     app_data = NULL;
     output_plane_pixfmt = 0;
     capture_plane_pixfmt = 0;
+    event_abort_fd = -1;
 
     /*Synchronization issue of libv4l2 open source library fixing here,adding lock for that*/
     pthread_mutex_lock(&initializer_mutex);
-    fd = v4l2_open(dev_node, flags | O_RDWR);
+    dev_ops = default_device_ops;
+    fd = dev_ops->open(dev_node, flags | O_RDWR);
     if (fd == -1)
     {
         COMP_SYS_ERROR_MSG("Could not open device '" << dev_node << "'");
@@ -69,7 +114,15 @@ NvV4l2Element::NvV4l2Element(const char *comp_name, const char *dev_node, int fl
 
     COMP_DEBUG_MSG("Opened, fd = " << fd);
 
-    ret = v4l2_ioctl(fd, VIDIOC_QUERYCAP, &caps);
+    event_abort_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_abort_fd == -1)
+    {
+        COMP_SYS_ERROR_MSG("Could not create eventfd");
+        is_in_error = 1;
+        return;
+    }
+
+    ret = dev_ops->ioctl(fd, VIDIOC_QUERYCAP, &caps);
     if (ret != 0)
     {
         COMP_SYS_ERROR_MSG("Error in VIDIOC_QUERYCAP");
@@ -82,53 +135,167 @@ NvV4l2Element::NvV4l2Element(const char *comp_name, const char *dev_node, int fl
         is_in_error = 1;
         return;
     }
+
+    NvMetricsRegistry::getInstance().setElementQueues(metrics_id,
+            &output_plane.num_queued_buffers, &capture_plane.num_queued_buffers);
 }
 
 NvV4l2Element::~NvV4l2Element()
 {
+    /* The planes go away before the base class unregisters. */
+    NvMetricsRegistry::getInstance().setElementQueues(metrics_id, NULL, NULL);
+
     output_plane.deinitPlane();
     capture_plane.deinitPlane();
 
     if (fd != -1)
     {
-        v4l2_close(fd);
+        dev_ops->close(fd);
         CAT_DEBUG_MSG("Device closed, fd = " << fd);
     }
+    if (event_abort_fd != -1)
+    {
+        close(event_abort_fd);
+    }
 }
 
 int
 NvV4l2Element::dqEvent(struct v4l2_event &ev, uint32_t max_wait_ms)
 {
+    struct timespec start, now;
+    uint64_t elapsed_ms;
+    int wait_ms;
     int ret;
 
-    do
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (true)
     {
-        ret = v4l2_ioctl(fd, VIDIOC_DQEVENT, &ev);
+        ret = dev_ops->ioctl(fd, VIDIOC_DQEVENT, &ev);
 
         if (ret == 0)
         {
             COMP_DEBUG_MSG("DQed event " << hex << ev.type << dec);
+            break;
         }
         else if (errno != EAGAIN)
         {
             COMP_SYS_ERROR_MSG("Error while DQing event");
             break;
         }
-        else if (max_wait_ms-- == 0)
+        else if (!output_plane.getStreamStatus() &&
+                !capture_plane.getStreamStatus())
+        {
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 +
+            (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed_ms >= max_wait_ms)
         {
             COMP_WARN_MSG("Error while DQing event: Resource temporarily unavailable");
+            errno = EAGAIN;
             break;
         }
-        else
+        wait_ms = (max_wait_ms - elapsed_ms > INT_MAX) ? -1 :
+            max_wait_ms - elapsed_ms;
+
+        if (NvV4l2ElementPlane::waitForDevice(dev_ops, fd, event_abort_fd,
+                    POLLPRI, wait_ms) < 0)
+        {
+            if (errno == ECANCELED)
+            {
+                COMP_DEBUG_MSG("Wait for event interrupted");
+                break;
+            }
+            if (errno == EPIPE)
+            {
+                /* Nothing to wait for until a buffer is queued. */
+                usleep(1000);
+            }
+        }
+    }
+
+    return ret;
+}
+
+bool
+NvV4l2Element::isPollable()
+{
+    return dev_ops->poll != NULL;
+}
+
+int
+NvV4l2Element::pollElements(NvV4l2Element **elements, uint32_t num_elements,
+        bool *ready, int max_wait_ms)
+{
+    std::vector<struct pollfd> fds(num_elements);
+    const NvV4l2DeviceOps *ops;
+    uint32_t i;
+    int ret;
+
+    if (num_elements == 0)
+    {
+        CAT_ERROR_MSG("No element to poll");
+        errno = EINVAL;
+        return -1;
+    }
+
+    ops = elements[0]->dev_ops;
+    for (i = 0; i < num_elements; i++)
+    {
+        NvV4l2Element *element = elements[i];
+
+        if (element->dev_ops != ops || !ops->poll)
         {
-            usleep(1000);
+            CAT_ERROR_MSG("Elements must share device entry points which can poll");
+            errno = EOPNOTSUPP;
+            return -1;
+        }
+        fds[i].fd = element->fd;
+        fds[i].events = POLLPRI;
+        fds[i].revents = 0;
+        /* M2M devices report an error on a plane with nothing queued. */
+        if (element->output_plane.getStreamStatus() &&
+                element->output_plane.getNumQueuedBuffers() > 0)
+        {
+            fds[i].events |= POLLOUT;
+        }
+        if (element->capture_plane.getStreamStatus() &&
+                element->capture_plane.getNumQueuedBuffers() > 0)
+        {
+            fds[i].events |= POLLIN;
         }
     }
-    while (ret && (output_plane.getStreamStatus() || capture_plane.getStreamStatus()));
 
+    if (ops->poll(&fds[0], num_elements, max_wait_ms) < 0 && errno != EINTR)
+    {
+        CAT_SYS_ERROR_MSG("Error while polling");
+        return -1;
+    }
+
+    ret = 0;
+    for (i = 0; i < num_elements; i++)
+    {
+        ready[i] = fds[i].revents != 0;
+        if (ready[i])
+        {
+            ret++;
+        }
+    }
     return ret;
 }
 
+void
+NvV4l2Element::interruptWait()
+{
+    if (NvV4l2ElementPlane::interruptDeviceWait(event_abort_fd) < 0)
+    {
+        COMP_SYS_ERROR_MSG("Error while interrupting wait");
+    }
+}
+
 int
 NvV4l2Element::setControl(uint32_t id, int32_t value)
 {
@@ -138,7 +305,7 @@ NvV4l2Element::setControl(uint32_t id, int32_t value)
     ctl.id = id;
     ctl.value = value;
 
-    ret = v4l2_ioctl(fd, VIDIOC_S_CTRL, &ctl);
+    ret = dev_ops->ioctl(fd, VIDIOC_S_CTRL, &ctl);
 
     if (ret < 0)
     {
@@ -160,7 +327,7 @@ NvV4l2Element::getControl(uint32_t id, int32_t &value)
 
     ctl.id = id;
 
-    ret = v4l2_ioctl(fd, VIDIOC_G_CTRL, &ctl);
+    ret = dev_ops->ioctl(fd, VIDIOC_G_CTRL, &ctl);
 
     if (ret < 0)
     {
@@ -179,7 +346,7 @@ NvV4l2Element::setExtControls(v4l2_ext_controls &ctl)
 {
     int ret;
 
-    ret = v4l2_ioctl(fd, VIDIOC_S_EXT_CTRLS, &ctl);
+    ret = dev_ops->ioctl(fd, VIDIOC_S_EXT_CTRLS, &ctl);
 
     if (ret < 0)
     {
@@ -197,7 +364,7 @@ NvV4l2Element::getExtControls(v4l2_ext_controls &ctl)
 {
     int ret;
 
-    ret = v4l2_ioctl(fd, VIDIOC_G_EXT_CTRLS, &ctl);
+    ret = dev_ops->ioctl(fd, VIDIOC_G_EXT_CTRLS, &ctl);
 
     if (ret < 0)
     {
@@ -222,7 +389,7 @@ NvV4l2Element::subscribeEvent(uint32_t type, uint32_t id, uint32_t flags)
     sub.id = id;
     sub.flags = flags;
 
-    ret = v4l2_ioctl(fd, VIDIOC_SUBSCRIBE_EVENT, &sub);
+    ret = dev_ops->ioctl(fd, VIDIOC_SUBSCRIBE_EVENT, &sub);
     if (ret == 0)
     {
         COMP_DEBUG_MSG("Successfully subscribed to event " << type);
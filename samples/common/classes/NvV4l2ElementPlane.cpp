@@ -27,11 +27,17 @@
  */
 
 #include "NvV4l2ElementPlane.h"
+#include "NvV4l2DQPoller.h"
 #include "NvLogging.h"
+#include "NvTracer.h"
 
 #include <cstring>
 #include <errno.h>
-#include <libv4l2.h>
+#include <list>
+#include <map>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <sys/prctl.h>
 #include "nvbufsurface.h"
@@ -45,12 +51,19 @@
         return 0;                                \
     }
 
+#define TRACE_PLANE \
+    (V4L2_TYPE_IS_OUTPUT(buf_type) ? NvTracer::PLANE_OUTPUT : \
+     NvTracer::PLANE_CAPTURE)
+
+#define TIMEVAL_USEC(tv) ((int64_t) (tv).tv_sec * 1000000 + (tv).tv_usec)
+
 using namespace std;
 
 NvV4l2ElementPlane::NvV4l2ElementPlane(enum v4l2_buf_type buf_type,
-        const char *device_name, int &fd, bool blocking,
-        NvElementProfiler &profiler)
+        const char *device_name, int &fd, const NvV4l2DeviceOps *&dev_ops,
+        bool blocking, NvElementProfiler &profiler)
     :fd(fd),
+     dev_ops(dev_ops),
      v4l2elem_profiler(profiler),
      comp_name(device_name)
 {
@@ -88,8 +101,16 @@ NvV4l2ElementPlane::NvV4l2ElementPlane(enum v4l2_buf_type buf_type,
     dqthread_running = false;
     stop_dqthread = false;
     dq_thread = 0;
+    dq_poller = NULL;
     callback = NULL;
 
+    wait_abort_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wait_abort_fd == -1)
+    {
+        PLANE_SYS_ERROR_MSG("Could not create eventfd");
+        is_in_error = 1;
+    }
+
     memory_type = V4L2_MEMORY_MMAP;
 
     dqThread_data = NULL;
@@ -97,6 +118,10 @@ NvV4l2ElementPlane::NvV4l2ElementPlane(enum v4l2_buf_type buf_type,
 
 NvV4l2ElementPlane::~NvV4l2ElementPlane()
 {
+    if (wait_abort_fd != -1)
+    {
+        close(wait_abort_fd);
+    }
     pthread_mutex_destroy(&plane_lock);
     pthread_cond_destroy(&plane_cond);
 }
@@ -118,18 +143,20 @@ NvV4l2ElementPlane::dqBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer ** buffer,
         NvBuffer ** shared_buffer, uint32_t num_retries)
 {
     int ret;
+    NvTraceScope trace("dqBuffer", comp_name, TRACE_PLANE);
 
     v4l2_buf.type = buf_type;
     v4l2_buf.memory = memory_type;
     do
     {
-        ret = v4l2_ioctl(fd, VIDIOC_DQBUF, &v4l2_buf);
+        ret = dev_ops->ioctl(fd, VIDIOC_DQBUF, &v4l2_buf);
 
         if (ret == 0)
         {
             pthread_mutex_lock(&plane_lock);
             if (buffer)
                 *buffer = buffers[v4l2_buf.index];
+            buffers[v4l2_buf.index]->queued = false;
             if (shared_buffer && memory_type == V4L2_MEMORY_DMABUF)
             {
                 *shared_buffer =
@@ -151,6 +178,13 @@ NvV4l2ElementPlane::dqBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer ** buffer,
             pthread_cond_broadcast(&plane_cond);
             PLANE_DEBUG_MSG("DQed buffer " << v4l2_buf.index);
             pthread_mutex_unlock(&plane_lock);
+
+            trace.setBuffer(v4l2_buf.index, TIMEVAL_USEC(v4l2_buf.timestamp));
+            if (NvTracer::isEnabled())
+            {
+                NvTracer::recordDequeued(this, comp_name, TRACE_PLANE,
+                        v4l2_buf.index, TIMEVAL_USEC(v4l2_buf.timestamp));
+            }
         }
         else if (errno == EAGAIN)
         {
@@ -181,19 +215,56 @@ NvV4l2ElementPlane::dqBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer ** buffer,
     }
     while (ret && !is_in_error);
 
+    /* Only dequeued buffers are traced, not empty polls. */
+    if (ret)
+    {
+        trace.discard();
+    }
     return ret;
 }
 
+int
+NvV4l2ElementPlane::dqBuffer(struct v4l2_buffer &v4l2_buf, NvBufferRef &buffer,
+        uint32_t num_retries)
+{
+    NvBuffer *dq_buffer;
+
+    buffer.reset();
+    if (dqBuffer(v4l2_buf, &dq_buffer, NULL, num_retries) < 0)
+    {
+        return -1;
+    }
+
+    if (buf_type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        buffer = NvBufferRef(dq_buffer, this);
+    }
+    else
+    {
+        buffer = NvBufferRef(dq_buffer);
+    }
+    return 0;
+}
+
 int
 NvV4l2ElementPlane::qBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer * shared_buffer)
 {
     int ret;
     uint32_t i;
     NvBuffer *buffer;
+    NvTraceScope trace("qBuffer", comp_name, TRACE_PLANE);
 
     pthread_mutex_lock(&plane_lock);
     buffer = buffers[v4l2_buf.index];
 
+    if (buffer->queued)
+    {
+        PLANE_ERROR_MSG("Buffer " << v4l2_buf.index << " is already queued");
+        pthread_mutex_unlock(&plane_lock);
+        trace.discard();
+        return -1;
+    }
+
     v4l2_buf.type = buf_type;
     v4l2_buf.memory = memory_type;
     v4l2_buf.length = n_planes;
@@ -249,7 +320,7 @@ NvV4l2ElementPlane::qBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer * shared_buff
         v4l2elem_profiler.startProcessing();
     }
 
-    ret = v4l2_ioctl(fd, VIDIOC_QBUF, &v4l2_buf);
+    ret = dev_ops->ioctl(fd, VIDIOC_QBUF, &v4l2_buf);
     if (ret)
     {
         is_in_error = 1;
@@ -261,6 +332,14 @@ NvV4l2ElementPlane::qBuffer(struct v4l2_buffer &v4l2_buf, NvBuffer * shared_buff
         pthread_cond_broadcast(&plane_cond);
         total_queued_buffers++;
         num_queued_buffers++;
+        buffer->queued = true;
+
+        trace.setBuffer(v4l2_buf.index, TIMEVAL_USEC(v4l2_buf.timestamp));
+        if (NvTracer::isEnabled())
+        {
+            NvTracer::recordQueued(this, comp_name, TRACE_PLANE,
+                    v4l2_buf.index, TIMEVAL_USEC(v4l2_buf.timestamp));
+        }
     }
     pthread_mutex_unlock(&plane_lock);
 
@@ -366,7 +445,7 @@ int
 NvV4l2ElementPlane::getFormat(struct v4l2_format &format)
 {
     format.type = buf_type;
-    CHECK_V4L2_RETURN(v4l2_ioctl(fd, VIDIOC_G_FMT, &format),
+    CHECK_V4L2_RETURN(dev_ops->ioctl(fd, VIDIOC_G_FMT, &format),
             "Getting format");
 }
 
@@ -377,7 +456,7 @@ NvV4l2ElementPlane::setFormat(struct v4l2_format &format)
     int j;
 
     format.type = buf_type;
-    ret = v4l2_ioctl(fd, VIDIOC_S_FMT, &format);
+    ret = dev_ops->ioctl(fd, VIDIOC_S_FMT, &format);
     if (ret)
     {
         PLANE_SYS_ERROR_MSG("Error in VIDIOC_S_FMT");
@@ -402,7 +481,7 @@ NvV4l2ElementPlane::getCrop(struct v4l2_crop & crop)
 {
     crop.type = buf_type;
 
-    CHECK_V4L2_RETURN(v4l2_ioctl(fd, VIDIOC_G_CROP, &crop),
+    CHECK_V4L2_RETURN(dev_ops->ioctl(fd, VIDIOC_G_CROP, &crop),
             "Getting crop params");
 }
 
@@ -428,7 +507,7 @@ NvV4l2ElementPlane::setSelection(uint32_t target, uint32_t flags, struct v4l2_re
     select.flags = flags;
     select.r = rect;
 
-    CHECK_V4L2_RETURN(v4l2_ioctl(fd, VIDIOC_S_SELECTION, &select),
+    CHECK_V4L2_RETURN(dev_ops->ioctl(fd, VIDIOC_S_SELECTION, &select),
             "Setting selection");
 }
 
@@ -504,7 +583,7 @@ NvV4l2ElementPlane::reqbufs(enum v4l2_memory mem_type, uint32_t num)
     memory_type = mem_type;
 
     reqbufs.memory = mem_type;
-    ret = v4l2_ioctl(fd, VIDIOC_REQBUFS, &reqbufs);
+    ret = dev_ops->ioctl(fd, VIDIOC_REQBUFS, &reqbufs);
     if (ret)
     {
         PLANE_SYS_ERROR_MSG("Error in VIDIOC_REQBUFS at output plane");
@@ -551,11 +630,11 @@ NvV4l2ElementPlane::setStreamStatus(bool status)
     pthread_mutex_lock(&plane_lock);
     if (status)
     {
-        ret = v4l2_ioctl(fd, VIDIOC_STREAMON, &buf_type);
+        ret = dev_ops->ioctl(fd, VIDIOC_STREAMON, &buf_type);
     }
     else
     {
-        ret = v4l2_ioctl(fd, VIDIOC_STREAMOFF, &buf_type);
+        ret = dev_ops->ioctl(fd, VIDIOC_STREAMOFF, &buf_type);
     }
     if (ret)
     {
@@ -569,8 +648,23 @@ NvV4l2ElementPlane::setStreamStatus(bool status)
         streamon = status;
         if (!streamon)
         {
+            /* STREAMOFF returns all queued buffers to the application. */
+            for (uint32_t i = 0; i < num_buffers; i++)
+            {
+                buffers[i]->queued = false;
+            }
             num_queued_buffers = 0;
             pthread_cond_broadcast(&plane_cond);
+
+            /* Wake up the DQ Thread so that it sees the stream stopped. */
+            if (dqthread_running && dq_poller)
+            {
+                dq_poller->wake();
+            }
+            else if (dqthread_running)
+            {
+                interruptWait();
+            }
         }
 
         if (buf_type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
@@ -599,7 +693,7 @@ NvV4l2ElementPlane::setStreamParms(struct v4l2_streamparm &parm)
     int ret;
 
     parm.type = buf_type;
-    ret = v4l2_ioctl(fd, VIDIOC_S_PARM, &parm);
+    ret = dev_ops->ioctl(fd, VIDIOC_S_PARM, &parm);
 
     if(ret == 0)
     {
@@ -628,7 +722,7 @@ NvV4l2ElementPlane::queryBuffer(uint32_t i)
     v4l2_buf.m.planes = planes;
     v4l2_buf.length = n_planes;
 
-    ret = v4l2_ioctl(fd, VIDIOC_QUERYBUF, &v4l2_buf);
+    ret = dev_ops->ioctl(fd, VIDIOC_QUERYBUF, &v4l2_buf);
     if (ret)
     {
         PLANE_SYS_ERROR_MSG("Error in QueryBuf for " << i << "th buffer");
@@ -663,7 +757,7 @@ NvV4l2ElementPlane::exportBuffer(uint32_t i)
     for (j = 0; j < n_planes; j++)
     {
         expbuf.plane = j;
-        ret = v4l2_ioctl(fd, VIDIOC_EXPBUF, &expbuf);
+        ret = dev_ops->ioctl(fd, VIDIOC_EXPBUF, &expbuf);
         if (ret)
         {
             PLANE_SYS_ERROR_MSG("Error in ExportBuf for Buffer " << i <<
@@ -795,6 +889,365 @@ NvV4l2ElementPlane::waitAllBuffersDequeued(uint32_t max_wait_ms)
     CHECK_V4L2_RETURN(return_val, "Waiting for all buffers to get dequeued");
 }
 
+/*
+ * Devices which cannot be polled (see NvV4l2DeviceOps::poll) are waited on
+ * with the DevicePoll control, V4L2_CID_MPEG_VIDEO_DEVICE_POLL. A wait is
+ * woken up by clearing the poll interrupt of the device with
+ * V4L2_CID_MPEG_SET_POLL_INTERRUPT, as NvVideoDecoder::ClearPollInterrupt()
+ * does. The interrupt belongs to the device and wakes up all its waits, so
+ * it is set again, letting the waits sleep, only once every interrupted wait
+ * of the device has returned. Timed waits are interrupted at their deadline
+ * by a timer thread, started on the first timed wait.
+ */
+typedef struct
+{
+    const NvV4l2DeviceOps *ops;
+    int fd;
+    int abort_fd;
+    bool timed;
+    struct timespec deadline;
+    bool interrupted;
+} DevicePollWait;
+
+static pthread_mutex_t device_poll_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t device_poll_timer_cond;
+static bool device_poll_timer_started = false;
+static list<DevicePollWait *> device_poll_waits;
+/* Number of interrupted waits of each device FD. */
+static map<int, uint32_t> device_poll_interrupts;
+
+static int
+setDevicePollInterrupt(const NvV4l2DeviceOps *ops, int fd, int32_t value)
+{
+    struct v4l2_ext_control control;
+    struct v4l2_ext_controls ctrls;
+
+    memset(&control, 0, sizeof(control));
+    memset(&ctrls, 0, sizeof(ctrls));
+
+    ctrls.count = 1;
+    ctrls.controls = &control;
+
+    control.id = V4L2_CID_MPEG_SET_POLL_INTERRUPT;
+    control.value = value;
+
+    return ops->ioctl(fd, VIDIOC_S_EXT_CTRLS, &ctrls);
+}
+
+/* Called with device_poll_lock held. */
+static void
+interruptDevicePollWait(DevicePollWait *wait)
+{
+    if (wait->interrupted)
+    {
+        return;
+    }
+    wait->interrupted = true;
+    if (device_poll_interrupts[wait->fd]++ == 0 &&
+            setDevicePollInterrupt(wait->ops, wait->fd, 0) < 0)
+    {
+        SYS_ERROR_MSG("Error while clearing poll interrupt");
+    }
+}
+
+static bool
+consumeInterrupt(int abort_fd)
+{
+    uint64_t value;
+
+    return read(abort_fd, &value, sizeof(value)) == sizeof(value);
+}
+
+static bool
+isBefore(const struct timespec &a, const struct timespec &b)
+{
+    return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+
+static void *
+devicePollTimer(void *data)
+{
+    prctl(PR_SET_NAME, "V4l2PollTimer", 0, 0, 0);
+
+    pthread_mutex_lock(&device_poll_lock);
+    while (true)
+    {
+        list<DevicePollWait *>::iterator it;
+        struct timespec now;
+        struct timespec next;
+        bool pending = false;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (it = device_poll_waits.begin(); it != device_poll_waits.end(); ++it)
+        {
+            DevicePollWait *wait = *it;
+
+            if (!wait->timed || wait->interrupted)
+            {
+                continue;
+            }
+            if (!isBefore(now, wait->deadline))
+            {
+                interruptDevicePollWait(wait);
+            }
+            else if (!pending || isBefore(wait->deadline, next))
+            {
+                next = wait->deadline;
+                pending = true;
+            }
+        }
+
+        if (pending)
+        {
+            pthread_cond_timedwait(&device_poll_timer_cond, &device_poll_lock,
+                    &next);
+        }
+        else
+        {
+            pthread_cond_wait(&device_poll_timer_cond, &device_poll_lock);
+        }
+    }
+    pthread_mutex_unlock(&device_poll_lock);
+    return NULL;
+}
+
+/* Called with device_poll_lock held. */
+static int
+startDevicePollTimer()
+{
+    pthread_condattr_t attr;
+    pthread_t thread;
+
+    if (device_poll_timer_started)
+    {
+        return 0;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&device_poll_timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&thread, NULL, devicePollTimer, NULL))
+    {
+        ERROR_MSG("Could not create device poll timer thread");
+        pthread_cond_destroy(&device_poll_timer_cond);
+        return -1;
+    }
+    pthread_detach(thread);
+    device_poll_timer_started = true;
+    return 0;
+}
+
+static int
+waitForDevicePoll(const NvV4l2DeviceOps *ops, int fd, int abort_fd,
+        short events, int max_wait_ms)
+{
+    v4l2_ctrl_video_device_poll devicepoll;
+    struct v4l2_ext_control control;
+    struct v4l2_ext_controls ctrls;
+    DevicePollWait wait;
+    map<int, uint32_t>::iterator interrupts;
+    struct timespec now;
+    bool aborted;
+    bool timed_out = false;
+    int poll_errno;
+    int ret;
+
+    wait.ops = ops;
+    wait.fd = fd;
+    wait.abort_fd = abort_fd;
+    wait.timed = max_wait_ms >= 0;
+    wait.interrupted = false;
+    if (wait.timed)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &wait.deadline);
+        wait.deadline.tv_sec += max_wait_ms / 1000;
+        wait.deadline.tv_nsec += (max_wait_ms % 1000) * 1000000L;
+        if (wait.deadline.tv_nsec >= 1000000000L)
+        {
+            wait.deadline.tv_sec++;
+            wait.deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&device_poll_lock);
+    if (consumeInterrupt(abort_fd))
+    {
+        pthread_mutex_unlock(&device_poll_lock);
+        errno = ECANCELED;
+        return -1;
+    }
+    if (max_wait_ms == 0 || (wait.timed && startDevicePollTimer() < 0))
+    {
+        pthread_mutex_unlock(&device_poll_lock);
+        errno = EAGAIN;
+        return -1;
+    }
+    /* Let the poll sleep, unless other waits of the device are still being
+       interrupted. */
+    if (device_poll_interrupts.find(fd) == device_poll_interrupts.end() &&
+            setDevicePollInterrupt(ops, fd, 1) < 0)
+    {
+        pthread_mutex_unlock(&device_poll_lock);
+        return -1;
+    }
+    device_poll_waits.push_back(&wait);
+    if (wait.timed)
+    {
+        pthread_cond_signal(&device_poll_timer_cond);
+    }
+    pthread_mutex_unlock(&device_poll_lock);
+
+    memset(&devicepoll, 0, sizeof(devicepoll));
+    memset(&control, 0, sizeof(control));
+    memset(&ctrls, 0, sizeof(ctrls));
+
+    devicepoll.req_events = events | POLLERR;
+    ctrls.count = 1;
+    ctrls.controls = &control;
+    control.id = V4L2_CID_MPEG_VIDEO_DEVICE_POLL;
+    control.string = (char *) &devicepoll;
+
+    ret = ops->ioctl(fd, VIDIOC_S_EXT_CTRLS, &ctrls);
+    poll_errno = errno;
+
+    pthread_mutex_lock(&device_poll_lock);
+    device_poll_waits.remove(&wait);
+    interrupts = device_poll_interrupts.find(fd);
+    if (wait.interrupted && --interrupts->second == 0)
+    {
+        device_poll_interrupts.erase(interrupts);
+    }
+    aborted = consumeInterrupt(abort_fd);
+    if (wait.timed)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timed_out = !isBefore(now, wait.deadline);
+    }
+    pthread_mutex_unlock(&device_poll_lock);
+
+    if (ret < 0)
+    {
+        errno = poll_errno;
+        return -1;
+    }
+    if (aborted)
+    {
+        errno = ECANCELED;
+        return -1;
+    }
+    if (devicepoll.resp_events & events)
+    {
+        return 0;
+    }
+    if (timed_out)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (devicepoll.resp_events & POLLERR)
+    {
+        errno = EPIPE;
+        return -1;
+    }
+    /* Woken up by the interrupt of another wait of the device. */
+    return 0;
+}
+
+int
+NvV4l2ElementPlane::interruptDeviceWait(int abort_fd)
+{
+    list<DevicePollWait *>::iterator it;
+    uint64_t value = 1;
+
+    if (write(abort_fd, &value, sizeof(value)) < 0)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&device_poll_lock);
+    for (it = device_poll_waits.begin(); it != device_poll_waits.end(); ++it)
+    {
+        if ((*it)->abort_fd == abort_fd)
+        {
+            interruptDevicePollWait(*it);
+        }
+    }
+    pthread_mutex_unlock(&device_poll_lock);
+    return 0;
+}
+
+int
+NvV4l2ElementPlane::waitForDevice(const NvV4l2DeviceOps *ops, int fd,
+        int abort_fd, short events, int max_wait_ms)
+{
+    struct pollfd fds[2];
+    uint64_t value;
+    int ret;
+
+    if (!ops->poll)
+    {
+        return waitForDevicePoll(ops, fd, abort_fd, events, max_wait_ms);
+    }
+
+    fds[0].fd = fd;
+    fds[0].events = events;
+    fds[1].fd = abort_fd;
+    fds[1].events = POLLIN;
+
+    do
+    {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        ret = ops->poll(fds, 2, max_wait_ms);
+    }
+    while (ret < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        return -1;
+    }
+    if (ret == 0)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (fds[1].revents & POLLIN)
+    {
+        if (read(abort_fd, &value, sizeof(value)) < 0)
+        {
+            return -1;
+        }
+        errno = ECANCELED;
+        return -1;
+    }
+    if (!(fds[0].revents & events))
+    {
+        errno = EPIPE;
+        return -1;
+    }
+    return 0;
+}
+
+int
+NvV4l2ElementPlane::waitForBuffer(int max_wait_ms)
+{
+    short events = (buf_type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) ?
+        POLLIN : POLLOUT;
+
+    return waitForDevice(dev_ops, fd, wait_abort_fd, events, max_wait_ms);
+}
+
+void
+NvV4l2ElementPlane::interruptWait()
+{
+    if (interruptDeviceWait(wait_abort_fd) < 0)
+    {
+        PLANE_SYS_ERROR_MSG("Error while interrupting wait");
+    }
+}
+
 bool NvV4l2ElementPlane::setDQThreadCallback(dqThreadCallback callback)
 {
     if (dqthread_running)
@@ -828,6 +1281,23 @@ NvV4l2ElementPlane::dqThread(void *data)
 
         if (plane->dqBuffer(v4l2_buf, &buffer, &shared_buffer, -1) < 0)
         {
+            if (errno == EAGAIN && !plane->blocking && plane->streamon)
+            {
+                /* Sleep until a buffer is ready, stopDQThread interrupts
+                   the wait. */
+                if (plane->waitForBuffer(-1) == 0 || errno == ECANCELED)
+                {
+                    continue;
+                }
+                if (errno == EPIPE && plane->streamon)
+                {
+                    /* M2M devices report an error while no buffer is
+                       queued on either plane, nothing to wait for. */
+                    usleep(1000);
+                    continue;
+                }
+                errno = EAGAIN;
+            }
             if (errno != EAGAIN)
             {
                 plane->is_in_error = 1;
@@ -843,6 +1313,11 @@ NvV4l2ElementPlane::dqThread(void *data)
         }
         else
         {
+            NvTraceScope trace("dqCallback", comp_name,
+                    V4L2_TYPE_IS_OUTPUT(plane->buf_type) ?
+                    NvTracer::PLANE_OUTPUT : NvTracer::PLANE_CAPTURE);
+            trace.setBuffer(v4l2_buf.index, TIMEVAL_USEC(v4l2_buf.timestamp));
+
             ret = plane->callback(&v4l2_buf, buffer, shared_buffer,
                     plane->dqThread_data);
         }
@@ -853,16 +1328,22 @@ NvV4l2ElementPlane::dqThread(void *data)
     }
     plane->stop_dqthread = false;
 
-    pthread_mutex_lock(&plane->plane_lock);
-    plane->dqthread_running = false;
-    pthread_cond_broadcast(&plane->plane_cond);
-    pthread_mutex_unlock(&plane->plane_lock);
+    plane->setDQThreadStopped();
     PLANE_DEBUG_MSG("Exiting DQthread");
     return NULL;
 }
 
+void
+NvV4l2ElementPlane::setDQThreadStopped()
+{
+    pthread_mutex_lock(&plane_lock);
+    dqthread_running = false;
+    pthread_cond_broadcast(&plane_cond);
+    pthread_mutex_unlock(&plane_lock);
+}
+
 int
-NvV4l2ElementPlane::startDQThread(void *data)
+NvV4l2ElementPlane::startDQThread(void *data, NvV4l2DQPoller *poller)
 {
     pthread_mutex_lock(&plane_lock);
     if (dqthread_running)
@@ -872,7 +1353,19 @@ NvV4l2ElementPlane::startDQThread(void *data)
         return 0;
     }
     dqThread_data = data;
-    pthread_create(&dq_thread, NULL, dqThread, this);
+    if (poller)
+    {
+        if (poller->addPlane(this) < 0)
+        {
+            pthread_mutex_unlock(&plane_lock);
+            return -1;
+        }
+        dq_poller = poller;
+    }
+    else
+    {
+        pthread_create(&dq_thread, NULL, dqThread, this);
+    }
     dqthread_running = true;
     pthread_mutex_unlock(&plane_lock);
     PLANE_DEBUG_MSG("Started DQ Thread");
@@ -882,14 +1375,34 @@ NvV4l2ElementPlane::startDQThread(void *data)
 int
 NvV4l2ElementPlane::stopDQThread()
 {
+    uint64_t value;
+
+    if (dq_poller)
+    {
+        dq_poller->removePlane(this);
+        dq_poller = NULL;
+        setDQThreadStopped();
+        PLANE_DEBUG_MSG("Removed from DQ poller");
+        return 0;
+    }
     if (blocking)
     {
         PLANE_WARN_MSG("Should not be called in blocking mode");
         return 0;
     }
+    if (!dq_thread)
+    {
+        return 0;
+    }
     stop_dqthread = true;
+    interruptWait();
     pthread_join(dq_thread, NULL);
     dq_thread = 0;
+    /* Drop the interrupt if the thread did not consume it. */
+    if (read(wait_abort_fd, &value, sizeof(value)) < 0)
+    {
+        PLANE_DEBUG_MSG("DQ Thread consumed the interrupt");
+    }
     PLANE_DEBUG_MSG("Stopped DQ Thread");
     return 0;
 }
@@ -921,11 +1434,28 @@ NvV4l2ElementPlane::waitForDQThread(uint32_t max_wait_ms)
     }
     pthread_mutex_unlock(&plane_lock);
 
-    if (ret == 0)
+    if (ret == 0 && dq_poller)
     {
-        pthread_join(dq_thread, NULL);
-        dq_thread = 0;
-        PLANE_DEBUG_MSG("Stopped DQ Thread");
+        dq_poller = NULL;
+        PLANE_DEBUG_MSG("Removed from DQ poller");
+    }
+    else if (ret == 0)
+    {
+        /* The thread may never have been started, or already joined. */
+        if (dq_thread)
+        {
+            uint64_t value;
+
+            pthread_join(dq_thread, NULL);
+            dq_thread = 0;
+            /* Drop the interrupt of STREAMOFF if the thread did not
+               consume it. */
+            if (read(wait_abort_fd, &value, sizeof(value)) < 0)
+            {
+                PLANE_DEBUG_MSG("DQ Thread consumed the interrupt");
+            }
+            PLANE_DEBUG_MSG("Stopped DQ Thread");
+        }
     }
     else
     {
@@ -0,0 +1,1164 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NvV4l2MockDevice.h"
+#include "NvLogging.h"
+#include "v4l2_nv_extensions.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <errno.h>
+#include <fcntl.h>
+#include <cstring>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#define CAT_NAME "V4l2MockDevice"
+
+#define MOCK_MAX_BUFFERS 32
+
+#define MOCK_OUTPUT 0
+#define MOCK_CAPTURE 1
+
+using namespace std;
+
+typedef struct
+{
+    uint32_t bytesused[MAX_PLANES];
+    uint32_t length[MAX_PLANES];
+    int mem_fd[MAX_PLANES];         /* Backing memory of MMAP buffers */
+    unsigned char *mem[MAX_PLANES]; /* Mock mapping of MMAP buffers */
+    unsigned long userptr[MAX_PLANES];
+    struct timeval timestamp;
+    uint32_t flags;
+    bool queued;
+} MockBuffer;
+
+typedef struct
+{
+    struct v4l2_format format;
+    enum v4l2_memory memory;
+    uint32_t num_buffers;
+    MockBuffer buffers[MOCK_MAX_BUFFERS];
+    deque<uint32_t> queued;         /* Queued by the application */
+    deque<uint32_t> done;           /* Ready to be dequeued */
+    uint32_t sequence;
+    bool streaming;
+    bool last_dequeued;             /* Buffer flagged LAST was dequeued */
+} MockQueue;
+
+typedef struct
+{
+    int output_index;               /* -1 once the plane is streamed off */
+    int capture_index;              /* -1 if no capture buffer */
+    bool resolution_change;
+    uint64_t complete_time_us;
+} MockJob;
+
+typedef struct
+{
+    int fd;
+    bool blocking;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t worker;
+    bool stop;
+
+    MockQueue queues[2];
+    deque<MockJob> jobs;
+    uint32_t delay_usec;
+    uint32_t capacity;
+
+    set<uint32_t> subscriptions;
+    deque<struct v4l2_event> events;
+    uint32_t event_sequence;
+    bool resolution_sent;
+
+    map<uint32_t, int64_t> controls;
+    bool poll_interrupted;          /* Cleared by SET_POLL_INTERRUPT 1 */
+
+    bool readable;                  /* State of the eventfd */
+} MockDevice;
+
+static pthread_mutex_t devices_lock = PTHREAD_MUTEX_INITIALIZER;
+static map<int, MockDevice *> devices;
+
+static uint32_t mock_delay_usec = 0;
+static uint32_t mock_capacity = 1;
+static uint32_t mock_width = 1920;
+static uint32_t mock_height = 1080;
+
+static uint64_t
+nowUsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static MockDevice *
+getDevice(int fd)
+{
+    MockDevice *dev = NULL;
+    map<int, MockDevice *>::iterator it;
+
+    pthread_mutex_lock(&devices_lock);
+    it = devices.find(fd);
+    if (it != devices.end())
+    {
+        dev = it->second;
+    }
+    pthread_mutex_unlock(&devices_lock);
+    return dev;
+}
+
+static MockQueue *
+getQueue(MockDevice *dev, uint32_t type)
+{
+    switch (type)
+    {
+        case V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE:
+            return &dev->queues[MOCK_OUTPUT];
+        case V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE:
+            return &dev->queues[MOCK_CAPTURE];
+        default:
+            return NULL;
+    }
+}
+
+/* Fills the plane layout of a format which does not specify it. */
+static void
+fillFormat(struct v4l2_pix_format_mplane &pix)
+{
+    uint32_t luma = pix.width * pix.height;
+    uint32_t i;
+
+    if (pix.num_planes == 0 || pix.num_planes > MAX_PLANES)
+    {
+        switch (pix.pixelformat)
+        {
+            case V4L2_PIX_FMT_NV12M:
+                pix.num_planes = 2;
+                break;
+            case V4L2_PIX_FMT_YUV420M:
+                pix.num_planes = 3;
+                break;
+            default:
+                pix.num_planes = 1;
+        }
+    }
+
+    for (i = 0; i < pix.num_planes; i++)
+    {
+        struct v4l2_plane_pix_format &plane = pix.plane_fmt[i];
+
+        if (plane.sizeimage)
+        {
+            continue;
+        }
+        if (pix.num_planes == 1)
+        {
+            plane.bytesperline = pix.width;
+            plane.sizeimage = luma * 3 / 2;
+        }
+        else if (i == 0)
+        {
+            plane.bytesperline = pix.width;
+            plane.sizeimage = luma;
+        }
+        else
+        {
+            plane.bytesperline = pix.num_planes == 2 ? pix.width : pix.width / 2;
+            plane.sizeimage = luma / (pix.num_planes == 2 ? 2 : 4);
+        }
+        if (plane.sizeimage < 4096)
+        {
+            plane.sizeimage = 4096;
+        }
+    }
+}
+
+static void
+freeBuffers(MockQueue *queue)
+{
+    uint32_t i, j;
+
+    for (i = 0; i < queue->num_buffers; i++)
+    {
+        MockBuffer &buf = queue->buffers[i];
+
+        for (j = 0; j < MAX_PLANES; j++)
+        {
+            if (buf.mem[j])
+            {
+                munmap(buf.mem[j], buf.length[j]);
+            }
+            if (buf.mem_fd[j] != -1)
+            {
+                close(buf.mem_fd[j]);
+            }
+        }
+    }
+    queue->num_buffers = 0;
+    queue->queued.clear();
+    queue->done.clear();
+}
+
+static unsigned char *
+getBufferData(MockQueue *queue, MockBuffer &buf, uint32_t plane)
+{
+    switch (queue->memory)
+    {
+        case V4L2_MEMORY_MMAP:
+            return buf.mem[plane];
+        case V4L2_MEMORY_USERPTR:
+            return (unsigned char *) buf.userptr[plane];
+        default:
+            return NULL;
+    }
+}
+
+/* Events which can be dequeued without waiting, among POLLIN, POLLOUT
+ * and POLLPRI. */
+static short
+getReadyEvents(MockDevice *dev, short events)
+{
+    short revents = 0;
+
+    if ((events & POLLPRI) && !dev->events.empty())
+    {
+        revents |= POLLPRI;
+    }
+    if (!dev->queues[MOCK_CAPTURE].done.empty())
+    {
+        revents |= events & (POLLIN | POLLRDNORM);
+    }
+    if (!dev->queues[MOCK_OUTPUT].done.empty())
+    {
+        revents |= events & (POLLOUT | POLLWRNORM);
+    }
+    return revents;
+}
+
+/* Keeps the eventfd readable while something can be dequeued. */
+static void
+updateReadiness(MockDevice *dev)
+{
+    bool ready = !dev->queues[MOCK_OUTPUT].done.empty() ||
+        !dev->queues[MOCK_CAPTURE].done.empty() || !dev->events.empty();
+    uint64_t value = 1;
+
+    if (ready && !dev->readable)
+    {
+        if (write(dev->fd, &value, sizeof(value)) == sizeof(value))
+        {
+            dev->readable = true;
+        }
+    }
+    else if (!ready && dev->readable)
+    {
+        if (read(dev->fd, &value, sizeof(value)) == sizeof(value))
+        {
+            dev->readable = false;
+        }
+    }
+}
+
+static void
+raiseEvent(MockDevice *dev, struct v4l2_event &ev)
+{
+    if (dev->subscriptions.find(ev.type) == dev->subscriptions.end())
+    {
+        return;
+    }
+    ev.sequence = dev->event_sequence++;
+    clock_gettime(CLOCK_MONOTONIC, &ev.timestamp);
+    dev->events.push_back(ev);
+}
+
+static void
+completeJob(MockDevice *dev, MockJob &job)
+{
+    MockQueue *out = &dev->queues[MOCK_OUTPUT];
+    MockQueue *cap = &dev->queues[MOCK_CAPTURE];
+    struct v4l2_event ev;
+    uint32_t i;
+
+    memset(&ev, 0, sizeof(ev));
+
+    if (job.output_index < 0)
+    {
+        /* The output plane was streamed off, give the capture buffer back. */
+        if (job.capture_index >= 0)
+        {
+            cap->queued.push_front(job.capture_index);
+        }
+        return;
+    }
+
+    MockBuffer &out_buf = out->buffers[job.output_index];
+
+    if (job.capture_index >= 0)
+    {
+        MockBuffer &cap_buf = cap->buffers[job.capture_index];
+        uint32_t out_planes = out->format.fmt.pix_mp.num_planes;
+        uint32_t cap_planes = cap->format.fmt.pix_mp.num_planes;
+        bool eos = out_buf.bytesused[0] == 0;
+
+        for (i = 0; i < cap_planes; i++)
+        {
+            unsigned char *src = NULL;
+            unsigned char *dst = getBufferData(cap, cap_buf, i);
+
+            if (eos)
+            {
+                cap_buf.bytesused[i] = 0;
+                continue;
+            }
+            if (i >= out_planes)
+            {
+                cap_buf.bytesused[i] = cap_buf.length[i];
+                continue;
+            }
+
+            cap_buf.bytesused[i] = min(out_buf.bytesused[i], cap_buf.length[i]);
+            src = getBufferData(out, out_buf, i);
+            if (src && dst)
+            {
+                memcpy(dst, src, cap_buf.bytesused[i]);
+            }
+        }
+
+        cap_buf.timestamp = out_buf.timestamp;
+        cap_buf.flags = eos ? V4L2_BUF_FLAG_LAST : 0;
+        cap_buf.queued = false;
+        cap->done.push_back(job.capture_index);
+
+        if (eos)
+        {
+            ev.type = V4L2_EVENT_EOS;
+            raiseEvent(dev, ev);
+        }
+    }
+    else if (job.resolution_change)
+    {
+        /* Same type as V4L2_EVENT_SOURCE_CHANGE */
+        ev.type = V4L2_EVENT_RESOLUTION_CHANGE;
+        ev.u.src_change.changes = V4L2_EVENT_SRC_CH_RESOLUTION;
+        raiseEvent(dev, ev);
+    }
+
+    out_buf.queued = false;
+    out->done.push_back(job.output_index);
+}
+
+static bool
+canStartJob(MockDevice *dev)
+{
+    MockQueue *out = &dev->queues[MOCK_OUTPUT];
+    MockQueue *cap = &dev->queues[MOCK_CAPTURE];
+
+    /* Until the capture plane streams, only the first output buffer is
+       processed, to raise the resolution change event. */
+    return out->streaming && !out->queued.empty() &&
+        dev->jobs.size() < dev->capacity &&
+        (cap->streaming ? !cap->queued.empty() : !dev->resolution_sent);
+}
+
+static void
+startJob(MockDevice *dev, uint64_t now)
+{
+    MockQueue *out = &dev->queues[MOCK_OUTPUT];
+    MockQueue *cap = &dev->queues[MOCK_CAPTURE];
+    MockJob job;
+
+    job.output_index = out->queued.front();
+    out->queued.pop_front();
+    job.capture_index = -1;
+    job.resolution_change = false;
+    if (cap->streaming)
+    {
+        job.capture_index = cap->queued.front();
+        cap->queued.pop_front();
+    }
+    else if (!dev->resolution_sent)
+    {
+        job.resolution_change = true;
+        dev->resolution_sent = true;
+    }
+    job.complete_time_us = now + dev->delay_usec;
+    dev->jobs.push_back(job);
+}
+
+static void *
+workerThread(void *data)
+{
+    MockDevice *dev = (MockDevice *) data;
+
+    pthread_mutex_lock(&dev->lock);
+    while (!dev->stop)
+    {
+        uint64_t now = nowUsec();
+        bool completed = false;
+
+        while (!dev->jobs.empty() && dev->jobs.front().complete_time_us <= now)
+        {
+            completeJob(dev, dev->jobs.front());
+            dev->jobs.pop_front();
+            completed = true;
+        }
+        if (completed)
+        {
+            updateReadiness(dev);
+            pthread_cond_broadcast(&dev->cond);
+        }
+
+        while (canStartJob(dev))
+        {
+            startJob(dev, now);
+        }
+
+        if (!dev->jobs.empty() && dev->jobs.front().complete_time_us <= now)
+        {
+            continue;
+        }
+
+        if (dev->jobs.empty())
+        {
+            pthread_cond_wait(&dev->cond, &dev->lock);
+        }
+        else
+        {
+            uint64_t wake_us = dev->jobs.front().complete_time_us;
+            struct timespec ts;
+
+            ts.tv_sec = wake_us / 1000000;
+            ts.tv_nsec = (wake_us % 1000000) * 1000;
+            pthread_cond_timedwait(&dev->cond, &dev->lock, &ts);
+        }
+    }
+    pthread_mutex_unlock(&dev->lock);
+    return NULL;
+}
+
+static int
+mockOpen(const char *dev_node, int flags)
+{
+    MockDevice *dev;
+    pthread_condattr_t attr;
+    int fd;
+    int i;
+
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    dev = new MockDevice();
+    dev->fd = fd;
+    dev->blocking = !(flags & O_NONBLOCK);
+    dev->stop = false;
+    dev->event_sequence = 0;
+    dev->resolution_sent = false;
+    dev->poll_interrupted = false;
+    dev->readable = false;
+
+    pthread_mutex_lock(&devices_lock);
+    dev->delay_usec = mock_delay_usec;
+    dev->capacity = mock_capacity;
+    for (i = 0; i < 2; i++)
+    {
+        MockQueue *queue = &dev->queues[i];
+        struct v4l2_pix_format_mplane &pix = queue->format.fmt.pix_mp;
+
+        memset(&queue->format, 0, sizeof(queue->format));
+        memset(queue->buffers, 0, sizeof(queue->buffers));
+        for (uint32_t j = 0; j < MOCK_MAX_BUFFERS; j++)
+        {
+            for (uint32_t k = 0; k < MAX_PLANES; k++)
+            {
+                queue->buffers[j].mem_fd[k] = -1;
+            }
+        }
+        queue->format.type = (i == MOCK_OUTPUT) ?
+            V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        pix.width = mock_width;
+        pix.height = mock_height;
+        pix.pixelformat = (i == MOCK_OUTPUT) ? V4L2_PIX_FMT_H264 : V4L2_PIX_FMT_NV12M;
+        fillFormat(pix);
+        queue->memory = V4L2_MEMORY_MMAP;
+        queue->num_buffers = 0;
+        queue->sequence = 0;
+        queue->streaming = false;
+        queue->last_dequeued = false;
+    }
+    devices[fd] = dev;
+    pthread_mutex_unlock(&devices_lock);
+
+    pthread_mutex_init(&dev->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&dev->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&dev->worker, NULL, workerThread, dev);
+
+    CAT_DEBUG_MSG("Opened mock device for " << dev_node << ", fd = " << fd);
+    return fd;
+}
+
+static int
+mockClose(int fd)
+{
+    MockDevice *dev;
+
+    pthread_mutex_lock(&devices_lock);
+    dev = devices[fd];
+    devices.erase(fd);
+    pthread_mutex_unlock(&devices_lock);
+
+    if (!dev)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    pthread_mutex_lock(&dev->lock);
+    dev->stop = true;
+    pthread_cond_broadcast(&dev->cond);
+    pthread_mutex_unlock(&dev->lock);
+    pthread_join(dev->worker, NULL);
+
+    freeBuffers(&dev->queues[MOCK_OUTPUT]);
+    freeBuffers(&dev->queues[MOCK_CAPTURE]);
+    pthread_mutex_destroy(&dev->lock);
+    pthread_cond_destroy(&dev->cond);
+    delete dev;
+
+    return close(fd);
+}
+
+static int
+mockReqbufs(MockDevice *dev, struct v4l2_requestbuffers *req)
+{
+    MockQueue *queue = getQueue(dev, req->type);
+    uint32_t i, j;
+
+    if (!queue)
+    {
+        return EINVAL;
+    }
+    if (queue->streaming)
+    {
+        return EBUSY;
+    }
+    if (req->memory != V4L2_MEMORY_MMAP && req->memory != V4L2_MEMORY_USERPTR &&
+            req->memory != V4L2_MEMORY_DMABUF)
+    {
+        return EINVAL;
+    }
+
+    struct v4l2_pix_format_mplane &pix = queue->format.fmt.pix_mp;
+
+    freeBuffers(queue);
+    queue->memory = (enum v4l2_memory) req->memory;
+    req->count = min(req->count, (uint32_t) MOCK_MAX_BUFFERS);
+
+    for (i = 0; i < req->count; i++)
+    {
+        MockBuffer &buf = queue->buffers[i];
+
+        memset(&buf, 0, sizeof(buf));
+        for (j = 0; j < MAX_PLANES; j++)
+        {
+            buf.mem_fd[j] = -1;
+        }
+        for (j = 0; j < pix.num_planes; j++)
+        {
+            buf.length[j] = pix.plane_fmt[j].sizeimage;
+            if (queue->memory != V4L2_MEMORY_MMAP)
+            {
+                continue;
+            }
+
+            buf.mem_fd[j] = memfd_create("nvv4l2mock", MFD_CLOEXEC);
+            if (buf.mem_fd[j] == -1 || ftruncate(buf.mem_fd[j], buf.length[j]))
+            {
+                queue->num_buffers = i + 1;
+                freeBuffers(queue);
+                return ENOMEM;
+            }
+            buf.mem[j] = (unsigned char *) mmap(NULL, buf.length[j],
+                    PROT_READ | PROT_WRITE, MAP_SHARED, buf.mem_fd[j], 0);
+            if (buf.mem[j] == MAP_FAILED)
+            {
+                buf.mem[j] = NULL;
+                queue->num_buffers = i + 1;
+                freeBuffers(queue);
+                return ENOMEM;
+            }
+        }
+    }
+    queue->num_buffers = req->count;
+    return 0;
+}
+
+static int
+mockQuerybuf(MockDevice *dev, struct v4l2_buffer *v4l2_buf)
+{
+    MockQueue *queue = getQueue(dev, v4l2_buf->type);
+    uint32_t i;
+
+    if (!queue || v4l2_buf->index >= queue->num_buffers)
+    {
+        return EINVAL;
+    }
+
+    MockBuffer &buf = queue->buffers[v4l2_buf->index];
+    v4l2_buf->memory = queue->memory;
+    v4l2_buf->length = queue->format.fmt.pix_mp.num_planes;
+    for (i = 0; i < v4l2_buf->length; i++)
+    {
+        v4l2_buf->m.planes[i].length = buf.length[i];
+        v4l2_buf->m.planes[i].m.mem_offset = 0;
+        v4l2_buf->m.planes[i].bytesused = buf.bytesused[i];
+    }
+    return 0;
+}
+
+/* The exported FD stays owned by the device, NvBuffer never closes it. */
+static int
+mockExpbuf(MockDevice *dev, struct v4l2_exportbuffer *expbuf)
+{
+    MockQueue *queue = getQueue(dev, expbuf->type);
+
+    if (!queue || queue->memory != V4L2_MEMORY_MMAP ||
+            expbuf->index >= queue->num_buffers ||
+            expbuf->plane >= queue->format.fmt.pix_mp.num_planes)
+    {
+        return EINVAL;
+    }
+    expbuf->fd = queue->buffers[expbuf->index].mem_fd[expbuf->plane];
+    return 0;
+}
+
+static int
+mockQbuf(MockDevice *dev, struct v4l2_buffer *v4l2_buf)
+{
+    MockQueue *queue = getQueue(dev, v4l2_buf->type);
+    uint32_t i;
+
+    if (!queue || v4l2_buf->index >= queue->num_buffers ||
+            v4l2_buf->memory != queue->memory)
+    {
+        return EINVAL;
+    }
+
+    MockBuffer &buf = queue->buffers[v4l2_buf->index];
+    if (buf.queued)
+    {
+        return EINVAL;
+    }
+
+    for (i = 0; i < queue->format.fmt.pix_mp.num_planes; i++)
+    {
+        buf.bytesused[i] = v4l2_buf->m.planes[i].bytesused;
+        if (queue->memory == V4L2_MEMORY_USERPTR)
+        {
+            buf.userptr[i] = v4l2_buf->m.planes[i].m.userptr;
+        }
+    }
+    buf.timestamp = v4l2_buf->timestamp;
+    buf.flags = v4l2_buf->flags;
+    buf.queued = true;
+    queue->queued.push_back(v4l2_buf->index);
+
+    pthread_cond_broadcast(&dev->cond);
+    return 0;
+}
+
+static int
+mockDqbuf(MockDevice *dev, struct v4l2_buffer *v4l2_buf)
+{
+    MockQueue *queue = getQueue(dev, v4l2_buf->type);
+    uint32_t index;
+    uint32_t i;
+
+    if (!queue)
+    {
+        return EINVAL;
+    }
+
+    while (queue->done.empty())
+    {
+        if (queue->last_dequeued)
+        {
+            /* As the Tegra codecs do, keep reporting the end of stream. */
+            v4l2_buf->flags |= V4L2_BUF_FLAG_LAST;
+            return EAGAIN;
+        }
+        if (!dev->blocking || !queue->streaming || dev->stop)
+        {
+            return EAGAIN;
+        }
+        pthread_cond_wait(&dev->cond, &dev->lock);
+    }
+
+    index = queue->done.front();
+    queue->done.pop_front();
+    updateReadiness(dev);
+
+    MockBuffer &buf = queue->buffers[index];
+    if (buf.flags & V4L2_BUF_FLAG_LAST)
+    {
+        queue->last_dequeued = true;
+    }
+    v4l2_buf->index = index;
+    v4l2_buf->memory = queue->memory;
+    v4l2_buf->flags = buf.flags;
+    v4l2_buf->timestamp = buf.timestamp;
+    v4l2_buf->sequence = queue->sequence++;
+    v4l2_buf->length = queue->format.fmt.pix_mp.num_planes;
+    for (i = 0; i < v4l2_buf->length; i++)
+    {
+        v4l2_buf->m.planes[i].bytesused = buf.bytesused[i];
+        v4l2_buf->m.planes[i].length = buf.length[i];
+        if (queue->memory == V4L2_MEMORY_USERPTR)
+        {
+            v4l2_buf->m.planes[i].m.userptr = buf.userptr[i];
+        }
+    }
+    return 0;
+}
+
+static int
+mockStream(MockDevice *dev, uint32_t type, bool on)
+{
+    MockQueue *queue = getQueue(dev, type);
+    deque<MockJob>::iterator it;
+    uint32_t i;
+
+    if (!queue)
+    {
+        return EINVAL;
+    }
+
+    queue->streaming = on;
+    queue->last_dequeued = false;
+    if (!on)
+    {
+        /* All buffers return to the application, without being dequeued. */
+        for (it = dev->jobs.begin(); it != dev->jobs.end(); ++it)
+        {
+            if (queue == &dev->queues[MOCK_OUTPUT])
+            {
+                it->output_index = -1;
+            }
+            else
+            {
+                it->capture_index = -1;
+            }
+        }
+        for (i = 0; i < queue->num_buffers; i++)
+        {
+            queue->buffers[i].queued = false;
+        }
+        queue->queued.clear();
+        queue->done.clear();
+        queue->sequence = 0;
+        updateReadiness(dev);
+    }
+    pthread_cond_broadcast(&dev->cond);
+    return 0;
+}
+
+static int
+mockDqevent(MockDevice *dev, struct v4l2_event *ev)
+{
+    if (dev->events.empty())
+    {
+        return EAGAIN;
+    }
+    *ev = dev->events.front();
+    dev->events.pop_front();
+    ev->pending = dev->events.size();
+    updateReadiness(dev);
+    return 0;
+}
+
+/* V4L2_CID_MPEG_VIDEO_DEVICE_POLL: waits until a buffer or an event can
+ * be dequeued, or until the poll is interrupted. */
+static int
+mockDevicePoll(MockDevice *dev, v4l2_ctrl_video_device_poll *devicepoll)
+{
+    if (!devicepoll)
+    {
+        return EINVAL;
+    }
+
+    devicepoll->resp_events = getReadyEvents(dev, devicepoll->req_events);
+    while (!devicepoll->resp_events && !dev->poll_interrupted && !dev->stop)
+    {
+        pthread_cond_wait(&dev->cond, &dev->lock);
+        devicepoll->resp_events = getReadyEvents(dev, devicepoll->req_events);
+    }
+    return 0;
+}
+
+static int
+mockExtControls(MockDevice *dev, struct v4l2_ext_controls *ctrls, bool set)
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < ctrls->count; i++)
+    {
+        struct v4l2_ext_control &ctrl = ctrls->controls[i];
+
+        if (set && ctrl.id == V4L2_CID_MPEG_VIDEO_DEVICE_POLL)
+        {
+            ret = mockDevicePoll(dev, (v4l2_ctrl_video_device_poll *) ctrl.string);
+            if (ret)
+            {
+                return ret;
+            }
+        }
+        else if (set && ctrl.id == V4L2_CID_MPEG_SET_POLL_INTERRUPT)
+        {
+            /* Clearing the interrupt mode wakes up the pending polls. */
+            dev->poll_interrupted = !ctrl.value;
+            pthread_cond_broadcast(&dev->cond);
+        }
+        else if (set)
+        {
+            dev->controls[ctrl.id] = ctrl.size ? 0 : ctrl.value64;
+        }
+        else if (!ctrl.size)
+        {
+            ctrl.value64 = dev->controls[ctrl.id];
+        }
+    }
+    return 0;
+}
+
+static int
+mockIoctl(int fd, unsigned long int request, void *arg)
+{
+    MockDevice *dev = getDevice(fd);
+    int ret = 0;
+
+    if (!dev)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    pthread_mutex_lock(&dev->lock);
+    switch (request)
+    {
+        case VIDIOC_QUERYCAP:
+        {
+            struct v4l2_capability *caps = (struct v4l2_capability *) arg;
+
+            memset(caps, 0, sizeof(*caps));
+            strncpy((char *) caps->driver, "nvv4l2mock", sizeof(caps->driver) - 1);
+            strncpy((char *) caps->card, "nvv4l2mock", sizeof(caps->card) - 1);
+            caps->capabilities = V4L2_CAP_VIDEO_M2M_MPLANE | V4L2_CAP_STREAMING |
+                V4L2_CAP_DEVICE_CAPS;
+            caps->device_caps = V4L2_CAP_VIDEO_M2M_MPLANE | V4L2_CAP_STREAMING;
+            break;
+        }
+        case VIDIOC_G_FMT:
+        case VIDIOC_S_FMT:
+        case VIDIOC_TRY_FMT:
+        {
+            struct v4l2_format *format = (struct v4l2_format *) arg;
+            MockQueue *queue = getQueue(dev, format->type);
+
+            if (!queue)
+            {
+                ret = EINVAL;
+            }
+            else if (request == VIDIOC_G_FMT)
+            {
+                *format = queue->format;
+            }
+            else if (request == VIDIOC_S_FMT && queue->num_buffers)
+            {
+                ret = EBUSY;
+            }
+            else
+            {
+                fillFormat(format->fmt.pix_mp);
+                if (request == VIDIOC_S_FMT)
+                {
+                    queue->format = *format;
+                }
+            }
+            break;
+        }
+        case VIDIOC_G_CROP:
+        {
+            struct v4l2_crop *crop = (struct v4l2_crop *) arg;
+            struct v4l2_pix_format_mplane &pix =
+                dev->queues[MOCK_CAPTURE].format.fmt.pix_mp;
+
+            crop->c.left = 0;
+            crop->c.top = 0;
+            crop->c.width = pix.width;
+            crop->c.height = pix.height;
+            break;
+        }
+        case VIDIOC_REQBUFS:
+            ret = mockReqbufs(dev, (struct v4l2_requestbuffers *) arg);
+            break;
+        case VIDIOC_QUERYBUF:
+            ret = mockQuerybuf(dev, (struct v4l2_buffer *) arg);
+            break;
+        case VIDIOC_EXPBUF:
+            ret = mockExpbuf(dev, (struct v4l2_exportbuffer *) arg);
+            break;
+        case VIDIOC_QBUF:
+            ret = mockQbuf(dev, (struct v4l2_buffer *) arg);
+            break;
+        case VIDIOC_DQBUF:
+            ret = mockDqbuf(dev, (struct v4l2_buffer *) arg);
+            break;
+        case VIDIOC_STREAMON:
+        case VIDIOC_STREAMOFF:
+            ret = mockStream(dev, *(uint32_t *) arg, request == VIDIOC_STREAMON);
+            break;
+        case VIDIOC_SUBSCRIBE_EVENT:
+            dev->subscriptions.insert(((struct v4l2_event_subscription *) arg)->type);
+            break;
+        case VIDIOC_UNSUBSCRIBE_EVENT:
+            dev->subscriptions.erase(((struct v4l2_event_subscription *) arg)->type);
+            break;
+        case VIDIOC_DQEVENT:
+            ret = mockDqevent(dev, (struct v4l2_event *) arg);
+            break;
+        case VIDIOC_S_CTRL:
+        {
+            struct v4l2_control *ctl = (struct v4l2_control *) arg;
+            dev->controls[ctl->id] = ctl->value;
+            break;
+        }
+        case VIDIOC_G_CTRL:
+        {
+            struct v4l2_control *ctl = (struct v4l2_control *) arg;
+            ctl->value = dev->controls[ctl->id];
+            break;
+        }
+        case VIDIOC_S_EXT_CTRLS:
+        case VIDIOC_G_EXT_CTRLS:
+            ret = mockExtControls(dev, (struct v4l2_ext_controls *) arg,
+                    request == VIDIOC_S_EXT_CTRLS);
+            break;
+        case VIDIOC_S_PARM:
+        case VIDIOC_S_SELECTION:
+        case VIDIOC_ENCODER_CMD:
+        case VIDIOC_DECODER_CMD:
+            break;
+        default:
+            CAT_DEBUG_MSG("Unsupported IOCTL " << hex << request << dec);
+            ret = ENOTTY;
+    }
+    pthread_mutex_unlock(&dev->lock);
+
+    if (ret)
+    {
+        errno = ret;
+        return -1;
+    }
+    return 0;
+}
+
+/* Readiness of a mock device, with the V4L2 M2M poll semantics. */
+static short
+getDeviceEvents(MockDevice *dev, short events)
+{
+    MockQueue *out = &dev->queues[MOCK_OUTPUT];
+    MockQueue *cap = &dev->queues[MOCK_CAPTURE];
+    short revents;
+
+    pthread_mutex_lock(&dev->lock);
+    revents = getReadyEvents(dev, events);
+    if ((events & (POLLIN | POLLRDNORM)) && cap->last_dequeued)
+    {
+        /* The end of stream is reported by VIDIOC_DQBUF. */
+        revents |= events & (POLLIN | POLLRDNORM);
+    }
+    else if ((events & (POLLIN | POLLRDNORM)) && cap->done.empty() &&
+            !cap->streaming)
+    {
+        revents |= POLLERR;
+    }
+    if ((events & (POLLOUT | POLLWRNORM)) && out->done.empty() &&
+            !out->streaming)
+    {
+        revents |= POLLERR;
+    }
+    pthread_mutex_unlock(&dev->lock);
+    return revents;
+}
+
+/* The eventfd of a mock device is readable while anything can be dequeued,
+ * so it wakes up the poll below, which then checks the requested events.
+ * While unrelated buffers or events are pending, the eventfd stays readable
+ * and the device is checked again every millisecond instead. */
+static int
+mockPoll(struct pollfd *fds, nfds_t nfds, int timeout_ms)
+{
+    struct pollfd *sys_fds = new struct pollfd[nfds];
+    MockDevice **mock_devs = new MockDevice *[nfds];
+    uint64_t deadline_us = nowUsec() + (uint64_t) timeout_ms * 1000;
+    int ret = 0;
+    nfds_t i;
+
+    for (i = 0; i < nfds; i++)
+    {
+        mock_devs[i] = getDevice(fds[i].fd);
+        sys_fds[i].fd = fds[i].fd;
+        sys_fds[i].events = mock_devs[i] ? POLLIN : fds[i].events;
+    }
+
+    while (true)
+    {
+        bool pending = false;
+        int wait_ms;
+
+        ret = poll(sys_fds, nfds, 0);
+        if (ret < 0)
+        {
+            break;
+        }
+
+        ret = 0;
+        for (i = 0; i < nfds; i++)
+        {
+            if (mock_devs[i])
+            {
+                fds[i].revents = getDeviceEvents(mock_devs[i], fds[i].events);
+                pending |= (sys_fds[i].revents & POLLIN) != 0;
+            }
+            else
+            {
+                fds[i].revents = sys_fds[i].revents;
+            }
+            if (fds[i].revents)
+            {
+                ret++;
+            }
+        }
+        if (ret || timeout_ms == 0)
+        {
+            break;
+        }
+
+        if (timeout_ms < 0)
+        {
+            wait_ms = pending ? 1 : -1;
+        }
+        else
+        {
+            uint64_t now = nowUsec();
+
+            if (now >= deadline_us)
+            {
+                break;
+            }
+            wait_ms = (deadline_us - now + 999) / 1000;
+            if (pending)
+            {
+                wait_ms = 1;
+            }
+        }
+
+        if (poll(sys_fds, nfds, wait_ms) < 0)
+        {
+            ret = -1;
+            break;
+        }
+    }
+
+    delete[] sys_fds;
+    delete[] mock_devs;
+    return ret;
+}
+
+static const NvV4l2DeviceOps mock_device_ops =
+{
+    mockOpen,
+    mockClose,
+    mockIoctl,
+    mockPoll
+};
+
+/* As libv4l2 on Tegra, which cannot poll the device. */
+static const NvV4l2DeviceOps mock_device_ops_no_poll =
+{
+    mockOpen,
+    mockClose,
+    mockIoctl,
+    NULL
+};
+
+const NvV4l2DeviceOps *
+NvV4l2MockDevice::getDeviceOps(bool pollable)
+{
+    return pollable ? &mock_device_ops : &mock_device_ops_no_poll;
+}
+
+void
+NvV4l2MockDevice::setProcessingDelay(uint32_t delay_usec)
+{
+    pthread_mutex_lock(&devices_lock);
+    mock_delay_usec = delay_usec;
+    pthread_mutex_unlock(&devices_lock);
+}
+
+void
+NvV4l2MockDevice::setCapacity(uint32_t capacity)
+{
+    pthread_mutex_lock(&devices_lock);
+    mock_capacity = capacity ? capacity : 1;
+    pthread_mutex_unlock(&devices_lock);
+}
+
+void
+NvV4l2MockDevice::setResolution(uint32_t width, uint32_t height)
+{
+    pthread_mutex_lock(&devices_lock);
+    mock_width = width;
+    mock_height = height;
+    pthread_mutex_unlock(&devices_lock);
+}
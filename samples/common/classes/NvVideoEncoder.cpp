@@ -202,7 +202,7 @@ NvVideoEncoder::setEncoderCommand(int cmd, int flags)
    v4l2_enc_cmd.cmd = cmd;
    v4l2_enc_cmd.flags = flags;
 
-   ret = v4l2_ioctl(fd, VIDIOC_ENCODER_CMD, v4l2_enc_cmd);
+   ret = dev_ops->ioctl(fd, VIDIOC_ENCODER_CMD, &v4l2_enc_cmd);
    if (ret < 0)
      printf(" Error in encoder command \n");
 
@@ -29,57 +29,425 @@
 #ifndef __QUEUE_H__
 #define __QUEUE_H__
 
-// This is an implementation of thread-safe blocking queue using pthread
-// and std::queue
+// This is an implementation of bounded thread-safe queues on top of
+// lock-free ring buffers.
+//
+// SpscRing only allows one producer and one consumer thread, MpmcRing allows
+// any number of both. BlockingQueue adds blocking, timed and batch operations
+// to either ring. Threads only take a mutex when they have to sleep, i.e.
+// after spinning on a full or empty ring, and producers/consumers only touch
+// it to wake up such sleepers.
+//
+// Queue<T> is the MPMC flavour and keeps the interface of the previous
+// std::queue based implementation, except that pop() returns by value.
 
 #include <pthread.h>
-#include <queue>
+#include <sched.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <atomic>
 
-template<typename T>
-class Queue
+#define QUEUE_CACHE_LINE_SIZE   64
+#define QUEUE_DEFAULT_CAPACITY  64
+// Number of failed attempts before a blocking call goes to sleep
+#define QUEUE_SPIN_COUNT        256
+
+// Single producer, single consumer ring. N must be a power of 2.
+template<typename T, size_t N>
+class SpscRing
 {
 public:
-    Queue()
+    typedef T value_type;
+
+    SpscRing() : m_head(0), m_tail(0), m_cachedHead(0), m_cachedTail(0)
+    {
+        static_assert(N && !(N & (N - 1)), "Ring capacity must be a power of 2");
+    }
+
+    bool tryPush(const T& obj)
+    {
+        return tryPushBatch(&obj, 1) == 1;
+    }
+
+    bool tryPop(T& obj)
+    {
+        return tryPopBatch(&obj, 1) == 1;
+    }
+
+    // Pushes up to count objects, returns the number pushed
+    size_t tryPushBatch(const T *objs, size_t count)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (N - (tail - m_cachedHead) < count)
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+
+        size_t space = N - (tail - m_cachedHead);
+        if (count > space)
+            count = space;
+
+        for (size_t i = 0; i < count; i++)
+            m_buffer[(tail + i) & (N - 1)] = objs[i];
+
+        if (count)
+            m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Pops up to count objects, returns the number popped
+    size_t tryPopBatch(T *objs, size_t count)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (m_cachedTail - head < count)
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+        size_t avail = m_cachedTail - head;
+        if (count > avail)
+            count = avail;
+
+        for (size_t i = 0; i < count; i++)
+            objs[i] = m_buffer[(head + i) & (N - 1)];
+
+        if (count)
+            m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t size() const
+    {
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    size_t capacity() const
+    {
+        return N;
+    }
+
+private:
+    SpscRing(const SpscRing&);
+    void operator=(const SpscRing&);
+
+    // Consumer side
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_head;
+    // Producer side
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_tail;
+    // Producer's copy of m_head
+    alignas(QUEUE_CACHE_LINE_SIZE) size_t m_cachedHead;
+    // Consumer's copy of m_tail
+    alignas(QUEUE_CACHE_LINE_SIZE) size_t m_cachedTail;
+    alignas(QUEUE_CACHE_LINE_SIZE) T m_buffer[N];
+};
+
+// Multi producer, multi consumer ring. Each cell carries a sequence number
+// telling whether it is ready to be written or read for a given lap.
+// N must be a power of 2.
+template<typename T, size_t N>
+class MpmcRing
+{
+public:
+    typedef T value_type;
+
+    MpmcRing() : m_head(0), m_tail(0)
+    {
+        static_assert(N && !(N & (N - 1)), "Ring capacity must be a power of 2");
+        for (size_t i = 0; i < N; i++)
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(const T& obj)
+    {
+        Cell *cell;
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_cells[pos & (N - 1)];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // Full
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = obj;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& obj)
+    {
+        Cell *cell;
+        size_t pos = m_head.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_cells[pos & (N - 1)];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // Empty
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        obj = cell->data;
+        cell->seq.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+    size_t tryPushBatch(const T *objs, size_t count)
+    {
+        size_t i;
+        for (i = 0; i < count && tryPush(objs[i]); i++)
+            ;
+        return i;
+    }
+
+    size_t tryPopBatch(T *objs, size_t count)
+    {
+        size_t i;
+        for (i = 0; i < count && tryPop(objs[i]); i++)
+            ;
+        return i;
+    }
+
+    // Approximate while producers or consumers are active
+    size_t size() const
     {
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        return (tail > head) ? tail - head : 0;
+    }
+
+    size_t capacity() const
+    {
+        return N;
+    }
+
+private:
+    MpmcRing(const MpmcRing&);
+    void operator=(const MpmcRing&);
+
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_head;
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_tail;
+    alignas(QUEUE_CACHE_LINE_SIZE) Cell m_cells[N];
+};
+
+// Sleeping side of the blocking queue. The waiter count is checked by the
+// waking side so that the mutex stays off the fast path.
+class QueueWaitSet
+{
+public:
+    QueueWaitSet() : m_waiters(0)
+    {
+        pthread_condattr_t attr;
+
         pthread_mutex_init(&m_mutex, NULL);
-        pthread_cond_init(&m_cond, NULL);
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&m_cond, &attr);
+        pthread_condattr_destroy(&attr);
     }
 
-    ~Queue()
+    ~QueueWaitSet()
     {
         pthread_mutex_destroy(&m_mutex);
         pthread_cond_destroy(&m_cond);
     }
 
-    void push(const T& obj)
+    // Waits until tryOp() succeeds. Returns false if deadline (absolute
+    // CLOCK_MONOTONIC time, NULL for none) expired first.
+    template<typename Op>
+    bool wait(Op tryOp, const struct timespec *deadline)
     {
+        for (int i = 0; i < QUEUE_SPIN_COUNT; i++)
+        {
+            if (tryOp())
+                return true;
+            sched_yield();
+        }
+
+        bool done;
         pthread_mutex_lock(&m_mutex);
-        m_queue.push(obj);
-        pthread_cond_signal(&m_cond);
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!(done = tryOp()))
+        {
+            if (!deadline)
+            {
+                pthread_cond_wait(&m_cond, &m_mutex);
+            }
+            else if (pthread_cond_timedwait(&m_cond, &m_mutex, deadline) == ETIMEDOUT)
+            {
+                done = tryOp();
+                break;
+            }
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
         pthread_mutex_unlock(&m_mutex);
+        return done;
     }
 
-    T& pop()
+    void notify()
     {
-        pthread_mutex_lock(&m_mutex);
-        while(m_queue.empty())
-            pthread_cond_wait(&m_cond, &m_mutex);
-        T& obj = m_queue.front();
-        m_queue.pop();
-        pthread_mutex_unlock(&m_mutex);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed))
+        {
+            pthread_mutex_lock(&m_mutex);
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+        }
+    }
+
+private:
+    QueueWaitSet(const QueueWaitSet&);
+    void operator=(const QueueWaitSet&);
+
+    std::atomic<int> m_waiters;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+};
+
+template<typename Ring>
+class BlockingQueue : public Ring
+{
+public:
+    typedef typename Ring::value_type T;
+
+    // Blocks while the queue is full
+    void push(const T& obj)
+    {
+        pushBatch(&obj, 1);
+    }
+
+    // Blocks while the queue is empty
+    T pop()
+    {
+        T obj;
+        popBatch(&obj, 1);
         return obj;
     }
 
-    size_t size()
+    bool tryPush(const T& obj)
+    {
+        if (!Ring::tryPush(obj))
+            return false;
+        m_notEmpty.notify();
+        return true;
+    }
+
+    bool tryPop(T& obj)
+    {
+        if (!Ring::tryPop(obj))
+            return false;
+        m_notFull.notify();
+        return true;
+    }
+
+    // Returns false if the queue stayed full for timeout_us microseconds
+    bool timedPush(const T& obj, uint64_t timeout_us)
+    {
+        struct timespec deadline;
+        getDeadline(timeout_us, &deadline);
+        if (!m_notFull.wait([&]() { return Ring::tryPush(obj); }, &deadline))
+            return false;
+        m_notEmpty.notify();
+        return true;
+    }
+
+    // Returns false if the queue stayed empty for timeout_us microseconds
+    bool timedPop(T& obj, uint64_t timeout_us)
+    {
+        struct timespec deadline;
+        getDeadline(timeout_us, &deadline);
+        if (!m_notEmpty.wait([&]() { return Ring::tryPop(obj); }, &deadline))
+            return false;
+        m_notFull.notify();
+        return true;
+    }
+
+    // Pushes all count objects, blocking while the queue is full
+    void pushBatch(const T *objs, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            m_notFull.wait([&]() {
+                    size_t n = Ring::tryPushBatch(objs + done, count - done);
+                    done += n;
+                    return n != 0;
+                }, NULL);
+            m_notEmpty.notify();
+        }
+    }
+
+    // Pops between 1 and count objects, blocking while the queue is empty.
+    // Returns the number popped.
+    size_t popBatch(T *objs, size_t count)
     {
-        return m_queue.size();
+        size_t done = 0;
+        m_notEmpty.wait([&]() {
+                done = Ring::tryPopBatch(objs, count);
+                return done != 0;
+            }, NULL);
+        m_notFull.notify();
+        return done;
     }
 
 private:
-    std::queue<T> m_queue;
-    pthread_mutex_t m_mutex;
-    pthread_cond_t m_cond;
+    static void getDeadline(uint64_t timeout_us, struct timespec *deadline)
+    {
+        clock_gettime(CLOCK_MONOTONIC, deadline);
+        deadline->tv_sec += timeout_us / 1000000;
+        deadline->tv_nsec += (timeout_us % 1000000) * 1000;
+        if (deadline->tv_nsec >= 1000000000)
+        {
+            deadline->tv_sec++;
+            deadline->tv_nsec -= 1000000000;
+        }
+    }
+
+    QueueWaitSet m_notEmpty;
+    QueueWaitSet m_notFull;
 };
 
+template<typename T, size_t N = QUEUE_DEFAULT_CAPACITY>
+using SpscQueue = BlockingQueue<SpscRing<T, N> >;
+
+template<typename T, size_t N = QUEUE_DEFAULT_CAPACITY>
+using Queue = BlockingQueue<MpmcRing<T, N> >;
 
 #endif  // __QUEUE_H__
@@ -88,15 +88,16 @@ private:
     pthread_t m_renderThread;
     pthread_t m_trtThread;
 
-    Queue<vector<Rect2f>*> m_bboxesQueue[CLASS_NUM];  // Inference result
+    SpscQueue<vector<Rect2f>*> m_bboxesQueue[CLASS_NUM];  // Inference result
 
     std::string m_deployFile;
     std::string m_modelFile;
     bool m_mode;
     Queue<int> m_emptyBufferQueue;
     Queue<int> m_emptyTRTBufferQueue;
-    Queue<BufferInfo> m_renderBufferQueue;
-    Queue<BufferInfo> m_trtBufferQueue;
+    // Single producer (consumer thread) to single consumer (render/TRT thread)
+    SpscQueue<BufferInfo> m_renderBufferQueue;
+    SpscQueue<BufferInfo> m_trtBufferQueue;
     vector<NvOSD_RectParams> m_rectParams;
 
     // Encoder support
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./appprofiler_sample [-t burn_ms] [-i interval_ms]
+ * Example:
+ * ./appprofiler_sample
+ * ./appprofiler_sample -t 500 -i 5
+**/
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "NvApplicationProfiler.h"
+
+using namespace std;
+
+/**
+ * CPU only check of the thread, core and sampler accounting of
+ * NvApplicationProfiler.
+ *
+ * Threads named with pthread_setname_np burn a known amount of CPU time,
+ * measured with their own CPU clock, while the profiler samples every
+ * 10 ms. One of them exits while the profiler still runs, and another one
+ * only sleeps. Each thread must be reported under its name with its CPU
+ * time, the exited one must keep its total, and the cores must have been
+ * busy for at least the time burnt. The CPU time of the profiling thread
+ * itself is reported as the cost of sampling.
+ */
+
+#define DEFAULT_BURN_MSEC 300
+#define DEFAULT_INTERVAL_MSEC 10
+/* Time the threads idle after burning, for the profiler to read them. */
+#define SETTLE_INTERVALS 4
+/* Error allowed on the CPU time of a thread: the milliseconds are
+   truncated and the run time may be one scheduler tick behind. */
+#define CPU_TIME_SLACK_MSEC 15
+/* Largest share of a core the sampler may use. */
+#define MAX_SAMPLER_USAGE 10.0f
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef struct
+{
+    const char *name;
+    /** CPU time to burn, in percent of the burn time option. */
+    uint32_t burn_percent;
+    /** Set if the thread exits before the profiler is stopped. */
+    bool exits_early;
+    uint32_t burn_msec;
+    uint32_t settle_msec;
+    pthread_t thread;
+    pthread_mutex_t *lock;
+    pthread_cond_t *cond;
+    bool *release;
+    /** Set once the thread has burnt its CPU time. */
+    bool done;
+    /** CPU time of the thread, measured by itself, in milliseconds. */
+    uint64_t cpu_time_ms;
+} burner_t;
+
+static uint64_t
+thread_cpu_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *
+burner_fcn(void *arg)
+{
+    burner_t *burner = (burner_t *) arg;
+    uint64_t target = (uint64_t) burner->burn_msec * burner->burn_percent *
+        10000ULL;
+    volatile uint64_t sink = 0;
+
+    pthread_setname_np(pthread_self(), burner->name);
+    while (thread_cpu_nsec() < target)
+    {
+        for (int i = 0; i < 10000; i++)
+            sink += i;
+    }
+    /* Idle long enough for the profiler to read the final CPU time. */
+    usleep(burner->settle_msec * 1000);
+
+    pthread_mutex_lock(burner->lock);
+    burner->cpu_time_ms = thread_cpu_nsec() / 1000000;
+    burner->done = true;
+    pthread_cond_broadcast(burner->cond);
+    while (!burner->exits_early && !*burner->release)
+        pthread_cond_wait(burner->cond, burner->lock);
+    pthread_mutex_unlock(burner->lock);
+    return NULL;
+}
+
+static const NvApplicationProfiler::NvAppThreadProfilerData *
+find_thread(const NvApplicationProfiler::NvAppProfilerData &data,
+        const char *name)
+{
+    for (uint32_t i = 0; i < data.num_threads; i++)
+    {
+        if (!strcmp(data.threads[i].name, name))
+            return &data.threads[i];
+    }
+    return NULL;
+}
+
+static int
+check_profiler(uint32_t burn_msec, uint32_t interval_msec)
+{
+    burner_t burners[] =
+    {
+        { "burn_full", 100, false },
+        { "burn_half", 50, false },
+        { "burn_exits", 30, true },
+        { "idle", 0, false },
+    };
+    const uint32_t num_burners = sizeof(burners) / sizeof(burners[0]);
+    static NvApplicationProfiler::NvAppProfilerData data;
+    NvApplicationProfiler &profiler =
+        NvApplicationProfiler::getProfilerInstance();
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    bool release = false;
+    uint64_t total_burn_ms = 0;
+    double total_ms;
+    double core_busy_ms = 0;
+    float core_peak = 0;
+
+    profiler.start(interval_msec);
+    for (uint32_t i = 0; i < num_burners; i++)
+    {
+        burners[i].burn_msec = burn_msec;
+        burners[i].settle_msec = SETTLE_INTERVALS * interval_msec;
+        burners[i].lock = &lock;
+        burners[i].cond = &cond;
+        burners[i].release = &release;
+        burners[i].done = false;
+        pthread_create(&burners[i].thread, NULL, burner_fcn, &burners[i]);
+    }
+    /* The early thread is gone for a few samples before the others go. */
+    pthread_join(burners[2].thread, NULL);
+    usleep(SETTLE_INTERVALS * interval_msec * 1000);
+    pthread_mutex_lock(&lock);
+    for (uint32_t i = 0; i < num_burners; i++)
+    {
+        while (!burners[i].done)
+            pthread_cond_wait(&cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    usleep(SETTLE_INTERVALS * interval_msec * 1000);
+    profiler.stop();
+
+    pthread_mutex_lock(&lock);
+    release = true;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+    for (uint32_t i = 0; i < num_burners; i++)
+    {
+        if (!burners[i].exits_early)
+            pthread_join(burners[i].thread, NULL);
+    }
+
+    profiler.getProfilerData(data);
+    total_ms = data.total_time.tv_sec * 1000.0 +
+        data.total_time.tv_usec / 1000.0;
+
+    for (uint32_t i = 0; i < num_burners; i++)
+    {
+        const burner_t &burner = burners[i];
+        const NvApplicationProfiler::NvAppThreadProfilerData *thread =
+            find_thread(data, burner.name);
+
+        CHECK(thread, burner.name << ": not profiled");
+        cout << burner.name << ": " << thread->cpu_time_ms << " ms of " <<
+            burner.cpu_time_ms << " ms, peak " << thread->peak_cpu_usage <<
+            "%, " << thread->context_switches << " switches" <<
+            (thread->exited ? ", exited" : "") << endl;
+        CHECK(thread->cpu_time_ms + CPU_TIME_SLACK_MSEC >= burner.cpu_time_ms &&
+                thread->cpu_time_ms <= burner.cpu_time_ms +
+                CPU_TIME_SLACK_MSEC, burner.name << ": " <<
+                thread->cpu_time_ms << " ms profiled instead of " <<
+                burner.cpu_time_ms);
+        CHECK(thread->exited == burner.exits_early, burner.name << ": " <<
+                (thread->exited ? "exited" : "still running"));
+        if (burner.burn_percent)
+        {
+            CHECK(thread->peak_cpu_usage > 0 && thread->avg_cpu_usage > 0,
+                    burner.name << ": no usage");
+        }
+        total_burn_ms += burner.cpu_time_ms;
+    }
+
+    CHECK(data.num_cores > 0 && data.num_cores <= data.num_cpu_cores,
+            data.num_cores << " cores profiled of " << data.num_cpu_cores);
+    for (uint32_t i = 0; i < data.num_cores; i++)
+    {
+        core_busy_ms += data.core_avg_usage[i] * total_ms / 100;
+        if (data.core_peak_usage[i] > core_peak)
+            core_peak = data.core_peak_usage[i];
+    }
+    cout << "cores: " << core_busy_ms << " ms busy over " << total_ms <<
+        " ms, " << total_burn_ms << " ms burnt, peak " << core_peak << "%" <<
+        endl;
+    /* /proc/stat counts in scheduler ticks. */
+    CHECK(core_busy_ms + 2 * CPU_TIME_SLACK_MSEC >= total_burn_ms &&
+            core_busy_ms <= data.num_cores * total_ms +
+            2 * CPU_TIME_SLACK_MSEC, "cores: " << core_busy_ms <<
+            " ms busy for " << total_burn_ms << " ms burnt");
+    CHECK(core_peak > 50, "cores: peak usage " << core_peak << "%");
+
+    const NvApplicationProfiler::NvAppThreadProfilerData *sampler =
+        find_thread(data, "ProfilingThread");
+    CHECK(sampler, "The profiling thread was not profiled");
+    cout << "sampler: " << sampler->cpu_time_ms << " ms over " << total_ms <<
+        " ms at " << interval_msec << " ms, " << sampler->avg_cpu_usage <<
+        "% of a core for " << data.num_threads << " threads" << endl;
+    CHECK(sampler->avg_cpu_usage < MAX_SAMPLER_USAGE, "sampler: " <<
+            sampler->avg_cpu_usage << "% of a core");
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: appprofiler_sample [OPTIONS]" << endl << endl;
+    cout << "\t-t <msec>    CPU time burnt by the busiest thread [Default = "
+        << DEFAULT_BURN_MSEC << "]" << endl;
+    cout << "\t-i <msec>    Sampling interval [Default = "
+        << DEFAULT_INTERVAL_MSEC << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t burn_msec = DEFAULT_BURN_MSEC;
+    uint32_t interval_msec = DEFAULT_INTERVAL_MSEC;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:i:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                burn_msec = atoi(optarg);
+                break;
+            case 'i':
+                interval_msec = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (burn_msec < 1 || interval_msec < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_profiler(burn_msec, interval_msec) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,677 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./bitstream_sample [-s size_in_MiB] [-o synthetic_stream_path] [-f input_stream]
+ * Example:
+ * ./bitstream_sample
+ * ./bitstream_sample -s 64
+ * ./bitstream_sample -f test_file.h264
+**/
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "NvBitstreamReader.h"
+
+using namespace std;
+
+/**
+ * CPU only check and benchmark of NvBitstreamReader.
+ *
+ * The decode samples used to find NAL units by reading CHUNK_SIZE bytes of
+ * the file, scanning them one byte at a time and seeking back to the next
+ * start code, so every byte of the file was read and copied twice.
+ * NvBitstreamReader indexes the mapped file once and copies each NAL unit
+ * with a single memcpy.
+ *
+ * This sample first checks the NAL units and access units found by
+ * NvBitstreamReader against golden tables of hand-built H.264 and H.265
+ * streams. It then writes a synthetic Annex-B stream, checks that both
+ * parsers return the same NAL units, and reports the throughput of each of
+ * them. No decoder hardware is used.
+ */
+
+#define CHUNK_SIZE 4000000
+
+#define IS_NAL_UNIT_START(buffer_ptr) (!buffer_ptr[0] && !buffer_ptr[1] && \
+        !buffer_ptr[2] && (buffer_ptr[3] == 1))
+
+#define IS_NAL_UNIT_START1(buffer_ptr) (!buffer_ptr[0] && !buffer_ptr[1] && \
+        (buffer_ptr[2] == 1))
+
+#define DEFAULT_STREAM_SIZE_MIB 2048
+#define DEFAULT_STREAM_PATH "bitstream_sample.h264"
+#define GOLDEN_STREAM_PATH "bitstream_sample_golden.bin"
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static double
+now_seconds()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+  * Append one NAL unit to the stream.
+  *
+  * The payload is random, with runs of zero bytes so that emulation
+  * prevention bytes are needed, and never ends with a zero byte so that
+  * the NAL unit boundaries of the stream are unambiguous.
+  */
+static void
+append_nal_unit(vector<uint8_t> &out, uint8_t header, uint32_t payload_size)
+{
+    uint32_t zeros = 0;
+
+    if (next_rand() & 1)
+        out.push_back(0);
+    out.push_back(0);
+    out.push_back(0);
+    out.push_back(1);
+    out.push_back(header);
+
+    for (uint32_t i = 0; i < payload_size; i++)
+    {
+        uint32_t r = next_rand();
+        uint8_t byte = (r & 0xF00) ? (uint8_t) r : 0;
+
+        if (i == payload_size - 1 && byte == 0)
+            byte = 0x80;
+        if (zeros >= 2 && byte <= 3)
+        {
+            out.push_back(3);
+            zeros = 0;
+        }
+        out.push_back(byte);
+        zeros = byte ? 0 : zeros + 1;
+    }
+}
+
+/**
+  * Write a synthetic H.264 stream of about @a size bytes: an IDR picture
+  * with SPS and PPS every 30 pictures, and P pictures of 2 to 64 KiB with
+  * an SEI in between.
+  */
+static int
+write_synthetic_stream(const char *path, uint64_t size)
+{
+    FILE *file = fopen(path, "wb");
+    vector<uint8_t> out;
+    uint64_t written = 0;
+    uint32_t picture = 0;
+
+    if (!file)
+    {
+        cerr << "Could not open " << path << " for writing" << endl;
+        return -1;
+    }
+
+    while (written < size)
+    {
+        out.clear();
+        if (picture % 30 == 0)
+        {
+            append_nal_unit(out, 0x67, 16 + next_rand() % 16);
+            append_nal_unit(out, 0x68, 4 + next_rand() % 8);
+            append_nal_unit(out, 0x65, 64 * 1024 + next_rand() % (192 * 1024));
+        }
+        else
+        {
+            if (next_rand() % 8 == 0)
+                append_nal_unit(out, 0x06, 8 + next_rand() % 32);
+            append_nal_unit(out, 0x41, 2 * 1024 + next_rand() % (62 * 1024));
+        }
+        if (fwrite(out.data(), 1, out.size(), file) != out.size())
+        {
+            cerr << "Could not write " << path << endl;
+            fclose(file);
+            return -1;
+        }
+        written += out.size();
+        picture++;
+    }
+
+    fclose(file);
+    return 0;
+}
+
+/**
+ * Hand-built H.264 and H.265 streams with the NAL unit boundaries and
+ * access units they must be split into. Both mix 3 and 4-byte start codes,
+ * and the H.264 stream begins with two bytes that are not part of any NAL
+ * unit.
+ */
+struct GoldenNalUnit
+{
+    uint64_t offset;
+    uint32_t size;
+    uint8_t start_code_len;
+};
+
+static const uint8_t h264_stream[] = {
+    0xab, 0xcd,
+    0x00, 0x00, 0x00, 0x01, 0x09, 0x10,                     /* AUD */
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x1f,         /* SPS */
+    0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80,               /* PPS */
+    0x00, 0x00, 0x01, 0x06, 0x05, 0x01, 0x80,               /* SEI */
+    0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x03,   /* IDR, first_mb 0 */
+    0x00, 0x21,
+    0x00, 0x00, 0x01, 0x65, 0x40, 0x11, 0x22,               /* IDR, first_mb 1 */
+    0x00, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x02,               /* P, first_mb 0 */
+    0x00, 0x00, 0x01, 0x41, 0x24, 0x33,                     /* P, first_mb 3 */
+    0x00, 0x00, 0x01, 0x06, 0x05, 0x01, 0x80,               /* SEI */
+    0x00, 0x00, 0x01, 0x41, 0x9a, 0x44,                     /* P, first_mb 0 */
+    0x00, 0x00, 0x01, 0x0c, 0xff, 0xff, 0x80,               /* Filler data */
+    0x00, 0x00, 0x00, 0x01, 0x01, 0x9e, 0x10,               /* Non-ref P, first_mb 0 */
+};
+
+static const GoldenNalUnit h264_nal_units[] = {
+    { 2, 6, 4 },
+    { 8, 8, 4 },
+    { 16, 7, 3 },
+    { 23, 7, 3 },
+    { 30, 11, 4 },
+    { 41, 7, 3 },
+    { 48, 7, 4 },
+    { 55, 6, 3 },
+    { 61, 7, 3 },
+    { 68, 6, 3 },
+    { 74, 7, 3 },
+    { 81, 7, 4 },
+};
+
+/* Number of NAL units in each access unit. */
+static const uint32_t h264_access_units[] = { 6, 2, 3, 1 };
+
+static const uint8_t h265_stream[] = {
+    0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x10,               /* AUD */
+    0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,         /* VPS */
+    0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,         /* SPS */
+    0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc1, 0x72,         /* PPS */
+    0x00, 0x00, 0x01, 0x4e, 0x01, 0x05, 0x1a,               /* Prefix SEI */
+    0x00, 0x00, 0x01, 0x26, 0x01, 0xaf, 0x09,               /* IDR_W_RADL, first segment */
+    0x00, 0x00, 0x01, 0x26, 0x01, 0x20, 0x40,               /* IDR_W_RADL */
+    0x00, 0x00, 0x01, 0x50, 0x01, 0x12, 0x80,               /* Suffix SEI */
+    0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x11,         /* TRAIL_R, first segment */
+    0x00, 0x00, 0x01, 0x02, 0x01, 0x60, 0x22,               /* TRAIL_R */
+    0x00, 0x00, 0x01, 0x00, 0x01, 0xe0, 0x33,               /* TRAIL_N, first segment */
+    0x00, 0x00, 0x00, 0x01, 0x4a, 0x01,                     /* End of sequence */
+};
+
+static const GoldenNalUnit h265_nal_units[] = {
+    { 0, 7, 4 },
+    { 7, 8, 4 },
+    { 15, 8, 4 },
+    { 23, 8, 4 },
+    { 31, 7, 3 },
+    { 38, 7, 3 },
+    { 45, 7, 3 },
+    { 52, 7, 3 },
+    { 59, 8, 4 },
+    { 67, 7, 3 },
+    { 74, 7, 3 },
+    { 81, 6, 4 },
+};
+
+static const uint32_t h265_access_units[] = { 8, 2, 2 };
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/**
+  * Check the NAL unit index and the access units of a golden stream, and
+  * that reading it with a buffer smaller than its access units, falling
+  * back to single NAL units as the decode samples do, still returns every
+  * byte of it.
+  */
+static int
+check_golden_stream(const char *name, uint32_t pixfmt,
+        const uint8_t *stream, uint32_t stream_size,
+        const GoldenNalUnit *nal_units, uint32_t num_nal_units,
+        const uint32_t *access_units, uint32_t num_access_units)
+{
+    NvBitstreamReader *reader = NULL;
+    NvBuffer buffer(4096, 0);
+    NvBuffer small_buffer(16, 0);
+    vector<uint8_t> output;
+    uint32_t first = 0;
+    uint32_t num_fallbacks = 0;
+    uint32_t i;
+    FILE *file;
+    int ret = -1;
+
+    file = fopen(GOLDEN_STREAM_PATH, "wb");
+    if (!file || fwrite(stream, 1, stream_size, file) != stream_size)
+    {
+        cerr << "Could not write " << GOLDEN_STREAM_PATH << endl;
+        if (file)
+            fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    reader = NvBitstreamReader::createBitstreamReader(GOLDEN_STREAM_PATH);
+    if (!reader || buffer.allocateMemory() < 0 ||
+        small_buffer.allocateMemory() < 0)
+    {
+        cerr << "Could not open " << GOLDEN_STREAM_PATH << endl;
+        goto cleanup;
+    }
+
+    if (reader->getNumNalUnits() != num_nal_units)
+    {
+        cerr << name << ": " << reader->getNumNalUnits() <<
+            " NAL units, expected " << num_nal_units << endl;
+        goto cleanup;
+    }
+    for (i = 0; i < num_nal_units; i++)
+    {
+        const NvBitstreamReader::NvNalUnit &unit = reader->getNalUnit(i);
+
+        if (unit.offset != nal_units[i].offset ||
+            unit.size != nal_units[i].size ||
+            unit.start_code_len != nal_units[i].start_code_len ||
+            unit.header != stream[unit.offset + unit.start_code_len])
+        {
+            cerr << name << ": NAL unit " << i << " at offset " <<
+                unit.offset << " of size " << unit.size << ", expected " <<
+                nal_units[i].offset << " of size " << nal_units[i].size << endl;
+            goto cleanup;
+        }
+    }
+
+    for (i = 0; i < num_access_units; i++)
+    {
+        const GoldenNalUnit &last = nal_units[first + access_units[i] - 1];
+        uint32_t count = 0;
+
+        if (reader->readNextAccessUnit(&buffer, pixfmt, NULL, &count) < 0 ||
+            count != access_units[i] ||
+            buffer.planes[0].bytesused !=
+                last.offset + last.size - nal_units[first].offset ||
+            memcmp(buffer.planes[0].data, stream + nal_units[first].offset,
+                   buffer.planes[0].bytesused))
+        {
+            cerr << name << ": access unit " << i << " has " << count <<
+                " NAL units, expected " << access_units[i] << endl;
+            goto cleanup;
+        }
+        first += access_units[i];
+    }
+    if (reader->readNextAccessUnit(&buffer, pixfmt) < 0 ||
+        buffer.planes[0].bytesused != 0)
+    {
+        cerr << name << ": no end of stream after the last access unit" << endl;
+        goto cleanup;
+    }
+
+    while (true)
+    {
+        NvBuffer::NvBufferPlane &plane = small_buffer.planes[0];
+
+        if (reader->readNextAccessUnit(&small_buffer, pixfmt) < 0)
+        {
+            num_fallbacks++;
+            if (reader->readNextNalUnit(&small_buffer) < 0)
+            {
+                cerr << name << ": NAL unit fallback failed" << endl;
+                goto cleanup;
+            }
+        }
+        if (plane.bytesused == 0)
+            break;
+        output.insert(output.end(), plane.data, plane.data + plane.bytesused);
+    }
+    if (num_fallbacks == 0 ||
+        output.size() != stream_size - nal_units[0].offset ||
+        memcmp(output.data(), stream + nal_units[0].offset, output.size()))
+    {
+        cerr << name << ": NAL unit fallback did not return the stream" << endl;
+        goto cleanup;
+    }
+
+    cout << name << " golden stream: " << num_nal_units << " NAL units, " <<
+        num_access_units << " access units: OK" << endl;
+    ret = 0;
+
+cleanup:
+    delete reader;
+    unlink(GOLDEN_STREAM_PATH);
+    return ret;
+}
+
+static int
+check_golden_streams()
+{
+    if (check_golden_stream("H.264", V4L2_PIX_FMT_H264,
+                            h264_stream, sizeof(h264_stream),
+                            h264_nal_units, ARRAY_SIZE(h264_nal_units),
+                            h264_access_units, ARRAY_SIZE(h264_access_units)) < 0)
+        return -1;
+    return check_golden_stream("H.265", V4L2_PIX_FMT_H265,
+                               h265_stream, sizeof(h265_stream),
+                               h265_nal_units, ARRAY_SIZE(h265_nal_units),
+                               h265_access_units, ARRAY_SIZE(h265_access_units));
+}
+
+/**
+  * Byte-wise NAL unit parser of the decode samples before NvBitstreamReader.
+  *
+  * Returns -1 at the last NAL unit of the file, since no start code follows
+  * it.
+  */
+static int
+read_nalu_bytewise(ifstream * stream, NvBuffer * buffer,
+        char *parse_buffer, streamsize parse_buffer_size)
+{
+    char *buffer_ptr = (char *) buffer->planes[0].data;
+    char *stream_ptr;
+    bool nalu_found = false;
+
+    streamsize bytes_read;
+    streamsize stream_initial_pos = stream->tellg();
+
+    stream->read(parse_buffer, parse_buffer_size);
+    bytes_read = stream->gcount();
+
+    if (bytes_read == 0)
+    {
+        return buffer->planes[0].bytesused = 0;
+    }
+
+    stream_ptr = parse_buffer;
+    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
+    {
+        nalu_found = IS_NAL_UNIT_START(stream_ptr) ||
+                    IS_NAL_UNIT_START1(stream_ptr);
+        if (nalu_found)
+        {
+            break;
+        }
+        stream_ptr++;
+    }
+
+    if (!nalu_found)
+    {
+        return -1;
+    }
+
+    memcpy(buffer_ptr, stream_ptr, 4);
+    buffer_ptr += 4;
+    buffer->planes[0].bytesused = 4;
+    stream_ptr += 4;
+
+    while ((stream_ptr - parse_buffer) < (bytes_read - 3))
+    {
+        if (IS_NAL_UNIT_START(stream_ptr) || IS_NAL_UNIT_START1(stream_ptr))
+        {
+            streamsize seekto = stream_initial_pos +
+                    (stream_ptr - parse_buffer);
+            if(stream->eof())
+            {
+                stream->clear();
+            }
+            stream->seekg(seekto, stream->beg);
+            return 0;
+        }
+        *buffer_ptr = *stream_ptr;
+        buffer_ptr++;
+        stream_ptr++;
+        buffer->planes[0].bytesused++;
+    }
+
+    return -1;
+}
+
+/**
+  * Check that both parsers return the same NAL units. The byte-wise parser
+  * cannot return the last NAL unit of the file, so it is not compared.
+  */
+static int
+compare_parsers(const char *path)
+{
+    NvBitstreamReader *reader = NvBitstreamReader::createBitstreamReader(path);
+    ifstream stream(path, ios::in | ios::binary);
+    NvBuffer old_buffer(CHUNK_SIZE, 0);
+    NvBuffer new_buffer(CHUNK_SIZE, 0);
+    char *parse_buffer = new char[CHUNK_SIZE];
+    uint64_t num_nal_units;
+    uint64_t i;
+    int ret = -1;
+
+    if (!reader || !stream.is_open() ||
+        old_buffer.allocateMemory() < 0 || new_buffer.allocateMemory() < 0)
+    {
+        cerr << "Could not open " << path << endl;
+        goto cleanup;
+    }
+
+    num_nal_units = reader->getNumNalUnits();
+    if (num_nal_units == 0)
+    {
+        cerr << "No NAL units found in " << path << endl;
+        goto cleanup;
+    }
+
+    for (i = 0; i < num_nal_units; i++)
+    {
+        int old_ret = read_nalu_bytewise(&stream, &old_buffer, parse_buffer,
+                CHUNK_SIZE);
+
+        if (reader->readNextNalUnit(&new_buffer) < 0)
+        {
+            cerr << "NvBitstreamReader failed at NAL unit " << i << endl;
+            goto cleanup;
+        }
+        if (i == num_nal_units - 1)
+        {
+            if (old_ret != -1)
+            {
+                cerr << "Byte-wise parser returned data past the last NAL unit"
+                    << endl;
+                goto cleanup;
+            }
+            break;
+        }
+        if (old_ret < 0 ||
+            old_buffer.planes[0].bytesused != new_buffer.planes[0].bytesused ||
+            memcmp(old_buffer.planes[0].data, new_buffer.planes[0].data,
+                   new_buffer.planes[0].bytesused))
+        {
+            cerr << "NAL unit " << i << " at offset " <<
+                reader->getNalUnit(i).offset << " differs: " <<
+                old_buffer.planes[0].bytesused << " bytes byte-wise, " <<
+                new_buffer.planes[0].bytesused << " bytes indexed" << endl;
+            goto cleanup;
+        }
+    }
+
+    cout << "Compared " << num_nal_units << " NAL units: OK" << endl;
+    ret = 0;
+
+cleanup:
+    delete [] parse_buffer;
+    delete reader;
+    return ret;
+}
+
+/**
+  * Read the whole file once so that both parsers run from the page cache.
+  */
+static void
+warm_page_cache(const char *path)
+{
+    ifstream stream(path, ios::in | ios::binary);
+    vector<char> chunk(CHUNK_SIZE);
+
+    while (stream.read(chunk.data(), chunk.size()) || stream.gcount() > 0);
+}
+
+static int
+benchmark_parsers(const char *path)
+{
+    ifstream stream(path, ios::in | ios::binary);
+    NvBitstreamReader *reader;
+    NvBuffer buffer(CHUNK_SIZE, 0);
+    char *parse_buffer;
+    uint64_t file_size;
+    uint64_t num_nal_units = 0;
+    double start, old_time, index_time, new_time;
+
+    if (!stream.is_open() || buffer.allocateMemory() < 0)
+    {
+        cerr << "Could not open " << path << endl;
+        return -1;
+    }
+
+    warm_page_cache(path);
+
+    parse_buffer = new char[CHUNK_SIZE];
+    start = now_seconds();
+    while (read_nalu_bytewise(&stream, &buffer, parse_buffer, CHUNK_SIZE) == 0 &&
+           buffer.planes[0].bytesused)
+    {
+        num_nal_units++;
+    }
+    old_time = now_seconds() - start;
+    delete [] parse_buffer;
+
+    start = now_seconds();
+    reader = NvBitstreamReader::createBitstreamReader(path);
+    if (!reader)
+    {
+        return -1;
+    }
+    index_time = now_seconds() - start;
+    file_size = reader->getFileSize();
+    while (reader->readNextNalUnit(&buffer) == 0 && buffer.planes[0].bytesused);
+    new_time = now_seconds() - start;
+
+    cout << "Stream: " << file_size / (1024 * 1024) << " MiB, " <<
+        reader->getNumNalUnits() << " NAL units" << endl;
+    cout << "Byte-wise parser: " << old_time << " s, " <<
+        file_size / old_time / (1024 * 1024) << " MiB/s (" <<
+        num_nal_units << " NAL units)" << endl;
+    cout << "NvBitstreamReader: " << new_time << " s, " <<
+        file_size / new_time / (1024 * 1024) << " MiB/s (index " <<
+        index_time << " s)" << endl;
+    cout << "Speedup: " << old_time / new_time << "x" << endl;
+
+    delete reader;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: bitstream_sample [OPTIONS]" << endl << endl;
+    cout << "\t-s <size>  Size of the synthetic stream in MiB [Default = "
+        << DEFAULT_STREAM_SIZE_MIB << "]" << endl;
+    cout << "\t-o <path>  Path of the synthetic stream [Default = "
+        << DEFAULT_STREAM_PATH << "]" << endl;
+    cout << "\t-f <path>  Use an existing Annex-B stream instead" << endl;
+    cout << "\t-h         Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint64_t size_mib = DEFAULT_STREAM_SIZE_MIB;
+    const char *path = DEFAULT_STREAM_PATH;
+    bool synthetic = true;
+    int ret;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:o:f:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                size_mib = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            case 'f':
+                path = optarg;
+                synthetic = false;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    if (check_golden_streams() < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+
+    if (synthetic)
+    {
+        cout << "Writing " << size_mib << " MiB synthetic stream to " << path
+            << endl;
+        if (write_synthetic_stream(path, size_mib * 1024 * 1024) < 0)
+            return -1;
+    }
+
+    ret = compare_parsers(path);
+    if (ret == 0)
+        ret = benchmark_parsers(path);
+
+    if (synthetic)
+        unlink(path);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
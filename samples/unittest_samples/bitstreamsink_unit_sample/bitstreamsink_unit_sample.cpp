@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./bitstreamsink_sample [-n buffers] [-v]
+ * Example:
+ * ./bitstreamsink_sample
+ * ./bitstreamsink_sample -n 20000
+**/
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "NvBitstreamSink.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvBitstreamSink.
+ *
+ * - Buffers of random sizes, some larger than the ring, must come out
+ *   byte-identical in the file, with the stats accounting for all of them.
+ * - The sink writes into a FIFO whose pipe is full and which is only
+ *   drained after a while, so that the ring fills up. The high-water marks
+ *   must then reach the size of the ring and the number of buffers it can
+ *   hold, and the stalls must be counted.
+ * - Several threads write numbered records, each must be found whole and
+ *   in order per thread.
+ * - Writing to /dev/full must fail write() or flush() and set isInError().
+ */
+
+#define SINK_PATH "bitstreamsink_sample.bin"
+#define SINK_FIFO_PATH "bitstreamsink_sample.fifo"
+
+#define DEFAULT_NUM_BUFFERS 5000
+/* Smallest ring, as in NvBitstreamSink.cpp. */
+#define SMALL_RING_SIZE (64 * 1024)
+/* Number of buffers the ring can hold, as in NvBitstreamSink.cpp. */
+#define MAX_QUEUED_BUFFERS 4096
+#define FIFO_DRAIN_DELAY_USEC 100000
+#define NUM_PRODUCERS 4
+#define MAX_RECORD_SIZE 3000
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t size;
+} record_header_t;
+
+typedef struct
+{
+    NvBitstreamSink *sink;
+    uint32_t producer;
+    uint32_t num_records;
+    int ret;
+} producer_t;
+
+typedef struct
+{
+    int fd;
+    vector<unsigned char> data;
+} fifo_reader_t;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+fill_random(vector<unsigned char> &data)
+{
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = next_rand();
+    }
+}
+
+static int
+read_file(const char *path, vector<unsigned char> &data)
+{
+    unsigned char chunk[65536];
+    ssize_t ret;
+    int fd = open(path, O_RDONLY);
+
+    CHECK(fd >= 0, "Could not open " << path);
+    data.clear();
+    while ((ret = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + ret);
+    }
+    close(fd);
+    CHECK(ret == 0, "Could not read " << path);
+    return 0;
+}
+
+/**
+  * Writes @a sizes.size() buffers through a sink and checks the file.
+  */
+static int
+check_identical(const char *name, uint32_t ring_size,
+        const vector<uint32_t> &sizes, uint64_t sync_interval)
+{
+    NvBitstreamSink::NvBitstreamSinkStats stats;
+    vector<unsigned char> data;
+    vector<unsigned char> file;
+    uint64_t total = 0;
+    uint64_t t0;
+    uint64_t pos = 0;
+    uint32_t used_ring_size = ring_size < SMALL_RING_SIZE ? SMALL_RING_SIZE :
+        ring_size;
+
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        total += sizes[i];
+    }
+    data.resize(total);
+    fill_random(data);
+
+    NvBitstreamSink *sink = NvBitstreamSink::createBitstreamSink(name,
+            SINK_PATH, ring_size, sync_interval);
+    CHECK(sink, name << ": could not create the sink");
+
+    t0 = now_nsec();
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        if (sink->write(&data[pos], sizes[i]) < 0)
+        {
+            delete sink;
+            CHECK(false, name << ": write " << i << " failed");
+        }
+        pos += sizes[i];
+    }
+    if (sink->flush() < 0)
+    {
+        delete sink;
+        CHECK(false, name << ": flush failed");
+    }
+    t0 = now_nsec() - t0;
+    sink->getStats(stats);
+    delete sink;
+
+    CHECK(read_file(SINK_PATH, file) == 0, name << ": no output");
+    CHECK(file == data, name << ": output differs, " << file.size() <<
+            " bytes instead of " << total);
+    CHECK(stats.buffers_written == sizes.size(), name << ": " <<
+            stats.buffers_written << " buffers counted instead of " <<
+            sizes.size());
+    CHECK(stats.bytes_written == total, name << ": " << stats.bytes_written <<
+            " bytes counted instead of " << total);
+    CHECK(stats.max_queued_bytes <= used_ring_size, name <<
+            ": more bytes queued than the ring holds");
+    CHECK(stats.max_queued_buffers >= 1 &&
+            stats.max_queued_buffers <= MAX_QUEUED_BUFFERS, name <<
+            ": " << stats.max_queued_buffers << " buffers queued at most");
+    CHECK(stats.writev_calls >= 1 && stats.writev_calls <= sizes.size() +
+            total / used_ring_size + 1, name << ": " << stats.writev_calls <<
+            " write calls");
+    if (sync_interval)
+    {
+        CHECK(stats.sync_calls >= 1 && stats.sync_calls <=
+                total / sync_interval, name << ": " << stats.sync_calls <<
+                " sync calls for " << total << " bytes");
+    }
+    else
+    {
+        CHECK(stats.sync_calls == 0, name << ": synced without interval");
+    }
+
+    cout << name << ": " << sizes.size() << " buffers, " << total <<
+        " bytes in " << stats.writev_calls << " write calls, " <<
+        total * 1000.0 / (t0 ? t0 : 1) << " MB/s" << endl;
+    return 0;
+}
+
+static int
+check_sizes(uint32_t num_buffers)
+{
+    vector<uint32_t> sizes;
+
+    /* Encoded frames, mostly much smaller than the ring. */
+    for (uint32_t i = 0; i < num_buffers; i++)
+    {
+        sizes.push_back(1 + next_rand() % 20000);
+    }
+    if (check_identical("frames", 8 * 1024 * 1024, sizes, 0) < 0 ||
+            check_identical("frames synced", 8 * 1024 * 1024, sizes,
+                1024 * 1024) < 0)
+    {
+        return -1;
+    }
+
+    /* Buffers wrap around the end of the smallest ring, and some are
+       larger than the ring itself. */
+    sizes.clear();
+    for (uint32_t i = 0; i < num_buffers / 10 + 1; i++)
+    {
+        sizes.push_back(next_rand() % 4 == 0 ?
+                SMALL_RING_SIZE + next_rand() % (3 * SMALL_RING_SIZE) :
+                1 + next_rand() % (SMALL_RING_SIZE / 2));
+    }
+    sizes.push_back(0);
+    sizes.push_back(SMALL_RING_SIZE);
+    sizes.push_back(1);
+    if (check_identical("wrap-around", SMALL_RING_SIZE, sizes, 0) < 0)
+    {
+        return -1;
+    }
+
+    /* A ring size smaller than the minimum is raised to it. */
+    sizes.clear();
+    sizes.push_back(SMALL_RING_SIZE - 1);
+    sizes.push_back(SMALL_RING_SIZE - 1);
+    return check_identical("tiny ring", 1000, sizes, 0);
+}
+
+static void *
+fifo_reader_fcn(void *arg)
+{
+    fifo_reader_t *reader = (fifo_reader_t *) arg;
+    unsigned char chunk[65536];
+    ssize_t ret;
+
+    usleep(FIFO_DRAIN_DELAY_USEC);
+    while ((ret = read(reader->fd, chunk, sizeof(chunk))) != 0)
+    {
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        reader->data.insert(reader->data.end(), chunk, chunk + ret);
+    }
+    return NULL;
+}
+
+/**
+  * Writes @a num_buffers of @a size bytes into a FIFO whose pipe is full,
+  * so that the writer thread blocks and the ring fills up.
+  */
+static int
+check_full_ring(const char *name, uint32_t ring_size, uint32_t num_buffers,
+        uint32_t size, NvBitstreamSink::NvBitstreamSinkStats &stats)
+{
+    fifo_reader_t reader;
+    pthread_t reader_thread;
+    vector<unsigned char> data(num_buffers * size);
+    vector<unsigned char> prefill(4096, 0);
+    uint64_t prefilled = 0;
+    int fd;
+    int ret = 0;
+
+    unlink(SINK_FIFO_PATH);
+    CHECK(mkfifo(SINK_FIFO_PATH, 0600) == 0, "Could not create the FIFO");
+    reader.fd = open(SINK_FIFO_PATH, O_RDONLY | O_NONBLOCK);
+    CHECK(reader.fd >= 0, "Could not open the FIFO");
+
+    fd = open(SINK_FIFO_PATH, O_WRONLY | O_NONBLOCK);
+    CHECK(fd >= 0, "Could not open the FIFO for writing");
+    while (write(fd, &prefill[0], prefill.size()) > 0)
+    {
+        prefilled += prefill.size();
+    }
+    close(fd);
+    fcntl(reader.fd, F_SETFL, fcntl(reader.fd, F_GETFL) & ~O_NONBLOCK);
+    fill_random(data);
+
+    NvBitstreamSink *sink = NvBitstreamSink::createBitstreamSink(name,
+            SINK_FIFO_PATH, ring_size);
+    if (!sink)
+    {
+        close(reader.fd);
+        CHECK(false, name << ": could not create the sink");
+    }
+    pthread_create(&reader_thread, NULL, fifo_reader_fcn, &reader);
+
+    for (uint32_t i = 0; i < num_buffers && ret == 0; i++)
+    {
+        ret = sink->write(&data[i * size], size);
+    }
+    sink->getStats(stats);
+    delete sink;
+    pthread_join(reader_thread, NULL);
+    close(reader.fd);
+    unlink(SINK_FIFO_PATH);
+
+    CHECK(ret == 0, name << ": write failed");
+    CHECK(reader.data.size() == prefilled + data.size() &&
+            memcmp(&reader.data[prefilled], &data[0], data.size()) == 0,
+            name << ": output differs");
+    CHECK(stats.buffers_written == num_buffers, name << ": " <<
+            stats.buffers_written << " buffers counted");
+    CHECK(stats.stall_count > 0 && stats.stall_time_usec > 0, name <<
+            ": no stall counted");
+
+    cout << name << ": " << stats.max_queued_buffers << " buffers, " <<
+        stats.max_queued_bytes << " bytes queued at most, " <<
+        stats.stall_count << " stalls, " << stats.stall_time_usec <<
+        " usec" << endl;
+    return 0;
+}
+
+static int
+check_high_water_marks()
+{
+    NvBitstreamSink::NvBitstreamSinkStats stats;
+
+    /* The buffers divide the ring, which fills up exactly. */
+    CHECK(check_full_ring("full ring", SMALL_RING_SIZE, 64, 4096, stats) == 0,
+            "Filling the ring failed");
+    CHECK(stats.max_queued_bytes == SMALL_RING_SIZE, "full ring: " <<
+            stats.max_queued_bytes << " bytes queued at most instead of " <<
+            SMALL_RING_SIZE);
+
+    CHECK(check_full_ring("full buffer list", 1024 * 1024,
+                MAX_QUEUED_BUFFERS + 1000, 1, stats) == 0,
+            "Filling the buffer list failed");
+    CHECK(stats.max_queued_buffers == MAX_QUEUED_BUFFERS,
+            "full buffer list: " << stats.max_queued_buffers <<
+            " buffers queued at most instead of " << MAX_QUEUED_BUFFERS);
+    return 0;
+}
+
+static void *
+producer_fcn(void *arg)
+{
+    producer_t *producer = (producer_t *) arg;
+    uint64_t state = 0x9E3779B97F4A7C15ULL * (producer->producer + 1);
+    vector<unsigned char> record(sizeof(record_header_t) + MAX_RECORD_SIZE);
+    record_header_t *header = (record_header_t *) &record[0];
+
+    producer->ret = 0;
+    for (uint32_t seq = 0; seq < producer->num_records; seq++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        header->producer = producer->producer;
+        header->seq = seq;
+        header->size = (state >> 32) % MAX_RECORD_SIZE;
+        for (uint32_t i = 0; i < header->size; i++)
+        {
+            record[sizeof(record_header_t) + i] =
+                producer->producer * 31 + seq + i;
+        }
+        if (producer->sink->write(&record[0],
+                    sizeof(record_header_t) + header->size) < 0)
+        {
+            producer->ret = -1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int
+check_producers(uint32_t num_records)
+{
+    producer_t producers[NUM_PRODUCERS];
+    pthread_t threads[NUM_PRODUCERS];
+    uint32_t next_seq[NUM_PRODUCERS] = { 0 };
+    vector<unsigned char> file;
+    NvBitstreamSink::NvBitstreamSinkStats stats;
+    size_t pos = 0;
+
+    NvBitstreamSink *sink = NvBitstreamSink::createBitstreamSink("producers",
+            SINK_PATH, SMALL_RING_SIZE);
+    CHECK(sink, "producers: could not create the sink");
+
+    for (uint32_t i = 0; i < NUM_PRODUCERS; i++)
+    {
+        producers[i].sink = sink;
+        producers[i].producer = i;
+        producers[i].num_records = num_records;
+        pthread_create(&threads[i], NULL, producer_fcn, &producers[i]);
+    }
+    for (uint32_t i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    sink->getStats(stats);
+    delete sink;
+
+    for (uint32_t i = 0; i < NUM_PRODUCERS; i++)
+    {
+        CHECK(producers[i].ret == 0, "producers: write failed");
+    }
+    CHECK(stats.buffers_written == NUM_PRODUCERS * num_records,
+            "producers: " << stats.buffers_written << " buffers counted");
+
+    CHECK(read_file(SINK_PATH, file) == 0, "producers: no output");
+    while (pos < file.size())
+    {
+        record_header_t header;
+
+        CHECK(file.size() - pos >= sizeof(header),
+                "producers: truncated record header at " << pos);
+        memcpy(&header, &file[pos], sizeof(header));
+        pos += sizeof(header);
+        CHECK(header.producer < NUM_PRODUCERS &&
+                header.size < MAX_RECORD_SIZE &&
+                file.size() - pos >= header.size,
+                "producers: corrupted record header at " << pos);
+        CHECK(header.seq == next_seq[header.producer], "producers: record " <<
+                header.seq << " of thread " << header.producer <<
+                " instead of " << next_seq[header.producer]);
+        for (uint32_t i = 0; i < header.size; i++)
+        {
+            CHECK(file[pos + i] == (unsigned char)
+                    (header.producer * 31 + header.seq + i),
+                    "producers: record " << header.seq << " of thread " <<
+                    header.producer << " is interleaved");
+        }
+        pos += header.size;
+        next_seq[header.producer]++;
+    }
+    for (uint32_t i = 0; i < NUM_PRODUCERS; i++)
+    {
+        CHECK(next_seq[i] == num_records, "producers: " << next_seq[i] <<
+                " records of thread " << i << " instead of " << num_records);
+    }
+
+    cout << "producers: " << NUM_PRODUCERS << " threads, " << num_records <<
+        " records each, " << stats.stall_count << " stalls" << endl;
+    return 0;
+}
+
+static int
+check_error()
+{
+    vector<unsigned char> data(SMALL_RING_SIZE);
+    int ret = 0;
+
+    if (access("/dev/full", W_OK) < 0)
+    {
+        cout << "error: /dev/full not available, skipped" << endl;
+        return 0;
+    }
+
+    NvBitstreamSink *sink = NvBitstreamSink::createBitstreamSink("error",
+            "/dev/full");
+    CHECK(sink, "error: could not create the sink");
+
+    /* The first buffers may be queued before the writer fails. */
+    for (uint32_t i = 0; i < 1000 && ret == 0; i++)
+    {
+        ret = sink->write(&data[0], data.size());
+    }
+    if (ret == 0)
+    {
+        ret = sink->flush();
+    }
+    bool in_error = sink->isInError();
+    int flush_ret = sink->flush();
+    int write_ret = sink->write(&data[0], 1);
+    delete sink;
+
+    CHECK(ret < 0 && in_error, "error: writing to /dev/full succeeded");
+    CHECK(flush_ret < 0 && write_ret < 0,
+            "error: calls succeed after an error");
+    cout << "error: reported" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: bitstreamsink_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Buffers written per check [Default = "
+        << DEFAULT_NUM_BUFFERS << "]" << endl;
+    cout << "\t-v           Print the errors of the sink on /dev/full" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_buffers = DEFAULT_NUM_BUFFERS;
+    int ret = 0;
+    int opt;
+
+    /* Writing to /dev/full fails on purpose. */
+    log_level = LOG_LEVEL_INFO;
+
+    while ((opt = getopt(argc, argv, "n:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_buffers = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_ERROR;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_buffers < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_sizes(num_buffers) < 0 || check_high_water_marks() < 0 ||
+            check_producers(num_buffers / NUM_PRODUCERS + 1) < 0 ||
+            check_error() < 0)
+    {
+        ret = -1;
+    }
+    unlink(SINK_PATH);
+    unlink(SINK_FIFO_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./buffer_sample [-f frames] [-c consumers] [-n iterations]
+ * Example:
+ * ./buffer_sample
+ * ./buffer_sample -f 100000 -c 8
+**/
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include "NvBuffer.h"
+#include "NvBufferPool.h"
+
+using namespace std;
+
+/**
+ * ThreadSanitizer stress test of the NvBuffer reference counts and of
+ * NvBufferRef.
+ *
+ * A producer hands every buffer it acquires from an NvBufferPool to several
+ * consumer threads, each with its own handle, as a decoder hands its
+ * capture buffers to a converter and a renderer. Each buffer must reach
+ * every consumer intact and go back to the pool exactly once, after its
+ * last consumer dropped it. Threads then share and drop handles to a
+ * single buffer, whose reference count must end where it started.
+ *
+ * Built with -fsanitize=thread, the test fails on any data race reported.
+ */
+
+#define DEFAULT_FRAMES 20000
+#define DEFAULT_CONSUMERS 4
+#define DEFAULT_ITERATIONS 200000
+#define QUEUE_DEPTH 4
+#define POOL_FREE_BUFFERS 8
+#define FRAME_WIDTH 64
+#define FRAME_HEIGHT 64
+
+/**
+ * Bounded queue of buffer handles between the producer and one consumer.
+ */
+class BufferQueue
+{
+public:
+    BufferQueue()
+        :done(false)
+    {
+    }
+
+    void push(NvBufferRef &&buffer)
+    {
+        unique_lock<mutex> lock(queue_lock);
+
+        queue_cond.wait(lock, [this] { return queue.size() < QUEUE_DEPTH; });
+        queue.push_back(std::move(buffer));
+        queue_cond.notify_all();
+    }
+
+    /**
+      * Pops the next handle, returns false once the queue is closed and
+      * empty.
+      */
+    bool pop(NvBufferRef &buffer)
+    {
+        unique_lock<mutex> lock(queue_lock);
+
+        queue_cond.wait(lock, [this] { return done || !queue.empty(); });
+        if (queue.empty())
+        {
+            return false;
+        }
+        buffer = std::move(queue.front());
+        queue.pop_front();
+        queue_cond.notify_all();
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> lock(queue_lock);
+
+        done = true;
+        queue_cond.notify_all();
+    }
+
+private:
+    mutex queue_lock;
+    condition_variable queue_cond;
+    deque<NvBufferRef> queue;
+    bool done;
+};
+
+/**
+  * Checks that every frame reaches every consumer, in order and intact, and
+  * that all the buffers go back to the pool.
+  */
+static int
+check_fan_out(uint32_t num_frames, uint32_t num_consumers)
+{
+    NvBufferPool *pool = NvBufferPool::createBufferPool("buffer_sample",
+            POOL_FREE_BUFFERS);
+    NvBufferPool::NvBufferPoolStats stats;
+    vector<BufferQueue> queues(num_consumers);
+    vector<thread> consumers;
+    vector<uint32_t> received(num_consumers, 0);
+    vector<uint32_t> corrupted(num_consumers, 0);
+    uint32_t frame;
+    uint32_t i;
+    int ret = 0;
+
+    if (!pool)
+    {
+        cerr << "Could not create the buffer pool" << endl;
+        return -1;
+    }
+
+    for (i = 0; i < num_consumers; i++)
+    {
+        consumers.push_back(thread([&queues, &received, &corrupted, i] {
+            NvBufferRef buffer;
+
+            while (queues[i].pop(buffer))
+            {
+                uint32_t stamp;
+
+                memcpy(&stamp, buffer->planes[0].data, sizeof(stamp));
+                if (stamp != received[i])
+                {
+                    corrupted[i]++;
+                }
+                received[i]++;
+                buffer.reset();
+            }
+        }));
+    }
+
+    for (frame = 0; frame < num_frames; frame++)
+    {
+        NvBufferRef buffer = NvBufferRef::adopt(pool->acquire(
+                V4L2_PIX_FMT_YUV420M, FRAME_WIDTH, FRAME_HEIGHT));
+
+        if (!buffer)
+        {
+            cerr << "Could not acquire frame " << frame << endl;
+            ret = -1;
+            break;
+        }
+        memcpy(buffer->planes[0].data, &frame, sizeof(frame));
+        for (i = 0; i < num_consumers; i++)
+        {
+            queues[i].push(buffer.share());
+        }
+    }
+
+    for (i = 0; i < num_consumers; i++)
+    {
+        queues[i].close();
+        consumers[i].join();
+    }
+
+    pool->getStats(stats);
+    delete pool;
+
+    for (i = 0; i < num_consumers; i++)
+    {
+        if (received[i] != frame || corrupted[i])
+        {
+            cerr << "Consumer " << i << " received " << received[i] <<
+                " frames, " << corrupted[i] << " corrupted, of " << frame <<
+                endl;
+            ret = -1;
+        }
+    }
+    if (stats.outstanding)
+    {
+        cerr << stats.outstanding << " buffers not returned to the pool" << endl;
+        ret = -1;
+    }
+
+    cout << "Fan out of " << frame << " frames to " << num_consumers <<
+        " consumers: " << stats.allocations << " allocations, " <<
+        stats.reuses << " reuses" << endl;
+    return ret;
+}
+
+/**
+  * Threads share and drop handles to one buffer concurrently.
+  */
+static int
+check_ref_count(uint64_t iterations, uint32_t num_threads)
+{
+    NvBuffer buffer(V4L2_PIX_FMT_GREY, FRAME_WIDTH, FRAME_HEIGHT, 0);
+    NvBufferRef handle(&buffer);
+    vector<thread> threads;
+    uint32_t i;
+    int count;
+
+    for (i = 0; i < num_threads; i++)
+    {
+        threads.push_back(thread([&handle, iterations] {
+            for (uint64_t n = 0; n < iterations; n++)
+            {
+                NvBufferRef shared = handle.share();
+                NvBufferRef moved(std::move(shared));
+            }
+        }));
+    }
+    for (i = 0; i < num_threads; i++)
+    {
+        threads[i].join();
+    }
+
+    handle.reset();
+    count = buffer.ref() - 1;
+    buffer.unref();
+    if (count != 0)
+    {
+        cerr << "Reference count is " << count << " after all handles are "
+            "dropped" << endl;
+        return -1;
+    }
+
+    cout << "Reference count of " << num_threads << " threads: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: buffer_sample [OPTIONS]" << endl << endl;
+    cout << "\t-f <count>   Frames handed to the consumers [Default = "
+        << DEFAULT_FRAMES << "]" << endl;
+    cout << "\t-c <count>   Number of consumer threads [Default = "
+        << DEFAULT_CONSUMERS << "]" << endl;
+    cout << "\t-n <count>   Handles shared per thread [Default = "
+        << DEFAULT_ITERATIONS << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_frames = DEFAULT_FRAMES;
+    uint32_t num_consumers = DEFAULT_CONSUMERS;
+    uint64_t iterations = DEFAULT_ITERATIONS;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:c:n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                num_frames = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                num_consumers = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                iterations = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_frames < 1 || num_consumers < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_fan_out(num_frames, num_consumers) < 0 ||
+        check_ref_count(iterations, num_consumers * 2) < 0)
+    {
+        ret = -1;
+    }
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,576 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./bufferpool_sample [-n iterations]
+ * Example:
+ * ./bufferpool_sample
+ * ./bufferpool_sample -n 2000
+**/
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <linux/videodev2.h>
+
+#include "NvBuffer.h"
+#include "NvBufferPool.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of NvBufferPool.
+ *
+ * - Planes must be page aligned, hence 64 byte aligned, and must not
+ *   overlap. Software buffers allocated without a pool must be 64 byte
+ *   aligned.
+ * - Memory must only be reused for the same pixel format, width and
+ *   height, and the free list must keep at most its high-water mark,
+ *   least recently released first.
+ * - prewarm() and trim() must account for their buffers and bytes in
+ *   getStats(), and so must buffers created with the pool constructor of
+ *   NvBuffer.
+ * - Threads acquiring and releasing buffers concurrently must leave the
+ *   counts balanced.
+ *
+ * Allocating, writing and freeing a buffer from a prewarmed pool is then
+ * timed against new[], as NvBuffer allocated planes before, and against
+ * the aligned allocation of NvBuffer without a pool. The first buffer is
+ * reported apart: once malloc has freed a large block it raises its mmap
+ * threshold and recycles such blocks itself, without faulting the pages
+ * in again.
+ */
+
+#define DEFAULT_ITERATIONS 2000
+#define MAX_FREE_BUFFERS 4
+#define NUM_THREADS 4
+#define THREAD_ITERATIONS 2000
+#define CACHE_LINE_SIZE 64
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef struct
+{
+    const char *name;
+    uint32_t pixfmt;
+    uint32_t width;
+    uint32_t height;
+} frame_format_t;
+
+static const frame_format_t formats[] =
+{
+    { "yuv420_1080p", V4L2_PIX_FMT_YUV420M, 1920, 1080 },
+    { "nv12_1080p", V4L2_PIX_FMT_NV12M, 1920, 1080 },
+    { "yuv420_1080p_short", V4L2_PIX_FMT_YUV420M, 1920, 1088 },
+    { "yuv420_720p", V4L2_PIX_FMT_YUV420M, 1280, 720 },
+    { "nv12_4k", V4L2_PIX_FMT_NV12M, 3840, 2160 },
+};
+
+#define NUM_FORMATS (sizeof(formats) / sizeof(formats[0]))
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+  * Gets the bytes the pool maps for a buffer of @a format.
+  */
+static uint64_t
+get_mapped_size(const frame_format_t &format)
+{
+    NvBuffer buffer(format.pixfmt, format.width, format.height, 0);
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t size = 0;
+
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        const NvBuffer::NvBufferPlaneFormat &fmt = buffer.planes[i].fmt;
+        uint64_t length = fmt.width * fmt.bytesperpixel * fmt.height;
+
+        if (fmt.sizeimage > length)
+            length = fmt.sizeimage;
+        size += ALIGN_UP(length, page_size);
+    }
+    return size;
+}
+
+/**
+  * Checks the alignment and layout of the planes of @a buffer, and writes
+  * all of them.
+  */
+static int
+check_planes(const char *name, NvBuffer *buffer, size_t alignment)
+{
+    for (uint32_t i = 0; i < buffer->n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = buffer->planes[i];
+
+        CHECK(plane.data, name << ": plane " << i << " has no memory");
+        CHECK((uintptr_t) plane.data % alignment == 0, name << ": plane " <<
+                i << " at " << (void *) plane.data << " is not aligned to " <<
+                alignment);
+        CHECK(plane.length >= plane.fmt.stride * plane.fmt.height, name <<
+                ": plane " << i << " is too short");
+        for (uint32_t j = 0; j < buffer->n_planes; j++)
+        {
+            NvBuffer::NvBufferPlane &other = buffer->planes[j];
+
+            CHECK(i == j || plane.data + plane.length <= other.data ||
+                    other.data + other.length <= plane.data, name <<
+                    ": planes " << i << " and " << j << " overlap");
+        }
+        memset(plane.data, i + 1, plane.length);
+    }
+    return 0;
+}
+
+static int
+check_stats(const char *name, NvBufferPool *pool, uint64_t allocations,
+        uint64_t reuses, uint64_t releases, uint32_t outstanding,
+        uint32_t free_buffers, uint64_t free_bytes)
+{
+    NvBufferPool::NvBufferPoolStats stats;
+
+    pool->getStats(stats);
+    CHECK(stats.allocations == allocations && stats.reuses == reuses &&
+            stats.releases == releases && stats.outstanding == outstanding &&
+            stats.free_buffers == free_buffers &&
+            stats.free_bytes == free_bytes, name << ": " <<
+            stats.allocations << " allocations, " << stats.reuses <<
+            " reuses, " << stats.releases << " releases, " <<
+            stats.outstanding << " outstanding, " << stats.free_buffers <<
+            " free buffers of " << stats.free_bytes << " bytes instead of " <<
+            allocations << ", " << reuses << ", " << releases << ", " <<
+            outstanding << ", " << free_buffers << ", " << free_bytes);
+    return 0;
+}
+
+static int
+check_alignment()
+{
+    NvBufferPool *pool = NvBufferPool::createBufferPool("alignment",
+            MAX_FREE_BUFFERS);
+    NvBufferPool *huge_pool = NvBufferPool::createBufferPool("huge",
+            MAX_FREE_BUFFERS, NvBufferPool::FLAG_HUGEPAGES);
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    int ret = 0;
+
+    CHECK(pool && huge_pool, "Could not create the pools");
+    for (uint32_t i = 0; i < NUM_FORMATS && ret == 0; i++)
+    {
+        const frame_format_t &format = formats[i];
+        NvBuffer *buffer = pool->acquire(format.pixfmt, format.width,
+                format.height);
+        NvBuffer *huge_buffer = huge_pool->acquire(format.pixfmt,
+                format.width, format.height);
+        NvBuffer plain(format.pixfmt, format.width, format.height, 0);
+
+        if (!buffer || !huge_buffer || plain.allocateMemory() < 0)
+        {
+            cerr << format.name << ": could not allocate" << endl;
+            ret = -1;
+        }
+        else if (check_planes(format.name, buffer, page_size) < 0 ||
+                check_planes(format.name, buffer, CACHE_LINE_SIZE) < 0 ||
+                check_planes(format.name, huge_buffer, page_size) < 0 ||
+                check_planes(format.name, &plain, CACHE_LINE_SIZE) < 0)
+        {
+            ret = -1;
+        }
+        if (buffer)
+            buffer->unref();
+        if (huge_buffer)
+            huge_buffer->unref();
+    }
+    delete huge_pool;
+    delete pool;
+    if (ret == 0)
+    {
+        cout << "alignment: OK" << endl;
+    }
+    return ret;
+}
+
+static int
+check_reuse()
+{
+    NvBufferPool *pool = NvBufferPool::createBufferPool("reuse",
+            MAX_FREE_BUFFERS);
+    NvBuffer *buffers[NUM_FORMATS];
+    NvBuffer *buffer;
+    unsigned char *data;
+    uint64_t bytes = 0;
+
+    CHECK(pool, "Could not create the pool");
+
+    /* Formats differ by pixel format, width or height only, none of them
+       may take the memory of another. */
+    for (uint32_t i = 0; i < NUM_FORMATS; i++)
+    {
+        buffers[i] = pool->acquire(formats[i].pixfmt, formats[i].width,
+                formats[i].height);
+        CHECK(buffers[i], formats[i].name << ": could not acquire");
+        CHECK(buffers[i]->planes[0].fmt.width == formats[i].width &&
+                buffers[i]->planes[0].fmt.height == formats[i].height,
+                formats[i].name << ": wrong size");
+    }
+    CHECK(check_stats("acquire", pool, NUM_FORMATS, 0, 0, NUM_FORMATS, 0,
+                0) == 0, "Acquiring failed");
+
+    data = buffers[0]->planes[0].data;
+    buffers[0]->unref();
+    bytes += get_mapped_size(formats[0]);
+    CHECK(check_stats("release", pool, NUM_FORMATS, 0, 0, NUM_FORMATS - 1, 1,
+                bytes) == 0, "Releasing failed");
+    for (uint32_t i = 1; i < NUM_FORMATS; i++)
+    {
+        buffers[i]->unref();
+        if (i < MAX_FREE_BUFFERS)
+            bytes += get_mapped_size(formats[i]);
+    }
+    /* The last buffer is over the high-water mark and unmapped. */
+    CHECK(check_stats("high-water mark", pool, NUM_FORMATS, 0,
+                NUM_FORMATS - MAX_FREE_BUFFERS, 0, MAX_FREE_BUFFERS,
+                bytes) == 0, "Keeping the free buffers failed");
+
+    buffer = pool->acquire(formats[0].pixfmt, formats[0].width,
+            formats[0].height);
+    CHECK(buffer && buffer->planes[0].data == data,
+            "The memory of the same format was not reused");
+    CHECK(check_stats("reuse", pool, NUM_FORMATS, 1,
+                NUM_FORMATS - MAX_FREE_BUFFERS, 1, MAX_FREE_BUFFERS - 1,
+                bytes - get_mapped_size(formats[0])) == 0, "Reusing failed");
+    buffer->unref();
+
+    /* Least recently released first: formats[1] goes. */
+    pool->trim(MAX_FREE_BUFFERS - 1);
+    bytes -= get_mapped_size(formats[1]);
+    CHECK(check_stats("trim", pool, NUM_FORMATS, 1,
+                NUM_FORMATS - MAX_FREE_BUFFERS + 1, 0, MAX_FREE_BUFFERS - 1,
+                bytes) == 0, "Trimming failed");
+    buffer = pool->acquire(formats[1].pixfmt, formats[1].width,
+            formats[1].height);
+    CHECK(buffer, "Could not acquire");
+    buffer->unref();
+    CHECK(check_stats("trimmed format", pool, NUM_FORMATS + 1, 1,
+                NUM_FORMATS - MAX_FREE_BUFFERS + 1, 0, MAX_FREE_BUFFERS,
+                bytes + get_mapped_size(formats[1])) == 0,
+            "The trimmed format was reused");
+
+    pool->trim(0);
+    CHECK(check_stats("trim all", pool, NUM_FORMATS + 1, 1,
+                NUM_FORMATS + 1, 0, 0, 0) == 0, "Trimming all failed");
+    delete pool;
+    cout << "reuse: OK" << endl;
+    return 0;
+}
+
+static int
+check_prewarm()
+{
+    const frame_format_t &format = formats[1];
+    NvBufferPool *pool = NvBufferPool::createBufferPool("prewarm",
+            MAX_FREE_BUFFERS);
+    uint64_t size = get_mapped_size(format);
+    NvBuffer *buffers[MAX_FREE_BUFFERS];
+    NvBuffer *buffer;
+
+    CHECK(pool, "Could not create the pool");
+    CHECK(pool->prewarm(format.pixfmt, format.width, format.height, 2) == 0,
+            "Could not prewarm");
+    CHECK(check_stats("prewarm", pool, 2, 0, 0, 0, 2, 2 * size) == 0,
+            "Prewarming failed");
+
+    /* Capped by the high-water mark. */
+    CHECK(pool->prewarm(format.pixfmt, format.width, format.height,
+                10 * MAX_FREE_BUFFERS) == 0, "Could not prewarm");
+    CHECK(check_stats("prewarm cap", pool, MAX_FREE_BUFFERS, 0, 0, 0,
+                MAX_FREE_BUFFERS, MAX_FREE_BUFFERS * size) == 0,
+            "Capping prewarm failed");
+
+    for (uint32_t i = 0; i < MAX_FREE_BUFFERS; i++)
+    {
+        buffers[i] = pool->acquire(format.pixfmt, format.width,
+                format.height);
+        CHECK(buffers[i], "Could not acquire");
+    }
+    CHECK(check_stats("prewarmed acquire", pool, MAX_FREE_BUFFERS,
+                MAX_FREE_BUFFERS, 0, MAX_FREE_BUFFERS, 0, 0) == 0,
+            "Prewarmed buffers were not reused");
+
+    /* Buffers of the pool constructor go back to the pool on delete. */
+    buffer = new NvBuffer(format.pixfmt, format.width, format.height, 0,
+            pool);
+    CHECK(buffer->allocateMemory() == 0, "Could not allocate");
+    CHECK(check_stats("constructor", pool, MAX_FREE_BUFFERS + 1,
+                MAX_FREE_BUFFERS, 0, MAX_FREE_BUFFERS + 1, 0, 0) == 0,
+            "Allocating with the pool constructor failed");
+    delete buffer;
+    for (uint32_t i = 0; i < MAX_FREE_BUFFERS; i++)
+    {
+        buffers[i]->unref();
+    }
+    CHECK(check_stats("release all", pool, MAX_FREE_BUFFERS + 1,
+                MAX_FREE_BUFFERS, 1, 0, MAX_FREE_BUFFERS,
+                MAX_FREE_BUFFERS * size) == 0, "Releasing failed");
+
+    pool->trim(1);
+    CHECK(check_stats("trim", pool, MAX_FREE_BUFFERS + 1, MAX_FREE_BUFFERS,
+                MAX_FREE_BUFFERS, 0, 1, size) == 0, "Trimming failed");
+    delete pool;
+    cout << "prewarm and trim: OK" << endl;
+    return 0;
+}
+
+static int
+check_threads()
+{
+    NvBufferPool *pool = NvBufferPool::createBufferPool("threads",
+            MAX_FREE_BUFFERS);
+    NvBufferPool::NvBufferPoolStats stats;
+    vector<thread> threads;
+    vector<int> results(NUM_THREADS, 0);
+
+    CHECK(pool, "Could not create the pool");
+    for (uint32_t t = 0; t < NUM_THREADS; t++)
+    {
+        threads.push_back(thread([pool, t, &results]() {
+            uint64_t state = 0x9E3779B97F4A7C15ULL * (t + 1);
+
+            for (uint32_t i = 0; i < THREAD_ITERATIONS; i++)
+            {
+                /* The small formats only, two at a time. */
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                const frame_format_t &a = formats[(state >> 32) % 4];
+                const frame_format_t &b = formats[(state >> 40) % 4];
+                NvBuffer *first = pool->acquire(a.pixfmt, a.width / 8,
+                        a.height / 8);
+                NvBuffer *second = pool->acquire(b.pixfmt, b.width / 8,
+                        b.height / 8);
+
+                if (!first || !second)
+                {
+                    results[t] = -1;
+                }
+                else
+                {
+                    first->planes[0].data[0] = t;
+                    second->planes[0].data[0] = t;
+                    if (first->planes[0].data[0] != t)
+                        results[t] = -1;
+                }
+                if (first)
+                    first->unref();
+                if (second)
+                    second->unref();
+            }
+        }));
+    }
+    for (uint32_t t = 0; t < NUM_THREADS; t++)
+    {
+        threads[t].join();
+        CHECK(results[t] == 0, "Thread " << t << " failed");
+    }
+
+    pool->getStats(stats);
+    CHECK(stats.allocations + stats.reuses ==
+            2ULL * NUM_THREADS * THREAD_ITERATIONS && stats.outstanding == 0 &&
+            stats.free_buffers <= MAX_FREE_BUFFERS &&
+            stats.allocations == stats.releases + stats.free_buffers, "threads: " <<
+            stats.allocations << " allocations, " << stats.reuses <<
+            " reuses, " << stats.releases << " releases, " <<
+            stats.free_buffers << " free buffers");
+    delete pool;
+    cout << "threads: " << stats.reuses << " of " <<
+        2 * NUM_THREADS * THREAD_ITERATIONS << " buffers reused" << endl;
+    return 0;
+}
+
+/**
+  * Writes a byte in each page of the planes, as the first use of a buffer
+  * would fault them in.
+  */
+static uint32_t
+touch_planes(unsigned char **data, const uint32_t *lengths, uint32_t n_planes)
+{
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < n_planes; i++)
+    {
+        for (uint32_t j = 0; j < lengths[i]; j += 4096)
+        {
+            data[i][j] = j / 4096 + 1;
+        }
+        sum += data[i][lengths[i] - 1] + data[i][4096];
+    }
+    return sum;
+}
+
+static int
+benchmark(uint32_t iterations)
+{
+    const frame_format_t *bench_formats[] = { &formats[0], &formats[4] };
+    uint64_t checksum = 0;
+
+    for (uint32_t f = 0; f < 2; f++)
+    {
+        const frame_format_t &format = *bench_formats[f];
+        NvBufferPool *pool = NvBufferPool::createBufferPool("benchmark", 1);
+        NvBuffer layout(format.pixfmt, format.width, format.height, 0);
+        unsigned char *data[MAX_PLANES];
+        uint32_t lengths[MAX_PLANES];
+        uint64_t t0, new_nsec, plain_nsec, pool_nsec;
+        uint64_t new_first_nsec = 0, pool_first_nsec = 0;
+
+        CHECK(pool, "Could not create the pool");
+        CHECK(pool->prewarm(format.pixfmt, format.width, format.height, 1) ==
+                0, "Could not prewarm");
+        for (uint32_t i = 0; i < layout.n_planes; i++)
+        {
+            const NvBuffer::NvBufferPlaneFormat &fmt = layout.planes[i].fmt;
+            lengths[i] = fmt.sizeimage;
+        }
+
+        t0 = now_nsec();
+        for (uint32_t n = 0; n < iterations; n++)
+        {
+            for (uint32_t i = 0; i < layout.n_planes; i++)
+                data[i] = new unsigned char[lengths[i]];
+            checksum += touch_planes(data, lengths, layout.n_planes);
+            for (uint32_t i = 0; i < layout.n_planes; i++)
+                delete[] data[i];
+            if (n == 0)
+                new_first_nsec = now_nsec() - t0;
+        }
+        new_nsec = now_nsec() - t0;
+
+        t0 = now_nsec();
+        for (uint32_t n = 0; n < iterations; n++)
+        {
+            NvBuffer buffer(format.pixfmt, format.width, format.height, 0);
+
+            CHECK(buffer.allocateMemory() == 0, "Could not allocate");
+            for (uint32_t i = 0; i < buffer.n_planes; i++)
+                data[i] = buffer.planes[i].data;
+            checksum += touch_planes(data, lengths, buffer.n_planes);
+        }
+        plain_nsec = now_nsec() - t0;
+
+        t0 = now_nsec();
+        for (uint32_t n = 0; n < iterations; n++)
+        {
+            NvBuffer *buffer = pool->acquire(format.pixfmt, format.width,
+                    format.height);
+
+            CHECK(buffer, "Could not acquire");
+            for (uint32_t i = 0; i < buffer->n_planes; i++)
+                data[i] = buffer->planes[i].data;
+            checksum += touch_planes(data, lengths, buffer->n_planes);
+            buffer->unref();
+            if (n == 0)
+                pool_first_nsec = now_nsec() - t0;
+        }
+        pool_nsec = now_nsec() - t0;
+        delete pool;
+
+        cout << format.name << ", first buffer: new[] " <<
+            new_first_nsec / 1000.0 << " usec, NvBufferPool " <<
+            pool_first_nsec / 1000.0 << " usec" << endl;
+        cout << format.name << ", " << iterations << " buffers:" << endl;
+        cout << "  new[]: " << new_nsec / 1000.0 / iterations << " usec" <<
+            endl;
+        cout << "  NvBuffer: " << plain_nsec / 1000.0 / iterations <<
+            " usec" << endl;
+        cout << "  NvBufferPool: " << pool_nsec / 1000.0 / iterations <<
+            " usec (" << (double) new_nsec / pool_nsec << "x new[])" << endl;
+    }
+    /* Keeps the writes from being optimized out. */
+    return checksum == 0 ? -1 : 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: bufferpool_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Buffers allocated per benchmark [Default = "
+        << DEFAULT_ITERATIONS << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (iterations < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_alignment() < 0 || check_reuse() < 0 || check_prewarm() < 0 ||
+            check_threads() < 0 || benchmark(iterations) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,1684 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./container_sample [-k]
+ * Example:
+ * ./container_sample
+**/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include "NvContainerReader.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvContainerReader.
+ *
+ * Synthetic MP4, fragmented MP4 and Matroska files are built box by box and
+ * element by element, along with a reference extraction of every video
+ * sample: the Annex-B access unit with the parameter sets of the codec
+ * configuration on key frames for H.264 and H.265, the temporal unit with a
+ * temporal delimiter for AV1, the raw frame for VP8 and VP9, and the
+ * presentation time in microseconds.
+ *
+ * The files exercise the layouts found in the wild: 1, 2 and 4 byte NAL
+ * unit lengths, stz2 and co64 tables, the moov before or after a 64-bit
+ * mdat, edit lists, signed composition offsets, interleaved audio, the
+ * tfhd and trex defaults of fragments, Matroska blocks in block groups,
+ * unknown-sized segments and clusters, laced blocks and timecode scales.
+ *
+ * Each file is read back and every sample must match its reference byte
+ * for byte. Seeking to key frames, the end of the stream and a buffer too
+ * small for a sample are checked as well.
+ */
+
+#define CONTAINER_PATH "container_sample.bin"
+
+#define BUFFER_SIZE (8 << 20)
+
+#define CONTAINER_MP4        0
+#define CONTAINER_FRAGMENTED 1
+#define CONTAINER_MATROSKA   2
+
+#define SCENARIO_MOOV_FIRST       (1 << 0)
+#define SCENARIO_STZ2             (1 << 1)
+#define SCENARIO_CO64             (1 << 2)
+#define SCENARIO_NO_AUDIO         (1 << 3)
+#define SCENARIO_NO_EDIT_LIST     (1 << 4)
+#define SCENARIO_CTTS_V1          (1 << 5)
+#define SCENARIO_NO_STSS          (1 << 6)
+#define SCENARIO_LARGE_MDAT       (1 << 7)
+#define SCENARIO_BASE_OFFSET      (1 << 8)
+#define SCENARIO_SAMPLE_FLAGS     (1 << 9)
+#define SCENARIO_SIZE_IN_TREX     (1 << 10)
+#define SCENARIO_UNKNOWN_SEGMENT  (1 << 11)
+#define SCENARIO_UNKNOWN_CLUSTER  (1 << 12)
+#define SCENARIO_NO_SEQ_ON_KEY    (1 << 13)
+
+#define TFHD_BASE_DATA_OFFSET         0x000001
+#define TFHD_DEFAULT_SAMPLE_DURATION  0x000008
+#define TFHD_DEFAULT_SAMPLE_SIZE      0x000010
+#define TFHD_DEFAULT_SAMPLE_FLAGS     0x000020
+#define TFHD_DEFAULT_BASE_IS_MOOF     0x020000
+
+#define TRUN_DATA_OFFSET              0x000001
+#define TRUN_FIRST_SAMPLE_FLAGS       0x000004
+#define TRUN_SAMPLE_SIZE              0x000200
+#define TRUN_SAMPLE_FLAGS             0x000400
+#define TRUN_SAMPLE_CTO               0x000800
+
+#define SAMPLE_FLAGS_SYNC 0x02000000
+#define SAMPLE_FLAGS_NON_SYNC 0x00010000
+
+#define MATROSKA_FRAME_MS 40
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/**
+ * Describes one file to build and read back.
+ */
+typedef struct
+{
+    const char *name;
+    uint32_t container;         /**< CONTAINER_* value. */
+    uint32_t pixfmt;
+    uint32_t length_size;       /**< Size of the NAL unit lengths. */
+    uint32_t flags;             /**< SCENARIO_* values. */
+    uint32_t timecode_scale;    /**< Matroska only. */
+} scenario_t;
+
+/**
+ * Frame of the synthetic stream, in decode order.
+ */
+typedef struct
+{
+    vector<vector<uint8_t> > units;     /**< NAL units or OBUs. */
+    bool key_frame;
+    uint32_t display;                   /**< Index in display order. */
+} frame_t;
+
+/**
+ * Decoder configuration stored in the sample entry or the CodecPrivate.
+ */
+typedef struct
+{
+    const char *type;                   /**< Box type, NULL for VP8 and VP9. */
+    vector<uint8_t> config;
+    vector<uint8_t> parameter_sets;     /**< As the reader must output them. */
+} codec_config_t;
+
+/**
+ * Sample the reader must return.
+ */
+typedef struct
+{
+    vector<uint8_t> data;
+    bool key_frame;
+    int64_t pts;
+} expected_sample_t;
+
+/** AV1 sequence header OBU payload, 1920x1080 main profile. */
+static const uint8_t av1_sequence_header[] =
+{
+    0x00, 0x00, 0x00, 0x6a, 0xef, 0xbf, 0xe1, 0xbc,
+    0x02, 0x19, 0x90, 0x10, 0x10, 0x10, 0x40
+};
+
+static const uint8_t start_code[] = { 0, 0, 0, 1 };
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static uint32_t
+choose(const uint32_t *values, uint32_t count)
+{
+    return values[next_rand() % count];
+}
+
+static void
+put_u16(vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void
+put_u32(vector<uint8_t> &out, uint32_t value)
+{
+    put_u16(out, value >> 16);
+    put_u16(out, value);
+}
+
+static void
+put_u64(vector<uint8_t> &out, uint64_t value)
+{
+    put_u32(out, value >> 32);
+    put_u32(out, value);
+}
+
+static void
+put_be(vector<uint8_t> &out, uint64_t value, uint32_t size)
+{
+    while (size-- > 0)
+    {
+        out.push_back(value >> (8 * size));
+    }
+}
+
+static void
+put_leb128(vector<uint8_t> &out, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(byte | (value ? 0x80 : 0));
+    } while (value);
+}
+
+static void
+put_random(vector<uint8_t> &out, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        out.push_back(next_rand());
+    }
+}
+
+static void
+append(vector<uint8_t> &out, const vector<uint8_t> &data)
+{
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+static void
+append(vector<uint8_t> &out, const void *data, size_t size)
+{
+    out.insert(out.end(), (const uint8_t *) data, (const uint8_t *) data + size);
+}
+
+static vector<uint8_t>
+make_bytes(const char *str)
+{
+    return vector<uint8_t>(str, str + strlen(str));
+}
+
+static vector<uint8_t>
+box(const char *type, const vector<uint8_t> &payload)
+{
+    vector<uint8_t> out;
+
+    put_u32(out, 8 + payload.size());
+    append(out, type, 4);
+    append(out, payload);
+    return out;
+}
+
+static vector<uint8_t>
+full_box(const char *type, uint32_t version, uint32_t flags,
+        const vector<uint8_t> &payload)
+{
+    vector<uint8_t> out;
+
+    put_u32(out, (version << 24) | flags);
+    append(out, payload);
+    return box(type, out);
+}
+
+/**
+  * Frames of a GOP structure with @a bframes B-frames between the
+  * reference frames, in decode order.
+  */
+static vector<frame_t>
+make_frames(uint32_t pixfmt, uint32_t num_frames, uint32_t gop,
+        uint32_t bframes, bool seq_on_key, uint32_t max_slice_size)
+{
+    static const uint32_t h264_sizes[] = { 5, 100, 300, 2000 };
+    static const uint32_t h265_sizes[] = { 5, 100, 300, 3000 };
+    static const uint32_t av1_sizes[] = { 5, 100, 300 };
+    static const uint32_t vpx_sizes[] = { 10, 500 };
+    vector<uint32_t> order;
+    vector<frame_t> frames;
+    uint32_t i = 0;
+
+    while (i < num_frames)
+    {
+        uint32_t g = min(gop, num_frames - i);
+        uint32_t j = 1;
+
+        order.push_back(i);
+        while (j < g)
+        {
+            uint32_t p = min(j + bframes, g - 1);
+
+            order.push_back(i + p);
+            for (uint32_t b = j; b < p; b++)
+            {
+                order.push_back(i + b);
+            }
+            j = p + 1;
+        }
+        i += g;
+    }
+
+    for (i = 0; i < order.size(); i++)
+    {
+        frame_t frame;
+        vector<uint8_t> unit;
+
+        frame.display = order[i];
+        frame.key_frame = order[i] % gop == 0;
+
+        switch (pixfmt)
+        {
+            case V4L2_PIX_FMT_H264:
+                if (next_rand() % 10 < 3)
+                {
+                    unit.assign(1, 0x06);
+                    put_random(unit, 2 + next_rand() % 28);
+                    frame.units.push_back(unit);
+                }
+                for (uint32_t n = 1 + next_rand() % 3; n > 0; n--)
+                {
+                    unit.assign(1, frame.key_frame ? 0x65 : 0x41);
+                    put_random(unit, min(max_slice_size, choose(h264_sizes, 4)));
+                    frame.units.push_back(unit);
+                }
+                break;
+            case V4L2_PIX_FMT_H265:
+                unit.push_back(frame.key_frame ? 0x26 : 0x02);
+                unit.push_back(0x01);
+                put_random(unit, choose(h265_sizes, 4));
+                frame.units.push_back(unit);
+                break;
+            case V4L2_PIX_FMT_AV1:
+                if (frame.key_frame && seq_on_key)
+                {
+                    unit.assign(1, 0x0A);
+                    put_leb128(unit, sizeof(av1_sequence_header));
+                    append(unit, av1_sequence_header,
+                            sizeof(av1_sequence_header));
+                    frame.units.push_back(unit);
+                    unit.clear();
+                }
+                {
+                    vector<uint8_t> payload;
+
+                    put_random(payload, choose(av1_sizes, 3));
+                    unit.push_back(0x32);
+                    put_leb128(unit, payload.size());
+                    append(unit, payload);
+                    frame.units.push_back(unit);
+                }
+                break;
+            default:
+                unit.push_back(frame.key_frame ? 0x82 : 0x86);
+                put_random(unit, choose(vpx_sizes, 2));
+                frame.units.push_back(unit);
+                break;
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static codec_config_t
+make_codec_config(uint32_t pixfmt, uint32_t length_size)
+{
+    codec_config_t c;
+    vector<vector<uint8_t> > sps(2), pps(2);
+    size_t i;
+
+    c.type = NULL;
+    switch (pixfmt)
+    {
+        case V4L2_PIX_FMT_H264:
+        {
+            static const uint8_t header[] = { 0x67, 0x64, 0x00, 0x28 };
+            static const uint8_t pps0[] = { 0x68, 0xee, 0x3c, 0x80 };
+            static const uint8_t pps1[] = { 0x68, 0xce, 0x01 };
+            static const uint8_t trailer[] = { 0xFD, 0xF8, 0xF8, 0x00 };
+
+            append(sps[0], header, sizeof(header));
+            put_random(sps[0], 10);
+            append(sps[1], header, sizeof(header));
+            sps[1].push_back(0x11);
+            append(pps[0], pps0, sizeof(pps0));
+            append(pps[1], pps1, sizeof(pps1));
+
+            c.type = "avcC";
+            c.config.push_back(1);
+            c.config.push_back(100);
+            c.config.push_back(0);
+            c.config.push_back(40);
+            c.config.push_back(0xFC | (length_size - 1));
+            c.config.push_back(0xE0 | sps.size());
+            for (i = 0; i < sps.size(); i++)
+            {
+                put_u16(c.config, sps[i].size());
+                append(c.config, sps[i]);
+            }
+            c.config.push_back(pps.size());
+            for (i = 0; i < pps.size(); i++)
+            {
+                put_u16(c.config, pps[i].size());
+                append(c.config, pps[i]);
+            }
+            append(c.config, trailer, sizeof(trailer));
+
+            for (i = 0; i < sps.size(); i++)
+            {
+                append(c.parameter_sets, start_code, sizeof(start_code));
+                append(c.parameter_sets, sps[i]);
+            }
+            for (i = 0; i < pps.size(); i++)
+            {
+                append(c.parameter_sets, start_code, sizeof(start_code));
+                append(c.parameter_sets, pps[i]);
+            }
+            break;
+        }
+        case V4L2_PIX_FMT_H265:
+        {
+            static const uint8_t header[] =
+            {
+                0x01, 0x01, 0x60, 0x00, 0x00, 0x00, 0x90, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x5D, 0xF0, 0x00, 0xFC, 0xFD, 0xF8, 0xF8, 0x00,
+                0x00
+            };
+            static const uint8_t vps[] = { 0x40, 0x01, 0x0c, 0x01, 0xff };
+            static const uint8_t sps_header[] = { 0x42, 0x01, 0x01, 0x01, 0x60 };
+            static const uint8_t pps0[] = { 0x44, 0x01, 0xc1, 0x72 };
+            static const uint8_t pps1[] = { 0x44, 0x01, 0xc0, 0x11 };
+            static const uint8_t sei[] = { 0x4e, 0x01, 0x05, 0x04, 'a', 'b', 'c', 'd' };
+            vector<vector<uint8_t> > arrays[4];
+            static const uint8_t types[4] = { 32, 33, 34, 39 };
+
+            arrays[0].push_back(vector<uint8_t>(vps, vps + sizeof(vps)));
+            arrays[1].push_back(vector<uint8_t>(sps_header,
+                        sps_header + sizeof(sps_header)));
+            put_random(arrays[1][0], 20);
+            arrays[2].push_back(vector<uint8_t>(pps0, pps0 + sizeof(pps0)));
+            arrays[2].push_back(vector<uint8_t>(pps1, pps1 + sizeof(pps1)));
+            arrays[3].push_back(vector<uint8_t>(sei, sei + sizeof(sei)));
+
+            c.type = "hvcC";
+            append(c.config, header, sizeof(header));
+            c.config.push_back(0x0C | (length_size - 1));
+            c.config.push_back(4);
+            for (i = 0; i < 4; i++)
+            {
+                c.config.push_back(0x80 | types[i]);
+                put_u16(c.config, arrays[i].size());
+                for (size_t j = 0; j < arrays[i].size(); j++)
+                {
+                    put_u16(c.config, arrays[i][j].size());
+                    append(c.config, arrays[i][j]);
+                    append(c.parameter_sets, start_code, sizeof(start_code));
+                    append(c.parameter_sets, arrays[i][j]);
+                }
+            }
+            break;
+        }
+        case V4L2_PIX_FMT_AV1:
+            c.type = "av1C";
+            c.parameter_sets.push_back(0x0A);
+            put_leb128(c.parameter_sets, sizeof(av1_sequence_header));
+            append(c.parameter_sets, av1_sequence_header,
+                    sizeof(av1_sequence_header));
+            c.config.push_back(0x81);
+            c.config.push_back(0x08);
+            c.config.push_back(0x0C);
+            c.config.push_back(0x00);
+            append(c.config, c.parameter_sets);
+            break;
+        default:
+            break;
+    }
+    return c;
+}
+
+static bool
+is_nal_codec(uint32_t pixfmt)
+{
+    return pixfmt == V4L2_PIX_FMT_H264 || pixfmt == V4L2_PIX_FMT_H265;
+}
+
+/**
+  * Frame as stored in the container: length prefixed NAL units, or the
+  * OBUs and frames as they are.
+  */
+static vector<uint8_t>
+sample_bytes(uint32_t pixfmt, const frame_t &frame, uint32_t length_size)
+{
+    vector<uint8_t> out;
+
+    for (size_t i = 0; i < frame.units.size(); i++)
+    {
+        if (is_nal_codec(pixfmt))
+        {
+            put_be(out, frame.units[i].size(), length_size);
+        }
+        append(out, frame.units[i]);
+    }
+    return out;
+}
+
+/**
+  * Reference extraction of a frame, built from its units.
+  */
+static vector<uint8_t>
+expected_bytes(uint32_t pixfmt, const frame_t &frame, const codec_config_t &c)
+{
+    vector<uint8_t> out;
+    size_t i;
+
+    if (is_nal_codec(pixfmt))
+    {
+        if (frame.key_frame)
+        {
+            append(out, c.parameter_sets);
+        }
+        for (i = 0; i < frame.units.size(); i++)
+        {
+            append(out, start_code, sizeof(start_code));
+            append(out, frame.units[i]);
+        }
+        return out;
+    }
+
+    if (pixfmt == V4L2_PIX_FMT_AV1)
+    {
+        bool has_sequence_header = false;
+
+        out.push_back(0x12);
+        out.push_back(0x00);
+        for (i = 0; i < frame.units.size(); i++)
+        {
+            has_sequence_header |= ((frame.units[i][0] >> 3) & 0xF) == 1;
+        }
+        if (frame.key_frame && !has_sequence_header)
+        {
+            append(out, c.parameter_sets);
+        }
+    }
+    for (i = 0; i < frame.units.size(); i++)
+    {
+        append(out, frame.units[i]);
+    }
+    return out;
+}
+
+/**
+  * Converts media time units to microseconds, rounding toward zero.
+  */
+static int64_t
+to_usec(int64_t ticks, int64_t timescale)
+{
+    int64_t q = ticks / timescale;
+
+    return q * 1000000 + (ticks - q * timescale) * 1000000 / timescale;
+}
+
+static vector<uint8_t>
+sample_entry(uint32_t pixfmt, uint32_t width, uint32_t height,
+        const codec_config_t &c)
+{
+    vector<uint8_t> entry(6, 0);
+    const char *type;
+
+    switch (pixfmt)
+    {
+        case V4L2_PIX_FMT_H264:
+            type = "avc1";
+            break;
+        case V4L2_PIX_FMT_H265:
+            type = "hvc1";
+            break;
+        case V4L2_PIX_FMT_AV1:
+            type = "av01";
+            break;
+        case V4L2_PIX_FMT_VP8:
+            type = "vp08";
+            break;
+        default:
+            type = "vp09";
+            break;
+    }
+
+    put_u16(entry, 1);
+    entry.resize(entry.size() + 16, 0);
+    put_u16(entry, width);
+    put_u16(entry, height);
+    put_u32(entry, 0x480000);
+    put_u32(entry, 0x480000);
+    put_u32(entry, 0);
+    put_u16(entry, 1);
+    entry.resize(entry.size() + 32, 0);
+    put_u16(entry, 0x18);
+    put_u16(entry, 0xFFFF);
+    if (c.type)
+    {
+        append(entry, box(c.type, c.config));
+    }
+    return box(type, entry);
+}
+
+static vector<uint8_t>
+tkhd(uint32_t track_id, uint32_t version)
+{
+    vector<uint8_t> payload;
+
+    if (version == 0)
+    {
+        put_u32(payload, 0);
+        put_u32(payload, 0);
+        put_u32(payload, track_id);
+        put_u32(payload, 0);
+        payload.resize(payload.size() + 60, 0);
+    }
+    else
+    {
+        put_u64(payload, 0);
+        put_u64(payload, 0);
+        put_u32(payload, track_id);
+        put_u32(payload, 0);
+        payload.resize(payload.size() + 64, 0);
+    }
+    return full_box("tkhd", version, 3, payload);
+}
+
+static vector<uint8_t>
+hdlr(const char *handler_type)
+{
+    vector<uint8_t> payload;
+
+    put_u32(payload, 0);
+    append(payload, handler_type, 4);
+    payload.resize(payload.size() + 13, 0);
+    return full_box("hdlr", 0, 0, payload);
+}
+
+static vector<uint8_t>
+mdhd(uint32_t timescale, uint32_t version)
+{
+    vector<uint8_t> payload;
+
+    put_be(payload, 0, version ? 8 : 4);
+    put_be(payload, 0, version ? 8 : 4);
+    put_u32(payload, timescale);
+    put_be(payload, 0, version ? 8 : 4);
+    put_u32(payload, 0);
+    return full_box("mdhd", version, 0, payload);
+}
+
+static vector<uint8_t>
+empty_table(const char *type, uint32_t fields)
+{
+    return full_box(type, 0, 0, vector<uint8_t>(4 * fields, 0));
+}
+
+/**
+  * Audio track with empty sample tables, which the reader must skip.
+  */
+static vector<uint8_t>
+audio_trak(uint32_t track_id)
+{
+    vector<uint8_t> stbl, mdia;
+
+    append(stbl, empty_table("stsd", 1));
+    append(stbl, empty_table("stsz", 2));
+    append(stbl, empty_table("stsc", 1));
+    append(stbl, empty_table("stco", 1));
+    append(stbl, empty_table("stts", 1));
+    append(mdia, mdhd(48000, 0));
+    append(mdia, hdlr("soun"));
+    append(mdia, box("minf", box("stbl", stbl)));
+
+    vector<uint8_t> trak = tkhd(track_id, 0);
+    append(trak, box("mdia", mdia));
+    return box("trak", trak);
+}
+
+static vector<uint8_t>
+video_trak(uint32_t track_id, uint32_t pixfmt, uint32_t width, uint32_t height,
+        const codec_config_t &c, const vector<uint8_t> &tables,
+        uint32_t timescale, const vector<uint8_t> &elst, uint32_t mdhd_version,
+        uint32_t tkhd_version)
+{
+    vector<uint8_t> stsd, stbl, minf, mdia, trak;
+
+    put_u32(stsd, 1);
+    append(stsd, sample_entry(pixfmt, width, height, c));
+    stbl = full_box("stsd", 0, 0, stsd);
+    append(stbl, tables);
+    minf = box("dinf", vector<uint8_t>());
+    append(minf, box("stbl", stbl));
+    mdia = mdhd(timescale, mdhd_version);
+    append(mdia, hdlr("vide"));
+    append(mdia, box("minf", minf));
+
+    trak = tkhd(track_id, tkhd_version);
+    if (!elst.empty())
+    {
+        append(trak, box("edts", elst));
+    }
+    append(trak, box("mdia", mdia));
+    return box("trak", trak);
+}
+
+/**
+  * Builds the sample tables of a progressive MP4, with the chunks starting
+  * at @a chunk_offsets.
+  */
+static vector<uint8_t>
+build_sample_tables(const scenario_t &s, const vector<vector<uint8_t> > &samples,
+        const vector<frame_t> &frames, const vector<vector<uint32_t> > &chunks,
+        const vector<uint64_t> &chunk_offsets, const vector<int32_t> &cts,
+        uint32_t duration)
+{
+    vector<uint8_t> tables, payload;
+    uint32_t n = samples.size();
+    bool same_size = true;
+    uint32_t num_keys = 0;
+    size_t i;
+
+    for (i = 1; i < n; i++)
+    {
+        same_size &= samples[i].size() == samples[0].size();
+    }
+
+    if (s.flags & SCENARIO_STZ2)
+    {
+        put_u32(payload, 16);
+        put_u32(payload, n);
+        for (i = 0; i < n; i++)
+        {
+            put_u16(payload, samples[i].size());
+        }
+        append(tables, full_box("stz2", 0, 0, payload));
+    }
+    else
+    {
+        put_u32(payload, same_size ? samples[0].size() : 0);
+        put_u32(payload, n);
+        for (i = 0; i < n && !same_size; i++)
+        {
+            put_u32(payload, samples[i].size());
+        }
+        append(tables, full_box("stsz", 0, 0, payload));
+    }
+
+    vector<pair<uint32_t, uint32_t> > runs;
+    for (i = 0; i < chunks.size(); i++)
+    {
+        if (runs.empty() || runs.back().second != chunks[i].size())
+        {
+            runs.push_back(make_pair(i + 1, chunks[i].size()));
+        }
+    }
+    payload.clear();
+    put_u32(payload, runs.size());
+    for (i = 0; i < runs.size(); i++)
+    {
+        put_u32(payload, runs[i].first);
+        put_u32(payload, runs[i].second);
+        put_u32(payload, 1);
+    }
+    append(tables, full_box("stsc", 0, 0, payload));
+
+    payload.clear();
+    put_u32(payload, chunk_offsets.size());
+    for (i = 0; i < chunk_offsets.size(); i++)
+    {
+        put_be(payload, chunk_offsets[i], (s.flags & SCENARIO_CO64) ? 8 : 4);
+    }
+    append(tables, full_box((s.flags & SCENARIO_CO64) ? "co64" : "stco", 0, 0,
+                payload));
+
+    /* The last sample has its own duration. */
+    payload.clear();
+    put_u32(payload, 2);
+    put_u32(payload, n - 1);
+    put_u32(payload, duration);
+    put_u32(payload, 1);
+    put_u32(payload, 1234);
+    append(tables, full_box("stts", 0, 0, payload));
+
+    vector<pair<uint32_t, int32_t> > cts_runs;
+    bool any_cts = false;
+    for (i = 0; i < n; i++)
+    {
+        any_cts |= cts[i] != 0;
+        if (!cts_runs.empty() && cts_runs.back().second == cts[i])
+        {
+            cts_runs.back().first++;
+        }
+        else
+        {
+            cts_runs.push_back(make_pair(1, cts[i]));
+        }
+    }
+    if (any_cts)
+    {
+        payload.clear();
+        put_u32(payload, cts_runs.size());
+        for (i = 0; i < cts_runs.size(); i++)
+        {
+            put_u32(payload, cts_runs[i].first);
+            put_u32(payload, cts_runs[i].second);
+        }
+        append(tables, full_box("ctts", (s.flags & SCENARIO_CTTS_V1) ? 1 : 0,
+                    0, payload));
+    }
+
+    if (!(s.flags & SCENARIO_NO_STSS))
+    {
+        payload.clear();
+        for (i = 0; i < n; i++)
+        {
+            num_keys += frames[i].key_frame;
+        }
+        put_u32(payload, num_keys);
+        for (i = 0; i < n; i++)
+        {
+            if (frames[i].key_frame)
+            {
+                put_u32(payload, i + 1);
+            }
+        }
+        append(tables, full_box("stss", 0, 0, payload));
+    }
+    return tables;
+}
+
+/**
+  * Progressive MP4: one moov with the sample tables of all the samples,
+  * stored in chunks of 1 to 5 samples in a single mdat.
+  */
+static void
+build_progressive(const scenario_t &s, vector<uint8_t> &file,
+        vector<expected_sample_t> &expected)
+{
+    static const uint32_t chunk_sizes[] = { 1, 3, 5, 5 };
+    const uint32_t n = 40;
+    const uint32_t timescale = 90000;
+    const uint32_t duration = 3000;
+    bool audio = !(s.flags & SCENARIO_NO_AUDIO);
+    bool edit_list = !(s.flags & SCENARIO_NO_EDIT_LIST);
+    uint32_t bframes = (s.flags & SCENARIO_NO_STSS) ? 0 : 2;
+    int32_t shift = duration * bframes;
+    codec_config_t c = make_codec_config(s.pixfmt, s.length_size);
+    vector<frame_t> frames = make_frames(s.pixfmt, n, 12, bframes, true,
+            s.length_size == 1 ? 200 : 1 << 30);
+    vector<vector<uint8_t> > samples;
+    vector<vector<uint32_t> > chunks;
+    vector<vector<uint8_t> > audio_chunks;
+    vector<uint64_t> offsets;
+    vector<int32_t> cts;
+    vector<uint8_t> ftyp, elst, moov, mdat_body;
+    uint32_t mdat_header = (s.flags & SCENARIO_LARGE_MDAT) ? 16 : 8;
+    uint64_t mdat_offset;
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        samples.push_back(sample_bytes(s.pixfmt, frames[i], s.length_size));
+        cts.push_back((int32_t) (frames[i].display * duration) -
+                (int32_t) (i * duration) + (edit_list ? shift : 0));
+    }
+    for (i = 0; i < n; )
+    {
+        uint32_t size = choose(chunk_sizes, 4);
+        vector<uint32_t> chunk;
+        vector<uint8_t> audio_chunk;
+
+        for (uint32_t j = i; j < min(n, i + size); j++)
+        {
+            chunk.push_back(j);
+        }
+        chunks.push_back(chunk);
+        put_random(audio_chunk, 17);
+        audio_chunks.push_back(audio_chunk);
+        i += size;
+    }
+
+    ftyp = make_bytes("isom");
+    put_u32(ftyp, 512);
+    append(ftyp, make_bytes("isomiso2mp41"));
+    ftyp = box("ftyp", ftyp);
+
+    if (edit_list)
+    {
+        vector<uint8_t> payload;
+
+        put_u32(payload, 1);
+        put_u64(payload, (uint64_t) n * duration);
+        put_u64(payload, shift);
+        put_u32(payload, 0x10000);
+        elst = full_box("elst", 1, 0, payload);
+    }
+
+    /* The size of the moov does not depend on the chunk offsets. */
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        mdat_offset = ftyp.size() + mdat_header;
+        if ((s.flags & SCENARIO_MOOV_FIRST) && pass == 1)
+        {
+            mdat_offset += moov.size();
+        }
+        mdat_body.clear();
+        offsets.clear();
+        for (i = 0; i < chunks.size(); i++)
+        {
+            if (audio)
+            {
+                append(mdat_body, audio_chunks[i]);
+            }
+            offsets.push_back(mdat_offset + mdat_body.size());
+            for (size_t j = 0; j < chunks[i].size(); j++)
+            {
+                append(mdat_body, samples[chunks[i][j]]);
+            }
+        }
+
+        moov = full_box("mvhd", 0, 0, vector<uint8_t>(96, 0));
+        if (audio)
+        {
+            append(moov, audio_trak(1));
+        }
+        append(moov, video_trak(2, s.pixfmt, 1280, 720, c,
+                    build_sample_tables(s, samples, frames, chunks, offsets,
+                        cts, duration),
+                    timescale, elst, (s.flags & SCENARIO_CO64) ? 1 : 0,
+                    (s.flags & SCENARIO_STZ2) ? 1 : 0));
+        moov = box("moov", moov);
+    }
+
+    vector<uint8_t> mdat;
+    if (s.flags & SCENARIO_LARGE_MDAT)
+    {
+        put_u32(mdat, 1);
+        append(mdat, "mdat", 4);
+        put_u64(mdat, 16 + mdat_body.size());
+    }
+    else
+    {
+        put_u32(mdat, 8 + mdat_body.size());
+        append(mdat, "mdat", 4);
+    }
+    append(mdat, mdat_body);
+
+    file = ftyp;
+    if (s.flags & SCENARIO_MOOV_FIRST)
+    {
+        append(file, moov);
+        append(file, mdat);
+    }
+    else
+    {
+        append(file, mdat);
+        append(file, moov);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        expected_sample_t e;
+
+        e.data = expected_bytes(s.pixfmt, frames[i], c);
+        e.key_frame = frames[i].key_frame || (s.flags & SCENARIO_NO_STSS);
+        e.pts = to_usec((int64_t) i * duration + cts[i] -
+                (edit_list ? shift : 0), timescale);
+        expected.push_back(e);
+    }
+}
+
+static vector<uint8_t>
+build_traf_video(const scenario_t &s, const vector<vector<uint8_t> > &samples,
+        const vector<frame_t> &frames, uint32_t first, uint32_t last,
+        const vector<int32_t> &cts, int32_t data_offset, uint64_t base,
+        uint64_t dts, uint32_t duration)
+{
+    bool sample_flags = s.flags & SCENARIO_SAMPLE_FLAGS;
+    uint32_t flags = TRUN_DATA_OFFSET | TRUN_SAMPLE_SIZE | TRUN_SAMPLE_CTO |
+        (sample_flags ? TRUN_SAMPLE_FLAGS : TRUN_FIRST_SAMPLE_FLAGS);
+    uint32_t version = 0;
+    vector<uint8_t> tfhd, tfdt, trun, traf;
+    uint32_t k;
+
+    if (s.flags & SCENARIO_SIZE_IN_TREX)
+    {
+        flags &= ~TRUN_SAMPLE_SIZE;
+    }
+    for (k = first; k < last; k++)
+    {
+        version |= cts[k - first] < 0;
+    }
+
+    put_u32(trun, last - first);
+    put_u32(trun, data_offset);
+    if (!sample_flags)
+    {
+        put_u32(trun, SAMPLE_FLAGS_SYNC);
+    }
+    for (k = first; k < last; k++)
+    {
+        if (!(s.flags & SCENARIO_SIZE_IN_TREX))
+        {
+            put_u32(trun, samples[k].size());
+        }
+        if (sample_flags)
+        {
+            put_u32(trun, frames[k].key_frame ? 0 : SAMPLE_FLAGS_NON_SYNC);
+        }
+        put_u32(trun, cts[k - first]);
+    }
+
+    put_u32(tfhd, 1);
+    if (s.flags & SCENARIO_BASE_OFFSET)
+    {
+        put_u64(tfhd, base);
+        put_u32(tfhd, duration);
+        tfhd = full_box("tfhd", 0,
+                TFHD_BASE_DATA_OFFSET | TFHD_DEFAULT_SAMPLE_DURATION, tfhd);
+    }
+    else if (sample_flags)
+    {
+        put_u32(tfhd, SAMPLE_FLAGS_NON_SYNC);
+        tfhd = full_box("tfhd", 0,
+                TFHD_DEFAULT_BASE_IS_MOOF | TFHD_DEFAULT_SAMPLE_FLAGS, tfhd);
+    }
+    else
+    {
+        tfhd = full_box("tfhd", 0, TFHD_DEFAULT_BASE_IS_MOOF, tfhd);
+    }
+    put_u64(tfdt, dts);
+
+    traf = tfhd;
+    append(traf, full_box("tfdt", 1, 0, tfdt));
+    append(traf, full_box("trun", version, flags, trun));
+    return box("traf", traf);
+}
+
+static vector<uint8_t>
+build_traf_audio(int32_t data_offset)
+{
+    vector<uint8_t> tfhd, trun, traf;
+
+    put_u32(tfhd, 2);
+    put_u32(tfhd, 1024);
+    put_u32(tfhd, 20);
+    put_u32(trun, 2);
+    put_u32(trun, data_offset);
+    traf = full_box("tfhd", 0, TFHD_DEFAULT_BASE_IS_MOOF |
+            TFHD_DEFAULT_SAMPLE_DURATION | TFHD_DEFAULT_SAMPLE_SIZE, tfhd);
+    append(traf, full_box("trun", 0, TRUN_DATA_OFFSET, trun));
+    return box("traf", traf);
+}
+
+/**
+  * Fragmented MP4: an empty moov and one moof and mdat per GOP, with the
+  * audio samples first in each mdat.
+  */
+static void
+build_fragmented(const scenario_t &s, vector<uint8_t> &file,
+        vector<expected_sample_t> &expected)
+{
+    const uint32_t n = 60;
+    const uint32_t timescale = 30000;
+    const uint32_t duration = 1001;
+    const uint32_t audio_size = 40;
+    bool audio = !(s.flags & SCENARIO_NO_AUDIO);
+    codec_config_t c = make_codec_config(s.pixfmt, s.length_size);
+    vector<frame_t> frames = make_frames(s.pixfmt, n, 15, 2, true, 1 << 30);
+    vector<vector<uint8_t> > samples;
+    vector<uint8_t> tables, mvex, trex, moov;
+    uint32_t trex_size = 0;
+    uint32_t sequence = 1;
+    uint64_t dts = 0;
+    uint32_t i, j, k;
+
+    for (i = 0; i < n; i++)
+    {
+        samples.push_back(sample_bytes(s.pixfmt, frames[i], s.length_size));
+    }
+    if (s.flags & SCENARIO_SIZE_IN_TREX)
+    {
+        /* VP8 and VP9 frames can be padded to a constant size. */
+        for (i = 0; i < n; i++)
+        {
+            trex_size = max(trex_size, (uint32_t) samples[i].size());
+        }
+        for (i = 0; i < n; i++)
+        {
+            samples[i].resize(trex_size, 0);
+        }
+    }
+
+    append(tables, empty_table("stsz", 2));
+    append(tables, empty_table("stsc", 1));
+    append(tables, empty_table("stco", 1));
+    append(tables, empty_table("stts", 1));
+
+    put_u32(trex, 2);
+    put_u32(trex, 1);
+    put_u32(trex, 0);
+    put_u32(trex, 0);
+    put_u32(trex, 0);
+    mvex = full_box("trex", 0, 0, trex);
+    trex.clear();
+    put_u32(trex, 1);
+    put_u32(trex, 1);
+    put_u32(trex, duration);
+    put_u32(trex, trex_size);
+    put_u32(trex, SAMPLE_FLAGS_NON_SYNC);
+    append(mvex, full_box("trex", 0, 0, trex));
+
+    moov = full_box("mvhd", 0, 0, vector<uint8_t>(96, 0));
+    append(moov, video_trak(1, s.pixfmt, 640, 480, c, tables, timescale,
+                vector<uint8_t>(), 0, 0));
+    if (audio)
+    {
+        append(moov, audio_trak(2));
+    }
+    append(moov, box("mvex", mvex));
+
+    file = make_bytes("iso6");
+    put_u32(file, 0);
+    append(file, make_bytes("iso6mp41"));
+    file = box("ftyp", file);
+    append(file, box("moov", moov));
+
+    for (i = 0; i < n; i = j)
+    {
+        vector<int32_t> cts;
+        vector<uint8_t> mdat, mfhd, moof;
+        uint64_t moof_start = file.size();
+        uint64_t base = 0;
+        uint32_t moof_size;
+
+        for (j = i + 1; j < n && !frames[j].key_frame; j++)
+        {
+        }
+        for (k = i; k < j; k++)
+        {
+            cts.push_back((int32_t) (frames[k].display * duration) -
+                    (int32_t) (k * duration));
+        }
+        if (audio)
+        {
+            mdat.resize(audio_size, 0);
+        }
+        for (k = i; k < j; k++)
+        {
+            append(mdat, samples[k]);
+        }
+        put_u32(mfhd, sequence);
+
+        /* The size of the moof does not depend on the data offsets. */
+        for (uint32_t pass = 0; pass < 2; pass++)
+        {
+            int32_t video_offset = 0;
+
+            moof_size = moof.size();
+            if (s.flags & SCENARIO_BASE_OFFSET)
+            {
+                base = moof_start + moof_size + 8 + (audio ? audio_size : 0);
+            }
+            else
+            {
+                video_offset = moof_size + 8 + (audio ? audio_size : 0);
+            }
+            moof = full_box("mfhd", 0, 0, mfhd);
+            if (audio)
+            {
+                append(moof, build_traf_audio(moof_size + 8));
+            }
+            append(moof, build_traf_video(s, samples, frames, i, j, cts,
+                        video_offset, base, dts, duration));
+            moof = box("moof", moof);
+        }
+        append(file, moof);
+        append(file, box("mdat", mdat));
+
+        for (k = i; k < j; k++)
+        {
+            expected_sample_t e;
+
+            e.data = is_nal_codec(s.pixfmt) || s.pixfmt == V4L2_PIX_FMT_AV1 ?
+                expected_bytes(s.pixfmt, frames[k], c) : samples[k];
+            e.key_frame = frames[k].key_frame;
+            e.pts = to_usec((int64_t) (dts + (k - i) * duration) + cts[k - i],
+                    timescale);
+            expected.push_back(e);
+        }
+        dts += (j - i) * duration;
+        sequence++;
+    }
+}
+
+static void
+put_ebml_id(vector<uint8_t> &out, uint32_t id)
+{
+    uint32_t size = id >> 24 ? 4 : id >> 16 ? 3 : id >> 8 ? 2 : 1;
+
+    put_be(out, id, size);
+}
+
+/**
+  * EBML element size, on @a width bytes or the fewest possible.
+  */
+static void
+put_ebml_size(vector<uint8_t> &out, uint64_t size, uint32_t width)
+{
+    if (!width)
+    {
+        for (width = 1; size >= (1ULL << (7 * width)) - 1; width++)
+        {
+        }
+    }
+    put_be(out, (1ULL << (7 * width)) | size, width);
+}
+
+static vector<uint8_t>
+ebml_element(uint32_t id, const vector<uint8_t> &payload, uint32_t width = 0)
+{
+    vector<uint8_t> out;
+
+    put_ebml_id(out, id);
+    put_ebml_size(out, payload.size(), width);
+    append(out, payload);
+    return out;
+}
+
+static vector<uint8_t>
+ebml_uint(uint32_t id, uint64_t value)
+{
+    vector<uint8_t> payload;
+    uint32_t size = 1;
+
+    while (size < 8 && (value >> (8 * size)))
+    {
+        size++;
+    }
+    put_be(payload, value, size);
+    return ebml_element(id, payload);
+}
+
+static vector<uint8_t>
+block_header(uint8_t track, int32_t timecode, uint8_t flags)
+{
+    vector<uint8_t> out;
+
+    out.push_back(0x80 | track);
+    put_u16(out, (uint16_t) timecode);
+    out.push_back(flags);
+    return out;
+}
+
+/**
+  * Matroska: an Opus track and the video track, with one cluster of
+  * SimpleBlocks and BlockGroups per GOP.
+  */
+static void
+build_matroska(const scenario_t &s, vector<uint8_t> &file,
+        vector<expected_sample_t> &expected)
+{
+    static const uint8_t seek_id[] = { 0x53, 0xab, 0x84, 0x15, 0x49, 0xa9, 0x66 };
+    static const uint8_t unknown_size[] =
+    {
+        0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+    };
+    const uint32_t n = 50;
+    const uint32_t gop = 10;
+    uint32_t scale = s.timecode_scale;
+    codec_config_t c = make_codec_config(s.pixfmt, s.length_size);
+    vector<frame_t> frames = make_frames(s.pixfmt, n, gop, 2,
+            !(s.flags & SCENARIO_NO_SEQ_ON_KEY), 1 << 30);
+    vector<uint8_t> header, info, audio_track, video_track, video, segment;
+    vector<uint8_t> payload;
+    const char *codec_id;
+    const char *doc_type = "webm";
+    uint64_t timecode = 0;
+    uint32_t i, j, k;
+
+    switch (s.pixfmt)
+    {
+        case V4L2_PIX_FMT_H264:
+            codec_id = "V_MPEG4/ISO/AVC";
+            doc_type = "matroska";
+            break;
+        case V4L2_PIX_FMT_H265:
+            codec_id = "V_MPEGH/ISO/HEVC";
+            doc_type = "matroska";
+            break;
+        case V4L2_PIX_FMT_AV1:
+            codec_id = "V_AV1";
+            break;
+        case V4L2_PIX_FMT_VP8:
+            codec_id = "V_VP8";
+            break;
+        default:
+            codec_id = "V_VP9";
+            break;
+    }
+
+    header = ebml_uint(0x4286, 1);
+    append(header, ebml_element(0x4282, make_bytes(doc_type)));
+    file = ebml_element(0x1A45DFA3, header);
+
+    info = ebml_uint(0x2AD7B1, scale);
+    put_u64(payload, 0x408F400000000000ULL);    /* 1000.0 */
+    append(info, ebml_element(0x4489, payload));
+
+    audio_track = ebml_uint(0xD7, 1);
+    append(audio_track, ebml_uint(0x83, 2));
+    append(audio_track, ebml_element(0x86, make_bytes("A_OPUS")));
+    payload = make_bytes("OpusHead");
+    payload.resize(payload.size() + 11, 0);
+    append(audio_track, ebml_element(0x63A2, payload));
+
+    /* A NUL terminated CodecID, and a TrackEntry with a wide size. */
+    video_track = ebml_uint(0xD7, 2);
+    append(video_track, ebml_uint(0x73C5, 12345));
+    append(video_track, ebml_uint(0x83, 1));
+    payload = make_bytes(codec_id);
+    payload.push_back(0);
+    append(video_track, ebml_element(0x86, payload));
+    if (c.type)
+    {
+        append(video_track, ebml_element(0x63A2, c.config));
+    }
+    video = ebml_uint(0xB0, 1920);
+    append(video, ebml_uint(0xBA, 1080));
+    append(video_track, ebml_element(0xE0, video));
+
+    payload = ebml_element(0xAE, audio_track);
+    append(payload, ebml_element(0xAE, video_track, 8));
+
+    segment = ebml_element(0x114D9B74, ebml_element(0x4DBB,
+                vector<uint8_t>(seek_id, seek_id + sizeof(seek_id))));
+    append(segment, ebml_element(0xEC, vector<uint8_t>(20, 0)));
+    append(segment, ebml_element(0x1549A966, info));
+    append(segment, ebml_element(0x1654AE6B, payload));
+
+    for (i = 0; i < n; i = j)
+    {
+        vector<uint8_t> cluster = ebml_uint(0xE7, timecode);
+
+        j = min(n, i + gop);
+        append(cluster, ebml_element(0xBF, vector<uint8_t>(4, 0)));
+        for (k = i; k < j; k++)
+        {
+            int32_t relative = (int64_t) frames[k].display * MATROSKA_FRAME_MS *
+                1000000 / scale - timecode;
+            vector<uint8_t> block;
+            expected_sample_t e;
+
+            if (next_rand() % 10 < 3)
+            {
+                vector<uint8_t> group;
+
+                block = block_header(2, relative, 0);
+                append(block, sample_bytes(s.pixfmt, frames[k], s.length_size));
+                group = ebml_element(0xA1, block);
+                if (!frames[k].key_frame)
+                {
+                    append(group, ebml_uint(0xFB, 1));
+                }
+                append(group, ebml_uint(0x9B, MATROSKA_FRAME_MS));
+                append(cluster, ebml_element(0xA0, group));
+            }
+            else
+            {
+                block = block_header(2, relative,
+                        frames[k].key_frame ? 0x80 : 0);
+                append(block, sample_bytes(s.pixfmt, frames[k], s.length_size));
+                append(cluster, ebml_element(0xA3, block));
+            }
+
+            e.data = expected_bytes(s.pixfmt, frames[k], c);
+            e.key_frame = frames[k].key_frame;
+            e.pts = (int64_t) (timecode + relative) * scale / 1000;
+            expected.push_back(e);
+
+            if (next_rand() & 1)
+            {
+                block = block_header(1, relative, 0x80);
+                block.resize(block.size() + 30, 0);
+                append(cluster, ebml_element(0xA3, block));
+            }
+            if (k == i + 1)
+            {
+                /* Xiph laced video block, which the reader skips. */
+                block = block_header(2, relative, 0x02);
+                block.push_back(0x01);
+                block.push_back(0x05);
+                block.resize(block.size() + 10, 0);
+                append(cluster, ebml_element(0xA3, block));
+            }
+        }
+
+        if (s.flags & SCENARIO_UNKNOWN_CLUSTER)
+        {
+            put_ebml_id(segment, 0x1F43B675);
+            append(segment, unknown_size, sizeof(unknown_size));
+            append(segment, cluster);
+        }
+        else
+        {
+            append(segment, ebml_element(0x1F43B675, cluster));
+        }
+        timecode = (uint64_t) j * MATROSKA_FRAME_MS * 1000000 / scale;
+    }
+    append(segment, ebml_element(0x1C53BB6B,
+                ebml_element(0xBB, ebml_uint(0xB3, 0))));
+
+    put_ebml_id(file, 0x18538067);
+    if (s.flags & SCENARIO_UNKNOWN_SEGMENT)
+    {
+        append(file, unknown_size, sizeof(unknown_size));
+    }
+    else
+    {
+        put_ebml_size(file, segment.size(), 8);
+    }
+    append(file, segment);
+}
+
+/**
+  * Reads back every sample and compares it with the reference extraction,
+  * then checks seeking and the rejection of a buffer too small.
+  */
+static int
+check_reader(NvContainerReader *reader, const vector<expected_sample_t> &expected)
+{
+    const NvContainerReader::NvContainerSample *sample;
+    NvBuffer buffer(BUFFER_SIZE, 0);
+    int64_t first_key = -1;
+    int64_t second_key = -1;
+    size_t i;
+
+    CHECK(buffer.allocateMemory() == 0, "Could not allocate the buffer");
+    CHECK(reader->getNumSamples() == expected.size(), "Reader indexed " <<
+            reader->getNumSamples() << " samples, expected " << expected.size());
+
+    for (i = 0; i < expected.size(); i++)
+    {
+        const expected_sample_t &e = expected[i];
+
+        CHECK(reader->readNextSample(&buffer, &sample) == 0 && sample,
+                "Could not read sample " << i);
+        CHECK(buffer.planes[0].bytesused == e.data.size() &&
+                !memcmp(buffer.planes[0].data, e.data.data(), e.data.size()),
+                "Sample " << i << ": " << buffer.planes[0].bytesused <<
+                " bytes differ from the " << e.data.size() << " expected");
+        CHECK(sample->pts == e.pts, "Sample " << i << ": pts " <<
+                sample->pts << ", expected " << e.pts);
+        CHECK(sample->key_frame == e.key_frame, "Sample " << i <<
+                ": key frame " << sample->key_frame << ", expected " <<
+                e.key_frame);
+        if (e.key_frame)
+        {
+            if (first_key < 0)
+            {
+                first_key = i;
+            }
+            else if (second_key < 0)
+            {
+                second_key = i;
+            }
+        }
+    }
+
+    CHECK(reader->readNextSample(&buffer, &sample) == 0 && !sample &&
+            buffer.planes[0].bytesused == 0 && reader->getPosition() == 0,
+            "End of stream not reported");
+
+    if (second_key > 0 && second_key + 1 < (int64_t) expected.size() &&
+        !expected[second_key + 1].key_frame)
+    {
+        CHECK(reader->seekToKeyFrame(second_key + 1) == second_key &&
+                reader->getPosition() == (uint64_t) second_key,
+                "seekToKeyFrame did not go back to sample " << second_key);
+        CHECK(reader->readNextSample(&buffer, &sample) == 0 && sample &&
+                buffer.planes[0].bytesused == expected[second_key].data.size(),
+                "Could not read the key frame after seeking");
+        CHECK(reader->seekToKeyFrame(second_key - 1) == first_key,
+                "seekToKeyFrame did not go back to sample " << first_key);
+    }
+    CHECK(reader->seek(expected.size()) == -1, "Seek past the end accepted");
+
+    reader->rewind();
+    buffer.planes[0].length = 4;
+    CHECK(reader->readNextSample(&buffer, &sample) == -1 &&
+            reader->getPosition() == 0 && buffer.planes[0].bytesused == 0,
+            "Buffer too small not rejected");
+    buffer.planes[0].length = BUFFER_SIZE;
+    return 0;
+}
+
+/**
+  * Builds the file of a scenario and reads it back.
+  */
+static int
+run_scenario(const scenario_t &s, bool keep_file)
+{
+    vector<expected_sample_t> expected;
+    vector<uint8_t> file;
+    NvContainerReader *reader;
+    uint64_t num_bytes = 0;
+    uint32_t num_keys = 0;
+    int ret;
+
+    switch (s.container)
+    {
+        case CONTAINER_MP4:
+            build_progressive(s, file, expected);
+            break;
+        case CONTAINER_FRAGMENTED:
+            build_fragmented(s, file, expected);
+            break;
+        default:
+            build_matroska(s, file, expected);
+            break;
+    }
+
+    ofstream out(CONTAINER_PATH, ios::binary);
+    out.write((const char *) file.data(), file.size());
+    out.close();
+    CHECK(out, "Could not write " << CONTAINER_PATH);
+
+    reader = NvContainerReader::createContainerReader(CONTAINER_PATH);
+    if (!keep_file)
+    {
+        unlink(CONTAINER_PATH);
+    }
+    CHECK(reader, "Could not open the file");
+
+    if (reader->getPixelFormat() != s.pixfmt ||
+        reader->isMatroska() != (s.container == CONTAINER_MATROSKA))
+    {
+        cerr << "Wrong pixel format or container" << endl;
+        ret = -1;
+    }
+    else
+    {
+        ret = check_reader(reader, expected);
+    }
+    delete reader;
+    if (ret < 0)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        num_bytes += expected[i].data.size();
+        num_keys += expected[i].key_frame;
+    }
+    cout << s.name << ": " << expected.size() << " samples, " << num_keys <<
+        " key frames, " << num_bytes << " bytes: OK" << endl;
+    return 0;
+}
+
+static void
+add_scenario(vector<scenario_t> &scenarios, const char *name,
+        uint32_t container, uint32_t pixfmt, uint32_t length_size,
+        uint32_t flags, uint32_t timecode_scale = 1000000)
+{
+    scenario_t s;
+
+    s.name = name;
+    s.container = container;
+    s.pixfmt = pixfmt;
+    s.length_size = length_size;
+    s.flags = flags;
+    s.timecode_scale = timecode_scale;
+    scenarios.push_back(s);
+}
+
+static vector<scenario_t>
+build_scenarios()
+{
+    vector<scenario_t> scenarios;
+
+    add_scenario(scenarios, "mp4_h264", CONTAINER_MP4,
+            V4L2_PIX_FMT_H264, 4, 0);
+    add_scenario(scenarios, "mp4_h264_moov_first_len2", CONTAINER_MP4,
+            V4L2_PIX_FMT_H264, 2, SCENARIO_MOOV_FIRST);
+    add_scenario(scenarios, "mp4_h264_len1_stz2_co64", CONTAINER_MP4,
+            V4L2_PIX_FMT_H264, 1, SCENARIO_STZ2 | SCENARIO_CO64);
+    add_scenario(scenarios, "mp4_h265_signed_ctts", CONTAINER_MP4,
+            V4L2_PIX_FMT_H265, 4, SCENARIO_NO_EDIT_LIST | SCENARIO_CTTS_V1 |
+            SCENARIO_LARGE_MDAT);
+    add_scenario(scenarios, "mp4_h265_no_audio", CONTAINER_MP4,
+            V4L2_PIX_FMT_H265, 4, SCENARIO_NO_AUDIO | SCENARIO_MOOV_FIRST);
+    add_scenario(scenarios, "mp4_av1", CONTAINER_MP4,
+            V4L2_PIX_FMT_AV1, 4, 0);
+    add_scenario(scenarios, "mp4_vp9_no_stss", CONTAINER_MP4,
+            V4L2_PIX_FMT_VP9, 4, SCENARIO_NO_STSS);
+
+    add_scenario(scenarios, "fmp4_h264", CONTAINER_FRAGMENTED,
+            V4L2_PIX_FMT_H264, 4, 0);
+    add_scenario(scenarios, "fmp4_h265_base_offset_len2", CONTAINER_FRAGMENTED,
+            V4L2_PIX_FMT_H265, 2, SCENARIO_BASE_OFFSET);
+    add_scenario(scenarios, "fmp4_h264_sample_flags_len2", CONTAINER_FRAGMENTED,
+            V4L2_PIX_FMT_H264, 2, SCENARIO_SAMPLE_FLAGS | SCENARIO_NO_AUDIO);
+    add_scenario(scenarios, "fmp4_vp9_trex_size", CONTAINER_FRAGMENTED,
+            V4L2_PIX_FMT_VP9, 4, SCENARIO_SIZE_IN_TREX);
+    add_scenario(scenarios, "fmp4_av1", CONTAINER_FRAGMENTED,
+            V4L2_PIX_FMT_AV1, 4, 0);
+
+    add_scenario(scenarios, "mkv_h264", CONTAINER_MATROSKA,
+            V4L2_PIX_FMT_H264, 4, 0);
+    add_scenario(scenarios, "mkv_h265_unknown_sizes", CONTAINER_MATROSKA,
+            V4L2_PIX_FMT_H265, 4, SCENARIO_UNKNOWN_SEGMENT |
+            SCENARIO_UNKNOWN_CLUSTER);
+    add_scenario(scenarios, "webm_av1_no_seq_scale", CONTAINER_MATROSKA,
+            V4L2_PIX_FMT_AV1, 4, SCENARIO_NO_SEQ_ON_KEY, 100000);
+    add_scenario(scenarios, "webm_vp9_unknown_cluster", CONTAINER_MATROSKA,
+            V4L2_PIX_FMT_VP9, 4, SCENARIO_UNKNOWN_CLUSTER);
+    add_scenario(scenarios, "webm_vp8", CONTAINER_MATROSKA,
+            V4L2_PIX_FMT_VP8, 4, 0);
+    add_scenario(scenarios, "mkv_h264_len2_unknown_segment", CONTAINER_MATROSKA,
+            V4L2_PIX_FMT_H264, 2, SCENARIO_UNKNOWN_SEGMENT);
+
+    return scenarios;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: container_sample [OPTIONS]" << endl << endl;
+    cout << "\t-k           Keep " << CONTAINER_PATH << " of the last file" <<
+        endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    vector<scenario_t> scenarios = build_scenarios();
+    bool keep_file = false;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "kh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'k':
+                keep_file = true;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    for (size_t i = 0; i < scenarios.size(); i++)
+    {
+        if (run_scenario(scenarios[i], keep_file) < 0)
+        {
+            cerr << scenarios[i].name << ": FAILED" << endl;
+            ret = -1;
+        }
+    }
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
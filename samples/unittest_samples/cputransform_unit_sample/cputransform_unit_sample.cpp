@@ -0,0 +1,1216 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./cputransform_sample [-n fuzz_cases] [-t threads] [-i iterations] [-v]
+ * Example:
+ * ./cputransform_sample
+ * ./cputransform_sample -n 20000 -t 8 -i 20
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NvCpuTransform.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvCpuTransform.
+ *
+ * Frames are filled with pseudo-random samples and transformed by three
+ * objects: one running the scalar kernels on a single thread, which is the
+ * reference, one running the AVX2 or NEON kernels on a single thread and
+ * one running them on several threads:
+ *
+ * - copy: same size transforms of every format, with every filter and with
+ *   source or destination cropping, must copy the samples bit-exactly and
+ *   leave the rest of the destination untouched;
+ * - flip: every flip method must move the pixels where it says, and
+ *   applying its inverse must give back the source bit-exactly;
+ * - fuzz: random formats, sizes, rectangles, filters and flips must give
+ *   bit-exact results with the vector kernels and with several threads;
+ * - reference: color conversions and scaling must be within 0.51 LSB of a
+ *   double precision computation;
+ * - throughput: full HD conversion, scaling and rotation rates are
+ *   reported for the three objects.
+ */
+
+#define DEFAULT_FUZZ_CASES 2000
+#define DEFAULT_THREADS 4
+#define DEFAULT_ITERATIONS 5
+#define MAX_THREADS 64
+#define FUZZ_MAX_SIZE 160
+#define MAX_REFERENCE_ERROR 0.51
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef NvCpuTransform::NvCpuSurface NvCpuSurface;
+
+typedef struct
+{
+    NvBufSurfaceColorFormat format;
+    const char *name;
+    /** Number of significant bits of a sample. */
+    uint32_t depth;
+    /** Whether the chroma is subsampled horizontally only, transposing
+        then has to resample it. */
+    bool chroma_422;
+    /** Whether the width must be even. */
+    bool packed_422;
+} FormatInfo;
+
+static const FormatInfo formats[] =
+{
+    { NVBUF_COLOR_FORMAT_GRAY8, "GRAY8", 8, false, false },
+    { NVBUF_COLOR_FORMAT_YUV420, "I420", 8, false, false },
+    { NVBUF_COLOR_FORMAT_YVU420, "YV12", 8, false, false },
+    { NVBUF_COLOR_FORMAT_YUV422, "YUV422", 8, true, false },
+    { NVBUF_COLOR_FORMAT_YUV444, "YUV444", 8, false, false },
+    { NVBUF_COLOR_FORMAT_NV12, "NV12", 8, false, false },
+    { NVBUF_COLOR_FORMAT_NV21, "NV21", 8, false, false },
+    { NVBUF_COLOR_FORMAT_NV12_709_ER, "NV12_709_ER", 8, false, false },
+    { NVBUF_COLOR_FORMAT_NV16, "NV16", 8, true, false },
+    { NVBUF_COLOR_FORMAT_NV24, "NV24", 8, false, false },
+    { NVBUF_COLOR_FORMAT_NV24_709_ER, "NV24_709_ER", 8, false, false },
+    { NVBUF_COLOR_FORMAT_NV12_10LE, "P010", 10, false, false },
+    { NVBUF_COLOR_FORMAT_NV12_12LE, "NV12_12LE", 12, false, false },
+    { NVBUF_COLOR_FORMAT_NV24_10LE_2020, "NV24_10LE_2020", 10, false, false },
+    { NVBUF_COLOR_FORMAT_YUYV, "YUYV", 8, true, true },
+    { NVBUF_COLOR_FORMAT_UYVY, "UYVY", 8, true, true },
+    { NVBUF_COLOR_FORMAT_YVYU, "YVYU", 8, true, true },
+    { NVBUF_COLOR_FORMAT_VYUY, "VYUY", 8, true, true },
+    { NVBUF_COLOR_FORMAT_RGBA, "RGBA", 8, false, false },
+    { NVBUF_COLOR_FORMAT_BGRA, "BGRA", 8, false, false },
+    { NVBUF_COLOR_FORMAT_ARGB, "ARGB", 8, false, false },
+    { NVBUF_COLOR_FORMAT_ABGR, "ABGR", 8, false, false },
+    { NVBUF_COLOR_FORMAT_RGB, "RGB", 8, false, false },
+    { NVBUF_COLOR_FORMAT_BGR, "BGR", 8, false, false },
+};
+
+#define NUM_FORMATS (sizeof(formats) / sizeof(formats[0]))
+
+static const NvBufSurfTransform_Inter filters[] =
+{
+    NvBufSurfTransformInter_Nearest,
+    NvBufSurfTransformInter_Bilinear,
+    NvBufSurfTransformInter_Algo1,
+    NvBufSurfTransformInter_Algo2,
+    NvBufSurfTransformInter_Algo3,
+    NvBufSurfTransformInter_Algo4,
+    NvBufSurfTransformInter_Default,
+};
+
+#define NUM_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+static const char *flip_names[] =
+{
+    "None", "Rotate90", "Rotate180", "Rotate270", "FlipX", "FlipY",
+    "Transpose", "InvTranspose"
+};
+
+#define NUM_FLIPS (sizeof(flip_names) / sizeof(flip_names[0]))
+
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+xorshift()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state >> 32;
+}
+
+/** Picks a number in [lo, hi]. */
+static uint32_t
+pick(uint32_t lo, uint32_t hi)
+{
+    return lo + xorshift() % (hi - lo + 1);
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Frame in CPU memory, freed when it goes out of scope.
+ */
+class Frame
+{
+public:
+    NvCpuSurface surface;
+    const FormatInfo *info;
+
+    Frame()
+    {
+        memset(&surface, 0, sizeof(surface));
+        info = NULL;
+    }
+
+    ~Frame()
+    {
+        NvCpuTransform::NvDestroy(&surface);
+    }
+
+    int allocate(uint32_t width, uint32_t height, const FormatInfo *format)
+    {
+        NvCpuTransform::NvDestroy(&surface);
+        info = format;
+        return NvCpuTransform::NvAllocate(width, height, format->format,
+                &surface);
+    }
+
+    uint32_t rowBytes(uint32_t plane) const
+    {
+        return surface.planeParams.width[plane] *
+            surface.planeParams.bytesPerPix[plane];
+    }
+
+    uint8_t *row(uint32_t plane, uint32_t y) const
+    {
+        return surface.addr[plane] +
+            (size_t) y * surface.planeParams.pitch[plane];
+    }
+
+    size_t size() const
+    {
+        const NvBufSurfacePlaneParams &params = surface.planeParams;
+        uint32_t last = params.num_planes - 1;
+
+        return params.offset[last] + params.psize[last];
+    }
+
+    /**
+     * Gets the log2 of the subsampling of @a plane, from the plane sizes.
+     */
+    void getShift(uint32_t plane, uint32_t &shift_x, uint32_t &shift_y) const
+    {
+        const NvBufSurfacePlaneParams &params = surface.planeParams;
+
+        shift_x = params.width[plane] < params.width[0] ? 1 : 0;
+        shift_y = params.height[plane] < params.height[0] ? 1 : 0;
+    }
+
+    /**
+     * Fills the frame with random samples, whose insignificant bits are 0
+     * for deep formats, and the row padding with random bytes.
+     */
+    void fillRandom()
+    {
+        uint16_t mask = 0xFFFF << (16 - info->depth);
+        uint8_t *data = surface.addr[0];
+
+        for (size_t i = 0; i < size(); i++)
+        {
+            data[i] = xorshift();
+        }
+        if (info->depth == 8)
+        {
+            return;
+        }
+        for (uint32_t p = 0; p < surface.planeParams.num_planes; p++)
+        {
+            for (uint32_t y = 0; y < surface.planeParams.height[p]; y++)
+            {
+                uint16_t *samples = (uint16_t *) row(p, y);
+                for (uint32_t x = 0; x < rowBytes(p) / 2; x++)
+                {
+                    samples[x] &= mask;
+                }
+            }
+        }
+    }
+
+    void copyFrom(const Frame &other)
+    {
+        memcpy(surface.addr[0], other.surface.addr[0], size());
+    }
+
+private:
+    /**
+     * Disallow copy constructor.
+     */
+    Frame(const Frame& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(Frame const&);
+};
+
+static void
+init_params(NvBufSurf::NvCommonTransformParams &params)
+{
+    memset(&params, 0, sizeof(params));
+    params.flag = (NvBufSurfTransform_Transform_Flag) 0;
+    params.flip = NvBufSurfTransform_None;
+    params.filter = NvBufSurfTransformInter_Default;
+}
+
+static void
+set_flag(NvBufSurf::NvCommonTransformParams &params,
+        NvBufSurfTransform_Transform_Flag flag)
+{
+    params.flag = (NvBufSurfTransform_Transform_Flag) (params.flag | flag);
+}
+
+static int
+find_format(NvBufSurfaceColorFormat format)
+{
+    for (uint32_t i = 0; i < NUM_FORMATS; i++)
+    {
+        if (formats[i].format == format)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Compares the samples of two frames of the same format and size, the row
+ * padding is ignored.
+ */
+static int
+compare_frames(const Frame &a, const Frame &b, const string &what)
+{
+    for (uint32_t p = 0; p < a.surface.planeParams.num_planes; p++)
+    {
+        for (uint32_t y = 0; y < a.surface.planeParams.height[p]; y++)
+        {
+            const uint8_t *ra = a.row(p, y);
+            const uint8_t *rb = b.row(p, y);
+
+            for (uint32_t x = 0; x < a.rowBytes(p); x++)
+            {
+                CHECK(ra[x] == rb[x], what << ": plane " << p << " row " <<
+                        y << " byte " << x << " is " << (int) ra[x] <<
+                        " instead of " << (int) rb[x]);
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Checks that the window of @a big at (@a left, @a top) holds the samples of
+ * @a small and, if @a before is given, that the rest of @a big still holds
+ * the samples of @a before.
+ */
+static int
+check_window(const Frame &big, const Frame *before, const Frame &small,
+        uint32_t left, uint32_t top, const string &what)
+{
+    for (uint32_t p = 0; p < big.surface.planeParams.num_planes; p++)
+    {
+        uint32_t shift_x, shift_y;
+        big.getShift(p, shift_x, shift_y);
+
+        uint32_t bpp = big.surface.planeParams.bytesPerPix[p];
+        uint32_t x0 = (left >> shift_x) * bpp;
+        uint32_t y0 = top >> shift_y;
+        uint32_t x1 = x0 + small.rowBytes(p);
+        uint32_t y1 = y0 + small.surface.planeParams.height[p];
+
+        for (uint32_t y = 0; y < big.surface.planeParams.height[p]; y++)
+        {
+            const uint8_t *row = big.row(p, y);
+
+            for (uint32_t x = 0; x < big.rowBytes(p); x++)
+            {
+                bool inside = x >= x0 && x < x1 && y >= y0 && y < y1;
+
+                if (inside)
+                {
+                    uint8_t expected = small.row(p, y - y0)[x - x0];
+                    CHECK(row[x] == expected, what << ": plane " << p <<
+                            " row " << y << " byte " << x << " is " <<
+                            (int) row[x] << " instead of " << (int) expected);
+                }
+                else if (before)
+                {
+                    CHECK(row[x] == before->row(p, y)[x], what << ": plane " <<
+                            p << " row " << y << " byte " << x <<
+                            " outside of the rectangle was written");
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static int
+check_copy(NvCpuTransform *transform)
+{
+    static const uint32_t sizes[][2] = { {2, 2}, {38, 23}, {129, 67} };
+
+    for (uint32_t f = 0; f < NUM_FORMATS; f++)
+    {
+        const FormatInfo *info = &formats[f];
+
+        for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            uint32_t width = info->packed_422 ? sizes[s][0] & ~1 : sizes[s][0];
+            uint32_t height = sizes[s][1];
+            NvBufSurf::NvCommonTransformParams params;
+            Frame src, dst, big, before;
+            string what = string("copy ") + info->name;
+
+            CHECK(src.allocate(width, height, info) == 0 &&
+                    dst.allocate(width, height, info) == 0 &&
+                    big.allocate(width + 10, height + 8, info) == 0 &&
+                    before.allocate(width + 10, height + 8, info) == 0,
+                    "Could not allocate " << info->name << " frames");
+            src.fillRandom();
+
+            for (uint32_t i = 0; i < NUM_FILTERS; i++)
+            {
+                init_params(params);
+                set_flag(params, NVBUFSURF_TRANSFORM_FILTER);
+                params.filter = filters[i];
+                dst.fillRandom();
+                CHECK(transform->NvTransform(&params, &src.surface,
+                            &dst.surface) == 0, what << " failed");
+                if (compare_frames(dst, src, what) < 0)
+                {
+                    return -1;
+                }
+            }
+
+            /* Source window at an even position, so that the chroma
+             * window also starts on a sample. */
+            big.fillRandom();
+            init_params(params);
+            set_flag(params, NVBUFSURF_TRANSFORM_CROP_SRC);
+            params.src_left = 4;
+            params.src_top = 2;
+            params.src_width = width;
+            params.src_height = height;
+            dst.fillRandom();
+            CHECK(transform->NvTransform(&params, &big.surface,
+                        &dst.surface) == 0, what << " from a window failed");
+            if (check_window(big, NULL, dst, 4, 2,
+                        what + " from a window") < 0)
+            {
+                return -1;
+            }
+
+            init_params(params);
+            set_flag(params, NVBUFSURF_TRANSFORM_CROP_DST);
+            params.dst_left = 4;
+            params.dst_top = 2;
+            params.dst_width = width;
+            params.dst_height = height;
+            big.fillRandom();
+            before.copyFrom(big);
+            CHECK(transform->NvTransform(&params, &src.surface,
+                        &big.surface) == 0, what << " to a window failed");
+            if (check_window(big, &before, src, 4, 2,
+                        what + " to a window") < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    cout << "copy: OK" << endl;
+    return 0;
+}
+
+static bool
+is_transposed(uint32_t flip)
+{
+    return flip == NvBufSurfTransform_Rotate90 ||
+        flip == NvBufSurfTransform_Rotate270 ||
+        flip == NvBufSurfTransform_Transpose ||
+        flip == NvBufSurfTransform_InvTranspose;
+}
+
+static uint32_t
+inverse_flip(uint32_t flip)
+{
+    if (flip == NvBufSurfTransform_Rotate90)
+    {
+        return NvBufSurfTransform_Rotate270;
+    }
+    if (flip == NvBufSurfTransform_Rotate270)
+    {
+        return NvBufSurfTransform_Rotate90;
+    }
+    return flip;
+}
+
+/**
+ * Gets the source pixel that pixel (x, y) of the flipped frame comes from,
+ * rotations being counter-clockwise.
+ */
+static void
+flip_source(uint32_t flip, uint32_t width, uint32_t height, uint32_t x,
+        uint32_t y, uint32_t &sx, uint32_t &sy)
+{
+    switch (flip)
+    {
+        case NvBufSurfTransform_Rotate90:
+            sx = width - 1 - y; sy = x;
+            break;
+        case NvBufSurfTransform_Rotate180:
+            sx = width - 1 - x; sy = height - 1 - y;
+            break;
+        case NvBufSurfTransform_Rotate270:
+            sx = y; sy = height - 1 - x;
+            break;
+        case NvBufSurfTransform_FlipX:
+            sx = width - 1 - x; sy = y;
+            break;
+        case NvBufSurfTransform_FlipY:
+            sx = x; sy = height - 1 - y;
+            break;
+        case NvBufSurfTransform_Transpose:
+            sx = y; sy = x;
+            break;
+        case NvBufSurfTransform_InvTranspose:
+            sx = width - 1 - y; sy = height - 1 - x;
+            break;
+        default:
+            sx = x; sy = y;
+            break;
+    }
+}
+
+static int
+check_flip(NvCpuTransform *transform)
+{
+    const FormatInfo *gray = &formats[find_format(NVBUF_COLOR_FORMAT_GRAY8)];
+    const uint32_t width = 37;
+    const uint32_t height = 23;
+    NvBufSurf::NvCommonTransformParams params;
+
+    /* Where the pixels go, on a gray frame. */
+    for (uint32_t flip = 0; flip < NUM_FLIPS; flip++)
+    {
+        bool transposed = is_transposed(flip);
+        Frame src, dst;
+
+        CHECK(src.allocate(width, height, gray) == 0 &&
+                dst.allocate(transposed ? height : width,
+                    transposed ? width : height, gray) == 0,
+                "Could not allocate gray frames");
+        src.fillRandom();
+
+        init_params(params);
+        set_flag(params, NVBUFSURF_TRANSFORM_FLIP);
+        params.flip = (NvBufSurfTransform_Flip) flip;
+        CHECK(transform->NvTransform(&params, &src.surface, &dst.surface) == 0,
+                "flip " << flip_names[flip] << " failed");
+
+        for (uint32_t y = 0; y < dst.surface.height; y++)
+        {
+            for (uint32_t x = 0; x < dst.surface.width; x++)
+            {
+                uint32_t sx, sy;
+                flip_source(flip, width, height, x, y, sx, sy);
+                CHECK(dst.row(0, y)[x] == src.row(0, sy)[sx], "flip " <<
+                        flip_names[flip] << ": pixel " << x << "," << y <<
+                        " is not pixel " << sx << "," << sy);
+            }
+        }
+    }
+
+    /* Round trips through the flip and its inverse. Transposing 4:2:2
+     * chroma resamples it, so these formats only take the other flips. */
+    for (uint32_t f = 0; f < NUM_FORMATS; f++)
+    {
+        const FormatInfo *info = &formats[f];
+        uint32_t w = info->packed_422 ? width + 1 : width;
+
+        for (uint32_t flip = 0; flip < NUM_FLIPS; flip++)
+        {
+            bool transposed = is_transposed(flip);
+            string what = string("flip ") + flip_names[flip] + " of " +
+                info->name;
+            Frame src, mid, back;
+
+            if (transposed && info->chroma_422)
+            {
+                continue;
+            }
+            CHECK(src.allocate(w, height, info) == 0 &&
+                    mid.allocate(transposed ? height : w,
+                        transposed ? w : height, info) == 0 &&
+                    back.allocate(w, height, info) == 0,
+                    "Could not allocate " << info->name << " frames");
+            src.fillRandom();
+            back.fillRandom();
+
+            init_params(params);
+            set_flag(params, NVBUFSURF_TRANSFORM_FLIP);
+            params.flip = (NvBufSurfTransform_Flip) flip;
+            CHECK(transform->NvTransform(&params, &src.surface,
+                        &mid.surface) == 0, what << " failed");
+            params.flip = (NvBufSurfTransform_Flip) inverse_flip(flip);
+            CHECK(transform->NvTransform(&params, &mid.surface,
+                        &back.surface) == 0, what << " inverse failed");
+            if (compare_frames(back, src, what + " and back") < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    cout << "flip: OK" << endl;
+    return 0;
+}
+
+/**
+ * Picks a rectangle of at least one pixel in a frame of @a size pixels,
+ * starting on a multiple of @a align.
+ */
+static void
+pick_rect(uint32_t size, uint32_t align, uint32_t &start, uint32_t &length)
+{
+    start = pick(0, (size - 1) / align) * align;
+    length = pick(1, size - start);
+}
+
+static int
+check_fuzz(NvCpuTransform *scalar, NvCpuTransform *vector,
+        NvCpuTransform *threaded, uint32_t num_cases)
+{
+    NvCpuTransform *transforms[] = { vector, threaded };
+    const char *names[] = { "vector kernels", "threads" };
+    uint32_t num_scaled = 0;
+    uint32_t num_converted = 0;
+
+    for (uint32_t i = 0; i < num_cases; i++)
+    {
+        const FormatInfo *src_info = &formats[pick(0, NUM_FORMATS - 1)];
+        const FormatInfo *dst_info = &formats[pick(0, NUM_FORMATS - 1)];
+        uint32_t src_width = pick(1, FUZZ_MAX_SIZE);
+        uint32_t src_height = pick(1, FUZZ_MAX_SIZE);
+        uint32_t dst_width = pick(1, FUZZ_MAX_SIZE);
+        uint32_t dst_height = pick(1, FUZZ_MAX_SIZE);
+        uint32_t dst_align_x, dst_align_y;
+        NvBufSurf::NvCommonTransformParams params;
+        Frame src, ref, dst, before;
+
+        if (src_info->packed_422)
+        {
+            src_width = (src_width + 1) & ~1;
+        }
+        if (dst_info->packed_422)
+        {
+            dst_width = (dst_width + 1) & ~1;
+        }
+        CHECK(src.allocate(src_width, src_height, src_info) == 0 &&
+                ref.allocate(dst_width, dst_height, dst_info) == 0 &&
+                dst.allocate(dst_width, dst_height, dst_info) == 0 &&
+                before.allocate(dst_width, dst_height, dst_info) == 0,
+                "Could not allocate the frames of fuzz case " << i);
+        src.fillRandom();
+        before.fillRandom();
+        ref.copyFrom(before);
+
+        init_params(params);
+        params.src_width = src_width;
+        params.src_height = src_height;
+        params.dst_width = dst_width;
+        params.dst_height = dst_height;
+        if (pick(0, 1))
+        {
+            set_flag(params, NVBUFSURF_TRANSFORM_CROP_SRC);
+            pick_rect(src_width, 1, params.src_left, params.src_width);
+            pick_rect(src_height, 1, params.src_top, params.src_height);
+        }
+        if (pick(0, 1))
+        {
+            dst_align_x = 1;
+            dst_align_y = 1;
+            if (dst.surface.planeParams.num_planes > 1 || dst_info->packed_422)
+            {
+                uint32_t shift_x, shift_y;
+                dst.getShift(dst.surface.planeParams.num_planes - 1,
+                        shift_x, shift_y);
+                dst_align_x = dst_info->packed_422 ? 2 : 1 << shift_x;
+                dst_align_y = 1 << shift_y;
+            }
+            set_flag(params, NVBUFSURF_TRANSFORM_CROP_DST);
+            pick_rect(dst_width, dst_align_x, params.dst_left, params.dst_width);
+            pick_rect(dst_height, dst_align_y, params.dst_top, params.dst_height);
+        }
+        if (pick(0, 3))
+        {
+            set_flag(params, NVBUFSURF_TRANSFORM_FILTER);
+            params.filter = filters[pick(0, NUM_FILTERS - 1)];
+        }
+        if (pick(0, 1))
+        {
+            set_flag(params, NVBUFSURF_TRANSFORM_FLIP);
+            params.flip = (NvBufSurfTransform_Flip) pick(0, NUM_FLIPS - 1);
+        }
+        /* Some windows of the same size, which are copied. */
+        if (!pick(0, 3) && params.src_width <= params.dst_width &&
+                params.src_height <= params.dst_height)
+        {
+            set_flag(params, NVBUFSURF_TRANSFORM_CROP_DST);
+            params.dst_width = params.src_width;
+            params.dst_height = params.src_height;
+            if (is_transposed(params.flip))
+            {
+                params.dst_width = min(params.src_height, params.dst_width);
+                params.dst_height = min(params.src_width, params.dst_height);
+            }
+        }
+
+        CHECK(scalar->NvTransform(&params, &src.surface, &ref.surface) == 0,
+                "Fuzz case " << i << " failed");
+        if ((is_transposed(params.flip) ? params.src_height :
+                    params.src_width) != params.dst_width ||
+                (is_transposed(params.flip) ? params.src_width :
+                 params.src_height) != params.dst_height)
+        {
+            num_scaled++;
+        }
+        if (src_info->format != dst_info->format)
+        {
+            num_converted++;
+        }
+
+        for (uint32_t t = 0; t < 2; t++)
+        {
+            ostringstream what;
+
+            what << "fuzz case " << i << " with " << names[t] << " (" <<
+                src_info->name << " " << src_width << "x" << src_height <<
+                " window " << params.src_left << "," << params.src_top <<
+                " " << params.src_width << "x" << params.src_height <<
+                " to " << dst_info->name << " " << dst_width << "x" <<
+                dst_height << " window " << params.dst_left << "," <<
+                params.dst_top << " " << params.dst_width << "x" <<
+                params.dst_height << ", filter " << params.filter <<
+                ", flip " << flip_names[params.flip] << ")";
+            dst.copyFrom(before);
+            CHECK(transforms[t]->NvTransform(&params, &src.surface,
+                        &dst.surface) == 0, what.str() << " failed");
+            if (compare_frames(dst, ref, what.str()) < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    cout << "fuzz: " << num_cases << " cases, " << num_scaled <<
+        " scaled, " << num_converted << " converted" << endl;
+    cout << "fuzz: OK" << endl;
+    return 0;
+}
+
+/**
+ * Color space of a format, with the luma weights of its matrix.
+ */
+typedef struct
+{
+    NvBufSurfaceColorFormat format;
+    bool is_rgb;
+    double kr;
+    double kb;
+    bool full_range;
+} ColorSpace;
+
+/**
+ * Gets the samples of pixel (x, y), normalized to [0, 1]: Y, U, V or R, G,
+ * B. Only 4:4:4 planar, semi-planar and packed RGB formats are handled.
+ */
+static void
+get_pixel(const Frame &frame, uint32_t x, uint32_t y, double c[3])
+{
+    uint32_t depth = frame.info->depth;
+    double peak = (1 << depth) - 1;
+    const uint8_t *row0 = frame.row(0, y);
+
+    switch (frame.info->format)
+    {
+        case NVBUF_COLOR_FORMAT_YUV444:
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                c[k] = frame.row(k, y)[x] / peak;
+            }
+            break;
+        case NVBUF_COLOR_FORMAT_NV24:
+        case NVBUF_COLOR_FORMAT_NV24_709_ER:
+            c[0] = row0[x] / peak;
+            c[1] = frame.row(1, y)[2 * x] / peak;
+            c[2] = frame.row(1, y)[2 * x + 1] / peak;
+            break;
+        case NVBUF_COLOR_FORMAT_NV24_10LE_2020:
+        case NVBUF_COLOR_FORMAT_NV24_10LE:
+            c[0] = (((const uint16_t *) row0)[x] >> (16 - depth)) / peak;
+            for (uint32_t k = 0; k < 2; k++)
+            {
+                const uint16_t *row1 = (const uint16_t *) frame.row(1, y);
+                c[1 + k] = (row1[2 * x + k] >> (16 - depth)) / peak;
+            }
+            break;
+        case NVBUF_COLOR_FORMAT_BGRA:
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                c[k] = row0[4 * x + 2 - k] / peak;
+            }
+            break;
+        case NVBUF_COLOR_FORMAT_RGB:
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                c[k] = row0[3 * x + k] / peak;
+            }
+            break;
+        default:
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                c[k] = row0[4 * x + k] / peak;
+            }
+            break;
+    }
+}
+
+/**
+ * Converts normalized samples of color space @a from to color space @a to.
+ * Limited range samples are scaled as 8-bit ones, Y from 16 to 235 and U
+ * and V from 16 to 240 around 128.
+ */
+static void
+convert_pixel(const ColorSpace &from, const ColorSpace &to, const double in[3],
+        double out[3])
+{
+    double rgb[3];
+
+    if (from.is_rgb)
+    {
+        memcpy(rgb, in, sizeof(rgb));
+    }
+    else
+    {
+        double kg = 1.0 - from.kr - from.kb;
+        double ys = from.full_range ? 1.0 : 255.0 / 219.0;
+        double yo = from.full_range ? 0.0 : 16.0 / 255.0;
+        double cs = from.full_range ? 1.0 : 255.0 / 224.0;
+        double y = (in[0] - yo) * ys;
+        double cb = (in[1] - 128.0 / 255.0) * cs;
+        double cr = (in[2] - 128.0 / 255.0) * cs;
+
+        rgb[0] = y + 2.0 * (1.0 - from.kr) * cr;
+        rgb[1] = y - 2.0 * from.kb * (1.0 - from.kb) / kg * cb -
+            2.0 * from.kr * (1.0 - from.kr) / kg * cr;
+        rgb[2] = y + 2.0 * (1.0 - from.kb) * cb;
+    }
+
+    if (to.is_rgb)
+    {
+        memcpy(out, rgb, sizeof(rgb));
+    }
+    else
+    {
+        double y = to.kr * rgb[0] + (1.0 - to.kr - to.kb) * rgb[1] +
+            to.kb * rgb[2];
+        double ys = to.full_range ? 1.0 : 219.0 / 255.0;
+        double yo = to.full_range ? 0.0 : 16.0 / 255.0;
+        double cs = to.full_range ? 1.0 : 224.0 / 255.0;
+
+        out[0] = y * ys + yo;
+        out[1] = (rgb[2] - y) / (2.0 * (1.0 - to.kb)) * cs + 128.0 / 255.0;
+        out[2] = (rgb[0] - y) / (2.0 * (1.0 - to.kr)) * cs + 128.0 / 255.0;
+    }
+}
+
+/**
+ * Gets the taps of output sample @a i of a filter mapping the window
+ * [start, start + length) of in_size samples onto out_size samples, with
+ * the kernel widened by the scaling factor when downscaling and the taps
+ * limited to the samples that the window touches.
+ */
+static void
+reference_taps(bool bicubic, uint32_t in_size, double start, double length,
+        uint32_t out_size, uint32_t i, vector<int> &index,
+        vector<double> &weight)
+{
+    double scale = length / out_size;
+    double filter_scale = scale > 1.0 ? scale : 1.0;
+    double support = (bicubic ? 2.0 : 1.0) * filter_scale;
+    double center = start + (i + 0.5) * scale;
+    int lo = (int) floor(start);
+    int hi = (int) ceil(start + length);
+    double sum = 0.0;
+
+    hi = hi > (int) in_size ? in_size : hi;
+    index.clear();
+    weight.clear();
+    for (int x = (int) floor(center - support + 0.5);
+            x < (int) floor(center + support + 0.5); x++)
+    {
+        double d = fabs((x + 0.5 - center) / filter_scale);
+        double w;
+
+        if (x < lo || x >= hi)
+        {
+            continue;
+        }
+        if (!bicubic)
+        {
+            w = d < 1.0 ? 1.0 - d : 0.0;
+        }
+        else if (d < 1.0)
+        {
+            w = (1.5 * d - 2.5) * d * d + 1.0;
+        }
+        else
+        {
+            w = d < 2.0 ? ((-0.5 * d + 2.5) * d - 4.0) * d + 2.0 : 0.0;
+        }
+        index.push_back(x);
+        weight.push_back(w);
+        sum += w;
+    }
+    for (size_t t = 0; t < weight.size(); t++)
+    {
+        weight[t] /= sum;
+    }
+}
+
+static int
+check_reference(NvCpuTransform *transform)
+{
+    static const ColorSpace spaces[] =
+    {
+        { NVBUF_COLOR_FORMAT_YUV444, false, 0.299, 0.114, false },
+        { NVBUF_COLOR_FORMAT_NV24, false, 0.299, 0.114, false },
+        { NVBUF_COLOR_FORMAT_NV24_709_ER, false, 0.2126, 0.0722, true },
+        { NVBUF_COLOR_FORMAT_NV24_10LE_2020, false, 0.2627, 0.0593, false },
+        { NVBUF_COLOR_FORMAT_RGBA, true, 0, 0, true },
+        { NVBUF_COLOR_FORMAT_BGRA, true, 0, 0, true },
+        { NVBUF_COLOR_FORMAT_RGB, true, 0, 0, true },
+    };
+    static const uint32_t num_spaces = sizeof(spaces) / sizeof(spaces[0]);
+    const uint32_t width = 67;
+    const uint32_t height = 41;
+    NvBufSurf::NvCommonTransformParams params;
+    double max_error = 0.0;
+
+    /* Color conversions between all the pairs of color spaces, the
+     * 10-bit ones are only read since their 16-bit rounding is coarser. */
+    for (uint32_t a = 0; a < num_spaces; a++)
+    {
+        for (uint32_t b = 0; b < num_spaces; b++)
+        {
+            const FormatInfo *src_info = &formats[find_format(spaces[a].format)];
+            const FormatInfo *dst_info = &formats[find_format(spaces[b].format)];
+            Frame src, dst;
+
+            if (a == b || dst_info->depth > 8)
+            {
+                continue;
+            }
+            CHECK(src.allocate(width, height, src_info) == 0 &&
+                    dst.allocate(width, height, dst_info) == 0,
+                    "Could not allocate the reference frames");
+            src.fillRandom();
+            init_params(params);
+            CHECK(transform->NvTransform(&params, &src.surface,
+                        &dst.surface) == 0, src_info->name << " to " <<
+                    dst_info->name << " failed");
+
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    double in[3], expected[3], out[3];
+
+                    get_pixel(src, x, y, in);
+                    convert_pixel(spaces[a], spaces[b], in, expected);
+                    get_pixel(dst, x, y, out);
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        double e = expected[k] < 0.0 ? 0.0 :
+                            (expected[k] > 1.0 ? 1.0 : expected[k]);
+                        double error = fabs(out[k] - e) * 255.0;
+
+                        CHECK(error <= MAX_REFERENCE_ERROR, src_info->name <<
+                                " to " << dst_info->name << ": channel " << k <<
+                                " of pixel " << x << "," << y << " is " <<
+                                out[k] * 255.0 << " instead of " << e * 255.0);
+                        max_error = error > max_error ? error : max_error;
+                    }
+                }
+            }
+        }
+    }
+
+    /* Scaling of a window of a gray frame with the separable filters. */
+    static const uint32_t sizes[][2] = { {160, 120}, {29, 17}, {97, 30},
+        {13, 90}, {80, 50} };
+    const FormatInfo *gray = &formats[find_format(NVBUF_COLOR_FORMAT_GRAY8)];
+    Frame src;
+    vector<int> h_index, v_index;
+    vector<double> h_weight, v_weight;
+
+    CHECK(src.allocate(97, 61, gray) == 0, "Could not allocate a gray frame");
+    src.fillRandom();
+    for (uint32_t bicubic = 0; bicubic < 2; bicubic++)
+    {
+        for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            Frame dst;
+
+            CHECK(dst.allocate(sizes[s][0], sizes[s][1], gray) == 0,
+                    "Could not allocate a gray frame");
+            init_params(params);
+            set_flag(params, NVBUFSURF_TRANSFORM_FILTER);
+            set_flag(params, NVBUFSURF_TRANSFORM_CROP_SRC);
+            params.filter = bicubic ? NvBufSurfTransformInter_Algo4 :
+                NvBufSurfTransformInter_Bilinear;
+            params.src_left = 3;
+            params.src_top = 5;
+            params.src_width = 80;
+            params.src_height = 50;
+            CHECK(transform->NvTransform(&params, &src.surface,
+                        &dst.surface) == 0, "Scaling to " << sizes[s][0] <<
+                    "x" << sizes[s][1] << " failed");
+
+            for (uint32_t y = 0; y < dst.surface.height; y++)
+            {
+                reference_taps(bicubic, src.surface.height, params.src_top,
+                        params.src_height, dst.surface.height, y, v_index,
+                        v_weight);
+                for (uint32_t x = 0; x < dst.surface.width; x++)
+                {
+                    double expected = 0.0;
+
+                    reference_taps(bicubic, src.surface.width, params.src_left,
+                            params.src_width, dst.surface.width, x, h_index,
+                            h_weight);
+                    for (size_t j = 0; j < v_index.size(); j++)
+                    {
+                        double sum = 0.0;
+                        for (size_t i = 0; i < h_index.size(); i++)
+                        {
+                            sum += src.row(0, v_index[j])[h_index[i]] *
+                                h_weight[i];
+                        }
+                        expected += sum * v_weight[j];
+                    }
+                    expected = expected < 0.0 ? 0.0 :
+                        (expected > 255.0 ? 255.0 : expected);
+
+                    double error = fabs(dst.row(0, y)[x] - expected);
+                    CHECK(error <= MAX_REFERENCE_ERROR, (bicubic ? "Bicubic" :
+                                "Bilinear") << " scaling to " << sizes[s][0] <<
+                            "x" << sizes[s][1] << ": pixel " << x << "," << y <<
+                            " is " << (int) dst.row(0, y)[x] << " instead of " <<
+                            expected);
+                    max_error = error > max_error ? error : max_error;
+                }
+            }
+        }
+    }
+
+    cout << "reference: largest error " << max_error << " LSB" << endl;
+    cout << "reference: OK" << endl;
+    return 0;
+}
+
+static int
+report_throughput(NvCpuTransform *scalar, NvCpuTransform *vector,
+        NvCpuTransform *threaded, uint32_t iterations)
+{
+    NvCpuTransform *transforms[] = { scalar, vector, threaded };
+    const FormatInfo *nv12 = &formats[find_format(NVBUF_COLOR_FORMAT_NV12)];
+    const FormatInfo *rgba = &formats[find_format(NVBUF_COLOR_FORMAT_RGBA)];
+    Frame src, converted, scaled, rotated;
+    struct
+    {
+        const char *name;
+        Frame *dst;
+        NvBufSurfTransform_Inter filter;
+        NvBufSurfTransform_Flip flip;
+    } cases[] =
+    {
+        { "NV12 to RGBA", &converted, NvBufSurfTransformInter_Bilinear,
+          NvBufSurfTransform_None },
+        { "NV12 bicubic to 1280x720", &scaled, NvBufSurfTransformInter_Algo4,
+          NvBufSurfTransform_None },
+        { "NV12 Rotate90", &rotated, NvBufSurfTransformInter_Nearest,
+          NvBufSurfTransform_Rotate90 },
+    };
+
+    CHECK(src.allocate(BENCH_WIDTH, BENCH_HEIGHT, nv12) == 0 &&
+            converted.allocate(BENCH_WIDTH, BENCH_HEIGHT, rgba) == 0 &&
+            scaled.allocate(1280, 720, nv12) == 0 &&
+            rotated.allocate(BENCH_HEIGHT, BENCH_WIDTH, nv12) == 0,
+            "Could not allocate the full HD frames");
+    src.fillRandom();
+
+    cout << "throughput (" << BENCH_WIDTH << "x" << BENCH_HEIGHT <<
+        " frames/s with scalar, " << vector->getSimdName() << " and " <<
+        threaded->getNumThreads() << " threads):" << endl;
+    for (uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        cout << "  " << left << setw(26) << cases[c].name << right;
+        for (uint32_t t = 0; t < 3; t++)
+        {
+            NvBufSurf::NvCommonTransformParams params;
+            uint64_t start;
+
+            init_params(params);
+            set_flag(params, NVBUFSURF_TRANSFORM_FILTER);
+            set_flag(params, NVBUFSURF_TRANSFORM_FLIP);
+            params.filter = cases[c].filter;
+            params.flip = cases[c].flip;
+
+            start = now_nsec();
+            for (uint32_t i = 0; i < iterations; i++)
+            {
+                CHECK(transforms[t]->NvTransform(&params, &src.surface,
+                            &cases[c].dst->surface) == 0,
+                        cases[c].name << " failed");
+            }
+            cout << fixed << setprecision(1) << setw(9) <<
+                iterations * 1e9 / (now_nsec() - start);
+        }
+        cout << endl;
+    }
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Help:" << endl;
+    cout << "Execution cmd:\n"
+         << "./cputransform_sample [-n fuzz_cases] [-t threads] [-i iterations] [-v]\n"
+         << endl;
+    cout << "\t-n fuzz_cases Number of random transforms compared (default "
+         << DEFAULT_FUZZ_CASES << ")" << endl;
+    cout << "\t-t threads    Threads of the threaded transform (default "
+         << DEFAULT_THREADS << ")" << endl;
+    cout << "\t-i iterations Full HD transforms timed per case, 0 to skip "
+         << "(default " << DEFAULT_ITERATIONS << ")" << endl;
+    cout << "\t-v            Print the debug messages" << endl;
+    cout << "\t-h            Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_cases = DEFAULT_FUZZ_CASES;
+    uint32_t num_threads = DEFAULT_THREADS;
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    NvCpuTransform *scalar;
+    NvCpuTransform *vector;
+    NvCpuTransform *threaded;
+    int ret = 0;
+    int opt;
+
+    log_level = LOG_LEVEL_INFO;
+    while ((opt = getopt(argc, argv, "n:t:i:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_cases = atoi(optarg);
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                break;
+            case 'i':
+                iterations = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_DEBUG;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_threads < 2 || num_threads > MAX_THREADS)
+    {
+        print_help();
+        return -1;
+    }
+
+    scalar = NvCpuTransform::createCpuTransform(1, false);
+    vector = NvCpuTransform::createCpuTransform(1, true);
+    threaded = NvCpuTransform::createCpuTransform(num_threads, true);
+    if (!scalar || !vector || !threaded)
+    {
+        cerr << "Could not create the transforms" << endl;
+        ret = -1;
+    }
+    else
+    {
+        cout << "vector kernels: " << vector->getSimdName() << endl;
+        if (check_copy(threaded) < 0 || check_flip(threaded) < 0 ||
+                check_fuzz(scalar, vector, threaded, num_cases) < 0 ||
+                check_reference(threaded) < 0 ||
+                (iterations &&
+                 report_throughput(scalar, vector, threaded, iterations) < 0))
+        {
+            ret = -1;
+        }
+    }
+    delete threaded;
+    delete vector;
+    delete scalar;
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./crc_sample [-s size_in_MiB] [-n iterations]
+ * Example:
+ * ./crc_sample
+ * ./crc_sample -s 256 -n 100000
+**/
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "NvCrc.h"
+
+using namespace std;
+
+/**
+ * CPU only bit-exactness check and benchmark of NvCrc.
+ *
+ * 01_video_encode and 16_multivideo_transcode used to compute the CRC of
+ * the encoded buffers with InitCrc() and CalculateCrc(), one table lookup
+ * per byte. Their golden CRC files must still match, so every engine of
+ * NvCrc supported by the CPU is checked against a copy of that code, on
+ * random data at random offsets, with random lengths and initial values,
+ * streamed in random pieces and combined from two chunks. The throughput
+ * of each engine and of CalculateCrc() is then reported.
+ */
+
+#define DEFAULT_SIZE_MIB 64
+#define DEFAULT_ITERATIONS 2000
+#define MAX_OFFSET 64
+#define MAX_LENGTH 70000
+
+/** CRC-32 of "123456789", with an initial value and final XOR of ~0. */
+#define CRC32_CHECK 0xCBF43926
+/** Reflected CRC-32C polynomial and CRC-32C of "123456789". */
+#define CRC32C_POLYNOMIAL 0x82F63B78
+#define CRC32C_CHECK 0xE3069283
+
+typedef struct
+{
+    unsigned int CRCTable[256];
+    unsigned int CrcValue;
+} Crc;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static double
+now_seconds()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+  * Initialise CRC Rec and creates CRC Table based on the polynomial.
+  *
+  * Copy of the code NvCrc replaced in the encode samples.
+  *
+  * @param CrcPolynomial : CRC Polynomial values
+  */
+static
+Crc* InitCrc(unsigned int CrcPolynomial)
+{
+    unsigned short int i;
+    unsigned short int j;
+    unsigned int tempcrc;
+    Crc *phCrc;
+    phCrc = (Crc*) malloc (sizeof(Crc));
+    if (phCrc == NULL)
+    {
+        cerr << "Mem allocation failed for Init CRC" <<endl;
+        return NULL;
+    }
+
+    memset (phCrc, 0, sizeof(Crc));
+
+    for (i = 0; i <= 255; i++)
+    {
+        tempcrc = i;
+        for (j = 8; j > 0; j--)
+        {
+            if (tempcrc & 1)
+            {
+                tempcrc = (tempcrc >> 1) ^ CrcPolynomial;
+            }
+            else
+            {
+                tempcrc >>= 1;
+            }
+        }
+        phCrc->CRCTable[i] = tempcrc;
+    }
+
+    phCrc->CrcValue = 0;
+    return phCrc;
+}
+
+/**
+  * Calculates CRC of data provided in by buffer.
+  *
+  * @param *phCrc : bitstream CRC
+  * @param buffer : process buffer
+  * @param count  : bytes used
+  */
+static
+void CalculateCrc(Crc *phCrc, unsigned char *buffer, uint32_t count)
+{
+    unsigned char *p;
+    unsigned int temp1;
+    unsigned int temp2;
+    unsigned int crc = phCrc->CrcValue;
+    unsigned int *CRCTable = phCrc->CRCTable;
+
+    if(!count)
+        return;
+
+    p = (unsigned char *) buffer;
+    while (count-- != 0)
+    {
+        temp1 = (crc >> 8) & 0x00FFFFFFL;
+        temp2 = CRCTable[((unsigned int) crc ^ *p++) & 0xFF];
+        crc = temp1 ^ temp2;
+    }
+
+    phCrc->CrcValue = crc;
+}
+
+/**
+  * Closes CRC related handles.
+  *
+  * @param *phCrc : bitstream CRC
+  */
+static
+void CloseCrc(Crc **phCrc)
+{
+    if (*phCrc)
+        free (*phCrc);
+    *phCrc = NULL;
+}
+
+static unsigned int
+reference_crc(Crc *ref, unsigned int crc, unsigned char *buffer, uint32_t count)
+{
+    ref->CrcValue = crc;
+    CalculateCrc(ref, buffer, count);
+    return ref->CrcValue;
+}
+
+/**
+  * Checks one engine against CalculateCrc().
+  */
+static int
+check_engine(NvCrc *crc, Crc *ref, vector<unsigned char> &data,
+        uint32_t iterations)
+{
+    const char *name = NvCrc::getEngineName(crc->getEngine());
+    uint32_t value;
+    uint32_t i;
+    size_t pos;
+
+    value = ~crc->calculate(~0U, "123456789", 9);
+    if (value != CRC32_CHECK)
+    {
+        cerr << name << ": check value 0x" << hex << value << dec << endl;
+        return -1;
+    }
+
+    /* Every length up to a few folds, then random chunks. */
+    for (i = 0; i < iterations; i++)
+    {
+        uint32_t offset = next_rand() % MAX_OFFSET;
+        uint32_t length = i < 512 ? i : next_rand() % MAX_LENGTH;
+        uint32_t initial = (i & 1) ? next_rand() : 0;
+
+        value = crc->calculate(initial, &data[offset], length);
+        if (value != reference_crc(ref, initial, &data[offset], length))
+        {
+            cerr << name << ": mismatch at offset " << offset << ", length "
+                << length << ", initial value 0x" << hex << initial << dec
+                << endl;
+            return -1;
+        }
+    }
+
+    /* Streamed in random pieces. */
+    crc->setValue(0);
+    for (pos = 0; pos < data.size() / 2;)
+    {
+        uint32_t length = next_rand() % 5000;
+
+        crc->update(&data[pos], length);
+        pos += length;
+    }
+    if (crc->getValue() != reference_crc(ref, 0, &data[0], pos))
+    {
+        cerr << name << ": streamed CRC mismatch" << endl;
+        return -1;
+    }
+
+    /* Two chunks computed separately. */
+    for (i = 0; i < iterations / 20; i++)
+    {
+        uint32_t length1 = next_rand() % MAX_LENGTH;
+        uint32_t length2 = next_rand() % MAX_LENGTH;
+        uint32_t crc1 = crc->calculate(0, &data[0], length1);
+        uint32_t crc2 = crc->calculate(0, &data[length1], length2);
+
+        if (crc->combine(crc1, crc2, length2) !=
+                reference_crc(ref, 0, &data[0], length1 + length2))
+        {
+            cerr << name << ": combined CRC mismatch for lengths " << length1
+                << " and " << length2 << endl;
+            return -1;
+        }
+    }
+
+    cout << name << ": bit-exact" << endl;
+    return 0;
+}
+
+/**
+  * Returns the throughput of an engine, or of CalculateCrc() if @a crc is
+  * NULL, in MiB/s.
+  */
+static double
+benchmark_engine(NvCrc *crc, Crc *ref, unsigned char *data, size_t size)
+{
+    double start;
+    double elapsed;
+
+    start = now_seconds();
+    if (crc)
+    {
+        crc->setValue(0);
+        crc->update(data, size);
+    }
+    else
+    {
+        ref->CrcValue = 0;
+        CalculateCrc(ref, data, size);
+    }
+    elapsed = now_seconds() - start;
+
+    return size / elapsed / (1024 * 1024);
+}
+
+static void
+print_help()
+{
+    cout << "Usage: crc_sample [OPTIONS]" << endl << endl;
+    cout << "\t-s <size>    Size of the benchmark buffer in MiB [Default = "
+        << DEFAULT_SIZE_MIB << "]" << endl;
+    cout << "\t-n <count>   Random chunks checked per engine [Default = "
+        << DEFAULT_ITERATIONS << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const NvCrc::Engine engines[] = {
+        NvCrc::ENGINE_BYTEWISE,
+        NvCrc::ENGINE_SLICE_BY_8,
+        NvCrc::ENGINE_SLICE_BY_16,
+        NvCrc::ENGINE_ARMV8_CRC32,
+        NvCrc::ENGINE_ARMV8_PMULL,
+        NvCrc::ENGINE_X86_PCLMUL,
+        NvCrc::ENGINE_AUTO
+    };
+    uint64_t size_mib = DEFAULT_SIZE_MIB;
+    size_t size;
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    vector<unsigned char> data;
+    Crc *ref;
+    NvCrc *crc;
+    double reference_speed;
+    double auto_speed = 0;
+    uint32_t value;
+    uint32_t i;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                size_mib = strtoull(optarg, NULL, 10);
+                break;
+            case 'n':
+                iterations = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (size_mib == 0)
+    {
+        print_help();
+        return -1;
+    }
+
+    /* The checks read up to two chunks past the benchmark buffer. */
+    size = size_mib * 1024 * 1024;
+    data.resize(size + 2 * MAX_LENGTH);
+    for (i = 0; i < data.size(); i++)
+    {
+        data[i] = next_rand();
+    }
+
+    ref = InitCrc(NV_CRC32_POLYNOMIAL);
+    if (!ref)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    reference_speed = benchmark_engine(NULL, ref, &data[0], size);
+    cout << "CalculateCrc: " << reference_speed << " MiB/s" << endl;
+
+    for (i = 0; i < sizeof(engines) / sizeof(engines[0]) && ret == 0; i++)
+    {
+        double speed;
+
+        crc = NvCrc::createCrc(NV_CRC32_POLYNOMIAL, engines[i]);
+        if (!crc)
+        {
+            cout << NvCrc::getEngineName(engines[i]) <<
+                ": not supported by the CPU" << endl;
+            continue;
+        }
+
+        ret = check_engine(crc, ref, data, iterations);
+        if (ret == 0)
+        {
+            speed = benchmark_engine(crc, ref, &data[0], size);
+            if (engines[i] == NvCrc::ENGINE_AUTO)
+                auto_speed = speed;
+            cout << NvCrc::getEngineName(engines[i]);
+            if (engines[i] == NvCrc::ENGINE_AUTO)
+                cout << " (" << NvCrc::getEngineName(crc->getEngine()) << ")";
+            cout << ": " << speed << " MiB/s, " << speed / reference_speed <<
+                "x" << endl;
+        }
+        delete crc;
+    }
+
+    /* Any other polynomial goes through the tables. */
+    crc = NvCrc::createCrc(CRC32C_POLYNOMIAL);
+    value = ~crc->calculate(~0U, "123456789", 9);
+    if (ret == 0 && value != CRC32C_CHECK)
+    {
+        cerr << "CRC-32C check value 0x" << hex << value << dec << endl;
+        ret = -1;
+    }
+    delete crc;
+
+    if (ret == 0 && auto_speed < reference_speed)
+    {
+        cerr << "Default engine is slower than CalculateCrc" << endl;
+        ret = -1;
+    }
+
+    CloseCrc(&ref);
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
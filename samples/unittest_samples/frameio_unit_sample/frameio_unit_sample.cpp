@@ -0,0 +1,689 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./frameio_sample [-n frames]
+ * Example:
+ * ./frameio_sample
+ * ./frameio_sample -n 120
+**/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <linux/videodev2.h>
+
+#include "NvUtils.h"
+#include "NvBuffer.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of read_video_frame() and
+ * write_video_frame().
+ *
+ * Raw files of random frames are read into buffers whose planes are
+ * either packed or padded to a larger stride, through:
+ *
+ * - the row at a time stream reader read_video_frame() used before;
+ * - read_video_frame() with a stream, a plane per call;
+ * - read_video_frame() with a file descriptor, gathering rows with preadv;
+ * - the same with O_DIRECT, where the file system supports it.
+ *
+ * Every row must match the file, the padding must be left untouched, the
+ * file offset must advance by one frame, and the truncated frame at the end
+ * of the file must fail. The frames written back by write_video_frame()
+ * must reproduce the file.
+ *
+ * The read paths and both writers are then timed on YUV420, NV12 and P010
+ * files at 720p, 1080p and 4K, packed and padded, against the row at a
+ * time reader and writer used before. The files were just written, so all
+ * but O_DIRECT read from the page cache.
+ */
+
+#define FRAMEIO_PATH "frameio_sample.yuv"
+#define FRAMEIO_OUT_PATH "frameio_sample_out.yuv"
+
+#define CHECK_FRAMES 3
+#define DEFAULT_BENCHMARK_FRAMES 30
+#define STRIDE_ALIGNMENT 256
+#define PADDING_BYTE 0xA5
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef struct
+{
+    const char *name;
+    uint32_t pixfmt;
+    uint32_t width;
+    uint32_t height;
+} frame_format_t;
+
+typedef enum
+{
+    READ_ROWS,
+    READ_STREAM,
+    READ_PREADV,
+    READ_DIRECT,
+    READ_MODES
+} read_mode_t;
+
+static const char *read_mode_names[READ_MODES] =
+{
+    "row reader", "stream", "preadv", "O_DIRECT"
+};
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+  * read_video_frame() before it read a plane at a time.
+  */
+static int
+read_video_frame_rows(std::ifstream * stream, NvBuffer & buffer)
+{
+    uint32_t i, j;
+    char *data;
+
+    for (i = 0; i < buffer.n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = buffer.planes[i];
+        std::streamsize bytes_to_read =
+            plane.fmt.bytesperpixel * plane.fmt.width;
+        data = (char *) plane.data;
+        plane.bytesused = 0;
+        for (j = 0; j < plane.fmt.height; j++)
+        {
+            stream->read(data, bytes_to_read);
+            if (stream->gcount() < bytes_to_read)
+                return -1;
+            data += plane.fmt.stride;
+        }
+        plane.bytesused = plane.fmt.stride * plane.fmt.height;
+    }
+    return 0;
+}
+
+/**
+  * write_video_frame() before it wrote a plane at a time.
+  */
+static int
+write_video_frame_rows(std::ofstream * stream, NvBuffer &buffer)
+{
+    uint32_t i, j;
+    char *data;
+
+    for (i = 0; i < buffer.n_planes; i++)
+    {
+        NvBuffer::NvBufferPlane &plane = buffer.planes[i];
+        size_t bytes_to_write =
+            plane.fmt.bytesperpixel * plane.fmt.width;
+
+        data = (char *) plane.data;
+        for (j = 0; j < plane.fmt.height; j++)
+        {
+            stream->write(data, bytes_to_write);
+            if (!stream->good())
+                return -1;
+            data += plane.fmt.stride;
+        }
+    }
+    return 0;
+}
+
+/**
+  * Creates a buffer of the format, with planes padded to a stride aligned
+  * to STRIDE_ALIGNMENT and larger than the row when @a padded.
+  */
+static NvBuffer *
+create_buffer(const frame_format_t &format, bool padded)
+{
+    NvBuffer *buffer = new NvBuffer(format.pixfmt, format.width,
+            format.height, 0);
+
+    for (uint32_t i = 0; padded && i < buffer->n_planes; i++)
+    {
+        NvBuffer::NvBufferPlaneFormat &fmt = buffer->planes[i].fmt;
+
+        fmt.stride = (fmt.bytesperpixel * fmt.width + STRIDE_ALIGNMENT) &
+            ~(STRIDE_ALIGNMENT - 1);
+        fmt.sizeimage = fmt.stride * fmt.height;
+    }
+    if (buffer->allocateMemory() < 0)
+    {
+        cerr << "Could not allocate a " << format.name << " buffer" << endl;
+        delete buffer;
+        return NULL;
+    }
+    return buffer;
+}
+
+static uint64_t
+get_frame_size(const NvBuffer &buffer)
+{
+    uint64_t size = 0;
+
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        const NvBuffer::NvBufferPlaneFormat &fmt = buffer.planes[i].fmt;
+
+        size += (uint64_t) fmt.bytesperpixel * fmt.width * fmt.height;
+    }
+    return size;
+}
+
+static void
+clear_buffer(NvBuffer &buffer)
+{
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        memset(buffer.planes[i].data, PADDING_BYTE, buffer.planes[i].length);
+        buffer.planes[i].bytesused = 0;
+    }
+}
+
+/**
+  * Compares the rows of the buffer with the packed frame @a expected and
+  * checks that the padding was left untouched.
+  */
+static int
+check_frame(const NvBuffer &buffer, const uint8_t *expected)
+{
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        const NvBuffer::NvBufferPlane &plane = buffer.planes[i];
+        uint32_t row_bytes = plane.fmt.bytesperpixel * plane.fmt.width;
+        const uint8_t *row = plane.data;
+
+        CHECK(plane.bytesused == plane.fmt.stride * plane.fmt.height,
+                "plane " << i << " bytesused " << plane.bytesused);
+        for (uint32_t j = 0; j < plane.fmt.height; j++)
+        {
+            CHECK(!memcmp(row, expected, row_bytes),
+                    "plane " << i << " row " << j << " differs");
+            for (uint32_t k = row_bytes; k < plane.fmt.stride; k++)
+            {
+                CHECK(row[k] == PADDING_BYTE,
+                        "plane " << i << " row " << j << " padding overwritten");
+            }
+            row += plane.fmt.stride;
+            expected += row_bytes;
+        }
+    }
+    return 0;
+}
+
+static int
+write_file(const char *path, const vector<uint8_t> &file)
+{
+    ofstream out(path, ios::binary);
+
+    out.write((const char *) file.data(), file.size());
+    out.close();
+    CHECK(out, "Could not write " << path);
+    return 0;
+}
+
+/**
+  * Opens the file for @a mode. Returns 1 if O_DIRECT is not supported by
+  * the file system.
+  */
+static int
+open_reader(read_mode_t mode, ifstream &stream, int &fd)
+{
+    fd = -1;
+    switch (mode)
+    {
+        case READ_ROWS:
+        case READ_STREAM:
+            stream.open(FRAMEIO_PATH, ios::binary);
+            CHECK(stream, "Could not open " << FRAMEIO_PATH);
+            break;
+        case READ_PREADV:
+            fd = open(FRAMEIO_PATH, O_RDONLY);
+            CHECK(fd >= 0, "Could not open " << FRAMEIO_PATH);
+            break;
+        case READ_DIRECT:
+            fd = open(FRAMEIO_PATH, O_RDONLY | O_DIRECT);
+            if (fd < 0 && errno == EINVAL)
+            {
+                return 1;
+            }
+            CHECK(fd >= 0, "Could not open " << FRAMEIO_PATH <<
+                    " with O_DIRECT");
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static int
+read_frame(read_mode_t mode, ifstream &stream, int fd, off_t &offset,
+        NvBuffer &buffer)
+{
+    switch (mode)
+    {
+        case READ_ROWS:
+            return read_video_frame_rows(&stream, buffer);
+        case READ_STREAM:
+            return read_video_frame(&stream, buffer);
+        default:
+            return read_video_frame(fd, &offset, buffer);
+    }
+}
+
+/**
+  * Reads the file through every path, then writes the frames back.
+  * Sets @a direct_supported to false if O_DIRECT was skipped.
+  */
+static int
+check_format(const frame_format_t &format, bool padded, bool &direct_supported)
+{
+    NvBuffer *buffer = create_buffer(format, padded);
+    vector<uint8_t> file;
+    vector<uint8_t> written;
+    uint64_t frame_size;
+    int ret = 0;
+
+    if (!buffer)
+    {
+        return -1;
+    }
+    frame_size = get_frame_size(*buffer);
+
+    /* CHECK_FRAMES frames and half of one. */
+    file.resize(frame_size * CHECK_FRAMES + frame_size / 2);
+    for (size_t i = 0; i < file.size(); i++)
+    {
+        file[i] = next_rand();
+    }
+    if (write_file(FRAMEIO_PATH, file) < 0)
+    {
+        delete buffer;
+        return -1;
+    }
+
+    for (int mode = 0; mode < READ_MODES && ret == 0; mode++)
+    {
+        ifstream stream;
+        off_t offset = 0;
+        int fd;
+
+        ret = open_reader((read_mode_t) mode, stream, fd);
+        if (ret == 1)
+        {
+            direct_supported = false;
+            ret = 0;
+            continue;
+        }
+        for (uint32_t i = 0; i < CHECK_FRAMES && ret == 0; i++)
+        {
+            clear_buffer(*buffer);
+            if (read_frame((read_mode_t) mode, stream, fd, offset, *buffer) < 0 ||
+                (fd >= 0 && offset != (off_t) ((i + 1) * frame_size)))
+            {
+                cerr << "read failed or offset " << offset << " wrong" << endl;
+                ret = -1;
+            }
+            else
+            {
+                ret = check_frame(*buffer, file.data() + i * frame_size);
+            }
+            if (ret < 0)
+            {
+                cerr << format.name << (padded ? " padded" : " packed") <<
+                    ", " << read_mode_names[mode] << ": frame " << i <<
+                    " wrong" << endl;
+            }
+        }
+        if (ret == 0 &&
+            read_frame((read_mode_t) mode, stream, fd, offset, *buffer) == 0)
+        {
+            cerr << format.name << (padded ? " padded" : " packed") << ", " <<
+                read_mode_names[mode] << ": truncated frame read" << endl;
+            ret = -1;
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    if (ret == 0)
+    {
+        ifstream in(FRAMEIO_PATH, ios::binary);
+        ofstream out(FRAMEIO_OUT_PATH, ios::binary);
+
+        for (uint32_t i = 0; i < CHECK_FRAMES && ret == 0; i++)
+        {
+            if (read_video_frame(&in, *buffer) < 0 ||
+                write_video_frame(&out, *buffer) < 0)
+            {
+                ret = -1;
+            }
+        }
+        out.close();
+
+        ifstream check(FRAMEIO_OUT_PATH, ios::binary);
+        written.assign(istreambuf_iterator<char>(check),
+                istreambuf_iterator<char>());
+        if (ret < 0 || written.size() != frame_size * CHECK_FRAMES ||
+            memcmp(written.data(), file.data(), written.size()))
+        {
+            cerr << format.name << (padded ? " padded" : " packed") <<
+                ": written frames differ from the file" << endl;
+            ret = -1;
+        }
+    }
+    delete buffer;
+
+    if (ret == 0)
+    {
+        cout << format.name << (padded ? " padded" : " packed") << ": OK" <<
+            endl;
+    }
+    return ret;
+}
+
+static const frame_format_t check_formats[] =
+{
+    { "yuv420_720p", V4L2_PIX_FMT_YUV420M, 1280, 720 },
+    { "nv12_1080p", V4L2_PIX_FMT_NV12M, 1920, 1080 },
+    { "p010_4k", V4L2_PIX_FMT_P010M, 3840, 2160 },
+    { "yuv422_odd", V4L2_PIX_FMT_YUV422M, 999, 577 },
+    { "grey_odd", V4L2_PIX_FMT_GREY, 1367, 771 },
+};
+
+static int
+check_formats_all()
+{
+    bool direct_supported = true;
+
+    for (size_t i = 0; i < sizeof(check_formats) / sizeof(check_formats[0]);
+            i++)
+    {
+        if (check_format(check_formats[i], false, direct_supported) < 0 ||
+            check_format(check_formats[i], true, direct_supported) < 0)
+        {
+            return -1;
+        }
+    }
+    if (!direct_supported)
+    {
+        cout << "O_DIRECT is not supported by this file system, not checked" <<
+            endl;
+    }
+    return 0;
+}
+
+static const frame_format_t benchmark_formats[] =
+{
+    { "yuv420_720p", V4L2_PIX_FMT_YUV420M, 1280, 720 },
+    { "nv12_720p", V4L2_PIX_FMT_NV12M, 1280, 720 },
+    { "p010_720p", V4L2_PIX_FMT_P010M, 1280, 720 },
+    { "yuv420_1080p", V4L2_PIX_FMT_YUV420M, 1920, 1080 },
+    { "nv12_1080p", V4L2_PIX_FMT_NV12M, 1920, 1080 },
+    { "p010_1080p", V4L2_PIX_FMT_P010M, 1920, 1080 },
+    { "yuv420_4k", V4L2_PIX_FMT_YUV420M, 3840, 2160 },
+    { "nv12_4k", V4L2_PIX_FMT_NV12M, 3840, 2160 },
+    { "p010_4k", V4L2_PIX_FMT_P010M, 3840, 2160 },
+};
+
+/**
+  * Prints the rate of a path, and its speedup over the old path whose rate
+  * is @a base_rate, if any.
+  */
+static double
+print_rate(const char *what, uint64_t bytes, uint64_t nsec, double base_rate)
+{
+    double rate = bytes * 1000.0 / (nsec ? nsec : 1);
+
+    cout << "  " << what << ": " << rate << " MB/s";
+    if (base_rate > 0)
+    {
+        cout << " (" << rate / base_rate << "x)";
+    }
+    cout << endl;
+    return rate;
+}
+
+/**
+  * Times the read paths and both writers on @a num_frames frames of
+  * @a format, packed and padded. The speedups are given over the row at a
+  * time reader and writer.
+  */
+static int
+benchmark_format(const frame_format_t &format, uint32_t num_frames,
+        uint64_t &checksum)
+{
+    vector<uint8_t> file;
+    uint64_t frame_size;
+
+    for (int padded = 0; padded < 2; padded++)
+    {
+        NvBuffer *buffer = create_buffer(format, padded);
+        double base_rate = 0;
+        uint64_t t0;
+
+        if (!buffer)
+        {
+            return -1;
+        }
+        frame_size = get_frame_size(*buffer);
+        if (file.empty())
+        {
+            file.resize(frame_size * num_frames);
+            for (size_t i = 0; i < file.size(); i++)
+            {
+                file[i] = next_rand();
+            }
+            if (write_file(FRAMEIO_PATH, file) < 0)
+            {
+                delete buffer;
+                return -1;
+            }
+        }
+
+        cout << format.name << (padded ? " padded" : " packed") << ", " <<
+            num_frames << " frames:" << endl;
+        for (int mode = 0; mode < READ_MODES; mode++)
+        {
+            ifstream stream;
+            off_t offset = 0;
+            int fd;
+            int ret = open_reader((read_mode_t) mode, stream, fd);
+            double rate;
+
+            if (ret == 1)
+            {
+                continue;
+            }
+            t0 = now_nsec();
+            for (uint32_t i = 0; i < num_frames && ret == 0; i++)
+            {
+                ret = read_frame((read_mode_t) mode, stream, fd, offset,
+                        *buffer);
+                checksum += buffer->planes[0].data[i];
+            }
+            if (ret == 0)
+            {
+                rate = print_rate(read_mode_names[mode],
+                        frame_size * num_frames, now_nsec() - t0, base_rate);
+                if (mode == READ_ROWS)
+                {
+                    base_rate = rate;
+                }
+            }
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            if (ret < 0)
+            {
+                cerr << read_mode_names[mode] << " failed" << endl;
+                delete buffer;
+                return -1;
+            }
+        }
+
+        base_rate = 0;
+        for (int rows = 1; rows >= 0; rows--)
+        {
+            ofstream out(FRAMEIO_OUT_PATH, ios::binary);
+            int ret = 0;
+            double rate;
+
+            t0 = now_nsec();
+            for (uint32_t i = 0; i < num_frames && ret == 0; i++)
+            {
+                ret = rows ? write_video_frame_rows(&out, *buffer) :
+                    write_video_frame(&out, *buffer);
+            }
+            out.close();
+            if (ret < 0 || !out)
+            {
+                cerr << "Could not write " << FRAMEIO_OUT_PATH << endl;
+                delete buffer;
+                return -1;
+            }
+            rate = print_rate(rows ? "row writer" : "write_video_frame",
+                    frame_size * num_frames, now_nsec() - t0, base_rate);
+            if (rows)
+            {
+                base_rate = rate;
+            }
+        }
+        delete buffer;
+    }
+    return 0;
+}
+
+/**
+  * Times every benchmark format. @a num_frames is the number of 1080p
+  * frames, other resolutions get as many pixels in total.
+  */
+static int
+benchmark(uint32_t num_frames)
+{
+    uint64_t checksum = 0;
+
+    for (size_t i = 0;
+            i < sizeof(benchmark_formats) / sizeof(benchmark_formats[0]); i++)
+    {
+        const frame_format_t &format = benchmark_formats[i];
+        uint64_t frames = (uint64_t) num_frames * 1920 * 1080 /
+            (format.width * format.height);
+
+        if (benchmark_format(format, frames ? frames : 1, checksum) < 0)
+        {
+            return -1;
+        }
+    }
+    /* Keeps the reads from being optimized out. */
+    return checksum == 0 ? -1 : 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: frameio_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Frames of the 1080p benchmark files [Default = "
+        << DEFAULT_BENCHMARK_FRAMES << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_frames = DEFAULT_BENCHMARK_FRAMES;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_frames = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_frames < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_formats_all() < 0 || benchmark(num_frames) < 0)
+    {
+        ret = -1;
+    }
+    unlink(FRAMEIO_PATH);
+    unlink(FRAMEIO_OUT_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
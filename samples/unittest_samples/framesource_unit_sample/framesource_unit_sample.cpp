@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./framesource_sample [-n frames] [-d delay_usec] [-v]
+ * Example:
+ * ./framesource_sample
+ * ./framesource_sample -n 200 -d 5000
+**/
+
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/videodev2.h>
+
+#include "NvBuffer.h"
+#include "NvFrameSource.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvFrameSource.
+ *
+ * Raw files are written with a pattern that identifies the frame, plane,
+ * row and column of every byte, after a header skipped with the start
+ * offset and before a partial frame, and read into a buffer whose planes
+ * are padded to a larger stride:
+ *
+ * - order: 1 to 8 prefetch threads whose reads complete out of order must
+ *   deliver every frame once, in order, and then the end of the file;
+ * - loop: the frames must repeat and the rewinds be counted;
+ * - truncated: the file is truncated while it is read ahead, the frames
+ *   still in it must be delivered, then the error;
+ * - error: a read error must be delivered at its frame;
+ * - starvation: a consumer slower than the reads must not wait after the
+ *   first frame, while one faster than the reads must wait for most
+ *   frames, less with more prefetch threads.
+ *
+ * The positioned reads of the sample are wrapped to delay them and inject
+ * errors.
+ */
+
+#define FILE_PATH "framesource_sample.yuv"
+#define WIDTH 64
+#define HEIGHT 48
+#define STRIDE_ALIGNMENT 128
+#define HEADER_SIZE 37
+#define DEFAULT_NUM_FRAMES 60
+#define DEFAULT_DELAY_USEC 2000
+#define NUM_FRAMES_AHEAD 4
+#define MAX_THREADS 8
+/* Random extra delay of the reads in the order check. */
+#define ORDER_JITTER_USEC 300
+#define LOOP_FRAMES 7
+#define LOOP_COUNT 5
+#define TRUNCATED_FRAMES 20
+#define TRUNCATE_AT 10
+#define CANARY 0xA5
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/* Delay of each read and of its jitter, in microseconds. */
+static atomic<uint32_t> read_delay_usec(0);
+static atomic<uint32_t> read_jitter_usec(0);
+/* Offset in the file at which reads fail with EIO, 0 if none. */
+static atomic<uint64_t> fail_offset(0);
+
+/**
+ * Wraps the positioned reads of NvFrameSource, delayed by the delay and a
+ * pseudo-random part of the jitter picked by the offset, so that the reads
+ * of the prefetch threads complete out of order.
+ */
+extern "C" ssize_t
+pread(int fd, void *buf, size_t count, off_t offset)
+{
+    uint64_t delay = read_delay_usec.load();
+    uint32_t jitter = read_jitter_usec.load();
+    uint64_t fail = fail_offset.load();
+
+    if (jitter)
+    {
+        delay += ((uint64_t) offset * 2654435761ULL >> 16) % jitter;
+    }
+    if (delay)
+    {
+        usleep(delay);
+    }
+    if (fail && (uint64_t) offset <= fail && fail < offset + count)
+    {
+        errno = EIO;
+        return -1;
+    }
+    return syscall(SYS_pread64, fd, buf, count, offset);
+}
+
+/* Byte at column @a k of row @a r of plane @a p of frame @a f. The frame
+   multiplier is odd, so 256 frames in a row differ. */
+static inline unsigned char
+pattern(uint32_t f, uint32_t p, uint32_t r, uint32_t k)
+{
+    return f * 131 + p * 57 + r * 7 + k;
+}
+
+/**
+ * Writes @a num_frames frames of the layout of @a buffer, after a header
+ * and followed by part of a frame.
+ */
+static int
+write_file(const NvBuffer &buffer, uint32_t num_frames)
+{
+    vector<unsigned char> data(HEADER_SIZE, 0xFF);
+    int fd;
+
+    for (uint32_t f = 0; f < num_frames; f++)
+    {
+        for (uint32_t p = 0; p < buffer.n_planes; p++)
+        {
+            const NvBuffer::NvBufferPlaneFormat &fmt = buffer.planes[p].fmt;
+
+            for (uint32_t r = 0; r < fmt.height; r++)
+            {
+                for (uint32_t k = 0; k < fmt.width * fmt.bytesperpixel; k++)
+                    data.push_back(pattern(f, p, r, k));
+            }
+        }
+    }
+    /* Not a whole frame, must be ignored. */
+    data.insert(data.end(), 100, 0xFF);
+
+    fd = open(FILE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CHECK(fd >= 0, "Could not create " << FILE_PATH);
+    if (write(fd, &data[0], data.size()) != (ssize_t) data.size())
+    {
+        cerr << "Could not write " << FILE_PATH << endl;
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+/**
+ * Checks that @a buffer holds frame @a f, with its padding untouched.
+ */
+static int
+check_frame(const NvBuffer &buffer, uint32_t f, const char *name)
+{
+    for (uint32_t p = 0; p < buffer.n_planes; p++)
+    {
+        const NvBuffer::NvBufferPlane &plane = buffer.planes[p];
+        uint32_t row_bytes = plane.fmt.width * plane.fmt.bytesperpixel;
+
+        CHECK(plane.bytesused == plane.fmt.stride * plane.fmt.height,
+                name << ": wrong bytesused of plane " << p);
+        for (uint32_t r = 0; r < plane.fmt.height; r++)
+        {
+            const unsigned char *row = plane.data + r * plane.fmt.stride;
+
+            for (uint32_t k = 0; k < row_bytes; k++)
+            {
+                CHECK(row[k] == pattern(f, p, r, k), name <<
+                        ": frame " << f << " expected, plane " << p <<
+                        " row " << r << " column " << k << " differs");
+            }
+            for (uint32_t k = row_bytes; k < plane.fmt.stride; k++)
+            {
+                CHECK(row[k] == CANARY, name << ": padding of plane " << p <<
+                        " row " << r << " overwritten");
+            }
+        }
+    }
+    return 0;
+}
+
+static int
+check_order(NvBuffer &buffer, uint32_t num_frames)
+{
+    CHECK(write_file(buffer, num_frames) == 0, "order: no file");
+    read_jitter_usec = ORDER_JITTER_USEC;
+    for (uint32_t num_threads = 1; num_threads <= MAX_THREADS;
+            num_threads *= 2)
+    {
+        NvFrameSource::NvFrameSourceStats stats;
+        NvFrameSource *source = NvFrameSource::createFrameSource("order",
+                FILE_PATH, buffer, HEADER_SIZE, NUM_FRAMES_AHEAD * 2, false,
+                num_threads);
+        uint32_t f;
+
+        CHECK(source, "order: could not create the frame source");
+        for (f = 0; source->readFrame(buffer) == 0; f++)
+        {
+            if (check_frame(buffer, f, "order") < 0)
+            {
+                delete source;
+                return -1;
+            }
+        }
+        source->getStats(stats);
+        CHECK(f == num_frames && !source->isInError() &&
+                stats.frames_read == num_frames && stats.num_loops == 0,
+                "order: " << f << " frames read for " << num_frames <<
+                " with " << num_threads << " threads");
+        /* The end of the file stays reported. */
+        CHECK(source->readFrame(buffer) < 0, "order: frame after the end");
+        delete source;
+    }
+    read_jitter_usec = 0;
+    cout << "order: OK" << endl;
+    return 0;
+}
+
+static int
+check_loop(NvBuffer &buffer)
+{
+    NvFrameSource::NvFrameSourceStats stats;
+    NvFrameSource *source;
+    uint32_t num_reads = LOOP_FRAMES * LOOP_COUNT + 3;
+
+    CHECK(write_file(buffer, LOOP_FRAMES) == 0, "loop: no file");
+    source = NvFrameSource::createFrameSource("loop", FILE_PATH, buffer,
+            HEADER_SIZE, NUM_FRAMES_AHEAD, true, 3);
+    CHECK(source, "loop: could not create the frame source");
+    for (uint32_t i = 0; i < num_reads; i++)
+    {
+        if (source->readFrame(buffer) < 0 ||
+                check_frame(buffer, i % LOOP_FRAMES, "loop") < 0)
+        {
+            cerr << "loop: read " << i << " failed" << endl;
+            delete source;
+            return -1;
+        }
+    }
+    source->getStats(stats);
+    delete source;
+    CHECK(stats.frames_read == num_reads && stats.num_loops == LOOP_COUNT,
+            "loop: " << stats.num_loops << " loops in " << stats.frames_read <<
+            " frames for " << LOOP_COUNT);
+    cout << "loop: OK" << endl;
+    return 0;
+}
+
+static int
+check_truncated(NvBuffer &buffer)
+{
+    NvFrameSource *source;
+    uint64_t frame_size = 0;
+    uint32_t f;
+
+    for (uint32_t p = 0; p < buffer.n_planes; p++)
+    {
+        frame_size += buffer.planes[p].fmt.width *
+            buffer.planes[p].fmt.bytesperpixel * buffer.planes[p].fmt.height;
+    }
+    CHECK(write_file(buffer, TRUNCATED_FRAMES) == 0, "truncated: no file");
+    CHECK(NvFrameSource::createFrameSource("missing", "/nonexistent.yuv",
+                buffer) == NULL, "truncated: missing file opened");
+
+    /* The frames read ahead are all before the new end of the file. */
+    source = NvFrameSource::createFrameSource("truncated", FILE_PATH,
+            buffer, HEADER_SIZE, NUM_FRAMES_AHEAD, false, 2);
+    CHECK(source, "truncated: could not create the frame source");
+    for (f = 0; f < TRUNCATE_AT - NUM_FRAMES_AHEAD - 1; f++)
+    {
+        if (source->readFrame(buffer) < 0 ||
+                check_frame(buffer, f, "truncated") < 0)
+        {
+            delete source;
+            return -1;
+        }
+    }
+    if (truncate(FILE_PATH, HEADER_SIZE + TRUNCATE_AT * frame_size) < 0)
+    {
+        cerr << "truncated: could not truncate " << FILE_PATH << endl;
+        delete source;
+        return -1;
+    }
+    for (; source->readFrame(buffer) == 0; f++)
+    {
+        if (check_frame(buffer, f, "truncated") < 0)
+        {
+            delete source;
+            return -1;
+        }
+    }
+    CHECK(f == TRUNCATE_AT && source->isInError(), "truncated: " << f <<
+            " frames read for " << TRUNCATE_AT);
+    CHECK(source->readFrame(buffer) < 0, "truncated: frame after the error");
+    delete source;
+    cout << "truncated: OK" << endl;
+    return 0;
+}
+
+static int
+check_error(NvBuffer &buffer, uint32_t num_frames)
+{
+    NvFrameSource *source;
+    uint64_t frame_size = 0;
+    uint32_t fail_frame = num_frames / 2;
+    uint32_t f;
+
+    for (uint32_t p = 0; p < buffer.n_planes; p++)
+    {
+        frame_size += buffer.planes[p].fmt.width *
+            buffer.planes[p].fmt.bytesperpixel * buffer.planes[p].fmt.height;
+    }
+    CHECK(write_file(buffer, num_frames) == 0, "error: no file");
+    fail_offset = HEADER_SIZE + fail_frame * frame_size + frame_size / 2;
+    source = NvFrameSource::createFrameSource("error", FILE_PATH, buffer,
+            HEADER_SIZE, NUM_FRAMES_AHEAD, false, 4);
+    if (!source)
+    {
+        fail_offset = 0;
+        cerr << "error: could not create the frame source" << endl;
+        return -1;
+    }
+    for (f = 0; source->readFrame(buffer) == 0; f++)
+    {
+        if (check_frame(buffer, f, "error") < 0)
+        {
+            fail_offset = 0;
+            delete source;
+            return -1;
+        }
+    }
+    fail_offset = 0;
+    CHECK(f == fail_frame && source->isInError(), "error: " << f <<
+            " frames read before the error at " << fail_frame);
+    delete source;
+    cout << "error: OK" << endl;
+    return 0;
+}
+
+/**
+ * Reads @a num_frames frames with reads delayed by @a delay_usec, sleeping
+ * @a consumer_usec between frames, and returns the stats.
+ */
+static int
+run_starvation(NvBuffer &buffer, uint32_t num_frames, uint32_t num_threads,
+        uint32_t delay_usec, uint32_t consumer_usec,
+        NvFrameSource::NvFrameSourceStats &stats)
+{
+    NvFrameSource *source;
+
+    read_delay_usec = delay_usec;
+    source = NvFrameSource::createFrameSource("starvation", FILE_PATH, buffer,
+            HEADER_SIZE, NUM_FRAMES_AHEAD, false, num_threads);
+    if (!source)
+    {
+        read_delay_usec = 0;
+        cerr << "starvation: could not create the frame source" << endl;
+        return -1;
+    }
+    for (uint32_t f = 0; f < num_frames; f++)
+    {
+        if (source->readFrame(buffer) < 0)
+        {
+            read_delay_usec = 0;
+            delete source;
+            cerr << "starvation: read " << f << " failed" << endl;
+            return -1;
+        }
+        if (consumer_usec)
+            usleep(consumer_usec);
+    }
+    source->getStats(stats);
+    delete source;
+    read_delay_usec = 0;
+
+    cout << "starvation: " << num_threads << " threads, reads of " <<
+        delay_usec << " us, consumer sleeping " << consumer_usec << " us: " <<
+        stats.starvation_count << " waits, " << stats.starvation_time_usec <<
+        " us, max " << stats.max_starvation_usec << " us" << endl;
+    CHECK(stats.frames_read == num_frames &&
+            stats.starvation_count <= num_frames &&
+            stats.max_starvation_usec <= stats.starvation_time_usec &&
+            (stats.starvation_count > 0 || stats.starvation_time_usec == 0),
+            "starvation: inconsistent stats");
+    return 0;
+}
+
+static int
+check_starvation(NvBuffer &buffer, uint32_t num_frames, uint32_t delay_usec)
+{
+    NvFrameSource::NvFrameSourceStats slow, fast_1, fast_n;
+
+    CHECK(write_file(buffer, num_frames) == 0, "starvation: no file");
+
+    /* Reads twice as fast as the consumer, only the first frame waits. */
+    CHECK(run_starvation(buffer, num_frames, 1, delay_usec / 2, delay_usec,
+                slow) == 0, "starvation: slow consumer failed");
+    CHECK(slow.starvation_count <= 1, "starvation: " <<
+            slow.starvation_count << " waits of a slow consumer");
+
+    /* A consumer that does not wait sees the read time of most frames. */
+    CHECK(run_starvation(buffer, num_frames, 1, delay_usec, 0, fast_1) == 0,
+            "starvation: fast consumer failed");
+    CHECK(fast_1.starvation_count >= num_frames / 2 &&
+            fast_1.starvation_time_usec >=
+            (uint64_t) (num_frames - NUM_FRAMES_AHEAD) * delay_usec / 2 &&
+            fast_1.max_starvation_usec >= delay_usec / 2,
+            "starvation: fast consumer did not wait for the reads");
+
+    CHECK(run_starvation(buffer, num_frames, NUM_FRAMES_AHEAD, delay_usec, 0,
+                fast_n) == 0, "starvation: fast consumer failed");
+    CHECK(fast_n.starvation_time_usec < fast_1.starvation_time_usec,
+            "starvation: " << NUM_FRAMES_AHEAD << " threads waited " <<
+            fast_n.starvation_time_usec << " us, 1 thread " <<
+            fast_1.starvation_time_usec << " us");
+    cout << "starvation: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: framesource_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Frames in the file [Default = "
+        << DEFAULT_NUM_FRAMES << "]" << endl;
+    cout << "\t-d <usec>    Read delay of the starvation check [Default = "
+        << DEFAULT_DELAY_USEC << "]" << endl;
+    cout << "\t-v           Print the expected errors" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_frames = DEFAULT_NUM_FRAMES;
+    uint32_t delay_usec = DEFAULT_DELAY_USEC;
+    NvBuffer buffer(V4L2_PIX_FMT_YUV420M, WIDTH, HEIGHT, 0);
+    int ret = 0;
+    int opt;
+
+    /* The truncated file and the read error are logged as errors. */
+    log_level = LOG_LEVEL_INFO;
+    while ((opt = getopt(argc, argv, "n:d:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_frames = atoi(optarg);
+                break;
+            case 'd':
+                delay_usec = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_DEBUG;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_frames < 2 * NUM_FRAMES_AHEAD || num_frames > 256 ||
+            delay_usec < 100)
+    {
+        print_help();
+        return -1;
+    }
+
+    /* Planes padded past their rows, the padding must stay untouched. */
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        NvBuffer::NvBufferPlaneFormat &fmt = buffer.planes[i].fmt;
+
+        fmt.stride = (fmt.bytesperpixel * fmt.width + STRIDE_ALIGNMENT) &
+            ~(STRIDE_ALIGNMENT - 1);
+        fmt.sizeimage = fmt.stride * fmt.height;
+    }
+    if (buffer.allocateMemory() < 0)
+    {
+        cerr << "Could not allocate the buffer" << endl;
+        return -1;
+    }
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        memset(buffer.planes[i].data, CANARY, buffer.planes[i].fmt.sizeimage);
+    }
+
+    if (check_order(buffer, num_frames) < 0 || check_loop(buffer) < 0 ||
+            check_truncated(buffer) < 0 || check_error(buffer, num_frames) < 0 ||
+            check_starvation(buffer, num_frames, delay_usec) < 0)
+    {
+        ret = -1;
+    }
+    unlink(FILE_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
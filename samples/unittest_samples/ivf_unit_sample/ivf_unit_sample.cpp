@@ -0,0 +1,793 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./ivf_sample [-n frames] [-v]
+ * Example:
+ * ./ivf_sample
+ * ./ivf_sample -n 100000
+**/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "NvIvfReader.h"
+#include "NvLogging.h"
+#include "NvBuffer.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of NvIvfReader.
+ *
+ * Synthetic VP8, VP9 and AV1 IVF files are built along with the list of
+ * their frames: VP8 frame tags, VP9 uncompressed headers of all profiles
+ * with superframes and show_existing_frame, and AV1 temporal units with
+ * OBU extensions and OBUs without a size field. Each file is read back:
+ *
+ * - the index holds the offset, size, pts and key frame flag of every
+ *   frame, and both readNextFrame() and getNextFrame() return its bytes;
+ * - the reader rewinds on end of stream, seeks to key frames, and rejects
+ *   a buffer too small for a frame without advancing;
+ * - a truncated last frame is dropped and a file without the DKIF
+ *   signature is rejected;
+ * - on well formed files, the frames are the ones the ifstream reader the
+ *   decoder samples used before returns.
+ *
+ * The index, readNextFrame(), getNextFrame() and the ifstream reader are
+ * then timed on a larger VP9 file.
+ */
+
+#define IVF_PATH "ivf_sample.ivf"
+
+#define IVF_FILE_HDR_SIZE   32
+#define IVF_FRAME_HDR_SIZE  12
+
+#define BUFFER_SIZE (1 << 20)
+#define DEFAULT_BENCHMARK_FRAMES 10000
+#define BENCHMARK_LOOPS 3
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/**
+ * Frame of a synthetic file.
+ */
+typedef struct
+{
+    vector<uint8_t> data;
+    uint64_t pts;
+    bool key_frame;
+} expected_frame_t;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+put_le16(vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(value);
+    out.push_back(value >> 8);
+}
+
+static void
+put_le32(vector<uint8_t> &out, uint32_t value)
+{
+    put_le16(out, value);
+    put_le16(out, value >> 16);
+}
+
+static void
+put_le64(vector<uint8_t> &out, uint64_t value)
+{
+    put_le32(out, value);
+    put_le32(out, value >> 32);
+}
+
+static void
+put_leb128(vector<uint8_t> &out, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(byte | (value ? 0x80 : 0));
+    } while (value);
+}
+
+static void
+put_random(vector<uint8_t> &out, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        out.push_back(next_rand());
+    }
+}
+
+static uint32_t
+random_size(uint32_t max_size)
+{
+    /* Mostly small inter frames, some large ones. */
+    return next_rand() % 8 ? 1 + next_rand() % (max_size / 16) :
+        1 + next_rand() % max_size;
+}
+
+/**
+  * VP8 frame: 3 byte frame tag, then the key frame start code and size.
+  */
+static vector<uint8_t>
+build_vp8_frame(bool key_frame, uint32_t max_size)
+{
+    vector<uint8_t> frame;
+
+    /* key_frame 0 for key frames, version, show_frame. */
+    frame.push_back((key_frame ? 0x00 : 0x01) | ((next_rand() % 4) << 1) |
+            0x10);
+    frame.push_back(next_rand());
+    frame.push_back(next_rand());
+    if (key_frame)
+    {
+        frame.push_back(0x9d);
+        frame.push_back(0x01);
+        frame.push_back(0x2a);
+        put_le16(frame, 1920);
+        put_le16(frame, 1080);
+    }
+    put_random(frame, random_size(max_size));
+    return frame;
+}
+
+/**
+  * VP9 frame: first byte of the uncompressed header, then random bytes.
+  */
+static vector<uint8_t>
+build_vp9_frame(uint32_t profile, bool key_frame, bool show_existing,
+        uint32_t max_size)
+{
+    vector<uint8_t> frame;
+    uint32_t bits = 0x2;
+    uint32_t num_bits = 2;
+
+    /* frame_marker, profile_low_bit, profile_high_bit, reserved_zero. */
+    bits = (bits << 2) | ((profile & 1) << 1) | (profile >> 1);
+    num_bits += 2;
+    if (profile == 3)
+    {
+        bits <<= 1;
+        num_bits++;
+    }
+    /* show_existing_frame, then frame_type, show_frame, error_resilient. */
+    bits = (bits << 1) | show_existing;
+    num_bits++;
+    if (!show_existing)
+    {
+        bits = (bits << 3) | ((key_frame ? 0 : 1) << 2) | 0x2;
+        num_bits += 3;
+    }
+    while (num_bits < 8)
+    {
+        bits = (bits << 1) | (next_rand() & 1);
+        num_bits++;
+    }
+    frame.push_back(bits >> (num_bits - 8));
+    if (!show_existing)
+    {
+        put_random(frame, random_size(max_size));
+    }
+    return frame;
+}
+
+/**
+  * VP9 superframe of @a count frames, classified by its first frame.
+  */
+static vector<uint8_t>
+build_vp9_superframe(uint32_t profile, bool key_frame, uint32_t count,
+        uint32_t max_size)
+{
+    vector<uint8_t> frame;
+    vector<uint32_t> sizes;
+    uint8_t marker = 0xC0 | (3 << 3) | (count - 1);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vector<uint8_t> sub = build_vp9_frame(profile, key_frame && i == 0,
+                false, max_size);
+
+        sizes.push_back(sub.size());
+        frame.insert(frame.end(), sub.begin(), sub.end());
+    }
+    frame.push_back(marker);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        put_le32(frame, sizes[i]);
+    }
+    frame.push_back(marker);
+    return frame;
+}
+
+/**
+  * AV1 temporal unit: temporal delimiter, sequence header on key frames,
+  * frame OBU. Some OBUs carry an extension, the last one may have no
+  * size field.
+  */
+static vector<uint8_t>
+build_av1_temporal_unit(bool key_frame, uint32_t max_size)
+{
+    vector<uint8_t> unit;
+    vector<uint8_t> payload;
+    bool extension = next_rand() % 4 == 0;
+    bool last_has_size = next_rand() % 3 != 0;
+
+    unit.push_back(0x12);
+    unit.push_back(0x00);
+
+    /* A metadata OBU with an extension header before the sequence header. */
+    if (extension)
+    {
+        unit.push_back((5 << 3) | 0x04 | 0x02);
+        unit.push_back(0x08);
+        put_random(payload, 1 + next_rand() % 20);
+        put_leb128(unit, payload.size());
+        unit.insert(unit.end(), payload.begin(), payload.end());
+    }
+    if (key_frame)
+    {
+        payload.clear();
+        put_random(payload, 10 + next_rand() % 10);
+        unit.push_back((1 << 3) | 0x02);
+        put_leb128(unit, payload.size());
+        unit.insert(unit.end(), payload.begin(), payload.end());
+    }
+
+    payload.clear();
+    put_random(payload, random_size(max_size));
+    unit.push_back((6 << 3) | (last_has_size ? 0x02 : 0));
+    if (last_has_size)
+    {
+        put_leb128(unit, payload.size());
+    }
+    unit.insert(unit.end(), payload.begin(), payload.end());
+    return unit;
+}
+
+/**
+  * Builds an IVF file of @a num_frames frames with a key frame every
+  * @a gop frames. @a profile only applies to VP9.
+  */
+static void
+build_ivf(const char *fourcc, uint32_t profile, uint32_t num_frames,
+        uint32_t gop, uint32_t header_size, uint32_t max_size,
+        vector<uint8_t> &file, vector<expected_frame_t> &expected)
+{
+    uint64_t pts = next_rand() % 1000;
+
+    file.assign("DKIF", "DKIF" + 4);
+    put_le16(file, 0);
+    put_le16(file, header_size);
+    file.insert(file.end(), fourcc, fourcc + 4);
+    put_le16(file, 1920);
+    put_le16(file, 1080);
+    put_le32(file, 30000);
+    put_le32(file, 1001);
+    put_le32(file, num_frames);
+    put_le32(file, 0);
+    file.resize(header_size, 0);
+
+    expected.clear();
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        expected_frame_t frame;
+        bool key_frame = i % gop == 0;
+
+        if (!strncmp(fourcc, "VP80", 4))
+        {
+            frame.data = build_vp8_frame(key_frame, max_size);
+        }
+        else if (!strncmp(fourcc, "VP90", 4))
+        {
+            if (!key_frame && next_rand() % 10 == 0)
+            {
+                frame.data = build_vp9_frame(profile, false, true, max_size);
+            }
+            else if (next_rand() % 5 == 0)
+            {
+                frame.data = build_vp9_superframe(profile, key_frame,
+                        2 + next_rand() % 3, max_size);
+            }
+            else
+            {
+                frame.data = build_vp9_frame(profile, key_frame, false,
+                        max_size);
+            }
+        }
+        else
+        {
+            frame.data = build_av1_temporal_unit(key_frame, max_size);
+        }
+        frame.key_frame = key_frame;
+        frame.pts = pts;
+        pts += 1 + next_rand() % 2;
+
+        put_le32(file, frame.data.size());
+        put_le64(file, frame.pts);
+        file.insert(file.end(), frame.data.begin(), frame.data.end());
+        expected.push_back(frame);
+    }
+}
+
+static int
+write_file(const vector<uint8_t> &file)
+{
+    ofstream out(IVF_PATH, ios::binary);
+
+    out.write((const char *) file.data(), file.size());
+    out.close();
+    CHECK(out, "Could not write " << IVF_PATH);
+    return 0;
+}
+
+/**
+  * The IVF reader of the decoder samples before NvIvfReader: the file
+  * header, then each frame header and frame, through ifstream reads.
+  */
+static int
+read_ivf_frame_ifstream(ifstream *stream, bool &header_read, NvBuffer *buffer)
+{
+    int Framesize;
+    unsigned char *bitstreambuffer = (unsigned char *)buffer->planes[0].data;
+    if (!header_read)
+    {
+        stream->read((char *) buffer->planes[0].data, IVF_FILE_HDR_SIZE);
+        if (stream->gcount() !=  IVF_FILE_HDR_SIZE)
+        {
+            cerr << "Couldn't read IVF FILE HEADER" << endl;
+            return -1;
+        }
+        if (!((bitstreambuffer[0] == 'D') && (bitstreambuffer[1] == 'K') &&
+                    (bitstreambuffer[2] == 'I') && (bitstreambuffer[3] == 'F')))
+        {
+            cerr << "It's not a valid IVF file \n" << endl;
+            return -1;
+        }
+        header_read = true;
+    }
+    stream->read((char *) buffer->planes[0].data, IVF_FRAME_HDR_SIZE);
+
+    if (!stream->gcount())
+    {
+        buffer->planes[0].bytesused = 0;
+        return 0;
+    }
+
+    if (stream->gcount() != IVF_FRAME_HDR_SIZE)
+    {
+        cerr << "Couldn't read IVF FRAME HEADER" << endl;
+        return -1;
+    }
+    Framesize = (bitstreambuffer[3]<<24) + (bitstreambuffer[2]<<16) +
+        (bitstreambuffer[1]<<8) + bitstreambuffer[0];
+    buffer->planes[0].bytesused = Framesize;
+    stream->read((char *) buffer->planes[0].data, Framesize);
+    if (stream->gcount() != Framesize)
+    {
+        cerr << "Couldn't read Framesize" << endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+  * Reads the file back and compares every frame with @a expected.
+  */
+static int
+check_reader(const char *name, const vector<expected_frame_t> &expected,
+        uint32_t header_size)
+{
+    NvIvfReader *reader = NvIvfReader::createIvfReader(IVF_PATH);
+    const NvIvfReader::NvIvfFrame *frame;
+    NvBuffer buffer(BUFFER_SIZE, 0);
+    uint64_t offset = header_size + IVF_FRAME_HDR_SIZE;
+    int64_t last_key = -1;
+    int64_t second_key = -1;
+    uint32_t num_keys = 0;
+    uint32_t loop, i;
+
+    CHECK(reader, name << ": could not open the file");
+    CHECK(buffer.allocateMemory() == 0, "Could not allocate the buffer");
+    CHECK(reader->getNumFrames() == expected.size() &&
+            reader->getWidth() == 1920 && reader->getHeight() == 1080,
+            name << ": indexed " << reader->getNumFrames() << " frames, expected "
+            << expected.size());
+
+    for (i = 0; i < expected.size(); i++)
+    {
+        const NvIvfReader::NvIvfFrame &entry = reader->getFrame(i);
+
+        CHECK(entry.offset == offset && entry.size == expected[i].data.size() &&
+                entry.pts == expected[i].pts &&
+                entry.key_frame == expected[i].key_frame,
+                name << ": frame " << i << " indexed at " << entry.offset <<
+                ", size " << entry.size << ", pts " << entry.pts << ", key " <<
+                entry.key_frame);
+        offset += entry.size + IVF_FRAME_HDR_SIZE;
+        if (entry.key_frame)
+        {
+            num_keys++;
+            second_key = num_keys == 2 ? i : second_key;
+        }
+    }
+
+    /* The reader rewinds itself on end of stream. */
+    for (loop = 0; loop < 2; loop++)
+    {
+        for (i = 0; i < expected.size(); i++)
+        {
+            const vector<uint8_t> &data = expected[i].data;
+            const uint8_t *span;
+            uint32_t size;
+
+            CHECK(reader->readNextFrame(&buffer, &frame) == 0 && frame &&
+                    buffer.planes[0].bytesused == data.size() &&
+                    !memcmp(buffer.planes[0].data, data.data(), data.size()),
+                    name << ": readNextFrame differs at frame " << i);
+            CHECK(reader->seek(i) == 0, name << ": seek to " << i << " failed");
+            span = reader->getNextFrame(size, &frame);
+            CHECK(span && frame && size == data.size() &&
+                    !memcmp(span, data.data(), size),
+                    name << ": getNextFrame differs at frame " << i);
+        }
+        CHECK(reader->readNextFrame(&buffer, &frame) == 0 && !frame &&
+                buffer.planes[0].bytesused == 0 && reader->getPosition() == 0,
+                name << ": end of stream not reported");
+    }
+
+    for (i = 0; i < expected.size(); i++)
+    {
+        if (expected[i].key_frame)
+        {
+            last_key = i;
+        }
+        CHECK(reader->seekToKeyFrame(i) == (last_key < 0 ? 0 : last_key) &&
+                reader->getPosition() == (uint64_t) (last_key < 0 ? 0 : last_key),
+                name << ": seekToKeyFrame(" << i << ") failed");
+    }
+    CHECK(reader->seek(expected.size()) == -1 &&
+            reader->seekToKeyFrame(expected.size()) == -1,
+            name << ": seek past the end accepted");
+
+    reader->rewind();
+    buffer.planes[0].length = expected[0].data.size() - 1;
+    CHECK(reader->readNextFrame(&buffer) == -1 && reader->getPosition() == 0,
+            name << ": buffer too small not rejected");
+    buffer.planes[0].length = BUFFER_SIZE;
+    delete reader;
+
+    cout << name << ": " << expected.size() << " frames, " << num_keys <<
+        " key frames: OK" << endl;
+    return 0;
+}
+
+/**
+  * Compares the frames of NvIvfReader with the ifstream reader.
+  */
+static int
+check_ifstream_equivalence(const char *name, uint32_t num_frames)
+{
+    NvIvfReader *reader = NvIvfReader::createIvfReader(IVF_PATH);
+    ifstream stream(IVF_PATH, ios::binary);
+    NvBuffer old_buffer(BUFFER_SIZE, 0);
+    NvBuffer new_buffer(BUFFER_SIZE, 0);
+    bool header_read = false;
+    uint32_t i;
+
+    CHECK(reader, name << ": could not open the file");
+    CHECK(old_buffer.allocateMemory() == 0 && new_buffer.allocateMemory() == 0,
+            "Could not allocate the buffers");
+    for (i = 0; i <= num_frames; i++)
+    {
+        CHECK(read_ivf_frame_ifstream(&stream, header_read, &old_buffer) == 0 &&
+                reader->readNextFrame(&new_buffer) == 0, name <<
+                ": read failed at frame " << i);
+        CHECK(old_buffer.planes[0].bytesused == new_buffer.planes[0].bytesused &&
+                !memcmp(old_buffer.planes[0].data, new_buffer.planes[0].data,
+                    new_buffer.planes[0].bytesused),
+                name << ": frame " << i << " differs from the ifstream reader");
+    }
+    CHECK(old_buffer.planes[0].bytesused == 0, name <<
+            ": ifstream reader did not end with the file");
+    delete reader;
+    return 0;
+}
+
+/**
+  * Files the reader must reject or trim.
+  */
+static int
+check_malformed()
+{
+    vector<expected_frame_t> expected;
+    vector<uint8_t> file;
+    NvIvfReader *reader;
+
+    /* Truncated last frame, dropped. */
+    build_ivf("VP80", 0, 10, 5, IVF_FILE_HDR_SIZE, 1000, file, expected);
+    file.resize(file.size() - 1);
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    reader = NvIvfReader::createIvfReader(IVF_PATH);
+    CHECK(reader && reader->getNumFrames() == expected.size() - 1,
+            "Truncated frame not dropped");
+    delete reader;
+
+    /* Truncated frame header, ignored. */
+    build_ivf("VP80", 0, 10, 5, IVF_FILE_HDR_SIZE, 1000, file, expected);
+    file.resize(file.size() + IVF_FRAME_HDR_SIZE - 1, 0);
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    reader = NvIvfReader::createIvfReader(IVF_PATH);
+    CHECK(reader && reader->getNumFrames() == expected.size(),
+            "Trailing bytes not ignored");
+    delete reader;
+
+    /* No DKIF signature. */
+    build_ivf("VP80", 0, 10, 5, IVF_FILE_HDR_SIZE, 1000, file, expected);
+    file[0] = 'R';
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    reader = NvIvfReader::createIvfReader(IVF_PATH);
+    CHECK(!reader, "File without DKIF signature accepted");
+
+    /* Shorter than a file header. */
+    file.resize(IVF_FILE_HDR_SIZE - 1);
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    reader = NvIvfReader::createIvfReader(IVF_PATH);
+    CHECK(!reader, "File shorter than a header accepted");
+
+    cout << "Malformed files: OK" << endl;
+    return 0;
+}
+
+static int
+check_files()
+{
+    static const struct
+    {
+        const char *name;
+        const char *fourcc;
+        uint32_t profile;
+        uint32_t num_frames;
+        uint32_t gop;
+        uint32_t header_size;
+    } files[] =
+    {
+        { "vp8", "VP80", 0, 300, 30, IVF_FILE_HDR_SIZE },
+        { "vp9_profile0", "VP90", 0, 300, 30, IVF_FILE_HDR_SIZE },
+        { "vp9_profile1", "VP90", 1, 100, 10, IVF_FILE_HDR_SIZE },
+        { "vp9_profile2_long_header", "VP90", 2, 100, 7, 64 },
+        { "vp9_profile3", "VP90", 3, 300, 20, IVF_FILE_HDR_SIZE },
+        { "av1", "AV01", 0, 300, 60, IVF_FILE_HDR_SIZE },
+        { "vp8_all_key", "VP80", 0, 20, 1, IVF_FILE_HDR_SIZE },
+    };
+    vector<expected_frame_t> expected;
+    vector<uint8_t> file;
+
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    {
+        build_ivf(files[i].fourcc, files[i].profile, files[i].num_frames,
+                files[i].gop, files[i].header_size, 30000, file, expected);
+        if (write_file(file) < 0 ||
+            check_reader(files[i].name, expected, files[i].header_size) < 0)
+        {
+            return -1;
+        }
+        /* The ifstream reader only knew 32 byte file headers. */
+        if (files[i].header_size == IVF_FILE_HDR_SIZE &&
+            check_ifstream_equivalence(files[i].name, files[i].num_frames) < 0)
+        {
+            return -1;
+        }
+    }
+    return check_malformed();
+}
+
+/**
+  * Times the index, readNextFrame(), getNextFrame() and the ifstream
+  * reader on a VP9 file of @a num_frames frames.
+  */
+static int
+benchmark(uint32_t num_frames)
+{
+    vector<expected_frame_t> expected;
+    vector<uint8_t> file;
+    NvBuffer buffer(BUFFER_SIZE, 0);
+    NvIvfReader *reader;
+    uint64_t checksum = 0;
+    uint64_t t0, index_nsec, read_nsec, span_nsec, ifstream_nsec;
+    uint32_t loop, i;
+
+    build_ivf("VP90", 0, num_frames, 30, IVF_FILE_HDR_SIZE, 30000, file,
+            expected);
+    expected.clear();
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    CHECK(buffer.allocateMemory() == 0, "Could not allocate the buffer");
+
+    t0 = now_nsec();
+    reader = NvIvfReader::createIvfReader(IVF_PATH);
+    index_nsec = now_nsec() - t0;
+    CHECK(reader && reader->getNumFrames() == num_frames,
+            "Could not index the benchmark file");
+
+    t0 = now_nsec();
+    for (loop = 0; loop < BENCHMARK_LOOPS; loop++)
+    {
+        while (reader->readNextFrame(&buffer) == 0 && buffer.planes[0].bytesused)
+        {
+            checksum += buffer.planes[0].data[0];
+        }
+    }
+    read_nsec = now_nsec() - t0;
+
+    t0 = now_nsec();
+    for (loop = 0; loop < BENCHMARK_LOOPS; loop++)
+    {
+        const uint8_t *span;
+        uint32_t size;
+
+        while ((span = reader->getNextFrame(size)) != NULL)
+        {
+            checksum += span[0];
+        }
+    }
+    span_nsec = now_nsec() - t0;
+    delete reader;
+
+    t0 = now_nsec();
+    for (loop = 0; loop < BENCHMARK_LOOPS; loop++)
+    {
+        ifstream stream(IVF_PATH, ios::binary);
+        bool header_read = false;
+
+        for (i = 0; i < num_frames; i++)
+        {
+            if (read_ivf_frame_ifstream(&stream, header_read, &buffer) < 0)
+            {
+                return -1;
+            }
+            checksum += buffer.planes[0].data[0];
+        }
+    }
+    ifstream_nsec = now_nsec() - t0;
+
+    num_frames *= BENCHMARK_LOOPS;
+    cout << "Index: " << (double) index_nsec / 1000000 << " ms for " <<
+        num_frames / BENCHMARK_LOOPS << " frames" << endl;
+    cout << "readNextFrame: " << (double) read_nsec / num_frames <<
+        " ns per frame" << endl;
+    cout << "getNextFrame: " << (double) span_nsec / num_frames <<
+        " ns per frame" << endl;
+    cout << "ifstream reader: " << (double) ifstream_nsec / num_frames <<
+        " ns per frame" << endl;
+    /* Keeps the reads from being optimized out. */
+    return checksum == 0 ? -1 : 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: ivf_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Frames of the benchmark file [Default = "
+        << DEFAULT_BENCHMARK_FRAMES << "]" << endl;
+    cout << "\t-v           Print the errors and warnings of the reader on"
+        " malformed files" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_frames = DEFAULT_BENCHMARK_FRAMES;
+    int ret = 0;
+    int opt;
+
+    /* Some reads and files are invalid on purpose. */
+    log_level = LOG_LEVEL_INFO;
+
+    while ((opt = getopt(argc, argv, "n:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_frames = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_WARN;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_frames < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_files() < 0 || benchmark(num_frames) < 0)
+    {
+        ret = -1;
+    }
+    unlink(IVF_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
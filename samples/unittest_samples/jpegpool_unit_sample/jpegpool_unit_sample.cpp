@@ -0,0 +1,726 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./jpegpool_sample [-n jobs] [-e encoders] [-v]
+ * Example:
+ * ./jpegpool_sample
+ * ./jpegpool_sample -n 20000 -e 16
+**/
+
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include "NvBuffer.h"
+#include "NvJpegEncodePool.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only ThreadSanitizer check of the ordering and back-pressure of
+ * NvJpegEncodePool, with a stand-in for NvJPEGEncoder.
+ *
+ * The stand-in encoder takes a pseudo-random time per image, so that the
+ * images complete out of order, and writes an output that identifies the
+ * source it read. Jobs are submitted in batches from a ring of source
+ * buffers refilled after waitPending(). Every image must be delivered
+ * once, in order, from the source it was submitted with, one callback at a
+ * time, never with more than the images in flight pending, and no encoder
+ * may be used by two workers at once. Failed encodes and jobs without a
+ * source must be delivered as errors in their place. A blocked callback
+ * must block submit(), and deleting the pool must deliver the images still
+ * pending.
+ *
+ * The scaling of the pool is then measured with 1 to N encoders, with the
+ * stand-in either sleeping, as the hardware encoder does, or using the
+ * CPU, as libjpeg does.
+ */
+
+#define DEFAULT_NUM_JOBS 4000
+#define DEFAULT_MAX_ENCODERS 8
+#define NUM_ENCODERS 4
+#define MAX_IN_FLIGHT 12
+#define MAX_BATCH 8
+#define WIDTH 64
+#define HEIGHT 32
+/* Longest stand-in encode of the order check, in microseconds. */
+#define MAX_ENCODE_USEC 200
+/* Every so many jobs fail to encode, and every so many have no source. */
+#define FAIL_EVERY 97
+#define NO_SOURCE_EVERY 251
+/* Encode time of the scaling run. */
+#define SCALING_JOBS 400
+#define SCALING_ENCODE_USEC 1000
+#define BLOCK_WAIT_USEC 50000
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/**
+ * Configures the stand-in encoder.
+ */
+static struct
+{
+    /** Longest pseudo-random sleep per image, 0 for none. */
+    atomic<uint32_t> max_sleep_usec;
+    /** Fixed sleep per image, standing for a hardware encode. */
+    atomic<uint32_t> sleep_usec;
+    /** CPU time per image, standing for a software encode. */
+    atomic<uint32_t> cpu_usec;
+} stand_in;
+
+/* Encoders in use, an encoder must only be used by one worker at a time. */
+static mutex encoders_lock;
+static set<const NvJPEGEncoder *> busy_encoders;
+static atomic<uint32_t> encoder_conflicts(0);
+static atomic<uint32_t> active_encodes(0);
+static atomic<uint32_t> max_active_encodes(0);
+
+static uint64_t
+now_usec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t
+thread_cpu_usec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t
+mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/* Output of the stand-in for a source hashed to @a hash: its size, then
+   its bytes. */
+static unsigned long
+output_size(uint64_t hash)
+{
+    return 16 + hash % 4096;
+}
+
+static unsigned char
+output_byte(uint64_t hash, unsigned long i)
+{
+    return mix(hash + i / 8) >> (i % 8 * 8);
+}
+
+/**
+ * Stand-in for the libjpeg encode, writing the output the way
+ * jpeg_mem_dest does: into the buffer given if it is large enough,
+ * otherwise into a new one, leaving the old one to the caller.
+ */
+static int
+stand_in_encode(const NvJPEGEncoder *encoder, uint64_t hash,
+        unsigned char **out_buf, unsigned long &out_buf_size, int quality)
+{
+    unsigned long size = output_size(hash);
+    uint32_t active = ++active_encodes;
+    uint32_t max_active = max_active_encodes.load();
+    uint32_t max_sleep = stand_in.max_sleep_usec.load();
+    uint32_t cpu = stand_in.cpu_usec.load();
+    int ret = 0;
+
+    while (active > max_active &&
+            !max_active_encodes.compare_exchange_weak(max_active, active))
+        ;
+    {
+        lock_guard<mutex> guard(encoders_lock);
+        if (!busy_encoders.insert(encoder).second)
+            encoder_conflicts++;
+    }
+
+    if (max_sleep)
+        usleep(hash % max_sleep);
+    if (stand_in.sleep_usec.load())
+        usleep(stand_in.sleep_usec.load());
+    if (cpu)
+    {
+        uint64_t start = thread_cpu_usec();
+        volatile uint64_t sink = 0;
+
+        while (thread_cpu_usec() - start < cpu)
+        {
+            for (int i = 0; i < 1000; i++)
+                sink += i;
+        }
+    }
+
+    if (quality <= 0)
+    {
+        ret = -1;
+    }
+    else
+    {
+        if (!*out_buf || out_buf_size < size)
+        {
+            *out_buf = (unsigned char *) malloc(size);
+            out_buf_size = size;
+        }
+        for (unsigned long i = 0; i < size; i++)
+            (*out_buf)[i] = output_byte(hash, i);
+        out_buf_size = size;
+    }
+
+    {
+        lock_guard<mutex> guard(encoders_lock);
+        busy_encoders.erase(encoder);
+    }
+    active_encodes--;
+    return ret;
+}
+
+/* Hash of the planes of a buffer. */
+static uint64_t
+hash_buffer(const NvBuffer &buffer)
+{
+    uint64_t hash = 0;
+
+    for (uint32_t i = 0; i < buffer.n_planes; i++)
+    {
+        const NvBuffer::NvBufferPlane &plane = buffer.planes[i];
+
+        for (uint32_t j = 0; j < plane.fmt.sizeimage; j += 8)
+        {
+            uint64_t word;
+
+            memcpy(&word, plane.data + j, sizeof(word));
+            hash = mix(hash ^ word);
+        }
+    }
+    return hash;
+}
+
+NvJPEGEncoder::NvJPEGEncoder(const char *comp_name)
+    :NvElement(comp_name, valid_fields)
+{
+    memset(&cinfo, 0, sizeof(cinfo));
+    memset(&jerr, 0, sizeof(jerr));
+}
+
+NvJPEGEncoder *
+NvJPEGEncoder::createJPEGEncoder(const char *comp_name)
+{
+    return new NvJPEGEncoder(comp_name);
+}
+
+NvJPEGEncoder::~NvJPEGEncoder()
+{
+}
+
+int
+NvJPEGEncoder::encodeFromFd(int fd, J_COLOR_SPACE color_space,
+        unsigned char **out_buf, unsigned long &out_buf_size, int quality)
+{
+    uint64_t id = profiler.startProcessing();
+    int ret = stand_in_encode(this, mix(fd), out_buf, out_buf_size,
+            quality);
+
+    profiler.finishProcessing(id, false);
+    return ret;
+}
+
+int
+NvJPEGEncoder::encodeFromBuffer(NvBuffer &buffer, J_COLOR_SPACE color_space,
+        unsigned char **out_buf, unsigned long &out_buf_size, int quality)
+{
+    uint64_t id = profiler.startProcessing();
+    int ret = stand_in_encode(this, hash_buffer(buffer), out_buf,
+            out_buf_size, quality);
+
+    profiler.finishProcessing(id, false);
+    return ret;
+}
+
+/**
+ * Holds what the delivery callback checks.
+ */
+typedef struct
+{
+    /** Hash of the source of each job, set before submission. */
+    vector<uint64_t> hashes;
+    /** Set for the jobs that must fail. */
+    vector<char> failing;
+    /** Sequence of the next image, only used by the callback. */
+    uint64_t next_sequence;
+    atomic<uint64_t> delivered;
+    atomic<uint32_t> in_callback;
+    /** First error seen by the callback. */
+    string error;
+    /** Callbacks wait while the gate is closed. */
+    pthread_mutex_t gate_lock;
+    pthread_cond_t gate_cond;
+    bool gate_closed;
+} checker_t;
+
+static void
+deliver_fcn(const NvJpegEncodeJob &job, void *arg)
+{
+    checker_t *checker = (checker_t *) arg;
+    uint64_t index = (uintptr_t) job.user_data;
+    ostringstream error;
+
+    if (++checker->in_callback != 1)
+        error << "Concurrent callbacks";
+    else if (job.sequence != checker->next_sequence || index != job.sequence)
+        error << "Image " << job.sequence << " of job " << index <<
+            " delivered for " << checker->next_sequence;
+    else if (checker->failing[index])
+    {
+        if (job.status != -1 || job.out_buf)
+            error << "Image " << index << " should have failed";
+    }
+    else if (job.status != 0 || !job.out_buf ||
+            job.out_buf_size != output_size(checker->hashes[index]))
+        error << "Image " << index << " failed or has the wrong size";
+    else
+    {
+        for (unsigned long i = 0; i < job.out_buf_size; i++)
+        {
+            if (job.out_buf[i] != output_byte(checker->hashes[index], i))
+            {
+                error << "Image " << index << " encoded from another source";
+                break;
+            }
+        }
+    }
+    if (checker->error.empty())
+        checker->error = error.str();
+    checker->next_sequence++;
+
+    pthread_mutex_lock(&checker->gate_lock);
+    while (checker->gate_closed)
+        pthread_cond_wait(&checker->gate_cond, &checker->gate_lock);
+    pthread_mutex_unlock(&checker->gate_lock);
+
+    checker->in_callback--;
+    checker->delivered++;
+}
+
+static void
+init_checker(checker_t &checker, uint32_t num_jobs)
+{
+    checker.hashes.assign(num_jobs, 0);
+    checker.failing.assign(num_jobs, 0);
+    checker.next_sequence = 0;
+    checker.delivered = 0;
+    checker.in_callback = 0;
+    checker.error.clear();
+    pthread_mutex_init(&checker.gate_lock, NULL);
+    pthread_cond_init(&checker.gate_cond, NULL);
+    checker.gate_closed = false;
+}
+
+static void
+destroy_checker(checker_t &checker)
+{
+    pthread_cond_destroy(&checker.gate_cond);
+    pthread_mutex_destroy(&checker.gate_lock);
+}
+
+static void
+set_gate(checker_t &checker, bool closed)
+{
+    pthread_mutex_lock(&checker.gate_lock);
+    checker.gate_closed = closed;
+    pthread_cond_broadcast(&checker.gate_cond);
+    pthread_mutex_unlock(&checker.gate_lock);
+}
+
+/* Fills the job @a index from a fake FD, which is never opened, the
+   stand-in only hashes it. */
+static void
+fill_fd_job(NvJpegEncodeJob &job, uint32_t index, checker_t &checker)
+{
+    memset(&job, 0, sizeof(job));
+    job.user_data = (void *) (uintptr_t) index;
+    job.color_space = JCS_YCbCr;
+    job.quality = 75;
+    job.fd = 1000 + index;
+    checker.hashes[index] = mix(job.fd);
+}
+
+/* Fills the job @a index from @a buffer, refilled with a pattern of the
+   job, or from a fake FD. Some jobs fail or have no source. */
+static void
+fill_job(NvJpegEncodeJob &job, uint32_t index, NvBuffer *buffer,
+        checker_t &checker)
+{
+    if (index % 5 == 4)
+    {
+        fill_fd_job(job, index, checker);
+    }
+    else
+    {
+        memset(&job, 0, sizeof(job));
+        job.user_data = (void *) (uintptr_t) index;
+        job.color_space = JCS_YCbCr;
+        job.quality = 75;
+        job.fd = -1;
+        for (uint32_t i = 0; i < buffer->n_planes; i++)
+        {
+            NvBuffer::NvBufferPlane &plane = buffer->planes[i];
+
+            for (uint32_t j = 0; j < plane.fmt.sizeimage; j++)
+                plane.data[j] = mix(index * 3 + i) >> (j % 8 * 8);
+        }
+        job.buffer = buffer;
+        checker.hashes[index] = hash_buffer(*buffer);
+    }
+    if (index % FAIL_EVERY == FAIL_EVERY - 1)
+    {
+        job.quality = 0;
+        checker.failing[index] = 1;
+    }
+    if (index % NO_SOURCE_EVERY == NO_SOURCE_EVERY - 1)
+    {
+        job.fd = -1;
+        job.buffer = NULL;
+        checker.failing[index] = 1;
+    }
+}
+
+static int
+check_order(uint32_t num_jobs)
+{
+    vector<NvBuffer *> buffers;
+    NvJpegEncodePool *pool;
+    checker_t checker;
+    uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+    uint32_t max_pending = 0;
+    int ret = 0;
+
+    init_checker(checker, num_jobs);
+    stand_in.max_sleep_usec = MAX_ENCODE_USEC;
+    for (uint32_t i = 0; i < MAX_IN_FLIGHT; i++)
+    {
+        buffers.push_back(new NvBuffer(V4L2_PIX_FMT_YUV420M, WIDTH, HEIGHT,
+                    i));
+        buffers.back()->allocateMemory();
+    }
+    /* Small output buffers, so that the stand-in grows them. */
+    pool = NvJpegEncodePool::createJpegEncodePool("order", NUM_ENCODERS,
+            MAX_IN_FLIGHT, 1024, deliver_fcn, &checker);
+    CHECK(pool, "order: could not create the pool");
+
+    for (uint32_t i = 0; i < num_jobs && ret == 0;)
+    {
+        NvJpegEncodeJob jobs[MAX_BATCH];
+        uint32_t batch;
+
+        rand_state ^= rand_state << 13;
+        rand_state ^= rand_state >> 7;
+        rand_state ^= rand_state << 17;
+        batch = 1 + rand_state % MAX_BATCH;
+        if (batch > num_jobs - i)
+            batch = num_jobs - i;
+
+        /* The buffers of the oldest pending jobs are about to be refilled. */
+        pool->waitPending(MAX_IN_FLIGHT - batch);
+        for (uint32_t j = 0; j < batch; j++)
+        {
+            fill_job(jobs[j], i + j, buffers[(i + j) % MAX_IN_FLIGHT],
+                    checker);
+        }
+        if (pool->submit(jobs, batch) < 0)
+        {
+            cerr << "order: submit failed" << endl;
+            ret = -1;
+        }
+        for (uint32_t j = 0; j < batch; j++)
+        {
+            if (jobs[j].sequence != i + j)
+            {
+                cerr << "order: job " << i + j << " got sequence " <<
+                    jobs[j].sequence << endl;
+                ret = -1;
+            }
+        }
+        i += batch;
+        /* Images up to the one before the last slots were delivered. */
+        if (i - checker.delivered.load() > max_pending)
+            max_pending = i - checker.delivered.load();
+    }
+    pool->waitPending(0);
+    delete pool;
+    for (uint32_t i = 0; i < buffers.size(); i++)
+        delete buffers[i];
+    stand_in.max_sleep_usec = 0;
+
+    cout << "order: " << checker.delivered.load() << " images, " <<
+        max_active_encodes.load() << " encoding at once, at most " <<
+        max_pending << " pending" << endl;
+    CHECK(ret == 0, "order: submission failed");
+    CHECK(checker.error.empty(), "order: " << checker.error);
+    CHECK(checker.delivered.load() == num_jobs, "order: " <<
+            checker.delivered.load() << " images delivered for " << num_jobs);
+    CHECK(max_pending <= MAX_IN_FLIGHT, "order: " << max_pending <<
+            " images pending for " << MAX_IN_FLIGHT << " in flight");
+    CHECK(encoder_conflicts.load() == 0, "order: an encoder was used by " <<
+            "two workers at once");
+    CHECK(max_active_encodes.load() <= NUM_ENCODERS &&
+            max_active_encodes.load() > 1, "order: " <<
+            max_active_encodes.load() << " encodes at once for " <<
+            NUM_ENCODERS << " encoders");
+    destroy_checker(checker);
+    cout << "order: OK" << endl;
+    return 0;
+}
+
+typedef struct
+{
+    NvJpegEncodePool *pool;
+    checker_t *checker;
+    uint32_t num_jobs;
+    atomic<uint32_t> submitted;
+} producer_t;
+
+static void *
+producer_fcn(void *arg)
+{
+    producer_t *producer = (producer_t *) arg;
+
+    for (uint32_t i = 0; i < producer->num_jobs; i++)
+    {
+        NvJpegEncodeJob job;
+
+        fill_fd_job(job, i, *producer->checker);
+        producer->pool->submit(&job, 1);
+        producer->submitted++;
+    }
+    return NULL;
+}
+
+static int
+check_back_pressure()
+{
+    NvJpegEncodePool *pool;
+    checker_t checker;
+    producer_t producer;
+    pthread_t thread;
+    uint32_t submitted;
+
+    init_checker(checker, MAX_IN_FLIGHT + 1);
+    pool = NvJpegEncodePool::createJpegEncodePool("pressure", NUM_ENCODERS,
+            MAX_IN_FLIGHT, 0, deliver_fcn, &checker);
+    CHECK(pool, "pressure: could not create the pool");
+
+    /* While the first image cannot be delivered, a slot is never freed. */
+    set_gate(checker, true);
+    producer.pool = pool;
+    producer.checker = &checker;
+    producer.num_jobs = MAX_IN_FLIGHT + 1;
+    producer.submitted = 0;
+    pthread_create(&thread, NULL, producer_fcn, &producer);
+    usleep(BLOCK_WAIT_USEC);
+    submitted = producer.submitted.load();
+    /* An image submitted over a pending one may never be delivered, the
+       pool is left as is. */
+    CHECK(submitted == MAX_IN_FLIGHT, "pressure: " << submitted <<
+            " images submitted with " << MAX_IN_FLIGHT << " in flight");
+    set_gate(checker, false);
+    pthread_join(thread, NULL);
+    pool->waitPending(0);
+    CHECK(checker.error.empty() &&
+            checker.delivered.load() == MAX_IN_FLIGHT + 1, "pressure: " <<
+            checker.delivered.load() << " images delivered " << checker.error);
+
+    /* Deleting the pool delivers the pending images. */
+    checker.next_sequence = MAX_IN_FLIGHT + 1;
+    checker.hashes.resize(2 * MAX_IN_FLIGHT + 1);
+    checker.failing.resize(2 * MAX_IN_FLIGHT + 1);
+    stand_in.sleep_usec = 1000;
+    for (uint32_t i = MAX_IN_FLIGHT + 1; i < 2 * MAX_IN_FLIGHT + 1; i++)
+    {
+        NvJpegEncodeJob job;
+
+        fill_fd_job(job, i, checker);
+        pool->submit(&job, 1);
+    }
+    delete pool;
+    stand_in.sleep_usec = 0;
+    CHECK(checker.error.empty() &&
+            checker.delivered.load() == 2 * MAX_IN_FLIGHT + 1, "pressure: " <<
+            checker.delivered.load() << " images delivered when deleting " <<
+            checker.error);
+    destroy_checker(checker);
+    cout << "pressure: OK" << endl;
+    return 0;
+}
+
+/* Returns the images per second encoded by @a num_encoders. */
+static double
+run_scaling(uint32_t num_encoders)
+{
+    NvJpegEncodePool *pool;
+    checker_t checker;
+    uint64_t start;
+    double rate;
+
+    init_checker(checker, SCALING_JOBS);
+    pool = NvJpegEncodePool::createJpegEncodePool("scaling", num_encoders, 0,
+            0, deliver_fcn, &checker);
+    if (!pool)
+    {
+        destroy_checker(checker);
+        return 0;
+    }
+
+    start = now_usec();
+    for (uint32_t i = 0; i < SCALING_JOBS; i++)
+    {
+        NvJpegEncodeJob job;
+
+        fill_fd_job(job, i, checker);
+        pool->submit(&job, 1);
+    }
+    pool->waitPending(0);
+    rate = SCALING_JOBS * 1000000.0 / (now_usec() - start);
+    delete pool;
+
+    if (!checker.error.empty() || checker.delivered.load() != SCALING_JOBS)
+        rate = 0;
+    destroy_checker(checker);
+    return rate;
+}
+
+static int
+check_scaling(uint32_t max_encoders)
+{
+    cout << "scaling: " << sysconf(_SC_NPROCESSORS_ONLN) << " CPUs, " <<
+        SCALING_ENCODE_USEC << " us per image" << endl;
+    for (int cpu = 0; cpu < 2; cpu++)
+    {
+        double base_rate = 0;
+
+        stand_in.sleep_usec = cpu ? 0 : SCALING_ENCODE_USEC;
+        stand_in.cpu_usec = cpu ? SCALING_ENCODE_USEC : 0;
+        for (uint32_t n = 1; n <= max_encoders; n *= 2)
+        {
+            double rate = run_scaling(n);
+
+            CHECK(rate > 0, "scaling: run with " << n << " encoders failed");
+            if (n == 1)
+                base_rate = rate;
+            cout << "scaling: " << (cpu ? "CPU" : "sleeping") << " encoder, " <<
+                n << " encoders: " << rate << " images/s, " <<
+                rate / base_rate << "x" << endl;
+            /* Sleeping encodes overlap whatever the number of CPUs. */
+            CHECK(cpu || n < 4 || rate >= 2 * base_rate, "scaling: " << n <<
+                    " sleeping encoders are not faster than one");
+        }
+    }
+    stand_in.sleep_usec = 0;
+    stand_in.cpu_usec = 0;
+    cout << "scaling: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: jpegpool_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Images of the order check [Default = "
+        << DEFAULT_NUM_JOBS << "]" << endl;
+    cout << "\t-e <count>   Largest number of encoders of the scaling run "
+        "[Default = " << DEFAULT_MAX_ENCODERS << "]" << endl;
+    cout << "\t-v           Print the expected errors" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_jobs = DEFAULT_NUM_JOBS;
+    uint32_t max_encoders = DEFAULT_MAX_ENCODERS;
+    int opt;
+
+    /* The jobs without a source are logged as errors. */
+    log_level = LOG_LEVEL_INFO;
+    while ((opt = getopt(argc, argv, "n:e:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_jobs = atoi(optarg);
+                break;
+            case 'e':
+                max_encoders = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_DEBUG;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_jobs < 1 || max_encoders < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_back_pressure() < 0 || check_order(num_jobs) < 0 ||
+            check_scaling(max_encoders) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
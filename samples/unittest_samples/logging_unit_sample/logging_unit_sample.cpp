@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./logging_sample [-n messages]
+ * Example:
+ * ./logging_sample
+ * ./logging_sample -n 100000
+**/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of the logging macros.
+ *
+ * The logging configuration is read from the environment once per
+ * process, so each path runs in a child process:
+ *
+ * - sync: messages written to stderr by the calling thread;
+ * - async: NVMM_LOG_ASYNC, messages queued to the ring of the calling
+ *   thread and written to stderr by the drain thread;
+ * - file: NVMM_LOG_FILE, the same, appended to a file;
+ * - rate: NVMM_LOG_RATE, messages of each call site limited per second.
+ *
+ * Each of 8 threads logs bursts of numbered messages small enough for its
+ * ring, waiting for the drain in between. All of them must be written,
+ * in order for each thread, except for the rate limit. The threads then
+ * log as fast as they can and the calls per second are reported. All
+ * these messages must then be written in order, or be counted as dropped
+ * by the asynchronous paths, or be within the rate limit.
+ */
+
+#define LOG_PATH "logging_sample.log"
+
+#define NUM_THREADS 8
+#define DEFAULT_NUM_MESSAGES 20000
+#define NUM_BURSTS 4
+/* About 20 KB of messages, under the 64 KB ring of a thread. */
+#define BURST_MESSAGES 256
+/* Longer than the interval of the drain thread. */
+#define BURST_INTERVAL_USEC 30000
+#define LOG_RATE 100
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef enum
+{
+    MODE_SYNC,
+    MODE_ASYNC,
+    MODE_FILE,
+    MODE_RATE,
+    MODE_DISABLED,
+    NUM_MODES
+} log_mode_t;
+
+static const char *mode_names[NUM_MODES] =
+{
+    "sync", "async", "file", "rate", "disabled"
+};
+
+typedef struct
+{
+    /** Next message expected from each thread. */
+    uint32_t next[NUM_THREADS];
+    /** Messages found out of order. */
+    uint32_t order_errors;
+    /** Messages found. */
+    uint64_t found;
+} phase_count_t;
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+log_burst_fcn(uint32_t thread)
+{
+    for (uint32_t burst = 0; burst < NUM_BURSTS; burst++)
+    {
+        for (uint32_t i = 0; i < BURST_MESSAGES; i++)
+        {
+            INFO_MSG("thread " << thread << " burst " <<
+                    burst * BURST_MESSAGES + i);
+        }
+        usleep(BURST_INTERVAL_USEC);
+    }
+}
+
+static void
+log_flood_fcn(uint32_t thread, uint32_t num_messages)
+{
+    for (uint32_t i = 0; i < num_messages; i++)
+    {
+        INFO_MSG("thread " << thread << " flood " << i);
+    }
+}
+
+static void
+log_disabled_fcn(uint32_t thread, uint32_t num_messages)
+{
+    for (uint32_t i = 0; i < num_messages; i++)
+    {
+        DEBUG_MSG("thread " << thread << " disabled " << i);
+    }
+}
+
+/**
+  * Logs from the threads of the child process of @a mode, and prints the
+  * calls per second of the flood to stdout.
+  */
+static int
+run_child(log_mode_t mode, uint32_t num_messages)
+{
+    vector<thread> threads;
+    uint64_t t0;
+    int fd;
+
+    switch (mode)
+    {
+        case MODE_ASYNC:
+            setenv("NVMM_LOG_ASYNC", "1", 1);
+            break;
+        case MODE_FILE:
+            setenv("NVMM_LOG_FILE", LOG_PATH, 1);
+            break;
+        case MODE_RATE:
+            setenv("NVMM_LOG_RATE", xstringify(LOG_RATE), 1);
+            break;
+        default:
+            break;
+    }
+    fd = open(mode == MODE_FILE ? "/dev/null" : LOG_PATH,
+            O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0 || dup2(fd, STDERR_FILENO) < 0)
+    {
+        return -1;
+    }
+    close(fd);
+    log_level = mode == MODE_DISABLED ? LOG_LEVEL_INFO : LOG_LEVEL_DEBUG;
+
+    if (mode != MODE_DISABLED)
+    {
+        for (uint32_t i = 0; i < NUM_THREADS; i++)
+        {
+            threads.push_back(thread(log_burst_fcn, i));
+        }
+        for (uint32_t i = 0; i < NUM_THREADS; i++)
+        {
+            threads[i].join();
+        }
+        threads.clear();
+    }
+
+    t0 = now_nsec();
+    for (uint32_t i = 0; i < NUM_THREADS; i++)
+    {
+        if (mode == MODE_DISABLED)
+            threads.push_back(thread(log_disabled_fcn, i, num_messages));
+        else
+            threads.push_back(thread(log_flood_fcn, i, num_messages));
+    }
+    for (uint32_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i].join();
+    }
+    t0 = now_nsec() - t0;
+
+    cout << mode_names[mode] << ": " << (double) NUM_THREADS * num_messages *
+        1e9 / (t0 ? t0 : 1) / 1e6 << " million calls/s from " <<
+        NUM_THREADS << " threads" << endl;
+    return 0;
+}
+
+static void
+count_message(phase_count_t &count, uint32_t thread, uint32_t seq)
+{
+    if (seq < count.next[thread])
+    {
+        count.order_errors++;
+    }
+    else
+    {
+        count.next[thread] = seq + 1;
+    }
+    count.found++;
+}
+
+/**
+  * Checks the messages written by the child of @a mode.
+  */
+static int
+check_output(log_mode_t mode, uint32_t num_messages)
+{
+    ifstream file(LOG_PATH);
+    string line;
+    phase_count_t bursts;
+    phase_count_t floods;
+    uint64_t dropped = 0;
+    uint64_t suppressed = 0;
+    uint64_t other = 0;
+    uint64_t burst_total = (uint64_t) NUM_THREADS * NUM_BURSTS *
+        BURST_MESSAGES;
+    uint64_t flood_total = (uint64_t) NUM_THREADS * num_messages;
+    const char *name = mode_names[mode];
+
+    memset(&bursts, 0, sizeof(bursts));
+    memset(&floods, 0, sizeof(floods));
+    CHECK(file, name << ": no output");
+    while (getline(file, line))
+    {
+        const char *message = strstr(line.c_str(), ") thread ");
+        const char *drop = strstr(line.c_str(), "<Logging> Dropped ");
+        const char *suppress = strstr(line.c_str(), " similar messages");
+        char phase[16];
+        unsigned int thread, seq, n;
+
+        if (message && sscanf(message, ") thread %u %15s %u", &thread,
+                    phase, &seq) == 3 && thread < NUM_THREADS)
+        {
+            count_message(strcmp(phase, "burst") ? floods : bursts, thread,
+                    seq);
+            if (suppress && sscanf(strrchr(line.c_str(), '['),
+                        "[%u similar", &n) == 1)
+            {
+                suppressed += n;
+            }
+        }
+        else if (drop && sscanf(drop, "<Logging> Dropped %u", &n) == 1)
+        {
+            dropped += n;
+        }
+        else
+        {
+            other++;
+        }
+    }
+
+    CHECK(other == 0, name << ": " << other << " malformed lines");
+    CHECK(bursts.order_errors == 0 && floods.order_errors == 0, name <<
+            ": " << bursts.order_errors + floods.order_errors <<
+            " messages out of order");
+    if (mode == MODE_DISABLED)
+    {
+        CHECK(bursts.found + floods.found + dropped == 0, name <<
+                ": disabled messages were written");
+    }
+    else if (mode == MODE_RATE)
+    {
+        /* The run spans one or two windows of a second. */
+        CHECK(bursts.found >= LOG_RATE && bursts.found <= 2 * LOG_RATE,
+                name << ": " << bursts.found << " burst messages written");
+        CHECK(floods.found >= LOG_RATE && floods.found <= 2 * LOG_RATE,
+                name << ": " << floods.found << " flood messages written");
+        CHECK(bursts.found + floods.found + suppressed <=
+                burst_total + flood_total, name << ": " << suppressed <<
+                " messages reported suppressed");
+        cout << name << ": " << bursts.found + floods.found <<
+            " messages written, " << suppressed << " reported suppressed" <<
+            endl;
+    }
+    else
+    {
+        CHECK(bursts.found == burst_total, name << ": " << bursts.found <<
+                " burst messages written instead of " << burst_total);
+        CHECK(floods.found + dropped == flood_total, name << ": " <<
+                floods.found << " flood messages written and " << dropped <<
+                " dropped instead of " << flood_total);
+        CHECK(mode != MODE_SYNC || dropped == 0, name << ": dropped " <<
+                dropped << " messages");
+        cout << name << ": " << bursts.found + floods.found <<
+            " messages written, " << dropped << " dropped" << endl;
+    }
+    return 0;
+}
+
+static int
+check_mode(log_mode_t mode, uint32_t num_messages)
+{
+    pid_t pid;
+    int status;
+
+    unlink(LOG_PATH);
+    cout.flush();
+    pid = fork();
+    CHECK(pid >= 0, "Could not fork");
+    if (pid == 0)
+    {
+        /* Exiting writes the last asynchronous messages. */
+        exit(run_child(mode, num_messages) < 0 ? 1 : 0);
+    }
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+            WEXITSTATUS(status) == 0, mode_names[mode] <<
+            ": child process failed");
+    return check_output(mode, num_messages);
+}
+
+static void
+print_help()
+{
+    cout << "Usage: logging_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Messages logged per thread as fast as possible "
+        "[Default = " << DEFAULT_NUM_MESSAGES << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_messages = DEFAULT_NUM_MESSAGES;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_messages = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_messages < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    for (int mode = 0; mode < NUM_MODES && ret == 0; mode++)
+    {
+        ret = check_mode((log_mode_t) mode, num_messages);
+    }
+    unlink(LOG_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,994 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./metrics_sample [-r fps] [-f freezes]
+ * Example:
+ * ./metrics_sample
+ * ./metrics_sample -r 100 -f 500
+**/
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+#include "NvElement.h"
+#include "NvMetricsRegistry.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvMetricsRegistry.
+ *
+ * Test elements feed their profilers at a known rate and with known
+ * latencies. The sliding window FPS, the late units, the queue depths and
+ * the latency percentiles of the snapshots are checked against them, then
+ * the metrics are fetched over the Unix socket, in the Prometheus text
+ * format and as JSON, and parsed back. Finally the sampler and server
+ * threads are frozen with a signal at random points, while they may hold
+ * any of their locks, and a thread calling startProcessing() and
+ * finishProcessing() must keep making progress.
+ */
+
+#define DEFAULT_RATE 250
+#define DEFAULT_FREEZES 200
+#define INTERVAL_MSEC 20
+#define WINDOW_MSEC 300
+/* Error allowed on the window FPS, the pacing sleeps may overshoot. */
+#define FPS_TOLERANCE 0.25f
+/* The histogram buckets stand for the middle of their range, which is
+   within 6.25% of any latency in it. The profiler also times a little more
+   than the sample does. */
+#define LATENCY_TOLERANCE 0.07f
+#define LATENCY_SLACK_USEC 50
+#define NUM_LATENCY_UNITS 400
+#define NUM_EXPORT_UNITS 50
+#define NUM_FREEZE_ELEMENTS 32
+/* Units the hot path must process while a thread is frozen. */
+#define FREEZE_UNITS 1000
+#define FREEZE_TIMEOUT_MSEC 2000
+
+#define SOCKET_PATH "metrics_sample.sock"
+#define JSON_PATH "metrics_sample.json"
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/**
+ * Element whose profiler is fed by the sample.
+ */
+class TestElement : public NvElement
+{
+public:
+    TestElement(const char *name, NvElementProfiler::ProfilerField fields =
+            NvElementProfiler::PROFILER_FIELD_ALL)
+        : NvElement(name, fields)
+    {
+        enableProfiling();
+    }
+
+    NvElementProfiler &getProfiler()
+    {
+        return profiler;
+    }
+
+    uint32_t getMetricsId()
+    {
+        return metrics_id;
+    }
+};
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+sleep_until(uint64_t deadline_nsec)
+{
+    struct timespec ts;
+
+    ts.tv_sec = deadline_nsec / 1000000000ULL;
+    ts.tv_nsec = deadline_nsec % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+static void
+sleep_usec(uint64_t usec)
+{
+    sleep_until(now_nsec() + usec * 1000);
+}
+
+static const NvMetricsRegistry::NvMetricsElementData *
+find_element(const NvMetricsRegistry::NvMetricsSnapshot &snapshot,
+        const string &name)
+{
+    for (size_t i = 0; i < snapshot.elements.size(); i++)
+    {
+        if (snapshot.elements[i].name == name)
+            return &snapshot.elements[i];
+    }
+    return NULL;
+}
+
+/* Returns the latency under which @a permille of the sorted latencies
+   fall, the same rank NvMetricsRegistry uses. */
+static uint64_t
+get_percentile(const vector<uint64_t> &sorted, uint32_t permille)
+{
+    uint64_t rank = (sorted.size() * permille + 999) / 1000;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static bool
+latency_matches(float reported, uint64_t expected)
+{
+    return reported >= expected * (1 - LATENCY_TOLERANCE) - LATENCY_SLACK_USEC &&
+        reported <= expected * (1 + LATENCY_TOLERANCE) + LATENCY_SLACK_USEC;
+}
+
+static int
+check_window(uint32_t rate)
+{
+    NvMetricsRegistry &registry = NvMetricsRegistry::getInstance();
+    NvMetricsRegistry::NvMetricsSnapshot snapshot;
+    const NvMetricsRegistry::NvMetricsElementData *element;
+    TestElement streamed("window");
+    /* Counts units without latencies, finishProcessing() alone. */
+    TestElement unstreamed("window_nostream",
+            NvElementProfiler::PROFILER_FIELD_TOTAL_UNITS |
+            NvElementProfiler::PROFILER_FIELD_LATE_UNITS |
+            NvElementProfiler::PROFILER_FIELD_FPS);
+    uint32_t output_queued = 3;
+    uint32_t capture_queued = 7;
+    uint32_t num_units = rate;
+    uint32_t num_late = 0;
+    uint64_t period = 1000000000ULL / rate;
+    uint64_t next = now_nsec();
+    float window_fps = 0;
+
+    registry.registerStream(&streamed, "window.h264");
+    registry.setElementQueues(streamed.getMetricsId(), &output_queued,
+            &capture_queued);
+    CHECK(registry.startExporter(INTERVAL_MSEC, WINDOW_MSEC, 0, NULL,
+                NULL) == 0, "window: could not start the exporter");
+
+    /* One second at the given rate, every fifth unit late. */
+    for (uint32_t i = 0; i < num_units; i++)
+    {
+        uint64_t id = streamed.getProfiler().startProcessing();
+
+        streamed.getProfiler().finishProcessing(id, i % 5 == 0);
+        unstreamed.getProfiler().finishProcessing(0, false);
+        num_late += i % 5 == 0;
+        if (i == num_units * 3 / 4)
+        {
+            registry.getSnapshot(snapshot);
+            element = find_element(snapshot, "window");
+            CHECK(element, "window: element missing from the snapshot");
+            window_fps = element->window_fps;
+        }
+        next += period;
+        sleep_until(next);
+    }
+    cout << "window: " << window_fps << " fps for " << rate << " fps" << endl;
+    CHECK(window_fps >= rate * (1 - FPS_TOLERANCE) &&
+            window_fps <= rate * (1 + FPS_TOLERANCE),
+            "window: " << window_fps << " fps for " << rate << " fps");
+
+    sleep_usec(3 * INTERVAL_MSEC * 1000);
+    registry.getSnapshot(snapshot);
+    element = find_element(snapshot, "window");
+    CHECK(element, "window: element missing from the snapshot");
+    CHECK(element->total_units == num_units &&
+            element->total_late_units == num_late, "window: " <<
+            element->total_units << " units, " << element->total_late_units <<
+            " late for " << num_units << ", " << num_late);
+    CHECK(element->window_late_units > 0 &&
+            element->window_late_units <= num_late, "window: " <<
+            element->window_late_units << " late units in the window");
+    CHECK(element->stream == "window.h264" &&
+            snapshot.total_stream_fps == element->window_fps,
+            "window: stream FPS " << snapshot.total_stream_fps << " for " <<
+            element->window_fps);
+    CHECK(element->output_queue_depth == 3 &&
+            element->capture_queue_depth == 7, "window: queue depths " <<
+            element->output_queue_depth << ", " <<
+            element->capture_queue_depth);
+    CHECK(element->average_fps > 0, "window: no average FPS");
+
+    element = find_element(snapshot, "window_nostream");
+    CHECK(element, "window: unstreamed element missing from the snapshot");
+    CHECK(element->total_units == num_units && element->stream.empty() &&
+            element->output_queue_depth == -1 &&
+            element->capture_queue_depth == -1 &&
+            element->p50_latency_usec == 0,
+            "window: unstreamed element " << element->total_units <<
+            " units, queue depths " << element->output_queue_depth << ", " <<
+            element->capture_queue_depth);
+
+    /* Once the window has slid past the last unit it must be empty. */
+    sleep_usec((WINDOW_MSEC + 3 * INTERVAL_MSEC) * 1000);
+    registry.getSnapshot(snapshot);
+    element = find_element(snapshot, "window");
+    CHECK(element, "window: element missing from the snapshot");
+    CHECK(element->window_fps == 0 && element->window_late_units == 0 &&
+            element->total_units == num_units && snapshot.total_stream_fps == 0,
+            "window: " << element->window_fps << " fps, " <<
+            element->window_late_units << " late units after the window");
+
+    registry.setElementQueues(streamed.getMetricsId(), NULL, NULL);
+    registry.stopExporter();
+    cout << "window: OK" << endl;
+    return 0;
+}
+
+static int
+check_percentiles()
+{
+    NvMetricsRegistry &registry = NvMetricsRegistry::getInstance();
+    NvMetricsRegistry::NvMetricsSnapshot snapshot;
+    const NvMetricsRegistry::NvMetricsElementData *element;
+    TestElement timed("latency");
+    vector<uint64_t> latencies;
+
+    /* The window covers the whole run. */
+    CHECK(registry.startExporter(INTERVAL_MSEC, 60000, 0, NULL, NULL) == 0,
+            "latency: could not start the exporter");
+    sleep_usec(2 * INTERVAL_MSEC * 1000);
+
+    /* Nine short units for a long one, the sleeps decide the exact
+       latencies, which are measured around them. */
+    for (uint32_t i = 0; i < NUM_LATENCY_UNITS; i++)
+    {
+        uint64_t id = timed.getProfiler().startProcessing();
+        uint64_t start = now_nsec();
+
+        sleep_usec(i % 10 == 9 ? 5000 : 500 + next_rand() % 500);
+        latencies.push_back((now_nsec() - start) / 1000);
+        timed.getProfiler().finishProcessing(id, false);
+    }
+    sleep_usec(3 * INTERVAL_MSEC * 1000);
+    registry.getSnapshot(snapshot);
+    registry.stopExporter();
+
+    sort(latencies.begin(), latencies.end());
+    element = find_element(snapshot, "latency");
+    CHECK(element, "latency: element missing from the snapshot");
+    cout << "latency: p50 " << element->p50_latency_usec << " us for " <<
+        get_percentile(latencies, 500) << ", p90 " <<
+        element->p90_latency_usec << " us for " <<
+        get_percentile(latencies, 900) << ", p99 " <<
+        element->p99_latency_usec << " us for " <<
+        get_percentile(latencies, 990) << ", max " <<
+        element->max_latency_usec << " us for " << latencies.back() << endl;
+    CHECK(element->total_units == NUM_LATENCY_UNITS, "latency: " <<
+            element->total_units << " units");
+    CHECK(latency_matches(element->p50_latency_usec,
+                get_percentile(latencies, 500)), "latency: wrong p50");
+    CHECK(latency_matches(element->p90_latency_usec,
+                get_percentile(latencies, 900)), "latency: wrong p90");
+    CHECK(latency_matches(element->p99_latency_usec,
+                get_percentile(latencies, 990)), "latency: wrong p99");
+    CHECK(latency_matches(element->max_latency_usec, latencies.back()),
+            "latency: wrong max");
+    cout << "latency: OK" << endl;
+    return 0;
+}
+
+/**
+ * Holds a parsed JSON value, only as much as the checks need.
+ */
+typedef struct json_value
+{
+    enum { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY,
+        JSON_OBJECT } type;
+    double number;
+    string str;
+    vector<json_value> array;
+    map<string, json_value> object;
+
+    /* Returns the member @a name of an object, or a null value. */
+    const json_value &operator[](const string &name) const
+    {
+        static const json_value null_value = json_value();
+        map<string, json_value>::const_iterator it = object.find(name);
+
+        return it == object.end() ? null_value : it->second;
+    }
+} json_value_t;
+
+static void
+skip_spaces(const char *&p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+}
+
+static bool
+parse_json_string(const char *&p, string &str)
+{
+    if (*p++ != '"')
+        return false;
+    str.clear();
+    while (*p != '"')
+    {
+        if (!*p || (unsigned char) *p < 0x20)
+            return false;
+        if (*p == '\\')
+        {
+            p++;
+            switch (*p)
+            {
+                case '"':   str += '"'; break;
+                case '\\':  str += '\\'; break;
+                case '/':   str += '/'; break;
+                case 'n':   str += '\n'; break;
+                case 't':   str += '\t'; break;
+                case 'r':   str += '\r'; break;
+                default:    return false;
+            }
+            p++;
+            continue;
+        }
+        str += *p++;
+    }
+    p++;
+    return true;
+}
+
+static bool
+parse_json(const char *&p, json_value_t &value)
+{
+    skip_spaces(p);
+    value.type = json_value_t::JSON_NULL;
+    if (*p == '{')
+    {
+        value.type = json_value_t::JSON_OBJECT;
+        p++;
+        skip_spaces(p);
+        if (*p == '}')
+        {
+            p++;
+            return true;
+        }
+        while (1)
+        {
+            string name;
+
+            skip_spaces(p);
+            if (!parse_json_string(p, name))
+                return false;
+            skip_spaces(p);
+            if (*p++ != ':' || value.object.count(name) ||
+                    !parse_json(p, value.object[name]))
+                return false;
+            skip_spaces(p);
+            if (*p == '}')
+            {
+                p++;
+                return true;
+            }
+            if (*p++ != ',')
+                return false;
+        }
+    }
+    if (*p == '[')
+    {
+        value.type = json_value_t::JSON_ARRAY;
+        p++;
+        skip_spaces(p);
+        if (*p == ']')
+        {
+            p++;
+            return true;
+        }
+        while (1)
+        {
+            value.array.push_back(json_value_t());
+            if (!parse_json(p, value.array.back()))
+                return false;
+            skip_spaces(p);
+            if (*p == ']')
+            {
+                p++;
+                return true;
+            }
+            if (*p++ != ',')
+                return false;
+        }
+    }
+    if (*p == '"')
+    {
+        value.type = json_value_t::JSON_STRING;
+        return parse_json_string(p, value.str);
+    }
+    if (!strncmp(p, "true", 4) || !strncmp(p, "null", 4))
+    {
+        value.type = *p == 't' ? json_value_t::JSON_BOOL :
+            json_value_t::JSON_NULL;
+        value.number = *p == 't';
+        p += 4;
+        return true;
+    }
+    if (!strncmp(p, "false", 5))
+    {
+        value.type = json_value_t::JSON_BOOL;
+        value.number = 0;
+        p += 5;
+        return true;
+    }
+
+    char *end;
+    /* JSON numbers start with a digit or a minus sign, strtod would also
+       take nan, inf and hexadecimal numbers. */
+    if (*p != '-' && (*p < '0' || *p > '9'))
+        return false;
+    value.type = json_value_t::JSON_NUMBER;
+    value.number = strtod(p, &end);
+    if (end == p)
+        return false;
+    p = end;
+    return true;
+}
+
+/* Parses a whole JSON document, nothing but spaces may follow it. */
+static bool
+parse_json_document(const string &text, json_value_t &value)
+{
+    const char *p = text.c_str();
+
+    value = json_value_t();
+    if (!parse_json(p, value))
+        return false;
+    skip_spaces(p);
+    return *p == '\0';
+}
+
+/**
+ * Parses the Prometheus text format into @a samples, keyed by the metric
+ * name with its labels as written. Each metric must have been preceded by
+ * its HELP and TYPE lines.
+ */
+static int
+parse_prometheus(const string &text, map<string, double> &samples)
+{
+    map<string, int> families;
+    size_t pos = 0;
+
+    while (pos < text.size())
+    {
+        size_t eol = text.find('\n', pos);
+        string line;
+
+        CHECK(eol != string::npos, "prometheus: unterminated line");
+        line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (!line.compare(0, 7, "# HELP ") || !line.compare(0, 7, "# TYPE "))
+        {
+            string name = line.substr(7, line.find(' ', 7) - 7);
+
+            families[name] |= line[2] == 'H' ? 1 : 2;
+            continue;
+        }
+        CHECK(line.size() && line[0] != '#', "prometheus: bad line " << line);
+
+        size_t name_end = line.find_first_of("{ ");
+        size_t key_end = name_end;
+        string name = line.substr(0, name_end);
+
+        CHECK(name_end != string::npos, "prometheus: bad line " << line);
+        if (line[name_end] == '{')
+        {
+            /* Label values may contain escaped quotes and braces. */
+            bool quoted = false;
+
+            for (key_end = name_end + 1; key_end < line.size(); key_end++)
+            {
+                if (quoted && line[key_end] == '\\')
+                    key_end++;
+                else if (line[key_end] == '"')
+                    quoted = !quoted;
+                else if (!quoted && line[key_end] == '}')
+                    break;
+            }
+            CHECK(key_end < line.size(), "prometheus: bad labels " << line);
+            key_end++;
+        }
+        CHECK(families[name] == 3, "prometheus: " << name <<
+                " has no HELP or TYPE");
+        CHECK(line[key_end] == ' ', "prometheus: bad line " << line);
+
+        const char *value = line.c_str() + key_end + 1;
+        char *end;
+
+        samples[line.substr(0, key_end)] = strtod(value, &end);
+        CHECK(end != value && *end == '\0', "prometheus: bad value " << line);
+    }
+    return 0;
+}
+
+/**
+ * Sends a request over the metrics socket and splits the response.
+ */
+static int
+http_request(const string &request, string &status, string &content_type,
+        string &body)
+{
+    struct sockaddr_un addr;
+    string response;
+    char buf[4096];
+    ssize_t ret;
+    int fd;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    CHECK(fd >= 0, "http: could not create socket");
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET_PATH);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        cerr << "http: could not connect to " << SOCKET_PATH << ": " <<
+            strerror(errno) << endl;
+        close(fd);
+        return -1;
+    }
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) !=
+            (ssize_t) request.size())
+    {
+        cerr << "http: could not send the request" << endl;
+        close(fd);
+        return -1;
+    }
+    while ((ret = recv(fd, buf, sizeof(buf), 0)) > 0)
+        response.append(buf, ret);
+    close(fd);
+
+    size_t headers_end = response.find("\r\n\r\n");
+    CHECK(headers_end != string::npos, "http: no headers in " << response);
+    status = response.substr(0, response.find("\r\n"));
+    body = response.substr(headers_end + 4);
+
+    size_t pos = response.find("\r\nContent-Type: ");
+    CHECK(pos != string::npos && pos < headers_end, "http: no content type");
+    pos += 16;
+    content_type = response.substr(pos, response.find("\r\n", pos) - pos);
+
+    pos = response.find("\r\nContent-Length: ");
+    CHECK(pos != string::npos && pos < headers_end, "http: no content length");
+    CHECK(strtoul(response.c_str() + pos + 18, NULL, 10) == body.size(),
+            "http: content length does not match the body");
+    return 0;
+}
+
+static int
+check_json_element(const json_value_t &elements, const string &name,
+        const string &stream, uint32_t num_units, uint32_t num_late)
+{
+    CHECK(elements.type == json_value_t::JSON_ARRAY, "json: no elements");
+    for (size_t i = 0; i < elements.array.size(); i++)
+    {
+        const json_value_t &element = elements.array[i];
+
+        if (element["name"].str != name)
+            continue;
+        CHECK(element["stream"].str == stream &&
+                element["units"].number == num_units &&
+                element["late_units"].number == num_late &&
+                element["fps"].type == json_value_t::JSON_NUMBER &&
+                element["latency_usec"]["p50"].number > 0 &&
+                element["latency_usec"]["max"].number >=
+                element["latency_usec"]["p99"].number &&
+                element["queue_depth"]["output"].number == 3 &&
+                element["queue_depth"]["capture"].number == -1,
+                "json: wrong element " << name);
+        return 0;
+    }
+    cerr << "json: element " << name << " missing" << endl;
+    return -1;
+}
+
+static int
+check_export()
+{
+    NvMetricsRegistry &registry = NvMetricsRegistry::getInstance();
+    /* Quotes and backslashes must be escaped in both formats. */
+    const char *name = "dec\"0\\";
+    const char *labels = "{element=\"dec\\\"0\\\\\",stream=\"cam.h264\"";
+    TestElement exported(name);
+    uint32_t output_queued = 3;
+    uint32_t num_late = 0;
+    map<string, double> samples;
+    json_value_t json;
+    string status, content_type, body;
+
+    registry.registerStream(&exported, "cam.h264");
+    registry.setElementQueues(exported.getMetricsId(), &output_queued, NULL);
+    unlink(JSON_PATH);
+    CHECK(registry.startExporter(INTERVAL_MSEC, 1000, 0, SOCKET_PATH,
+                JSON_PATH) == 0, "export: could not start the exporter");
+
+    for (uint32_t i = 0; i < NUM_EXPORT_UNITS; i++)
+    {
+        uint64_t id = exported.getProfiler().startProcessing();
+
+        sleep_usec(200);
+        exported.getProfiler().finishProcessing(id, i % 7 == 0);
+        num_late += i % 7 == 0;
+    }
+    sleep_usec(3 * INTERVAL_MSEC * 1000);
+
+    CHECK(http_request("GET /metrics HTTP/1.0\r\n\r\n", status, content_type,
+                body) == 0, "export: /metrics failed");
+    CHECK(status == "HTTP/1.0 200 OK" &&
+            content_type == "text/plain; version=0.0.4",
+            "export: /metrics returned " << status << ", " << content_type);
+    CHECK(parse_prometheus(body, samples) == 0, "export: bad Prometheus text");
+    CHECK(samples[string("nvmm_element_units_total") + labels + "}"] ==
+            NUM_EXPORT_UNITS && samples[string(
+                "nvmm_element_late_units_total") + labels + "}"] == num_late,
+            "export: wrong unit counters in" << endl << body);
+    CHECK(samples.count(string("nvmm_element_fps") + labels + "}") &&
+            samples[string("nvmm_element_queue_depth") + labels +
+            ",plane=\"output\"}"] == 3 &&
+            !samples.count(string("nvmm_element_queue_depth") + labels +
+                ",plane=\"capture\"}") &&
+            samples.count("nvmm_stream_fps_total") &&
+            samples.count("nvmm_process_cpu_usage_percent"),
+            "export: missing samples in" << endl << body);
+    const char *quantiles[] = { "0.5", "0.9", "0.99", "1" };
+    double last_quantile = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        string key = string("nvmm_element_latency_usec") + labels +
+            ",quantile=\"" + quantiles[i] + "\"}";
+
+        CHECK(samples.count(key) && samples[key] >= last_quantile &&
+                samples[key] > 0, "export: wrong quantile " << quantiles[i]);
+        last_quantile = samples[key];
+    }
+
+    CHECK(http_request("GET /metrics.json HTTP/1.0\r\n\r\n", status,
+                content_type, body) == 0, "export: /metrics.json failed");
+    CHECK(status == "HTTP/1.0 200 OK" && content_type == "application/json",
+            "export: /metrics.json returned " << status << ", " <<
+            content_type);
+    CHECK(parse_json_document(body, json), "export: bad JSON " << body);
+    CHECK(json["window_ms"].number == 1000 &&
+            json["timestamp_ms"].number > 0 &&
+            json["total_stream_fps"].type == json_value_t::JSON_NUMBER,
+            "export: wrong JSON snapshot " << body);
+    CHECK(check_json_element(json["elements"], name, "cam.h264",
+                NUM_EXPORT_UNITS, num_late) == 0, "export: in " << body);
+
+    CHECK(http_request("GET /nothing HTTP/1.0\r\n\r\n", status, content_type,
+                body) == 0 && status == "HTTP/1.0 404 Not Found",
+            "export: unknown path returned " << status);
+    CHECK(http_request("POST /metrics HTTP/1.0\r\n\r\n", status, content_type,
+                body) == 0 && status == "HTTP/1.0 405 Method Not Allowed",
+            "export: POST returned " << status);
+
+    registry.stopExporter();
+    registry.setElementQueues(exported.getMetricsId(), NULL, NULL);
+    CHECK(access(SOCKET_PATH, F_OK) < 0, "export: socket left behind");
+
+    /* One JSON line per sample, the last one written when stopping. */
+    ifstream json_file(JSON_PATH);
+    string line;
+    uint32_t num_lines = 0;
+    double last_timestamp = 0;
+    CHECK(json_file.is_open(), "export: no " << JSON_PATH);
+    while (getline(json_file, line))
+    {
+        CHECK(parse_json_document(line, json), "export: bad JSON line " <<
+                line);
+        CHECK(json["timestamp_ms"].number >= last_timestamp,
+                "export: JSON lines out of order");
+        last_timestamp = json["timestamp_ms"].number;
+        num_lines++;
+    }
+    CHECK(num_lines >= 3, "export: only " << num_lines << " JSON lines");
+    CHECK(check_json_element(json["elements"], name, "cam.h264",
+                NUM_EXPORT_UNITS, num_late) == 0, "export: in the last line");
+    unlink(JSON_PATH);
+
+    cout << "export: " << samples.size() << " samples, " << num_lines <<
+        " JSON lines" << endl;
+    cout << "export: OK" << endl;
+    return 0;
+}
+
+static sem_t frozen_sem;
+static sem_t thaw_sem;
+
+static void
+freeze_handler(int signum)
+{
+    sem_post(&frozen_sem);
+    while (sem_wait(&thaw_sem) < 0 && errno == EINTR)
+        ;
+}
+
+/* Returns the ID of the thread named @a name, 0 if none. */
+static pid_t
+find_thread(const char *name)
+{
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+    pid_t tid = 0;
+
+    if (!dir)
+        return 0;
+    while (!tid && (entry = readdir(dir)))
+    {
+        string path = string("/proc/self/task/") + entry->d_name + "/comm";
+        ifstream comm(path.c_str());
+        string comm_name;
+
+        if (entry->d_name[0] != '.' && getline(comm, comm_name) &&
+                comm_name == name)
+        {
+            tid = atoi(entry->d_name);
+        }
+    }
+    closedir(dir);
+    return tid;
+}
+
+typedef struct
+{
+    vector<TestElement *> *elements;
+    atomic<uint64_t> units;
+    atomic<bool> stop;
+} hot_path_t;
+
+static void *
+hot_path_fcn(void *arg)
+{
+    hot_path_t *hot_path = (hot_path_t *) arg;
+    vector<TestElement *> &elements = *hot_path->elements;
+
+    /* Goes through all the elements, so that whichever profiler the frozen
+       thread was reading is used. */
+    for (size_t i = 0; !hot_path->stop.load(); i = (i + 1) % elements.size())
+    {
+        NvElementProfiler &profiler = elements[i]->getProfiler();
+        uint64_t id = profiler.startProcessing();
+
+        profiler.finishProcessing(id, false);
+        hot_path->units++;
+    }
+    return NULL;
+}
+
+static void *
+client_fcn(void *arg)
+{
+    atomic<bool> *stop = (atomic<bool> *) arg;
+    string status, content_type, body;
+
+    while (!stop->load())
+    {
+        http_request("GET /metrics HTTP/1.0\r\n\r\n", status, content_type,
+                body);
+    }
+    return NULL;
+}
+
+/* Freezes the thread @a tid and waits for the hot path to process
+   FREEZE_UNITS units meanwhile. */
+static int
+freeze_thread(pid_t tid, hot_path_t &hot_path)
+{
+    struct timespec ts;
+    uint64_t deadline;
+    uint64_t units;
+    bool progressed;
+
+    if (syscall(SYS_tgkill, getpid(), tid, SIGUSR1) < 0)
+    {
+        cerr << "freeze: could not signal thread " << tid << endl;
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += FREEZE_TIMEOUT_MSEC / 1000;
+    if (sem_timedwait(&frozen_sem, &ts) < 0)
+    {
+        cerr << "freeze: thread " << tid << " did not freeze" << endl;
+        return -1;
+    }
+
+    units = hot_path.units.load();
+    deadline = now_nsec() + FREEZE_TIMEOUT_MSEC * 1000000ULL;
+    while (hot_path.units.load() < units + FREEZE_UNITS &&
+            now_nsec() < deadline)
+    {
+        sched_yield();
+    }
+    progressed = hot_path.units.load() >= units + FREEZE_UNITS;
+
+    /* Thaw it even on failure, the locks it holds would never be
+       released otherwise. */
+    sem_post(&thaw_sem);
+    CHECK(progressed, "freeze: hot path blocked while thread " << tid <<
+            " was frozen");
+    return 0;
+}
+
+static int
+check_hot_path(uint32_t num_freezes)
+{
+    NvMetricsRegistry &registry = NvMetricsRegistry::getInstance();
+    vector<TestElement *> elements;
+    hot_path_t hot_path;
+    atomic<bool> stop_client(false);
+    pthread_t hot_thread;
+    pthread_t client_thread;
+    struct sigaction action;
+    pid_t sampler_tid, server_tid;
+    int ret = 0;
+
+    /* Enough elements to keep the sampler busy reading the profilers. */
+    for (uint32_t i = 0; i < NUM_FREEZE_ELEMENTS; i++)
+        elements.push_back(new TestElement("freeze"));
+    sem_init(&frozen_sem, 0, 0);
+    sem_init(&thaw_sem, 0, 0);
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = freeze_handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+
+    CHECK(registry.startExporter(1, 100, 0, SOCKET_PATH, NULL) == 0,
+            "freeze: could not start the exporter");
+    sampler_tid = find_thread("MetricsSampler");
+    server_tid = find_thread("MetricsServer");
+    if (!sampler_tid || !server_tid)
+    {
+        cerr << "freeze: metrics threads not found" << endl;
+        registry.stopExporter();
+        return -1;
+    }
+
+    hot_path.elements = &elements;
+    hot_path.units = 0;
+    hot_path.stop = false;
+    pthread_create(&hot_thread, NULL, hot_path_fcn, &hot_path);
+    pthread_create(&client_thread, NULL, client_fcn, &stop_client);
+
+    /* Alternate between the threads, at random points of their loops. */
+    for (uint32_t i = 0; i < num_freezes && ret == 0; i++)
+    {
+        sleep_usec(next_rand() % 2000);
+        ret = freeze_thread(i % 2 ? server_tid : sampler_tid, hot_path);
+    }
+
+    hot_path.stop = true;
+    stop_client = true;
+    pthread_join(hot_thread, NULL);
+    pthread_join(client_thread, NULL);
+    registry.stopExporter();
+    signal(SIGUSR1, SIG_DFL);
+    sem_destroy(&frozen_sem);
+    sem_destroy(&thaw_sem);
+    for (size_t i = 0; i < elements.size(); i++)
+        delete elements[i];
+    CHECK(ret == 0, "freeze: failed after " << hot_path.units.load() <<
+            " units");
+
+    cout << "freeze: " << num_freezes << " freezes, " <<
+        hot_path.units.load() << " hot path units" << endl;
+    cout << "freeze: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: metrics_sample [OPTIONS]" << endl << endl;
+    cout << "\t-r <fps>     Rate of the window check [Default = "
+        << DEFAULT_RATE << "]" << endl;
+    cout << "\t-f <count>   Number of times the metrics threads are frozen "
+        "[Default = " << DEFAULT_FREEZES << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t rate = DEFAULT_RATE;
+    uint32_t num_freezes = DEFAULT_FREEZES;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:f:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r':
+                rate = atoi(optarg);
+                break;
+            case 'f':
+                num_freezes = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (rate < 1 || rate > 1000)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_window(rate) < 0 || check_percentiles() < 0 ||
+            check_export() < 0 || check_hot_path(num_freezes) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
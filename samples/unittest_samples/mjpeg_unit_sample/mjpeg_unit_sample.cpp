@@ -0,0 +1,790 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./mjpeg_sample [-n images] [-v]
+ * Example:
+ * ./mjpeg_sample
+ * ./mjpeg_sample -n 10000
+**/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "NvMjpegReader.h"
+#include "NvBuffer.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of NvMjpegReader.
+ *
+ * A synthetic MJPEG file is built along with the offset, size and
+ * resolution of each of its images. The images have fill bytes before
+ * markers, APP1 payloads containing FF D8 and FF D9, byte stuffing and
+ * restart markers in the entropy-coded data, progressive scans, and end
+ * at odd and even offsets. Garbage separates some images, and some
+ * images are truncated.
+ *
+ * - findMarker() matches a scalar reference on short buffers at every
+ *   alignment, covering the vector scan and its tail;
+ * - parseFrame() returns the size and resolution of each complete image,
+ *   and 0 once its first or last byte is cut;
+ * - the index holds exactly the complete images, and both
+ *   readNextFrame() and getNextFrame() return their bytes;
+ * - the reader rewinds on end of stream and rejects a buffer too small
+ *   for an image without advancing.
+ *
+ * The index, readNextFrame() and getNextFrame() are then timed on a larger
+ * file, along with the two byte at a time splitter the decoder samples
+ * used before, which also reports how many of its chunks are images.
+ */
+
+#define MJPEG_PATH "mjpeg_sample.mjpeg"
+
+#define BUFFER_SIZE (4 << 20)
+#define DEFAULT_BENCHMARK_IMAGES 1000
+#define FIND_MARKER_ITERATIONS 200000
+
+#define JPEG_MARKER_SOF0 0xC0
+#define JPEG_MARKER_SOF2 0xC2
+#define JPEG_MARKER_DHT  0xC4
+#define JPEG_MARKER_RST0 0xD0
+#define JPEG_MARKER_SOI  0xD8
+#define JPEG_MARKER_EOI  0xD9
+#define JPEG_MARKER_SOS  0xDA
+#define JPEG_MARKER_DQT  0xDB
+#define JPEG_MARKER_DRI  0xDD
+#define JPEG_MARKER_APP0 0xE0
+#define JPEG_MARKER_APP1 0xE1
+#define JPEG_MARKER_COM  0xFE
+
+#define IS_MJPEG_START(buffer_ptr) (buffer_ptr[0] == 0xFF && buffer_ptr[1] == 0xD8)
+#define IS_MJPEG_END(buffer_ptr) (buffer_ptr[0] == 0xFF && buffer_ptr[1] == 0xD9)
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/**
+ * Complete image of a synthetic file.
+ */
+typedef struct
+{
+    uint64_t offset;
+    uint32_t size;
+    uint16_t width;
+    uint16_t height;
+} expected_image_t;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+put_be16(vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+/**
+  * Random byte other than FF, so that only the markers put on purpose
+  * appear outside segment payloads.
+  */
+static uint8_t
+random_byte()
+{
+    return next_rand() % 255;
+}
+
+static void
+put_marker(vector<uint8_t> &out, uint8_t marker)
+{
+    /* Any marker may be preceded by fill bytes. */
+    if (next_rand() % 8 == 0)
+    {
+        out.insert(out.end(), 1 + next_rand() % 3, 0xFF);
+    }
+    out.push_back(0xFF);
+    out.push_back(marker);
+}
+
+static void
+put_segment(vector<uint8_t> &out, uint8_t marker,
+        const vector<uint8_t> &payload)
+{
+    put_marker(out, marker);
+    put_be16(out, payload.size() + 2);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+/**
+  * Segment payload with FF D8 and FF D9 sequences, as in an EXIF
+  * thumbnail. The SOI markers do not start an image, should a truncated
+  * image leave them outside a segment.
+  */
+static vector<uint8_t>
+random_payload(uint32_t size)
+{
+    vector<uint8_t> payload;
+
+    while (payload.size() < size)
+    {
+        switch (next_rand() % 64)
+        {
+            case 0:
+                payload.push_back(0xFF);
+                payload.push_back(JPEG_MARKER_EOI);
+                break;
+            case 1:
+                payload.push_back(0xFF);
+                payload.push_back(JPEG_MARKER_SOI);
+                payload.push_back(random_byte());
+                break;
+            default:
+                payload.push_back(random_byte());
+                break;
+        }
+    }
+    return payload;
+}
+
+/**
+  * Entropy-coded data: FF bytes are stuffed with 00, restart markers
+  * every @a restart_interval bytes when not 0.
+  */
+static void
+put_entropy_data(vector<uint8_t> &out, uint32_t size, uint32_t restart_interval)
+{
+    uint32_t restart = 0;
+
+    for (uint32_t i = 1; i <= size; i++)
+    {
+        if (next_rand() % 16 == 0)
+        {
+            out.push_back(0xFF);
+            out.push_back(0x00);
+        }
+        else
+        {
+            out.push_back(random_byte());
+        }
+        if (restart_interval && i % restart_interval == 0 && i < size)
+        {
+            put_marker(out, JPEG_MARKER_RST0 + restart++ % 8);
+        }
+    }
+}
+
+/**
+  * Appends one image to @a file. It is complete when @a truncate_at is 0,
+  * else cut after @a truncate_at bytes.
+  */
+static void
+build_image(vector<uint8_t> &file, uint16_t width, uint16_t height,
+        uint32_t entropy_size, uint32_t truncate_at,
+        vector<expected_image_t> &expected)
+{
+    vector<uint8_t> image;
+    vector<uint8_t> payload;
+    expected_image_t entry;
+    bool progressive = next_rand() % 4 == 0;
+    uint32_t restart_interval = next_rand() % 2 ? 0 : 64 + next_rand() % 1024;
+    uint32_t num_scans = progressive ? 2 + next_rand() % 3 : 1;
+    size_t fill;
+
+    put_marker(image, JPEG_MARKER_SOI);
+    /* Of a run of fill bytes, the image starts at the last FF. */
+    for (fill = 0; image[fill + 1] == 0xFF; fill++);
+
+    const char jfif[] = "JFIF\0\1\1\0\0\1\0\1\0\0";
+    payload.assign(jfif, jfif + sizeof(jfif) - 1);
+    put_segment(image, JPEG_MARKER_APP0, payload);
+    if (next_rand() % 2)
+    {
+        put_segment(image, JPEG_MARKER_APP1,
+                random_payload(20 + next_rand() % 4000));
+    }
+    put_segment(image, JPEG_MARKER_DQT, random_payload(65));
+
+    payload.clear();
+    payload.push_back(8);
+    put_be16(payload, height);
+    put_be16(payload, width);
+    payload.push_back(3);
+    for (uint8_t c = 1; c <= 3; c++)
+    {
+        payload.push_back(c);
+        payload.push_back(c == 1 ? 0x22 : 0x11);
+        payload.push_back(c != 1);
+    }
+    put_segment(image, progressive ? JPEG_MARKER_SOF2 : JPEG_MARKER_SOF0,
+            payload);
+
+    if (restart_interval)
+    {
+        payload.clear();
+        put_be16(payload, restart_interval);
+        put_segment(image, JPEG_MARKER_DRI, payload);
+    }
+
+    for (uint32_t scan = 0; scan < num_scans; scan++)
+    {
+        put_segment(image, JPEG_MARKER_DHT,
+                random_payload(30 + next_rand() % 400));
+        if (next_rand() % 8 == 0)
+        {
+            put_segment(image, JPEG_MARKER_COM,
+                    random_payload(1 + next_rand() % 64));
+        }
+        put_segment(image, JPEG_MARKER_SOS, random_payload(10));
+        put_entropy_data(image, entropy_size / num_scans, restart_interval);
+    }
+    put_marker(image, JPEG_MARKER_EOI);
+
+    if (truncate_at)
+    {
+        image.resize(fill + truncate_at % (image.size() - fill - 1));
+    }
+    else
+    {
+        entry.offset = file.size() + fill;
+        entry.size = image.size() - fill;
+        entry.width = width;
+        entry.height = height;
+        expected.push_back(entry);
+    }
+    file.insert(file.end(), image.begin(), image.end());
+}
+
+/**
+  * Garbage between images: random bytes, SOI markers which do not start
+  * an image and, with @a eoi, EOI markers. A truncated image followed by
+  * an EOI would be indistinguishable from a complete one.
+  */
+static void
+put_garbage(vector<uint8_t> &file, uint32_t size, bool eoi)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        switch (next_rand() % 32)
+        {
+            case 0:
+                file.push_back(0xFF);
+                file.push_back(JPEG_MARKER_SOI);
+                file.push_back(random_byte());
+                break;
+            case 1:
+                if (eoi)
+                {
+                    file.push_back(0xFF);
+                    file.push_back(JPEG_MARKER_EOI);
+                }
+                break;
+            default:
+                file.push_back(random_byte());
+                break;
+        }
+    }
+}
+
+/**
+  * Builds a file of @a num_images images. Every 16th is truncated and
+  * followed by garbage, and the last one is truncated at the end of the
+  * file.
+  */
+static void
+build_mjpeg(uint32_t num_images, uint16_t width, uint16_t height,
+        uint32_t max_entropy_size, vector<uint8_t> &file,
+        vector<expected_image_t> &expected)
+{
+    file.clear();
+    expected.clear();
+    put_garbage(file, next_rand() % 16, true);
+    for (uint32_t i = 0; i < num_images; i++)
+    {
+        uint16_t w = width ? width : 16 + next_rand() % 4096;
+        uint16_t h = height ? height : 16 + next_rand() % 4096;
+        bool truncate = i % 16 == 15 || i == num_images - 1;
+
+        build_image(file, w, h, 1 + next_rand() % max_entropy_size,
+                truncate ? 1 + next_rand() : 0, expected);
+        if (truncate || next_rand() % 8 == 0)
+        {
+            put_garbage(file, next_rand() % 64, !truncate);
+        }
+    }
+}
+
+static int
+write_file(const vector<uint8_t> &file)
+{
+    ofstream out(MJPEG_PATH, ios::binary);
+
+    out.write((const char *) file.data(), file.size());
+    out.close();
+    CHECK(out, "Could not write " << MJPEG_PATH);
+    return 0;
+}
+
+static const uint8_t *
+find_marker_reference(const uint8_t *begin, const uint8_t *end)
+{
+    for (const uint8_t *p = begin; end - p >= 2; p++)
+    {
+        if (p[0] == 0xFF && p[1] != 0x00 && p[1] != 0xFF)
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+/**
+  * Compares findMarker() with a scalar reference on buffers of 0 to 79
+  * bytes at every alignment, with varying densities of FF bytes.
+  */
+static int
+check_find_marker()
+{
+    static const uint8_t values[] = { 0xFF, 0xFF, 0x00, 0xD9, 0xD0, 0x12 };
+    uint8_t buf[96];
+
+    for (uint32_t i = 0; i < FIND_MARKER_ITERATIONS; i++)
+    {
+        uint32_t offset = next_rand() % 16;
+        uint32_t length = next_rand() % 80;
+        uint32_t density = 1 + next_rand() % 64;
+        const uint8_t *begin = buf + offset;
+        const uint8_t *end = begin + length;
+        const uint8_t *found;
+
+        for (uint32_t j = 0; j < sizeof(buf); j++)
+        {
+            buf[j] = next_rand() % density == 0 ?
+                values[next_rand() % sizeof(values)] : random_byte();
+        }
+        found = NvMjpegReader::findMarker(begin, end);
+        CHECK(found == find_marker_reference(begin, end),
+                "findMarker returned offset " << found - begin <<
+                " instead of " << find_marker_reference(begin, end) - begin <<
+                " on " << length << " bytes at alignment " << offset);
+    }
+    cout << "findMarker: " << FIND_MARKER_ITERATIONS << " buffers: OK" << endl;
+    return 0;
+}
+
+/**
+  * parseFrame() on each image alone, followed by other bytes, and cut.
+  */
+static int
+check_parse_frame(const vector<uint8_t> &file,
+        const vector<expected_image_t> &expected)
+{
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        const uint8_t *begin = file.data() + expected[i].offset;
+        uint16_t width = 0;
+        uint16_t height = 0;
+
+        CHECK(NvMjpegReader::parseFrame(begin, begin + expected[i].size,
+                    &width, &height) == expected[i].size &&
+                width == expected[i].width && height == expected[i].height,
+                "parseFrame differs on image " << i << ": " << width << "x" <<
+                height);
+        CHECK(NvMjpegReader::parseFrame(begin, file.data() + file.size()) ==
+                expected[i].size,
+                "parseFrame differs on image " << i << " followed by data");
+        CHECK(NvMjpegReader::parseFrame(begin, begin + expected[i].size - 1) ==
+                0, "parseFrame accepted image " << i << " without its last byte");
+        CHECK(NvMjpegReader::parseFrame(begin + 1, begin + expected[i].size) ==
+                0, "parseFrame accepted image " << i << " without its SOI");
+    }
+    cout << "parseFrame: " << expected.size() << " images: OK" << endl;
+    return 0;
+}
+
+static int
+check_reader(const vector<uint8_t> &file,
+        const vector<expected_image_t> &expected)
+{
+    NvMjpegReader *reader = NvMjpegReader::createMjpegReader(MJPEG_PATH);
+    const NvMjpegReader::NvMjpegFrame *frame;
+    NvBuffer buffer(BUFFER_SIZE, 0);
+    uint32_t loop, size;
+    size_t i;
+
+    CHECK(reader, "Could not open the file");
+    CHECK(buffer.allocateMemory() == 0, "Could not allocate the buffer");
+    CHECK(reader->getFileSize() == file.size() &&
+            reader->getNumFrames() == expected.size(),
+            "Indexed " << reader->getNumFrames() << " images, expected " <<
+            expected.size());
+
+    for (i = 0; i < expected.size(); i++)
+    {
+        const NvMjpegReader::NvMjpegFrame &entry = reader->getFrame(i);
+
+        CHECK(entry.offset == expected[i].offset &&
+                entry.size == expected[i].size &&
+                entry.width == expected[i].width &&
+                entry.height == expected[i].height &&
+                reader->getFrameData(i) == reader->getFrameData(0) +
+                    (entry.offset - reader->getFrame(0).offset),
+                "Image " << i << " indexed at " << entry.offset << ", size " <<
+                entry.size << ", expected " << expected[i].offset << ", size " <<
+                expected[i].size);
+    }
+
+    /* The reader rewinds itself on end of stream. */
+    for (loop = 0; loop < 2; loop++)
+    {
+        for (i = 0; i < expected.size(); i++)
+        {
+            const uint8_t *data = file.data() + expected[i].offset;
+
+            CHECK(reader->readNextFrame(&buffer, &frame) == 0 &&
+                    frame == &reader->getFrame(i) &&
+                    buffer.planes[0].bytesused == expected[i].size &&
+                    !memcmp(buffer.planes[0].data, data, expected[i].size),
+                    "readNextFrame differs at image " << i);
+        }
+        CHECK(reader->readNextFrame(&buffer, &frame) == 0 && !frame &&
+                buffer.planes[0].bytesused == 0,
+                "readNextFrame did not report end of stream");
+
+        for (i = 0; i < expected.size(); i++)
+        {
+            const uint8_t *span = reader->getNextFrame(size, &frame);
+
+            CHECK(span && frame == &reader->getFrame(i) &&
+                    size == expected[i].size &&
+                    !memcmp(span, file.data() + expected[i].offset, size),
+                    "getNextFrame differs at image " << i);
+        }
+        CHECK(!reader->getNextFrame(size, &frame) && !frame && size == 0,
+                "getNextFrame did not report end of stream");
+    }
+
+    buffer.planes[0].length = expected[0].size - 1;
+    CHECK(reader->readNextFrame(&buffer) == -1 &&
+            buffer.planes[0].bytesused == 0,
+            "Buffer too small not rejected");
+    buffer.planes[0].length = expected[0].size;
+    CHECK(reader->readNextFrame(&buffer) == 0 &&
+            buffer.planes[0].bytesused == expected[0].size,
+            "Reader advanced past a rejected image");
+    buffer.planes[0].length = BUFFER_SIZE;
+    delete reader;
+
+    cout << "Reader: " << expected.size() << " images: OK" << endl;
+    return 0;
+}
+
+/**
+  * Files without complete images.
+  */
+static int
+check_empty_files()
+{
+    vector<expected_image_t> expected;
+    vector<uint8_t> file;
+    NvBuffer buffer(BUFFER_SIZE, 0);
+    NvMjpegReader *reader;
+
+    CHECK(buffer.allocateMemory() == 0, "Could not allocate the buffer");
+
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    reader = NvMjpegReader::createMjpegReader(MJPEG_PATH);
+    CHECK(reader && reader->getNumFrames() == 0 &&
+            reader->readNextFrame(&buffer) == 0 &&
+            buffer.planes[0].bytesused == 0, "Empty file not handled");
+    delete reader;
+
+    build_mjpeg(1, 0, 0, 1000, file, expected);
+    put_garbage(file, 4096, false);
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    reader = NvMjpegReader::createMjpegReader(MJPEG_PATH);
+    CHECK(reader && reader->getNumFrames() == 0,
+            "Image found in garbage and a truncated image");
+    delete reader;
+
+    cout << "Files without images: OK" << endl;
+    return 0;
+}
+
+static int
+check_files()
+{
+    vector<expected_image_t> expected;
+    vector<uint8_t> file;
+
+    if (check_find_marker() < 0)
+    {
+        return -1;
+    }
+    build_mjpeg(500, 0, 0, 20000, file, expected);
+    if (write_file(file) < 0 || check_parse_frame(file, expected) < 0 ||
+        check_reader(file, expected) < 0)
+    {
+        return -1;
+    }
+    return check_empty_files();
+}
+
+/**
+  * The MJPEG splitter of the decoder samples before NvMjpegReader. It
+  * reads two bytes at a time until FF D9, so it only finds an EOI at an
+  * even offset from the SOI, and ends an image early at FF D9 in a
+  * segment payload. It read char data, which only compares equal to FF
+  * where char is unsigned, as on the Jetson, and did not stop at the end
+  * of the file or of the buffer.
+  */
+static int
+read_mjpeg_chunk_ifstream(ifstream *stream, NvBuffer *buffer)
+{
+    uint8_t *buffer_ptr = buffer->planes[0].data;
+    uint8_t *buffer_end = buffer_ptr + buffer->planes[0].length;
+
+    buffer->planes[0].bytesused = 0;
+    stream->read((char *) buffer_ptr, 2);
+    buffer->planes[0].bytesused += stream->gcount();
+    if (IS_MJPEG_START(buffer_ptr))
+    {
+        while (!IS_MJPEG_END(buffer_ptr))
+        {
+            buffer_ptr += 2;
+            if (buffer_end - buffer_ptr < 2)
+            {
+                cerr << "Chunk does not fit in the buffer" << endl;
+                return -1;
+            }
+            stream->read((char *) buffer_ptr, 2);
+            buffer->planes[0].bytesused += stream->gcount();
+            if (stream->gcount() < 2)
+            {
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+  * Times the index, readNextFrame(), getNextFrame() and the old splitter
+  * on a file of @a num_images 640x480 images.
+  */
+static int
+benchmark(uint32_t num_images)
+{
+    vector<expected_image_t> expected;
+    vector<uint8_t> file;
+    NvBuffer buffer(BUFFER_SIZE, 0);
+    NvMjpegReader *reader;
+    ifstream stream;
+    uint64_t checksum = 0;
+    uint64_t position = 0;
+    uint64_t file_size;
+    uint64_t t0, index_nsec, read_nsec, span_nsec, old_nsec;
+    uint32_t num_chunks = 0;
+    uint32_t num_matching = 0;
+    size_t next = 0;
+
+    build_mjpeg(num_images, 640, 480, 60000, file, expected);
+    file_size = file.size();
+    if (write_file(file) < 0)
+    {
+        return -1;
+    }
+    file.clear();
+    CHECK(buffer.allocateMemory() == 0, "Could not allocate the buffer");
+
+    t0 = now_nsec();
+    reader = NvMjpegReader::createMjpegReader(MJPEG_PATH);
+    index_nsec = now_nsec() - t0;
+    CHECK(reader && reader->getNumFrames() == expected.size(),
+            "Could not index the benchmark file");
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        CHECK(reader->getFrame(i).offset == expected[i].offset &&
+                reader->getFrame(i).size == expected[i].size,
+                "Benchmark image " << i << " indexed wrongly");
+    }
+
+    t0 = now_nsec();
+    while (reader->readNextFrame(&buffer) == 0 && buffer.planes[0].bytesused)
+    {
+        checksum += buffer.planes[0].data[0];
+    }
+    read_nsec = now_nsec() - t0;
+
+    t0 = now_nsec();
+    {
+        const uint8_t *span;
+        uint32_t size;
+
+        while ((span = reader->getNextFrame(size)) != NULL)
+        {
+            checksum += span[size - 1];
+        }
+    }
+    span_nsec = now_nsec() - t0;
+    delete reader;
+
+    t0 = now_nsec();
+    stream.open(MJPEG_PATH, ios::binary);
+    for (;;)
+    {
+        if (read_mjpeg_chunk_ifstream(&stream, &buffer) < 0)
+        {
+            return -1;
+        }
+        if (buffer.planes[0].bytesused == 0)
+        {
+            break;
+        }
+        while (next < expected.size() && expected[next].offset < position)
+        {
+            next++;
+        }
+        if (next < expected.size() && expected[next].offset == position &&
+            expected[next].size == buffer.planes[0].bytesused)
+        {
+            num_matching++;
+        }
+        if (buffer.planes[0].bytesused > 2)
+        {
+            num_chunks++;
+        }
+        position += buffer.planes[0].bytesused;
+    }
+    old_nsec = now_nsec() - t0;
+
+    cout << "Benchmark file: " << num_images << " images, " <<
+        expected.size() << " complete, " << file_size / 1000000.0 << " MB" <<
+        endl;
+    cout << "Index: " << index_nsec / 1000000.0 << " ms (" <<
+        file_size / (double) index_nsec << " GB/s)" << endl;
+    cout << "readNextFrame: " << read_nsec / 1000000.0 << " ms (" <<
+        expected.size() * 1000000000.0 / read_nsec << " images/s)" << endl;
+    cout << "getNextFrame: " << span_nsec / 1000000.0 << " ms" << endl;
+    cout << "Two byte splitter: " << old_nsec / 1000000.0 << " ms, " <<
+        num_chunks << " chunks, " << num_matching << " of them images" << endl;
+    /* Keeps the reads from being optimized out. */
+    return checksum == 0 ? -1 : 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: mjpeg_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Images of the benchmark file [Default = "
+        << DEFAULT_BENCHMARK_IMAGES << "]" << endl;
+    cout << "\t-v           Print the errors and warnings of the reader on"
+        " malformed files" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_images = DEFAULT_BENCHMARK_IMAGES;
+    int ret = 0;
+    int opt;
+
+    /* Some reads and images are invalid on purpose. */
+    log_level = LOG_LEVEL_INFO;
+
+    while ((opt = getopt(argc, argv, "n:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_images = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_WARN;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_images < 2)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_files() < 0 || benchmark(num_images) < 0)
+    {
+        ret = -1;
+    }
+    unlink(MJPEG_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
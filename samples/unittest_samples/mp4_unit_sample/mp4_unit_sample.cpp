@@ -0,0 +1,1362 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./mp4_sample [-k]
+ * Example:
+ * ./mp4_sample
+**/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include "NvMp4Muxer.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvMp4Muxer.
+ *
+ * Synthetic H.264, H.265 and AV1 streams are built as the encoders output
+ * them: parameter sets first, then access units with start codes, AUDs,
+ * SEIs, repeated parameter sets, B-frames, IVF headers or OBUs without a
+ * size field. Each stream is muxed, then the file is parsed back and
+ * checked box by box:
+ *
+ * - the boxes nest exactly and the file ends with the last fragment;
+ * - the sample entry carries the avcC, hvcC or av1C built independently
+ *   from the parameter sets;
+ * - the sample tables of the moov are empty, and each moof holds one GOP
+ *   with a trun pointing at its mdat;
+ * - every sample has the expected payload, sync flag and presentation
+ *   time, and decode times increase across fragments.
+ */
+
+#define MUX_PATH "mp4_sample.mp4"
+
+#define TIMESCALE 90000
+#define FRAME_DURATION_US 33333
+#define FIRST_PTS_US 5000000
+
+#define SAMPLE_FLAGS_SYNC 0x02000000
+#define SAMPLE_FLAGS_NON_SYNC 0x01010000
+#define TRUN_REQUIRED_FLAGS 0x000701
+#define TRUN_SAMPLE_CTO_PRESENT 0x000800
+#define TFHD_DEFAULT_BASE_IS_MOOF 0x020000
+
+#define SCENARIO_ZERO_TS    (1 << 0)
+#define SCENARIO_BIG_FRAMES (1 << 1)
+#define SCENARIO_PS_CHANGE  (1 << 2)
+#define SCENARIO_IVF        (1 << 3)
+#define SCENARIO_NO_SIZE    (1 << 4)
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+/**
+ * Describes one stream to mux and check.
+ */
+typedef struct
+{
+    const char *name;
+    uint32_t pixfmt;
+    uint32_t num_frames;
+    uint32_t gop;
+    uint32_t bframes;
+    uint32_t flags;             /**< SCENARIO_* values. */
+    uint32_t width;
+    uint32_t height;
+
+    uint32_t profile;
+    uint32_t level;
+    uint32_t tier;
+    uint32_t chroma_format_idc;
+    uint32_t bit_depth_luma_minus8;
+    uint32_t bit_depth_chroma_minus8;
+
+    /* H.264 */
+    uint32_t sps_id;
+    /* H.265 */
+    uint32_t max_sub_layers_minus1;
+    uint32_t sub_layer_profile_present;   /**< Bit i set for sub-layer i. */
+    uint32_t sub_layer_level_present;     /**< Bit i set for sub-layer i. */
+    bool conformance_window;
+    /* AV1 */
+    bool reduced_still_picture_header;
+    bool twelve_bit;
+    bool mono_chrome;
+    uint32_t subsampling_x;
+    uint32_t subsampling_y;
+    uint32_t chroma_sample_position;
+    uint8_t color_description[3];       /**< All 0 when absent. */
+} scenario_t;
+
+/**
+ * Sample the muxer must write for a frame.
+ */
+typedef struct
+{
+    vector<uint8_t> data;
+    bool key_frame;
+    uint64_t pts;
+} expected_sample_t;
+
+/**
+ * Box found in the file.
+ */
+typedef struct
+{
+    char type[5];
+    size_t offset;
+    size_t size;
+} box_t;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+/**
+ * Writes the bits of a parameter set, most significant bit first.
+ */
+class BitWriter
+{
+public:
+    BitWriter()
+        :num_bits(0)
+    {
+    }
+
+    void put(uint32_t n, uint64_t value)
+    {
+        for (uint32_t i = n; i > 0; i--)
+        {
+            putBit((value >> (i - 1)) & 1);
+        }
+    }
+
+    /** Exp-Golomb ue(v), also the uvlc() of AV1. */
+    void putUe(uint32_t value)
+    {
+        uint64_t v = (uint64_t) value + 1;
+        uint32_t n = 0;
+
+        while ((v >> n) > 1)
+        {
+            n++;
+        }
+        put(n, 0);
+        put(n + 1, v);
+    }
+
+    void putTrailingBits()
+    {
+        putBit(1);
+        while (num_bits & 7)
+        {
+            putBit(0);
+        }
+    }
+
+    const vector<uint8_t> &getBytes() const
+    {
+        return bytes;
+    }
+
+private:
+    void putBit(uint32_t bit)
+    {
+        if (!(num_bits & 7))
+        {
+            bytes.push_back(0);
+        }
+        if (bit)
+        {
+            bytes.back() |= 0x80 >> (num_bits & 7);
+        }
+        num_bits++;
+    }
+
+    vector<uint8_t> bytes;
+    uint64_t num_bits;
+};
+
+static void
+put_u16(vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void
+put_u32(vector<uint8_t> &out, uint32_t value)
+{
+    put_u16(out, value >> 16);
+    put_u16(out, value);
+}
+
+static void
+put_le16(vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(value);
+    out.push_back(value >> 8);
+}
+
+static void
+put_le32(vector<uint8_t> &out, uint32_t value)
+{
+    put_le16(out, value);
+    put_le16(out, value >> 16);
+}
+
+static void
+put_leb128(vector<uint8_t> &out, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(byte | (value ? 0x80 : 0));
+    } while (value);
+}
+
+static void
+append(vector<uint8_t> &out, const vector<uint8_t> &data)
+{
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+static uint32_t
+get_u32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static uint64_t
+get_u64(const uint8_t *p)
+{
+    return ((uint64_t) get_u32(p) << 32) | get_u32(p + 4);
+}
+
+/**
+  * Inserts the emulation prevention bytes of a NAL unit payload.
+  */
+static vector<uint8_t>
+escape_rbsp(const vector<uint8_t> &rbsp)
+{
+    vector<uint8_t> out;
+    uint32_t zeros = 0;
+
+    for (size_t i = 0; i < rbsp.size(); i++)
+    {
+        if (zeros >= 2 && rbsp[i] <= 3)
+        {
+            out.push_back(3);
+            zeros = 0;
+        }
+        out.push_back(rbsp[i]);
+        zeros = rbsp[i] ? 0 : zeros + 1;
+    }
+    return out;
+}
+
+/**
+  * Random bytes without zeros, which never emulate a start code.
+  */
+static vector<uint8_t>
+random_payload(vector<uint8_t> header, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        header.push_back(next_rand() % 255 + 1);
+    }
+    return header;
+}
+
+static vector<uint8_t>
+build_h264_sps(const scenario_t &s, uint32_t level)
+{
+    BitWriter bw;
+    vector<uint8_t> sps(1, 0x67);
+
+    bw.put(8, s.profile);
+    bw.put(8, 0);                   /* constraint flags */
+    bw.put(8, level);
+    bw.putUe(s.sps_id);
+    if (s.profile == 100 || s.profile == 110 || s.profile == 122 ||
+        s.profile == 244 || s.profile == 44 || s.profile == 83 ||
+        s.profile == 86 || s.profile == 118 || s.profile == 128)
+    {
+        bw.putUe(s.chroma_format_idc);
+        if (s.chroma_format_idc == 3)
+        {
+            bw.put(1, 0);
+        }
+        bw.putUe(s.bit_depth_luma_minus8);
+        bw.putUe(s.bit_depth_chroma_minus8);
+        bw.put(2, 0);               /* no scaling matrices */
+    }
+    bw.putUe(0);                    /* log2_max_frame_num_minus4 */
+    bw.putUe(2);                    /* pic_order_cnt_type */
+    bw.putUe(1);                    /* max_num_ref_frames */
+    bw.put(1, 0);
+    bw.putUe(s.width / 16 - 1);
+    bw.putUe(s.height / 16 - 1);
+    bw.put(4, 0xC);                 /* frame_mbs_only, direct_8x8 */
+    bw.putTrailingBits();
+    append(sps, escape_rbsp(bw.getBytes()));
+    return sps;
+}
+
+static vector<uint8_t>
+build_avcc(const scenario_t &s, const vector<uint8_t> &sps,
+        const vector<uint8_t> &pps)
+{
+    vector<uint8_t> config;
+
+    config.push_back(1);
+    config.push_back(sps[1]);
+    config.push_back(sps[2]);
+    config.push_back(sps[3]);
+    config.push_back(0xFF);
+    config.push_back(0xE1);
+    put_u16(config, sps.size());
+    append(config, sps);
+    config.push_back(1);
+    put_u16(config, pps.size());
+    append(config, pps);
+    if (s.profile == 100 || s.profile == 110 || s.profile == 122 ||
+        s.profile == 144)
+    {
+        config.push_back(0xFC | s.chroma_format_idc);
+        config.push_back(0xF8 | s.bit_depth_luma_minus8);
+        config.push_back(0xF8 | s.bit_depth_chroma_minus8);
+        config.push_back(0);
+    }
+    return config;
+}
+
+static vector<uint8_t>
+build_h265_sps_rbsp(const scenario_t &s)
+{
+    BitWriter bw;
+    uint32_t i;
+
+    bw.put(4, 0);                   /* sps_video_parameter_set_id */
+    bw.put(3, s.max_sub_layers_minus1);
+    bw.put(1, 1);                   /* sps_temporal_id_nesting_flag */
+    bw.put(3, 0);                   /* profile_space, tier_flag */
+    bw.put(5, s.profile);
+    bw.put(32, 0x60000000);         /* profile_compatibility_flags */
+    bw.put(48, 0x900000000000ULL);  /* constraint flags */
+    bw.put(8, s.level);
+    for (i = 0; i < s.max_sub_layers_minus1; i++)
+    {
+        bw.put(1, (s.sub_layer_profile_present >> i) & 1);
+        bw.put(1, (s.sub_layer_level_present >> i) & 1);
+    }
+    if (s.max_sub_layers_minus1 > 0)
+    {
+        for (i = s.max_sub_layers_minus1; i < 8; i++)
+        {
+            bw.put(2, 0);
+        }
+    }
+    for (i = 0; i < s.max_sub_layers_minus1; i++)
+    {
+        if ((s.sub_layer_profile_present >> i) & 1)
+        {
+            bw.put(32, 0x12345678);
+            bw.put(32, 0x9ABCDEF0);
+            bw.put(24, 0x123456);
+        }
+        if ((s.sub_layer_level_present >> i) & 1)
+        {
+            bw.put(8, 0x5A);
+        }
+    }
+    bw.putUe(0);                    /* sps_seq_parameter_set_id */
+    bw.putUe(s.chroma_format_idc);
+    if (s.chroma_format_idc == 3)
+    {
+        bw.put(1, 0);
+    }
+    bw.putUe(s.width);
+    bw.putUe(s.height);
+    bw.put(1, s.conformance_window);
+    if (s.conformance_window)
+    {
+        bw.putUe(0);
+        bw.putUe(4);
+        bw.putUe(0);
+        bw.putUe(8);
+    }
+    bw.putUe(s.bit_depth_luma_minus8);
+    bw.putUe(s.bit_depth_chroma_minus8);
+    bw.putUe(4);                    /* log2_max_pic_order_cnt_lsb_minus4 */
+    bw.putTrailingBits();
+    return bw.getBytes();
+}
+
+static vector<uint8_t>
+build_hvcc(const scenario_t &s, const vector<uint8_t> &sps_rbsp,
+        const vector<uint8_t> *parameter_sets[3])
+{
+    vector<uint8_t> config;
+
+    config.push_back(1);
+    config.insert(config.end(), sps_rbsp.begin() + 1, sps_rbsp.begin() + 13);
+    config.push_back(0xF0);
+    config.push_back(0x00);
+    config.push_back(0xFC);
+    config.push_back(0xFC | s.chroma_format_idc);
+    config.push_back(0xF8 | s.bit_depth_luma_minus8);
+    config.push_back(0xF8 | s.bit_depth_chroma_minus8);
+    put_u16(config, 0);
+    config.push_back(((s.max_sub_layers_minus1 + 1) << 3) | (1 << 2) | 3);
+    config.push_back(3);
+    for (int i = 0; i < 3; i++)
+    {
+        config.push_back(0x80 | (32 + i));
+        put_u16(config, 1);
+        put_u16(config, parameter_sets[i]->size());
+        append(config, *parameter_sets[i]);
+    }
+    return config;
+}
+
+/**
+  * Builds an AV1 sequence header OBU payload and the matching av1C.
+  */
+static void
+build_av1_sequence_header(const scenario_t &s, vector<uint8_t> &payload,
+        vector<uint8_t> &config)
+{
+    BitWriter bw;
+    bool has_color = s.color_description[0] || s.color_description[1] ||
+        s.color_description[2];
+    bool srgb = s.color_description[0] == 1 && s.color_description[1] == 13 &&
+        s.color_description[2] == 0;
+    uint32_t high_bitdepth = s.bit_depth_luma_minus8 > 0;
+    uint32_t twelve_bit = 0;
+    uint32_t mono_chrome = 0;
+    uint32_t ssx = 0, ssy = 0, csp = 0;
+    uint32_t tier = 0;
+
+    bw.put(3, s.profile);
+    bw.put(1, 0);                   /* still_picture */
+    bw.put(1, s.reduced_still_picture_header);
+    if (s.reduced_still_picture_header)
+    {
+        bw.put(5, s.level);
+    }
+    else
+    {
+        bw.put(1, 0);               /* timing_info_present_flag */
+        bw.put(1, 0);               /* initial_display_delay_present_flag */
+        bw.put(5, 0);               /* operating_points_cnt_minus_1 */
+        bw.put(12, 0);              /* operating_point_idc[0] */
+        bw.put(5, s.level);
+        if (s.level > 7)
+        {
+            tier = s.tier;
+            bw.put(1, tier);
+        }
+    }
+    bw.put(4, 15);                  /* frame_width_bits_minus_1 */
+    bw.put(4, 15);
+    bw.put(16, s.width - 1);
+    bw.put(16, s.height - 1);
+    if (!s.reduced_still_picture_header)
+    {
+        bw.put(1, 1);               /* frame_id_numbers_present_flag */
+        bw.put(4, 5);
+        bw.put(3, 2);
+    }
+    bw.put(3, 3);                   /* superblock size, intra filters */
+    if (!s.reduced_still_picture_header)
+    {
+        bw.put(4, 0xB);             /* inter tools */
+        bw.put(1, 1);               /* enable_order_hint */
+        bw.put(2, 3);
+        bw.put(1, 1);               /* seq_choose_screen_content_tools */
+        bw.put(1, 1);               /* seq_choose_integer_mv */
+        bw.put(3, 6);               /* order_hint_bits_minus_1 */
+    }
+    bw.put(3, 3);                   /* superres, cdef, restoration */
+
+    /* color_config() */
+    bw.put(1, high_bitdepth);
+    if (s.profile == 2 && high_bitdepth)
+    {
+        twelve_bit = s.twelve_bit;
+        bw.put(1, twelve_bit);
+    }
+    if (s.profile != 1)
+    {
+        mono_chrome = s.mono_chrome;
+        bw.put(1, mono_chrome);
+    }
+    bw.put(1, has_color);
+    if (has_color)
+    {
+        bw.put(8, s.color_description[0]);
+        bw.put(8, s.color_description[1]);
+        bw.put(8, s.color_description[2]);
+    }
+    if (mono_chrome)
+    {
+        bw.put(1, 1);               /* color_range */
+        ssx = ssy = 1;
+    }
+    else if (!srgb)
+    {
+        bw.put(1, 0);               /* color_range */
+        if (s.profile == 0)
+        {
+            ssx = ssy = 1;
+        }
+        else if (s.profile == 2 && twelve_bit)
+        {
+            ssx = s.subsampling_x;
+            bw.put(1, ssx);
+            if (ssx)
+            {
+                ssy = s.subsampling_y;
+                bw.put(1, ssy);
+            }
+        }
+        else if (s.profile == 2)
+        {
+            ssx = 1;
+        }
+        if (ssx && ssy)
+        {
+            csp = s.chroma_sample_position;
+            bw.put(2, csp);
+        }
+    }
+    bw.put(1, 0);                   /* separate_uv_delta_q */
+    bw.put(1, 0);                   /* film_grain_params_present */
+    bw.putTrailingBits();
+    payload = bw.getBytes();
+
+    config.clear();
+    config.push_back(0x81);
+    config.push_back((s.profile << 5) | s.level);
+    config.push_back((tier << 7) | (high_bitdepth << 6) | (twelve_bit << 5) |
+            (mono_chrome << 4) | (ssx << 3) | (ssy << 2) | csp);
+    config.push_back(0);
+    config.push_back(0x0A);
+    put_leb128(config, payload.size());
+    append(config, payload);
+}
+
+/**
+  * Display indices of a GOP in decode order, with @a bframes B-frames
+  * between the reference frames.
+  */
+static vector<uint32_t>
+decode_order(uint32_t gop, uint32_t bframes)
+{
+    vector<uint32_t> order(1, 0);
+    uint32_t i = 1;
+
+    while (i < gop)
+    {
+        uint32_t p = min(i + bframes, gop - 1);
+
+        order.push_back(p);
+        for (uint32_t b = i; b < p; b++)
+        {
+            order.push_back(b);
+        }
+        i = p + 1;
+    }
+    return order;
+}
+
+static void
+append_start_code(vector<uint8_t> &out)
+{
+    if (next_rand() & 1)
+    {
+        out.push_back(0);
+    }
+    out.push_back(0);
+    out.push_back(0);
+    out.push_back(1);
+}
+
+/**
+  * Builds the encoder output buffers of a scenario, the samples the muxer
+  * must write for them and the expected decoder configuration.
+  */
+static void
+build_stream(const scenario_t &s, vector<vector<uint8_t> > &buffers,
+        vector<uint64_t> &timestamps, vector<expected_sample_t> &expected,
+        vector<uint8_t> &config)
+{
+    vector<vector<uint8_t> > parameter_sets;
+    vector<uint8_t> changed_sps;
+    vector<uint8_t> sequence_header;
+    vector<uint8_t> aud, sei;
+    vector<uint32_t> order;
+    uint32_t k;
+
+    if (s.pixfmt == V4L2_PIX_FMT_H264)
+    {
+        vector<uint8_t> sps = build_h264_sps(s, s.level);
+        vector<uint8_t> pps = random_payload(vector<uint8_t>(1, 0x68), 4);
+
+        config = build_avcc(s, sps, pps);
+        changed_sps = build_h264_sps(s, s.level + 1);
+        parameter_sets.push_back(sps);
+        parameter_sets.push_back(pps);
+        aud = { 0x09, 0xF0 };
+        sei = random_payload({ 0x06, 0x05, 0x10 }, 16);
+    }
+    else if (s.pixfmt == V4L2_PIX_FMT_H265)
+    {
+        vector<uint8_t> vps = random_payload({ 0x40, 0x01 }, 6);
+        vector<uint8_t> rbsp = build_h265_sps_rbsp(s);
+        vector<uint8_t> sps = { 0x42, 0x01 };
+        vector<uint8_t> pps = random_payload({ 0x44, 0x01 }, 3);
+        const vector<uint8_t> *arrays[3] = { &vps, &sps, &pps };
+
+        append(sps, escape_rbsp(rbsp));
+        config = build_hvcc(s, rbsp, arrays);
+        changed_sps = sps;
+        changed_sps.back() ^= 0x40;
+        parameter_sets.push_back(vps);
+        parameter_sets.push_back(sps);
+        parameter_sets.push_back(pps);
+        aud = { 0x46, 0x01, 0x50 };
+        sei = random_payload({ 0x4E, 0x01 }, 10);
+    }
+    else
+    {
+        build_av1_sequence_header(s, sequence_header, config);
+    }
+
+    /* The encoders output the parameter sets alone first. */
+    if (s.pixfmt != V4L2_PIX_FMT_AV1)
+    {
+        vector<uint8_t> buffer;
+
+        for (size_t i = 0; i < parameter_sets.size(); i++)
+        {
+            append_start_code(buffer);
+            append(buffer, parameter_sets[i]);
+        }
+        buffers.push_back(buffer);
+        timestamps.push_back(0);
+    }
+
+    for (uint32_t g = 0; g < s.num_frames; g += s.gop)
+    {
+        vector<uint32_t> gop_order = decode_order(min(s.gop, s.num_frames - g),
+                s.bframes);
+
+        for (k = 0; k < gop_order.size(); k++)
+        {
+            order.push_back(g + gop_order[k]);
+        }
+    }
+
+    for (k = 0; k < order.size(); k++)
+    {
+        uint32_t display = order[k];
+        bool key_frame = display % s.gop == 0;
+        uint32_t frame_size;
+        expected_sample_t sample;
+        vector<uint8_t> buffer;
+
+        if (s.flags & SCENARIO_BIG_FRAMES)
+        {
+            frame_size = 3000000 + next_rand() % 500000;
+        }
+        else
+        {
+            frame_size = key_frame ? 2000 + next_rand() % 6000 :
+                100 + next_rand() % 2900;
+        }
+        sample.key_frame = key_frame;
+        sample.pts = (s.flags & SCENARIO_ZERO_TS) ? 0 :
+            FIRST_PTS_US + display * FRAME_DURATION_US + (display * 7) % 5;
+
+        if (s.pixfmt == V4L2_PIX_FMT_AV1)
+        {
+            vector<uint8_t> payload = random_payload(vector<uint8_t>(), frame_size);
+            vector<uint8_t> obus = { 0x12, 0x00 };
+
+            if (key_frame)
+            {
+                obus.push_back(0x0A);
+                put_leb128(obus, sequence_header.size());
+                append(obus, sequence_header);
+                sample.data = obus;
+                sample.data.erase(sample.data.begin(), sample.data.begin() + 2);
+            }
+            sample.data.push_back(0x32);
+            put_leb128(sample.data, payload.size());
+            append(sample.data, payload);
+            if ((s.flags & SCENARIO_NO_SIZE) && k % 3 == 0)
+            {
+                /* The last OBU may omit its size, the sample gets one. */
+                obus.push_back(0x30);
+                append(obus, payload);
+            }
+            else
+            {
+                obus.push_back(0x32);
+                put_leb128(obus, payload.size());
+                append(obus, payload);
+                if (k % 5 == 1)
+                {
+                    /* Padding, dropped by the muxer. */
+                    obus.insert(obus.end(), { 0x7A, 0x03, 0x01, 0x02, 0x03 });
+                }
+            }
+
+            if (s.flags & SCENARIO_IVF)
+            {
+                if (k == 0)
+                {
+                    buffer.insert(buffer.end(), { 'D', 'K', 'I', 'F' });
+                    put_le16(buffer, 0);
+                    put_le16(buffer, 32);
+                    put_le32(buffer, v4l2_fourcc('A', 'V', '0', '1'));
+                    put_le16(buffer, s.width);
+                    put_le16(buffer, s.height);
+                    put_le32(buffer, 30);
+                    put_le32(buffer, 1);
+                    put_le32(buffer, s.num_frames);
+                    put_le32(buffer, 0);
+                }
+                put_le32(buffer, obus.size());
+                put_le32(buffer, k);
+                put_le32(buffer, 0);
+            }
+            append(buffer, obus);
+        }
+        else
+        {
+            vector<vector<uint8_t> > nal_units(1, aud);
+            uint8_t vcl_header[2];
+            uint32_t vcl_header_size;
+
+            if (key_frame)
+            {
+                nal_units.insert(nal_units.end(), parameter_sets.begin(),
+                        parameter_sets.end());
+                if ((s.flags & SCENARIO_PS_CHANGE) && display >= s.gop)
+                {
+                    /* Replaces the SPS, kept in band by the muxer. */
+                    nal_units[s.pixfmt == V4L2_PIX_FMT_H264 ? 1 : 2] =
+                        changed_sps;
+                }
+            }
+            if (next_rand() % 10 < 3)
+            {
+                nal_units.push_back(sei);
+            }
+            if (s.pixfmt == V4L2_PIX_FMT_H264)
+            {
+                vcl_header[0] = key_frame ? 0x65 : 0x41;
+                vcl_header_size = 1;
+            }
+            else
+            {
+                vcl_header[0] = (key_frame ? 19 : 1) << 1;
+                vcl_header[1] = 1;
+                vcl_header_size = 2;
+            }
+            nal_units.push_back(random_payload(vector<uint8_t>(vcl_header,
+                            vcl_header + vcl_header_size), frame_size));
+            if (s.pixfmt == V4L2_PIX_FMT_H264 && next_rand() % 10 < 3)
+            {
+                nal_units.push_back(random_payload(vector<uint8_t>(vcl_header,
+                                vcl_header + 1), 200));
+            }
+
+            for (size_t i = 0; i < nal_units.size(); i++)
+            {
+                const vector<uint8_t> &nal = nal_units[i];
+                bool dropped = nal == aud;
+
+                append_start_code(buffer);
+                append(buffer, nal);
+                /* Trailing zeros are not part of the NAL unit. */
+                if (next_rand() % 10 < 2)
+                {
+                    buffer.insert(buffer.end(), next_rand() % 3, 0);
+                }
+                for (size_t j = 0; j < parameter_sets.size(); j++)
+                {
+                    dropped |= nal == parameter_sets[j];
+                }
+                if (!dropped)
+                {
+                    put_u32(sample.data, nal.size());
+                    append(sample.data, nal);
+                }
+            }
+        }
+
+        buffers.push_back(buffer);
+        timestamps.push_back(sample.pts);
+        expected.push_back(sample);
+    }
+}
+
+/**
+  * Parses the boxes between @a offset and @a end, which they must fill.
+  */
+static int
+parse_boxes(const vector<uint8_t> &file, size_t offset, size_t end,
+        vector<box_t> &boxes)
+{
+    boxes.clear();
+    while (offset < end)
+    {
+        box_t box;
+
+        CHECK(end - offset >= 8, "Truncated box header at " << offset);
+        box.offset = offset;
+        box.size = get_u32(&file[offset]);
+        memcpy(box.type, &file[offset + 4], 4);
+        box.type[4] = '\0';
+        CHECK(box.size >= 8 && box.size <= end - offset,
+                "Box " << box.type << " at " << offset << " has size " <<
+                box.size);
+        boxes.push_back(box);
+        offset += box.size;
+    }
+    return 0;
+}
+
+/**
+  * Finds the only child box of type @a type. The children start after
+  * the header of @a parent and @a skip more bytes.
+  */
+static int
+find_child(const vector<uint8_t> &file, const box_t &parent, size_t skip,
+        const char *type, box_t &child)
+{
+    vector<box_t> children;
+    int found = 0;
+
+    if (parse_boxes(file, parent.offset + 8 + skip,
+                parent.offset + parent.size, children) < 0)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        if (!strcmp(children[i].type, type))
+        {
+            child = children[i];
+            found++;
+        }
+    }
+    CHECK(found == 1, found << " " << type << " boxes in " << parent.type);
+    return 0;
+}
+
+static int
+check_moov(const scenario_t &s, const vector<uint8_t> &file, const box_t &moov,
+        const vector<uint8_t> &config)
+{
+    static const char *tables[4] = { "stts", "stsc", "stsz", "stco" };
+    const char *entry_type;
+    const char *config_type;
+    box_t trak, mdia, mdhd, hdlr, minf, stbl, stsd, mvex, trex, box;
+    vector<box_t> entries;
+    vector<box_t> configs;
+
+    if (find_child(file, moov, 0, "mvhd", box) < 0 ||
+        find_child(file, moov, 0, "trak", trak) < 0 ||
+        find_child(file, trak, 0, "tkhd", box) < 0 ||
+        find_child(file, trak, 0, "mdia", mdia) < 0 ||
+        find_child(file, mdia, 0, "mdhd", mdhd) < 0 ||
+        find_child(file, mdia, 0, "hdlr", hdlr) < 0 ||
+        find_child(file, mdia, 0, "minf", minf) < 0 ||
+        find_child(file, minf, 0, "vmhd", box) < 0 ||
+        find_child(file, minf, 0, "dinf", box) < 0 ||
+        find_child(file, minf, 0, "stbl", stbl) < 0 ||
+        find_child(file, stbl, 0, "stsd", stsd) < 0 ||
+        find_child(file, moov, 0, "mvex", mvex) < 0 ||
+        find_child(file, mvex, 0, "trex", trex) < 0)
+    {
+        return -1;
+    }
+
+    CHECK(get_u32(&file[mdhd.offset + 20]) == TIMESCALE,
+            "Track time scale is " << get_u32(&file[mdhd.offset + 20]));
+    CHECK(!memcmp(&file[hdlr.offset + 16], "vide", 4), "Not a video track");
+    CHECK(get_u32(&file[trex.offset + 12]) == 1, "trex is not for track 1");
+
+    /* The samples are all in the fragments. */
+    for (int i = 0; i < 4; i++)
+    {
+        if (find_child(file, stbl, 0, tables[i], box) < 0)
+        {
+            return -1;
+        }
+        CHECK(get_u32(&file[box.offset + 12]) == 0,
+                tables[i] << " is not empty");
+    }
+
+    if (s.pixfmt == V4L2_PIX_FMT_H264)
+    {
+        entry_type = "avc1";
+        config_type = "avcC";
+    }
+    else if (s.pixfmt == V4L2_PIX_FMT_H265)
+    {
+        entry_type = "hvc1";
+        config_type = "hvcC";
+    }
+    else
+    {
+        entry_type = "av01";
+        config_type = "av1C";
+    }
+
+    if (parse_boxes(file, stsd.offset + 16, stsd.offset + stsd.size,
+                entries) < 0)
+    {
+        return -1;
+    }
+    CHECK(entries.size() == 1 && !strcmp(entries[0].type, entry_type),
+            "Sample entry is not a single " << entry_type);
+    box = entries[0];
+    CHECK(get_u32(&file[box.offset + 32]) == ((s.width << 16) | s.height),
+            "Sample entry has the wrong dimensions");
+
+    /* The configuration follows the 78 bytes of the visual sample entry. */
+    if (parse_boxes(file, box.offset + 86, box.offset + box.size,
+                configs) < 0)
+    {
+        return -1;
+    }
+    CHECK(configs.size() == 1 && !strcmp(configs[0].type, config_type),
+            "Sample entry has no single " << config_type);
+    CHECK(configs[0].size - 8 == config.size() &&
+            !memcmp(&file[configs[0].offset + 8], config.data(), config.size()),
+            config_type << " does not match the parameter sets");
+    return 0;
+}
+
+/**
+  * Checks the fragments, from the third top-level box on, against the
+  * expected samples.
+  */
+static int
+check_fragments(const scenario_t &s, const vector<uint8_t> &file,
+        const vector<box_t> &top, const vector<expected_sample_t> &expected,
+        uint32_t &num_fragments)
+{
+    uint64_t fragment_end = 0;
+    int64_t last_dts = -1;
+    size_t n = 0;
+    size_t i;
+
+    CHECK(top.size() % 2 == 0, "Fragment without mdat");
+    num_fragments = (top.size() - 2) / 2;
+
+    for (i = 2; i < top.size(); i += 2)
+    {
+        const box_t &moof = top[i];
+        const box_t &mdat = top[i + 1];
+        uint32_t sequence_number = (i - 2) / 2 + 1;
+        box_t mfhd, traf, tfhd, tfdt, trun;
+        uint32_t version, flags, count;
+        size_t pos, sample_pos;
+        uint64_t dts;
+        uint64_t mdat_used = 0;
+
+        CHECK(!strcmp(moof.type, "moof") && !strcmp(mdat.type, "mdat"),
+                "Expected moof and mdat, found " << moof.type << " and " <<
+                mdat.type);
+        if (find_child(file, moof, 0, "mfhd", mfhd) < 0 ||
+            find_child(file, moof, 0, "traf", traf) < 0 ||
+            find_child(file, traf, 0, "tfhd", tfhd) < 0 ||
+            find_child(file, traf, 0, "tfdt", tfdt) < 0 ||
+            find_child(file, traf, 0, "trun", trun) < 0)
+        {
+            return -1;
+        }
+
+        CHECK(get_u32(&file[mfhd.offset + 12]) == sequence_number,
+                "Fragment " << sequence_number << " has sequence number " <<
+                get_u32(&file[mfhd.offset + 12]));
+        CHECK((get_u32(&file[tfhd.offset + 8]) & 0xFFFFFF) ==
+                TFHD_DEFAULT_BASE_IS_MOOF &&
+                get_u32(&file[tfhd.offset + 12]) == 1,
+                "Unexpected tfhd in fragment " << sequence_number);
+        CHECK(file[tfdt.offset + 8] == 1, "tfdt is not version 1");
+        dts = get_u64(&file[tfdt.offset + 12]);
+        CHECK(dts >= fragment_end, "Fragment " << sequence_number <<
+                " starts at " << dts << " before the end " << fragment_end <<
+                " of the previous one");
+
+        version = file[trun.offset + 8];
+        flags = get_u32(&file[trun.offset + 8]) & 0xFFFFFF;
+        count = get_u32(&file[trun.offset + 12]);
+        CHECK((flags & TRUN_REQUIRED_FLAGS) == TRUN_REQUIRED_FLAGS,
+                "trun flags are 0x" << hex << flags << dec);
+        CHECK(get_u32(&file[trun.offset + 16]) == moof.size + 8,
+                "trun data offset does not point at the mdat payload");
+
+        pos = trun.offset + 20;
+        sample_pos = mdat.offset + 8;
+        for (uint32_t j = 0; j < count; j++, n++)
+        {
+            uint32_t duration = get_u32(&file[pos]);
+            uint32_t size = get_u32(&file[pos + 4]);
+            uint32_t sample_flags = get_u32(&file[pos + 8]);
+            int64_t cto = 0;
+            int64_t pts;
+            int64_t expected_pts;
+
+            pos += 12;
+            if (flags & TRUN_SAMPLE_CTO_PRESENT)
+            {
+                cto = version ? (int64_t) (int32_t) get_u32(&file[pos]) :
+                    (int64_t) get_u32(&file[pos]);
+                pos += 4;
+            }
+            CHECK(n < expected.size(), "More samples than frames");
+            CHECK(pos <= trun.offset + trun.size &&
+                    sample_pos + size <= mdat.offset + mdat.size,
+                    "Sample " << n << " is out of its fragment");
+            CHECK((int64_t) dts > last_dts, "Sample " << n <<
+                    " does not increase the decode time");
+
+            const expected_sample_t &sample = expected[n];
+            CHECK(size == sample.data.size() &&
+                    !memcmp(&file[sample_pos], sample.data.data(), size),
+                    "Sample " << n << " payload differs");
+            CHECK(sample_flags == (sample.key_frame ? SAMPLE_FLAGS_SYNC :
+                        SAMPLE_FLAGS_NON_SYNC),
+                    "Sample " << n << " has flags 0x" << hex << sample_flags <<
+                    dec);
+            CHECK(j > 0 || sample.key_frame ||
+                    (s.flags & SCENARIO_BIG_FRAMES),
+                    "Fragment " << sequence_number <<
+                    " does not start with a key frame");
+
+            pts = dts + cto;
+            if (s.flags & SCENARIO_ZERO_TS)
+            {
+                expected_pts = n * (TIMESCALE / 30);
+            }
+            else
+            {
+                expected_pts = (int64_t) (sample.pts - expected[0].pts) *
+                    TIMESCALE / 1000000;
+            }
+            CHECK(pts == expected_pts, "Sample " << n << " is presented at "
+                    << pts << " instead of " << expected_pts);
+
+            last_dts = dts;
+            dts += duration;
+            sample_pos += size;
+            mdat_used += size;
+        }
+        CHECK(pos == trun.offset + trun.size, "trun has trailing bytes");
+        CHECK(mdat_used == mdat.size - 8, "mdat has " << mdat.size - 8 -
+                mdat_used << " bytes not used by samples");
+        fragment_end = dts;
+    }
+    CHECK(n == expected.size(), "File has " << n << " samples, expected " <<
+            expected.size());
+    return 0;
+}
+
+/**
+  * Muxes the stream of a scenario and checks the file.
+  */
+static int
+run_scenario(const scenario_t &s, bool keep_file)
+{
+    vector<vector<uint8_t> > buffers;
+    vector<uint64_t> timestamps;
+    vector<expected_sample_t> expected;
+    vector<uint8_t> config;
+    vector<uint8_t> file;
+    vector<box_t> top;
+    NvMp4Muxer *muxer;
+    uint32_t num_fragments = 0;
+    uint64_t num_samples;
+    int ret = 0;
+    size_t i;
+
+    build_stream(s, buffers, timestamps, expected, config);
+
+    muxer = NvMp4Muxer::createMp4Muxer(MUX_PATH, s.pixfmt, s.width, s.height);
+    CHECK(muxer, "Could not create the muxer");
+    for (i = 0; i < buffers.size() && ret == 0; i++)
+    {
+        ret = muxer->writeSample(buffers[i].data(), buffers[i].size(),
+                timestamps[i]);
+    }
+    if (muxer->close() < 0)
+    {
+        ret = -1;
+    }
+    num_samples = muxer->getNumSamples();
+    delete muxer;
+    CHECK(ret == 0, "Muxing failed at buffer " << i - 1);
+    CHECK(num_samples == expected.size(), "Muxer wrote " << num_samples <<
+            " samples, expected " << expected.size());
+
+    ifstream in(MUX_PATH, ios::binary);
+    file.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    in.close();
+    if (!keep_file)
+    {
+        unlink(MUX_PATH);
+    }
+
+    if (parse_boxes(file, 0, file.size(), top) < 0)
+    {
+        return -1;
+    }
+    CHECK(top.size() >= 2 && !strcmp(top[0].type, "ftyp") &&
+            !strcmp(top[1].type, "moov"), "File does not start with ftyp and moov");
+    if (check_moov(s, file, top[1], config) < 0 ||
+        check_fragments(s, file, top, expected, num_fragments) < 0)
+    {
+        return -1;
+    }
+    CHECK(!(s.flags & SCENARIO_BIG_FRAMES) || num_fragments > 1,
+            "Large GOP was not split");
+
+    cout << s.name << ": " << expected.size() << " samples in " <<
+        num_fragments << " fragments: OK" << endl;
+    return 0;
+}
+
+static void
+init_scenario(scenario_t &s, const char *name, uint32_t pixfmt,
+        uint32_t num_frames, uint32_t gop, uint32_t bframes)
+{
+    memset(&s, 0, sizeof(s));
+    s.name = name;
+    s.pixfmt = pixfmt;
+    s.num_frames = num_frames;
+    s.gop = gop;
+    s.bframes = bframes;
+    s.width = 1280;
+    s.height = 720;
+    s.chroma_format_idc = 1;
+}
+
+static vector<scenario_t>
+build_scenarios()
+{
+    vector<scenario_t> scenarios;
+    scenario_t s;
+
+    init_scenario(s, "h264_high_b", V4L2_PIX_FMT_H264, 95, 30, 2);
+    s.profile = 100;
+    s.level = 40;
+    scenarios.push_back(s);
+
+    /* High 4:4:4 has no avcC extension. */
+    init_scenario(s, "h264_high444_10", V4L2_PIX_FMT_H264, 40, 10, 0);
+    s.profile = 244;
+    s.level = 51;
+    s.chroma_format_idc = 3;
+    s.bit_depth_luma_minus8 = 2;
+    s.bit_depth_chroma_minus8 = 2;
+    scenarios.push_back(s);
+
+    /* Level 0 puts an emulation prevention byte in the SPS. */
+    init_scenario(s, "h264_hi10_escape", V4L2_PIX_FMT_H264, 33, 16, 3);
+    s.profile = 110;
+    s.level = 0;
+    s.sps_id = 63;
+    s.bit_depth_luma_minus8 = 2;
+    s.bit_depth_chroma_minus8 = 2;
+    scenarios.push_back(s);
+
+    init_scenario(s, "h264_zero_ts", V4L2_PIX_FMT_H264, 50, 15, 0);
+    s.profile = 66;
+    s.level = 31;
+    s.flags = SCENARIO_ZERO_TS;
+    scenarios.push_back(s);
+
+    init_scenario(s, "h264_ps_change", V4L2_PIX_FMT_H264, 60, 20, 0);
+    s.profile = 100;
+    s.level = 40;
+    s.flags = SCENARIO_PS_CHANGE;
+    scenarios.push_back(s);
+
+    init_scenario(s, "h264_big_gop", V4L2_PIX_FMT_H264, 8, 8, 0);
+    s.profile = 100;
+    s.level = 40;
+    s.flags = SCENARIO_BIG_FRAMES;
+    scenarios.push_back(s);
+
+    init_scenario(s, "h265_main", V4L2_PIX_FMT_H265, 90, 30, 2);
+    s.profile = 1;
+    s.level = 93;
+    scenarios.push_back(s);
+
+    init_scenario(s, "h265_main10_sub_layers", V4L2_PIX_FMT_H265, 64, 32, 3);
+    s.profile = 2;
+    s.level = 120;
+    s.bit_depth_luma_minus8 = 2;
+    s.bit_depth_chroma_minus8 = 2;
+    s.max_sub_layers_minus1 = 2;
+    s.sub_layer_profile_present = 0x1;
+    s.sub_layer_level_present = 0x3;
+    s.conformance_window = true;
+    scenarios.push_back(s);
+
+    init_scenario(s, "h265_ps_change", V4L2_PIX_FMT_H265, 40, 10, 1);
+    s.profile = 1;
+    s.level = 93;
+    s.flags = SCENARIO_PS_CHANGE;
+    scenarios.push_back(s);
+
+    init_scenario(s, "av1_main", V4L2_PIX_FMT_AV1, 90, 30, 0);
+    s.level = 8;
+    s.tier = 1;
+    scenarios.push_back(s);
+
+    init_scenario(s, "av1_ivf_no_size", V4L2_PIX_FMT_AV1, 40, 20, 0);
+    s.level = 5;
+    s.flags = SCENARIO_IVF | SCENARIO_NO_SIZE;
+    scenarios.push_back(s);
+
+    init_scenario(s, "av1_profile2_12bit", V4L2_PIX_FMT_AV1, 10, 5, 0);
+    s.profile = 2;
+    s.level = 13;
+    s.tier = 1;
+    s.bit_depth_luma_minus8 = 4;
+    s.twelve_bit = true;
+    s.subsampling_x = 1;
+    s.subsampling_y = 1;
+    s.chroma_sample_position = 2;
+    scenarios.push_back(s);
+
+    init_scenario(s, "av1_reduced_still", V4L2_PIX_FMT_AV1, 10, 5, 0);
+    s.profile = 1;
+    s.level = 4;
+    s.reduced_still_picture_header = true;
+    s.bit_depth_luma_minus8 = 2;
+    scenarios.push_back(s);
+
+    init_scenario(s, "av1_mono", V4L2_PIX_FMT_AV1, 10, 5, 0);
+    s.level = 4;
+    s.mono_chrome = true;
+    s.color_description[0] = 2;
+    s.color_description[1] = 2;
+    s.color_description[2] = 2;
+    scenarios.push_back(s);
+
+    init_scenario(s, "av1_srgb", V4L2_PIX_FMT_AV1, 10, 5, 0);
+    s.profile = 1;
+    s.level = 4;
+    s.color_description[0] = 1;
+    s.color_description[1] = 13;
+    s.color_description[2] = 0;
+    scenarios.push_back(s);
+
+    return scenarios;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: mp4_sample [OPTIONS]" << endl << endl;
+    cout << "\t-k           Keep " << MUX_PATH << " of the last stream" <<
+        endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    vector<scenario_t> scenarios = build_scenarios();
+    bool keep_file = false;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "kh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'k':
+                keep_file = true;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    for (size_t i = 0; i < scenarios.size(); i++)
+    {
+        if (run_scenario(scenarios[i], keep_file) < 0)
+        {
+            cerr << scenarios[i].name << ": FAILED" << endl;
+            ret = -1;
+        }
+    }
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./profiler_sample [-n iterations] [-t threads]
+ * Example:
+ * ./profiler_sample
+ * ./profiler_sample -n 10000000 -t 8
+**/
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "NvElement.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of NvElementProfiler.
+ *
+ * startProcessing() and finishProcessing() are called for every buffer
+ * queued and dequeued by the elements, so a start and finish pair must add
+ * less than MAX_CALL_NSEC to the two reads of the time counter it makes.
+ * The cost of that read depends on the platform, from a few ns for the
+ * generic timer of aarch64 to tens of ns for a virtualized TSC, so it is
+ * measured and reported separately. The sample also checks that units
+ * evicted from the units in flight are still counted, and that the
+ * profiling time stays sane when read while units are being finished.
+ */
+
+#define MAX_CALL_NSEC 50
+#define DEFAULT_ITERATIONS 4000000
+#define DEFAULT_THREADS 4
+#define BATCH_SIZE 128
+
+/**
+ * Element which only drives its profiler.
+ */
+class ProfiledElement : public NvElement
+{
+public:
+    ProfiledElement()
+        :NvElement("ProfiledElement", NvElementProfiler::PROFILER_FIELD_ALL)
+    {
+    }
+
+    NvElementProfiler &getProfiler()
+    {
+        return profiler;
+    }
+};
+
+/* Keeps the timed counter reads from being optimized out. */
+static volatile uint64_t counter_sink;
+
+/* Same counter as the profiler. */
+static inline uint64_t
+read_counter()
+{
+#if defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r" (ticks) :: "memory");
+    return ticks;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+  * Times startProcessing() and finishProcessing() separately, in batches
+  * small enough for all the units of a batch to stay in flight.
+  */
+static int
+benchmark_single_thread(uint64_t iterations)
+{
+    ProfiledElement element;
+    NvElementProfiler &profiler = element.getProfiler();
+    uint64_t ids[BATCH_SIZE];
+    uint64_t start_nsec = 0;
+    uint64_t finish_nsec = 0;
+    uint64_t fifo_nsec;
+    uint64_t counter_nsec;
+    uint64_t sum = 0;
+    uint64_t t0;
+    uint64_t i;
+    int j;
+
+    t0 = now_nsec();
+    for (i = 0; i < iterations; i++)
+    {
+        sum += read_counter();
+    }
+    counter_nsec = now_nsec() - t0;
+    counter_sink = sum;
+
+    profiler.enableProfiling(true);
+
+    for (i = 0; i < iterations; i += BATCH_SIZE)
+    {
+        t0 = now_nsec();
+        for (j = 0; j < BATCH_SIZE; j++)
+        {
+            ids[j] = profiler.startProcessing();
+        }
+        start_nsec += now_nsec() - t0;
+
+        t0 = now_nsec();
+        for (j = 0; j < BATCH_SIZE; j++)
+        {
+            profiler.finishProcessing(ids[j], false);
+        }
+        finish_nsec += now_nsec() - t0;
+    }
+
+    t0 = now_nsec();
+    for (i = 0; i < iterations; i++)
+    {
+        profiler.startProcessing();
+        profiler.finishProcessing(0, false);
+    }
+    fifo_nsec = now_nsec() - t0;
+
+    cout << "Time counter read: " << (double) counter_nsec / iterations <<
+        " ns" << endl;
+    cout << "startProcessing: " << (double) start_nsec / iterations <<
+        " ns" << endl;
+    cout << "finishProcessing by ID: " << (double) finish_nsec / iterations <<
+        " ns" << endl;
+    cout << "startProcessing + finishProcessing in order: " <<
+        (double) fifo_nsec / iterations << " ns" << endl;
+
+    cout << "startProcessing + finishProcessing by ID, without the counter "
+        "reads: " << ((double) start_nsec + finish_nsec - 2.0 * counter_nsec) /
+        iterations << " ns" << endl;
+
+    if (start_nsec + finish_nsec >= 2 * counter_nsec + iterations * MAX_CALL_NSEC)
+    {
+        cerr << "A start and finish pair takes more than " << MAX_CALL_NSEC <<
+            " ns on top of its two time counter reads" << endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+  * Each thread starts and finishes its own units, while the main thread
+  * keeps reading the profiler data.
+  */
+static int
+benchmark_threads(uint64_t iterations, int num_threads)
+{
+    ProfiledElement element;
+    NvElementProfiler &profiler = element.getProfiler();
+    NvElementProfiler::NvElementProfilerData data;
+    vector<thread> threads;
+    atomic<int> running(num_threads);
+    uint64_t max_profiling_usec = 0;
+    uint64_t elapsed_nsec;
+    uint64_t t0;
+    int i;
+
+    profiler.enableProfiling(true);
+
+    t0 = now_nsec();
+    for (i = 0; i < num_threads; i++)
+    {
+        threads.push_back(thread([&profiler, &running, iterations] {
+            for (uint64_t n = 0; n < iterations; n++)
+            {
+                uint64_t id = profiler.startProcessing();
+                profiler.finishProcessing(id, false);
+            }
+            running--;
+        }));
+    }
+    while (running)
+    {
+        profiler.getProfilerData(data);
+        max_profiling_usec = max(max_profiling_usec,
+                (uint64_t) (data.profiling_time.tv_sec * 1000000ULL +
+                    data.profiling_time.tv_usec));
+    }
+    for (i = 0; i < num_threads; i++)
+    {
+        threads[i].join();
+    }
+    elapsed_nsec = now_nsec() - t0;
+
+    profiler.getProfilerData(data);
+    cout << num_threads << " threads: " <<
+        (double) elapsed_nsec / iterations << " ns per unit and thread" << endl;
+
+    if (data.total_processed_units != iterations * num_threads)
+    {
+        cerr << "Processed " << data.total_processed_units << " units, expected "
+            << iterations * num_threads << endl;
+        return -1;
+    }
+    if (max_profiling_usec > elapsed_nsec / 1000 + 1000)
+    {
+        cerr << "Profiling time " << max_profiling_usec <<
+            " us is longer than the run" << endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+  * Start more units than fit in flight, then finish all of them, by ID and
+  * in order. Every unit must be counted, only the last ones timed.
+  */
+static int
+check_overflow()
+{
+    const uint64_t num_units = 300;
+    const uint64_t max_in_flight = 256;
+    NvElementProfiler::NvElementProfilerData data;
+    vector<uint64_t> ids;
+    int by_id;
+    uint64_t i;
+
+    for (by_id = 0; by_id < 2; by_id++)
+    {
+        ProfiledElement element;
+        NvElementProfiler &profiler = element.getProfiler();
+        uint64_t histogram[NvElementProfiler::HISTOGRAM_BUCKETS];
+        uint64_t timed_units = 0;
+        int bucket;
+
+        profiler.enableProfiling(true);
+        ids.clear();
+        for (i = 0; i < num_units; i++)
+        {
+            ids.push_back(profiler.startProcessing());
+        }
+        for (i = 0; i < num_units; i++)
+        {
+            profiler.finishProcessing(by_id ? ids[i] : 0, false);
+        }
+        /* Nothing is left in flight. */
+        profiler.finishProcessing(0, false);
+
+        profiler.getProfilerData(data);
+        profiler.getLatencyHistogram(histogram);
+        for (bucket = 0; bucket < NvElementProfiler::HISTOGRAM_BUCKETS; bucket++)
+        {
+            timed_units += histogram[bucket];
+        }
+
+        if (data.total_processed_units != num_units ||
+            data.num_overflowed_units != num_units - max_in_flight ||
+            timed_units != max_in_flight)
+        {
+            cerr << "Overflow " << (by_id ? "by ID" : "in order") << ": " <<
+                data.total_processed_units << " units, " <<
+                data.num_overflowed_units << " overflowed, " << timed_units <<
+                " timed" << endl;
+            return -1;
+        }
+    }
+
+    cout << "Overflowed units counted: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: profiler_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Units per benchmark and thread [Default = "
+        << DEFAULT_ITERATIONS << "]" << endl;
+    cout << "\t-t <count>   Number of threads [Default = "
+        << DEFAULT_THREADS << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint64_t iterations = DEFAULT_ITERATIONS;
+    int num_threads = DEFAULT_THREADS;
+    int ret = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                iterations = strtoull(optarg, NULL, 10);
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (iterations < BATCH_SIZE || num_threads < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_overflow() < 0 ||
+        benchmark_single_thread(iterations) < 0 ||
+        benchmark_threads(iterations, num_threads) < 0)
+    {
+        ret = -1;
+    }
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./queue_sample [-n items]
+ * Example:
+ * ./queue_sample
+ * ./queue_sample -n 1000000
+**/
+
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "Queue.h"
+
+using namespace std;
+
+/**
+ * CPU only check and microbenchmark of the frontend queues.
+ *
+ * Producers push numbered items through SpscQueue and Queue, with the
+ * blocking, try, timed and batch calls, into a ring small enough to be
+ * full and empty often. Every item must be popped exactly once, and each
+ * consumer must see the items of a producer in order. The try and timed
+ * calls must fail on a full or empty ring, the timed ones only after their
+ * timeout.
+ *
+ * The throughput and push to pop latency of Queue are then compared with
+ * the mutex and std::queue based Queue it replaced, with 1, 2, 4 and 8
+ * producer and consumer threads.
+ */
+
+#define DEFAULT_NUM_ITEMS 200000
+#define CHECK_CAPACITY 8
+#define BATCH_SIZE 16
+#define TIMEOUT_USEC 20000
+#define TIMEOUT_SLACK_USEC 200000
+#define MAX_THREADS 8
+#define STOP_PRODUCER 0xFFFFFFFF
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef enum
+{
+    OP_BLOCKING,
+    OP_TRY,
+    OP_TIMED,
+    OP_BATCH,
+    OP_MODES
+} op_mode_t;
+
+static const char *op_mode_names[OP_MODES] =
+{
+    "blocking", "try", "timed", "batch"
+};
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t seq;
+    uint64_t push_nsec;
+} item_t;
+
+/**
+  * The Queue used before, with pop() returning by value.
+  */
+template<typename T>
+class LockedQueue
+{
+public:
+    LockedQueue()
+    {
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_cond, NULL);
+    }
+
+    ~LockedQueue()
+    {
+        pthread_mutex_destroy(&m_mutex);
+        pthread_cond_destroy(&m_cond);
+    }
+
+    void push(const T& obj)
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_queue.push(obj);
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    T pop()
+    {
+        pthread_mutex_lock(&m_mutex);
+        while(m_queue.empty())
+            pthread_cond_wait(&m_cond, &m_mutex);
+        T obj = m_queue.front();
+        m_queue.pop();
+        pthread_mutex_unlock(&m_mutex);
+        return obj;
+    }
+
+private:
+    std::queue<T> m_queue;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+};
+
+template<typename Q>
+struct run_t
+{
+    Q *queue;
+    op_mode_t mode;
+    uint32_t items_per_producer;
+    /** Times each item was popped, by producer and sequence number. */
+    vector<uint8_t> popped;
+};
+
+template<typename Q>
+struct worker_t
+{
+    run_t<Q> *run;
+    uint32_t id;
+    uint64_t num_popped;
+    uint64_t total_latency_nsec;
+    uint64_t max_latency_nsec;
+    uint64_t order_errors;
+};
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+push_items(LockedQueue<item_t> &queue, op_mode_t mode, const item_t *items,
+        size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        queue.push(items[i]);
+    }
+}
+
+template<typename Q>
+static void
+push_items(Q &queue, op_mode_t mode, const item_t *items, size_t count)
+{
+    if (mode == OP_BATCH)
+    {
+        queue.pushBatch(items, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        switch (mode)
+        {
+            case OP_TRY:
+                while (!queue.tryPush(items[i]))
+                    sched_yield();
+                break;
+            case OP_TIMED:
+                while (!queue.timedPush(items[i], TIMEOUT_USEC))
+                    ;
+                break;
+            default:
+                queue.push(items[i]);
+                break;
+        }
+    }
+}
+
+static size_t
+pop_items(LockedQueue<item_t> &queue, op_mode_t mode, item_t *items)
+{
+    items[0] = queue.pop();
+    return 1;
+}
+
+template<typename Q>
+static size_t
+pop_items(Q &queue, op_mode_t mode, item_t *items)
+{
+    switch (mode)
+    {
+        case OP_TRY:
+            while (!queue.tryPop(items[0]))
+                sched_yield();
+            return 1;
+        case OP_TIMED:
+            while (!queue.timedPop(items[0], TIMEOUT_USEC))
+                ;
+            return 1;
+        case OP_BATCH:
+            return queue.popBatch(items, BATCH_SIZE);
+        default:
+            items[0] = queue.pop();
+            return 1;
+    }
+}
+
+template<typename Q>
+static void *
+producer_fcn(void *arg)
+{
+    worker_t<Q> *worker = (worker_t<Q> *) arg;
+    run_t<Q> *run = worker->run;
+    item_t items[BATCH_SIZE];
+    uint32_t seq = 0;
+
+    while (seq < run->items_per_producer)
+    {
+        size_t count = 0;
+
+        while (count < BATCH_SIZE && seq < run->items_per_producer)
+        {
+            items[count].producer = worker->id;
+            items[count].seq = seq++;
+            items[count].push_nsec = now_nsec();
+            count++;
+        }
+        push_items(*run->queue, run->mode, items, count);
+    }
+    return NULL;
+}
+
+template<typename Q>
+static void *
+consumer_fcn(void *arg)
+{
+    worker_t<Q> *worker = (worker_t<Q> *) arg;
+    run_t<Q> *run = worker->run;
+    item_t items[BATCH_SIZE];
+    int64_t last_seq[MAX_THREADS];
+    uint32_t num_stops = 0;
+
+    for (int i = 0; i < MAX_THREADS; i++)
+    {
+        last_seq[i] = -1;
+    }
+    while (!num_stops)
+    {
+        size_t count = pop_items(*run->queue, run->mode, items);
+        uint64_t now = now_nsec();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const item_t &item = items[i];
+
+            if (item.producer == STOP_PRODUCER)
+            {
+                num_stops++;
+                continue;
+            }
+            uint64_t latency = now - item.push_nsec;
+            worker->total_latency_nsec += latency;
+            if (latency > worker->max_latency_nsec)
+                worker->max_latency_nsec = latency;
+            if ((int64_t) item.seq <= last_seq[item.producer])
+                worker->order_errors++;
+            last_seq[item.producer] = item.seq;
+            run->popped[(size_t) item.producer * run->items_per_producer +
+                item.seq]++;
+            worker->num_popped++;
+        }
+    }
+    /* A batch took the stop items of other consumers, give them back. */
+    for (uint32_t i = 1; i < num_stops; i++)
+    {
+        push_items(*run->queue, run->mode, items, 1);
+    }
+    return NULL;
+}
+
+/**
+  * Runs @a num_producers producers pushing @a items_per_producer items each
+  * through @a queue to @a num_consumers consumers.
+  *
+  * @param[out] rate Items popped per second.
+  * @param[out] latency Average push to pop latency, in nanoseconds.
+  */
+template<typename Q>
+static int
+run_queue(const char *name, Q &queue, op_mode_t mode, uint32_t num_producers,
+        uint32_t num_consumers, uint32_t items_per_producer, double &rate,
+        double &latency)
+{
+    run_t<Q> run;
+    worker_t<Q> producers[MAX_THREADS];
+    worker_t<Q> consumers[MAX_THREADS];
+    pthread_t producer_threads[MAX_THREADS];
+    pthread_t consumer_threads[MAX_THREADS];
+    item_t stop;
+    uint64_t total = (uint64_t) num_producers * items_per_producer;
+    uint64_t num_popped = 0;
+    uint64_t total_latency = 0;
+    uint64_t order_errors = 0;
+    uint64_t t0;
+
+    run.queue = &queue;
+    run.mode = mode;
+    run.items_per_producer = items_per_producer;
+    run.popped.assign(total, 0);
+    memset(producers, 0, sizeof(producers));
+    memset(consumers, 0, sizeof(consumers));
+    memset(&stop, 0, sizeof(stop));
+    stop.producer = STOP_PRODUCER;
+
+    t0 = now_nsec();
+    for (uint32_t i = 0; i < num_consumers; i++)
+    {
+        consumers[i].run = &run;
+        consumers[i].id = i;
+        pthread_create(&consumer_threads[i], NULL, consumer_fcn<Q>,
+                &consumers[i]);
+    }
+    for (uint32_t i = 0; i < num_producers; i++)
+    {
+        producers[i].run = &run;
+        producers[i].id = i;
+        pthread_create(&producer_threads[i], NULL, producer_fcn<Q>,
+                &producers[i]);
+    }
+    for (uint32_t i = 0; i < num_producers; i++)
+    {
+        pthread_join(producer_threads[i], NULL);
+    }
+    /* All the items are ahead of the stop items. */
+    for (uint32_t i = 0; i < num_consumers; i++)
+    {
+        push_items(queue, mode, &stop, 1);
+    }
+    for (uint32_t i = 0; i < num_consumers; i++)
+    {
+        pthread_join(consumer_threads[i], NULL);
+        num_popped += consumers[i].num_popped;
+        total_latency += consumers[i].total_latency_nsec;
+        order_errors += consumers[i].order_errors;
+    }
+    t0 = now_nsec() - t0;
+
+    for (uint64_t i = 0; i < total; i++)
+    {
+        CHECK(run.popped[i] == 1, name << " " << op_mode_names[mode] << " " <<
+                num_producers << "x" << num_consumers << ": item " <<
+                i % items_per_producer << " of producer " <<
+                i / items_per_producer << " popped " << (int) run.popped[i] <<
+                " times");
+    }
+    CHECK(num_popped == total, name << ": " << num_popped <<
+            " items popped instead of " << total);
+    CHECK(order_errors == 0, name << " " << op_mode_names[mode] << " " <<
+            num_producers << "x" << num_consumers << ": " << order_errors <<
+            " items popped out of order");
+
+    rate = total * 1e9 / (t0 ? t0 : 1);
+    latency = (double) total_latency / (total ? total : 1);
+    return 0;
+}
+
+template<typename Q>
+static int
+check_queue(const char *name, uint32_t num_producers, uint32_t num_consumers,
+        uint32_t num_items)
+{
+    double rate, latency;
+
+    for (int mode = 0; mode < OP_MODES; mode++)
+    {
+        Q queue;
+
+        if (run_queue(name, queue, (op_mode_t) mode, num_producers,
+                    num_consumers, num_items / num_producers, rate,
+                    latency) < 0)
+        {
+            return -1;
+        }
+    }
+    cout << name << " " << num_producers << "x" << num_consumers <<
+        ": OK" << endl;
+    return 0;
+}
+
+/**
+  * Checks the try and timed calls on an empty and a full ring.
+  */
+template<typename Q>
+static int
+check_limits(const char *name)
+{
+    Q queue;
+    item_t items[BATCH_SIZE];
+    item_t item;
+    uint64_t t0, elapsed;
+
+    memset(items, 0, sizeof(items));
+    CHECK(queue.capacity() == CHECK_CAPACITY, name << ": capacity " <<
+            queue.capacity());
+    CHECK(!queue.tryPop(item), name << ": popped from an empty queue");
+
+    t0 = now_nsec();
+    CHECK(!queue.timedPop(item, TIMEOUT_USEC), name <<
+            ": timed pop from an empty queue");
+    elapsed = (now_nsec() - t0) / 1000;
+    CHECK(elapsed >= TIMEOUT_USEC && elapsed < TIMEOUT_USEC +
+            TIMEOUT_SLACK_USEC, name << ": timed pop returned after " <<
+            elapsed << " usec");
+
+    for (uint32_t i = 0; i < CHECK_CAPACITY; i++)
+    {
+        items[i].seq = i;
+        CHECK(queue.tryPush(items[i]), name << ": push " << i << " failed");
+    }
+    CHECK(queue.size() == CHECK_CAPACITY, name << ": size " << queue.size());
+    CHECK(!queue.tryPush(items[0]), name << ": pushed to a full queue");
+
+    t0 = now_nsec();
+    CHECK(!queue.timedPush(items[0], TIMEOUT_USEC), name <<
+            ": timed push to a full queue");
+    elapsed = (now_nsec() - t0) / 1000;
+    CHECK(elapsed >= TIMEOUT_USEC && elapsed < TIMEOUT_USEC +
+            TIMEOUT_SLACK_USEC, name << ": timed push returned after " <<
+            elapsed << " usec");
+
+    CHECK(queue.popBatch(items, BATCH_SIZE) == CHECK_CAPACITY, name <<
+            ": batch did not pop the whole queue");
+    for (uint32_t i = 0; i < CHECK_CAPACITY; i++)
+    {
+        CHECK(items[i].seq == i, name << ": batch popped " << items[i].seq <<
+                " instead of " << i);
+    }
+    CHECK(queue.size() == 0, name << ": size " << queue.size());
+
+    items[0].seq = 100;
+    CHECK(queue.timedPush(items[0], TIMEOUT_USEC) &&
+            queue.timedPop(item, TIMEOUT_USEC) && item.seq == 100, name <<
+            ": timed push and pop failed");
+    cout << name << " limits: OK" << endl;
+    return 0;
+}
+
+/**
+  * Compares Queue and the queue it replaced with 1 to 8 producers and as
+  * many consumers.
+  */
+static int
+benchmark(uint32_t num_items)
+{
+    double rate, latency, old_rate, old_latency;
+
+    for (uint32_t threads = 1; threads <= MAX_THREADS; threads *= 2)
+    {
+        uint32_t items_per_producer = num_items / threads;
+
+        {
+            LockedQueue<item_t> queue;
+            if (run_queue("LockedQueue", queue, OP_BLOCKING, threads, threads,
+                        items_per_producer, old_rate, old_latency) < 0)
+            {
+                return -1;
+            }
+        }
+        cout << threads << "x" << threads << " threads:" << endl;
+        cout << "  std::queue and mutex: " << old_rate / 1e6 <<
+            " Mitems/s, " << old_latency / 1000 << " usec latency" << endl;
+        {
+            Queue<item_t> queue;
+            if (run_queue("Queue", queue, OP_BLOCKING, threads, threads,
+                        items_per_producer, rate, latency) < 0)
+            {
+                return -1;
+            }
+        }
+        cout << "  Queue: " << rate / 1e6 << " Mitems/s (" <<
+            rate / old_rate << "x), " << latency / 1000 << " usec latency" <<
+            endl;
+        if (threads == 1)
+        {
+            SpscQueue<item_t> queue;
+            if (run_queue("SpscQueue", queue, OP_BLOCKING, 1, 1,
+                        items_per_producer, rate, latency) < 0)
+            {
+                return -1;
+            }
+            cout << "  SpscQueue: " << rate / 1e6 << " Mitems/s (" <<
+                rate / old_rate << "x), " << latency / 1000 <<
+                " usec latency" << endl;
+        }
+    }
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: queue_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Items pushed per run [Default = "
+        << DEFAULT_NUM_ITEMS << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    typedef SpscQueue<item_t, CHECK_CAPACITY> CheckSpscQueue;
+    typedef Queue<item_t, CHECK_CAPACITY> CheckQueue;
+    uint32_t num_items = DEFAULT_NUM_ITEMS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_items = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_items < MAX_THREADS)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (check_limits<CheckSpscQueue>("SpscQueue") < 0 ||
+            check_limits<CheckQueue>("Queue") < 0 ||
+            check_queue<CheckSpscQueue>("SpscQueue", 1, 1, num_items) < 0 ||
+            check_queue<CheckQueue>("Queue", 1, 1, num_items) < 0 ||
+            check_queue<CheckQueue>("Queue", 2, 2, num_items) < 0 ||
+            check_queue<CheckQueue>("Queue", 4, 1, num_items) < 0 ||
+            check_queue<CheckQueue>("Queue", 1, 4, num_items) < 0 ||
+            check_queue<CheckQueue>("Queue", 8, 8, num_items) < 0 ||
+            benchmark(num_items) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
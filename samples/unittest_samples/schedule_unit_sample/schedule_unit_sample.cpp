@@ -0,0 +1,889 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./schedule_sample [-n inputs] [-f frames] [-v]
+ * Example:
+ * ./schedule_sample
+ * ./schedule_sample -n 100000
+**/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "NvEncSchedule.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvEncSchedule against the parsers it replaces.
+ *
+ * The reference below is the code 01_video_encode ran while queuing frames
+ * before the schedule existed: the runtime parameter string parser and the
+ * ROI, RPS, rate control hints and GDR file parsers, with the encoder calls
+ * replaced by an event log. For each random input, the reference is run
+ * frame after frame and each frame is compared with the lookups of the
+ * schedule, field for field, first on a freshly compiled schedule and then
+ * on the image mapped from its cache.
+ *
+ * The inputs cover malformed and out of range numbers, missing trailing
+ * newlines, more regions or reference frames than the controls hold, bad
+ * separators and frames out of order. An RPS or hints file without a
+ * complete record, on which the reference never returns, must be rejected
+ * by the schedule.
+ */
+
+#define ROI_PATH "schedule_sample_roi.txt"
+#define RPS_PATH "schedule_sample_rps.txt"
+#define HINTS_PATH "schedule_sample_hints.txt"
+#define GDR_PATH "schedule_sample_gdr.txt"
+#define CACHE_PATH "schedule_sample.cache"
+
+#define DEFAULT_INPUTS 5000
+#define DEFAULT_FRAMES 200
+
+#define IS_DIGIT(c) (c >= '0' && c <= '9')
+#define TEST_PARSE_ERROR(cond, label) \
+    if (cond) \
+    { \
+        goto label; \
+    }
+
+/**
+ * State of the reference runtime parameter parser.
+ */
+typedef struct
+{
+    stringstream *runtime_params_str;
+    uint32_t next_param_change_frame;
+    vector<string> *events;
+} reference_t;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t
+next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t) (rand_state >> 32);
+}
+
+static uint32_t
+rand_below(uint32_t n)
+{
+    return next_rand() % n;
+}
+
+static string
+to_str(uint32_t value)
+{
+    ostringstream out;
+
+    out << value;
+    return out.str();
+}
+
+static string
+change_event(uint32_t frame)
+{
+    return "f" + to_str(frame);
+}
+
+static string
+op_event(char id, uint32_t value, uint32_t value2)
+{
+    string event(1, id);
+
+    if (id == 'i')
+    {
+        return event;
+    }
+    event += to_str(value);
+    if (id == 'r')
+    {
+        event += "/" + to_str(value2);
+    }
+    return event;
+}
+
+/**
+  * Reference: parses the next id and value of the runtime string.
+  */
+static int
+get_next_parsed_pair(reference_t *ref, char *id, uint32_t *value)
+{
+    char charval;
+
+    *ref->runtime_params_str >> *id;
+    if (ref->runtime_params_str->eof())
+    {
+        return -1;
+    }
+
+    charval = ref->runtime_params_str->peek();
+    if (!IS_DIGIT(charval))
+    {
+        return -1;
+    }
+
+    *ref->runtime_params_str >> *value;
+
+    *ref->runtime_params_str >> charval;
+    if (ref->runtime_params_str->eof())
+    {
+        return 0;
+    }
+
+    return charval;
+}
+
+/**
+  * Reference: applies the operations of the current runtime change.
+  */
+static int
+set_runtime_params(reference_t *ref)
+{
+    char charval;
+    uint32_t intval;
+    int next;
+
+    ref->events->push_back(change_event(ref->next_param_change_frame));
+    while (!ref->runtime_params_str->eof())
+    {
+        next = get_next_parsed_pair(ref, &charval, &intval);
+        TEST_PARSE_ERROR(next < 0, err);
+        switch (charval)
+        {
+            case 'b':
+            case 'p':
+                ref->events->push_back(op_event(charval, intval, 0));
+                break;
+            case 'r':
+            {
+                int fps_num = intval;
+                TEST_PARSE_ERROR(next != '/', err);
+
+                ref->runtime_params_str->seekg(-1, ios::cur);
+                next = get_next_parsed_pair(ref, &charval, &intval);
+                TEST_PARSE_ERROR(next < 0, err);
+
+                ref->events->push_back(op_event('r', fps_num, intval));
+                break;
+            }
+            case 'i':
+                if (intval > 0)
+                {
+                    ref->events->push_back(op_event('i', intval, 0));
+                }
+                break;
+            default:
+                TEST_PARSE_ERROR(true, err);
+        }
+        switch (next)
+        {
+            case 0:
+                delete ref->runtime_params_str;
+                ref->runtime_params_str = NULL;
+                return 0;
+            case '#':
+                return 0;
+            case ',':
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+err:
+    ref->events->push_back("skip");
+    delete ref->runtime_params_str;
+    ref->runtime_params_str = NULL;
+    return -1;
+}
+
+/**
+  * Reference: parses the frame of the next runtime change.
+  */
+static int
+get_next_runtime_param_change_frame(reference_t *ref)
+{
+    char charval;
+    int ret;
+
+    ret = get_next_parsed_pair(ref, &charval, &ref->next_param_change_frame);
+    if (ret == 0)
+    {
+        return 0;
+    }
+
+    TEST_PARSE_ERROR((ret != ';' && ret != ',') || charval != 'f', err);
+
+    return 0;
+
+err:
+    ref->events->push_back("skip");
+    delete ref->runtime_params_str;
+    ref->runtime_params_str = NULL;
+    return -1;
+}
+
+/**
+  * Reference: parses the ROI parameters of a frame.
+  */
+static void
+populate_roi_Param(std::ifstream * stream, v4l2_enc_frame_ROI_params *VEnc_ROI_params)
+{
+    unsigned int ROIIndex = 0;
+
+    if (!stream->eof()) {
+        *stream >> VEnc_ROI_params->num_ROI_regions;
+        while (ROIIndex < VEnc_ROI_params->num_ROI_regions)
+        {
+            if (ROIIndex == V4L2_MAX_ROI_REGIONS) {
+                string skip_str;
+                getline(*stream, skip_str);
+
+                VEnc_ROI_params->num_ROI_regions = V4L2_MAX_ROI_REGIONS;
+                break;
+            }
+
+            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].QPdelta;
+            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.left;
+            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.top;
+            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.width;
+            *stream >> VEnc_ROI_params->ROI_params[ROIIndex].ROIRect.height;
+            ROIIndex++;
+        }
+    } else {
+        stream->clear();
+        stream->seekg(0);
+    }
+}
+
+/**
+  * Reference: parses the external RPS parameters of a frame.
+  *
+  * The original rewinds forever when the file holds no complete record,
+  * this copy sets @a hang instead.
+  */
+static void
+populate_ext_rps_ctrl_Param (std::ifstream * stream, v4l2_enc_frame_ext_rps_ctrl_params *VEnc_ext_rps_ctrl_params,
+        bool *hang)
+{
+    unsigned int RPSIndex = 0;
+    unsigned int temp = 0;
+    int rewinds = 0;
+
+    stream->peek();
+restart :
+    if (stream->eof()) {
+        if (++rewinds > 1) {
+            *hang = true;
+            return;
+        }
+        stream->clear();
+        stream->seekg(0);
+    }
+    if (!stream->eof()) {
+        *stream >> VEnc_ext_rps_ctrl_params->nFrameId;
+        if (stream->eof())
+            goto restart;
+        *stream >> temp;
+        VEnc_ext_rps_ctrl_params->bRefFrame = ((temp)?true:false);
+        *stream >> temp;
+        VEnc_ext_rps_ctrl_params->bLTRefFrame = ((temp)?true:false);
+        *stream >> VEnc_ext_rps_ctrl_params->nMaxRefFrames;
+        *stream >> VEnc_ext_rps_ctrl_params->nActiveRefFrames;
+        *stream >> VEnc_ext_rps_ctrl_params->nCurrentRefFrameId;
+        while (RPSIndex < VEnc_ext_rps_ctrl_params->nActiveRefFrames)
+        {
+            if (RPSIndex == V4L2_MAX_REF_FRAMES) {
+                string skip_str;
+                getline(*stream, skip_str);
+
+                VEnc_ext_rps_ctrl_params->nActiveRefFrames = V4L2_MAX_REF_FRAMES;
+                break;
+            }
+
+            *stream >> VEnc_ext_rps_ctrl_params->RPSList[RPSIndex].nFrameId;
+            *stream >> temp;
+            VEnc_ext_rps_ctrl_params->RPSList[RPSIndex].bLTRefFrame = ((temp)?true:false);
+            RPSIndex++;
+        }
+    }
+}
+
+/**
+  * Reference: parses the external rate control hints of a frame, with the
+  * same guard as populate_ext_rps_ctrl_Param().
+  */
+static void
+populate_ext_rate_ctrl_Param(std::ifstream * stream, v4l2_enc_frame_ext_rate_ctrl_params *VEnc_ext_rate_ctrl_params,
+        bool *hang)
+{
+    int rewinds = 0;
+
+    stream->peek();
+restart:
+    if (stream->eof()) {
+        if (++rewinds > 1) {
+            *hang = true;
+            return;
+        }
+        stream->clear();
+        stream->seekg(0);
+    }
+    if (!stream->eof()) {
+        *stream >> VEnc_ext_rate_ctrl_params->nTargetFrameBits;
+        if (stream->eof())
+            goto restart;
+        *stream >> VEnc_ext_rate_ctrl_params->nFrameQP;
+        *stream >> VEnc_ext_rate_ctrl_params->nFrameMinQp;
+        *stream >> VEnc_ext_rate_ctrl_params->nFrameMaxQp;
+        *stream >> VEnc_ext_rate_ctrl_params->nMaxQPDeviation;
+    }
+}
+
+/**
+  * Reference: parses the next GDR entry.
+  */
+static void
+populate_gdr_Param(std::ifstream * stream, uint32_t *start_frame_num, uint32_t *gdr_num_frames)
+{
+    if (stream->eof()) {
+        *start_frame_num = 0xFFFFFFFF;
+    }
+    if (!stream->eof()) {
+        *stream >> *start_frame_num;
+        *stream >> *gdr_num_frames;
+    }
+}
+
+/**
+  * Number for a parameter file, mostly valid.
+  */
+static string
+random_number(uint32_t max)
+{
+    switch (rand_below(100))
+    {
+        case 0:
+            return "-" + to_str(rand_below(50));
+        case 1:
+            return "99999999999";
+        case 2:
+            return "x";
+        case 3:
+            return "4294967295";
+        default:
+            return to_str(rand_below(max));
+    }
+}
+
+static string
+random_space()
+{
+    static const char *spaces[] = { " ", " ", "  ", "\t", "\n" };
+
+    return spaces[rand_below(5)];
+}
+
+/**
+  * Random parameter file of up to 6 lines.
+  *
+  * Counted lines hold @a count_index fields, a count, then count times
+  * @a per_count fields, give or take one field. Other lines hold
+  * @a min_fields to @a max_fields fields.
+  */
+static string
+random_file(uint32_t min_fields, uint32_t max_fields, bool counted,
+        uint32_t count_index, uint32_t per_count)
+{
+    uint32_t lines = rand_below(12) ? 1 + rand_below(6) : 0;
+    string file;
+
+    for (uint32_t l = 0; l < lines; l++)
+    {
+        vector<string> fields;
+
+        if (counted)
+        {
+            uint32_t count = rand_below(12);
+            uint32_t total = count_index + 1 + count * per_count +
+                rand_below(3) - 1;
+
+            for (uint32_t i = 0; i < count_index; i++)
+            {
+                fields.push_back(to_str(rand_below(40)));
+            }
+            fields.push_back(to_str(count));
+            while (fields.size() < total)
+            {
+                fields.push_back(random_number(40));
+            }
+        }
+        else
+        {
+            uint32_t num_fields = min_fields +
+                rand_below(max_fields - min_fields + 1);
+
+            for (uint32_t i = 0; i < num_fields; i++)
+            {
+                fields.push_back(random_number(60));
+            }
+        }
+
+        for (uint32_t i = 0; i < fields.size(); i++)
+        {
+            file += (i ? random_space() : "") + fields[i];
+        }
+        if (l + 1 < lines || rand_below(2))
+        {
+            file += "\n";
+        }
+    }
+    if (!rand_below(6))
+    {
+        file += random_space();
+    }
+    if (!rand_below(15))
+    {
+        file.clear();
+    }
+    return file;
+}
+
+/**
+  * Random runtime parameter string, mostly valid.
+  */
+static string
+random_runtime_params()
+{
+    uint32_t num_changes = 1 + rand_below(4);
+    uint32_t frame = 0;
+    string str;
+
+    for (uint32_t c = 0; c < num_changes; c++)
+    {
+        uint32_t num_ops = rand_below(4);
+
+        frame += rand_below(6);
+        if (c)
+        {
+            str += rand_below(10) ? "#" : (rand_below(2) ? ";" : ",");
+        }
+        str += rand_below(20) ? "f" : "q";
+        str += to_str(rand_below(15) ? frame : rand_below(30));
+        if (rand_below(3))
+        {
+            str += rand_below(2) ? "," : ";";
+        }
+        for (uint32_t o = 0; o < num_ops; o++)
+        {
+            if (o)
+            {
+                str += rand_below(12) ? "," : (rand_below(2) ? ";" : " ");
+            }
+            switch (rand_below(6))
+            {
+                case 0:
+                    str += "b" + to_str(rand_below(9000000));
+                    break;
+                case 1:
+                    str += "p" + to_str(rand_below(9000000));
+                    break;
+                case 2:
+                    str += "r" + to_str(rand_below(60)) +
+                        (rand_below(8) ? "/" : ",") + to_str(rand_below(3));
+                    break;
+                case 3:
+                    str += "i" + to_str(rand_below(2));
+                    break;
+                case 4:
+                    str += rand_below(2) ? "z" : "b";
+                    str += rand_below(3) ? to_str(rand_below(99)) : "x";
+                    break;
+                default:
+                    str += "i1";
+                    break;
+            }
+        }
+    }
+    if (!rand_below(8))
+    {
+        str += rand_below(2) ? "#" : ",";
+    }
+    if (!rand_below(20))
+    {
+        str.clear();
+    }
+    return str;
+}
+
+static int
+write_file(const char *path, const string &content)
+{
+    ofstream out(path, ios::binary);
+
+    out << content;
+    out.close();
+    if (!out)
+    {
+        cerr << "Could not write " << path << endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+  * Frame by frame output of the reference for one input.
+  */
+typedef struct
+{
+    vector<string> events;
+    vector<v4l2_enc_frame_ROI_params> roi;
+    vector<v4l2_enc_frame_ext_rps_ctrl_params> rps;
+    vector<v4l2_enc_frame_ext_rate_ctrl_params> rate_ctrl;
+    vector<pair<uint32_t, uint32_t> > gdr;
+    bool hang;
+} reference_output_t;
+
+/**
+  * Runs the reference over @a num_frames frames, as 01_video_encode did
+  * when queuing them.
+  */
+static void
+run_reference(const char *runtime_params, uint32_t num_frames,
+        reference_output_t &out)
+{
+    ifstream roi_file(ROI_PATH);
+    ifstream rps_file(RPS_PATH);
+    ifstream hints_file(HINTS_PATH);
+    ifstream gdr_file(GDR_PATH);
+    uint32_t gdr_start_frame = 0xFFFFFFFF;
+    uint32_t gdr_num_frames = 0xFFFFFFFF;
+    reference_t ref;
+
+    ref.runtime_params_str = runtime_params ?
+        new stringstream(runtime_params) : NULL;
+    ref.next_param_change_frame = 0;
+    ref.events = &out.events;
+    out.hang = false;
+
+    /* The schedule reports the errors of the first change at startup. */
+    if (ref.runtime_params_str)
+    {
+        get_next_runtime_param_change_frame(&ref);
+    }
+    out.events.clear();
+
+    for (uint32_t frame = 0; frame < num_frames && !out.hang; frame++)
+    {
+        v4l2_enc_frame_ROI_params roi;
+        v4l2_enc_frame_ext_rps_ctrl_params rps;
+        v4l2_enc_frame_ext_rate_ctrl_params rate_ctrl;
+
+        if (ref.runtime_params_str && frame == ref.next_param_change_frame)
+        {
+            set_runtime_params(&ref);
+            if (ref.runtime_params_str)
+            {
+                get_next_runtime_param_change_frame(&ref);
+            }
+        }
+
+        memset(&roi, 0, sizeof(roi));
+        memset(&rps, 0, sizeof(rps));
+        memset(&rate_ctrl, 0, sizeof(rate_ctrl));
+        populate_roi_Param(&roi_file, &roi);
+        populate_ext_rps_ctrl_Param(&rps_file, &rps, &out.hang);
+        populate_ext_rate_ctrl_Param(&hints_file, &rate_ctrl, &out.hang);
+        if (gdr_start_frame == 0xFFFFFFFF)
+        {
+            populate_gdr_Param(&gdr_file, &gdr_start_frame, &gdr_num_frames);
+        }
+
+        out.roi.push_back(roi);
+        out.rps.push_back(rps);
+        out.rate_ctrl.push_back(rate_ctrl);
+        out.gdr.push_back(make_pair(gdr_start_frame, gdr_num_frames));
+    }
+    delete ref.runtime_params_str;
+}
+
+/**
+  * Looks up every frame in @a schedule, as 01_video_encode does, and
+  * compares it with the reference.
+  */
+static int
+compare_schedule(const NvEncSchedule *schedule, uint32_t num_frames,
+        const reference_output_t &ref)
+{
+    vector<string> events;
+    uint32_t change_index = 0;
+    uint32_t gdr_index = 0;
+    uint32_t gdr_start_frame = 0xFFFFFFFF;
+    uint32_t gdr_num_frames = 0xFFFFFFFF;
+
+    for (uint32_t frame = 0; frame < num_frames; frame++)
+    {
+        const NvEncSchedule::NvEncScheduleChange *change =
+            schedule->getRuntimeChange(change_index);
+        v4l2_enc_frame_ROI_params roi;
+        v4l2_enc_frame_ext_rps_ctrl_params rps;
+        v4l2_enc_frame_ext_rate_ctrl_params rate_ctrl;
+
+        if (change && change->frame == frame)
+        {
+            const NvEncSchedule::NvEncScheduleOp *ops =
+                schedule->getRuntimeOps(change);
+
+            events.push_back(change_event(change->frame));
+            for (uint32_t i = 0; i < change->num_ops; i++)
+            {
+                if (ops[i].id != 'i' || ops[i].value > 0)
+                {
+                    events.push_back(op_event(ops[i].id, ops[i].value,
+                                ops[i].value2));
+                }
+            }
+            if (change->parse_error)
+            {
+                events.push_back("skip");
+            }
+            change_index++;
+        }
+
+        schedule->getRoiParams(frame, &roi);
+        schedule->getRpsParams(frame, &rps);
+        schedule->getRateCtrlParams(frame, &rate_ctrl);
+        if (gdr_start_frame == 0xFFFFFFFF)
+        {
+            schedule->getGdrParams(gdr_index++, &gdr_start_frame,
+                    &gdr_num_frames);
+        }
+
+        if (memcmp(&roi, &ref.roi[frame], sizeof(roi)))
+        {
+            cerr << "Frame " << frame << ": ROI parameters differ" << endl;
+            return -1;
+        }
+        if (memcmp(&rps, &ref.rps[frame], sizeof(rps)))
+        {
+            cerr << "Frame " << frame << ": RPS parameters differ" << endl;
+            return -1;
+        }
+        if (memcmp(&rate_ctrl, &ref.rate_ctrl[frame], sizeof(rate_ctrl)))
+        {
+            cerr << "Frame " << frame << ": rate control hints differ" << endl;
+            return -1;
+        }
+        if (make_pair(gdr_start_frame, gdr_num_frames) != ref.gdr[frame])
+        {
+            cerr << "Frame " << frame << ": GDR " << gdr_start_frame << "," <<
+                gdr_num_frames << ", expected " << ref.gdr[frame].first <<
+                "," << ref.gdr[frame].second << endl;
+            return -1;
+        }
+    }
+
+    if (events != ref.events)
+    {
+        cerr << "Runtime changes differ:" << endl << "  expected:";
+        for (size_t i = 0; i < ref.events.size(); i++)
+        {
+            cerr << " " << ref.events[i];
+        }
+        cerr << endl << "  schedule:";
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            cerr << " " << events[i];
+        }
+        cerr << endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+  * Checks one random input, on a compiled then on a cached schedule.
+  */
+static int
+check_input(uint32_t input, uint32_t num_frames, uint32_t &num_rejected)
+{
+    string runtime_params = random_runtime_params();
+    bool has_runtime_params = !runtime_params.empty() || rand_below(2);
+    NvEncSchedule::NvEncScheduleSources sources;
+    reference_output_t ref;
+
+    if (write_file(ROI_PATH, random_file(0, 0, true, 0, 5)) < 0 ||
+        write_file(RPS_PATH, random_file(0, 0, true, 4, 2)) < 0 ||
+        write_file(HINTS_PATH, random_file(3, 6, false, 0, 0)) < 0 ||
+        write_file(GDR_PATH, random_file(1, 3, false, 0, 0)) < 0)
+    {
+        return -1;
+    }
+
+    run_reference(has_runtime_params ? runtime_params.c_str() : NULL,
+            num_frames, ref);
+
+    sources.runtime_params = has_runtime_params ? runtime_params.c_str() : NULL;
+    sources.roi_file_path = ROI_PATH;
+    sources.rps_file_path = RPS_PATH;
+    sources.hints_file_path = HINTS_PATH;
+    sources.gdr_file_path = GDR_PATH;
+
+    unlink(CACHE_PATH);
+    for (int cached = 0; cached < 2; cached++)
+    {
+        NvEncSchedule *schedule =
+            NvEncSchedule::createEncSchedule(sources, CACHE_PATH);
+        int ret;
+
+        if (ref.hang)
+        {
+            if (schedule)
+            {
+                cerr << "Input " << input << ": file without a complete " <<
+                    "record accepted" << endl;
+                delete schedule;
+                return -1;
+            }
+            num_rejected++;
+            return 0;
+        }
+        if (!schedule)
+        {
+            cerr << "Input " << input << ": could not create the schedule" <<
+                endl;
+            return -1;
+        }
+        if (schedule->isCached() != (cached == 1))
+        {
+            cerr << "Input " << input << ": schedule " <<
+                (cached ? "not" : "unexpectedly") << " mapped from the cache"
+                << endl;
+            delete schedule;
+            return -1;
+        }
+
+        ret = compare_schedule(schedule, num_frames, ref);
+        delete schedule;
+        if (ret < 0)
+        {
+            cerr << "Input " << input << (cached ? " (cached)" : "") <<
+                ", runtime parameters \"" << runtime_params << "\"" << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: schedule_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Number of random inputs [Default = "
+        << DEFAULT_INPUTS << "]" << endl;
+    cout << "\t-f <count>   Frames checked per input [Default = "
+        << DEFAULT_FRAMES << "]" << endl;
+    cout << "\t-v           Print the errors of the schedule on malformed inputs"
+        << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_inputs = DEFAULT_INPUTS;
+    uint32_t num_frames = DEFAULT_FRAMES;
+    uint32_t num_rejected = 0;
+    uint32_t i;
+    int ret = 0;
+    int opt;
+
+    /* Most inputs are malformed on purpose. */
+    log_level = LOG_LEVEL_INFO;
+
+    while ((opt = getopt(argc, argv, "n:f:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_inputs = atoi(optarg);
+                break;
+            case 'f':
+                num_frames = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_ERROR;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_inputs < 1 || num_frames < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    for (i = 0; i < num_inputs && ret == 0; i++)
+    {
+        ret = check_input(i, num_frames, num_rejected);
+    }
+
+    unlink(ROI_PATH);
+    unlink(RPS_PATH);
+    unlink(HINTS_PATH);
+    unlink(GDR_PATH);
+    unlink(CACHE_PATH);
+
+    if (ret < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << num_inputs << " inputs, " << (uint64_t) (num_inputs -
+            num_rejected) * num_frames << " frames equal, " << num_rejected <<
+        " inputs rejected" << endl;
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,688 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./tracer_sample [-n events] [-t threads]
+ * Example:
+ * ./tracer_sample
+ * ./tracer_sample -n 5000 -t 8
+**/
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "NvLogging.h"
+#include "NvTracer.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvTracer.
+ *
+ * Tracing is enabled from the environment when the process starts, so each
+ * case runs in a child process started with NVMM_TRACE set:
+ *
+ * - threads: named threads each record queue, dequeue and slice events for
+ *   buffers cycling through a few indexes, few enough for their rings;
+ * - overflow: one thread records many more events than its ring holds
+ *   before the drain thread runs;
+ * - crash: events are flushed, then the process exits without closing the
+ *   trace.
+ *
+ * The emitted trace must parse as JSON. Every event of every thread must
+ * be there, in order, with its buffer, and the queue and dequeue events of
+ * each buffer must form matched async slices. Events written and events
+ * counted as dropped must add up to the events recorded, and the trace of
+ * a crashed process must parse once its array is closed.
+ */
+
+#define TRACE_PATH "tracer_sample.json"
+#define LOG_PATH "tracer_sample.log"
+
+#define DEFAULT_NUM_EVENTS 4000
+#define DEFAULT_NUM_THREADS 4
+/* Queue, slice and dequeue per buffer, to stay under the 16384 events of
+   the ring of a thread. */
+#define MAX_NUM_EVENTS 5000
+#define MAX_NUM_THREADS 16
+#define NUM_INDEXES 8
+#define OVERFLOW_EVENTS 200000
+#define CRASH_EVENTS 1000
+/* Needs escaping in the trace. */
+#define OWNER "dec\"0"
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+typedef enum
+{
+    MODE_THREADS,
+    MODE_OVERFLOW,
+    MODE_CRASH,
+    MODE_COUNT
+} trace_mode_t;
+
+static const char *mode_names[MODE_COUNT] = { "threads", "overflow", "crash" };
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Holds a parsed JSON value, only as much as the checks need.
+ */
+typedef struct json_value
+{
+    enum { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY,
+        JSON_OBJECT } type;
+    double number;
+    string str;
+    vector<json_value> array;
+    map<string, json_value> object;
+
+    /* Returns the member @a name of an object, or a null value. */
+    const json_value &operator[](const string &name) const
+    {
+        static const json_value null_value = json_value();
+        map<string, json_value>::const_iterator it = object.find(name);
+
+        return it == object.end() ? null_value : it->second;
+    }
+} json_value_t;
+
+static void
+skip_spaces(const char *&p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+}
+
+static bool
+parse_json_string(const char *&p, string &str)
+{
+    if (*p++ != '"')
+        return false;
+    str.clear();
+    while (*p != '"')
+    {
+        if (!*p || (unsigned char) *p < 0x20)
+            return false;
+        if (*p == '\\')
+        {
+            p++;
+            switch (*p)
+            {
+                case '"':   str += '"'; break;
+                case '\\':  str += '\\'; break;
+                case '/':   str += '/'; break;
+                case 'n':   str += '\n'; break;
+                case 't':   str += '\t'; break;
+                case 'r':   str += '\r'; break;
+                default:    return false;
+            }
+            p++;
+            continue;
+        }
+        str += *p++;
+    }
+    p++;
+    return true;
+}
+
+static bool
+parse_json(const char *&p, json_value_t &value)
+{
+    skip_spaces(p);
+    value.type = json_value_t::JSON_NULL;
+    if (*p == '{')
+    {
+        value.type = json_value_t::JSON_OBJECT;
+        p++;
+        skip_spaces(p);
+        if (*p == '}')
+        {
+            p++;
+            return true;
+        }
+        while (1)
+        {
+            string name;
+
+            skip_spaces(p);
+            if (!parse_json_string(p, name))
+                return false;
+            skip_spaces(p);
+            if (*p++ != ':' || value.object.count(name) ||
+                    !parse_json(p, value.object[name]))
+                return false;
+            skip_spaces(p);
+            if (*p == '}')
+            {
+                p++;
+                return true;
+            }
+            if (*p++ != ',')
+                return false;
+        }
+    }
+    if (*p == '[')
+    {
+        value.type = json_value_t::JSON_ARRAY;
+        p++;
+        skip_spaces(p);
+        if (*p == ']')
+        {
+            p++;
+            return true;
+        }
+        while (1)
+        {
+            value.array.push_back(json_value_t());
+            if (!parse_json(p, value.array.back()))
+                return false;
+            skip_spaces(p);
+            if (*p == ']')
+            {
+                p++;
+                return true;
+            }
+            if (*p++ != ',')
+                return false;
+        }
+    }
+    if (*p == '"')
+    {
+        value.type = json_value_t::JSON_STRING;
+        return parse_json_string(p, value.str);
+    }
+    if (!strncmp(p, "true", 4) || !strncmp(p, "null", 4))
+    {
+        value.type = *p == 't' ? json_value_t::JSON_BOOL :
+            json_value_t::JSON_NULL;
+        value.number = *p == 't';
+        p += 4;
+        return true;
+    }
+    if (!strncmp(p, "false", 5))
+    {
+        value.type = json_value_t::JSON_BOOL;
+        value.number = 0;
+        p += 5;
+        return true;
+    }
+
+    char *end;
+    /* JSON numbers start with a digit or a minus sign, strtod would also
+       take nan, inf and hexadecimal numbers. */
+    if (*p != '-' && (*p < '0' || *p > '9'))
+        return false;
+    value.type = json_value_t::JSON_NUMBER;
+    value.number = strtod(p, &end);
+    if (end == p)
+        return false;
+    p = end;
+    return true;
+}
+
+/* Parses a whole JSON document, nothing but spaces may follow it. */
+static bool
+parse_json_document(const string &text, json_value_t &value)
+{
+    const char *p = text.c_str();
+
+    value = json_value_t();
+    if (!parse_json(p, value))
+        return false;
+    skip_spaces(p);
+    return *p == '\0';
+}
+
+typedef struct
+{
+    uint32_t index;
+    uint32_t num_events;
+} recorder_t;
+
+/* Timestamp of buffer @a i of thread @a thread, unique in the trace. */
+static int64_t
+buffer_timestamp(uint32_t thread, uint32_t i)
+{
+    return (int64_t) i * 1000 + thread;
+}
+
+static void *
+recorder_fcn(void *arg)
+{
+    recorder_t *recorder = (recorder_t *) arg;
+    char name[16];
+
+    snprintf(name, sizeof(name), "trace%u", recorder->index);
+    pthread_setname_np(pthread_self(), name);
+    for (uint32_t i = 0; i < recorder->num_events; i++)
+    {
+        int64_t timestamp = buffer_timestamp(recorder->index, i);
+
+        /* The recorder stands for the queue the buffers go through. */
+        NvTracer::recordQueued(recorder, OWNER, NvTracer::PLANE_OUTPUT,
+                i % NUM_INDEXES, timestamp);
+        {
+            NvTraceScope scope("process", OWNER, NvTracer::PLANE_CAPTURE);
+            scope.setBuffer(i % NUM_INDEXES, timestamp);
+        }
+        NvTracer::recordDequeued(recorder, OWNER, NvTracer::PLANE_OUTPUT,
+                i % NUM_INDEXES, timestamp);
+    }
+    return NULL;
+}
+
+/**
+ * Records the events of @a mode. Runs in the child process, with the
+ * trace enabled and stderr written to the log file.
+ */
+static int
+run_child(trace_mode_t mode, uint32_t num_events, uint32_t num_threads)
+{
+    /* For the count of dropped events. */
+    log_level = LOG_LEVEL_WARN;
+    CHECK(NvTracer::isEnabled(), "Tracing is not enabled");
+
+    if (mode == MODE_THREADS)
+    {
+        vector<recorder_t> recorders(num_threads);
+        vector<pthread_t> threads(num_threads);
+        uint64_t start = now_nsec();
+
+        for (uint32_t i = 0; i < num_threads; i++)
+        {
+            recorders[i].index = i;
+            recorders[i].num_events = num_events;
+            CHECK(pthread_create(&threads[i], NULL, recorder_fcn,
+                        &recorders[i]) == 0, "Could not create thread");
+        }
+        for (uint32_t i = 0; i < num_threads; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        cout << "threads: " << (double) (now_nsec() - start) /
+            (3ULL * num_events * num_threads) << " ns per event for " <<
+            num_threads << " threads" << endl;
+    }
+    else if (mode == MODE_OVERFLOW)
+    {
+        for (uint32_t i = 0; i < OVERFLOW_EVENTS; i++)
+        {
+            NvTraceScope scope("overflow", OWNER);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < CRASH_EVENTS; i++)
+        {
+            NvTraceScope scope("crash", OWNER);
+            scope.setBuffer(i % NUM_INDEXES, i);
+        }
+        NvTracer::flush();
+        cout.flush();
+        /* Skips the handler closing the trace. */
+        _exit(0);
+    }
+    return 0;
+}
+
+static int
+read_file(const char *path, string &text)
+{
+    ifstream file(path);
+    ostringstream contents;
+
+    CHECK(file.is_open(), "Could not open " << path);
+    contents << file.rdbuf();
+    text = contents.str();
+    return 0;
+}
+
+/* Counts the slices named @a name. */
+static uint32_t
+count_slices(const json_value_t &trace, const string &name)
+{
+    uint32_t count = 0;
+
+    for (size_t i = 0; i < trace.array.size(); i++)
+    {
+        if (trace.array[i]["ph"].str == "X" && trace.array[i]["name"].str == name)
+            count++;
+    }
+    return count;
+}
+
+typedef struct
+{
+    uint32_t slices;
+    uint32_t begins;
+    uint32_t ends;
+    int64_t last_timestamp;
+} thread_events_t;
+
+/**
+ * Checks the trace of the threads case: every event of every thread, in
+ * order, and each buffer queued and dequeued in turn.
+ */
+static int
+check_threads(const json_value_t &trace, pid_t pid, uint32_t num_events,
+        uint32_t num_threads)
+{
+    map<double, string> thread_names;
+    map<double, thread_events_t> threads;
+    /* Queue events of the buffers in the driver, by async slice ID. */
+    map<string, const json_value_t *> open_slices;
+    uint32_t num_processes = 0;
+
+    for (size_t i = 0; i < trace.array.size(); i++)
+    {
+        const json_value_t &event = trace.array[i];
+
+        if (event["ph"].str != "M")
+            continue;
+        if (event["name"].str == "process_name")
+            num_processes++;
+        else if (event["name"].str == "thread_name")
+            thread_names[event["tid"].number] = event["args"]["name"].str;
+    }
+    CHECK(num_processes == 1, "threads: " << num_processes <<
+            " process names");
+
+    for (size_t i = 0; i < trace.array.size(); i++)
+    {
+        const json_value_t &event = trace.array[i];
+        const json_value_t &args = event["args"];
+        const string &ph = event["ph"].str;
+        string &thread_name = thread_names[event["tid"].number];
+        uint32_t thread;
+        int64_t timestamp = args["timestamp"].number;
+
+        if (ph == "M")
+            continue;
+        CHECK(sscanf(thread_name.c_str(), "trace%u", &thread) == 1 &&
+                thread < num_threads, "threads: event of unknown thread " <<
+                thread_name);
+        CHECK(event["pid"].number == pid && event["ts"].type == json_value_t::JSON_NUMBER &&
+                args["element"].str == OWNER && timestamp % 1000 == thread &&
+                args["index"].number == (timestamp / 1000) % NUM_INDEXES,
+                "threads: wrong event " << i << " of " << thread_name);
+
+        thread_events_t &events = threads[event["tid"].number];
+        if (ph == "X")
+        {
+            CHECK(event["name"].str == "process" &&
+                    event["dur"].number >= 0 &&
+                    args["plane"].str == "capture", "threads: wrong slice " <<
+                    i << " of " << thread_name);
+            /* Each buffer is queued, processed then dequeued. */
+            CHECK(events.begins == events.slices + 1 &&
+                    events.ends == events.slices &&
+                    timestamp == events.last_timestamp,
+                    "threads: slice " << i << " of " << thread_name <<
+                    " out of order");
+            events.slices++;
+            continue;
+        }
+
+        CHECK(ph == "b" || ph == "e", "threads: unknown phase " << ph);
+        ostringstream name;
+        name << OWNER << " output " << args["index"].number;
+        CHECK(event["name"].str == name.str() &&
+                event["cat"].str == "buffer" && args["plane"].str == "output",
+                "threads: wrong async event " << i << " of " << thread_name);
+
+        const string &id = event["id"].str;
+        if (ph == "b")
+        {
+            CHECK(events.begins == events.ends &&
+                    (events.begins == 0 ||
+                     timestamp == events.last_timestamp + 1000),
+                    "threads: queue event " << i << " of " << thread_name <<
+                    " out of order");
+            CHECK(!open_slices.count(id), "threads: buffer " << id <<
+                    " queued twice");
+            open_slices[id] = &event;
+            events.begins++;
+            events.last_timestamp = timestamp;
+        }
+        else
+        {
+            CHECK(open_slices.count(id), "threads: buffer " << id <<
+                    " dequeued without being queued");
+            const json_value_t &begin = *open_slices[id];
+            CHECK(begin["args"]["timestamp"].number == timestamp &&
+                    begin["tid"].number == event["tid"].number &&
+                    begin["ts"].number <= event["ts"].number &&
+                    events.slices == events.begins,
+                    "threads: unmatched dequeue event " << i << " of " <<
+                    thread_name);
+            open_slices.erase(id);
+            events.ends++;
+        }
+    }
+
+    CHECK(open_slices.empty(), "threads: " << open_slices.size() <<
+            " buffers never dequeued");
+    CHECK(threads.size() == num_threads, "threads: events of " <<
+            threads.size() << " threads for " << num_threads);
+    for (map<double, thread_events_t>::iterator it = threads.begin();
+            it != threads.end(); ++it)
+    {
+        CHECK(it->second.slices == num_events &&
+                it->second.begins == num_events &&
+                it->second.ends == num_events, "threads: " <<
+                thread_names[it->first] << " has " << it->second.slices <<
+                " slices, " << it->second.begins << " queue and " <<
+                it->second.ends << " dequeue events for " << num_events);
+    }
+    return 0;
+}
+
+static int
+check_mode(trace_mode_t mode, uint32_t num_events, uint32_t num_threads)
+{
+    json_value_t trace;
+    string text, log;
+    pid_t pid;
+    int status;
+
+    unlink(TRACE_PATH);
+    unlink(LOG_PATH);
+    cout.flush();
+    pid = fork();
+    CHECK(pid >= 0, "Could not fork");
+    if (pid == 0)
+    {
+        char events_arg[16];
+        char threads_arg[16];
+        /* The tracer logs from the static constructors already. */
+        int fd = open(LOG_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0 || dup2(fd, STDERR_FILENO) < 0)
+        {
+            _exit(127);
+        }
+        close(fd);
+        snprintf(events_arg, sizeof(events_arg), "%u", num_events);
+        snprintf(threads_arg, sizeof(threads_arg), "%u", num_threads);
+        setenv("NVMM_TRACE", TRACE_PATH, 1);
+        execl("/proc/self/exe", "tracer_sample", "-c", mode_names[mode],
+                "-n", events_arg, "-t", threads_arg, (char *) NULL);
+        _exit(127);
+    }
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+            WEXITSTATUS(status) == 0, mode_names[mode] <<
+            ": child process failed");
+
+    CHECK(read_file(TRACE_PATH, text) == 0 && read_file(LOG_PATH, log) == 0,
+            mode_names[mode] << ": no trace");
+    size_t last = text.find_last_not_of(" \n");
+    CHECK(last != string::npos, mode_names[mode] << ": empty trace");
+    if (mode == MODE_CRASH)
+    {
+        /* The array is left open, as by a process that crashed. */
+        CHECK(text[last] != ']', "crash: trace was closed");
+        text += "]";
+    }
+    else
+    {
+        CHECK(text[last] == ']', mode_names[mode] << ": trace not closed");
+    }
+    CHECK(parse_json_document(text, trace) &&
+            trace.type == json_value_t::JSON_ARRAY, mode_names[mode] <<
+            ": trace is not a JSON array");
+
+    if (mode == MODE_THREADS)
+    {
+        CHECK(log.find("Dropped") == string::npos, "threads: " << log);
+        CHECK(check_threads(trace, pid, num_events, num_threads) == 0,
+                "threads: wrong trace");
+        cout << "threads: " << trace.array.size() << " events" << endl;
+    }
+    else if (mode == MODE_OVERFLOW)
+    {
+        uint32_t written = count_slices(trace, "overflow");
+        size_t pos = log.find("Dropped ");
+        uint32_t dropped;
+
+        CHECK(pos != string::npos &&
+                sscanf(log.c_str() + pos, "Dropped %u", &dropped) == 1,
+                "overflow: no dropped events in " << log);
+        cout << "overflow: " << written << " events written, " << dropped <<
+            " dropped" << endl;
+        CHECK(dropped > 0 && written + dropped == OVERFLOW_EVENTS,
+                "overflow: " << written << " written and " << dropped <<
+                " dropped for " << OVERFLOW_EVENTS);
+    }
+    else
+    {
+        uint32_t written = count_slices(trace, "crash");
+
+        CHECK(written == CRASH_EVENTS, "crash: " << written <<
+                " events for " << CRASH_EVENTS);
+    }
+    unlink(TRACE_PATH);
+    unlink(LOG_PATH);
+    cout << mode_names[mode] << ": OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Usage: tracer_sample [OPTIONS]" << endl << endl;
+    cout << "\t-n <count>   Buffers traced per thread [Default = "
+        << DEFAULT_NUM_EVENTS << ", at most " << MAX_NUM_EVENTS << "]" <<
+        endl;
+    cout << "\t-t <count>   Number of tracing threads [Default = "
+        << DEFAULT_NUM_THREADS << "]" << endl;
+    cout << "\t-h           Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_events = DEFAULT_NUM_EVENTS;
+    uint32_t num_threads = DEFAULT_NUM_THREADS;
+    const char *child_mode = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:n:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c':
+                /* Set when the sample starts itself with tracing enabled. */
+                child_mode = optarg;
+                break;
+            case 'n':
+                num_events = atoi(optarg);
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_events < 1 || num_events > MAX_NUM_EVENTS || num_threads < 1 ||
+            num_threads > MAX_NUM_THREADS)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (child_mode)
+    {
+        for (int mode = 0; mode < MODE_COUNT; mode++)
+        {
+            if (!strcmp(child_mode, mode_names[mode]))
+            {
+                return run_child((trace_mode_t) mode, num_events,
+                        num_threads) < 0 ? 1 : 0;
+            }
+        }
+        return -1;
+    }
+
+    for (int mode = 0; mode < MODE_COUNT; mode++)
+    {
+        if (check_mode((trace_mode_t) mode, num_events, num_threads) < 0)
+        {
+            cerr << "TEST FAILED" << endl;
+            return -1;
+        }
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
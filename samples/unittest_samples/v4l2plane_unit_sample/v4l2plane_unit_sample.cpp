@@ -0,0 +1,752 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./v4l2plane_sample [-n frames] [-b buffers] [-d delay_usec] [-c capacity] [-v]
+ * Example:
+ * ./v4l2plane_sample
+ * ./v4l2plane_sample -n 2000 -b 10 -d 500 -c 8
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NvV4l2Element.h"
+#include "NvV4l2MockDevice.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check of NvV4l2ElementPlane on the mock V4L2 device.
+ *
+ * An element is opened on the loopback device, which copies the payload of
+ * every output plane buffer to a capture plane buffer after its processing
+ * delay, with a given number of buffers processed concurrently. Every
+ * frame carries a pattern and its number in its timestamp:
+ *
+ * - setup: setupPlane() must request, query, export and map the buffers of
+ *   both planes;
+ * - blocking: frames queued with qBuffer() and dequeued with dqBuffer() on
+ *   a blocking element must come back in order and intact, an empty
+ *   buffer must come back flagged LAST, raise the end of stream event and
+ *   end the capture plane, and the buffer counts must add up;
+ * - DQ threads: the same on a non-blocking element driven by the DQ
+ *   threads of startDQThread(), refilling the output plane from its
+ *   callback, until waitAllBuffersDequeued(). The frames must not come
+ *   back faster than the capacity of the device allows.
+ *
+ * The time spent in qBuffer() and dqBuffer() and the frame rates are
+ * reported.
+ */
+
+#define DEFAULT_FRAMES 300
+#define DEFAULT_BUFFERS 6
+#define DEFAULT_DELAY_USEC 1000
+#define DEFAULT_CAPACITY 4
+#define MAX_BUFFERS 32
+#define WIDTH 320
+#define HEIGHT 240
+#define MIN_PAYLOAD 64
+#define WAIT_MS 10000
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Element with no format logic of its own, on the mock device.
+ */
+class MockElement : public NvV4l2Element
+{
+public:
+    static MockElement *createMockElement(const char *name, bool blocking)
+    {
+        MockElement *element = new MockElement(name,
+                blocking ? 0 : O_NONBLOCK);
+
+        if (element->isInError())
+        {
+            delete element;
+            return NULL;
+        }
+        return element;
+    }
+
+private:
+    MockElement(const char *name, int flags)
+        : NvV4l2Element(name, "/dev/nvhost-mock", flags,
+                NvElementProfiler::PROFILER_FIELD_ALL)
+    {
+    }
+
+    /**
+     * Disallow copy constructor.
+     */
+    MockElement(const MockElement& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(MockElement const&);
+};
+
+/**
+ * Holds a V4L2 buffer and its planes.
+ */
+typedef struct
+{
+    struct v4l2_buffer v4l2_buf;
+    struct v4l2_plane planes[MAX_PLANES];
+} QueuedBuffer;
+
+static void
+init_buffer(QueuedBuffer &buf, uint32_t index)
+{
+    memset(&buf, 0, sizeof(buf));
+    buf.v4l2_buf.index = index;
+    buf.v4l2_buf.m.planes = buf.planes;
+}
+
+static uint32_t
+payload_size(uint32_t frame, uint32_t size)
+{
+    return MIN_PAYLOAD + (frame * 97) % (size - MIN_PAYLOAD);
+}
+
+static uint8_t
+payload_byte(uint32_t frame, uint32_t offset)
+{
+    return frame * 131 + offset * 7 + (offset >> 8);
+}
+
+/**
+ * Fills an output plane buffer with frame @a frame, an empty buffer if
+ * @a frame is negative.
+ */
+static void
+fill_frame(NvBuffer *buffer, QueuedBuffer &buf, int frame,
+        uint32_t payload_limit)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+
+    plane.bytesused = 0;
+    if (frame >= 0)
+    {
+        plane.bytesused = payload_size(frame, payload_limit);
+        for (uint32_t i = 0; i < plane.bytesused; i++)
+        {
+            plane.data[i] = payload_byte(frame, i);
+        }
+        buf.v4l2_buf.timestamp.tv_sec = 1;
+        buf.v4l2_buf.timestamp.tv_usec = frame;
+    }
+    buf.v4l2_buf.flags |= V4L2_BUF_FLAG_TIMESTAMP_COPY;
+}
+
+/**
+ * Checks that a capture plane buffer holds frame @a frame.
+ */
+static int
+check_frame(const struct v4l2_buffer &v4l2_buf, NvBuffer *buffer,
+        uint32_t frame, uint32_t payload_limit)
+{
+    NvBuffer::NvBufferPlane &plane = buffer->planes[0];
+    uint32_t size = payload_size(frame, payload_limit);
+
+    CHECK(v4l2_buf.timestamp.tv_usec == (long) frame, "Frame " <<
+            v4l2_buf.timestamp.tv_usec << " came back instead of frame " <<
+            frame);
+    CHECK(!(v4l2_buf.flags & V4L2_BUF_FLAG_LAST), "Frame " << frame <<
+            " is flagged LAST");
+    CHECK(plane.bytesused == size, "Frame " << frame << " has " <<
+            plane.bytesused << " bytes instead of " << size);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        CHECK(plane.data[i] == payload_byte(frame, i), "Byte " << i <<
+                " of frame " << frame << " is corrupted");
+    }
+    return 0;
+}
+
+/**
+ * Sets up both planes of @a element with @a num_buffers mapped MMAP
+ * buffers each, and starts streaming.
+ */
+static int
+setup_element(MockElement *element, uint32_t num_buffers)
+{
+    NvV4l2ElementPlane *planes[] = { &element->output_plane,
+        &element->capture_plane };
+    const uint32_t num_planes[] = { 1, 2 };
+
+    CHECK(element->subscribeEvent(V4L2_EVENT_EOS, 0, 0) == 0,
+            "Could not subscribe to the end of stream event");
+    for (uint32_t p = 0; p < 2; p++)
+    {
+        struct v4l2_format format;
+
+        /* The device picks the sizes of the default formats. */
+        memset(&format, 0, sizeof(format));
+        CHECK(planes[p]->getFormat(format) == 0 &&
+                planes[p]->setFormat(format) == 0,
+                "Could not set the format of plane " << p);
+        CHECK(planes[p]->setupPlane(V4L2_MEMORY_MMAP, num_buffers, true,
+                    false) == 0, "Could not set up plane " << p);
+        CHECK(planes[p]->getNumBuffers() == num_buffers, "Plane " << p <<
+                " has " << planes[p]->getNumBuffers() << " buffers instead of " <<
+                num_buffers);
+        CHECK(planes[p]->getNumPlanes() == num_planes[p], "Plane " << p <<
+                " buffers have " << planes[p]->getNumPlanes() << " planes");
+
+        for (uint32_t i = 0; i < num_buffers; i++)
+        {
+            NvBuffer *buffer = planes[p]->getNthBuffer(i);
+
+            CHECK(buffer, "Buffer " << i << " of plane " << p << " is missing");
+            for (uint32_t j = 0; j < buffer->n_planes; j++)
+            {
+                CHECK(buffer->planes[j].data &&
+                        buffer->planes[j].fmt.sizeimage > MIN_PAYLOAD &&
+                        buffer->planes[j].fd >= 0, "Plane " << j <<
+                        " of buffer " << i << " of plane " << p <<
+                        " is not mapped");
+            }
+        }
+    }
+    CHECK(element->capture_plane.getNthBuffer(0)->planes[0].fmt.sizeimage >=
+            WIDTH * HEIGHT, "Capture buffers are smaller than a frame");
+
+    /* The capture plane streams first, so that the device does not raise
+     * a resolution change. */
+    CHECK(element->capture_plane.setStreamStatus(true) == 0 &&
+            element->output_plane.setStreamStatus(true) == 0,
+            "Could not start streaming");
+    return 0;
+}
+
+/**
+ * Gets the largest payload which fits in the first plane of the buffers of
+ * both planes.
+ */
+static uint32_t
+get_payload_limit(MockElement *element)
+{
+    uint32_t out = element->output_plane.getNthBuffer(0)->planes[0].fmt.sizeimage;
+    uint32_t cap = element->capture_plane.getNthBuffer(0)->planes[0].fmt.sizeimage;
+
+    return out < cap ? out : cap;
+}
+
+static int
+queue_capture_buffers(MockElement *element, uint32_t num_buffers)
+{
+    for (uint32_t i = 0; i < num_buffers; i++)
+    {
+        QueuedBuffer buf;
+
+        init_buffer(buf, i);
+        CHECK(element->capture_plane.qBuffer(buf.v4l2_buf, NULL) == 0,
+                "Could not queue capture buffer " << i);
+    }
+    return 0;
+}
+
+/**
+ * Checks the end of stream event and the buffer counts of both planes once
+ * @a num_frames frames and the empty buffer have been processed.
+ */
+static int
+check_accounting(MockElement *element, uint32_t num_frames,
+        uint32_t num_buffers)
+{
+    NvV4l2ElementPlane &out = element->output_plane;
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    struct v4l2_event event;
+
+    CHECK(element->dqEvent(event, 1000) == 0 && event.type == V4L2_EVENT_EOS,
+            "The end of stream event was not raised");
+
+    CHECK(out.getTotalQueuedBuffers() == num_frames + 1 &&
+            out.getTotalDequeuedBuffers() == num_frames + 1 &&
+            out.getNumQueuedBuffers() == 0, "Output plane queued " <<
+            out.getTotalQueuedBuffers() << " and dequeued " <<
+            out.getTotalDequeuedBuffers() << " buffers, " <<
+            out.getNumQueuedBuffers() << " are still queued, instead of " <<
+            num_frames + 1);
+    /* Every capture buffer but the LAST one is queued again. */
+    CHECK(cap.getTotalQueuedBuffers() == num_buffers + num_frames &&
+            cap.getTotalDequeuedBuffers() == num_frames + 1 &&
+            cap.getNumQueuedBuffers() == num_buffers - 1,
+            "Capture plane queued " << cap.getTotalQueuedBuffers() <<
+            " and dequeued " << cap.getTotalDequeuedBuffers() <<
+            " buffers, " << cap.getNumQueuedBuffers() <<
+            " are still queued, instead of " << num_buffers + num_frames <<
+            ", " << num_frames + 1 << " and " << num_buffers - 1);
+    return 0;
+}
+
+static int
+stop_element(MockElement *element)
+{
+    CHECK(element->output_plane.setStreamStatus(false) == 0 &&
+            element->capture_plane.setStreamStatus(false) == 0,
+            "Could not stop streaming");
+    CHECK(!element->isInError(), "Element is in error");
+    return 0;
+}
+
+static int
+run_blocking(MockElement *element, uint32_t num_frames, uint32_t num_buffers)
+{
+    NvV4l2ElementPlane &out = element->output_plane;
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    uint32_t payload_limit;
+    uint64_t q_nsec = 0;
+    uint64_t dq_nsec = 0;
+    uint32_t num_q = 0;
+    uint32_t num_dq = 0;
+    uint64_t start = now_nsec();
+    uint64_t t;
+    QueuedBuffer buf;
+    NvBuffer *buffer;
+
+    if (setup_element(element, num_buffers) < 0 ||
+            queue_capture_buffers(element, num_buffers) < 0)
+    {
+        return -1;
+    }
+    payload_limit = get_payload_limit(element);
+
+    /* Frame num_frames is the empty buffer. */
+    for (uint32_t f = 0; f < num_buffers && f <= num_frames; f++)
+    {
+        init_buffer(buf, f);
+        fill_frame(out.getNthBuffer(f), buf, f < num_frames ? (int) f : -1,
+                payload_limit);
+        CHECK(out.qBuffer(buf.v4l2_buf, NULL) == 0, "Could not queue frame " << f);
+    }
+
+    for (uint32_t f = 0; f < num_frames; f++)
+    {
+        uint32_t next = f + num_buffers;
+
+        init_buffer(buf, 0);
+        t = now_nsec();
+        CHECK(cap.dqBuffer(buf.v4l2_buf, &buffer, NULL, 0) == 0,
+                "Could not dequeue frame " << f);
+        dq_nsec += now_nsec() - t;
+        num_dq++;
+        if (check_frame(buf.v4l2_buf, buffer, f, payload_limit) < 0)
+        {
+            return -1;
+        }
+        t = now_nsec();
+        CHECK(cap.qBuffer(buf.v4l2_buf, NULL) == 0,
+                "Could not queue capture buffer " << buf.v4l2_buf.index);
+        q_nsec += now_nsec() - t;
+        num_q++;
+
+        init_buffer(buf, 0);
+        t = now_nsec();
+        CHECK(out.dqBuffer(buf.v4l2_buf, &buffer, NULL, 0) == 0,
+                "Could not dequeue the output buffer of frame " << f);
+        dq_nsec += now_nsec() - t;
+        num_dq++;
+        if (next <= num_frames)
+        {
+            fill_frame(buffer, buf, next < num_frames ? (int) next : -1,
+                    payload_limit);
+            t = now_nsec();
+            CHECK(out.qBuffer(buf.v4l2_buf, NULL) == 0,
+                    "Could not queue frame " << next);
+            q_nsec += now_nsec() - t;
+            num_q++;
+        }
+    }
+
+    /* The empty buffer comes back flagged LAST, then the capture plane
+     * reports the end of stream. */
+    init_buffer(buf, 0);
+    CHECK(cap.dqBuffer(buf.v4l2_buf, &buffer, NULL, 0) == 0,
+            "Could not dequeue the LAST buffer");
+    CHECK((buf.v4l2_buf.flags & V4L2_BUF_FLAG_LAST) &&
+            buffer->planes[0].bytesused == 0,
+            "Empty buffer did not come back flagged LAST");
+    init_buffer(buf, 0);
+    CHECK(cap.dqBuffer(buf.v4l2_buf, &buffer, NULL, 0) < 0 &&
+            errno == EAGAIN && (buf.v4l2_buf.flags & V4L2_BUF_FLAG_LAST),
+            "Capture plane did not report the end of stream");
+
+    while (out.getNumQueuedBuffers())
+    {
+        init_buffer(buf, 0);
+        CHECK(out.dqBuffer(buf.v4l2_buf, &buffer, NULL, 0) == 0,
+                "Could not dequeue the last output buffers");
+    }
+    CHECK(out.waitAllBuffersDequeued(WAIT_MS) == 0,
+            "Output plane buffers are still queued");
+
+    if (check_accounting(element, num_frames, num_buffers) < 0 ||
+            stop_element(element) < 0)
+    {
+        return -1;
+    }
+
+    cout << "blocking: " << fixed << setprecision(0) <<
+        num_frames * 1e9 / (now_nsec() - start) << " frames/s, qBuffer " <<
+        q_nsec / num_q << " ns, dqBuffer " << dq_nsec / num_dq << " ns" << endl;
+    return 0;
+}
+
+/**
+ * State shared by the DQ threads of both planes.
+ */
+typedef struct
+{
+    MockElement *element;
+    uint32_t num_frames;
+    uint32_t payload_limit;
+    /** Next frame to queue, written by the output plane DQ thread. */
+    uint32_t next_frame;
+    /** Frames checked by the capture plane DQ thread. */
+    uint32_t captured;
+    bool eos;
+    atomic<bool> failed;
+    atomic<uint64_t> q_nsec;
+    atomic<uint64_t> num_q;
+} DQContext;
+
+static bool
+output_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+        NvBuffer *shared_buffer, void *arg)
+{
+    DQContext *ctx = (DQContext *) arg;
+    QueuedBuffer buf;
+    uint64_t t;
+
+    if (!v4l2_buf)
+    {
+        return !ctx->element->isInError();
+    }
+    if (ctx->next_frame > ctx->num_frames)
+    {
+        return true;
+    }
+
+    init_buffer(buf, v4l2_buf->index);
+    fill_frame(buffer, buf, ctx->next_frame < ctx->num_frames ?
+            (int) ctx->next_frame : -1, ctx->payload_limit);
+    t = now_nsec();
+    if (ctx->element->output_plane.qBuffer(buf.v4l2_buf, NULL) < 0)
+    {
+        cerr << "Could not queue frame " << ctx->next_frame << endl;
+        ctx->failed = true;
+        return false;
+    }
+    ctx->q_nsec += now_nsec() - t;
+    ctx->num_q++;
+    ctx->next_frame++;
+    return true;
+}
+
+static bool
+capture_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+        NvBuffer *shared_buffer, void *arg)
+{
+    DQContext *ctx = (DQContext *) arg;
+    uint64_t t;
+
+    if (!v4l2_buf)
+    {
+        cerr << "Capture plane ended before the LAST buffer" << endl;
+        ctx->failed = true;
+        return false;
+    }
+    if (buffer->planes[0].bytesused == 0)
+    {
+        if (!(v4l2_buf->flags & V4L2_BUF_FLAG_LAST) ||
+                ctx->captured != ctx->num_frames)
+        {
+            cerr << "Empty buffer after " << ctx->captured << " frames" << endl;
+            ctx->failed = true;
+        }
+        ctx->eos = true;
+        return false;
+    }
+    if (check_frame(*v4l2_buf, buffer, ctx->captured, ctx->payload_limit) < 0)
+    {
+        ctx->failed = true;
+        return false;
+    }
+    ctx->captured++;
+
+    t = now_nsec();
+    if (ctx->element->capture_plane.qBuffer(*v4l2_buf, NULL) < 0)
+    {
+        cerr << "Could not queue capture buffer " << v4l2_buf->index << endl;
+        ctx->failed = true;
+        return false;
+    }
+    ctx->q_nsec += now_nsec() - t;
+    ctx->num_q++;
+    return true;
+}
+
+static int
+run_dq_threads(MockElement *element, uint32_t num_frames,
+        uint32_t num_buffers, uint32_t delay_usec, uint32_t capacity)
+{
+    NvV4l2ElementPlane &out = element->output_plane;
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    DQContext ctx;
+    QueuedBuffer buf;
+    uint64_t start;
+    uint64_t elapsed;
+    uint64_t min_elapsed;
+
+    if (setup_element(element, num_buffers) < 0)
+    {
+        return -1;
+    }
+
+    ctx.element = element;
+    ctx.num_frames = num_frames;
+    ctx.payload_limit = get_payload_limit(element);
+    ctx.next_frame = 0;
+    ctx.captured = 0;
+    ctx.eos = false;
+    ctx.failed = false;
+    ctx.q_nsec = 0;
+    ctx.num_q = 0;
+
+    start = now_nsec();
+    cap.setDQThreadCallback(capture_callback);
+    out.setDQThreadCallback(output_callback);
+    CHECK(cap.startDQThread(&ctx) == 0, "Could not start the capture DQ thread");
+    if (queue_capture_buffers(element, num_buffers) < 0)
+    {
+        return -1;
+    }
+    /* The output plane DQ thread takes over once the buffers are queued. */
+    for (; ctx.next_frame < num_buffers; ctx.next_frame++)
+    {
+        init_buffer(buf, ctx.next_frame);
+        fill_frame(out.getNthBuffer(ctx.next_frame), buf, ctx.next_frame,
+                ctx.payload_limit);
+        CHECK(out.qBuffer(buf.v4l2_buf, NULL) == 0, "Could not queue frame " <<
+                ctx.next_frame);
+    }
+    CHECK(out.startDQThread(&ctx) == 0, "Could not start the output DQ thread");
+
+    CHECK(cap.waitForDQThread(WAIT_MS) == 0, "Capture DQ thread did not stop, " <<
+            ctx.captured << " frames captured");
+    elapsed = now_nsec() - start;
+    CHECK(out.waitAllBuffersDequeued(WAIT_MS) == 0,
+            "Output plane buffers are still queued");
+    /* The capture DQ thread was joined by waitForDQThread(). */
+    out.stopDQThread();
+    CHECK(!ctx.failed && ctx.eos, "DQ threads failed after " << ctx.captured <<
+            " frames");
+
+    if (check_accounting(element, num_frames, num_buffers) < 0 ||
+            stop_element(element) < 0)
+    {
+        return -1;
+    }
+
+    /* The device processes at most capacity frames per delay. */
+    min_elapsed = (uint64_t) ((num_frames + capacity - 1) / capacity) *
+        delay_usec * 1000;
+    CHECK(elapsed >= min_elapsed, num_frames << " frames took " <<
+            elapsed / 1000 << " us, the device needs " << min_elapsed / 1000);
+
+    cout << "DQ threads, capacity " << capacity << ": " << fixed <<
+        setprecision(0) << num_frames * 1e9 / elapsed << " frames/s of " <<
+        1e6 * capacity / delay_usec << ", qBuffer " <<
+        ctx.q_nsec / ctx.num_q << " ns" << endl;
+    return 0;
+}
+
+static int
+check_setup()
+{
+    MockElement *element = MockElement::createMockElement("mock0", true);
+
+    CHECK(element, "Could not open the mock device");
+    if (setup_element(element, DEFAULT_BUFFERS) < 0 ||
+            stop_element(element) < 0)
+    {
+        delete element;
+        return -1;
+    }
+    delete element;
+
+    cout << "setup: OK" << endl;
+    return 0;
+}
+
+static int
+check_blocking(uint32_t num_frames, uint32_t num_buffers)
+{
+    MockElement *element;
+    int ret;
+
+    NvV4l2MockDevice::setProcessingDelay(0);
+    NvV4l2MockDevice::setCapacity(1);
+    element = MockElement::createMockElement("mock1", true);
+    CHECK(element, "Could not open the mock device");
+    ret = run_blocking(element, num_frames, num_buffers);
+    delete element;
+    CHECK(ret == 0, "Blocking check failed");
+
+    cout << "blocking: OK" << endl;
+    return 0;
+}
+
+static int
+check_dq_threads(uint32_t num_frames, uint32_t num_buffers,
+        uint32_t delay_usec, uint32_t capacity)
+{
+    /* One buffer at a time, then the capacity asked for. */
+    const uint32_t capacities[] = { 1, capacity };
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        MockElement *element;
+        int ret;
+
+        NvV4l2MockDevice::setProcessingDelay(delay_usec);
+        NvV4l2MockDevice::setCapacity(capacities[i]);
+        element = MockElement::createMockElement("mock2", false);
+        CHECK(element, "Could not open the mock device");
+        ret = run_dq_threads(element, num_frames, num_buffers, delay_usec,
+                capacities[i]);
+        delete element;
+        CHECK(ret == 0, "DQ thread check with capacity " << capacities[i] <<
+                " failed");
+    }
+
+    cout << "DQ threads: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Help:" << endl;
+    cout << "Execution cmd:\n"
+         << "./v4l2plane_sample [-n frames] [-b buffers] [-d delay_usec] [-c capacity] [-v]\n"
+         << endl;
+    cout << "\t-n frames     Frames processed per check (default "
+         << DEFAULT_FRAMES << ")" << endl;
+    cout << "\t-b buffers    Buffers of each plane (default "
+         << DEFAULT_BUFFERS << ")" << endl;
+    cout << "\t-d delay_usec Processing delay of the device (default "
+         << DEFAULT_DELAY_USEC << ")" << endl;
+    cout << "\t-c capacity   Buffers processed concurrently by the device "
+         << "(default " << DEFAULT_CAPACITY << ")" << endl;
+    cout << "\t-v            Print the debug messages" << endl;
+    cout << "\t-h            Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_frames = DEFAULT_FRAMES;
+    uint32_t num_buffers = DEFAULT_BUFFERS;
+    uint32_t delay_usec = DEFAULT_DELAY_USEC;
+    uint32_t capacity = DEFAULT_CAPACITY;
+    int opt;
+
+    log_level = LOG_LEVEL_INFO;
+    while ((opt = getopt(argc, argv, "n:b:d:c:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                num_frames = atoi(optarg);
+                break;
+            case 'b':
+                num_buffers = atoi(optarg);
+                break;
+            case 'd':
+                delay_usec = atoi(optarg);
+                break;
+            case 'c':
+                capacity = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_DEBUG;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_buffers < 2 || num_buffers > MAX_BUFFERS ||
+            num_frames < num_buffers || num_frames > 1000000 ||
+            capacity < 1 || capacity > MAX_BUFFERS)
+    {
+        print_help();
+        return -1;
+    }
+
+    NvV4l2Element::setDeviceOps(NvV4l2MockDevice::getDeviceOps());
+    NvV4l2MockDevice::setResolution(WIDTH, HEIGHT);
+
+    if (check_setup() < 0 || check_blocking(num_frames, num_buffers) < 0 ||
+            check_dq_threads(num_frames, num_buffers, delay_usec,
+                capacity) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
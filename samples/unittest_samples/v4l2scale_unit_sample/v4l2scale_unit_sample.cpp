@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./v4l2scale_sample [-s streams] [-w workers] [-n frames] [-d delay_usec] [-f min_fps] [-v]
+ * Example:
+ * ./v4l2scale_sample
+ * ./v4l2scale_sample -s 512 -w 4 -n 120
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NvV4l2Element.h"
+#include "NvV4l2MockDevice.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only scaling check of many streams on the mock V4L2 device.
+ *
+ * Every stream is a mock device carrying frames from its output plane to
+ * its capture plane, with a processing delay per frame as a hardware codec
+ * has. A fixed pool of reactor threads drives all the streams, each
+ * sleeping in a single NvV4l2Element::pollElements() over its streams, as
+ * the reactor mode of 14_multivideo_decode does.
+ *
+ * The check fails if a stream does not carry all its frames, if a stream
+ * runs slower than the minimum frame rate, or if the process gains more
+ * threads than the reactor threads while the streams run.
+ */
+
+#define DEFAULT_STREAMS 256
+#define DEFAULT_WORKERS 2
+#define DEFAULT_FRAMES 60
+#define DEFAULT_DELAY_USEC 1000
+#define DEFAULT_MIN_FPS 30
+#define NUM_BUFFERS 4
+#define FRAME_SIZE 64
+#define POLL_MS 1000
+#define SAMPLE_USEC 10000
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Element with no format logic of its own, on the mock device.
+ */
+class MockElement : public NvV4l2Element
+{
+public:
+    static MockElement *createMockElement(const char *name)
+    {
+        MockElement *element = new MockElement(name);
+
+        if (element->isInError())
+        {
+            delete element;
+            return NULL;
+        }
+        return element;
+    }
+
+private:
+    MockElement(const char *name)
+        : NvV4l2Element(name, "/dev/nvhost-mock", O_NONBLOCK,
+                NvElementProfiler::PROFILER_FIELD_ALL)
+    {
+    }
+
+    /**
+     * Disallow copy constructor.
+     */
+    MockElement(const MockElement& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(MockElement const&);
+};
+
+/**
+ * A stream, driven by one reactor thread.
+ */
+typedef struct
+{
+    MockElement *element;
+    uint32_t queued;
+    uint32_t captured;
+    uint64_t start_nsec;
+    uint64_t end_nsec;
+    bool failed;
+} Stream;
+
+/**
+ * A reactor thread and the streams it drives.
+ */
+typedef struct
+{
+    vector<Stream *> streams;
+    uint32_t num_frames;
+    pthread_t thread;
+    int ret;
+} Worker;
+
+static atomic<uint32_t> workers_running;
+
+static int
+queue_buffer(NvV4l2ElementPlane &plane, uint32_t index, uint32_t bytesused)
+{
+    struct v4l2_buffer v4l2_buf;
+    struct v4l2_plane planes[MAX_PLANES];
+
+    memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+    memset(planes, 0, sizeof(planes));
+    v4l2_buf.index = index;
+    v4l2_buf.m.planes = planes;
+    if (bytesused)
+    {
+        planes[0].bytesused = bytesused;
+        plane.getNthBuffer(index)->planes[0].bytesused = bytesused;
+    }
+    return plane.qBuffer(v4l2_buf, NULL);
+}
+
+static MockElement *
+open_stream(uint32_t index)
+{
+    string name = "mock" + to_string(index);
+    MockElement *element = MockElement::createMockElement(name.c_str());
+
+    if (!element)
+    {
+        return NULL;
+    }
+
+    NvV4l2ElementPlane *planes[] = { &element->output_plane,
+        &element->capture_plane };
+    for (uint32_t p = 0; p < 2; p++)
+    {
+        struct v4l2_format format;
+
+        memset(&format, 0, sizeof(format));
+        if (planes[p]->getFormat(format) < 0 ||
+                planes[p]->setFormat(format) < 0 ||
+                planes[p]->setupPlane(V4L2_MEMORY_MMAP, NUM_BUFFERS, true,
+                    false) < 0)
+        {
+            cerr << "Could not set up plane " << p << endl;
+            delete element;
+            return NULL;
+        }
+    }
+    /* The capture plane streams first, so that the device does not raise
+     * a resolution change. */
+    if (element->capture_plane.setStreamStatus(true) < 0 ||
+            element->output_plane.setStreamStatus(true) < 0)
+    {
+        cerr << "Could not start streaming" << endl;
+        delete element;
+        return NULL;
+    }
+    for (uint32_t i = 0; i < NUM_BUFFERS; i++)
+    {
+        if (queue_buffer(element->capture_plane, i, 0) < 0)
+        {
+            cerr << "Could not queue capture buffer " << i << endl;
+            delete element;
+            return NULL;
+        }
+    }
+    return element;
+}
+
+/**
+ * Dequeues the frames of a ready stream and queues the buffers back.
+ *
+ * @return true once the stream has captured all its frames.
+ */
+static bool
+service_stream(Stream *stream, uint32_t num_frames)
+{
+    NvV4l2ElementPlane &out = stream->element->output_plane;
+    NvV4l2ElementPlane &cap = stream->element->capture_plane;
+    struct v4l2_buffer v4l2_buf;
+    struct v4l2_plane planes[MAX_PLANES];
+
+    while (true)
+    {
+        memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+        memset(planes, 0, sizeof(planes));
+        v4l2_buf.m.planes = planes;
+        if (out.dqBuffer(v4l2_buf, NULL, NULL, 0) < 0)
+        {
+            break;
+        }
+        if (stream->queued < num_frames)
+        {
+            if (queue_buffer(out, v4l2_buf.index, FRAME_SIZE) < 0)
+            {
+                stream->failed = true;
+                return true;
+            }
+            stream->queued++;
+        }
+    }
+    if (errno != EAGAIN)
+    {
+        stream->failed = true;
+        return true;
+    }
+
+    while (stream->captured < num_frames)
+    {
+        memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+        memset(planes, 0, sizeof(planes));
+        v4l2_buf.m.planes = planes;
+        if (cap.dqBuffer(v4l2_buf, NULL, NULL, 0) < 0)
+        {
+            if (errno != EAGAIN)
+            {
+                stream->failed = true;
+                return true;
+            }
+            return false;
+        }
+        if (++stream->captured < num_frames &&
+                queue_buffer(cap, v4l2_buf.index, 0) < 0)
+        {
+            stream->failed = true;
+            return true;
+        }
+    }
+    stream->end_nsec = now_nsec();
+    return true;
+}
+
+static void *
+worker_thread(void *arg)
+{
+    Worker *worker = (Worker *) arg;
+    vector<Stream *> active(worker->streams);
+    vector<Stream *> pending;
+    vector<NvV4l2Element *> elements;
+    bool *ready = new bool[active.size()];
+    uint32_t i;
+    int ret;
+
+    worker->ret = 0;
+    for (i = 0; i < active.size(); i++)
+    {
+        Stream *stream = active[i];
+
+        stream->start_nsec = now_nsec();
+        for (; stream->queued < NUM_BUFFERS &&
+                stream->queued < worker->num_frames; stream->queued++)
+        {
+            if (queue_buffer(stream->element->output_plane, stream->queued,
+                        FRAME_SIZE) < 0)
+            {
+                stream->failed = true;
+                break;
+            }
+        }
+    }
+
+    while (!active.empty())
+    {
+        elements.clear();
+        for (i = 0; i < active.size(); i++)
+        {
+            elements.push_back(active[i]->element);
+        }
+        ret = NvV4l2Element::pollElements(&elements[0], elements.size(),
+                ready, POLL_MS);
+        if (ret < 0)
+        {
+            worker->ret = -1;
+            break;
+        }
+
+        pending.clear();
+        for (i = 0; i < active.size(); i++)
+        {
+            /* On timeout, check every stream again. */
+            if ((ret == 0 || ready[i]) &&
+                    service_stream(active[i], worker->num_frames))
+            {
+                continue;
+            }
+            pending.push_back(active[i]);
+        }
+        active.swap(pending);
+    }
+
+    delete[] ready;
+    workers_running--;
+    return NULL;
+}
+
+static uint32_t
+count_threads()
+{
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+    uint32_t count = 0;
+
+    if (!dir)
+    {
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] != '.')
+        {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static int
+run_streams(uint32_t num_streams, uint32_t num_workers, uint32_t num_frames,
+        uint32_t min_fps)
+{
+    vector<Stream> streams(num_streams);
+    vector<Worker> workers(num_workers);
+    uint32_t base_threads;
+    uint32_t max_threads;
+    uint32_t num_started = 0;
+    uint32_t failed = 0;
+    double min_stream_fps = 0;
+    double sum_fps = 0;
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t i;
+    int ret = 0;
+
+    for (i = 0; i < num_streams; i++)
+    {
+        streams[i].element = open_stream(i);
+        streams[i].queued = 0;
+        streams[i].captured = 0;
+        streams[i].start_nsec = 0;
+        streams[i].end_nsec = 0;
+        streams[i].failed = false;
+        if (!streams[i].element)
+        {
+            cerr << "Could not open stream " << i << endl;
+            ret = -1;
+            break;
+        }
+        workers[i % num_workers].streams.push_back(&streams[i]);
+    }
+
+    if (ret == 0)
+    {
+        /* Every device and its mock processing thread is up, only the
+         * reactor threads may be added from now on. */
+        base_threads = count_threads();
+        max_threads = base_threads;
+        workers_running = num_workers;
+        start = now_nsec();
+        for (; num_started < num_workers; num_started++)
+        {
+            Worker &worker = workers[num_started];
+
+            worker.num_frames = num_frames;
+            if (pthread_create(&worker.thread, NULL, worker_thread,
+                        &worker) != 0)
+            {
+                cerr << "Could not create reactor thread " << num_started <<
+                    endl;
+                /* The streams of the missing threads are reported below. */
+                workers_running -= num_workers - num_started;
+                ret = -1;
+                break;
+            }
+            string name = "Reactor" + to_string(num_started);
+            pthread_setname_np(worker.thread, name.c_str());
+        }
+        while (workers_running > 0)
+        {
+            uint32_t threads = count_threads();
+
+            if (threads > max_threads)
+            {
+                max_threads = threads;
+            }
+            usleep(SAMPLE_USEC);
+        }
+        elapsed = now_nsec() - start;
+        for (i = 0; i < num_started; i++)
+        {
+            pthread_join(workers[i].thread, NULL);
+            if (workers[i].ret < 0)
+            {
+                ret = -1;
+            }
+        }
+
+        for (i = 0; i < num_streams; i++)
+        {
+            Stream &stream = streams[i];
+            double fps;
+
+            if (stream.failed || stream.captured != num_frames)
+            {
+                cerr << "Stream " << i << " captured " << stream.captured <<
+                    " frames instead of " << num_frames << endl;
+                failed++;
+                continue;
+            }
+            fps = num_frames * 1e9 / (stream.end_nsec - stream.start_nsec);
+            if (i == 0 || fps < min_stream_fps)
+            {
+                min_stream_fps = fps;
+            }
+            sum_fps += fps;
+        }
+
+        cout << num_streams << " streams, " << num_workers <<
+            " reactor threads: " << fixed << setprecision(0) <<
+            (uint64_t) num_streams * num_frames * 1e9 / elapsed <<
+            " frames/s in total" << endl;
+        if (failed < num_streams)
+        {
+            cout << "Per stream: mean " << sum_fps / (num_streams - failed) <<
+                " fps, min " << min_stream_fps << " fps" << endl;
+        }
+        cout << "Threads added while decoding: " <<
+            max_threads - base_threads << endl;
+
+        if (failed > 0)
+        {
+            cerr << failed << " streams failed" << endl;
+            ret = -1;
+        }
+        else if (min_stream_fps < min_fps)
+        {
+            cerr << "A stream ran below " << min_fps << " fps" << endl;
+            ret = -1;
+        }
+        if (max_threads - base_threads > num_workers)
+        {
+            cerr << "More threads than the reactor threads were added" <<
+                endl;
+            ret = -1;
+        }
+    }
+
+    for (i = 0; i < num_streams; i++)
+    {
+        delete streams[i].element;
+    }
+    return ret;
+}
+
+static void
+print_help()
+{
+    cout << "Help:" << endl;
+    cout << "Execution cmd:\n"
+         << "./v4l2scale_sample [-s streams] [-w workers] [-n frames] "
+         << "[-d delay_usec] [-f min_fps] [-v]\n"
+         << endl;
+    cout << "\t-s streams    Number of streams (default " << DEFAULT_STREAMS
+         << ")" << endl;
+    cout << "\t-w workers    Number of reactor threads (default "
+         << DEFAULT_WORKERS << ")" << endl;
+    cout << "\t-n frames     Frames carried by each stream (default "
+         << DEFAULT_FRAMES << ")" << endl;
+    cout << "\t-d delay_usec Processing delay of a frame on the mock device "
+         << "(default " << DEFAULT_DELAY_USEC << ")" << endl;
+    cout << "\t-f min_fps    Lowest frame rate allowed for a stream (default "
+         << DEFAULT_MIN_FPS << ")" << endl;
+    cout << "\t-v            Print the debug messages" << endl;
+    cout << "\t-h            Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t num_streams = DEFAULT_STREAMS;
+    uint32_t num_workers = DEFAULT_WORKERS;
+    uint32_t num_frames = DEFAULT_FRAMES;
+    uint32_t delay_usec = DEFAULT_DELAY_USEC;
+    uint32_t min_fps = DEFAULT_MIN_FPS;
+    int opt;
+
+    log_level = LOG_LEVEL_INFO;
+    while ((opt = getopt(argc, argv, "s:w:n:d:f:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                num_streams = atoi(optarg);
+                break;
+            case 'w':
+                num_workers = atoi(optarg);
+                break;
+            case 'n':
+                num_frames = atoi(optarg);
+                break;
+            case 'd':
+                delay_usec = atoi(optarg);
+                break;
+            case 'f':
+                min_fps = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_DEBUG;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (num_streams < 1 || num_workers < 1 || num_workers > num_streams ||
+            num_frames < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    NvV4l2Element::setDeviceOps(NvV4l2MockDevice::getDeviceOps());
+    NvV4l2MockDevice::setProcessingDelay(delay_usec);
+
+    if (run_streams(num_streams, num_workers, num_frames, min_fps) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}
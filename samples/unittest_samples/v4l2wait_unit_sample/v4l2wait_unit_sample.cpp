@@ -0,0 +1,663 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Execution command
+ * ./v4l2wait_sample [-n iterations] [-l max_latency_usec] [-v]
+ * Example:
+ * ./v4l2wait_sample
+ * ./v4l2wait_sample -n 200 -l 500
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NvV4l2Element.h"
+#include "NvV4l2DQPoller.h"
+#include "NvV4l2MockDevice.h"
+#include "NvLogging.h"
+
+using namespace std;
+
+/**
+ * CPU only check of the waits of NvV4l2ElementPlane and NvV4l2Element on
+ * the mock V4L2 device.
+ *
+ * Every check runs twice: with the @c poll entry point of the mock, and
+ * without it, as with libv4l2 on Tegra, where the waits sleep in the
+ * DevicePoll control of the device:
+ *
+ * - timeout: waitForBuffer() and dqEvent() with nothing to dequeue must
+ *   time out after their timeout, and not much later;
+ * - latency: a thread sleeping in waitForBuffer() must wake up as soon as
+ *   a buffer is ready, the mean latency must stay below a bound;
+ * - abort: interruptWait() must end the wait of its plane or element with
+ *   ECANCELED, leave the other waits on the device sleeping, and be
+ *   remembered if no wait is in progress;
+ * - streamoff: stopping the stream must end the DQ Thread of the plane and
+ *   remove the plane from its NvV4l2DQPoller;
+ * - poller: a poller must carry frames through both planes of an element.
+ *   Without @c poll, planes of another element must be refused.
+ */
+
+#define DEFAULT_ITERATIONS 50
+#define DEFAULT_MAX_LATENCY_USEC 1000
+#define NUM_BUFFERS 4
+#define NUM_POLLER_FRAMES 200
+#define TIMEOUT_MS 20
+#define SLACK_MS 500
+#define SETTLE_USEC 2000
+#define WAIT_MS 10000
+
+#define CHECK(cond, msg) \
+    if (!(cond)) \
+    { \
+        cerr << msg << endl; \
+        return -1; \
+    }
+
+static uint64_t
+now_nsec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Element with no format logic of its own, on the mock device.
+ */
+class MockElement : public NvV4l2Element
+{
+public:
+    static MockElement *createMockElement(const char *name)
+    {
+        MockElement *element = new MockElement(name);
+
+        if (element->isInError())
+        {
+            delete element;
+            return NULL;
+        }
+        return element;
+    }
+
+private:
+    MockElement(const char *name)
+        : NvV4l2Element(name, "/dev/nvhost-mock", O_NONBLOCK,
+                NvElementProfiler::PROFILER_FIELD_ALL)
+    {
+    }
+
+    /**
+     * Disallow copy constructor.
+     */
+    MockElement(const MockElement& that);
+    /**
+     * Disallow assignment.
+     */
+    void operator=(MockElement const&);
+};
+
+static MockElement *
+open_element(const char *name)
+{
+    MockElement *element = MockElement::createMockElement(name);
+
+    if (!element)
+    {
+        return NULL;
+    }
+
+    NvV4l2ElementPlane *planes[] = { &element->output_plane,
+        &element->capture_plane };
+    for (uint32_t p = 0; p < 2; p++)
+    {
+        struct v4l2_format format;
+
+        memset(&format, 0, sizeof(format));
+        if (planes[p]->getFormat(format) < 0 ||
+                planes[p]->setFormat(format) < 0 ||
+                planes[p]->setupPlane(V4L2_MEMORY_MMAP, NUM_BUFFERS, true,
+                    false) < 0)
+        {
+            cerr << "Could not set up plane " << p << endl;
+            delete element;
+            return NULL;
+        }
+    }
+    /* The capture plane streams first, so that the device does not raise
+     * a resolution change. */
+    if (element->subscribeEvent(V4L2_EVENT_EOS, 0, 0) < 0 ||
+            element->capture_plane.setStreamStatus(true) < 0 ||
+            element->output_plane.setStreamStatus(true) < 0)
+    {
+        cerr << "Could not start streaming" << endl;
+        delete element;
+        return NULL;
+    }
+    return element;
+}
+
+static int
+queue_buffer(NvV4l2ElementPlane &plane, uint32_t index, uint32_t bytesused)
+{
+    struct v4l2_buffer v4l2_buf;
+    struct v4l2_plane planes[MAX_PLANES];
+
+    memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+    memset(planes, 0, sizeof(planes));
+    v4l2_buf.index = index;
+    v4l2_buf.m.planes = planes;
+    if (bytesused)
+    {
+        planes[0].bytesused = bytesused;
+        plane.getNthBuffer(index)->planes[0].bytesused = bytesused;
+    }
+    return plane.qBuffer(v4l2_buf, NULL);
+}
+
+static int
+dequeue_buffer(NvV4l2ElementPlane &plane)
+{
+    struct v4l2_buffer v4l2_buf;
+    struct v4l2_plane planes[MAX_PLANES];
+
+    memset(&v4l2_buf, 0, sizeof(v4l2_buf));
+    memset(planes, 0, sizeof(planes));
+    v4l2_buf.m.planes = planes;
+    if (plane.waitForBuffer(WAIT_MS) < 0 ||
+            plane.dqBuffer(v4l2_buf, NULL, NULL, 0) < 0)
+    {
+        return -1;
+    }
+    return v4l2_buf.index;
+}
+
+/**
+ * Result of a wait run on another thread.
+ */
+typedef struct
+{
+    MockElement *element;
+    NvV4l2ElementPlane *plane; /* NULL to wait for an event. */
+    pthread_t thread;
+    atomic<bool> done;
+    int ret;
+    int err;
+    uint64_t end_nsec;
+} Waiter;
+
+static void *
+wait_thread(void *arg)
+{
+    Waiter *waiter = (Waiter *) arg;
+    struct v4l2_event event;
+
+    if (waiter->plane)
+    {
+        waiter->ret = waiter->plane->waitForBuffer(-1);
+    }
+    else
+    {
+        waiter->ret = waiter->element->dqEvent(event, UINT_MAX);
+    }
+    waiter->err = errno;
+    waiter->end_nsec = now_nsec();
+    waiter->done = true;
+    return NULL;
+}
+
+static int
+start_waiter(Waiter &waiter, MockElement *element, NvV4l2ElementPlane *plane)
+{
+    waiter.element = element;
+    waiter.plane = plane;
+    waiter.done = false;
+    CHECK(pthread_create(&waiter.thread, NULL, wait_thread, &waiter) == 0,
+            "Could not create wait thread");
+    /* Let the thread go to sleep. */
+    usleep(SETTLE_USEC);
+    return 0;
+}
+
+/**
+ * Ends a wait that must still be sleeping with interruptWait().
+ */
+static int
+interrupt_waiter(Waiter &waiter, const char *what)
+{
+    uint64_t start;
+
+    CHECK(!waiter.done, what << " wait ended early");
+    start = now_nsec();
+    if (waiter.plane)
+    {
+        waiter.plane->interruptWait();
+    }
+    else
+    {
+        waiter.element->interruptWait();
+    }
+    pthread_join(waiter.thread, NULL);
+    CHECK(waiter.ret < 0 && waiter.err == ECANCELED, what <<
+            " wait returned " << waiter.ret << " instead of ECANCELED");
+    CHECK(waiter.end_nsec - start < SLACK_MS * 1000000ULL, what <<
+            " wait took " << (waiter.end_nsec - start) / 1000 <<
+            " us to abort");
+    return 0;
+}
+
+static int
+run_timeout(MockElement *element)
+{
+    struct v4l2_event event;
+    uint64_t start;
+    uint64_t elapsed;
+
+    start = now_nsec();
+    CHECK(element->capture_plane.waitForBuffer(0) < 0 && errno == EAGAIN,
+            "Wait without timeout did not return EAGAIN");
+    CHECK(element->capture_plane.waitForBuffer(TIMEOUT_MS) < 0 &&
+            errno == EAGAIN, "Timed wait did not return EAGAIN");
+    elapsed = now_nsec() - start;
+    CHECK(elapsed >= TIMEOUT_MS * 1000000ULL &&
+            elapsed < (TIMEOUT_MS + SLACK_MS) * 1000000ULL,
+            "Timed wait took " << elapsed / 1000 << " us instead of " <<
+            TIMEOUT_MS << " ms");
+
+    start = now_nsec();
+    CHECK(element->dqEvent(event, TIMEOUT_MS) < 0 && errno == EAGAIN,
+            "Timed event wait did not return EAGAIN");
+    elapsed = now_nsec() - start;
+    CHECK(elapsed >= TIMEOUT_MS * 1000000ULL &&
+            elapsed < (TIMEOUT_MS + SLACK_MS) * 1000000ULL,
+            "Timed event wait took " << elapsed / 1000 << " us instead of " <<
+            TIMEOUT_MS << " ms");
+    return 0;
+}
+
+static int
+run_latency(MockElement *element, uint32_t iterations,
+        uint32_t max_latency_usec, const char *mode)
+{
+    NvV4l2ElementPlane &out = element->output_plane;
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    uint64_t total_nsec = 0;
+    uint64_t max_nsec = 0;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        Waiter waiter;
+        uint64_t start;
+        uint64_t latency;
+
+        CHECK(queue_buffer(cap, i % NUM_BUFFERS, 0) == 0,
+                "Could not queue capture buffer");
+        if (start_waiter(waiter, element, &cap) < 0)
+        {
+            return -1;
+        }
+        CHECK(!waiter.done, "Wait ended before a buffer was ready");
+        start = now_nsec();
+        CHECK(queue_buffer(out, i % NUM_BUFFERS, 64) == 0,
+                "Could not queue output buffer");
+        pthread_join(waiter.thread, NULL);
+        CHECK(waiter.ret == 0, "Wait for the capture buffer failed");
+
+        latency = waiter.end_nsec - start;
+        total_nsec += latency;
+        if (latency > max_nsec)
+        {
+            max_nsec = latency;
+        }
+        CHECK(dequeue_buffer(cap) == (int) (i % NUM_BUFFERS) &&
+                dequeue_buffer(out) == (int) (i % NUM_BUFFERS),
+                "Could not dequeue the buffers of iteration " << i);
+    }
+
+    cout << mode << " wake-up latency: mean " << total_nsec / iterations / 1000
+        << " us, max " << max_nsec / 1000 << " us" << endl;
+    CHECK(total_nsec / iterations <= max_latency_usec * 1000ULL,
+            "Mean wake-up latency is above " << max_latency_usec << " us");
+    return 0;
+}
+
+static int
+run_abort(MockElement *element)
+{
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    Waiter cap_waiter;
+    Waiter event_waiter;
+
+    /* Both waits sleep on the same device, interrupting one of them must
+     * not end the other. */
+    if (start_waiter(event_waiter, element, NULL) < 0 ||
+            start_waiter(cap_waiter, element, &cap) < 0 ||
+            interrupt_waiter(cap_waiter, "Capture plane") < 0)
+    {
+        return -1;
+    }
+    usleep(SETTLE_USEC);
+    if (interrupt_waiter(event_waiter, "Event") < 0)
+    {
+        return -1;
+    }
+
+    /* An interrupt without a wait in progress ends the next wait only. */
+    cap.interruptWait();
+    CHECK(cap.waitForBuffer(-1) < 0 && errno == ECANCELED,
+            "Interrupt before the wait was lost");
+    CHECK(cap.waitForBuffer(TIMEOUT_MS) < 0 && errno == EAGAIN,
+            "Interrupt ended more than one wait");
+    return 0;
+}
+
+static bool
+stop_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+        NvBuffer *shared_buffer, void *arg)
+{
+    return v4l2_buf != NULL;
+}
+
+static int
+run_streamoff(MockElement *element, NvV4l2DQPoller *poller,
+        const char *what)
+{
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    uint64_t start;
+    uint64_t elapsed;
+
+    cap.setDQThreadCallback(stop_callback);
+    CHECK(cap.startDQThread(NULL, poller) == 0, "Could not start the " <<
+            what);
+    usleep(SETTLE_USEC);
+
+    start = now_nsec();
+    CHECK(cap.setStreamStatus(false) == 0, "Could not stop the capture plane");
+    CHECK(cap.waitForDQThread(SLACK_MS) == 0, "The " << what <<
+            " did not stop on STREAMOFF");
+    elapsed = now_nsec() - start;
+    CHECK(!poller || poller->getNumPlanes() == 0, "The plane is still in the "
+            "poller");
+    CHECK(!element->isInError(), "Element is in error");
+    cout << "STREAMOFF stopped the " << what << " in " << elapsed / 1000 <<
+        " us" << endl;
+    return 0;
+}
+
+/**
+ * Frames carried by a poller through both planes of an element.
+ */
+typedef struct
+{
+    MockElement *element;
+    uint32_t queued;
+    uint32_t captured;
+    atomic<bool> failed;
+} PollerContext;
+
+static bool
+poller_output_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+        NvBuffer *shared_buffer, void *arg)
+{
+    PollerContext *ctx = (PollerContext *) arg;
+
+    if (!v4l2_buf)
+    {
+        return false;
+    }
+    if (ctx->queued < NUM_POLLER_FRAMES)
+    {
+        if (queue_buffer(ctx->element->output_plane, v4l2_buf->index, 64) < 0)
+        {
+            cerr << "Could not queue frame " << ctx->queued << endl;
+            ctx->failed = true;
+            return false;
+        }
+        ctx->queued++;
+    }
+    return true;
+}
+
+static bool
+poller_capture_callback(struct v4l2_buffer *v4l2_buf, NvBuffer *buffer,
+        NvBuffer *shared_buffer, void *arg)
+{
+    PollerContext *ctx = (PollerContext *) arg;
+
+    if (!v4l2_buf)
+    {
+        cerr << "Capture plane ended after " << ctx->captured << " frames" <<
+            endl;
+        ctx->failed = true;
+        return false;
+    }
+    if (++ctx->captured == NUM_POLLER_FRAMES)
+    {
+        return false;
+    }
+    if (queue_buffer(ctx->element->capture_plane, v4l2_buf->index, 0) < 0)
+    {
+        cerr << "Could not queue capture buffer " << v4l2_buf->index << endl;
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static int
+run_poller(MockElement *element, NvV4l2DQPoller *poller)
+{
+    NvV4l2ElementPlane &out = element->output_plane;
+    NvV4l2ElementPlane &cap = element->capture_plane;
+    PollerContext ctx;
+    uint64_t start;
+    uint64_t elapsed;
+
+    ctx.element = element;
+    ctx.queued = 0;
+    ctx.captured = 0;
+    ctx.failed = false;
+
+    for (uint32_t i = 0; i < NUM_BUFFERS; i++)
+    {
+        CHECK(queue_buffer(cap, i, 0) == 0, "Could not queue capture buffer "
+                << i);
+    }
+    start = now_nsec();
+    cap.setDQThreadCallback(poller_capture_callback);
+    out.setDQThreadCallback(poller_output_callback);
+    CHECK(cap.startDQThread(&ctx, poller) == 0,
+            "Could not add the capture plane to the poller");
+    /* The poller refills the output plane once the buffers are queued. */
+    for (; ctx.queued < NUM_BUFFERS; ctx.queued++)
+    {
+        CHECK(queue_buffer(out, ctx.queued, 64) == 0, "Could not queue frame "
+                << ctx.queued);
+    }
+    CHECK(out.startDQThread(&ctx, poller) == 0,
+            "Could not add the output plane to the poller");
+
+    CHECK(cap.waitForDQThread(WAIT_MS) == 0, "Capture plane did not leave "
+            "the poller, " << ctx.captured << " frames captured");
+    elapsed = now_nsec() - start;
+    out.stopDQThread();
+    CHECK(!ctx.failed && ctx.captured == NUM_POLLER_FRAMES, "Poller "
+            "captured " << ctx.captured << " frames instead of " <<
+            NUM_POLLER_FRAMES);
+    CHECK(poller->getNumPlanes() == 0, "Planes are still in the poller");
+
+    cout << "Poller: " << fixed << setprecision(0) << NUM_POLLER_FRAMES *
+        1e9 / elapsed << " frames/s" << endl;
+    return 0;
+}
+
+/**
+ * Runs the checks with the @c poll entry point of the mock, or without it.
+ */
+static int
+check_waits(bool pollable, uint32_t iterations, uint32_t max_latency_usec)
+{
+    const char *mode = pollable ? "poll" : "DevicePoll";
+    MockElement *element;
+    MockElement *other;
+    NvV4l2DQPoller *poller;
+    int ret;
+
+    NvV4l2Element::setDeviceOps(NvV4l2MockDevice::getDeviceOps(pollable));
+
+    element = open_element("mock0");
+    CHECK(element, "Could not open the mock device");
+    ret = run_timeout(element);
+    if (ret == 0)
+    {
+        cout << mode << " timeout: OK" << endl;
+        ret = run_latency(element, iterations, max_latency_usec, mode);
+    }
+    if (ret == 0)
+    {
+        cout << mode << " latency: OK" << endl;
+        ret = run_abort(element);
+    }
+    if (ret == 0)
+    {
+        cout << mode << " abort: OK" << endl;
+        ret = run_streamoff(element, NULL, "DQ Thread");
+    }
+    delete element;
+    CHECK(ret == 0, mode << " checks failed");
+
+    poller = NvV4l2DQPoller::createDQPoller("mockpoller");
+    CHECK(poller, "Could not create the poller");
+    element = open_element("mock1");
+    ret = element ? run_streamoff(element, poller, "poller") : -1;
+    delete element;
+    if (ret == 0)
+    {
+        cout << mode << " streamoff: OK" << endl;
+        element = open_element("mock2");
+        ret = element ? run_poller(element, poller) : -1;
+        delete element;
+    }
+    if (ret == 0 && !pollable)
+    {
+        /* A single thread cannot sleep in the DevicePoll control of two
+         * devices. */
+        element = open_element("mock3");
+        other = open_element("mock4");
+        ret = element && other &&
+            element->capture_plane.startDQThread(NULL, poller) == 0 &&
+            other->capture_plane.startDQThread(NULL, poller) < 0 ? 0 : -1;
+        if (ret < 0)
+        {
+            cerr << "Poller accepted planes of two devices" << endl;
+        }
+        if (element)
+        {
+            element->capture_plane.stopDQThread();
+        }
+        delete other;
+        delete element;
+    }
+    delete poller;
+    CHECK(ret == 0, mode << " poller checks failed");
+
+    cout << mode << " poller: OK" << endl;
+    return 0;
+}
+
+static void
+print_help()
+{
+    cout << "Help:" << endl;
+    cout << "Execution cmd:\n"
+         << "./v4l2wait_sample [-n iterations] [-l max_latency_usec] [-v]\n"
+         << endl;
+    cout << "\t-n iterations       Wake-ups measured (default "
+         << DEFAULT_ITERATIONS << ")" << endl;
+    cout << "\t-l max_latency_usec Largest mean wake-up latency allowed "
+         << "(default " << DEFAULT_MAX_LATENCY_USEC << ")" << endl;
+    cout << "\t-v                  Print the debug messages" << endl;
+    cout << "\t-h                  Print this help" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    uint32_t max_latency_usec = DEFAULT_MAX_LATENCY_USEC;
+    int opt;
+
+    log_level = LOG_LEVEL_INFO;
+    while ((opt = getopt(argc, argv, "n:l:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'l':
+                max_latency_usec = atoi(optarg);
+                break;
+            case 'v':
+                log_level = LOG_LEVEL_DEBUG;
+                break;
+            default:
+                print_help();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (iterations < 1 || iterations > 100000 || max_latency_usec < 1)
+    {
+        print_help();
+        return -1;
+    }
+
+    NvV4l2MockDevice::setProcessingDelay(0);
+
+    if (check_waits(true, iterations, max_latency_usec) < 0 ||
+            check_waits(false, iterations, max_latency_usec) < 0)
+    {
+        cerr << "TEST FAILED" << endl;
+        return -1;
+    }
+    cout << "TEST PASSED" << endl;
+    return 0;
+}